@@ -0,0 +1,93 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Formats.h"
+
+namespace Falcor
+{
+    /** Reads back the back-buffer without stalling the GPU.
+        capture() copies the back-buffer into one of a ring of staging buffers and returns immediately. The data is read a few frames later, once the copy is complete.
+        Frames are returned in capture order.
+    */
+    class AsyncScreenCapture
+    {
+    public:
+        using UniquePtr = std::unique_ptr<AsyncScreenCapture>;
+        using UniqueConstPtr = std::unique_ptr<const AsyncScreenCapture>;
+
+        /** Create a new object
+            \param[in] width The width of the screen
+            \param[in] height The height of the screen
+            \param[in] format The requested data format
+            \param[in] ringSize The number of staging buffers. This is the maximum number of readbacks in flight.
+            \return A new object, or nullptr if creation failed
+        */
+        static UniquePtr create(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize = 3);
+        ~AsyncScreenCapture();
+
+        /** Start a readback of the back-buffer.
+            \return false if all the staging buffers are in flight. Call readFrame() to release the oldest one.
+        */
+        bool capture();
+
+        /** Check if the oldest readback completed. Doesn't block.
+        */
+        bool isFrameReady() const;
+
+        /** Copy the oldest readback into a user buffer and release its staging buffer. Blocks until the readback completes.
+            \param[in] pData Destination buffer of getFrameSize() bytes. If nullptr, the frame is discarded.
+            \return false if there are no readbacks in flight, or if the readback couldn't be mapped. In the second case the staging buffer is still released, and pData isn't written.
+        */
+        bool readFrame(uint8_t* pData);
+
+        /** Get the number of readbacks in flight
+        */
+        uint32_t getPendingCount() const { return mPendingCount; }
+
+        /** Get the number of staging buffers
+        */
+        uint32_t getRingSize() const { return mRingSize; }
+
+        /** Get the size of a frame in bytes
+        */
+        uint32_t getFrameSize() const { return mWidth * mHeight * getFormatBytesPerBlock(mFormat); }
+
+    private:
+        AsyncScreenCapture(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize);
+        bool init();
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        ResourceFormat mFormat;
+        uint32_t mRingSize;
+        uint32_t mFirstPending = 0;
+        uint32_t mPendingCount = 0;
+        void* mpPrivateData = nullptr;
+    };
+}
\ No newline at end of file
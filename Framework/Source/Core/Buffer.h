@@ -73,7 +73,8 @@ namespace Falcor
             StreamOutput    = 0x10,
             RenderTarget    = 0x20,
             DepthStencil    = 0x40,
-            UnorderedAccess = 0x80
+            UnorderedAccess = 0x80,
+            IndirectArgs    = 0x100, ///< Buffer holds arguments for indirect draw calls (see RenderContext#multiDrawIndexedIndirect())
         };
 
         enum class MapType
@@ -0,0 +1,433 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CommandList.h"
+#include <new>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct CommandHeader
+        {
+            CommandList::Command command;
+            uint32_t size;      ///< Size of the command including the header, in bytes
+        };
+    }
+
+    CommandList::SharedPtr CommandList::create(size_t initialSize)
+    {
+        return SharedPtr(new CommandList(initialSize));
+    }
+
+    CommandList::CommandList(size_t initialSize)
+    {
+        mArena.reserve(initialSize);
+        reset();
+    }
+
+    void CommandList::reset()
+    {
+        mArena.clear();
+        mObjects.clear();
+        mObjectIndices.clear();
+        mCommandCount = 0;
+        for(uint32_t i = 0; i < (uint32_t)Command::Count; i++)
+        {
+            mCommandCounts[i] = 0;
+        }
+        mBoundUniformBuffers.clear();
+        mUniformBufferStack.clear();
+        mLastUniformBufferData.clear();
+#ifdef FALCOR_DX11
+        mShaderResources.clear();
+        mLastShaderResources.clear();
+#endif
+    }
+
+    template<typename T>
+    T* CommandList::allocate(Command command, size_t extraBytes)
+    {
+        // Keep the commands 8-byte aligned
+        const size_t size = (sizeof(CommandHeader) + sizeof(T) + extraBytes + 7) & ~size_t(7);
+        const size_t offset = mArena.size();
+        mArena.resize(offset + size);
+
+        CommandHeader* pHeader = (CommandHeader*)(mArena.data() + offset);
+        pHeader->command = command;
+        pHeader->size = (uint32_t)size;
+        mCommandCount++;
+        mCommandCounts[(uint32_t)command]++;
+        return new(pHeader + 1) T;
+    }
+
+    uint32_t CommandList::addObject(const std::shared_ptr<const void>& pObject)
+    {
+        if(pObject == nullptr)
+        {
+            return kNullObject;
+        }
+
+        auto it = mObjectIndices.find(pObject.get());
+        if(it != mObjectIndices.end())
+        {
+            return it->second;
+        }
+        const uint32_t index = (uint32_t)mObjects.size();
+        mObjects.push_back(pObject);
+        mObjectIndices[pObject.get()] = index;
+        return index;
+    }
+
+    void CommandList::setFbo(const Fbo::SharedPtr& pFbo)
+    {
+        allocate<ObjectCmd>(Command::SetFbo)->object = addObject(pFbo);
+    }
+
+    void CommandList::pushFbo(const Fbo::SharedPtr& pFbo)
+    {
+        allocate<ObjectCmd>(Command::PushFbo)->object = addObject(pFbo);
+    }
+
+    void CommandList::popFbo()
+    {
+        allocate<EmptyCmd>(Command::PopFbo);
+    }
+
+    void CommandList::pushState()
+    {
+        allocate<EmptyCmd>(Command::PushState);
+        mUniformBufferStack.push_back(mBoundUniformBuffers);
+    }
+
+    void CommandList::popState()
+    {
+        allocate<EmptyCmd>(Command::PopState);
+        if(mUniformBufferStack.empty() == false)
+        {
+            mBoundUniformBuffers = mUniformBufferStack.back();
+            mUniformBufferStack.pop_back();
+        }
+    }
+
+    void CommandList::setVao(const Vao::SharedConstPtr& pVao)
+    {
+        allocate<ObjectCmd>(Command::SetVao)->object = addObject(pVao);
+    }
+
+    void CommandList::setTopology(RenderContext::Topology topology)
+    {
+        allocate<TopologyCmd>(Command::SetTopology)->topology = topology;
+    }
+
+    void CommandList::setRasterizerState(const RasterizerState::SharedConstPtr& pRastState)
+    {
+        allocate<ObjectCmd>(Command::SetRasterizerState)->object = addObject(pRastState);
+    }
+
+    void CommandList::setDepthStencilState(const DepthStencilState::SharedConstPtr& pDepthStencil, uint32_t stencilRef)
+    {
+        ObjectValueCmd* pCmd = allocate<ObjectValueCmd>(Command::SetDepthStencilState);
+        pCmd->object = addObject(pDepthStencil);
+        pCmd->value = stencilRef;
+    }
+
+    void CommandList::setBlendState(const BlendState::SharedConstPtr& pBlendState, uint32_t sampleMask)
+    {
+        ObjectValueCmd* pCmd = allocate<ObjectValueCmd>(Command::SetBlendState);
+        pCmd->object = addObject(pBlendState);
+        pCmd->value = sampleMask;
+    }
+
+    void CommandList::setProgram(const ProgramVersion::SharedConstPtr& pProgram)
+    {
+        allocate<ObjectCmd>(Command::SetProgram)->object = addObject(pProgram);
+    }
+
+    void CommandList::setUniformBuffer(uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer)
+    {
+        if(index != 0xFFFFFFFFu)
+        {
+            SlotCmd* pCmd = allocate<SlotCmd>(Command::SetUniformBuffer);
+            pCmd->index = index;
+            pCmd->object = addObject(pBuffer);
+
+            if(index >= mBoundUniformBuffers.size())
+            {
+                mBoundUniformBuffers.resize(index + 1);
+            }
+            mBoundUniformBuffers[index] = pBuffer;
+        }
+    }
+
+    void CommandList::setShaderStorageBuffer(uint32_t index, const ShaderStorageBuffer::SharedConstPtr& pBuffer)
+    {
+        if(index != 0xFFFFFFFFu)
+        {
+            SlotCmd* pCmd = allocate<SlotCmd>(Command::SetShaderStorageBuffer);
+            pCmd->index = index;
+            pCmd->object = addObject(pBuffer);
+        }
+    }
+
+    void CommandList::updateUniformBuffer(const UniformBuffer::SharedPtr& pBuffer, const void* pData, size_t offset, size_t size)
+    {
+        UpdateUniformBufferCmd* pCmd = allocate<UpdateUniformBufferCmd>(Command::UpdateUniformBuffer, size);
+        pCmd->object = addObject(pBuffer);
+        pCmd->offset = (uint32_t)offset;
+        pCmd->size = (uint32_t)size;
+        memcpy(pCmd + 1, pData, size);
+
+        // The replayed buffer no longer matches the last capture
+        mLastUniformBufferData.erase(pBuffer.get());
+    }
+
+    void CommandList::setViewport(uint32_t index, const RenderContext::Viewport& vp)
+    {
+        ViewportCmd* pCmd = allocate<ViewportCmd>(Command::SetViewport);
+        pCmd->index = index;
+        pCmd->vp = vp;
+    }
+
+    void CommandList::setScissor(uint32_t index, const RenderContext::Scissor& sc)
+    {
+        ScissorCmd* pCmd = allocate<ScissorCmd>(Command::SetScissor);
+        pCmd->index = index;
+        pCmd->sc = sc;
+    }
+
+#ifdef FALCOR_DX11
+    void CommandList::captureShaderResources()
+    {
+        // The render-context binds the resources of the first bound uniform buffer. The maps are shared by all the buffers of a program.
+        for(const auto& pBuffer : mBoundUniformBuffers)
+        {
+            if(pBuffer == nullptr)
+            {
+                continue;
+            }
+
+            const auto& srvs = pBuffer->getAssignedResourcesMap();
+            const auto& samplers = pBuffer->getAssignedSamplersMap();
+            auto it = mLastShaderResources.find(&srvs);
+            if(it != mLastShaderResources.end() && mShaderResources[it->second].srvs == srvs && mShaderResources[it->second].samplers == samplers)
+            {
+                return;
+            }
+
+            const uint32_t index = (uint32_t)mShaderResources.size();
+            mShaderResources.push_back({srvs, samplers});
+            mLastShaderResources[&srvs] = index;
+
+            ShaderResourcesCmd* pCmd = allocate<ShaderResourcesCmd>(Command::SetShaderResources);
+            pCmd->object = addObject(pBuffer);
+            pCmd->resources = index;
+            return;
+        }
+    }
+#endif
+
+    void CommandList::captureUniformBuffers()
+    {
+#ifdef FALCOR_DX11
+        captureShaderResources();
+#endif
+        for(const auto& pBuffer : mBoundUniformBuffers)
+        {
+            if(pBuffer == nullptr || pBuffer->getSize() == 0)
+            {
+                continue;
+            }
+
+            // Skip the buffer if its data didn't change since the last capture
+            const uint32_t size = (uint32_t)pBuffer->getSize();
+            auto it = mLastUniformBufferData.find(pBuffer.get());
+            if(it != mLastUniformBufferData.end())
+            {
+                const UpdateUniformBufferCmd* pLast = (const UpdateUniformBufferCmd*)(mArena.data() + it->second);
+                if(memcmp(pLast + 1, pBuffer->getData(), size) == 0)
+                {
+                    continue;
+                }
+            }
+
+            UpdateUniformBufferCmd* pCmd = allocate<UpdateUniformBufferCmd>(Command::UpdateUniformBuffer, size);
+            pCmd->object = addObject(pBuffer);
+            pCmd->offset = 0;
+            pCmd->size = size;
+            memcpy(pCmd + 1, pBuffer->getData(), size);
+            mLastUniformBufferData[pBuffer.get()] = (size_t)((uint8_t*)pCmd - mArena.data());
+        }
+    }
+
+    void CommandList::draw(uint32_t vertexCount, uint32_t startVertexLocation)
+    {
+        captureUniformBuffers();
+        DrawCmd* pCmd = allocate<DrawCmd>(Command::Draw);
+        pCmd->vertexCount = vertexCount;
+        pCmd->startVertexLocation = startVertexLocation;
+    }
+
+    void CommandList::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
+    {
+        captureUniformBuffers();
+        DrawIndexedCmd* pCmd = allocate<DrawIndexedCmd>(Command::DrawIndexed);
+        pCmd->indexCount = indexCount;
+        pCmd->startIndexLocation = startIndexLocation;
+        pCmd->baseVertexLocation = baseVertexLocation;
+    }
+
+    void CommandList::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
+    {
+        captureUniformBuffers();
+        DrawIndexedInstancedCmd* pCmd = allocate<DrawIndexedInstancedCmd>(Command::DrawIndexedInstanced);
+        pCmd->indexCount = indexCount;
+        pCmd->instanceCount = instanceCount;
+        pCmd->startIndexLocation = startIndexLocation;
+        pCmd->baseVertexLocation = baseVertexLocation;
+        pCmd->startInstanceLocation = startInstanceLocation;
+    }
+
+    void CommandList::execute(const std::function<void(Command command, const void* pPayload)>& callback) const
+    {
+        size_t offset = 0;
+        while(offset < mArena.size())
+        {
+            const CommandHeader* pHeader = (const CommandHeader*)(mArena.data() + offset);
+            callback(pHeader->command, pHeader + 1);
+            offset += pHeader->size;
+        }
+    }
+
+    void CommandList::execute(RenderContext* pContext) const
+    {
+        size_t offset = 0;
+        while(offset < mArena.size())
+        {
+            const CommandHeader* pHeader = (const CommandHeader*)(mArena.data() + offset);
+            const void* pData = pHeader + 1;
+            offset += pHeader->size;
+
+            switch(pHeader->command)
+            {
+            case Command::SetFbo:
+                pContext->setFbo(getObject<Fbo>(((const ObjectCmd*)pData)->object));
+                break;
+            case Command::PushFbo:
+                pContext->pushFbo(getObject<Fbo>(((const ObjectCmd*)pData)->object));
+                break;
+            case Command::PopFbo:
+                pContext->popFbo();
+                break;
+            case Command::PushState:
+                pContext->pushState();
+                break;
+            case Command::PopState:
+                pContext->popState();
+                break;
+            case Command::SetVao:
+                pContext->setVao(getObject<const Vao>(((const ObjectCmd*)pData)->object));
+                break;
+            case Command::SetTopology:
+                pContext->setTopology(((const TopologyCmd*)pData)->topology);
+                break;
+            case Command::SetRasterizerState:
+                pContext->setRasterizerState(getObject<const RasterizerState>(((const ObjectCmd*)pData)->object));
+                break;
+            case Command::SetDepthStencilState:
+            {
+                const ObjectValueCmd* pCmd = (const ObjectValueCmd*)pData;
+                pContext->setDepthStencilState(getObject<const DepthStencilState>(pCmd->object), pCmd->value);
+                break;
+            }
+            case Command::SetBlendState:
+            {
+                const ObjectValueCmd* pCmd = (const ObjectValueCmd*)pData;
+                pContext->setBlendState(getObject<const BlendState>(pCmd->object), pCmd->value);
+                break;
+            }
+            case Command::SetProgram:
+                pContext->setProgram(getObject<const ProgramVersion>(((const ObjectCmd*)pData)->object));
+                break;
+            case Command::SetUniformBuffer:
+            {
+                const SlotCmd* pCmd = (const SlotCmd*)pData;
+                pContext->setUniformBuffer(pCmd->index, getObject<const UniformBuffer>(pCmd->object));
+                break;
+            }
+            case Command::SetShaderStorageBuffer:
+            {
+                const SlotCmd* pCmd = (const SlotCmd*)pData;
+                pContext->setShaderStorageBuffer(pCmd->index, getObject<const ShaderStorageBuffer>(pCmd->object));
+                break;
+            }
+            case Command::UpdateUniformBuffer:
+            {
+                const UpdateUniformBufferCmd* pCmd = (const UpdateUniformBufferCmd*)pData;
+                getObject<UniformBuffer>(pCmd->object)->setBlob(pCmd + 1, pCmd->offset, pCmd->size);
+                break;
+            }
+            case Command::SetShaderResources:
+            {
+#ifdef FALCOR_DX11
+                const ShaderResourcesCmd* pCmd = (const ShaderResourcesCmd*)pData;
+                const ShaderResources& resources = mShaderResources[pCmd->resources];
+                getObject<UniformBuffer>(pCmd->object)->setAssignedResources(resources.srvs, resources.samplers);
+#endif
+                break;
+            }
+            case Command::SetViewport:
+                pContext->setViewport(((const ViewportCmd*)pData)->index, ((const ViewportCmd*)pData)->vp);
+                break;
+            case Command::SetScissor:
+                pContext->setScissor(((const ScissorCmd*)pData)->index, ((const ScissorCmd*)pData)->sc);
+                break;
+            case Command::Draw:
+            {
+                const DrawCmd* pCmd = (const DrawCmd*)pData;
+                pContext->draw(pCmd->vertexCount, pCmd->startVertexLocation);
+                break;
+            }
+            case Command::DrawIndexed:
+            {
+                const DrawIndexedCmd* pCmd = (const DrawIndexedCmd*)pData;
+                pContext->drawIndexed(pCmd->indexCount, pCmd->startIndexLocation, pCmd->baseVertexLocation);
+                break;
+            }
+            case Command::DrawIndexedInstanced:
+            {
+                const DrawIndexedInstancedCmd* pCmd = (const DrawIndexedInstancedCmd*)pData;
+                pContext->drawIndexedInstanced(pCmd->indexCount, pCmd->instanceCount, pCmd->startIndexLocation, pCmd->baseVertexLocation, pCmd->startInstanceLocation);
+                break;
+            }
+            default:
+                should_not_get_here();
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include "Core/RenderContext.h"
+
+namespace Falcor
+{
+    /** A list of rendering commands which can be recorded without a graphics API and replayed on a RenderContext later.
+        Commands are stored in a linear memory arena. Recording doesn't touch the GPU, so lists can be recorded on worker threads, one list per thread, and executed on the thread which owns the render-context.\n
+        Uniform buffers are handled by value. Whenever a draw is recorded, the CPU data of every bound uniform buffer which changed since it was last recorded is copied into the list. The same buffer objects can be reused between draws, like when rendering directly.\n
+        Under DX11, textures and samplers aren't part of the uniform buffer's data. The shader resource views and samplers assigned to the first bound uniform buffer are captured at draws as well, the same way the render-context binds them.\n
+        Recording reads the bound uniform buffers' CPU data, and the DX11 texture maps are shared by all the buffers of a program. Two threads which record with the same buffer objects race, even when each has its own list.
+        For example, all SceneRenderer instances share their uniform buffers, so only one thread at a time may record a scene. Give each recording thread its own buffers to record in parallel.
+    */
+    class CommandList
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CommandList>;
+        using SharedConstPtr = std::shared_ptr<const CommandList>;
+
+        enum class Command : uint32_t
+        {
+            SetFbo,
+            PushFbo,
+            PopFbo,
+            PushState,
+            PopState,
+            SetVao,
+            SetTopology,
+            SetRasterizerState,
+            SetDepthStencilState,
+            SetBlendState,
+            SetProgram,
+            SetUniformBuffer,
+            SetShaderStorageBuffer,
+            UpdateUniformBuffer,
+            SetShaderResources,     ///< DX11 only
+            SetViewport,
+            SetScissor,
+            Draw,
+            DrawIndexed,
+            DrawIndexedInstanced,
+            Count
+        };
+
+        /** Objects are referenced by index into the list's object table, see getObject(). This index stands for a null object.
+        */
+        static const uint32_t kNullObject = uint32_t(-1);
+
+        /** Command payloads, as passed to the execute() callback.
+        */
+        struct EmptyCmd                 ///< PopFbo, PushState, PopState
+        {
+            uint32_t unused;
+        };
+
+        struct ObjectCmd                ///< SetFbo, PushFbo, SetVao, SetRasterizerState, SetProgram
+        {
+            uint32_t object;
+        };
+
+        struct ObjectValueCmd           ///< SetDepthStencilState (value is the stencil reference), SetBlendState (value is the sample mask)
+        {
+            uint32_t object;
+            uint32_t value;
+        };
+
+        struct SlotCmd                  ///< SetUniformBuffer, SetShaderStorageBuffer
+        {
+            uint32_t index;
+            uint32_t object;
+        };
+
+        struct TopologyCmd              ///< SetTopology
+        {
+            RenderContext::Topology topology;
+        };
+
+        struct UpdateUniformBufferCmd   ///< UpdateUniformBuffer. The data follows the command.
+        {
+            uint32_t object;
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        struct ShaderResourcesCmd       ///< SetShaderResources
+        {
+            uint32_t object;            ///< The uniform buffer which holds the resource maps
+            uint32_t resources;         ///< Index of the captured resources. Internal to the list.
+        };
+
+        struct ViewportCmd              ///< SetViewport
+        {
+            uint32_t index;
+            RenderContext::Viewport vp;
+        };
+
+        struct ScissorCmd               ///< SetScissor
+        {
+            uint32_t index;
+            RenderContext::Scissor sc;
+        };
+
+        struct DrawCmd                  ///< Draw
+        {
+            uint32_t vertexCount;
+            uint32_t startVertexLocation;
+        };
+
+        struct DrawIndexedCmd           ///< DrawIndexed
+        {
+            uint32_t indexCount;
+            uint32_t startIndexLocation;
+            int baseVertexLocation;
+        };
+
+        struct DrawIndexedInstancedCmd  ///< DrawIndexedInstanced
+        {
+            uint32_t indexCount;
+            uint32_t instanceCount;
+            uint32_t startIndexLocation;
+            int baseVertexLocation;
+            uint32_t startInstanceLocation;
+        };
+
+        /** Create a new, empty command list
+            \param[in] initialSize Initial size of the command arena in bytes
+        */
+        static SharedPtr create(size_t initialSize = 64 * 1024);
+
+        /** Remove all of the commands. The arena memory is kept for the next recording.
+        */
+        void reset();
+
+        /** The recording functions mirror the RenderContext functions with the same names
+        */
+        void setFbo(const Fbo::SharedPtr& pFbo);
+        void pushFbo(const Fbo::SharedPtr& pFbo);
+        void popFbo();
+        void pushState();
+        void popState();
+        void setVao(const Vao::SharedConstPtr& pVao);
+        void setTopology(RenderContext::Topology topology);
+        void setRasterizerState(const RasterizerState::SharedConstPtr& pRastState);
+        void setDepthStencilState(const DepthStencilState::SharedConstPtr& pDepthStencil, uint32_t stencilRef);
+        void setBlendState(const BlendState::SharedConstPtr& pBlendState, uint32_t sampleMask = RenderContext::kSampleMaskAll);
+        void setProgram(const ProgramVersion::SharedConstPtr& pProgram);
+        void setUniformBuffer(uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer);
+        void setShaderStorageBuffer(uint32_t index, const ShaderStorageBuffer::SharedConstPtr& pBuffer);
+        void setViewport(uint32_t index, const RenderContext::Viewport& vp);
+        void setScissor(uint32_t index, const RenderContext::Scissor& sc);
+        void draw(uint32_t vertexCount, uint32_t startVertexLocation);
+        void drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation);
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation);
+
+        /** Record an update of a range of a uniform buffer's data. Bound buffers are captured automatically at draws, use this for buffers which aren't bound yet.
+        */
+        void updateUniformBuffer(const UniformBuffer::SharedPtr& pBuffer, const void* pData, size_t offset, size_t size);
+
+        /** Replay the commands on a render-context. Must be called on the thread which owns the context.
+        */
+        void execute(RenderContext* pContext) const;
+
+        /** Replay the commands on a recording backend.
+            Every command is passed to the callback with a pointer to its payload struct, nothing reaches a graphics API. Use this to validate and benchmark command generation without a GPU.
+            \param[in] callback Called once per command. pPayload points to the struct documented with the command type, for example DrawIndexedInstancedCmd for Command::DrawIndexedInstanced.
+        */
+        void execute(const std::function<void(Command command, const void* pPayload)>& callback) const;
+
+        /** Get an object referenced by a command payload
+            \param[in] index The object index stored in the payload
+            \return The object, or nullptr if the index is kNullObject
+        */
+        template<typename T>
+        std::shared_ptr<T> getObject(uint32_t index) const
+        {
+            if(index == kNullObject)
+            {
+                return nullptr;
+            }
+            return std::const_pointer_cast<T>(std::static_pointer_cast<const T>(mObjects[index]));
+        }
+
+        /** Get the number of recorded commands
+        */
+        uint32_t getCommandCount() const { return mCommandCount; }
+
+        /** Get the number of recorded commands of a specific type
+        */
+        uint32_t getCommandCount(Command command) const { return mCommandCounts[(uint32_t)command]; }
+
+        /** Get the number of bytes used by the commands
+        */
+        size_t getSize() const { return mArena.size(); }
+
+    private:
+        CommandList(size_t initialSize);
+
+        template<typename T>
+        T* allocate(Command command, size_t extraBytes = 0);
+        uint32_t addObject(const std::shared_ptr<const void>& pObject);
+        void captureUniformBuffers();
+
+        std::vector<uint8_t> mArena;
+        std::vector<std::shared_ptr<const void>> mObjects;          ///< Keeps the referenced objects alive. Commands reference them by index.
+        std::unordered_map<const void*, uint32_t> mObjectIndices;
+        uint32_t mCommandCount = 0;
+        uint32_t mCommandCounts[(uint32_t)Command::Count];
+
+        // Uniform buffer tracking, used to capture the buffers' data at draws
+        std::vector<UniformBuffer::SharedConstPtr> mBoundUniformBuffers;
+        std::vector<std::vector<UniformBuffer::SharedConstPtr>> mUniformBufferStack;
+        std::unordered_map<const UniformBuffer*, size_t> mLastUniformBufferData;    ///< Arena offset of the last captured data of each buffer
+
+#ifdef FALCOR_DX11
+        struct ShaderResources
+        {
+            std::map<uint32_t, ID3D11ShaderResourceViewPtr> srvs;
+            std::map<uint32_t, ID3D11SamplerStatePtr> samplers;
+        };
+        void captureShaderResources();
+        std::vector<ShaderResources> mShaderResources;      ///< Commands reference the captured resources by index
+        std::unordered_map<const void*, uint32_t> mLastShaderResources;  ///< Index of the last captured resources of each program's resource map
+#endif
+    };
+}
\ No newline at end of file
@@ -29,6 +29,7 @@
 
 #include "Utils/OS.h"
 #include "Framework.h"
+#include "Utils/MemoryMappedFile.h"
 #include <D3D11.h>
 
 namespace Falcor
@@ -116,8 +117,12 @@ namespace Falcor
         {
             DdsHeader header;
             DdsHeaderDX10 dx10Header;
-            bool hasDX10Header;
-            std::vector<uint8_t> data;
+            bool hasDX10Header = false;
+            MemoryMappedFile::UniquePtr pFile;
+            uint8_t* pData = nullptr;       ///< The texture data. Points into the mapped file.
+            size_t dataSize = 0;
+            ResourceFormat format = ResourceFormat::Unknown;
+            uint32_t mipLevels = 0;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#ifdef FALCOR_DX11
+#include "Core/AsyncScreenCapture.h"
+
+namespace Falcor
+{
+    AsyncScreenCapture::UniquePtr AsyncScreenCapture::create(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize)
+    {
+        UniquePtr pCapture = UniquePtr(new AsyncScreenCapture(width, height, format, ringSize));
+        if(pCapture->init() == false)
+        {
+            return nullptr;
+        }
+        return pCapture;
+    }
+
+    AsyncScreenCapture::AsyncScreenCapture(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize) : mWidth(width), mHeight(height), mFormat(format), mRingSize(ringSize)
+    {
+    }
+
+    AsyncScreenCapture::~AsyncScreenCapture() = default;
+
+    bool AsyncScreenCapture::init()
+    {
+        return true;
+    }
+
+    bool AsyncScreenCapture::capture()
+    {
+        // Screen capture is not implemented for DX11 yet (see ScreenCaptureDX11.cpp)
+        return false;
+    }
+
+    bool AsyncScreenCapture::isFrameReady() const
+    {
+        return false;
+    }
+
+    bool AsyncScreenCapture::readFrame(uint8_t* pData)
+    {
+        return false;
+    }
+}
+#endif //#ifdef FALCOR_DX11
\ No newline at end of file
@@ -72,7 +72,7 @@ namespace Falcor
         assert(size < UINT32_MAX);
         desc.ByteWidth = (uint32_t)size;
         desc.CPUAccessFlags = getCpuAccessFlags(access);
-        desc.MiscFlags = 0;
+        desc.MiscFlags = ((usage & BindFlags::IndirectArgs) != BindFlags::None) ? D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS : 0;
         desc.StructureByteStride = 0;
         desc.Usage = getUsageFlags(access);
 
@@ -109,8 +109,8 @@ namespace Falcor
         }
 
         struct D3D11_BOX srcBox;
-        srcBox.left = (UINT)dstOffset;
-        srcBox.right = (UINT)(dstOffset + count);
+        srcBox.left = (UINT)srcOffset;
+        srcBox.right = (UINT)(srcOffset + count);
         srcBox.top = 0;
         srcBox.bottom = 1;
         srcBox.front = 0;
@@ -106,8 +106,10 @@ namespace Falcor
         {ResourceFormat::BC4Snorm,                      DXGI_FORMAT_BC4_SNORM},
         {ResourceFormat::BC5Unorm,                      DXGI_FORMAT_BC5_UNORM},
         {ResourceFormat::BC5Snorm,                      DXGI_FORMAT_BC5_SNORM},
+        {ResourceFormat::BC7Unorm,                      DXGI_FORMAT_BC7_UNORM},
+        {ResourceFormat::BC7UnormSrgb,                  DXGI_FORMAT_BC7_UNORM_SRGB},
     };
 
-    static_assert(arraysize(kDxgiFormatDesc) == (uint32_t)ResourceFormat::BC5Snorm + 1, "DXGI format desc table has a wrong size");
+    static_assert(arraysize(kDxgiFormatDesc) == (uint32_t)ResourceFormat::BC7UnormSrgb + 1, "DXGI format desc table has a wrong size");
 }
 #endif //#ifdef FALCOR_DX11
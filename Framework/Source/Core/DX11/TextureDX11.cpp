@@ -136,17 +136,23 @@ namespace Falcor
         std::vector<D3D11_SUBRESOURCE_DATA> initData(subresourceCount);
 
         const uint8_t* pSrc = (uint8_t*)pData;
+        uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        uint32_t blockHeight = getFormatHeightCompressionRatio(format);
 
         // Loop over the array slices. 3D textures have a single array-slice.
         for(uint32_t array = 0; array < arraySize; array++)
         {
             for(uint32_t mip = 0; mip < mipLevels; mip++)
             {
+                // For compressed formats the pitch is a row of blocks, and partial blocks at the edges are padded to whole ones
+                uint32_t mipWidth = max(1U, width >> mip);
+                uint32_t mipHeight = max(1U, height >> mip);
+                uint32_t mipDepth = max(1U, depth >> mip);
                 auto& data = initData[D3D11CalcSubresource(mip, array, mipLevels)];
                 data.pSysMem = pSrc;
-                data.SysMemPitch = getFormatBytesPerBlock(format) * (width >> mip);
-                data.SysMemSlicePitch = data.SysMemPitch * (height >> mip);
-                pSrc += data.SysMemSlicePitch * depth;
+                data.SysMemPitch = getFormatBytesPerBlock(format) * ((mipWidth + blockWidth - 1) / blockWidth);
+                data.SysMemSlicePitch = data.SysMemPitch * ((mipHeight + blockHeight - 1) / blockHeight);
+                pSrc += data.SysMemSlicePitch * mipDepth;
             }
         }
 
@@ -376,6 +382,13 @@ namespace Falcor
 		UNSUPPORTED_IN_DX11("Texture::GenerateMips");
 	}
 
+    void Texture::copySubresource(const Texture* pDst, uint32_t srcMipLevel, uint32_t srcArraySlice, uint32_t dstMipLevel, uint32_t dstArraySlice) const
+    {
+        UINT srcSubresource = D3D11CalcSubresource(srcMipLevel, srcArraySlice, mMipLevels);
+        UINT dstSubresource = D3D11CalcSubresource(dstMipLevel, dstArraySlice, pDst->mMipLevels);
+        getD3D11ImmediateContext()->CopySubresourceRegion(pDst->mApiHandle, dstSubresource, 0, 0, 0, mApiHandle, srcSubresource, nullptr);
+    }
+
     Texture::SharedPtr Texture::createView(uint32_t firstArraySlice, uint32_t arraySize, uint32_t mostDetailedMip, uint32_t mipCount) const
     {
         UNSUPPORTED_IN_DX11("createView");
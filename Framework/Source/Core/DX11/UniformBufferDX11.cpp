@@ -179,5 +179,11 @@ namespace Falcor
         (*mAssignedResourcesMap)[(uint32_t)offset] = pTexture ? pTexture->getShaderResourceView() : nullptr;
         (*mAssignedSamplersMap)[(uint32_t)offset] = pSampler ? pSampler->getApiHandle() : nullptr;
     }
+
+    void UniformBuffer::setAssignedResources(const ShaderResourceMap& srvs, const SamplerMap& samplers)
+    {
+        *mAssignedResourcesMap = srvs;
+        *mAssignedSamplersMap = samplers;
+    }
 }
 #endif //#ifdef FALCOR_DX11
@@ -49,6 +49,7 @@ namespace Falcor
         IDXGISwapChainPtr pSwapChain = nullptr;
         uint32_t syncInterval = 0;
         bool isWindowOccluded = false;
+        bool isHidden = false;
     };
     
     static std::wstring string_2_wstring(const std::string& s)
@@ -540,6 +541,7 @@ namespace Falcor
         DxWindowData* pWinData = new DxWindowData;
         pWindow->mpPrivateData = pWinData;
         pWinData->pWindow = pWindow.get();
+        pWinData->isHidden = desc.isHidden;
         
         // create the window
         pWinData->hWnd = createFalcorWindow(desc, pWinData);
@@ -639,7 +641,10 @@ namespace Falcor
     {
         // Show the window
         DxWindowData* pData = (DxWindowData*)mpPrivateData;
-        ShowWindow(pData->hWnd, SW_SHOWNORMAL);
+        if(pData->isHidden == false)
+        {
+            ShowWindow(pData->hWnd, SW_SHOWNORMAL);
+        }
 
         MSG msg;
         while(1) 
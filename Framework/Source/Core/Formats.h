@@ -119,6 +119,8 @@ namespace Falcor
         BC4Snorm,   // RGTC Signed Red
         BC5Unorm,   // RGTC Unsigned RG
         BC5Snorm,   // RGTC Signed RG
+        BC7Unorm,   // BPTC
+        BC7UnormSrgb,
     };
     
     /** Falcor format Type
@@ -0,0 +1,173 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#ifdef FALCOR_GL
+#include "Core/AsyncScreenCapture.h"
+
+namespace Falcor
+{
+    struct CaptureRingData
+    {
+        std::vector<GLuint> pixelBuffers;
+        std::vector<GLsync> fences;
+    };
+
+    AsyncScreenCapture::UniquePtr AsyncScreenCapture::create(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize)
+    {
+        UniquePtr pCapture = UniquePtr(new AsyncScreenCapture(width, height, format, ringSize));
+        if(pCapture->init() == false)
+        {
+            return nullptr;
+        }
+        return pCapture;
+    }
+
+    AsyncScreenCapture::AsyncScreenCapture(uint32_t width, uint32_t height, ResourceFormat format, uint32_t ringSize) : mWidth(width), mHeight(height), mFormat(format), mRingSize(ringSize)
+    {
+    }
+
+    bool AsyncScreenCapture::init()
+    {
+        if(mRingSize == 0)
+        {
+            Logger::log(Logger::Level::Error, "AsyncScreenCapture::create() - ring size must be larger than 0.");
+            return false;
+        }
+
+        CaptureRingData* pData = new CaptureRingData;
+        mpPrivateData = pData;
+        pData->pixelBuffers.resize(mRingSize);
+        pData->fences.assign(mRingSize, nullptr);
+
+        gl_call(glCreateBuffers(mRingSize, pData->pixelBuffers.data()));
+        for(GLuint pbo : pData->pixelBuffers)
+        {
+            gl_call(glNamedBufferStorage(pbo, getFrameSize(), nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT));
+        }
+        return true;
+    }
+
+    AsyncScreenCapture::~AsyncScreenCapture()
+    {
+        CaptureRingData* pData = (CaptureRingData*)mpPrivateData;
+        if(pData)
+        {
+            for(GLsync fence : pData->fences)
+            {
+                if(fence)
+                {
+                    glDeleteSync(fence);
+                }
+            }
+            glDeleteBuffers((GLsizei)pData->pixelBuffers.size(), pData->pixelBuffers.data());
+            safe_delete(pData);
+        }
+    }
+
+    bool AsyncScreenCapture::capture()
+    {
+        if(mPendingCount == mRingSize)
+        {
+            return false;
+        }
+
+        CaptureRingData* pData = (CaptureRingData*)mpPrivateData;
+        uint32_t slot = (mFirstPending + mPendingCount) % mRingSize;
+
+        // Store the current read FB
+        GLint boundFB;
+        gl_call(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &boundFB));
+
+        // With a pixel-pack buffer bound, glReadPixels() queues a GPU copy instead of waiting for the data
+        gl_call(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+        gl_call(glNamedFramebufferReadBuffer(0, GL_BACK));
+        gl_call(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+        gl_call(glBindBuffer(GL_PIXEL_PACK_BUFFER, pData->pixelBuffers[slot]));
+        gl_call(glReadPixels(0, 0, mWidth, mHeight, getGlBaseFormat(mFormat), getGlFormatType(mFormat), nullptr));
+        gl_call(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+        pData->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        // Restore the read FB
+        gl_call(glBindFramebuffer(GL_READ_FRAMEBUFFER, boundFB));
+
+        mPendingCount++;
+        return true;
+    }
+
+    bool AsyncScreenCapture::isFrameReady() const
+    {
+        if(mPendingCount == 0)
+        {
+            return false;
+        }
+
+        const CaptureRingData* pData = (const CaptureRingData*)mpPrivateData;
+        GLint status = GL_UNSIGNALED;
+        gl_call(glGetSynciv(pData->fences[mFirstPending], GL_SYNC_STATUS, sizeof(status), nullptr, &status));
+        return status == GL_SIGNALED;
+    }
+
+    bool AsyncScreenCapture::readFrame(uint8_t* pDst)
+    {
+        if(mPendingCount == 0)
+        {
+            return false;
+        }
+
+        CaptureRingData* pData = (CaptureRingData*)mpPrivateData;
+        uint32_t slot = mFirstPending;
+        GLsync& fence = pData->fences[slot];
+
+        // The first wait flushes the command stream, in case the fence wasn't submitted yet
+        GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while(glClientWaitSync(fence, waitFlags, 1000000) == GL_TIMEOUT_EXPIRED)
+        {
+            waitFlags = 0;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        // The staging buffer is released even if mapping it failed, so that the ring doesn't stall
+        mFirstPending = (mFirstPending + 1) % mRingSize;
+        mPendingCount--;
+
+        if(pDst)
+        {
+            const void* pSrc = glMapNamedBufferRange(pData->pixelBuffers[slot], 0, getFrameSize(), GL_MAP_READ_BIT);
+            if(pSrc == nullptr)
+            {
+                Logger::log(Logger::Level::Error, "AsyncScreenCapture::readFrame() - can't map the staging buffer. The frame is lost.");
+                return false;
+            }
+            memcpy(pDst, pSrc, getFrameSize());
+            gl_call(glUnmapNamedBuffer(pData->pixelBuffers[slot]));
+        }
+        return true;
+    }
+}
+#endif //#ifdef FALCOR_GL
\ No newline at end of file
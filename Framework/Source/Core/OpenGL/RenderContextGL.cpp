@@ -487,27 +487,70 @@ namespace Falcor
 
     void RenderContext::draw(uint32_t vertexCount, uint32_t startVertexLocation)
     {
-        prepareForDraw();
+        if(prepareForDraw() == false)
+        {
+            return;
+        }
         GLenum glTopology = getGlTopology(mState.topology);
         gl_call(glDrawArrays(glTopology, startVertexLocation, vertexCount));
     }
 
+    GLenum getGlIndexType(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::R16Uint:
+            return GL_UNSIGNED_SHORT;
+        case ResourceFormat::R32Uint:
+            return GL_UNSIGNED_INT;
+        default:
+            should_not_get_here();
+            return GL_NONE;
+        }
+    }
+
     void RenderContext::drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation)
     {
-        prepareForDraw();
+        if(prepareForDraw() == false)
+        {
+            return;
+        }
         GLenum glTopology = getGlTopology(mState.topology);
-        uint32_t offset = sizeof(uint32_t) * startIndexLocation;
+        ResourceFormat indexFormat = mState.pVao->getIndexBufferFormat();
+        uint32_t offset = getFormatBytesPerBlock(indexFormat) * startIndexLocation;
 
-        gl_call(glDrawElementsBaseVertex(glTopology, indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)offset, baseVertexLocation));
+        gl_call(glDrawElementsBaseVertex(glTopology, indexCount, getGlIndexType(indexFormat), (void*)(uintptr_t)offset, baseVertexLocation));
     }
 
     void RenderContext::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation)
     {
-        prepareForDraw();
+        if(prepareForDraw() == false)
+        {
+            return;
+        }
+        GLenum glTopology = getGlTopology(mState.topology);
+        ResourceFormat indexFormat = mState.pVao->getIndexBufferFormat();
+        uint32_t offset = getFormatBytesPerBlock(indexFormat) * startIndexLocation;
+
+        gl_call(glDrawElementsInstancedBaseVertexBaseInstance(glTopology, indexCount, getGlIndexType(indexFormat), (void*)(uintptr_t)offset, instanceCount, baseVertexLocation, startInstanceLocation));
+    }
+
+    void RenderContext::multiDrawIndexedIndirect(const Buffer* pArgBuffer, uint32_t drawCount, uint64_t argBufferOffset)
+    {
+        if(drawCount == 0)
+        {
+            return;
+        }
+        if(prepareForDraw() == false)
+        {
+            return;
+        }
         GLenum glTopology = getGlTopology(mState.topology);
-        uint32_t offset = sizeof(uint32_t) * startIndexLocation;
+        ResourceFormat indexFormat = mState.pVao->getIndexBufferFormat();
 
-        gl_call(glDrawElementsInstancedBaseVertexBaseInstance(glTopology, indexCount, GL_UNSIGNED_INT, (void*)(uintptr_t)offset, instanceCount, baseVertexLocation, startInstanceLocation));
+        gl_call(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, pArgBuffer->getApiHandle()));
+        gl_call(glMultiDrawElementsIndirect(glTopology, getGlIndexType(indexFormat), (void*)(uintptr_t)argBufferOffset, drawCount, 0));
+        gl_call(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
     }
 
     void RenderContext::applyViewport(uint32_t index) const
@@ -153,14 +153,17 @@ namespace Falcor
             if(isCompressedFormat(format))
             {
 				GLenum glFormat = getGlSizedFormat(format);
-				uint32_t requiredSize;
+				uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+				uint32_t blockHeight = getFormatHeightCompressionRatio(format);
 				uint8_t *data = (uint8_t*)pData;
 				for (uint32_t i = 0; i < mipLevels; ++i) 
 				{
-					gl_call(glGetTextureLevelParameteriv(apiHandle, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, (int*)&requiredSize));
-					glCompressedTextureSubImage2D(apiHandle, i, 0, 0, width, height, glFormat, requiredSize, data);
-					uint32_t offset = getFormatBytesPerBlock(format) * (width >> i) * (height >> i) / getFormatPixelsPerBlock(format);
-					data += offset;
+					// Levels are stored back to back, each one padded to whole blocks
+					uint32_t mipWidth = max(1U, width >> i);
+					uint32_t mipHeight = max(1U, height >> i);
+					uint32_t size = getFormatBytesPerBlock(format) * ((mipWidth + blockWidth - 1) / blockWidth) * ((mipHeight + blockHeight - 1) / blockHeight);
+					gl_call(glCompressedTextureSubImage2D(apiHandle, i, 0, 0, mipWidth, mipHeight, glFormat, size, data));
+					data += size;
 					if (autoGenerateMipMaps)
 					{
 						break;
@@ -174,9 +177,10 @@ namespace Falcor
 				uint8_t *data = (uint8_t*)pData;
 				for (uint32_t i = 0; i < mipLevels; ++i)
 				{
-					gl_call(glTextureSubImage2D(apiHandle, i, 0, 0, width, height, baseFormat, baseType, data));
-					uint32_t offset = getFormatBytesPerBlock(format) * (width >> i) * (height >> i) / getFormatPixelsPerBlock(format);
-					data += offset;
+					uint32_t mipWidth = max(1U, width >> i);
+					uint32_t mipHeight = max(1U, height >> i);
+					gl_call(glTextureSubImage2D(apiHandle, i, 0, 0, mipWidth, mipHeight, baseFormat, baseType, data));
+					data += getFormatBytesPerBlock(format) * mipWidth * mipHeight;
 					if (autoGenerateMipMaps)
 					{
 						break;
@@ -698,7 +702,10 @@ namespace Falcor
 
     void Texture::copySubresource(const Texture* pDst, uint32_t srcMipLevel, uint32_t srcArraySlice, uint32_t dstMipLevel, uint32_t dstArraySlice) const
     {
-        gl_call(glCopyImageSubData(mApiHandle, convertTexTypeToGL(mType, mArraySize), srcMipLevel, 0, 0, srcArraySlice, pDst->mApiHandle, convertTexTypeToGL(pDst->mType, pDst->mArraySize), dstMipLevel, 0, 0, dstArraySlice, mWidth, mHeight, mDepth));
+        // Copy the size of the source mip-level. For array textures, the depth is the number of slices to copy.
+        uint32_t width, height, depth;
+        getMipLevelImageSize(srcMipLevel, width, height, depth);
+        gl_call(glCopyImageSubData(mApiHandle, convertTexTypeToGL(mType, mArraySize), srcMipLevel, 0, 0, srcArraySlice, pDst->mApiHandle, convertTexTypeToGL(pDst->mType, pDst->mArraySize), dstMipLevel, 0, 0, dstArraySlice, width, height, depth));
     }
 
 
@@ -34,7 +34,7 @@
 
 namespace Falcor
 {
-    bool checkVaoParams(const Vao::VertexBufferDescVector& vbDesc, Buffer* pIB);
+    bool checkVaoParams(const Vao::VertexBufferDescVector& vbDesc, Buffer* pIB, ResourceFormat ibFormat);
 
     static bool shouldBindAttribAsInteger(ResourceFormat format)
     {
@@ -370,6 +370,7 @@ namespace Falcor
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, desc.apiMajorVersion);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, desc.apiMinorVersion);
         glfwWindowHint(GLFW_RESIZABLE, desc.resizableWindow);
+        glfwWindowHint(GLFW_VISIBLE, !desc.isHidden);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  // Block legacy API.
         glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, desc.useDebugContext);
 #ifdef _DEBUG
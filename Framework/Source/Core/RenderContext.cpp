@@ -62,11 +62,151 @@ namespace Falcor
         mScStack.resize(viewportCount);
         for(uint32_t i = 0; i < viewportCount; i++)
         {
-            applyViewport(i);
-            applyScissor(i);
+            commitState(StateCategory::Viewport, i);
+            commitState(StateCategory::Scissor, i);
         }
     }
 
+    void RenderContext::Stats::reset()
+    {
+        for(uint32_t i = 0; i < (uint32_t)StateCategory::Count; i++)
+        {
+            appliedChanges[i] = 0;
+            filteredChanges[i] = 0;
+        }
+        drawCount = 0;
+        boundBufferCount = 0;
+    }
+
+    uint32_t RenderContext::Stats::getTotalAppliedChanges() const
+    {
+        uint32_t total = 0;
+        for(uint32_t i = 0; i < (uint32_t)StateCategory::Count; i++)
+        {
+            total += appliedChanges[i];
+        }
+        return total;
+    }
+
+    uint32_t RenderContext::Stats::getTotalFilteredChanges() const
+    {
+        uint32_t total = 0;
+        for(uint32_t i = 0; i < (uint32_t)StateCategory::Count; i++)
+        {
+            total += filteredChanges[i];
+        }
+        return total;
+    }
+
+    template<typename T>
+    bool RenderContext::needsApply(ApiValue<T>& apiValue, const T& value, StateCategory category)
+    {
+        if(mStateFiltering && apiValue.isValid && apiValue.value == value)
+        {
+            mStats.filteredChanges[(uint32_t)category]++;
+            return false;
+        }
+        apiValue.value = value;
+        apiValue.isValid = true;
+        mStats.appliedChanges[(uint32_t)category]++;
+        return true;
+    }
+
+    void RenderContext::commitState(StateCategory category, uint32_t index)
+    {
+        switch(category)
+        {
+        case StateCategory::Fbo:
+            mStats.appliedChanges[(uint32_t)category]++;
+            if(mApiSubmission)
+            {
+                applyFbo();
+            }
+            break;
+        case StateCategory::Vao:
+            if(needsApply(mApiState.vao, mState.pVao, category) && mApiSubmission)
+            {
+                applyVao();
+            }
+            break;
+        case StateCategory::Topology:
+            if(needsApply(mApiState.topology, mState.topology, category) && mApiSubmission)
+            {
+                applyTopology();
+            }
+            break;
+        case StateCategory::RasterizerState:
+            if(needsApply(mApiState.rastState, mState.pRastState, category) && mApiSubmission)
+            {
+                applyRasterizerState();
+            }
+            break;
+        case StateCategory::DepthStencilState:
+            if(needsApply(mApiState.dsState, std::make_pair(mState.pDsState, mState.stencilRef), category) && mApiSubmission)
+            {
+                applyDepthStencilState();
+            }
+            break;
+        case StateCategory::BlendState:
+            if(needsApply(mApiState.blendState, std::make_pair(mState.pBlendState, mState.sampleMask), category) && mApiSubmission)
+            {
+                applyBlendState();
+            }
+            break;
+        case StateCategory::Program:
+            if(needsApply(mApiState.program, mState.pProgram, category) && mApiSubmission)
+            {
+                applyProgram();
+            }
+            break;
+        case StateCategory::UniformBuffer:
+            mApiState.uniformBuffers.resize(mState.pUniformBuffers.size());
+            if(needsApply(mApiState.uniformBuffers[index], mState.pUniformBuffers[index], category) && mApiSubmission)
+            {
+                applyUniformBuffer(index);
+            }
+            break;
+        case StateCategory::ShaderStorageBuffer:
+            mApiState.shaderStorageBuffers.resize(mState.pShaderStorageBuffers.size());
+            if(needsApply(mApiState.shaderStorageBuffers[index], mState.pShaderStorageBuffers[index], category) && mApiSubmission)
+            {
+                applyShaderStorageBuffer(index);
+            }
+            break;
+        case StateCategory::Viewport:
+            mApiState.viewports.resize(mState.viewports.size());
+            if(needsApply(mApiState.viewports[index], mState.viewports[index], category) && mApiSubmission)
+            {
+                applyViewport(index);
+            }
+            break;
+        case StateCategory::Scissor:
+            mApiState.scissors.resize(mState.scissors.size());
+            if(needsApply(mApiState.scissors[index], mState.scissors[index], category) && mApiSubmission)
+            {
+                applyScissor(index);
+            }
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    void RenderContext::invalidateApiState()
+    {
+        mApiState = ApiState();
+    }
+
+    void RenderContext::setApiSubmission(bool enabled)
+    {
+        if(enabled && (mApiSubmission == false))
+        {
+            // The tracked state was never sent
+            invalidateApiState();
+        }
+        mApiSubmission = enabled;
+    }
+
     const RenderContext::Viewport& RenderContext::getViewport(uint32_t index) const
     {
         if(index >= mState.viewports.size())
@@ -101,23 +241,32 @@ namespace Falcor
         }
         mState = mStateStack.top();
 
-        // And set all state objects
-        applyFbo();
-        applyVao();
-        applyTopology();
-        applyRasterizerState();
-        applyDepthStencilState();
-        applyBlendState();
-        applyProgram();
+        // And set all state objects. Only the ones that changed since pushState() reach the API.
+        if(mState.pFbo->checkStatus())
+        {
+            commitState(StateCategory::Fbo);
+        }
+        commitState(StateCategory::Vao);
+        commitState(StateCategory::Topology);
+        commitState(StateCategory::RasterizerState);
+        commitState(StateCategory::DepthStencilState);
+        commitState(StateCategory::BlendState);
+        commitState(StateCategory::Program);
 
         for(uint32_t i = 0; i < mState.pUniformBuffers.size(); i++)
         {
-            applyUniformBuffer(i);
+            commitState(StateCategory::UniformBuffer, i);
+        }
+
+        for(uint32_t i = 0; i < mState.pShaderStorageBuffers.size(); i++)
+        {
+            commitState(StateCategory::ShaderStorageBuffer, i);
         }
 
         for(uint32_t i = 0; i < mState.viewports.size(); i++)
         {
-            applyViewport(i);
+            commitState(StateCategory::Viewport, i);
+            commitState(StateCategory::Scissor, i);
         }
 
         mStateStack.pop();
@@ -179,36 +328,34 @@ namespace Falcor
 
     void RenderContext::setDepthStencilState(const DepthStencilState::SharedConstPtr& pDepthStencil, uint32_t stencilRef)
     {
-        // Not checking if the state actually changed. Some of the externals libraries we use make raw API calls, bypassing the render-context, so checking if the state actually changed might lead to unexpected behavior.
         mState.pDsState = (pDepthStencil == nullptr) ? mpDefaultDepthStencilState : pDepthStencil;
         mState.stencilRef = stencilRef;
-
-        applyDepthStencilState();
+        commitState(StateCategory::DepthStencilState);
     }
 
     void RenderContext::setRasterizerState(const RasterizerState::SharedConstPtr& pRastState)
     {
         mState.pRastState = (pRastState == nullptr) ? mpDefaultRastState : pRastState;
-        applyRasterizerState();
+        commitState(StateCategory::RasterizerState);
     }
 
     void RenderContext::setBlendState(const BlendState::SharedConstPtr& pBlendState, uint32_t sampleMask)
     {
         mState.pBlendState = (pBlendState == nullptr) ? mpDefaultBlendState : pBlendState;
         mState.sampleMask = sampleMask;
-        applyBlendState();
+        commitState(StateCategory::BlendState);
     }
 
     void RenderContext::setProgram(const ProgramVersion::SharedConstPtr& pProgram)
     {
         mState.pProgram = pProgram;
-        applyProgram();
+        commitState(StateCategory::Program);
     }
 
     void RenderContext::setVao(const Vao::SharedConstPtr& pVao)
     {
         mState.pVao = pVao;
-        applyVao();
+        commitState(StateCategory::Vao);
     }
 
     Fbo::SharedConstPtr RenderContext::getFbo() const
@@ -222,7 +369,7 @@ namespace Falcor
         mState.pFbo = pTemp;
         if(pTemp->checkStatus())
         {
-            applyFbo();
+            commitState(StateCategory::Fbo);
         }
     }
 
@@ -231,7 +378,7 @@ namespace Falcor
         if ( index != 0xFFFFFFFFu )  // check that index isn't -1 (i.e., an invalid return from GL calls)
         {
             mState.pUniformBuffers[index] = pBuffer;
-            applyUniformBuffer( index );
+            commitState(StateCategory::UniformBuffer, index);
         }
     }
 
@@ -239,16 +386,15 @@ namespace Falcor
     {
         if ( index != 0xFFFFFFFFu )
         {
-            // Not checking if the state actually changed. Some of the externals libraries we use make raw API calls, bypassing the render-context, so checking if the state actually changed might lead to unexpected behavior.
             mState.pShaderStorageBuffers[index] = pBuffer;
-            applyShaderStorageBuffer( index );
+            commitState(StateCategory::ShaderStorageBuffer, index);
         }
     }
 
     void RenderContext::setTopology(Topology topology)
     {
         mState.topology = topology;
-        applyTopology();
+        commitState(StateCategory::Topology);
     }
 
     void RenderContext::setViewport(uint32_t index, const Viewport& vp)
@@ -260,7 +406,7 @@ namespace Falcor
         }
 
         mState.viewports[index] = vp;
-        applyViewport(index);
+        commitState(StateCategory::Viewport, index);
     }
 
 
@@ -273,16 +419,21 @@ namespace Falcor
         }
 
         mState.scissors[index] = sc;
-        applyScissor(index);
+        commitState(StateCategory::Scissor, index);
     }
 
-    void RenderContext::prepareForDraw() const
+    bool RenderContext::prepareForDraw() const
     {
+        mStats.drawCount++;
         for(auto& pUBO : mState.pUniformBuffers)
         {
             if(pUBO)
             {
-                pUBO->uploadToGPU();
+                if(mApiSubmission)
+                {
+                    pUBO->uploadToGPU();
+                }
+                mStats.boundBufferCount++;
             }
         }
 
@@ -290,10 +441,20 @@ namespace Falcor
         {
             if(pSSBO)
             {
-                pSSBO->uploadToGPU();
-                pSSBO->setGpuCopyDirty();
+                if(mApiSubmission)
+                {
+                    pSSBO->uploadToGPU();
+                    pSSBO->setGpuCopyDirty();
+                }
+                mStats.boundBufferCount++;
             }
         }
+
+        if(mApiSubmission == false)
+        {
+            return false;
+        }
         prepareForDrawApi();
+        return true;
     }
 }
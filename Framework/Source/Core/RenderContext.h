@@ -71,6 +71,11 @@ namespace Falcor
             float height   = 0;
             float minDepth = 0;
             float maxDepth = 1;
+
+            bool operator==(const Viewport& other) const
+            {
+                return originX == other.originX && originY == other.originY && width == other.width && height == other.height && minDepth == other.minDepth && maxDepth == other.maxDepth;
+            }
         };
 
         struct Scissor
@@ -79,6 +84,44 @@ namespace Falcor
             int32_t originY = 0;
             int32_t width = 0;
             int32_t height = 0;
+
+            bool operator==(const Scissor& other) const
+            {
+                return originX == other.originX && originY == other.originY && width == other.width && height == other.height;
+            }
+        };
+
+        /** Categories of pipeline state, used by the state-change statistics
+        */
+        enum class StateCategory
+        {
+            Fbo,
+            Vao,
+            Topology,
+            RasterizerState,
+            DepthStencilState,
+            BlendState,
+            Program,
+            UniformBuffer,
+            ShaderStorageBuffer,
+            Viewport,
+            Scissor,
+            Count
+        };
+
+        /** State-change and draw counters. Sample resets them at the beginning of every frame.
+        */
+        struct Stats
+        {
+            uint32_t appliedChanges[(uint32_t)StateCategory::Count];    ///< State changes sent to the API
+            uint32_t filteredChanges[(uint32_t)StateCategory::Count];   ///< Redundant state changes which were skipped
+            uint32_t drawCount;                                         ///< Number of draw calls
+            uint32_t boundBufferCount;                                  ///< Number of uniform and shader storage buffers bound at draw time, summed over all draws
+
+            Stats() { reset(); }
+            void reset();
+            uint32_t getTotalAppliedChanges() const;
+            uint32_t getTotalFilteredChanges() const;
         };
 
         /** create a new object
@@ -93,14 +136,14 @@ namespace Falcor
             \param[in] startVertexLocation The location of the first vertex to read from the vertex buffers (offset in vertices)
         */
         void draw(uint32_t vertexCount, uint32_t startVertexLocation);
-        /** Indexed draw call
+        /** Indexed draw call. The index format is taken from the bound VAO (see Vao#getIndexBufferFormat()).
             \param[in] indexCount Number of indices to draw
             \param[in] startIndexLocation The location of the first index to read from the index buffer (offset in indices)
             \param[in] baseVertexLocation A value which is added to each index before reading a vertex from the vertex buffer
         */
         void drawIndexed(uint32_t indexCount, uint32_t startIndexLocation, int baseVertexLocation);
 
-        /** Indexed instanced draw call
+        /** Indexed instanced draw call. The index format is taken from the bound VAO (see Vao#getIndexBufferFormat()).
             \param[in] indexCount Number of indices to draw per instance
             \param[in] instanceCount Number of instances to draw
             \param[in] startIndexLocation The location of the first index to read from the index buffer (offset in indices)
@@ -109,6 +152,14 @@ namespace Falcor
         */
         void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndexLocation, int baseVertexLocation, uint32_t startInstanceLocation);
 
+        /** Indexed indirect multi-draw call. Issues several indexed instanced draws whose arguments are read from a GPU buffer. The index format is taken from the bound VAO.
+            Each argument record holds 5 32-bit values: indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation. This matches both DrawElementsIndirectCommand and D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS.
+            \param[in] pArgBuffer The argument buffer. Must be created with Buffer#BindFlags#IndirectArgs.
+            \param[in] drawCount Number of argument records to consume
+            \param[in] argBufferOffset Byte offset of the first argument record
+        */
+        void multiDrawIndexedIndirect(const Buffer* pArgBuffer, uint32_t drawCount, uint64_t argBufferOffset = 0);
+
         /** Get current FBO.
         */
         Fbo::SharedConstPtr getFbo() const;
@@ -141,10 +192,40 @@ namespace Falcor
         */
         void pushState();
         /** Restore the last state saved into the stack. If the stack is empty will log an error.\n
-            Using this function might lead to undesirable performance degradation. Use with care.
+            Only the state which differs from the current state is sent to the API, unless state filtering is disabled.
         */
         void popState();
 
+        /** Enable or disable redundant state filtering. When enabled (the default), state which is already bound isn't sent to the API again.
+        */
+        void setStateFiltering(bool enabled) { mStateFiltering = enabled; }
+
+        /** Check if redundant state filtering is enabled
+        */
+        bool isStateFilteringEnabled() const { return mStateFiltering; }
+
+        /** Forget the state which was sent to the API, so that the next change of every piece of state is applied.
+            Call this after code which makes raw API calls that bypass the render-context, for example third-party libraries.
+        */
+        void invalidateApiState();
+
+        /** Enable or disable API submission. When disabled, the render-context acts as a null backend - state is tracked and filtered and draws are counted, but nothing is sent to the API and bound buffers aren't uploaded.
+            Use it to measure the CPU cost of a frame without the driver's cost. Calls which bypass the state tracking, like clears and blits, still reach the API.
+        */
+        void setApiSubmission(bool enabled);
+
+        /** Check if API submission is enabled
+        */
+        bool isApiSubmissionEnabled() const { return mApiSubmission; }
+
+        /** Get the state-change and draw counters
+        */
+        const Stats& getStats() const { return mStats; }
+
+        /** Reset the state-change and draw counters
+        */
+        void resetStats() { mStats.reset(); }
+
         /** Set a new vertex array object. By default, no VAO is bound.
             \param[in] pVao The CVao object to bind. If this is nullptr, will unbind the current VAO.
         */
@@ -219,6 +300,10 @@ namespace Falcor
         */
         const Viewport& getViewport(uint32_t index) const;
 
+        /** Get the number of viewport slots
+        */
+        uint32_t getViewportCount() const { return (uint32_t)mState.viewports.size(); }
+
         /** Push the current viewport and sets a new one
         */
         void pushViewport(uint32_t index, const Viewport& vp);
@@ -265,7 +350,36 @@ namespace Falcor
             ProgramVersion::SharedConstPtr pProgram = nullptr;
         };
 
+        /** A copy of a piece of state which was sent to the API
+        */
+        template<typename T>
+        struct ApiValue
+        {
+            T value;
+            bool isValid = false;
+        };
+
+        /** The state last sent to the API. FBOs aren't tracked since their attachments can change without the object changing.
+        */
+        struct ApiState
+        {
+            ApiValue<Vao::SharedConstPtr> vao;
+            ApiValue<Topology> topology;
+            ApiValue<RasterizerState::SharedConstPtr> rastState;
+            ApiValue<std::pair<DepthStencilState::SharedConstPtr, uint32_t>> dsState;
+            ApiValue<std::pair<BlendState::SharedConstPtr, uint32_t>> blendState;
+            ApiValue<ProgramVersion::SharedConstPtr> program;
+            std::vector<ApiValue<UniformBuffer::SharedConstPtr>> uniformBuffers;
+            std::vector<ApiValue<ShaderStorageBuffer::SharedConstPtr>> shaderStorageBuffers;
+            std::vector<ApiValue<Viewport>> viewports;
+            std::vector<ApiValue<Scissor>> scissors;
+        };
+
         State mState;
+        ApiState mApiState;
+        bool mStateFiltering = true;
+        bool mApiSubmission = true;
+        mutable Stats mStats;
         std::stack<State> mStateStack;
         std::stack<Fbo::SharedPtr> mFboStack;
         std::vector<std::stack<Viewport>> mVpStack;
@@ -277,6 +391,14 @@ namespace Falcor
         DepthStencilState::SharedConstPtr mpDefaultDepthStencilState;
         Fbo::SharedPtr mpEmptyFBO;
 
+        /** Send a piece of the current state to the API, unless it's already bound
+            \param[in] category The state to send
+            \param[in] index Slot index for uniform buffers, shader storage buffers, viewports and scissors
+        */
+        void commitState(StateCategory category, uint32_t index = 0);
+        template<typename T>
+        bool needsApply(ApiValue<T>& apiValue, const T& value, StateCategory category);
+
         // Internal functions used by the API layers
         void applyViewport(uint32_t index) const;
         void applyScissor(uint32_t index) const;
@@ -289,7 +411,10 @@ namespace Falcor
         void applyUniformBuffer(uint32_t Index) const;
         void applyShaderStorageBuffer(uint32_t Index) const;
         void applyTopology() const;
-        void prepareForDraw() const;
+        /** Upload the bound buffers and count the draw
+            \return false if API submission is disabled and the draw should be skipped
+        */
+        bool prepareForDraw() const;
         void prepareForDrawApi() const;
     };
 }
\ No newline at end of file
@@ -156,6 +156,14 @@ namespace Falcor
         */
         Buffer::SharedPtr getBuffer() const { return mpBuffer; }
 
+        /** Get the CPU copy of the buffer's data
+        */
+        const void* getData() const { return mData.data(); }
+
+        /** Get the size of the buffer's data in bytes
+        */
+        size_t getSize() const { return mSize; }
+
         /** Get uniform offset inside the buffer. See notes about naming in the UniformBuffer class description. Uniform name can be provided with an implicit array-index, similar to UniformBuffer#SetVariableArray.
         */
         size_t getVariableOffset(const std::string& varName) const;
@@ -169,6 +177,24 @@ namespace Falcor
         void setBlob(const void* pSrc, size_t offset, size_t size);
 
         static const size_t kInvalidUniformOffset = (size_t)-1;
+
+#ifdef FALCOR_DX11
+        using ShaderResourceMap = std::map<uint32_t, ID3D11ShaderResourceViewPtr>;
+        using SamplerMap = std::map<uint32_t, ID3D11SamplerStatePtr>;
+
+        /** Get the shader resource views assigned with setTexture(). They are shared by all the buffers created from the same program.
+        */
+        const ShaderResourceMap& getAssignedResourcesMap() const { return *mAssignedResourcesMap; }
+
+        /** Get the samplers assigned with setTexture(). They are shared by all the buffers created from the same program.
+        */
+        const SamplerMap& getAssignedSamplersMap() const { return *mAssignedSamplersMap; }
+
+        /** Replace all of the program's shader resource views and samplers, for example with ones captured from getAssignedResourcesMap() and getAssignedSamplersMap().
+            This affects all the buffers created from the same program.
+        */
+        void setAssignedResources(const ShaderResourceMap& srvs, const SamplerMap& samplers);
+#endif
     protected:
         bool init(const ProgramVersion* pProgram, const std::string& bufferName, size_t overrideSize, bool isUniformBuffer);
         bool apiInit(const ProgramVersion* pProgram, const std::string& bufferName, bool isUniformBuffer);
@@ -189,10 +215,8 @@ namespace Falcor
 
 #ifdef FALCOR_DX11
         friend class RenderContext;
-        std::map<uint32_t, ID3D11ShaderResourceViewPtr>* mAssignedResourcesMap;
-        std::map<uint32_t, ID3D11SamplerStatePtr>* mAssignedSamplersMap;
-        const std::map<uint32_t, ID3D11ShaderResourceViewPtr>& getAssignedResourcesMap() const { return *mAssignedResourcesMap; }
-        const std::map<uint32_t, ID3D11SamplerStatePtr>& getAssignedSamplersMap() const { return *mAssignedSamplersMap; }
+        ShaderResourceMap* mAssignedResourcesMap;
+        SamplerMap* mAssignedSamplersMap;
 #endif
     };
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 #include <vector>
 #include "VertexLayout.h"
 #include "Buffer.h"
+#include "Formats.h"
 
 namespace Falcor
 {
@@ -62,8 +63,9 @@ namespace Falcor
         /** create a new object
             \param vbDesc Array of pointers to vertex buffer descriptor. Must have at least 1 element
             \param pIB Pointer to the index-buffer. Can be nullptr, in which case no index-buffer will be bound.
+            \param ibFormat The format of the index-buffer elements. Must be either ResourceFormat#R16Uint or ResourceFormat#R32Uint.
         */
-        static SharedPtr create(const VertexBufferDescVector& vbDesc, const Buffer::SharedPtr& pIB);
+        static SharedPtr create(const VertexBufferDescVector& vbDesc, const Buffer::SharedPtr& pIB, ResourceFormat ibFormat = ResourceFormat::R32Uint);
         ~Vao();
 
         /** Get the API handle
@@ -95,17 +97,22 @@ namespace Falcor
         */
         Buffer::SharedConstPtr getIndexBuffer() const { return mpIB; }
 
+        /** Get the index buffer format. Either ResourceFormat#R16Uint or ResourceFormat#R32Uint
+        */
+        ResourceFormat getIndexBufferFormat() const { return mIbFormat; }
+
     protected:
         friend class RenderContext;
 #ifdef FALCOR_DX11
         ID3D11InputLayoutPtr getInputLayout(ID3DBlob* pVsBlob) const;
 #endif
     private:
-        Vao(const VertexBufferDescVector& vbDesc, const Buffer::SharedPtr& pIB);
+        Vao(const VertexBufferDescVector& vbDesc, const Buffer::SharedPtr& pIB, ResourceFormat ibFormat);
         bool initialize();
         VaoHandle mApiHandle;
         VertexBufferDescVector mpVBs;
         Buffer::SharedConstPtr mpIB = nullptr;
+        ResourceFormat mIbFormat = ResourceFormat::R32Uint;
         void* mpPrivateData = nullptr;
     };
 }
\ No newline at end of file
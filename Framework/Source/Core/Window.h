@@ -57,6 +57,7 @@ namespace Falcor
             int apiMajorVersion = DEFAULT_API_MAJOR_VERSION; ///< Requested API major version. Context creation fails if this version is not supported.
             int apiMinorVersion = DEFAULT_API_MINOR_VERSION; ///< Requested API minor version. Context creation fails if this version is not supported.
             bool resizableWindow = false;          ///< Allow the user to resize the window.
+            bool isHidden = false;                 ///< Create the device and the swap-chain without showing the window. Used for headless runs.
             bool useDebugContext = false;             ///< create a debug context. NOTE: Debug configuration always creates a debug context
             std::vector<std::string> requiredExtensions; ///< Extensions required by the sample
         };
@@ -27,16 +27,20 @@
 ***************************************************************************/
 #version 440
 #include "hlslglslcommon.h"
+#expect _TILE_SIZE
+#expect _TARGET_COUNT
 
 UNIFORM_BUFFER(PerImageCB, 0)
 {
-   sampler2D gInputTex;
+    sampler2D gInputTex[_TARGET_COUNT];
+    vec2 gHistogramRange;
 };
 
+#ifdef _MIN_MAX_REDUCTION
 #ifdef _FIRST_ITERATION
 vec2 compareMinMax(vec2 crd, vec2 range)
 {
-    vec4 d4 = textureGather(gInputTex, crd, 0);
+    vec4 d4 = textureGather(gInputTex[0], crd, 0);
 
     for(int i = 0 ; i < 4 ; i++)
     {
@@ -51,8 +55,8 @@ vec2 compareMinMax(vec2 crd, vec2 range)
 #else
 vec2 compareMinMax(vec2 crd, vec2 range)
 {
-    vec4 min4 = textureGather(gInputTex, crd, 0);
-    vec4 max4 = textureGather(gInputTex, crd, 1);
+    vec4 min4 = textureGather(gInputTex[0], crd, 0);
+    vec4 max4 = textureGather(gInputTex[0], crd, 1);
     float prevMin = min(min4.x, min(min4.y, min(min4.z, min4.w)));
     float prevMax = max(max4.x, max(max4.y, max(max4.z, max4.w)));
      
@@ -62,10 +66,10 @@ vec2 compareMinMax(vec2 crd, vec2 range)
 }
 #endif
 
-vec2 minMaxReduction(vec2 texC)
+void reduce(out vec4 results[_TARGET_COUNT])
 {
     vec2 range = vec2(1, 0);
-    ivec2 dim = textureSize(gInputTex, 0);
+    ivec2 dim = textureSize(gInputTex[0], 0);
 
     // Using gather4, so need to skip 4 samples everytime
     for(int x = 0 ; x < _TILE_SIZE ; x+=2)
@@ -73,26 +77,86 @@ vec2 minMaxReduction(vec2 texC)
         for(int y = 0 ; y < _TILE_SIZE ; y+=2)
         {
             ivec2 crd = ivec2(gl_FragCoord.xy) * _TILE_SIZE + ivec2(x, y);
-            vec2 normalizedCrd = vec2(crd)/vec2(dim);
+            // Gather the 2x2 texels starting at crd. Their shared corner is at crd + 1.
+            vec2 normalizedCrd = vec2(crd + 1)/vec2(dim);
 
             range = compareMinMax(normalizedCrd, range);
         }
     }
-    return range;
+    results[0] = vec4(range, 0, 0);
+}
+#else
+// The other reductions fetch each texel exactly once, so sums don't count the edge texels twice
+void accumulate(ivec2 crd, inout vec4 results[_TARGET_COUNT])
+{
+#ifdef _FIRST_ITERATION
+    vec4 value = texelFetch(gInputTex[0], crd, 0);
+#if defined _CHANNEL_MIN_MAX_REDUCTION
+    results[0] = min(results[0], value);
+    results[1] = max(results[1], value);
+#elif defined _SUM_REDUCTION
+    results[0] += value;
+#elif defined _LOG_LUMINANCE_REDUCTION
+    float luminance = dot(value.rgb, vec3(0.299f, 0.587f, 0.114f));
+    results[0].x += log(max(0.0001f, luminance));
+#elif defined _HISTOGRAM_REDUCTION
+    float bin = floor((value.r - gHistogramRange.x) / (gHistogramRange.y - gHistogramRange.x) * _BIN_COUNT);
+    if(bin >= 0 && bin < _BIN_COUNT)
+    {
+        int i = int(bin);
+        results[i / 4][i % 4] += 1;
+    }
+#endif
+#else
+#if defined _CHANNEL_MIN_MAX_REDUCTION
+    results[0] = min(results[0], texelFetch(gInputTex[0], crd, 0));
+    results[1] = max(results[1], texelFetch(gInputTex[1], crd, 0));
+#else
+    for(int i = 0 ; i < _TARGET_COUNT ; i++)
+    {
+        results[i] += texelFetch(gInputTex[i], crd, 0);
+    }
+#endif
+#endif
 }
 
+void reduce(out vec4 results[_TARGET_COUNT])
+{
+#ifdef _CHANNEL_MIN_MAX_REDUCTION
+    results[0] = vec4(3.402823466e+38f);
+    results[1] = vec4(-3.402823466e+38f);
+#else
+    for(int i = 0 ; i < _TARGET_COUNT ; i++)
+    {
+        results[i] = vec4(0);
+    }
+#endif
+
+    ivec2 dim = textureSize(gInputTex[0], 0);
+    ivec2 tileStart = ivec2(gl_FragCoord.xy) * _TILE_SIZE;
+    ivec2 tileEnd = min(tileStart + ivec2(_TILE_SIZE), dim);
+    for(int y = tileStart.y ; y < tileEnd.y ; y++)
+    {
+        for(int x = tileStart.x ; x < tileEnd.x ; x++)
+        {
+            accumulate(ivec2(x, y), results);
+        }
+    }
+}
+#endif
+
 #ifdef FALCOR_HLSL
-vec2 main(float2 texC  : TEXCOORD) : SV_TARGET0
+void main(float2 texC : TEXCOORD, out vec4 results[_TARGET_COUNT] : SV_TARGET0)
 {
-    return minMaxReduction();
+    reduce(results);
 }
 
 #elif defined FALCOR_GLSL
 in vec2 texC;
-out vec2 fragColor;
+out vec4 fragColor[_TARGET_COUNT];
 
 void main()
 {
-    fragColor = minMaxReduction(texC);
+    reduce(fragColor);
 }
 #endif
\ No newline at end of file
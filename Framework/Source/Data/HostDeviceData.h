@@ -238,6 +238,12 @@ struct CameraData
 #define     NDFGGX             1    ///< GGX distribution for NDF
 #define     NDFUser            2    ///< User-defined distribution for NDF, should be processed by user
 
+/** Type of the normal map, stored in MaterialDesc::hasNormalMap
+*/
+#define     NormalMapNone      0    ///< No normal map
+#define     NormalMapRGB       1    ///< The texture stores all three components of the normal
+#define     NormalMapRG        2    ///< Two-channel texture, such as BC5. Z is reconstructed from X and Y.
+
 #define     BlendFresnel       0    ///< Material layer is blended according to Fresnel
 #define     BlendConstant      1    ///< Material layer is blended according to a constant factor stored in w component of constant color
 #define     BlendAdd           2    ///< Material layer is added to the previous layers
@@ -295,7 +301,7 @@ struct MaterialDesc
 {
     MaterialLayerDesc   layers[MatMaxLayers];     // First one is a terminal layer, usually either opaque with coating, or dielectric; others are optional layers, usually a transparent dielectric coating layer or a mixture with conductor
     uint32_t            hasAlphaMap     DEFAULTS(0);
-    uint32_t            hasNormalMap    DEFAULTS(0);
+    uint32_t            hasNormalMap    DEFAULTS(0);     ///< One of the NormalMap* values
     uint32_t            hasHeightMap    DEFAULTS(0);
     uint32_t            hasAmbientMap   DEFAULTS(0);
 };
@@ -375,6 +381,7 @@ struct LightData
 	BufPtr          texCoordPtr;                                  ///< Buffer id for texcoord
 
 	BufPtr          meshCDFPtr;                                   ///< Pointer to probability distributions of triangle meshes
+	BufPtr          aliasTablePtr;                                ///< Pointer to the triangle alias table (pairs of {float threshold, uint alias})
 
 	MaterialData    material;                                     ///< Emissive material of the geometry mesh
 
@@ -384,6 +391,26 @@ struct LightData
 	uint32_t        pad3               DEFAULTS(0);
 };
 
+/**
+    Clustered light lists. The view frustum is split into tileCountX * tileCountY screen tiles and sliceCount exponential depth slices.
+    Each cluster holds an {offset, count} pair into the light index list. The indices point into the light data array.
+*/
+struct LightClusterData
+{
+	uint32_t        tileCountX         DEFAULTS(16);              ///< Number of screen tiles along X
+	uint32_t        tileCountY         DEFAULTS(8);               ///< Number of screen tiles along Y
+	uint32_t        sliceCount         DEFAULTS(24);              ///< Number of depth slices
+	uint32_t        lightCount         DEFAULTS(0);               ///< Number of lights in the light data array
+	float           nearZ              DEFAULTS(0.1f);            ///< View depth of the first slice
+	float           logDepthScale      DEFAULTS(1.f);             ///< sliceCount / log(farZ / nearZ)
+	float           pad0               DEFAULTS(0);
+	float           pad1               DEFAULTS(0);
+
+	BufPtr          clusterPtr;                                   ///< Per-cluster {offset, count} pairs
+	BufPtr          lightIndexPtr;                                ///< Light indices referenced by the clusters
+	BufPtr          lightDataPtr;                                 ///< Array of LightData
+};
+
 /*******************************************************************
                     Shared material routines
 *******************************************************************/
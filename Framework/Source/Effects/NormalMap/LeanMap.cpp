@@ -30,77 +30,266 @@
 #include "Data/Effects/LeanMapData.h"
 #include "Graphics/Material/Material.h"
 #include "Graphics/Scene/Scene.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/ImageProcessing.h"
+#include "Utils/OS.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/TextureCompressor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define LEAN_MAP_USE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Falcor
 {
+    std::string LeanMap::sCacheDirectory;
+
+    static const float kEpsilon = 1e-3f;
+    static const float kMaxHalf = 65504.0f;         // The second moments are clamped, so that RGBA16F doesn't overflow
+    static const uint32_t kCacheMagic = 0x4E41454C; // 'LEAN'
+    static const uint32_t kCacheVersion = 1;
+
+    // Where the normal components are stored in a texel
+    struct NormalMapLayout
+    {
+        uint32_t bytesPerPixel;
+        uint32_t xOffset;
+        uint32_t yOffset;
+        uint32_t zOffset;
+        bool isSrgb;
+        bool reconstructZ;      // 2-channel maps only store X and Y
+    };
+
+    static bool getNormalMapLayout(ResourceFormat format, NormalMapLayout& layout)
+    {
+        switch(format)
+        {
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+            layout = {4, 0, 1, 2, isSrgbFormat(format), false};
+            return true;
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+            layout = {4, 2, 1, 0, isSrgbFormat(format), false};
+            return true;
+        case ResourceFormat::RG8Unorm:
+            layout = {2, 0, 1, 0, false, true};
+            return true;
+        case ResourceFormat::BC5Unorm:
+            // Decompressed to RGBA first
+            layout = {4, 0, 1, 2, false, true};
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Convert a single texel. This is the original scalar conversion, used for the row tails and as the reference for the SIMD path.
+    static vec4 convertTexel(vec3 n, bool reconstructZ)
+    {
+        if(reconstructZ)
+        {
+            n.z = sqrt(max(0.0f, 1.0f - n.x * n.x - n.y * n.y));
+        }
+        n.z = max(n.z, kEpsilon);
+        n = normalize(n);
+
+        // The first moment (mean) in slope space, and the second moment
+        vec2 b = vec2(n.x, n.y) / max(n.z, kEpsilon);
+        vec2 m = min(b * b, vec2(kMaxHalf));
+        return vec4(b.x * 0.5f + 0.5f, b.y * 0.5f + 0.5f, m.x, m.y);
+    }
+
+    // Convert a row of normals, stored as separate X, Y and Z arrays in [-1, 1], into RGBA LEAN texels
+    static void convertRow(const float* pX, const float* pY, const float* pZ, uint32_t width, bool reconstructZ, vec4* pDst)
+    {
+        uint32_t x = 0;
+#ifdef LEAN_MAP_USE_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 eps = _mm_set1_ps(kEpsilon);
+        const __m128 maxHalf = _mm_set1_ps(kMaxHalf);
+        for(; x + 4 <= width; x += 4)
+        {
+            __m128 nx = _mm_loadu_ps(pX + x);
+            __m128 ny = _mm_loadu_ps(pY + x);
+            __m128 nz;
+            if(reconstructZ)
+            {
+                __m128 xy2 = _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny));
+                nz = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(one, xy2)));
+            }
+            else
+            {
+                nz = _mm_loadu_ps(pZ + x);
+            }
+            nz = _mm_max_ps(nz, eps);
+
+            // Dividing the normalized XY by the normalized Z is the same as dividing the unnormalized values, except for the epsilon clamp
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+            __m128 rcpDenom = _mm_div_ps(one, _mm_max_ps(nz, _mm_mul_ps(eps, length)));
+            __m128 bx = _mm_mul_ps(nx, rcpDenom);
+            __m128 by = _mm_mul_ps(ny, rcpDenom);
+
+            __m128 r = _mm_add_ps(_mm_mul_ps(bx, half), half);
+            __m128 g = _mm_add_ps(_mm_mul_ps(by, half), half);
+            __m128 b = _mm_min_ps(_mm_mul_ps(bx, bx), maxHalf);
+            __m128 a = _mm_min_ps(_mm_mul_ps(by, by), maxHalf);
+            _MM_TRANSPOSE4_PS(r, g, b, a);
+            float* pOut = (float*)(pDst + x);
+            _mm_storeu_ps(pOut, r);
+            _mm_storeu_ps(pOut + 4, g);
+            _mm_storeu_ps(pOut + 8, b);
+            _mm_storeu_ps(pOut + 12, a);
+        }
+#endif
+        for(; x < width; x++)
+        {
+            pDst[x] = convertTexel(vec3(pX[x], pY[x], pZ[x]), reconstructZ);
+        }
+    }
+
+    static std::vector<uint16_t> convertNormalMap(const uint8_t* pData, uint32_t width, uint32_t height, const NormalMapLayout& layout)
+    {
+        // Unpack 8-bit values straight to [-1, 1]
+        float unpack[256];
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            float value = i / 255.0f;
+            unpack[i] = (layout.isSrgb ? SRGBToLinear(value) : value) * 2.0f - 1.0f;
+        }
+
+        std::vector<uint16_t> leanData((size_t)width * height * 4);
+        parallelFor(height, 8, [&](uint32_t begin, uint32_t end)
+        {
+            std::vector<float> x(width), y(width), z(width);
+            std::vector<vec4> row(width);
+            for(uint32_t rowID = begin; rowID < end; rowID++)
+            {
+                const uint8_t* pSrc = pData + (size_t)rowID * width * layout.bytesPerPixel;
+                for(uint32_t i = 0; i < width; i++)
+                {
+                    const uint8_t* pTexel = pSrc + i * layout.bytesPerPixel;
+                    x[i] = unpack[pTexel[layout.xOffset]];
+                    y[i] = unpack[pTexel[layout.yOffset]];
+                    z[i] = layout.reconstructZ ? 0.0f : unpack[pTexel[layout.zOffset]];
+                }
+                convertRow(x.data(), y.data(), z.data(), width, layout.reconstructZ, row.data());
+                ImageProcessing::convertFloatToHalf((const float*)row.data(), leanData.data() + (size_t)rowID * width * 4, (size_t)width * 4);
+            }
+        });
+        return leanData;
+    }
+
+    // FNV-1a over 64-bit words
+    static uint64_t hashData(const uint8_t* pData, size_t size, uint64_t seed)
+    {
+        const uint64_t kPrime = 1099511628211ull;
+        uint64_t hash = 14695981039346656037ull ^ seed;
+        size_t wordCount = size / sizeof(uint64_t);
+        for(size_t i = 0; i < wordCount; i++)
+        {
+            uint64_t word;
+            memcpy(&word, pData + i * sizeof(uint64_t), sizeof(word));
+            hash = (hash ^ word) * kPrime;
+        }
+        for(size_t i = wordCount * sizeof(uint64_t); i < size; i++)
+        {
+            hash = (hash ^ pData[i]) * kPrime;
+        }
+        return hash;
+    }
+
+    static std::string getCacheFilename(const std::string& dir, uint64_t hash)
+    {
+        char name[32];
+        snprintf(name, arraysize(name), "%016llx.lean", (unsigned long long)hash);
+        return dir + "\\" + name;
+    }
+
+    static bool loadFromCache(const std::string& filename, uint32_t width, uint32_t height, uint64_t hash, std::vector<uint16_t>& leanData)
+    {
+        if(doesFileExist(filename) == false)
+        {
+            return false;
+        }
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Read);
+        uint32_t magic = 0, version = 0, w = 0, h = 0;
+        uint64_t fileHash = 0;
+        stream >> magic >> version >> w >> h >> fileHash;
+        if(magic != kCacheMagic || version != kCacheVersion || w != width || h != height || fileHash != hash)
+        {
+            return false;
+        }
+
+        leanData.resize((size_t)width * height * 4);
+        stream.read(leanData.data(), leanData.size() * sizeof(uint16_t));
+        return stream.isGood();
+    }
+
+    static void saveToCache(const std::string& filename, uint32_t width, uint32_t height, uint64_t hash, const std::vector<uint16_t>& leanData)
+    {
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        stream << kCacheMagic << kCacheVersion << width << height << hash;
+        stream.write(leanData.data(), leanData.size() * sizeof(uint16_t));
+        if(stream.isGood() == false)
+        {
+            stream.remove();
+            Logger::log(Logger::Level::Warning, "Can't write LEAN map cache file " + filename);
+        }
+    }
+
     Texture::SharedPtr LeanMap::createFromNormalMap(const Falcor::Texture* pNormalMap)
     {
         uint32_t texW = pNormalMap->getWidth();
         uint32_t texH = pNormalMap->getHeight();
 
-        std::vector<vec4> leanData;
-
-        leanData.resize(texW * texH);
+        NormalMapLayout layout;
+        if(getNormalMapLayout(pNormalMap->getFormat(), layout) == false)
+        {
+            Logger::log(Logger::Level::Error, "Can't generate LEAN map. Unsupported normal map format " + to_string(pNormalMap->getFormat()) + ".");
+            return nullptr;
+        }
 
         uint32_t normalMapDataSize = pNormalMap->getMipLevelDataSize(0);
         std::vector<uint8_t> normalMapData(normalMapDataSize);
         pNormalMap->readSubresourceData(normalMapData.data(), normalMapDataSize, 0, 0);
 
-        const float oneBy255 = 1.0f / 255.0f;
-        for(auto y = 0u; y < texH; y++)
+        // Look for a cached copy. The key covers everything the result depends on.
+        std::vector<uint16_t> leanData;
+        uint64_t hash = 0;
+        std::string cacheFilename;
+        if(sCacheDirectory.size())
         {
-            for(auto x = 0u; x < texW; x++)
+            uint64_t seed = ((uint64_t)texW << 32) ^ ((uint64_t)texH << 8) ^ (uint64_t)pNormalMap->getFormat() ^ ((uint64_t)kCacheVersion << 60);
+            hash = hashData(normalMapData.data(), normalMapData.size(), seed);
+            cacheFilename = getCacheFilename(sCacheDirectory, hash);
+            if(loadFromCache(cacheFilename, texW, texH, hash, leanData) == false)
             {
-                auto texIdx = (x + y * texW);
-                vec3 tn;
+                leanData.clear();
+            }
+        }
 
-                switch(pNormalMap->getFormat())
-                {
-                case ResourceFormat::RGBA8Unorm:
-                {
-                    tn.x = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 0]), 0.0f, 1.0f);
-                    tn.y = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 1]), 0.0f, 1.0f);
-                    tn.z = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 2]), 0.0f, 1.0f);
-                } break;
-                case ResourceFormat::BGRA8Unorm:
-                case ResourceFormat::BGRX8Unorm:
-                {
-                    tn.z = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 0]), 0.0f, 1.0f);
-                    tn.y = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 1]), 0.0f, 1.0f);
-                    tn.x = clamp(oneBy255 * (float)(normalMapData[texIdx * 4 + 2]), 0.0f, 1.0f);
-                } break;
-                case ResourceFormat::RGBA8UnormSrgb:
-                {
-                    tn.x = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 0])), 0.0f, 1.0f);
-                    tn.y = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 1])), 0.0f, 1.0f);
-                    tn.z = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 2])), 0.0f, 1.0f);
-                } break;
-                case ResourceFormat::BGRA8UnormSrgb:
-                {
-                    tn.z = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 0])), 0.0f, 1.0f);
-                    tn.y = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 1])), 0.0f, 1.0f);
-                    tn.x = clamp(SRGBToLinear(oneBy255 * (float)(normalMapData[texIdx * 4 + 2])), 0.0f, 1.0f);
-                } break;
-                default: 
-                    Logger::log(Logger::Level::Error, "Can't generate LEAN map. Unsupported normal map format.");
-                    return nullptr;
-                };
-
-                // Unpack
-                static const float epsilon = 1e-3f;
-                vec3 n = tn * 2.f - vec3(1.f);
-                // And normalize the normal
-                n.z = max(n.z, epsilon);
-                n = normalize(n);
-
-                // Write out the first moment (mean) in slope space
-                vec2 b = vec2(n.x, n.y) / max(n.z, epsilon);
-                vec2 m = b*b;
-                leanData[texIdx] = vec4(b.x*0.5f + 0.5f, b.y*0.5f + 0.5f, m.x, m.y);
+        if(leanData.empty())
+        {
+            if(pNormalMap->getFormat() == ResourceFormat::BC5Unorm)
+            {
+                normalMapData = TextureCompressor::decompressImage(normalMapData.data(), texW, texH, TextureCompressor::Format::BC5);
+            }
+            leanData = convertNormalMap(normalMapData.data(), texW, texH, layout);
+
+            if(cacheFilename.size())
+            {
+                saveToCache(cacheFilename, texW, texH, hash, leanData);
             }
         }
 
-        Texture::SharedPtr pTex = Texture::create2D(texW, texH, ResourceFormat::RGBA32Float, 1, Texture::kEntireMipChain, leanData.data());
+        Texture::SharedPtr pTex = Texture::create2D(texW, texH, ResourceFormat::RGBA16Float, 1, Texture::kEntireMipChain, leanData.data());
         return pTex;
     }
 
@@ -117,7 +306,13 @@ namespace Falcor
         const Texture* pNormalMap = pMaterial->getNormalValue().texture.pTexture.get();
         if(pNormalMap)
         {
-            mpLeanMaps[materialID] = createFromNormalMap(pNormalMap);
+            // Materials which share a normal map share the LEAN map
+            auto it = mpLeanMapsBySource.find(pNormalMap);
+            if(it == mpLeanMapsBySource.end())
+            {
+                it = mpLeanMapsBySource.insert(std::make_pair(pNormalMap, createFromNormalMap(pNormalMap))).first;
+            }
+            mpLeanMaps[materialID] = it->second;
             mShaderArraySize = max(materialID + 1, mShaderArraySize);
         }
         return true;
@@ -126,6 +321,7 @@ namespace Falcor
     LeanMap::UniquePtr LeanMap::create(const Scene* pScene)
     {
         UniquePtr pLeanMaps = UniquePtr(new LeanMap);
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
 
         // Initialize scene materials
         for(uint32_t i = 0; i < pScene->getMaterialCount(); i++)
@@ -155,6 +351,11 @@ namespace Falcor
         {
             Logger::log(Logger::Level::Warning, "Trying to create SceneLeanMaps for a scene without materials.");
         }
+        else
+        {
+            double time = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            Logger::log(Logger::Level::Info, "Created " + std::to_string(pLeanMaps->mpLeanMapsBySource.size()) + " LEAN maps for " + std::to_string(pLeanMaps->mpLeanMaps.size()) + " materials in " + std::to_string(time) + " ms");
+        }
 
         return pLeanMaps;
     }
@@ -28,6 +28,7 @@
 #pragma once
 #include <map>
 #include <memory>
+#include <string>
 #include "Core/Texture.h"
 
 namespace Falcor
@@ -38,13 +39,29 @@ namespace Falcor
     class UniformBuffer;
     class Sampler;
 
+    /** LEAN maps for the normal maps of a scene.
+        A LEAN map stores the first and second moments of the normal map slopes as RGBA16F. Materials which use the same normal map share a single LEAN map.
+        The conversion is multi-threaded and uses SSE2. Generated maps can be cached on disk, see setCacheDirectory().
+    */
     class LeanMap
     {
     public:
         using UniquePtr = std::unique_ptr<LeanMap>;
+
+        /** Create LEAN maps for all the materials of a scene
+        */
         static UniquePtr create(const Falcor::Scene* pScene);
+
+        /** Create a LEAN map from a normal map. Supports 8-bit RGBA/BGRA normal maps, and 2-channel RG8 and BC5 maps, for which Z is reconstructed.
+            \return A new RGBA16F texture with a full mip-chain, or nullptr if the normal map format isn't supported
+        */
         static Falcor::Texture::SharedPtr createFromNormalMap(const Falcor::Texture* pNormalMap);
 
+        /** Set the directory used to cache LEAN maps. The cache is keyed by a hash of the normal map's data, so it never returns stale results.
+            \param[in] dir The cache directory. An empty string disables the cache, which is the default.
+        */
+        static void setCacheDirectory(const std::string& dir) { sCacheDirectory = dir; }
+
         Falcor::Texture* getLeanMap(uint32_t sceneMaterialID) { return mpLeanMaps[sceneMaterialID].get(); }
         void setIntoUniformBuffer(Falcor::UniformBuffer* pUB, size_t offset, Falcor::Sampler* pSampler = nullptr) const;
         void setIntoUniformBuffer(Falcor::UniformBuffer* pUB, const std::string& varName, Falcor::Sampler* pSampler = nullptr) const;
@@ -53,6 +70,8 @@ namespace Falcor
         LeanMap() = default;
         bool createLeanMap(const Falcor::Material* pMaterial);
         std::map<uint32_t, Falcor::Texture::SharedPtr> mpLeanMaps;
+        std::map<const Falcor::Texture*, Falcor::Texture::SharedPtr> mpLeanMapsBySource;
         uint32_t mShaderArraySize = 0;
+        static std::string sCacheDirectory;
     };
 }
\ No newline at end of file
@@ -75,6 +75,10 @@ namespace Falcor
         */
         void setOperator(Operator op);
 
+        /** Get the operator
+        */
+        Operator getOperator() const { return mOperator; }
+
         /** Sets the middle-gray luminance used for normalizing each pixel's luminance. 
             Middle gray is usually in the range of[0.045, 0.72].
             Lower values maximize contrast. Useful for night scenes.
@@ -82,20 +86,36 @@ namespace Falcor
         */
         void setMiddleGray(float middleGray);
 
+        /** Get the middle-gray luminance
+        */
+        float getMiddleGray() const { return mMiddleGray; }
+
         /** Sets the maximal luminance to be consider as pure white.
             Only valid if the operator is ReinhardModified
         */
         void setWhiteMaxLuminance(float maxLuminance);
 
+        /** Get the maximal white luminance
+        */
+        float getWhiteMaxLuminance() const { return mWhiteMaxLuminance; }
+
         /** Sets the luminance texture LOD to use when fetching average luminance values.
             Lower values will result in a more localized effect
         */
         void setLuminanceLod(float lod);
 
+        /** Get the luminance texture LOD
+        */
+        float getLuminanceLod() const { return mLuminanceLod; }
+
         /** Sets the white-scale used in Uncharted 2 tone mapping.
         */
         void setWhiteScale(float whiteScale);
 
+        /** Get the Uncharted 2 white-scale
+        */
+        float getWhiteScale() const { return mWhiteScale; }
+
     private:
         ToneMapping(Operator op);
         void createLuminanceFbo(Fbo::SharedPtr pSrcFbo);
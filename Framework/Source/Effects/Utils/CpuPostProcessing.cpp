@@ -0,0 +1,688 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuPostProcessing.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "Utils/ImageProcessing.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Math/SseMath.h"
+
+namespace Falcor
+{
+    /************************************************************************/
+    /* Tone mapping                                                         */
+    /************************************************************************/
+    struct LuminanceLevel
+    {
+        const float* pData;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static float calcLuminance(const glm::vec3& color)
+    {
+        return glm::dot(color, glm::vec3(0.299f, 0.587f, 0.114f));
+    }
+
+    static uint32_t wrapCoord(int32_t coord, uint32_t size)
+    {
+        int32_t wrapped = coord % (int32_t)size;
+        return (wrapped < 0) ? wrapped + size : wrapped;
+    }
+
+    static float sampleLevel(const LuminanceLevel& level, float u, float v)
+    {
+        float x = u * level.width - 0.5f;
+        float y = v * level.height - 0.5f;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        float fx = x - x0;
+        float fy = y - y0;
+        uint32_t ix0 = wrapCoord((int32_t)x0, level.width);
+        uint32_t ix1 = wrapCoord((int32_t)x0 + 1, level.width);
+        const float* pRow0 = level.pData + (size_t)wrapCoord((int32_t)y0, level.height) * level.width;
+        const float* pRow1 = level.pData + (size_t)wrapCoord((int32_t)y0 + 1, level.height) * level.width;
+        float bottom = pRow0[ix0] * (1 - fx) + pRow0[ix1] * fx;
+        float top = pRow1[ix0] * (1 - fx) + pRow1[ix1] * fx;
+        return bottom * (1 - fy) + top * fy;
+    }
+
+    /** Trilinear sample with wrap addressing, the sampler ToneMapping uses for the luminance texture
+    */
+    static float sampleLuminance(const std::vector<LuminanceLevel>& levels, float lod, float u, float v)
+    {
+        lod = glm::clamp(lod, 0.0f, (float)(levels.size() - 1));
+        uint32_t level = (uint32_t)lod;
+        float f = lod - level;
+        float value = sampleLevel(levels[level], u, v);
+        if(f > 0)
+        {
+            value = value * (1 - f) + sampleLevel(levels[level + 1], u, v) * f;
+        }
+        return value;
+    }
+
+    /** Build the box-filtered mip-chain of the log-luminance. Returns the storage, and the levels pointing into it.
+    */
+    static std::vector<uint8_t> createLuminanceMips(const std::vector<float>& logLuminance, uint32_t width, uint32_t height, std::vector<LuminanceLevel>& levels)
+    {
+        uint32_t mipCount;
+        std::vector<uint8_t> chain = ImageProcessing::generateMipChain(logLuminance.data(), width, height, ResourceFormat::R32Float, ImageProcessing::MipFilter::Box, mipCount);
+        levels.resize(mipCount);
+        const float* pData = (const float*)chain.data();
+        for(uint32_t mip = 0; mip < mipCount; mip++)
+        {
+            LuminanceLevel level = {pData, width, height};
+            levels[mip] = level;
+            pData += (size_t)width * height;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        return chain;
+    }
+
+    static glm::vec3 uc2Operator(const glm::vec3& color)
+    {
+        const float A = 0.15f;
+        const float B = 0.50f;
+        const float C = 0.10f;
+        const float D = 0.20f;
+        const float E = 0.01f;
+        const float F = 0.30f;
+        return ((color * (A * color + C * B) + D * E) / (color * (A * color + B) + D * F)) - (E / F);
+    }
+
+    /** Per-pixel tone-mapping, following ToneMapping.fs
+    */
+    static glm::vec4 toneMapPixel(const glm::vec4& color, float avgLogLuminance, const CpuPostProcessing::ToneMappingParams& params)
+    {
+        glm::vec3 exposed = glm::vec3(color) * (params.middleGray / std::exp(avgLogLuminance));
+        switch(params.op)
+        {
+        case ToneMapping::Operator::Clamp:
+            return glm::clamp(color, 0.0f, 1.0f);
+        case ToneMapping::Operator::Linear:
+            return glm::vec4(exposed, color.a);
+        case ToneMapping::Operator::Reinhard:
+        {
+            float luminance = calcLuminance(exposed);
+            float reinhard = luminance / (luminance + 1);
+            return glm::vec4(exposed * (reinhard / luminance), color.a);
+        }
+        case ToneMapping::Operator::ReinhardModified:
+        {
+            float luminance = calcLuminance(exposed);
+            float reinhard = luminance * (1 + luminance / (params.whiteMaxLuminance * params.whiteMaxLuminance)) * (1 + luminance);
+            return glm::vec4(exposed * (reinhard / luminance), color.a);
+        }
+        case ToneMapping::Operator::HejiHableAlu:
+        {
+            glm::vec3 c = glm::max(glm::vec3(0.0f), exposed - 0.004f);
+            c = (c * (6.2f * c + 0.5f)) / (c * (6.2f * c + 1.7f) + 0.06f);
+            return glm::vec4(glm::pow(c, glm::vec3(2.2f)), color.a);
+        }
+        case ToneMapping::Operator::HableUc2:
+        {
+            glm::vec3 whiteScale = 1.0f / uc2Operator(glm::vec3(params.whiteScale));
+            return glm::vec4(uc2Operator(2.0f * exposed) * whiteScale, color.a);
+        }
+        default:
+            should_not_get_here();
+            return color;
+        }
+    }
+
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+    static __m128 calcLuminance4(__m128 r, __m128 g, __m128 b)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(0.299f)), _mm_mul_ps(g, _mm_set1_ps(0.587f))), _mm_mul_ps(b, _mm_set1_ps(0.114f)));
+    }
+
+    static __m128 uc2Operator4(__m128 c)
+    {
+        __m128 ac = _mm_mul_ps(_mm_set1_ps(0.15f), c);
+        __m128 numerator = _mm_add_ps(_mm_mul_ps(c, _mm_add_ps(ac, _mm_set1_ps(0.10f * 0.50f))), _mm_set1_ps(0.20f * 0.01f));
+        __m128 denominator = _mm_add_ps(_mm_mul_ps(c, _mm_add_ps(ac, _mm_set1_ps(0.50f))), _mm_set1_ps(0.20f * 0.30f));
+        return _mm_sub_ps(_mm_div_ps(numerator, denominator), _mm_set1_ps(0.01f / 0.30f));
+    }
+
+    static __m128 hejiHableAlu4(__m128 c)
+    {
+        c = _mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(c, _mm_set1_ps(0.004f)));
+        __m128 c62 = _mm_mul_ps(_mm_set1_ps(6.2f), c);
+        c = _mm_div_ps(_mm_mul_ps(c, _mm_add_ps(c62, _mm_set1_ps(0.5f))), _mm_add_ps(_mm_mul_ps(c, _mm_add_ps(c62, _mm_set1_ps(1.7f))), _mm_set1_ps(0.06f)));
+        return pow4(c, _mm_set1_ps(2.2f));
+    }
+
+    /** Tone-map 4 pixels, transposed to one register per channel
+    */
+    static void toneMap4(__m128& r, __m128& g, __m128& b, __m128& a, __m128 avgLogLuminance, const CpuPostProcessing::ToneMappingParams& params)
+    {
+        if(params.op == ToneMapping::Operator::Clamp)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            r = _mm_min_ps(_mm_max_ps(r, zero), one);
+            g = _mm_min_ps(_mm_max_ps(g, zero), one);
+            b = _mm_min_ps(_mm_max_ps(b, zero), one);
+            a = _mm_min_ps(_mm_max_ps(a, zero), one);
+            return;
+        }
+
+        __m128 exposure = _mm_div_ps(_mm_set1_ps(params.middleGray), exp4(avgLogLuminance));
+        r = _mm_mul_ps(r, exposure);
+        g = _mm_mul_ps(g, exposure);
+        b = _mm_mul_ps(b, exposure);
+
+        switch(params.op)
+        {
+        case ToneMapping::Operator::Linear:
+            break;
+        case ToneMapping::Operator::Reinhard:
+        case ToneMapping::Operator::ReinhardModified:
+        {
+            __m128 luminance = calcLuminance4(r, g, b);
+            __m128 reinhard;
+            if(params.op == ToneMapping::Operator::Reinhard)
+            {
+                reinhard = _mm_div_ps(luminance, _mm_add_ps(luminance, _mm_set1_ps(1.0f)));
+            }
+            else
+            {
+                __m128 whiteSquared = _mm_set1_ps(params.whiteMaxLuminance * params.whiteMaxLuminance);
+                reinhard = _mm_add_ps(_mm_set1_ps(1.0f), _mm_div_ps(luminance, whiteSquared));
+                reinhard = _mm_mul_ps(_mm_mul_ps(luminance, reinhard), _mm_add_ps(_mm_set1_ps(1.0f), luminance));
+            }
+            __m128 scale = _mm_div_ps(reinhard, luminance);
+            r = _mm_mul_ps(r, scale);
+            g = _mm_mul_ps(g, scale);
+            b = _mm_mul_ps(b, scale);
+            break;
+        }
+        case ToneMapping::Operator::HejiHableAlu:
+            r = hejiHableAlu4(r);
+            g = hejiHableAlu4(g);
+            b = hejiHableAlu4(b);
+            break;
+        case ToneMapping::Operator::HableUc2:
+        {
+            const __m128 bias = _mm_set1_ps(2.0f);
+            __m128 whiteScale = _mm_div_ps(_mm_set1_ps(1.0f), uc2Operator4(_mm_set1_ps(params.whiteScale)));
+            r = _mm_mul_ps(uc2Operator4(_mm_mul_ps(bias, r)), whiteScale);
+            g = _mm_mul_ps(uc2Operator4(_mm_mul_ps(bias, g)), whiteScale);
+            b = _mm_mul_ps(uc2Operator4(_mm_mul_ps(bias, b)), whiteScale);
+            break;
+        }
+        default:
+            should_not_get_here();
+        }
+    }
+#endif
+
+    static void calcLogLuminanceRows(const float* pSrc, uint32_t width, uint32_t begin, uint32_t end, float* pDst)
+    {
+        for(uint32_t y = begin; y < end; y++)
+        {
+            const float* pSrcRow = pSrc + (size_t)y * width * 4;
+            float* pDstRow = pDst + (size_t)y * width;
+            uint32_t x = 0;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+            for(; x + 4 <= width; x += 4)
+            {
+                __m128 r = _mm_loadu_ps(pSrcRow + x * 4);
+                __m128 g = _mm_loadu_ps(pSrcRow + x * 4 + 4);
+                __m128 b = _mm_loadu_ps(pSrcRow + x * 4 + 8);
+                __m128 a = _mm_loadu_ps(pSrcRow + x * 4 + 12);
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+                __m128 luminance = _mm_max_ps(_mm_set1_ps(0.0001f), calcLuminance4(r, g, b));
+                _mm_storeu_ps(pDstRow + x, log4(luminance));
+            }
+#endif
+            for(; x < width; x++)
+            {
+                pDstRow[x] = std::log(std::max(0.0001f, calcLuminance(glm::vec3(pSrcRow[x * 4], pSrcRow[x * 4 + 1], pSrcRow[x * 4 + 2]))));
+            }
+        }
+    }
+
+    static void toneMapRows(const float* pSrc, uint32_t width, uint32_t height, const CpuPostProcessing::ToneMappingParams& params, const std::vector<LuminanceLevel>& levels, uint32_t begin, uint32_t end, float* pDst)
+    {
+        // At the LOD of the 1x1 level, which is the common case, all the pixels use the same average
+        std::vector<float> avgLogLuminance(width, 0.0f);
+        bool isAverageConstant = levels.empty() || (params.luminanceLod >= (float)(levels.size() - 1));
+        if(isAverageConstant && (levels.empty() == false))
+        {
+            std::fill(avgLogLuminance.begin(), avgLogLuminance.end(), levels.back().pData[0]);
+        }
+
+        for(uint32_t y = begin; y < end; y++)
+        {
+            if(isAverageConstant == false)
+            {
+                float v = (y + 0.5f) / height;
+                for(uint32_t x = 0; x < width; x++)
+                {
+                    avgLogLuminance[x] = sampleLuminance(levels, params.luminanceLod, (x + 0.5f) / width, v);
+                }
+            }
+
+            const float* pSrcRow = pSrc + (size_t)y * width * 4;
+            float* pDstRow = pDst + (size_t)y * width * 4;
+            uint32_t x = 0;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+            for(; x + 4 <= width; x += 4)
+            {
+                __m128 r = _mm_loadu_ps(pSrcRow + x * 4);
+                __m128 g = _mm_loadu_ps(pSrcRow + x * 4 + 4);
+                __m128 b = _mm_loadu_ps(pSrcRow + x * 4 + 8);
+                __m128 a = _mm_loadu_ps(pSrcRow + x * 4 + 12);
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+                toneMap4(r, g, b, a, _mm_loadu_ps(avgLogLuminance.data() + x), params);
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+                _mm_storeu_ps(pDstRow + x * 4, r);
+                _mm_storeu_ps(pDstRow + x * 4 + 4, g);
+                _mm_storeu_ps(pDstRow + x * 4 + 8, b);
+                _mm_storeu_ps(pDstRow + x * 4 + 12, a);
+            }
+#endif
+            for(; x < width; x++)
+            {
+                const float* pColor = pSrcRow + x * 4;
+                glm::vec4 result = toneMapPixel(glm::vec4(pColor[0], pColor[1], pColor[2], pColor[3]), avgLogLuminance[x], params);
+                memcpy(pDstRow + x * 4, &result, sizeof(result));
+            }
+        }
+    }
+
+    CpuPostProcessing::ToneMappingParams CpuPostProcessing::getToneMappingParams(const ToneMapping& toneMapping)
+    {
+        ToneMappingParams params;
+        params.op = toneMapping.getOperator();
+        params.middleGray = toneMapping.getMiddleGray();
+        params.whiteMaxLuminance = toneMapping.getWhiteMaxLuminance();
+        params.luminanceLod = toneMapping.getLuminanceLod();
+        params.whiteScale = toneMapping.getWhiteScale();
+        return params;
+    }
+
+    void CpuPostProcessing::toneMap(const float* pSrc, uint32_t width, uint32_t height, const ToneMappingParams& params, float* pDst)
+    {
+        if(width == 0 || height == 0)
+        {
+            return;
+        }
+
+        const uint32_t grainSize = std::max(1u, 16384 / width);
+        std::vector<uint8_t> luminanceChain;
+        std::vector<LuminanceLevel> levels;
+        if(params.op != ToneMapping::Operator::Clamp)
+        {
+            std::vector<float> logLuminance((size_t)width * height);
+            parallelFor(height, grainSize, [&](uint32_t begin, uint32_t end)
+            {
+                calcLogLuminanceRows(pSrc, width, begin, end, logLuminance.data());
+            });
+            luminanceChain = createLuminanceMips(logLuminance, width, height, levels);
+        }
+
+        parallelFor(height, grainSize, [&](uint32_t begin, uint32_t end)
+        {
+            toneMapRows(pSrc, width, height, params, levels, begin, end, pDst);
+        });
+    }
+
+    /************************************************************************/
+    /* Gaussian blur                                                        */
+    /************************************************************************/
+    static const float kBlurWeights1[] = {1};
+    static const float kBlurWeights3[] = {0.27901f, 0.44198f, 0.27901f};
+    static const float kBlurWeights5[] = {0.06136f, 0.24477f, 0.38774f, 0.24477f, 0.06136f};
+    static const float kBlurWeights7[] = {0.00598f, 0.060626f, 0.241843f, 0.383103f, 0.241843f, 0.060626f, 0.00598f};
+    static const float kBlurWeights9[] = {0.000229f, 0.005977f, 0.060598f, 0.241732f, 0.382928f, 0.241732f, 0.060598f, 0.005977f, 0.000229f};
+    static const float kBlurWeights11[] = {0.000003f, 0.000229f, 0.005977f, 0.060598f, 0.24173f, 0.382925f, 0.24173f, 0.060598f, 0.005977f, 0.000229f, 0.000003f};
+
+    /** Get the weights GaussianBlur.fs uses for a kernel size. Returns nullptr for unsupported sizes.
+    */
+    static const float* getBlurWeights(uint32_t kernelSize)
+    {
+        switch(kernelSize)
+        {
+        case 1:
+            return kBlurWeights1;
+        case 3:
+            return kBlurWeights3;
+        case 5:
+            return kBlurWeights5;
+        case 7:
+            return kBlurWeights7;
+        case 9:
+            return kBlurWeights9;
+        case 11:
+            return kBlurWeights11;
+        default:
+            return nullptr;
+        }
+    }
+
+    static const uint32_t kBlurBandHeight = 32;
+
+    /** Blur a row horizontally. pPadded is scratch space for width + kernelSize - 1 pixels.
+    */
+    static void blurRow(const float* pSrcRow, uint32_t width, const float* pWeights, uint32_t kernelSize, float* pPadded, float* pDst)
+    {
+        // Pad the row with copies of the edge pixels, so the filter loop doesn't need to clamp
+        const uint32_t radius = kernelSize / 2;
+        for(uint32_t i = 0; i < radius; i++)
+        {
+            memcpy(pPadded + i * 4, pSrcRow, sizeof(float) * 4);
+            memcpy(pPadded + (radius + width + i) * 4, pSrcRow + (width - 1) * 4, sizeof(float) * 4);
+        }
+        memcpy(pPadded + radius * 4, pSrcRow, sizeof(float) * 4 * width);
+
+        for(uint32_t x = 0; x < width; x++)
+        {
+            const float* pTaps = pPadded + x * 4;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+            __m128 sum = _mm_setzero_ps();
+            for(uint32_t i = 0; i < kernelSize; i++)
+            {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pTaps + i * 4), _mm_set1_ps(pWeights[i])));
+            }
+            _mm_storeu_ps(pDst + x * 4, sum);
+#else
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                float sum = 0;
+                for(uint32_t i = 0; i < kernelSize; i++)
+                {
+                    sum += pTaps[i * 4 + c] * pWeights[i];
+                }
+                pDst[x * 4 + c] = sum;
+            }
+#endif
+        }
+    }
+
+    /** Blur a band of rows. The band is blurred horizontally, together with the rows the vertical pass reads above and below it, into pTmp.
+    */
+    static void blurBand(const float* pSrc, uint32_t width, uint32_t height, const float* pWeights, uint32_t kernelSize, uint32_t begin, uint32_t end, std::vector<float>& tmp, std::vector<float>& padded, float* pDst)
+    {
+        const uint32_t radius = kernelSize / 2;
+        const size_t rowSize = (size_t)width * 4;
+        const uint32_t firstRow = (begin > radius) ? begin - radius : 0;
+        const uint32_t lastRow = std::min(end + radius, height);
+
+        tmp.resize((lastRow - firstRow) * rowSize);
+        padded.resize((width + kernelSize - 1) * 4);
+        for(uint32_t y = firstRow; y < lastRow; y++)
+        {
+            blurRow(pSrc + y * rowSize, width, pWeights, kernelSize, padded.data(), tmp.data() + (y - firstRow) * rowSize);
+        }
+
+        const float* pRows[11];
+        for(uint32_t y = begin; y < end; y++)
+        {
+            for(uint32_t i = 0; i < kernelSize; i++)
+            {
+                int32_t row = glm::clamp((int32_t)y - (int32_t)radius + (int32_t)i, 0, (int32_t)height - 1);
+                pRows[i] = tmp.data() + (row - firstRow) * rowSize;
+            }
+
+            float* pDstRow = pDst + y * rowSize;
+            size_t i = 0;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+            for(; i < rowSize; i += 4)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for(uint32_t k = 0; k < kernelSize; k++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pRows[k] + i), _mm_set1_ps(pWeights[k])));
+                }
+                _mm_storeu_ps(pDstRow + i, sum);
+            }
+#endif
+            for(; i < rowSize; i++)
+            {
+                float sum = 0;
+                for(uint32_t k = 0; k < kernelSize; k++)
+                {
+                    sum += pRows[k][i] * pWeights[k];
+                }
+                pDstRow[i] = sum;
+            }
+        }
+    }
+
+    bool CpuPostProcessing::gaussianBlur(const float* pSrc, uint32_t width, uint32_t height, uint32_t kernelSize, float* pDst)
+    {
+        const float* pWeights = getBlurWeights(kernelSize);
+        if(pWeights == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "CpuPostProcessing::gaussianBlur() - unsupported kernel size " + std::to_string(kernelSize) + ". Kernel size must be an odd number in the range [1, 11].");
+            return false;
+        }
+        if(width == 0 || height == 0)
+        {
+            return true;
+        }
+
+        const uint32_t bandCount = (height + kBlurBandHeight - 1) / kBlurBandHeight;
+        parallelFor(bandCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            std::vector<float> tmp;
+            std::vector<float> padded;
+            for(uint32_t band = begin; band < end; band++)
+            {
+                uint32_t firstRow = band * kBlurBandHeight;
+                blurBand(pSrc, width, height, pWeights, kernelSize, firstRow, std::min(firstRow + kBlurBandHeight, height), tmp, padded, pDst);
+            }
+        });
+        return true;
+    }
+
+    /************************************************************************/
+    /* Min/max reduction                                                    */
+    /************************************************************************/
+    static const uint32_t kReductionBandHeight = 16;
+
+    static glm::vec2 reduceMinMaxRange(const float* pDepth, size_t count)
+    {
+        // Same initial range as ParallelReduction.fs. The minimum starts at 1, the maximum at 0.
+        glm::vec2 range(1, 0);
+        size_t i = 0;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 minimum = one;
+        __m128 maximum = _mm_setzero_ps();
+        for(; i + 4 <= count; i += 4)
+        {
+            __m128 depth = _mm_loadu_ps(pDepth + i);
+            __m128 valid = _mm_cmpneq_ps(depth, one);
+            minimum = _mm_min_ps(minimum, _mm_or_ps(_mm_and_ps(valid, depth), _mm_andnot_ps(valid, one)));
+            maximum = _mm_max_ps(maximum, _mm_and_ps(valid, depth));
+        }
+        float minimums[4];
+        float maximums[4];
+        _mm_storeu_ps(minimums, minimum);
+        _mm_storeu_ps(maximums, maximum);
+        for(uint32_t j = 0; j < 4; j++)
+        {
+            range.x = std::min(range.x, minimums[j]);
+            range.y = std::max(range.y, maximums[j]);
+        }
+#endif
+        for(; i < count; i++)
+        {
+            if(pDepth[i] != 1.0f)
+            {
+                range.x = std::min(range.x, pDepth[i]);
+                range.y = std::max(range.y, pDepth[i]);
+            }
+        }
+        return range;
+    }
+
+    glm::vec2 CpuPostProcessing::reduceMinMax(const float* pDepth, uint32_t width, uint32_t height)
+    {
+        const uint32_t bandCount = (height + kReductionBandHeight - 1) / kReductionBandHeight;
+        std::vector<glm::vec2> bandRanges(bandCount);
+        parallelFor(bandCount, 4, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t band = begin; band < end; band++)
+            {
+                uint32_t firstRow = band * kReductionBandHeight;
+                uint32_t rowCount = std::min(kReductionBandHeight, height - firstRow);
+                bandRanges[band] = reduceMinMaxRange(pDepth + (size_t)firstRow * width, (size_t)rowCount * width);
+            }
+        });
+
+        glm::vec2 range(1, 0);
+        for(const auto& bandRange : bandRanges)
+        {
+            range.x = std::min(range.x, bandRange.x);
+            range.y = std::max(range.y, bandRange.y);
+        }
+        return range;
+    }
+
+    /************************************************************************/
+    /* Sky box                                                              */
+    /************************************************************************/
+
+    /** Select the cube-map face and the face coordinates for a direction, following the OpenGL specification
+    */
+    static uint32_t getCubeFaceCoords(const glm::vec3& dir, float& s, float& t)
+    {
+        glm::vec3 absDir = glm::abs(dir);
+        uint32_t face;
+        float ma, sc, tc;
+        if(absDir.x >= absDir.y && absDir.x >= absDir.z)
+        {
+            face = (dir.x >= 0) ? 0 : 1;
+            ma = absDir.x;
+            sc = (dir.x >= 0) ? -dir.z : dir.z;
+            tc = -dir.y;
+        }
+        else if(absDir.y >= absDir.z)
+        {
+            face = (dir.y >= 0) ? 2 : 3;
+            ma = absDir.y;
+            sc = dir.x;
+            tc = (dir.y >= 0) ? dir.z : -dir.z;
+        }
+        else
+        {
+            face = (dir.z >= 0) ? 4 : 5;
+            ma = absDir.z;
+            sc = (dir.z >= 0) ? dir.x : -dir.x;
+            tc = -dir.y;
+        }
+        s = 0.5f * (sc / ma + 1);
+        t = 0.5f * (tc / ma + 1);
+        return face;
+    }
+
+    /** Bilinear sample with clamp addressing. Seams between the faces aren't filtered.
+    */
+    static void sampleCubeFace(const float* pFace, uint32_t size, float s, float t, float* pResult)
+    {
+        float x = s * size - 0.5f;
+        float y = t * size - 0.5f;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        float fx = x - x0;
+        float fy = y - y0;
+        int32_t maxCoord = (int32_t)size - 1;
+        size_t ix0 = glm::clamp((int32_t)x0, 0, maxCoord) * 4;
+        size_t ix1 = glm::clamp((int32_t)x0 + 1, 0, maxCoord) * 4;
+        const float* pRow0 = pFace + (size_t)glm::clamp((int32_t)y0, 0, maxCoord) * size * 4;
+        const float* pRow1 = pFace + (size_t)glm::clamp((int32_t)y0 + 1, 0, maxCoord) * size * 4;
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+        __m128 wx0 = _mm_set1_ps(1 - fx);
+        __m128 wx1 = _mm_set1_ps(fx);
+        __m128 bottom = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pRow0 + ix0), wx0), _mm_mul_ps(_mm_loadu_ps(pRow0 + ix1), wx1));
+        __m128 top = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pRow1 + ix0), wx0), _mm_mul_ps(_mm_loadu_ps(pRow1 + ix1), wx1));
+        _mm_storeu_ps(pResult, _mm_add_ps(_mm_mul_ps(bottom, _mm_set1_ps(1 - fy)), _mm_mul_ps(top, _mm_set1_ps(fy))));
+#else
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            float bottom = pRow0[ix0 + c] * (1 - fx) + pRow0[ix1 + c] * fx;
+            float top = pRow1[ix0 + c] * (1 - fx) + pRow1[ix1 + c] * fx;
+            pResult[c] = bottom * (1 - fy) + top * fy;
+        }
+#endif
+    }
+
+    static float getPixelNdc(uint32_t coord, uint32_t size, bool flip)
+    {
+        float ndc = (coord + 0.5f) / size * 2 - 1;
+        return flip ? -ndc : ndc;
+    }
+
+    void CpuPostProcessing::renderSkyBox(const CubeMap& cubeMap, const glm::mat4& viewMat, const glm::mat4& projMat, float scale, const float* pDepth, uint32_t width, uint32_t height, bool isTopDown, float* pDst)
+    {
+        if(width == 0 || height == 0)
+        {
+            return;
+        }
+
+        // SkyBox.vs centers the cube on the camera, so only the rotation of the view matrix matters. The clip-space position before the scale is the NDC divided by the scale.
+        // Unprojecting is linear in the pixel coordinates, so each pixel only needs two additions and the perspective division.
+        glm::mat4 invProj = glm::inverse(projMat);
+        glm::mat3 invView = glm::inverse(glm::mat3(viewMat));
+        glm::vec4 origin = invProj * glm::vec4(-1 / scale, -1 / scale, 0, 1);
+        glm::vec4 stepX = invProj * glm::vec4(2 / (scale * width), 0, 0, 0);
+        glm::vec4 stepY = invProj * glm::vec4(0, 2 / (scale * height), 0, 0);
+
+        parallelFor(height, std::max(1u, 4096 / width), [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t y = begin; y < end; y++)
+            {
+                uint32_t ndcRow = isTopDown ? height - 1 - y : y;
+                glm::vec4 rowPos = origin + stepY * (ndcRow + 0.5f) + stepX * 0.5f;
+                const float* pDepthRow = pDepth ? pDepth + (size_t)y * width : nullptr;
+                float* pDstRow = pDst + (size_t)y * width * 4;
+                for(uint32_t x = 0; x < width; x++)
+                {
+                    // The depth-test is LessEqual, and the sky is drawn at the far plane
+                    if(pDepthRow && pDepthRow[x] < 1.0f)
+                    {
+                        continue;
+                    }
+                    glm::vec4 viewPos = rowPos + stepX * (float)x;
+                    glm::vec3 dir = invView * (glm::vec3(viewPos) / viewPos.w);
+                    float s, t;
+                    uint32_t face = getCubeFaceCoords(dir, s, t);
+                    sampleCubeFace(cubeMap.pFaces[face], cubeMap.size, s, t, pDstRow + x * 4);
+                }
+            }
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Framework.h"
+#include "Effects/ToneMapping/ToneMapping.h"
+
+namespace Falcor
+{
+    /** CPU implementations of the post-processing passes, for headless image tests and offline processing of rendered frames.
+        The functions take the same parameters as the GPU passes and work on tightly packed RGBA32F images, the layout Bitmap uses for float images.
+        The images are split into row bands which are processed with parallelFor(), and the inner loops use SSE2 where it is available.
+        Row 0 is the bottom row, as in a texture, unless a function takes an isTopDown flag.
+    */
+    class CpuPostProcessing
+    {
+    public:
+        /** ToneMapping parameters. Apart from the operator, the defaults match a newly created ToneMapping object.
+        */
+        struct ToneMappingParams
+        {
+            ToneMapping::Operator op = ToneMapping::Operator::HableUc2;
+            float middleGray = 0.18f;
+            float whiteMaxLuminance = 1.0f;
+            float luminanceLod = 16.0f;
+            float whiteScale = 11.2f;
+        };
+
+        /** Get the parameters of a ToneMapping object
+        */
+        static ToneMappingParams getToneMappingParams(const ToneMapping& toneMapping);
+
+        /** Tone-map an image, like ToneMapping::execute(). The average luminance is read from a box-filtered mip-chain of the log-luminance, with trilinear filtering and wrap addressing.
+            ToneMapping::Operator::Clamp saturates all the channels, which is what a unorm render-target does to the output of the GPU pass.
+            \param[in] pSrc The source image
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] params The tone-mapping parameters
+            \param[out] pDst The destination image. Can be the same as pSrc.
+        */
+        static void toneMap(const float* pSrc, uint32_t width, uint32_t height, const ToneMappingParams& params, float* pDst);
+
+        /** Blur an image, like GaussianBlur::execute(). Samples outside the image are clamped to the edge.
+            \param[in] pSrc The source image
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] kernelSize The kernel size. Must be an odd number in the range [1, 11].
+            \param[out] pDst The destination image. Must not overlap pSrc.
+            \return false if the kernel size isn't supported
+        */
+        static bool gaussianBlur(const float* pSrc, uint32_t width, uint32_t height, uint32_t kernelSize, float* pDst);
+
+        /** Find the range of a depth-buffer, like ParallelReduction with Type::MinMax. Depth values of 1 are ignored.
+            \param[in] pDepth The depth values, one float per pixel
+            \param[in] width The width of the depth-buffer
+            \param[in] height The height of the depth-buffer
+            \return The minimum in x and the maximum in y. (1, 0) if all the values are 1.
+        */
+        static glm::vec2 reduceMinMax(const float* pDepth, uint32_t width, uint32_t height);
+
+        /** A cube-map in RGBA32F. The faces are in the order +X, -X, +Y, -Y, +Z, -Z, with their rows in the order they are uploaded to the texture.
+        */
+        struct CubeMap
+        {
+            uint32_t size = 0;      ///< The width and height of each face
+            const float* pFaces[6];
+        };
+
+        /** Draw the sky, like SkyBox::render(). Only the most detailed level of the cube-map is used, with bilinear filtering.
+            \param[in] cubeMap The sky texture
+            \param[in] viewMat The camera's view matrix
+            \param[in] projMat The camera's projection matrix
+            \param[in] scale The scale, see SkyBox::setScale()
+            \param[in] pDepth Optional depth-buffer. If it isn't nullptr, only pixels with a depth of 1 are written, like the depth-test of the GPU pass.
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] isTopDown Whether row 0 of the image and the depth-buffer is the top row
+            \param[in, out] pDst The image
+        */
+        static void renderSkyBox(const CubeMap& cubeMap, const glm::mat4& viewMat, const glm::mat4& projMat, float scale, const float* pDepth, uint32_t width, uint32_t height, bool isTopDown, float* pDst);
+    };
+}
\ No newline at end of file
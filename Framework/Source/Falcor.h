@@ -54,6 +54,7 @@
 #include "Core/UniformBuffer.h"
 #include "Core/VertexLayout.h"
 #include "Core/ShaderStorageBuffer.h"
+#include "Core/CommandList.h"
 #include "Core/Window.h"
 
 #include "Graphics/Camera/Camera.h"
@@ -63,6 +64,8 @@
 #include "Graphics/FullScreenPass.h"
 #include "Graphics/TextureHelper.h"
 #include "Graphics/Light.h"
+#include "Graphics/AreaLightSampler.h"
+#include "Graphics/LightClusters.h"
 #include "Graphics/Program.h"
 #include "Graphics/Program.h"
 #include "Graphics/FboHelper.h"
@@ -89,6 +92,7 @@
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/ParallelReduction.h"
+#include "Utils/Math/AliasTable.h"
 
 // Utils
 #include "Utils/Bitmap.h"
@@ -101,7 +105,10 @@
 #include "Utils/CpuTimer.h"
 #include "Utils/UserInput.h"
 #include "Utils/Profiler.h"
+#include "Utils/Benchmark.h"
+#include "Utils/ParallelFor.h"
 #include "Utils/StringUtils.h"
+#include "Utils/Random.h"
 #include "Utils/BinaryFileStream.h"
 #include "Utils/Video/VideoEncoder.h"
 #include "Utils/Video/VideoEncoderUI.h"
@@ -0,0 +1,160 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AreaLightSampler.h"
+#include "Graphics/Model/Mesh.h"
+#include "Data/VertexAttrib.h"
+#include "glm/vec2.hpp"
+#include "glm/geometric.hpp"
+#include <cmath>
+
+namespace Falcor
+{
+    AreaLightSampler::SharedPtr AreaLightSampler::create(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount)
+    {
+        SharedPtr pSampler = SharedPtr(new AreaLightSampler);
+        if(pSampler->init(pPositions, vertexCount, pIndices, indexCount) == false)
+        {
+            return nullptr;
+        }
+        pSampler->createBuffers(nullptr);
+        return pSampler;
+    }
+
+    AreaLightSampler::SharedPtr AreaLightSampler::create(const Mesh* pMesh)
+    {
+        assert(pMesh);
+        const auto& pVao = pMesh->getVao();
+        std::vector<glm::vec3> positions = pMesh->readVertexAttribute(VERTEX_POSITION_LOC);
+        if(positions.empty() || pVao->getIndexBuffer() == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "AreaLightSampler::create() - the mesh must have positions and an index buffer");
+            return nullptr;
+        }
+
+        std::vector<uint32_t> indices = pMesh->readIndices();
+
+        // The shaders expect 32-bit indices. Share the mesh's buffer if it already has them.
+        Buffer::SharedConstPtr pIndexBuffer;
+        if(pMesh->getIndexFormat() == ResourceFormat::R32Uint)
+        {
+            pIndexBuffer = pVao->getIndexBuffer();
+        }
+
+        SharedPtr pSampler = SharedPtr(new AreaLightSampler);
+        if(pSampler->init(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size()) == false)
+        {
+            return nullptr;
+        }
+        pSampler->createBuffers(pIndexBuffer);
+        return pSampler;
+    }
+
+    bool AreaLightSampler::init(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount)
+    {
+        if(vertexCount == 0 || indexCount < 3 || (indexCount % 3) != 0)
+        {
+            Logger::log(Logger::Level::Error, "AreaLightSampler - the geometry must be a non-empty triangle list");
+            return false;
+        }
+
+        mPositions.assign(pPositions, pPositions + vertexCount);
+        mIndices.assign(pIndices, pIndices + indexCount);
+
+        // Compute the triangle areas. They are the weights of the triangle distribution
+        const uint32_t triangleCount = indexCount / 3;
+        std::vector<float> areas(triangleCount);
+        double surfaceArea = 0;
+        mCDF.resize(triangleCount + 1);
+        mCDF[0] = 0;
+        for(uint32_t i = 0; i < triangleCount; i++)
+        {
+            const glm::vec3& p0 = mPositions[mIndices[i * 3 + 0]];
+            const glm::vec3& p1 = mPositions[mIndices[i * 3 + 1]];
+            const glm::vec3& p2 = mPositions[mIndices[i * 3 + 2]];
+            areas[i] = 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
+            surfaceArea += areas[i];
+            mCDF[i + 1] = (float)surfaceArea;
+        }
+        mSurfaceArea = (float)surfaceArea;
+
+        // Normalize the CDF
+        if(mSurfaceArea > 0)
+        {
+            const float invSurfaceArea = 1.0f / mSurfaceArea;
+            for(float& c : mCDF)
+            {
+                c *= invSurfaceArea;
+            }
+        }
+        mCDF[triangleCount] = 1.0f;
+
+        mpAliasTable = AliasTable::create(areas);
+
+        // Bounds and planar light direction
+        glm::vec3 boxMin = mPositions[0];
+        glm::vec3 boxMax = mPositions[0];
+        for(const glm::vec3& p : mPositions)
+        {
+            boxMin = glm::min(boxMin, p);
+            boxMax = glm::max(boxMax, p);
+        }
+        mBoundingBox = BoundingBox::fromMinMax(boxMin, boxMax);
+
+        const glm::vec3& p0 = mPositions[mIndices[0]];
+        const glm::vec3& p1 = mPositions[mIndices[1]];
+        const glm::vec3& p2 = mPositions[mIndices[2]];
+        mFirstNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+        return true;
+    }
+
+    void AreaLightSampler::createBuffers(const Buffer::SharedConstPtr& pIndexBuffer)
+    {
+        mpIndexBuffer = pIndexBuffer;
+        if(mpIndexBuffer == nullptr)
+        {
+            mpIndexBuffer = Buffer::create(sizeof(uint32_t) * mIndices.size(), Buffer::BindFlags::Index, Buffer::AccessFlags::None, mIndices.data());
+        }
+        mpCDFBuffer = Buffer::create(sizeof(float) * mCDF.size(), Buffer::BindFlags::ShaderResource, Buffer::AccessFlags::None, mCDF.data());
+        const auto& entries = mpAliasTable->getEntries();
+        mpAliasTableBuffer = Buffer::create(sizeof(AliasTable::Entry) * entries.size(), Buffer::BindFlags::ShaderResource, Buffer::AccessFlags::None, entries.data());
+    }
+
+    glm::vec3 AreaLightSampler::samplePosition(const glm::vec3& rSample, uint32_t& triangleId) const
+    {
+        triangleId = mpAliasTable->sample(rSample.z);
+        const glm::vec3& p0 = mPositions[mIndices[triangleId * 3 + 0]];
+        const glm::vec3& p1 = mPositions[mIndices[triangleId * 3 + 1]];
+        const glm::vec3& p2 = mPositions[mIndices[triangleId * 3 + 2]];
+
+        // Same barycentric mapping as the shader code
+        float a = sqrt(rSample.x);
+        glm::vec2 bary(1.0f - a, a * rSample.y);
+        return p0 * bary.x + p1 * bary.y + p2 * (1.0f - bary.x - bary.y);
+    }
+}
\ No newline at end of file
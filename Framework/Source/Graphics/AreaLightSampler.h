@@ -0,0 +1,133 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "glm/vec3.hpp"
+#include "Core/Buffer.h"
+#include "Utils/AABB.h"
+#include "Utils/Math/AliasTable.h"
+
+namespace Falcor
+{
+    class Mesh;
+
+    /** Importance sampling data for an emissive triangle mesh.
+        The data is built once per mesh on the CPU and is shared by the area lights of all of the mesh's instances.
+        Triangles are selected in O(1) with an alias table, so the sampled points are uniformly distributed over the mesh surface.
+    */
+    class AreaLightSampler
+    {
+    public:
+        using SharedPtr = std::shared_ptr<AreaLightSampler>;
+        using SharedConstPtr = std::shared_ptr<const AreaLightSampler>;
+
+        /** Create the sampling data from CPU-side geometry
+            \param[in] pPositions Object-space vertex positions
+            \param[in] vertexCount Number of vertices
+            \param[in] pIndices Triangle list indices
+            \param[in] indexCount Number of indices. Must be a multiple of 3.
+            \return A new object, or nullptr if the geometry is empty
+        */
+        static SharedPtr create(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount);
+
+        /** Create the sampling data for a mesh. The positions and indices are read once, from the mesh's CPU geometry copy (see Model::KeepCpuGeometry).
+            If the mesh doesn't have one, they are read back from the GPU, which stalls the pipeline until the GPU is idle and copies the whole vertex and index buffers. Load the model with Model::KeepCpuGeometry to avoid it.
+            If the mesh uses 32-bit indices, its index buffer is shared with the sampler.
+            \param[in] pMesh A triangle list mesh
+            \return A new object, or nullptr if the mesh has no positions or indices
+        */
+        static SharedPtr create(const Mesh* pMesh);
+
+        /** Sample a point uniformly over the mesh surface
+            \param[in] rSample Uniform random numbers in [0, 1). z selects the triangle, x and y select the point on it.
+            \param[out] triangleId The index of the selected triangle
+            \return The object-space position of the sample
+        */
+        glm::vec3 samplePosition(const glm::vec3& rSample, uint32_t& triangleId) const;
+
+        /** Get the PDF of samplePosition() with respect to the object-space surface area
+        */
+        float getAreaPdf() const { return (mSurfaceArea > 0) ? 1.0f / mSurfaceArea : 0.0f; }
+
+        /** Get the probability of selecting a triangle
+        */
+        float getTriangleProbability(uint32_t triangleId) const { return mpAliasTable->getProbability(triangleId); }
+
+        /** Get the object-space surface area of the mesh
+        */
+        float getSurfaceArea() const { return mSurfaceArea; }
+
+        /** Get the number of triangles
+        */
+        uint32_t getTriangleCount() const { return (uint32_t)mIndices.size() / 3; }
+
+        /** Get the object-space bounding box of the mesh
+        */
+        const BoundingBox& getBoundingBox() const { return mBoundingBox; }
+
+        /** Get the normal of the first triangle. Used as the direction of planar lights.
+        */
+        const glm::vec3& getFirstTriangleNormal() const { return mFirstNormal; }
+
+        /** Get the alias table used for triangle selection
+        */
+        const AliasTable::SharedConstPtr& getAliasTable() const { return mpAliasTable; }
+
+        /** Get the triangle CDF. It has getTriangleCount() + 1 entries, starting at 0 and ending at 1.
+        */
+        const std::vector<float>& getCDF() const { return mCDF; }
+
+        /** Get a 32-bit index buffer for the mesh, as expected by the light sampling shader code
+        */
+        const Buffer::SharedConstPtr& getIndexBuffer() const { return mpIndexBuffer; }
+
+        /** Get the GPU buffer holding the triangle CDF
+        */
+        const Buffer::SharedPtr& getCDFBuffer() const { return mpCDFBuffer; }
+
+        /** Get the GPU buffer holding the alias table entries
+        */
+        const Buffer::SharedPtr& getAliasTableBuffer() const { return mpAliasTableBuffer; }
+
+    private:
+        AreaLightSampler() = default;
+        bool init(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount);
+        void createBuffers(const Buffer::SharedConstPtr& pIndexBuffer);
+
+        std::vector<glm::vec3> mPositions;
+        std::vector<uint32_t> mIndices;
+        std::vector<float> mCDF;
+        AliasTable::SharedConstPtr mpAliasTable;
+        float mSurfaceArea = 0;
+        BoundingBox mBoundingBox;
+        glm::vec3 mFirstNormal = glm::vec3(0, -1, 0);
+
+        Buffer::SharedConstPtr mpIndexBuffer;
+        Buffer::SharedPtr mpCDFBuffer;
+        Buffer::SharedPtr mpAliasTableBuffer;
+    };
+}
\ No newline at end of file
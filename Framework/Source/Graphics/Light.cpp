@@ -314,10 +314,11 @@ namespace Falcor
 			mData.vertexPtr.ptr = mVertexBuf->makeResident();
 			if (mTexCoordBuf)
 				mData.texCoordPtr.ptr = mTexCoordBuf->makeResident();
-			// Store the mesh CDF buffer id
+			// Store the mesh CDF and alias table buffer ids
 			mData.meshCDFPtr.ptr = mMeshCDFBuf->makeResident();
+			mData.aliasTablePtr.ptr = mAliasTableBuf->makeResident();
 		}
-		mData.numIndices = uint32_t(mIndexBuf->getSize() / sizeof(glm::ivec3));
+		mData.numIndices = mpSampler->getTriangleCount();
 
 		// Get the surface area of the geometry mesh
 		mData.surfaceArea = mSurfaceArea;
@@ -333,24 +334,34 @@ namespace Falcor
 
 	void AreaLight::unloadGPUData()
 	{
-	    // Unload GPU data by calling makeNonResident()
-		mIndexBuf->makeNonResident();
-		mVertexBuf->makeNonResident();
-		if (mTexCoordBuf)
-			mTexCoordBuf->makeNonResident();
-		mMeshCDFBuf->makeNonResident();
+		// The buffers belong to the mesh and the shared sampler. Making them non-resident would break the other lights using them, so only drop the pointers.
+		mData.indexPtr.ptr = 0ull;
+		mData.vertexPtr.ptr = 0ull;
+		mData.texCoordPtr.ptr = 0ull;
+		mData.meshCDFPtr.ptr = 0ull;
+		mData.aliasTablePtr.ptr = 0ull;
 	}
 
-	void AreaLight::setMeshData(const Mesh::SharedPtr& pMesh, uint32_t instanceId)
+	bool AreaLight::setMeshData(const Mesh::SharedPtr& pMesh, uint32_t instanceId, const AreaLightSampler::SharedConstPtr& pSampler)
 	{
 		if (pMesh)
 		{
 			mMeshData.pMesh = pMesh;
 			mMeshData.instanceId = instanceId;
 
+			// Build the sampling data if it wasn't provided. Instances of the same mesh should share it, see createAreaLightsForModel()
+			mpSampler = pSampler ? pSampler : AreaLightSampler::create(pMesh.get());
+			if (mpSampler == nullptr)
+			{
+				Logger::log(Logger::Level::Error, "AreaLight::setMeshData() - can't create the sampling data for the mesh");
+				return false;
+			}
+
 			auto& vao = mMeshData.pMesh->getVao();
 		
-            setIndexBuffer(vao->getIndexBuffer());
+            // The sampler holds a 32-bit index buffer, as expected by the sampling code and the ray-tracer
+            Buffer::SharedConstPtr pIndexBuf = mpSampler->getIndexBuffer();
+            setIndexBuffer(pIndexBuf);
 
 			int32_t posIdx = vao->getElementIndexByLocation(VERTEX_POSITION_LOC).vbIndex;
 			assert(posIdx != Vao::ElementDesc::kInvalidIndex);
@@ -363,7 +374,7 @@ namespace Falcor
                 setTexCoordBuffer(vao->getVertexBuffer(VERTEX_TEXCOORD_LOC));
 			}
 
-			// Compute surface area of the mesh and generate probability
+			// Fetch the surface area of the mesh and the probability
 			// densities for importance sampling a triangle mesh
 			computeSurfaceArea();
 
@@ -380,74 +391,29 @@ namespace Falcor
                     }
                 }
             }
+			return true;
 		}
+		return false;
 	}
 
 	void AreaLight::computeSurfaceArea()
 	{
-		if(mVertexBuf && mIndexBuf)
+		if(mpSampler)
         {
-			// Read data from the buffers
-			std::vector<ivec3> indices(mMeshData.pMesh->getPrimitiveCount());
-			mIndexBuf->readData(indices.data(), 0, mIndexBuf->getSize());
-			std::vector<vec3> vertices(mVertexBuf->getSize() / sizeof(vec3));
-			mVertexBuf->readData(vertices.data(), 0, mVertexBuf->getSize());
-
-			// Calculate surface area of the mesh
-			mSurfaceArea = 0.f;
-			mMeshCDF.push_back(0.f);
-			for (uint32_t i = 0; i < mMeshData.pMesh->getPrimitiveCount(); ++i)
-			{
-				ivec3 pId = indices[i];
-				const vec3 p0(vertices[pId.x]), p1(vertices[pId.y]),  p2(vertices[pId.z]);
-
-				mSurfaceArea += 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
-
-				// Add an entry using surface area measure as the discrete probability
-				mMeshCDF.push_back(mMeshCDF[mMeshCDF.size() - 1] + mSurfaceArea);
-			}
-
-			// Normalize the probability densities
-			if (mSurfaceArea > 0.f)
-			{
-				float invSurfaceArea = 1.f / mSurfaceArea;
-				for (uint32_t i = 1; i < mMeshCDF.size(); ++i)
-				{
-					mMeshCDF[i] *= invSurfaceArea;
-				}
-						
-				mMeshCDF[mMeshCDF.size() - 1] = 1.f;
-			}
-
-            // Create a CDF buffer
-            auto pCDFBuffer = Buffer::create(sizeof(mMeshCDF[0])*mMeshCDF.size(), Buffer::BindFlags::ShaderResource, Buffer::AccessFlags::None, mMeshCDF.data());
-            setMeshCDFBuffer(pCDFBuffer);
+			mSurfaceArea = mpSampler->getSurfaceArea();
+			setMeshCDFBuffer(mpSampler->getCDFBuffer());
+			mAliasTableBuf = mpSampler->getAliasTableBuffer();
 
 			// Set the world position and world direction of this light
-			if (!vertices.empty() && !indices.empty())
-			{
-				glm::vec3 boxMin = vertices[0];
-				glm::vec3 boxMax = vertices[0];
-				for (uint32_t id = 1; id < vertices.size(); ++id)
-				{
-					boxMin = glm::min(boxMin, vertices[id]);
-					boxMax = glm::max(boxMax, vertices[id]);
-				}
+			const BoundingBox& box = mpSampler->getBoundingBox();
+			mData.worldPos = box.center;
 
-				mData.worldPos = BoundingBox::fromMinMax(boxMin, boxMax).center;
+			// This holds only for planar light sources. Take the normal of the first triangle as a light normal
+			mData.worldDir = mpSampler->getFirstTriangleNormal();
 
-				// This holds only for planar light sources
-				const glm::vec3& p0 = vertices[indices[0].x];
-				const glm::vec3& p1 = vertices[indices[0].y];
-				const glm::vec3& p2 = vertices[indices[0].z];
-
-                // Take the normal of the first triangle as a light normal
-				mData.worldDir = normalize(cross(p1 - p0, p2 - p0));
-
-                // Save the axis-aligned bounding box
-                mData.aabbMin = boxMin;
-                mData.aabbMax = boxMax;
-			}
+			// Save the axis-aligned bounding box
+			mData.aabbMin = box.center - box.extent;
+			mData.aabbMax = box.center + box.extent;
 		}
 	}
 
@@ -455,10 +421,11 @@ namespace Falcor
 	{
 		// Create an area light
 		AreaLight::SharedPtr pAreaLight = AreaLight::create();
-		if (pAreaLight)
+
+		// Set the geometry mesh. Lights without sampling data can't be used.
+		if (pAreaLight && pAreaLight->setMeshData(pMesh, instanceId) == false)
 		{
-			// Set the geometry mesh
-			pAreaLight->setMeshData(pMesh, instanceId);
+			return nullptr;
 		}
 
 		return pAreaLight;
@@ -473,8 +440,12 @@ namespace Falcor
 		{
 			const Mesh::SharedPtr& pMesh = pModel->getMesh(meshId);
 
+			// The sampling data only depends on the mesh, so it's built once and shared by all of the instances
+			AreaLightSampler::SharedConstPtr pSampler;
+			bool isSamplerValid = true;
+
 			// Obtain mesh instances for this mesh
-			for (uint32_t meshInstanceId = 0; meshInstanceId < pMesh->getInstanceCount(); ++meshInstanceId)
+			for (uint32_t meshInstanceId = 0; meshInstanceId < pMesh->getInstanceCount() && isSamplerValid; ++meshInstanceId)
 			{
 				// Check if this mesh has a material
 				const Material::SharedPtr& pMaterial = pMesh->getMaterial();
@@ -489,7 +460,22 @@ namespace Falcor
 						if (pLayerDesc->type == MatEmissive)
 						{
 							// Create an area light for an emissive material
-							areaLights.push_back(createAreaLight(pMesh, meshInstanceId));
+							if (pSampler == nullptr)
+							{
+								pSampler = AreaLightSampler::create(pMesh.get());
+								if (pSampler == nullptr)
+								{
+									// The mesh has no usable triangles. Don't create lights for any of its instances.
+									Logger::log(Logger::Level::Error, "createAreaLightsForModel() - can't create the sampling data for mesh " + std::to_string(meshId) + ", skipping its area lights");
+									isSamplerValid = false;
+									break;
+								}
+							}
+							AreaLight::SharedPtr pAreaLight = AreaLight::create();
+							if (pAreaLight->setMeshData(pMesh, meshInstanceId, pSampler))
+							{
+								areaLights.push_back(pAreaLight);
+							}
 							break;
 						}
 					}
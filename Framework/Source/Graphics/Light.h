@@ -34,6 +34,7 @@
 #include "Data/HostDeviceData.h"
 #include "Utils/Gui.h"
 #include "Graphics/Model/Mesh.h"
+#include "Graphics/AreaLightSampler.h"
 #include "Graphics/Paths/MovableObject.h"
 
 namespace Falcor
@@ -312,7 +313,7 @@ namespace Falcor
 		void prepareGPUData() override;
 
 		/**
-		    Unload GPU data
+		    Unload GPU data. The buffers are shared with the mesh and with the lights of the mesh's other instances, so they are left resident.
 		*/
 		void unloadGPUData() override;
 
@@ -321,8 +322,10 @@ namespace Falcor
 
 		    \param[in] pMesh Geometry mesh for this light
 			\param[in] instanceId Geometry mesh instance id
+			\param[in] pSampler Optional. Sampling data shared between all instances of the mesh. If this is nullptr, the data is created from the mesh.
+			\return false if the sampling data can't be created. The light can't be used in that case.
 		*/
-		void setMeshData(const Mesh::SharedPtr& pMesh, uint32_t instanceId);
+		bool setMeshData(const Mesh::SharedPtr& pMesh, uint32_t instanceId, const AreaLightSampler::SharedConstPtr& pSampler = nullptr);
 
 		/**
 		    Obtain the geometry mesh for this light
@@ -332,10 +335,17 @@ namespace Falcor
 		const AreaLight::MeshData& getMeshData() const { return mMeshData; }
 
 		/**
-		    Compute surface area of the mesh
+		    Update the surface area, position, direction and bounds of the light from the sampling data
 		*/
 		void computeSurfaceArea();
 
+		/**
+		    Get the importance sampling data of the mesh
+
+			\return The sampling data, shared between all instances of the mesh
+		*/
+		const AreaLightSampler::SharedConstPtr& getSampler() const { return mpSampler; }
+
 		/**
 		    Get surface area of the mesh
 
@@ -348,7 +358,7 @@ namespace Falcor
 
 			\return Probability distribution of the mesh
 		*/
-		const std::vector<float>& getMeshCDF() const { return mMeshCDF; }
+		const std::vector<float>& getMeshCDF() const { return mpSampler->getCDF(); }
 
 		/**
 		    Set buffer id for indices
@@ -406,6 +416,13 @@ namespace Falcor
 		*/
 		const Buffer::SharedPtr& getMeshCDFBuffer() const { return mMeshCDFBuf; }
 
+		/**
+		    Get Buffer id for the triangle alias table
+
+		    \return Buffer id for the triangle alias table
+		*/
+		const Buffer::SharedPtr& getAliasTableBuffer() const { return mAliasTableBuf; }
+
 		/**
 		    IMovableObject interface
 		*/
@@ -417,9 +434,10 @@ namespace Falcor
         Buffer::SharedConstPtr  mVertexBuf;          ///< Buffer id for vertices
         Buffer::SharedConstPtr  mTexCoordBuf;        ///< Buffer id for texcoord
         Buffer::SharedPtr       mMeshCDFBuf;         ///< Buffer id for mesh Cumulative distribution function (CDF)
+        Buffer::SharedPtr       mAliasTableBuf;      ///< Buffer id for the triangle alias table
 
-		float                   mSurfaceArea;        ///< Surface area of the mesh
-		std::vector<float>      mMeshCDF;            ///< CDF function for importance sampling a triangle mesh
+		float                   mSurfaceArea = 0.f;  ///< Surface area of the mesh
+		AreaLightSampler::SharedConstPtr mpSampler;  ///< Importance sampling data, shared between all instances of the mesh
 	};
 
 	/**
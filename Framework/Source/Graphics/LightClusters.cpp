@@ -0,0 +1,398 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightClusters.h"
+#include "Graphics/Camera/Camera.h"
+#include "Core/UniformBuffer.h"
+#include "Utils/AABB.h"
+#include "Utils/ParallelFor.h"
+#include <xmmintrin.h>
+#include <algorithm>
+
+namespace Falcor
+{
+    LightClusters::UniquePtr LightClusters::create(uint32_t tileCountX, uint32_t tileCountY, uint32_t sliceCount)
+    {
+        if(tileCountX == 0 || tileCountY == 0 || sliceCount == 0)
+        {
+            Logger::log(Logger::Level::Error, "LightClusters::create() - the cluster counts must be greater than zero");
+            return nullptr;
+        }
+        return UniquePtr(new LightClusters(tileCountX, tileCountY, sliceCount));
+    }
+
+    LightClusters::LightClusters(uint32_t tileCountX, uint32_t tileCountY, uint32_t sliceCount)
+    {
+        mData.tileCountX = tileCountX;
+        mData.tileCountY = tileCountY;
+        mData.sliceCount = sliceCount;
+
+        const uint32_t clusterCount = getClusterCount();
+        for(uint32_t axis = 0; axis < 3; axis++)
+        {
+            mClusterMin[axis].resize(clusterCount);
+            mClusterMax[axis].resize(clusterCount);
+        }
+        mClusterLists.resize(clusterCount);
+        mClusters.resize(clusterCount);
+        mSliceLights.resize(sliceCount);
+    }
+
+    void LightClusters::updateClusterBounds(const Camera* pCamera)
+    {
+        const glm::mat4& proj = pCamera->getProjMatrix();
+        const float nearZ = pCamera->getNearPlane();
+        const float farZ = pCamera->getFarPlane();
+        if(proj == mBoundsProjMat && nearZ == mData.nearZ && farZ == mBoundsFarZ)
+        {
+            return;
+        }
+        mBoundsProjMat = proj;
+        mBoundsFarZ = farZ;
+        mData.nearZ = nearZ;
+        mData.logDepthScale = float(mData.sliceCount) / log(farZ / nearZ);
+        mIsPerspective = (proj[2][3] != 0);
+
+        // Convert NDC to view-space X/Y. Perspective: x = (ndc + P20) * depth / P00. Orthographic: x = (ndc - P30) / P00.
+        auto ndcToView = [&](float ndc, uint32_t axis, float depth)
+        {
+            if(mIsPerspective)
+            {
+                return (ndc + proj[2][axis]) * depth / proj[axis][axis];
+            }
+            return (ndc - proj[3][axis]) / proj[axis][axis];
+        };
+
+        const uint32_t tileCount[2] = {mData.tileCountX, mData.tileCountY};
+        for(uint32_t slice = 0; slice < mData.sliceCount; slice++)
+        {
+            const float depth0 = nearZ * exp(float(slice) / mData.logDepthScale);
+            const float depth1 = nearZ * exp(float(slice + 1) / mData.logDepthScale);
+            for(uint32_t y = 0; y < mData.tileCountY; y++)
+            {
+                for(uint32_t x = 0; x < mData.tileCountX; x++)
+                {
+                    const uint32_t cluster = getClusterIndex(x, y, slice);
+                    const uint32_t tile[2] = {x, y};
+                    for(uint32_t axis = 0; axis < 2; axis++)
+                    {
+                        const float ndc0 = -1.0f + 2.0f * float(tile[axis]) / float(tileCount[axis]);
+                        const float ndc1 = -1.0f + 2.0f * float(tile[axis] + 1) / float(tileCount[axis]);
+                        const float v[4] = {ndcToView(ndc0, axis, depth0), ndcToView(ndc1, axis, depth0), ndcToView(ndc0, axis, depth1), ndcToView(ndc1, axis, depth1)};
+                        mClusterMin[axis][cluster] = std::min(std::min(v[0], v[1]), std::min(v[2], v[3]));
+                        mClusterMax[axis][cluster] = std::max(std::max(v[0], v[1]), std::max(v[2], v[3]));
+                    }
+                    // The camera looks down -Z
+                    mClusterMin[2][cluster] = -depth1;
+                    mClusterMax[2][cluster] = -depth0;
+                }
+            }
+        }
+    }
+
+    uint32_t LightClusters::getSlice(float depth) const
+    {
+        float slice = log(depth / mData.nearZ) * mData.logDepthScale;
+        return (uint32_t)glm::clamp(slice, 0.0f, float(mData.sliceCount - 1));
+    }
+
+    bool LightClusters::computeLightSphere(const Light* pLight, const glm::mat4& viewMat, LightBounds& bounds) const
+    {
+        const LightData& data = pLight->getData();
+        const float maxIntensity = std::max(data.intensity.x, std::max(data.intensity.y, data.intensity.z));
+        glm::vec3 center;
+
+        switch(pLight->getType())
+        {
+        case LightPoint:
+            // Inverse-square falloff. Spot lights use the same sphere, which is conservative.
+            center = data.worldPos;
+            bounds.radius = sqrt(maxIntensity / mIntensityThreshold);
+            break;
+        case LightArea:
+        {
+            // Bound the instance, then grow the bound by the falloff of a point light emitting the same power
+            BoundingBox box = BoundingBox::fromMinMax(data.aabbMin, data.aabbMax).transform(data.transMat);
+            center = box.center;
+            bounds.radius = glm::length(box.extent) + sqrt(maxIntensity * data.surfaceArea / mIntensityThreshold);
+            break;
+        }
+        default:
+            // Directional lights can't be bounded
+            return false;
+        }
+
+        bounds.center = glm::vec3(viewMat * glm::vec4(center, 1.0f));
+        return true;
+    }
+
+    bool LightClusters::computeTileRange(float center, float depth, float radius, float scale, float offset, uint32_t tileCount, uint32_t& minTile, uint32_t& maxTile) const
+    {
+        float ndc0 = -1;
+        float ndc1 = 1;
+        if(mIsPerspective == false)
+        {
+            ndc0 = scale * (center - radius) + offset;
+            ndc1 = scale * (center + radius) + offset;
+        }
+        else if(depth > radius)
+        {
+            // Slopes of the two lines through the eye which are tangent to the sphere's cross-section. See Mara and McGuire, "2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere".
+            float t = sqrt(center * center + depth * depth - radius * radius);
+            float denom = depth * depth - radius * radius;
+            float m0 = (center * depth - radius * t) / denom;
+            float m1 = (center * depth + radius * t) / denom;
+            ndc0 = scale * m0 + offset;
+            ndc1 = scale * m1 + offset;
+        }
+
+        if(ndc1 < -1 || ndc0 > 1)
+        {
+            return false;
+        }
+
+        float tile0 = (ndc0 * 0.5f + 0.5f) * tileCount;
+        float tile1 = (ndc1 * 0.5f + 0.5f) * tileCount;
+        minTile = (uint32_t)glm::clamp(tile0, 0.0f, float(tileCount - 1));
+        maxTile = (uint32_t)glm::clamp(tile1, 0.0f, float(tileCount - 1));
+        return true;
+    }
+
+    bool LightClusters::computeClusterRange(LightBounds& bounds) const
+    {
+        const float farZ = mBoundsFarZ;
+        const float depth = -bounds.center.z;
+        if(depth + bounds.radius < mData.nearZ || depth - bounds.radius > farZ)
+        {
+            return false;
+        }
+        bounds.minSlice = getSlice(std::max(depth - bounds.radius, mData.nearZ));
+        bounds.maxSlice = getSlice(std::min(depth + bounds.radius, farZ));
+
+        const glm::mat4& proj = mBoundsProjMat;
+        const float offsetX = mIsPerspective ? -proj[2][0] : proj[3][0];
+        const float offsetY = mIsPerspective ? -proj[2][1] : proj[3][1];
+        if(computeTileRange(bounds.center.x, depth, bounds.radius, proj[0][0], offsetX, mData.tileCountX, bounds.minX, bounds.maxX) == false)
+        {
+            return false;
+        }
+        return computeTileRange(bounds.center.y, depth, bounds.radius, proj[1][1], offsetY, mData.tileCountY, bounds.minY, bounds.maxY);
+    }
+
+    bool LightClusters::testCluster(uint32_t cluster, const LightBounds& bounds) const
+    {
+        float distSq = 0;
+        for(uint32_t axis = 0; axis < 3; axis++)
+        {
+            float d = std::max(mClusterMin[axis][cluster] - bounds.center[axis], 0.0f) + std::max(bounds.center[axis] - mClusterMax[axis][cluster], 0.0f);
+            distSq += d * d;
+        }
+        return distSq <= bounds.radius * bounds.radius;
+    }
+
+    void LightClusters::assignRow(uint32_t slice, uint32_t y, uint32_t lightIndex, const LightBounds& bounds)
+    {
+        const uint32_t rowStart = getClusterIndex(0, y, slice);
+        uint32_t x = bounds.minX;
+
+        // Test 4 clusters at a time
+        const __m128 radiusSq = _mm_set1_ps(bounds.radius * bounds.radius);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 center[3] = {_mm_set1_ps(bounds.center.x), _mm_set1_ps(bounds.center.y), _mm_set1_ps(bounds.center.z)};
+        for(; x + 4 <= bounds.maxX + 1; x += 4)
+        {
+            const uint32_t cluster = rowStart + x;
+            __m128 distSq = zero;
+            for(uint32_t axis = 0; axis < 3; axis++)
+            {
+                __m128 toMin = _mm_sub_ps(_mm_loadu_ps(&mClusterMin[axis][cluster]), center[axis]);
+                __m128 toMax = _mm_sub_ps(center[axis], _mm_loadu_ps(&mClusterMax[axis][cluster]));
+                __m128 d = _mm_add_ps(_mm_max_ps(toMin, zero), _mm_max_ps(toMax, zero));
+                distSq = _mm_add_ps(distSq, _mm_mul_ps(d, d));
+            }
+
+            int mask = _mm_movemask_ps(_mm_cmple_ps(distSq, radiusSq));
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                if(mask & (1 << i))
+                {
+                    mClusterLists[cluster + i].push_back(lightIndex);
+                }
+            }
+        }
+
+        for(; x <= bounds.maxX; x++)
+        {
+            if(testCluster(rowStart + x, bounds))
+            {
+                mClusterLists[rowStart + x].push_back(lightIndex);
+            }
+        }
+    }
+
+    void LightClusters::gatherLights(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights)
+    {
+        const uint32_t lightCount = (uint32_t)lights.size();
+        mLightBounds.resize(lightCount);
+        mLightVisible.resize(lightCount);
+
+        const glm::mat4& viewMat = pCamera->getViewMatrix();
+        parallelFor(lightCount, 256, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                LightBounds& bounds = mLightBounds[i];
+                mLightVisible[i] = computeLightSphere(lights[i].get(), viewMat, bounds) && computeClusterRange(bounds);
+            }
+        });
+
+        // Bin the lights by depth slice. Lights are added in order, so the cluster lists end up sorted.
+        for(auto& sliceLights : mSliceLights)
+        {
+            sliceLights.clear();
+        }
+        for(uint32_t i = 0; i < lightCount; i++)
+        {
+            if(mLightVisible[i])
+            {
+                for(uint32_t slice = mLightBounds[i].minSlice; slice <= mLightBounds[i].maxSlice; slice++)
+                {
+                    mSliceLights[slice].push_back(i);
+                }
+            }
+        }
+    }
+
+    void LightClusters::compactLists()
+    {
+        uint32_t offset = 0;
+        for(uint32_t cluster = 0; cluster < getClusterCount(); cluster++)
+        {
+            const uint32_t count = (uint32_t)mClusterLists[cluster].size();
+            mClusters[cluster] = glm::uvec2(offset, count);
+            offset += count;
+        }
+        mLightIndices.resize(offset);
+
+        const uint32_t clustersPerSlice = mData.tileCountX * mData.tileCountY;
+        parallelFor(mData.sliceCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t cluster = begin * clustersPerSlice; cluster < end * clustersPerSlice; cluster++)
+            {
+                std::copy(mClusterLists[cluster].begin(), mClusterLists[cluster].end(), mLightIndices.begin() + mClusters[cluster].x);
+            }
+        });
+    }
+
+    void LightClusters::build(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights)
+    {
+        updateClusterBounds(pCamera);
+        gatherLights(pCamera, lights);
+
+        // Every slice only touches its own clusters, so the slices can be processed independently
+        const uint32_t clustersPerSlice = mData.tileCountX * mData.tileCountY;
+        parallelFor(mData.sliceCount, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t slice = begin; slice < end; slice++)
+            {
+                for(uint32_t cluster = slice * clustersPerSlice; cluster < (slice + 1) * clustersPerSlice; cluster++)
+                {
+                    mClusterLists[cluster].clear();
+                }
+
+                for(uint32_t lightIndex : mSliceLights[slice])
+                {
+                    const LightBounds& bounds = mLightBounds[lightIndex];
+                    for(uint32_t y = bounds.minY; y <= bounds.maxY; y++)
+                    {
+                        assignRow(slice, y, lightIndex, bounds);
+                    }
+                }
+            }
+        });
+
+        compactLists();
+        mData.lightCount = (uint32_t)lights.size();
+    }
+
+    static void updateBuffer(Buffer::SharedPtr& pBuffer, const void* pData, size_t size)
+    {
+        // Grow the buffer geometrically, so that the light count can change every frame without reallocating
+        if(pBuffer == nullptr || pBuffer->getSize() < size)
+        {
+            size_t capacity = std::max(size, size_t(16));
+            if(pBuffer)
+            {
+                pBuffer->makeNonResident();
+                capacity = std::max(capacity, pBuffer->getSize() * 2);
+            }
+            pBuffer = Buffer::create(capacity, Buffer::BindFlags::ShaderResource, Buffer::AccessFlags::Dynamic, nullptr);
+        }
+
+        if(size > 0)
+        {
+            pBuffer->updateData(pData, 0, size);
+        }
+    }
+
+    void LightClusters::uploadData(const std::vector<Light::SharedPtr>& lights)
+    {
+        // Light data is gathered on the calling thread, since area lights touch API resources
+        mLightData.resize(lights.size());
+        for(size_t i = 0; i < lights.size(); i++)
+        {
+            lights[i]->prepareGPUData();
+            mLightData[i] = lights[i]->getData();
+        }
+
+        updateBuffer(mpClusterBuffer, mClusters.data(), mClusters.size() * sizeof(glm::uvec2));
+        updateBuffer(mpLightIndexBuffer, mLightIndices.data(), mLightIndices.size() * sizeof(uint32_t));
+        updateBuffer(mpLightDataBuffer, mLightData.data(), mLightData.size() * sizeof(LightData));
+
+        mData.clusterPtr.ptr = mpClusterBuffer->makeResident();
+        mData.lightIndexPtr.ptr = mpLightIndexBuffer->makeResident();
+        mData.lightDataPtr.ptr = mpLightDataBuffer->makeResident();
+    }
+
+    void LightClusters::update(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights)
+    {
+        build(pCamera, lights);
+        uploadData(lights);
+    }
+
+    void LightClusters::setIntoUniformBuffer(UniformBuffer* pBuffer, const std::string& varName)
+    {
+        size_t offset = pBuffer->getVariableOffset(varName + ".tileCountX");
+        if(offset == UniformBuffer::kInvalidUniformOffset)
+        {
+            Logger::log(Logger::Level::Warning, "LightClusters::setIntoUniformBuffer() - variable \"" + varName + "\"not found in uniform buffer\n");
+            return;
+        }
+        pBuffer->setBlob(&mData, offset, sizeof(mData));
+    }
+}
\ No newline at end of file
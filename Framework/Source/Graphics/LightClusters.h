@@ -0,0 +1,150 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Core/Buffer.h"
+#include "Data/HostDeviceData.h"
+#include "Graphics/Light.h"
+
+namespace Falcor
+{
+    class Camera;
+    class UniformBuffer;
+
+    /** Clustered light culling.
+        Splits the view frustum into screen tiles and exponential depth slices, and builds a compact list of the lights affecting each cluster.
+        Point (and spot) lights and area lights are clustered using their bounding spheres. Directional lights affect everything and are not added to any cluster.
+        The lists are built on the CPU every frame, using all of the available cores, and uploaded to GPU buffers which are accessed in shaders through LightClusterData.
+    */
+    class LightClusters
+    {
+    public:
+        using UniquePtr = std::unique_ptr<LightClusters>;
+
+        /** Create a new object
+            \param[in] tileCountX Number of screen tiles along X
+            \param[in] tileCountY Number of screen tiles along Y
+            \param[in] sliceCount Number of depth slices
+        */
+        static UniquePtr create(uint32_t tileCountX = 16, uint32_t tileCountY = 8, uint32_t sliceCount = 24);
+
+        /** Build the cluster lists and upload them to the GPU.
+            \param[in] pCamera The camera the clusters are built for
+            \param[in] lights The lights. The light indices in the clusters refer to this vector.
+        */
+        void update(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights);
+
+        /** Build the cluster lists on the CPU only, without uploading them.
+            \param[in] pCamera The camera the clusters are built for
+            \param[in] lights The lights
+        */
+        void build(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights);
+
+        /** Set the light parameters into a program. Needs the LightClusterData declaration from 'HostDeviceData.h'.
+            \param[in] pBuffer The uniform buffer to set the parameters into.
+            \param[in] varName The name of the LightClusterData variable in the program.
+        */
+        void setIntoUniformBuffer(UniformBuffer* pBuffer, const std::string& varName);
+
+        /** Set the irradiance below which a light is considered to have no effect. This controls the radius of point and area lights.
+        */
+        void setIntensityThreshold(float threshold) { mIntensityThreshold = threshold; }
+
+        /** Get the irradiance threshold
+        */
+        float getIntensityThreshold() const { return mIntensityThreshold; }
+
+        /** Get the number of clusters
+        */
+        uint32_t getClusterCount() const { return mData.tileCountX * mData.tileCountY * mData.sliceCount; }
+
+        /** Get the index of a cluster
+        */
+        uint32_t getClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return (slice * mData.tileCountY + y) * mData.tileCountX + x; }
+
+        /** Get the per-cluster {offset, count} pairs from the last build
+        */
+        const std::vector<glm::uvec2>& getClusters() const { return mClusters; }
+
+        /** Get the light index lists from the last build
+        */
+        const std::vector<uint32_t>& getLightIndices() const { return mLightIndices; }
+
+        /** Get the shader data
+        */
+        const LightClusterData& getData() const { return mData; }
+
+    private:
+        LightClusters(uint32_t tileCountX, uint32_t tileCountY, uint32_t sliceCount);
+
+        struct LightBounds
+        {
+            glm::vec3 center;   ///< View-space center
+            float radius;
+            uint32_t minX, maxX;
+            uint32_t minY, maxY;
+            uint32_t minSlice, maxSlice;
+        };
+
+        void updateClusterBounds(const Camera* pCamera);
+        bool computeLightSphere(const Light* pLight, const glm::mat4& viewMat, LightBounds& bounds) const;
+        bool computeClusterRange(LightBounds& bounds) const;
+        bool computeTileRange(float center, float depth, float radius, float scale, float offset, uint32_t tileCount, uint32_t& minTile, uint32_t& maxTile) const;
+        uint32_t getSlice(float depth) const;
+        void gatherLights(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights);
+        bool testCluster(uint32_t cluster, const LightBounds& bounds) const;
+        void assignRow(uint32_t slice, uint32_t y, uint32_t lightIndex, const LightBounds& bounds);
+        void compactLists();
+        void uploadData(const std::vector<Light::SharedPtr>& lights);
+
+        LightClusterData mData;
+        float mIntensityThreshold = 1.0f / 256.0f;
+
+        // Cluster view-space AABBs, SoA so that a row of clusters can be tested with SIMD
+        std::vector<float> mClusterMin[3];
+        std::vector<float> mClusterMax[3];
+        glm::mat4 mBoundsProjMat;
+        float mBoundsFarZ = 0;
+        bool mIsPerspective = true;
+
+        std::vector<LightBounds> mLightBounds;
+        std::vector<uint8_t> mLightVisible;
+        std::vector<std::vector<uint32_t>> mSliceLights;    ///< Lights overlapping each depth slice
+        std::vector<std::vector<uint32_t>> mClusterLists;   ///< Per-cluster lists before compaction
+
+        std::vector<glm::uvec2> mClusters;
+        std::vector<uint32_t> mLightIndices;
+        std::vector<LightData> mLightData;
+
+        Buffer::SharedPtr mpClusterBuffer;
+        Buffer::SharedPtr mpLightIndexBuffer;
+        Buffer::SharedPtr mpLightDataBuffer;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,576 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuMaterialEvaluator.h"
+#include <algorithm>
+#include <cmath>
+#include "ShadingUtils/HostShading.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Math/SseMath.h"
+
+namespace Falcor
+{
+    using PackedLayer = CpuMaterialEvaluator::PackedLayer;
+
+    CpuMaterialEvaluator::SharedPtr CpuMaterialEvaluator::create(const std::vector<Material::SharedPtr>& materials)
+    {
+        std::vector<MaterialData> data;
+        data.reserve(materials.size());
+        for(const auto& pMaterial : materials)
+        {
+            data.push_back(pMaterial->getData());
+        }
+        return create(data);
+    }
+
+    CpuMaterialEvaluator::SharedPtr CpuMaterialEvaluator::create(const std::vector<MaterialData>& materials)
+    {
+        if(materials.empty())
+        {
+            Logger::log(Logger::Level::Error, "CpuMaterialEvaluator::create() - the material list is empty");
+            return nullptr;
+        }
+        return SharedPtr(new CpuMaterialEvaluator(materials));
+    }
+
+    CpuMaterialEvaluator::CpuMaterialEvaluator(const std::vector<MaterialData>& materials) : mMaterials(materials)
+    {
+        uint32_t texturedLayerCount = 0;
+        mLayers.resize(materials.size() * MatMaxLayers);
+        for(size_t m = 0; m < materials.size(); m++)
+        {
+            // Match FOR_MAT_LAYERS, which stops at the first empty layer
+            bool terminated = false;
+            for(uint32_t l = 0; l < MatMaxLayers; l++)
+            {
+                const MaterialLayerDesc& desc = materials[m].desc.layers[l];
+                const MaterialLayerValues& values = materials[m].values.layers[l];
+                terminated = terminated || (desc.type == MatNone);
+
+                PackedLayer& packed = mLayers[m * MatMaxLayers + l];
+                for(uint32_t c = 0; c < 4; c++)
+                {
+                    packed.albedo[c] = values.albedo.constantColor[c];
+                }
+                packed.roughness[0] = values.roughness.constantColor.x;
+                packed.roughness[1] = values.roughness.constantColor.y;
+                packed.ior = values.extraParam.constantColor.x;
+                packed.kappa = values.extraParam.constantColor.y;
+                packed.type = terminated ? (float)MatNone : (float)desc.type;
+                packed.ndf = (float)desc.ndf;
+                packed.blending = (float)desc.blending;
+                packed.pad = 0;
+
+                if(terminated == false && (desc.hasAlbedoTexture || desc.hasRoughnessTexture || desc.hasExtraParamTexture))
+                {
+                    texturedLayerCount++;
+                }
+            }
+        }
+
+        if(texturedLayerCount > 0)
+        {
+            Logger::log(Logger::Level::Warning, "CpuMaterialEvaluator - " + std::to_string(texturedLayerCount) + " material layers use textures. Textures are not sampled on the CPU, the constant colors will be used instead.");
+        }
+    }
+
+    /************************************************************************/
+    /* Reference path - the shader code compiled for the host                */
+    /************************************************************************/
+    static glm::vec3 loadVector(const CpuMaterialEvaluator::InputArray& a, uint32_t i, const glm::vec3& defaultValue)
+    {
+        return a.x ? glm::vec3(a.x[i], a.y[i], a.z[i]) : defaultValue;
+    }
+
+    static void storeVector(const CpuMaterialEvaluator::OutputArray& a, uint32_t i, const glm::vec3& v)
+    {
+        if(a.x)
+        {
+            a.x[i] = v.x;
+            a.y[i] = v.y;
+            a.z[i] = v.z;
+        }
+    }
+
+    void CpuMaterialEvaluator::evaluateReferenceRange(const Samples& samples, const Results& results, uint32_t begin, uint32_t end) const
+    {
+        for(uint32_t i = begin; i < end; i++)
+        {
+            const MaterialData& material = mMaterials[samples.pMaterialIndex ? samples.pMaterialIndex[i] : 0];
+            glm::vec3 normal = loadVector(samples.normal, i, glm::vec3(0, 0, 1));
+            glm::vec3 view = loadVector(samples.view, i, glm::vec3(0, 0, 1));
+
+            // The shading point is at the origin, so the camera position is the view direction
+            ShadingAttribs shAttr;
+            if(samples.tangent.x)
+            {
+                glm::vec3 tangent = loadVector(samples.tangent, i, glm::vec3(1, 0, 0));
+                glm::vec3 bitangent = loadVector(samples.bitangent, i, glm::vec3(0, 1, 0));
+                HostShading::prepareShadingAttribs(material, glm::vec3(0), view, normal, tangent, bitangent, glm::vec2(0), 0.f, shAttr);
+            }
+            else
+            {
+                HostShading::prepareShadingAttribs(material, glm::vec3(0), view, normal, glm::vec2(0), 0.f, shAttr);
+            }
+
+            HostShading::LightAttribs lAttr;
+            lAttr.L = loadVector(samples.light, i, glm::vec3(0, 0, 1));
+            lAttr.lightIntensity = loadVector(samples.lightIntensity, i, glm::vec3(1));
+
+            HostShading::ShadingOutput output;
+            HostShading::evalMaterial(shAttr, lAttr, output, true);
+
+            storeVector(results.value, i, output.finalValue);
+            storeVector(results.diffuseAlbedo, i, output.diffuseAlbedo);
+            storeVector(results.diffuseIllumination, i, output.diffuseIllumination);
+            storeVector(results.specularAlbedo, i, output.specularAlbedo);
+            storeVector(results.specularIllumination, i, output.specularIllumination);
+        }
+    }
+
+    void CpuMaterialEvaluator::evaluateReference(const Samples& samples, const Results& results) const
+    {
+        evaluateReferenceRange(samples, results, 0, samples.count);
+    }
+
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+    /************************************************************************/
+    /* SIMD path. Each function mirrors its counterpart in BSDFs.h and      */
+    /* Shading.h, with the operations in the same order.                    */
+    /************************************************************************/
+    struct SimdVector
+    {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+    };
+
+    static __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    static __m128 dot(const SimdVector& a, const SimdVector& b)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+    }
+
+    static SimdVector scale(const SimdVector& v, __m128 s)
+    {
+        SimdVector r = {_mm_mul_ps(v.x, s), _mm_mul_ps(v.y, s), _mm_mul_ps(v.z, s)};
+        return r;
+    }
+
+    static SimdVector normalize(const SimdVector& v)
+    {
+        return scale(v, _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(dot(v, v))));
+    }
+
+    static SimdVector select(__m128 mask, const SimdVector& a, const SimdVector& b)
+    {
+        SimdVector r = {select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z)};
+        return r;
+    }
+
+    static SimdVector add(const SimdVector& a, const SimdVector& b)
+    {
+        SimdVector r = {_mm_add_ps(a.x, b.x), _mm_add_ps(a.y, b.y), _mm_add_ps(a.z, b.z)};
+        return r;
+    }
+
+    /** The lanes' layer parameters, transposed from PackedLayer
+    */
+    struct SimdLayer
+    {
+        __m128 albedo[4];
+        __m128 roughnessX;
+        __m128 roughnessY;
+        __m128 ior;
+        __m128 kappa;
+        __m128 type;
+        __m128 ndf;
+        __m128 blending;
+    };
+
+    static void gatherLayer(const PackedLayer* const pLayers[4], SimdLayer& layer)
+    {
+        static_assert(sizeof(PackedLayer) == 12 * sizeof(float), "PackedLayer must hold 3 SSE vectors");
+        __m128 v[3][4];
+        for(uint32_t lane = 0; lane < 4; lane++)
+        {
+            const float* pData = &pLayers[lane]->albedo[0];
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                v[i][lane] = _mm_loadu_ps(pData + i * 4);
+            }
+        }
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            _MM_TRANSPOSE4_PS(v[i][0], v[i][1], v[i][2], v[i][3]);
+        }
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            layer.albedo[c] = v[0][c];
+        }
+        layer.roughnessX = v[1][0];
+        layer.roughnessY = v[1][1];
+        layer.ior = v[1][2];
+        layer.kappa = v[1][3];
+        layer.type = v[2][0];
+        layer.ndf = v[2][1];
+        layer.blending = v[2][2];
+    }
+
+    static __m128 evalBeckmannDistribution(const SimdVector& h, const SimdLayer& layer)
+    {
+        __m128 NoH2 = _mm_mul_ps(h.z, h.z);
+        __m128 exponent = _mm_add_ps(_mm_mul_ps(_mm_div_ps(h.x, _mm_mul_ps(layer.roughnessX, layer.roughnessX)), h.x), _mm_mul_ps(_mm_div_ps(h.y, _mm_mul_ps(layer.roughnessY, layer.roughnessY)), h.y));
+        exponent = _mm_div_ps(exponent, NoH2);
+        __m128 denom = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(M_PIf), layer.roughnessX), layer.roughnessY), NoH2), NoH2);
+        return _mm_div_ps(exp4(_mm_sub_ps(_mm_setzero_ps(), exponent)), denom);
+    }
+
+    static __m128 evalGGXDistribution(const SimdVector& h, const SimdLayer& layer)
+    {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 anisoU = select(_mm_cmplt_ps(layer.roughnessY, layer.roughnessX), _mm_div_ps(layer.roughnessY, layer.roughnessX), one);
+        __m128 anisoV = select(_mm_cmplt_ps(layer.roughnessX, layer.roughnessY), _mm_div_ps(layer.roughnessX, layer.roughnessY), one);
+        __m128 r = _mm_min_ps(layer.roughnessX, layer.roughnessY);
+        __m128 NoH2 = _mm_mul_ps(h.z, h.z);
+        __m128 exponent = _mm_add_ps(_mm_mul_ps(_mm_div_ps(h.x, _mm_mul_ps(anisoU, anisoU)), h.x), _mm_mul_ps(_mm_div_ps(h.y, _mm_mul_ps(anisoV, anisoV)), h.y));
+        __m128 root = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(NoH2, r), r), exponent);
+        __m128 denom = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(M_PIf), anisoU), anisoV), root), root);
+        return _mm_div_ps(_mm_mul_ps(r, r), denom);
+    }
+
+    static __m128 GSmith(const SimdVector& dir, const SimdVector& h, const SimdLayer& layer, __m128 isBeckmann)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 visible = _mm_cmpgt_ps(_mm_mul_ps(dot(dir, h), dir.z), zero);
+        __m128 sinThSq = _mm_sub_ps(one, _mm_mul_ps(dir.z, dir.z));
+        __m128 grazing = _mm_cmpgt_ps(sinThSq, zero);
+        __m128 recipSlope = _mm_div_ps(_mm_sqrt_ps(sinThSq), dir.z);
+
+        // effectiveVisibleRoughness()
+        __m128 recipSinThSq = _mm_div_ps(one, sinThSq);
+        __m128 cosPhiSq = _mm_mul_ps(_mm_mul_ps(dir.x, dir.x), recipSinThSq);
+        __m128 sinPhiSq = _mm_mul_ps(_mm_mul_ps(dir.y, dir.y), recipSinThSq);
+        __m128 alpha = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(layer.roughnessX, layer.roughnessX), cosPhiSq), _mm_mul_ps(_mm_mul_ps(layer.roughnessY, layer.roughnessY), sinPhiSq)));
+
+        // Beckmann, using the fit from [Walter07]
+        __m128 a = _mm_div_ps(one, _mm_mul_ps(alpha, recipSlope));
+        __m128 aSq = _mm_mul_ps(a, a);
+        __m128 beckmann = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(3.535f), a), _mm_mul_ps(_mm_set1_ps(2.181f), aSq)),
+            _mm_add_ps(_mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(2.276f), a)), _mm_mul_ps(_mm_set1_ps(2.577f), aSq)));
+        beckmann = select(_mm_cmpgt_ps(a, _mm_set1_ps(1.6f)), one, beckmann);
+
+        // GGX
+        __m128 isectRoot = _mm_mul_ps(alpha, recipSlope);
+        __m128 ggx = _mm_div_ps(_mm_set1_ps(2.f), _mm_add_ps(one, _mm_sqrt_ps(_mm_add_ps(one, _mm_mul_ps(isectRoot, isectRoot)))));
+
+        __m128 g = select(grazing, select(isBeckmann, beckmann, ggx), one);
+        return _mm_and_ps(visible, g);
+    }
+
+    static __m128 conductorFresnel(__m128 NdE, __m128 IoR, __m128 kappa)
+    {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 totalIoR2 = _mm_add_ps(_mm_mul_ps(IoR, IoR), _mm_mul_ps(kappa, kappa));
+        NdE = _mm_min_ps(_mm_max_ps(NdE, _mm_setzero_ps()), one);
+        __m128 NdE2 = _mm_mul_ps(NdE, NdE);
+        __m128 reducedNdE2 = _mm_mul_ps(totalIoR2, NdE2);
+        __m128 twoIoRNdE = _mm_mul_ps(_mm_mul_ps(IoR, NdE), _mm_set1_ps(2.f));
+        __m128 Rp2 = _mm_div_ps(_mm_add_ps(_mm_sub_ps(reducedNdE2, twoIoRNdE), one), _mm_add_ps(_mm_add_ps(reducedNdE2, twoIoRNdE), one));
+        __m128 Rs2 = _mm_div_ps(_mm_add_ps(_mm_sub_ps(totalIoR2, twoIoRNdE), NdE2), _mm_add_ps(_mm_add_ps(totalIoR2, twoIoRNdE), NdE2));
+        return _mm_mul_ps(_mm_add_ps(Rp2, Rs2), _mm_set1_ps(.5f));
+    }
+
+    static __m128 dielectricFresnel(__m128 NdE, __m128 IoR)
+    {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 realIoR = select(_mm_cmpge_ps(NdE, _mm_setzero_ps()), _mm_div_ps(one, IoR), IoR);
+        __m128 NdL2 = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(realIoR, realIoR), _mm_sub_ps(one, _mm_mul_ps(NdE, NdE))));
+        __m128 refracted = _mm_cmpgt_ps(NdL2, _mm_setzero_ps());
+        __m128 IoRNdL = _mm_mul_ps(IoR, _mm_sqrt_ps(NdL2));
+        NdE = _mm_andnot_ps(_mm_set1_ps(-0.f), NdE);
+        __m128 Rp = _mm_div_ps(_mm_sub_ps(IoRNdL, NdE), _mm_add_ps(IoRNdL, NdE));
+        __m128 Rs = _mm_div_ps(_mm_sub_ps(NdE, IoRNdL), _mm_add_ps(NdE, IoRNdL));
+        __m128 F = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(Rp, Rp), _mm_mul_ps(Rs, Rs)), _mm_set1_ps(.5f));
+        // Total internal reflection
+        return select(refracted, F, one);
+    }
+
+    static __m128 loadLanes(const float* pData, uint32_t base, uint32_t laneCount, float defaultValue)
+    {
+        if(pData == nullptr)
+        {
+            return _mm_set1_ps(defaultValue);
+        }
+        if(laneCount == 4)
+        {
+            return _mm_loadu_ps(pData + base);
+        }
+        // Repeat the last sample in the unused lanes, so they don't produce NaNs
+        float values[4];
+        for(uint32_t lane = 0; lane < 4; lane++)
+        {
+            values[lane] = pData[base + std::min(lane, laneCount - 1)];
+        }
+        return _mm_loadu_ps(values);
+    }
+
+    static SimdVector loadLanes(const CpuMaterialEvaluator::InputArray& a, uint32_t base, uint32_t laneCount, float defaultX, float defaultY, float defaultZ)
+    {
+        SimdVector v = {loadLanes(a.x, base, laneCount, defaultX), loadLanes(a.y, base, laneCount, defaultY), loadLanes(a.z, base, laneCount, defaultZ)};
+        return v;
+    }
+
+    static void storeLanes(float* pData, uint32_t base, uint32_t laneCount, __m128 value)
+    {
+        if(laneCount == 4)
+        {
+            _mm_storeu_ps(pData + base, value);
+        }
+        else
+        {
+            float values[4];
+            _mm_storeu_ps(values, value);
+            for(uint32_t lane = 0; lane < laneCount; lane++)
+            {
+                pData[base + lane] = values[lane];
+            }
+        }
+    }
+
+    static void storeLanes(const CpuMaterialEvaluator::OutputArray& a, uint32_t base, uint32_t laneCount, const SimdVector& v)
+    {
+        if(a.x)
+        {
+            storeLanes(a.x, base, laneCount, v.x);
+            storeLanes(a.y, base, laneCount, v.y);
+            storeLanes(a.z, base, laneCount, v.z);
+        }
+    }
+
+    void CpuMaterialEvaluator::evaluateRange(const Samples& samples, const Results& results, uint32_t begin, uint32_t end) const
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const SimdVector zeroVector = {zero, zero, zero};
+
+        for(uint32_t base = begin; base < end; base += 4)
+        {
+            uint32_t laneCount = std::min(4u, end - base);
+
+            // prepareShadingAttribs()
+            SimdVector rawNormal = loadLanes(samples.normal, base, laneCount, 0, 0, 1);
+            SimdVector N = normalize(rawNormal);
+            SimdVector E = normalize(loadLanes(samples.view, base, laneCount, 0, 0, 1));
+            SimdVector T;
+            SimdVector B;
+            if(samples.tangent.x)
+            {
+                T = normalize(loadLanes(samples.tangent, base, laneCount, 1, 0, 0));
+                B = normalize(loadLanes(samples.bitangent, base, laneCount, 0, 1, 0));
+            }
+            else
+            {
+                // createTangentFrame()
+                const __m128 signMask = _mm_set1_ps(-0.f);
+                __m128 useXZ = _mm_cmpgt_ps(_mm_andnot_ps(signMask, rawNormal.x), _mm_andnot_ps(signMask, rawNormal.y));
+                __m128 u = select(useXZ, rawNormal.x, rawNormal.y);
+                __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(u, u), _mm_mul_ps(rawNormal.z, rawNormal.z)));
+                SimdVector b;
+                b.x = _mm_div_ps(_mm_and_ps(useXZ, rawNormal.z), length);
+                b.y = _mm_div_ps(_mm_andnot_ps(useXZ, rawNormal.z), length);
+                b.z = _mm_div_ps(_mm_xor_ps(u, signMask), length);
+                SimdVector t;
+                t.x = _mm_sub_ps(_mm_mul_ps(b.y, rawNormal.z), _mm_mul_ps(rawNormal.y, b.z));
+                t.y = _mm_sub_ps(_mm_mul_ps(b.z, rawNormal.x), _mm_mul_ps(rawNormal.z, b.x));
+                t.z = _mm_sub_ps(_mm_mul_ps(b.x, rawNormal.y), _mm_mul_ps(rawNormal.x, b.y));
+                T = normalize(t);
+                B = normalize(b);
+            }
+
+            SimdVector L = loadLanes(samples.light, base, laneCount, 0, 0, 1);
+            SimdVector lightIntensity = loadLanes(samples.lightIntensity, base, laneCount, 1, 1, 1);
+
+            // Light-independent terms, shared by all the layers
+            __m128 NdE = dot(E, N);
+            __m128 NdL = dot(L, N);
+            __m128 diffuseBSDF = _mm_mul_ps(_mm_max_ps(NdL, zero), _mm_set1_ps(M_1_PIf));
+            SimdVector hW = normalize(add(E, L));
+            SimdVector hTangent = {dot(hW, T), dot(hW, B), dot(hW, N)};
+            SimdVector h = normalize(hTangent);
+            SimdVector lTg = {dot(T, L), dot(B, L), dot(N, L)};
+            SimdVector vTg = {dot(T, E), dot(B, E), dot(N, E)};
+            __m128 sameSide = _mm_cmpgt_ps(_mm_mul_ps(lTg.z, vTg.z), zero);
+            __m128 HoE = dot(hW, E);
+            __m128 jacobian = _mm_mul_ps(_mm_set1_ps(4.f), NdE);
+
+            // evalMaterial(). Back-facing lanes stay black.
+            __m128 active = _mm_cmpgt_ps(NdE, zero);
+            SimdVector value = zeroVector;
+            SimdVector diffuseAlbedo = zeroVector;
+            SimdVector diffuseIllumination = zeroVector;
+            SimdVector specularAlbedo = zeroVector;
+            SimdVector specularIllumination = zeroVector;
+
+            const PackedLayer* pMaterialLayers[4];
+            for(uint32_t lane = 0; lane < 4; lane++)
+            {
+                uint32_t sample = base + std::min(lane, laneCount - 1);
+                uint32_t materialIndex = samples.pMaterialIndex ? samples.pMaterialIndex[sample] : 0;
+                pMaterialLayers[lane] = &mLayers[materialIndex * MatMaxLayers];
+            }
+
+            for(uint32_t l = 0; l < MatMaxLayers; l++)
+            {
+                const PackedLayer* pLayers[4];
+                for(uint32_t lane = 0; lane < 4; lane++)
+                {
+                    pLayers[lane] = pMaterialLayers[lane] + l;
+                }
+                SimdLayer layer;
+                gatherLayer(pLayers, layer);
+
+                active = _mm_andnot_ps(_mm_cmpeq_ps(layer.type, _mm_set1_ps((float)MatNone)), active);
+                if(_mm_movemask_ps(active) == 0)
+                {
+                    break;
+                }
+                SimdVector albedo = {layer.albedo[0], layer.albedo[1], layer.albedo[2]};
+
+                // Layers of other types return zero
+                SimdVector layerValue = zeroVector;
+                __m128 layerWeight = zero;
+
+                // evalDiffuseLayer()
+                __m128 isDiffuse = _mm_and_ps(active, _mm_cmpeq_ps(layer.type, _mm_set1_ps((float)MatLambert)));
+                if(_mm_movemask_ps(isDiffuse))
+                {
+                    SimdVector diffuse = scale(lightIntensity, diffuseBSDF);
+                    layerValue = select(isDiffuse, diffuse, layerValue);
+                    layerWeight = select(isDiffuse, layer.albedo[3], layerWeight);
+                    diffuseAlbedo = select(isDiffuse, add(diffuseAlbedo, albedo), diffuseAlbedo);
+                    diffuseIllumination = select(isDiffuse, add(diffuseIllumination, diffuse), diffuseIllumination);
+                }
+
+                // evalEmissiveLayer()
+                __m128 isEmissive = _mm_and_ps(active, _mm_cmpeq_ps(layer.type, _mm_set1_ps((float)MatEmissive)));
+                if(_mm_movemask_ps(isEmissive))
+                {
+                    SimdVector ones = {one, one, one};
+                    layerValue = select(isEmissive, ones, layerValue);
+                    layerWeight = select(isEmissive, one, layerWeight);
+                    diffuseAlbedo = select(isEmissive, add(diffuseAlbedo, ones), diffuseAlbedo);
+                    diffuseIllumination = select(isEmissive, add(diffuseIllumination, albedo), diffuseIllumination);
+                }
+
+                // evalSpecularLayer()
+                __m128 isConductor = _mm_cmpeq_ps(layer.type, _mm_set1_ps((float)MatConductor));
+                __m128 isDielectric = _mm_cmpeq_ps(layer.type, _mm_set1_ps((float)MatDielectric));
+                __m128 isSpecular = _mm_and_ps(active, _mm_or_ps(isConductor, isDielectric));
+                if(_mm_movemask_ps(isSpecular))
+                {
+                    // The albedo is added regardless of facing
+                    specularAlbedo = select(isSpecular, add(specularAlbedo, albedo), specularAlbedo);
+
+                    __m128 isBeckmann = _mm_cmpeq_ps(layer.ndf, _mm_set1_ps((float)NDFBeckmann));
+                    __m128 isGGX = _mm_cmpeq_ps(layer.ndf, _mm_set1_ps((float)NDFGGX));
+                    __m128 D = one;
+                    if(_mm_movemask_ps(_mm_and_ps(isSpecular, isBeckmann)))
+                    {
+                        D = select(isBeckmann, evalBeckmannDistribution(h, layer), D);
+                    }
+                    if(_mm_movemask_ps(_mm_and_ps(isSpecular, isGGX)))
+                    {
+                        D = select(isGGX, evalGGXDistribution(h, layer), D);
+                    }
+
+                    // evalMicrofacetTerms()
+                    __m128 G = _mm_mul_ps(GSmith(vTg, h, layer, isBeckmann), GSmith(lTg, h, layer, isBeckmann));
+                    G = _mm_and_ps(_mm_or_ps(isDielectric, sameSide), G);
+
+                    __m128 F = select(isConductor, conductorFresnel(HoE, layer.ior, layer.kappa), _mm_sub_ps(one, dielectricFresnel(HoE, layer.ior)));
+
+                    SimdVector specular;
+                    specular.x = _mm_mul_ps(_mm_div_ps(_mm_mul_ps(_mm_mul_ps(lightIntensity.x, D), G), jacobian), F);
+                    specular.y = _mm_mul_ps(_mm_div_ps(_mm_mul_ps(_mm_mul_ps(lightIntensity.y, D), G), jacobian), F);
+                    specular.z = _mm_mul_ps(_mm_div_ps(_mm_mul_ps(_mm_mul_ps(lightIntensity.z, D), G), jacobian), F);
+
+                    // Transmission is ignored
+                    __m128 lit = _mm_and_ps(isSpecular, _mm_cmpgt_ps(NdL, zero));
+                    layerValue = select(lit, specular, select(isSpecular, zeroVector, layerValue));
+                    layerWeight = select(lit, F, select(isSpecular, zero, layerWeight));
+                    specularAlbedo = select(lit, add(specularAlbedo, albedo), specularAlbedo);
+                    specularIllumination = select(lit, add(specularIllumination, specular), specularIllumination);
+                }
+
+                // blendLayer()
+                SimdVector scaledLayerOut = {_mm_mul_ps(layerValue.x, albedo.x), _mm_mul_ps(layerValue.y, albedo.y), _mm_mul_ps(layerValue.z, albedo.z)};
+                __m128 weight = select(_mm_cmpeq_ps(layer.blending, _mm_set1_ps((float)BlendConstant)), layer.albedo[3], layerWeight);
+                SimdVector mixed;
+                mixed.x = _mm_add_ps(value.x, _mm_mul_ps(weight, _mm_sub_ps(scaledLayerOut.x, value.x)));
+                mixed.y = _mm_add_ps(value.y, _mm_mul_ps(weight, _mm_sub_ps(scaledLayerOut.y, value.y)));
+                mixed.z = _mm_add_ps(value.z, _mm_mul_ps(weight, _mm_sub_ps(scaledLayerOut.z, value.z)));
+                SimdVector blended = select(_mm_cmpeq_ps(layer.blending, _mm_set1_ps((float)BlendAdd)), add(value, scaledLayerOut), mixed);
+                value = select(active, blended, value);
+            }
+
+            storeLanes(results.value, base, laneCount, value);
+            storeLanes(results.diffuseAlbedo, base, laneCount, diffuseAlbedo);
+            storeLanes(results.diffuseIllumination, base, laneCount, diffuseIllumination);
+            storeLanes(results.specularAlbedo, base, laneCount, specularAlbedo);
+            storeLanes(results.specularIllumination, base, laneCount, specularIllumination);
+        }
+    }
+#else
+    void CpuMaterialEvaluator::evaluateRange(const Samples& samples, const Results& results, uint32_t begin, uint32_t end) const
+    {
+        evaluateReferenceRange(samples, results, begin, end);
+    }
+#endif
+
+    void CpuMaterialEvaluator::evaluate(const Samples& samples, const Results& results) const
+    {
+        if(results.value.x == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "CpuMaterialEvaluator::evaluate() - the value output is required");
+            return;
+        }
+
+        // Ranges are multiples of the SIMD width, so only the last one has a partial block
+        uint32_t blockCount = (samples.count + 3) / 4;
+        parallelFor(blockCount, 256, [&](uint32_t begin, uint32_t end)
+        {
+            evaluateRange(samples, results, begin * 4, std::min(end * 4, samples.count));
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Graphics/Material/Material.h"
+
+namespace Falcor
+{
+    /** Evaluates the layered material model (evalMaterial() in ShadingUtils/Shading.h) on the CPU for batches of samples.
+        Samples are passed as structure-of-arrays. Each sample has a material, a shading frame, a view direction and a light direction and intensity, and gets the same outputs as ShadingOutput.
+        Four samples are shaded at once with SSE2, each lane running its own material, and the batch is split between threads with parallelFor().
+        evaluateReference() runs the shader code itself through ShadingUtils/HostShading.h, one sample at a time. It is the ground truth the SIMD path is checked against.
+        Like the host build of the shading headers, textures are not sampled - every material parameter uses its constant color.
+    */
+    class CpuMaterialEvaluator
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuMaterialEvaluator>;
+        using SharedConstPtr = std::shared_ptr<const CpuMaterialEvaluator>;
+
+        /** Three arrays holding the X, Y and Z (or R, G and B) components of a vector
+        */
+        struct InputArray
+        {
+            const float* x = nullptr;
+            const float* y = nullptr;
+            const float* z = nullptr;
+        };
+
+        struct OutputArray
+        {
+            float* x = nullptr;
+            float* y = nullptr;
+            float* z = nullptr;
+        };
+
+        /** A batch of shading samples. Every array holds 'count' elements.
+        */
+        struct Samples
+        {
+            uint32_t count = 0;
+            const uint32_t* pMaterialIndex = nullptr;   ///< Index into the material list the evaluator was created with. If null, all samples use material 0.
+            InputArray normal;                          ///< Shading normal
+            InputArray tangent;                         ///< Optional shading tangent. If null, the tangent frame is built from the normal, like the prepareShadingAttribs() overload without tangents does.
+            InputArray bitangent;                       ///< Shading bitangent. Must be set if the tangent is.
+            InputArray view;                            ///< Direction from the shading point to the eye
+            InputArray light;                           ///< Normalized direction from the shading point to the light (LightAttribs::L)
+            InputArray lightIntensity;                  ///< Optional incident radiance (LightAttribs::lightIntensity). If null, (1, 1, 1) is used.
+        };
+
+        /** Output arrays, matching the fields of ShadingOutput. Only 'value' is required. Every array must hold Samples::count elements.
+        */
+        struct Results
+        {
+            OutputArray value;                          ///< ShadingOutput::finalValue
+            OutputArray diffuseAlbedo;
+            OutputArray diffuseIllumination;
+            OutputArray specularAlbedo;
+            OutputArray specularIllumination;
+        };
+
+        /** Create an evaluator for a list of materials
+            \param[in] materials The materials. Samples reference them by index.
+        */
+        static SharedPtr create(const std::vector<Material::SharedPtr>& materials);
+
+        /** Create an evaluator for a list of material descriptions
+        */
+        static SharedPtr create(const std::vector<MaterialData>& materials);
+
+        /** Evaluate a batch of samples, using SIMD and all worker threads
+        */
+        void evaluate(const Samples& samples, const Results& results) const;
+
+        /** Evaluate a batch of samples with the host build of the shader code, one sample at a time on the calling thread
+        */
+        void evaluateReference(const Samples& samples, const Results& results) const;
+
+        /** Get the number of materials
+        */
+        uint32_t getMaterialCount() const { return (uint32_t)mMaterials.size(); }
+
+        /** A material layer, flattened for SIMD gathers. Public so the implementation's helpers can use it.
+        */
+        struct PackedLayer
+        {
+            float albedo[4];
+            float roughness[2];
+            float ior;
+            float kappa;
+            float type;         ///< The layer's MatXXX type, stored as a float so lanes can be compared without conversions. MatNone for the layers after the last one.
+            float ndf;
+            float blending;
+            float pad;
+        };
+
+    private:
+        CpuMaterialEvaluator(const std::vector<MaterialData>& materials);
+        void evaluateRange(const Samples& samples, const Results& results, uint32_t begin, uint32_t end) const;
+        void evaluateReferenceRange(const Samples& samples, const Results& results, uint32_t begin, uint32_t end) const;
+
+        std::vector<MaterialData> mMaterials;
+        std::vector<PackedLayer> mLayers;   ///< MatMaxLayers per material
+    };
+}
\ No newline at end of file
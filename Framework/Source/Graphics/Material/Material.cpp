@@ -333,10 +333,37 @@ namespace Falcor
         }
     }
 
+    uint32_t Material::replaceTexture(const Texture* pOld, const Texture::SharedPtr& pNew)
+    {
+        uint32_t count = 0;
+        for(uint32_t i = 0; i < arraysize(kTextureSlots); i++)
+        {
+            TexPtr& gpuTex = getTexture(&mData.values, kTextureSlots[i]);
+            if(gpuTex.pTexture.get() == pOld)
+            {
+                pOld->makeNonResident(mpSamplerOverride.get());
+                gpuTex.pTexture = pNew;
+                gpuTex.ptr = 0;
+                count++;
+            }
+        }
+
+        // The new texture might have a different channel count
+        if(mData.values.normalMap.texture.pTexture == pNew)
+        {
+            setNormalValue(mData.values.normalMap);
+        }
+        return count;
+    }
+
     void Material::setNormalValue(const MaterialValue& normal)
     {
         mData.values.normalMap = normal; 
-        mData.desc.hasNormalMap = normal.texture.pTexture ? true : false; 
+        mData.desc.hasNormalMap = NormalMapNone;
+        if(normal.texture.pTexture)
+        {
+            mData.desc.hasNormalMap = (getFormatChannelCount(normal.texture.pTexture->getFormat()) == 2) ? NormalMapRG : NormalMapRGB;
+        }
         mDescDirty = true;
     }
 
@@ -150,7 +150,7 @@ namespace Falcor
 		*/
 		void removeLayer(uint32_t layerIdx);
         
-        /** Set the normal map value
+        /** Set the normal map value. Two-channel textures are flagged as NormalMapRG, and the shader reconstructs Z for them.
         */
         void setNormalValue(const MaterialValue& normal);
     
@@ -220,6 +220,13 @@ namespace Falcor
         */
         void unloadTextures() const;
 
+        /** Replace a texture in all the slots which reference it. Used by the TextureStreamer to swap in a version of the texture with a different number of mip-levels.
+            \param[in] pOld The texture to replace
+            \param[in] pNew The new texture. Should have the same dimensions-ratio and format, since the material desc is not updated.
+            \return The number of slots which were updated
+        */
+        uint32_t replaceTexture(const Texture* pOld, const Texture::SharedPtr& pNew);
+
         /** Comparison operator
         */
         bool operator==(const Material& other) const;
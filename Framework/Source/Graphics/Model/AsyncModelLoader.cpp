@@ -0,0 +1,168 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AsyncModelLoader.h"
+#include <algorithm>
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    AsyncModelLoader::UniquePtr AsyncModelLoader::create(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount)
+    {
+        return create(filenames, modelLoadFlags, threadCount, &Model::readFile, &Model::createFromFileData);
+    }
+
+    AsyncModelLoader::UniquePtr AsyncModelLoader::create(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount, const ReadFunc& readFunc, const CreateFunc& createFunc)
+    {
+        return UniquePtr(new AsyncModelLoader(filenames, modelLoadFlags, threadCount, readFunc, createFunc));
+    }
+
+    AsyncModelLoader::AsyncModelLoader(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount, const ReadFunc& readFunc, const CreateFunc& createFunc) :
+        mFilenames(filenames), mModelLoadFlags(modelLoadFlags), mReadFunc(readFunc), mCreateFunc(createFunc)
+    {
+        if(threadCount == 0)
+        {
+            // hardware_concurrency() returns 0 when the count is unknown
+            threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+        threadCount = std::min(threadCount, std::max(1u, (uint32_t)mFilenames.size()));
+        mMaxReadAhead = threadCount * 2;
+
+        for(uint32_t i = 0; i < threadCount; i++)
+        {
+            mWorkers.push_back(std::thread(&AsyncModelLoader::workerFunc, this));
+        }
+    }
+
+    AsyncModelLoader::~AsyncModelLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mFileCreatedCV.notify_all();
+        for(auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    void AsyncModelLoader::workerFunc()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(true)
+        {
+            // Files which are being read count against the read-ahead limit too, so wait for update() to create models before starting a new file
+            mFileCreatedCV.wait(lock, [this] {return mStopping || (mNextFileIndex - mLoadedCount < mMaxReadAhead); });
+            if(mStopping || (mNextFileIndex == mFilenames.size()))
+            {
+                break;
+            }
+
+            uint32_t fileIndex = mNextFileIndex++;
+            lock.unlock();
+            Model::FileData::UniquePtr pData = mReadFunc(mFilenames[fileIndex], mModelLoadFlags);
+            lock.lock();
+
+            mReadFiles.push_back(std::make_pair(fileIndex, std::move(pData)));
+            mFileReadCV.notify_one();
+        }
+    }
+
+    bool AsyncModelLoader::createNextModel(bool wait, const LoadedCallback& callback)
+    {
+        std::pair<uint32_t, Model::FileData::UniquePtr> file;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if(wait)
+            {
+                mFileReadCV.wait(lock, [this] {return mReadFiles.empty() == false; });
+            }
+            else if(mReadFiles.empty())
+            {
+                return false;
+            }
+            file.first = mReadFiles.front().first;
+            file.second = std::move(mReadFiles.front().second);
+            mReadFiles.pop_front();
+        }
+
+        Model::SharedPtr pModel = file.second ? mCreateFunc(file.second.get()) : nullptr;
+        file.second = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mLoadedCount++;
+        }
+        mFileCreatedCV.notify_all();
+
+        if(callback)
+        {
+            callback(file.first, pModel);
+        }
+        return true;
+    }
+
+    void AsyncModelLoader::update(float timeBudgetInMs, const LoadedCallback& callback)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        while(isComplete() == false)
+        {
+            if(createNextModel(false, callback) == false)
+            {
+                break;
+            }
+            if(CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) >= timeBudgetInMs)
+            {
+                break;
+            }
+        }
+    }
+
+    void AsyncModelLoader::finish(const LoadedCallback& callback)
+    {
+        while(isComplete() == false)
+        {
+            createNextModel(true, callback);
+        }
+    }
+
+    std::vector<uint32_t> AsyncModelLoader::calcLoadOrder(const std::vector<float>& distances, const std::vector<uint64_t>& fileSizes)
+    {
+        std::vector<uint32_t> order(distances.size());
+        for(uint32_t i = 0; i < (uint32_t)order.size(); i++)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+        {
+            return (distances[a] != distances[b]) ? (distances[a] < distances[b]) : (fileSizes[a] < fileSizes[b]);
+        });
+        return order;
+    }
+}
\ No newline at end of file
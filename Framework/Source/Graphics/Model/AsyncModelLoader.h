@@ -0,0 +1,125 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Model.h"
+
+namespace Falcor
+{
+    /** Loads model files in the background.
+        Worker threads read the files in the order they were given (see Model::readFile()). update() creates the GPU resources of the files which were read, on the calling thread, within a time budget. The number of files which were read but not created yet is bounded, so reading never runs far ahead of update().
+    */
+    class AsyncModelLoader
+    {
+    public:
+        using UniquePtr = std::unique_ptr<AsyncModelLoader>;
+
+        /** Called by update() for each file. pModel is nullptr if the file failed to load.
+        */
+        using LoadedCallback = std::function<void(uint32_t fileIndex, const Model::SharedPtr& pModel)>;
+
+        /** Start loading files
+            \param[in] filenames The files to load. Files are read in this order.
+            \param[in] modelLoadFlags Flags controlling model creation, used for all of the models
+            \param[in] threadCount Number of worker threads. 0 uses one thread per core, minus one for the caller.
+        */
+        static UniquePtr create(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount = 0);
+
+        /** Reads a file on a worker thread. Returns nullptr if the file failed to load.
+        */
+        using ReadFunc = std::function<Model::FileData::UniquePtr(const std::string& filename, uint32_t flags)>;
+
+        /** Creates the model of a file which was read, on the thread calling update()
+        */
+        using CreateFunc = std::function<Model::SharedPtr(const Model::FileData* pData)>;
+
+        /** Start loading files with custom read and create functions, instead of Model::readFile() and Model::createFromFileData()
+            \param[in] filenames The files to load. Files are read in this order.
+            \param[in] modelLoadFlags Flags passed to readFunc
+            \param[in] threadCount Number of worker threads. 0 uses one thread per core, minus one for the caller.
+            \param[in] readFunc Called on the worker threads for each file
+            \param[in] createFunc Called by update() and finish() for each file which was read successfully
+        */
+        static UniquePtr create(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount, const ReadFunc& readFunc, const CreateFunc& createFunc);
+
+        /** Destructor. Stops the workers. Files which weren't read yet are skipped.
+        */
+        ~AsyncModelLoader();
+
+        /** Create the models of the files which were read. Must be called from the thread which owns the graphics context.
+            \param[in] timeBudgetInMs Stop once this much time was spent. At least one model is created if one is ready.
+            \param[in] callback Called for each file which finished loading
+        */
+        void update(float timeBudgetInMs, const LoadedCallback& callback);
+
+        /** Wait until every file was read and create all of the remaining models
+        */
+        void finish(const LoadedCallback& callback);
+
+        uint32_t getFileCount() const { return (uint32_t)mFilenames.size(); }
+
+        /** Get the number of files which update() reported, including the ones which failed
+        */
+        uint32_t getLoadedCount() const { return mLoadedCount; }
+
+        bool isComplete() const { return mLoadedCount == getFileCount(); }
+
+        /** Order files for loading: the nearest ones first, and among equally near ones the smallest first
+            \param[in] distances The distance of each file's nearest instance from the viewer
+            \param[in] fileSizes The size of each file in bytes
+            \return The file indices in loading order
+        */
+        static std::vector<uint32_t> calcLoadOrder(const std::vector<float>& distances, const std::vector<uint64_t>& fileSizes);
+
+    private:
+        AsyncModelLoader(const std::vector<std::string>& filenames, uint32_t modelLoadFlags, uint32_t threadCount, const ReadFunc& readFunc, const CreateFunc& createFunc);
+        void workerFunc();
+        bool createNextModel(bool wait, const LoadedCallback& callback);
+
+        std::vector<std::string> mFilenames;
+        uint32_t mModelLoadFlags;
+        ReadFunc mReadFunc;
+        CreateFunc mCreateFunc;
+        uint32_t mMaxReadAhead;
+        uint32_t mNextFileIndex = 0;
+        uint32_t mLoadedCount = 0;
+        bool mStopping = false;
+
+        std::deque<std::pair<uint32_t, Model::FileData::UniquePtr>> mReadFiles;
+        std::mutex mMutex;
+        std::condition_variable mFileReadCV;
+        std::condition_variable mFileCreatedCV;
+        std::vector<std::thread> mWorkers;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,496 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuGeometry.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include "glm/mat3x3.hpp"
+#include "glm/matrix.hpp"
+#include "glm/common.hpp"
+#include "Core/VertexLayout.h"
+#include "Data/VertexAttrib.h"
+#include "Utils/OS.h"
+#include "Utils/ParallelFor.h"
+
+namespace Falcor
+{
+    static std::mutex sPageFileMutex;
+    static std::string sPageFilePrefix;
+    static uint32_t sPageFileCounter = 0;
+
+    struct PageChunk
+    {
+        void* pData;
+        size_t size;
+    };
+
+    static std::string createPageFilename()
+    {
+        std::lock_guard<std::mutex> lock(sPageFileMutex);
+        if(sPageFilePrefix.empty())
+        {
+            std::string dir;
+            if(getEnvironemntVariable("TEMP", dir) == false)
+            {
+                dir = getExecutableDirectory();
+            }
+            // Tag the files with the session start time, so that several instances of the application don't collide
+            sPageFilePrefix = dir + "\\FalcorGeometry." + std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count()) + ".";
+        }
+        return sPageFilePrefix + std::to_string(sPageFileCounter++) + ".bin";
+    }
+
+    static bool writePageFile(const std::string& filename, const PageChunk* pChunks, uint32_t chunkCount)
+    {
+        std::ofstream stream(filename, std::ios::binary | std::ios::trunc);
+        for(uint32_t i = 0; i < chunkCount; i++)
+        {
+            stream.write((const char*)pChunks[i].pData, pChunks[i].size);
+        }
+        stream.close();
+
+        if(stream.fail())
+        {
+            std::remove(filename.c_str());
+            Logger::log(Logger::Level::Warning, "CpuGeometry - can't write the page file '" + filename + "'. The data is kept in memory.");
+            return false;
+        }
+        return true;
+    }
+
+    static bool readPageFile(const std::string& filename, const PageChunk* pChunks, uint32_t chunkCount)
+    {
+        std::ifstream stream(filename, std::ios::binary);
+        for(uint32_t i = 0; i < chunkCount; i++)
+        {
+            stream.read((char*)pChunks[i].pData, pChunks[i].size);
+        }
+        bool success = stream.good();
+        stream.close();
+        std::remove(filename.c_str());
+
+        if(success == false)
+        {
+            Logger::log(Logger::Level::Error, "CpuGeometry - can't read the page file '" + filename + "'. The data is lost, falling back to the GPU buffers.");
+        }
+        return success;
+    }
+
+    static uint32_t getFloatComponentCount(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::R32Float:
+            return 1;
+        case ResourceFormat::RG32Float:
+            return 2;
+        case ResourceFormat::RGB32Float:
+            return 3;
+        case ResourceFormat::RGBA32Float:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    // The value a component we don't store must have for the copy to be exact. Only the W of positions is 1.
+    static float getDefaultComponent(uint32_t shaderLocation, uint32_t component)
+    {
+        return (shaderLocation == VERTEX_POSITION_LOC && component == 3) ? 1.0f : 0.0f;
+    }
+
+    template<typename VecType>
+    static bool captureAttribute(uint32_t shaderLocation, const uint8_t* pSrc, uint32_t stride, uint32_t componentCount, uint32_t vertexCount, std::vector<VecType>& dst)
+    {
+        const uint32_t keptCount = (std::min)(componentCount, (uint32_t)(sizeof(VecType) / sizeof(float)));
+        dst.assign(vertexCount, VecType(0));
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            const float* pValue = (const float*)(pSrc + size_t(v) * stride);
+            for(uint32_t c = 0; c < keptCount; c++)
+            {
+                dst[v][c] = pValue[c];
+            }
+            for(uint32_t c = keptCount; c < componentCount; c++)
+            {
+                if(pValue[c] != getDefaultComponent(shaderLocation, c))
+                {
+                    std::vector<VecType>().swap(dst);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template<typename VecType>
+    static void writeAttribute(uint32_t shaderLocation, const std::vector<VecType>& src, uint32_t componentCount, uint8_t* pDst, uint32_t stride)
+    {
+        const uint32_t keptCount = (std::min)(componentCount, (uint32_t)(sizeof(VecType) / sizeof(float)));
+        for(size_t v = 0; v < src.size(); v++)
+        {
+            float* pValue = (float*)(pDst + v * stride);
+            for(uint32_t c = 0; c < keptCount; c++)
+            {
+                pValue[c] = src[v][c];
+            }
+            for(uint32_t c = keptCount; c < componentCount; c++)
+            {
+                pValue[c] = getDefaultComponent(shaderLocation, c);
+            }
+        }
+    }
+
+    template<typename VecType>
+    static void freeVector(std::vector<VecType>& v)
+    {
+        std::vector<VecType>().swap(v);
+    }
+
+    CpuGeometry::VertexData::SharedPtr CpuGeometry::VertexData::create(uint32_t vertexCount)
+    {
+        return SharedPtr(new VertexData(vertexCount));
+    }
+
+    CpuGeometry::VertexData::~VertexData()
+    {
+        if(mPageFile.size())
+        {
+            std::remove(mPageFile.c_str());
+        }
+    }
+
+    bool CpuGeometry::VertexData::addAttribute(uint32_t shaderLocation, ResourceFormat format, const void* pData, uint32_t stride)
+    {
+        assert(mResidency == Residency::Keep);
+        const uint32_t componentCount = getFloatComponentCount(format);
+        if(componentCount == 0)
+        {
+            return false;
+        }
+
+        const uint8_t* pSrc = (const uint8_t*)pData;
+        switch(shaderLocation)
+        {
+        case VERTEX_POSITION_LOC:
+            mHasPositions = captureAttribute(shaderLocation, pSrc, stride, componentCount, mVertexCount, mPositions);
+            return mHasPositions;
+        case VERTEX_NORMAL_LOC:
+            mHasNormals = captureAttribute(shaderLocation, pSrc, stride, componentCount, mVertexCount, mNormals);
+            return mHasNormals;
+        case VERTEX_TEXCOORD_LOC:
+            mHasTexCoords = captureAttribute(shaderLocation, pSrc, stride, componentCount, mVertexCount, mTexCoords);
+            return mHasTexCoords;
+        default:
+            return false;
+        }
+    }
+
+    void CpuGeometry::VertexData::addVertexBuffer(const VertexLayout* pLayout, const void* pData, uint32_t stride)
+    {
+        for(uint32_t i = 0; i < pLayout->getElementCount(); i++)
+        {
+            const uint8_t* pElement = (const uint8_t*)pData + pLayout->getElementOffset(i);
+            addAttribute(pLayout->getElementShaderLocation(i), pLayout->getElementFormat(i), pElement, stride);
+        }
+    }
+
+    bool CpuGeometry::VertexData::hasAttribute(uint32_t shaderLocation) const
+    {
+        switch(shaderLocation)
+        {
+        case VERTEX_POSITION_LOC:
+            return mHasPositions;
+        case VERTEX_NORMAL_LOC:
+            return mHasNormals;
+        case VERTEX_TEXCOORD_LOC:
+            return mHasTexCoords;
+        default:
+            return false;
+        }
+    }
+
+    bool CpuGeometry::VertexData::readAttribute(uint32_t shaderLocation, ResourceFormat format, void* pDst, uint32_t stride) const
+    {
+        const uint32_t componentCount = getFloatComponentCount(format);
+        if(componentCount == 0 || hasAttribute(shaderLocation) == false)
+        {
+            return false;
+        }
+
+        makeResident();
+        uint8_t* pDstBytes = (uint8_t*)pDst;
+        switch(shaderLocation)
+        {
+        case VERTEX_POSITION_LOC:
+            writeAttribute(shaderLocation, mPositions, componentCount, pDstBytes, stride);
+            break;
+        case VERTEX_NORMAL_LOC:
+            writeAttribute(shaderLocation, mNormals, componentCount, pDstBytes, stride);
+            break;
+        case VERTEX_TEXCOORD_LOC:
+            writeAttribute(shaderLocation, mTexCoords, componentCount, pDstBytes, stride);
+            break;
+        }
+        // A failed page-in clears the attribute
+        return hasAttribute(shaderLocation);
+    }
+
+    std::vector<glm::vec3> CpuGeometry::VertexData::getAttribute(uint32_t shaderLocation) const
+    {
+        std::vector<glm::vec3> values;
+        if(hasAttribute(shaderLocation))
+        {
+            values.resize(mVertexCount);
+            if(readAttribute(shaderLocation, ResourceFormat::RGB32Float, values.data(), sizeof(glm::vec3)) == false)
+            {
+                values.clear();
+            }
+        }
+        return values;
+    }
+
+    void CpuGeometry::VertexData::transform(const glm::mat4& transform)
+    {
+        makeResident();
+        const glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
+        parallelFor(mVertexCount, 4096, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                if(mHasPositions)
+                {
+                    mPositions[i] = glm::vec3(transform * glm::vec4(mPositions[i], 1.0f));
+                }
+                if(mHasNormals)
+                {
+                    mNormals[i] = normalMatrix * mNormals[i];
+                }
+            }
+        });
+    }
+
+    BoundingBox CpuGeometry::VertexData::calcBoundingBox() const
+    {
+        const std::vector<glm::vec3>& positions = getPositions();
+        if(positions.empty())
+        {
+            return BoundingBox::fromMinMax(glm::vec3(0), glm::vec3(0));
+        }
+
+        glm::vec3 posMin = positions[0];
+        glm::vec3 posMax = positions[0];
+        for(const auto& p : positions)
+        {
+            posMin = glm::min(posMin, p);
+            posMax = glm::max(posMax, p);
+        }
+        return BoundingBox::fromMinMax(posMin, posMax);
+    }
+
+    size_t CpuGeometry::VertexData::getMemorySize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPositions.capacity() * sizeof(glm::vec3) + mNormals.capacity() * sizeof(glm::vec3) + mTexCoords.capacity() * sizeof(glm::vec2);
+    }
+
+    bool CpuGeometry::VertexData::setResidency(Residency residency)
+    {
+        if(mResidency == Residency::Release)
+        {
+            return residency == Residency::Release;
+        }
+
+        switch(residency)
+        {
+        case Residency::Keep:
+            makeResident();
+            break;
+        case Residency::Release:
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                freeVector(mPositions);
+                freeVector(mNormals);
+                freeVector(mTexCoords);
+                mHasPositions = mHasNormals = mHasTexCoords = false;
+                if(mPageFile.size())
+                {
+                    std::remove(mPageFile.c_str());
+                    mPageFile.clear();
+                }
+            }
+            break;
+        case Residency::PageToDisk:
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if(mPageFile.empty())
+                {
+                    const PageChunk chunks[] =
+                    {
+                        {mPositions.data(), mPositions.size() * sizeof(glm::vec3)},
+                        {mNormals.data(), mNormals.size() * sizeof(glm::vec3)},
+                        {mTexCoords.data(), mTexCoords.size() * sizeof(glm::vec2)},
+                    };
+                    std::string filename = createPageFilename();
+                    if(writePageFile(filename, chunks, arraysize(chunks)) == false)
+                    {
+                        return false;
+                    }
+                    mPageFile = filename;
+                    freeVector(mPositions);
+                    freeVector(mNormals);
+                    freeVector(mTexCoords);
+                }
+            }
+            break;
+        default:
+            should_not_get_here();
+        }
+
+        mResidency = residency;
+        return true;
+    }
+
+    void CpuGeometry::VertexData::makeResident() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mPageFile.empty())
+        {
+            return;
+        }
+
+        mPositions.resize(mHasPositions ? mVertexCount : 0);
+        mNormals.resize(mHasNormals ? mVertexCount : 0);
+        mTexCoords.resize(mHasTexCoords ? mVertexCount : 0);
+        const PageChunk chunks[] =
+        {
+            {mPositions.data(), mPositions.size() * sizeof(glm::vec3)},
+            {mNormals.data(), mNormals.size() * sizeof(glm::vec3)},
+            {mTexCoords.data(), mTexCoords.size() * sizeof(glm::vec2)},
+        };
+        if(readPageFile(mPageFile, chunks, arraysize(chunks)) == false)
+        {
+            freeVector(mPositions);
+            freeVector(mNormals);
+            freeVector(mTexCoords);
+            mHasPositions = mHasNormals = mHasTexCoords = false;
+        }
+        mPageFile.clear();
+    }
+
+    CpuGeometry::SharedPtr CpuGeometry::create(const VertexData::SharedPtr& pVertexData, const uint32_t* pIndices, uint32_t indexCount)
+    {
+        assert(pVertexData);
+        return SharedPtr(new CpuGeometry(pVertexData, pIndices, indexCount));
+    }
+
+    CpuGeometry::CpuGeometry(const VertexData::SharedPtr& pVertexData, const uint32_t* pIndices, uint32_t indexCount) : mpVertexData(pVertexData), mIndexCount(indexCount)
+    {
+        mIndices.assign(pIndices, pIndices + indexCount);
+    }
+
+    CpuGeometry::~CpuGeometry()
+    {
+        if(mPageFile.size())
+        {
+            std::remove(mPageFile.c_str());
+        }
+    }
+
+    size_t CpuGeometry::getMemorySize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mIndices.capacity() * sizeof(uint32_t);
+    }
+
+    bool CpuGeometry::setResidency(Residency residency)
+    {
+        bool success = mpVertexData->setResidency(residency);
+        if(mResidency == Residency::Release)
+        {
+            return success && (residency == Residency::Release);
+        }
+
+        switch(residency)
+        {
+        case Residency::Keep:
+            makeResident();
+            break;
+        case Residency::Release:
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                freeVector(mIndices);
+                if(mPageFile.size())
+                {
+                    std::remove(mPageFile.c_str());
+                    mPageFile.clear();
+                }
+            }
+            break;
+        case Residency::PageToDisk:
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if(mPageFile.empty())
+                {
+                    const PageChunk chunk = {mIndices.data(), mIndices.size() * sizeof(uint32_t)};
+                    std::string filename = createPageFilename();
+                    if(writePageFile(filename, &chunk, 1) == false)
+                    {
+                        return false;
+                    }
+                    mPageFile = filename;
+                    freeVector(mIndices);
+                }
+            }
+            break;
+        default:
+            should_not_get_here();
+        }
+
+        mResidency = residency;
+        return success;
+    }
+
+    void CpuGeometry::makeResident() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if(mPageFile.empty())
+        {
+            return;
+        }
+
+        mIndices.resize(mIndexCount);
+        const PageChunk chunk = {mIndices.data(), mIndices.size() * sizeof(uint32_t)};
+        if(readPageFile(mPageFile, &chunk, 1) == false)
+        {
+            freeVector(mIndices);
+        }
+        mPageFile.clear();
+    }
+}
\ No newline at end of file
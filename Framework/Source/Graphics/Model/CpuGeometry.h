@@ -0,0 +1,212 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Core/Formats.h"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    class VertexLayout;
+
+    /** A CPU copy of a mesh's geometry.
+        The importers create it when a model is loaded with Model::KeepCpuGeometry. Mesh#readIndices() and Mesh#readVertexAttribute() read from it instead of reading back the GPU buffers,
+        so CPU algorithms (transforms, export, area-light tables, BVHs) don't stall the pipeline, and can run without touching the GPU at all.
+        Only positions, normals and texture coordinates are kept, in structure-of-arrays layout. An attribute is only captured if the copy is exact - a 32-bit float format whose
+        extra components hold their default values (W = 1 for positions, Z = 0 for texture coordinates, 0 otherwise). Other attributes are still read from the GPU.
+        The vertex data is held by a separate object, so meshes which share vertex buffers share a single copy.
+        Readers page data back in on demand. Changing the residency isn't thread-safe, don't call setResidency() while other threads are reading the data.
+    */
+    class CpuGeometry
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuGeometry>;
+        using SharedConstPtr = std::shared_ptr<const CpuGeometry>;
+
+        /** What to do with the data once the model was loaded
+        */
+        enum class Residency
+        {
+            Keep,           ///< Keep the data in memory
+            Release,        ///< Free the data. Readers fall back to the GPU buffers. This can't be undone.
+            PageToDisk,     ///< Write the data to a temporary file and free the memory. The data is read back the next time it's accessed.
+        };
+
+        /** The vertex attributes of a set of vertex buffers
+        */
+        class VertexData
+        {
+        public:
+            using SharedPtr = std::shared_ptr<VertexData>;
+            using SharedConstPtr = std::shared_ptr<const VertexData>;
+
+            /** Create an empty object
+                \param[in] vertexCount The number of vertices
+            */
+            static SharedPtr create(uint32_t vertexCount);
+            ~VertexData();
+
+            /** Copy an attribute from vertex data
+                \param[in] shaderLocation The attribute's shader location (see Data/VertexAttrib.h). Only positions, normals and texture coordinates are captured.
+                \param[in] format The attribute's format
+                \param[in] pData Pointer to the attribute of the first vertex
+                \param[in] stride The distance in bytes between consecutive vertices
+                \return true if the attribute was captured, otherwise false
+            */
+            bool addAttribute(uint32_t shaderLocation, ResourceFormat format, const void* pData, uint32_t stride);
+
+            /** Copy all the supported attributes of an interleaved vertex buffer
+                \param[in] pLayout The buffer's layout
+                \param[in] pData The buffer's data
+                \param[in] stride The vertex stride
+            */
+            void addVertexBuffer(const VertexLayout* pLayout, const void* pData, uint32_t stride);
+
+            /** Check if an attribute was captured
+            */
+            bool hasAttribute(uint32_t shaderLocation) const;
+
+            /** Write an attribute in a 32-bit float format, as it was stored in the original vertex buffer
+                \param[in] shaderLocation The attribute's shader location
+                \param[in] format The requested format
+                \param[out] pDst The destination. Must hold getVertexCount() elements.
+                \param[in] stride The distance in bytes between consecutive destination elements
+                \return false if the attribute wasn't captured, or if it has more components than the format can reproduce exactly
+            */
+            bool readAttribute(uint32_t shaderLocation, ResourceFormat format, void* pDst, uint32_t stride) const;
+
+            /** Get an attribute as 3 components, matching Mesh#readVertexAttribute()
+                \return The attribute values, or an empty vector if the attribute wasn't captured
+            */
+            std::vector<glm::vec3> getAttribute(uint32_t shaderLocation) const;
+
+            /** Get the number of vertices
+            */
+            uint32_t getVertexCount() const { return mVertexCount; }
+
+            /** Get the positions. Pages the data in if needed.
+            */
+            const std::vector<glm::vec3>& getPositions() const { makeResident(); return mPositions; }
+
+            /** Get the normals. Pages the data in if needed.
+            */
+            const std::vector<glm::vec3>& getNormals() const { makeResident(); return mNormals; }
+
+            /** Get the texture coordinates. Pages the data in if needed.
+            */
+            const std::vector<glm::vec2>& getTexCoords() const { makeResident(); return mTexCoords; }
+
+            /** Permanently transform the positions and normals. Normals are transformed with the inverse-transpose matrix.
+            */
+            void transform(const glm::mat4& transform);
+
+            /** Calculate the bounding-box of all the vertices
+            */
+            BoundingBox calcBoundingBox() const;
+
+            /** Get the number of bytes held in memory
+            */
+            size_t getMemorySize() const;
+
+            /** Check if the data is available. Released data isn't.
+            */
+            bool isAvailable() const { return mResidency != Residency::Release; }
+
+            /** Change the residency of the data
+                \return false if the data couldn't be written to disk. The data stays in memory in that case.
+            */
+            bool setResidency(Residency residency);
+
+        private:
+            VertexData(uint32_t vertexCount) : mVertexCount(vertexCount) {}
+            void makeResident() const;
+
+            uint32_t mVertexCount;
+            mutable bool mHasPositions = false;
+            mutable bool mHasNormals = false;
+            mutable bool mHasTexCoords = false;
+            Residency mResidency = Residency::Keep;
+
+            mutable std::vector<glm::vec3> mPositions;
+            mutable std::vector<glm::vec3> mNormals;
+            mutable std::vector<glm::vec2> mTexCoords;
+            mutable std::string mPageFile;
+            mutable std::mutex mMutex;
+        };
+
+        /** Create a new object
+            \param[in] pVertexData The vertex data. Can be shared with other meshes.
+            \param[in] pIndices The mesh's indices
+            \param[in] indexCount The number of indices
+        */
+        static SharedPtr create(const VertexData::SharedPtr& pVertexData, const uint32_t* pIndices, uint32_t indexCount);
+        ~CpuGeometry();
+
+        /** Get the vertex data
+        */
+        const VertexData::SharedPtr& getVertexData() const { return mpVertexData; }
+
+        /** Get the indices. Pages the data in if needed.
+        */
+        const std::vector<uint32_t>& getIndices() const { makeResident(); return mIndices; }
+
+        /** Get the number of indices
+        */
+        uint32_t getIndexCount() const { return mIndexCount; }
+
+        /** Check if the data is available. Released data isn't.
+        */
+        bool isAvailable() const { return mResidency != Residency::Release; }
+
+        /** Get the number of bytes held in memory by the indices. The vertex data is reported separately, since it can be shared.
+        */
+        size_t getMemorySize() const;
+
+        /** Change the residency of the indices and the vertex data
+            \return false if the data couldn't be written to disk. The data stays in memory in that case.
+        */
+        bool setResidency(Residency residency);
+
+    private:
+        CpuGeometry(const VertexData::SharedPtr& pVertexData, const uint32_t* pIndices, uint32_t indexCount);
+        void makeResident() const;
+
+        VertexData::SharedPtr mpVertexData;
+        uint32_t mIndexCount;
+        Residency mResidency = Residency::Keep;
+
+        mutable std::vector<uint32_t> mIndices;
+        mutable std::string mPageFile;
+        mutable std::mutex mMutex;
+    };
+}
\ No newline at end of file
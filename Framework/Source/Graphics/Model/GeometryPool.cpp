@@ -0,0 +1,423 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "GeometryPool.h"
+#include "Graphics/Model/Mesh.h"
+#include "Graphics/Scene/Scene.h"
+
+namespace Falcor
+{
+    void GeometryPool::DrawList::addDraw(const MeshRange& range, uint32_t instanceCount, uint32_t baseInstance)
+    {
+        DrawItem item;
+        item.range = range;
+        item.instanceCount = instanceCount;
+        item.baseInstance = baseInstance;
+        mItems.push_back(item);
+    }
+
+    GeometryPool::SharedPtr GeometryPool::create(uint32_t initialVertexCount, uint32_t initialIndexCount)
+    {
+        return SharedPtr(new GeometryPool(initialVertexCount, initialIndexCount));
+    }
+
+    GeometryPool::GeometryPool(uint32_t initialVertexCount, uint32_t initialIndexCount) : mInitialVertexCount(initialVertexCount), mInitialIndexCount(initialIndexCount)
+    {
+    }
+
+    std::string GeometryPool::getLayoutKey(const Mesh* pMesh)
+    {
+        const Vao* pVao = pMesh->getVao().get();
+        if(pVao->getIndexBuffer() == nullptr)
+        {
+            return "";
+        }
+
+        std::string key = "t" + std::to_string((uint32_t)pMesh->getTopology());
+        for(uint32_t vb = 0; vb < pVao->getVertexBuffersCount(); vb++)
+        {
+            const VertexLayout* pLayout = pVao->getVertexBufferLayout(vb).get();
+            if(pLayout->getInputClass() == VertexLayout::InputClass::PerInstanceData && pLayout->getInstanceStepRate() != 0)
+            {
+                return "";
+            }
+
+            key += "|s" + std::to_string(pVao->getVertexBufferStride(vb));
+            for(uint32_t e = 0; e < pLayout->getElementCount(); e++)
+            {
+                key += ":" + std::to_string(pLayout->getElementShaderLocation(e)) + "," + std::to_string((uint32_t)pLayout->getElementFormat(e)) + "," + std::to_string(pLayout->getElementOffset(e)) + "," + std::to_string(pLayout->getElementArraySize(e)) + "," + pLayout->getElementName(e);
+            }
+        }
+        return key;
+    }
+
+    uint32_t GeometryPool::findOrCreateBucket(const Mesh* pMesh)
+    {
+        std::string key = getLayoutKey(pMesh);
+        if(key.empty())
+        {
+            return kInvalidBucket;
+        }
+
+        for(uint32_t i = 0; i < (uint32_t)mBuckets.size(); i++)
+        {
+            if(mBuckets[i].layoutKey == key)
+            {
+                return i;
+            }
+        }
+
+        mBuckets.push_back(Bucket());
+        Bucket& bucket = mBuckets.back();
+        bucket.layoutKey = key;
+        bucket.topology = pMesh->getTopology();
+
+        // Copy the layouts. The buffers are created by reallocateBuffers().
+        const Vao* pVao = pMesh->getVao().get();
+        bucket.vertexBuffers.resize(pVao->getVertexBuffersCount());
+        for(uint32_t vb = 0; vb < pVao->getVertexBuffersCount(); vb++)
+        {
+            Vao::VertexBufferDesc& desc = bucket.vertexBuffers[vb];
+            const VertexLayout* pSrcLayout = pVao->getVertexBufferLayout(vb).get();
+            desc.stride = pVao->getVertexBufferStride(vb);
+            for(uint32_t e = 0; e < pSrcLayout->getElementCount(); e++)
+            {
+                desc.pLayout->addElement(pSrcLayout->getElementName(e), pSrcLayout->getElementOffset(e), pSrcLayout->getElementFormat(e), pSrcLayout->getElementArraySize(e), pSrcLayout->getElementShaderLocation(e));
+            }
+        }
+
+        reallocateBuffers(bucket, mInitialVertexCount, mInitialIndexCount);
+        return (uint32_t)mBuckets.size() - 1;
+    }
+
+    void GeometryPool::reallocateBuffers(Bucket& bucket, uint64_t vertexCapacity, uint64_t indexCapacity)
+    {
+        // Grow the buffers, keeping the existing data in place
+        uint64_t oldVertexCapacity = bucket.vertexAllocator.getCapacity();
+        if(vertexCapacity > oldVertexCapacity)
+        {
+            for(auto& desc : bucket.vertexBuffers)
+            {
+                auto pBuffer = Buffer::create(vertexCapacity * desc.stride, Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, nullptr);
+                if(desc.pBuffer && oldVertexCapacity > 0)
+                {
+                    desc.pBuffer->copy(pBuffer.get(), 0, 0, oldVertexCapacity * desc.stride);
+                }
+                desc.pBuffer = pBuffer;
+            }
+            bucket.vertexAllocator.grow(vertexCapacity);
+        }
+
+        uint64_t oldIndexCapacity = bucket.indexAllocator.getCapacity();
+        if(indexCapacity > oldIndexCapacity)
+        {
+            auto pBuffer = Buffer::create(indexCapacity * sizeof(uint32_t), Buffer::BindFlags::Index, Buffer::AccessFlags::Dynamic, nullptr);
+            if(bucket.pIndexBuffer && oldIndexCapacity > 0)
+            {
+                bucket.pIndexBuffer->copy(pBuffer.get(), 0, 0, oldIndexCapacity * sizeof(uint32_t));
+            }
+            bucket.pIndexBuffer = pBuffer;
+            bucket.indexAllocator.grow(indexCapacity);
+        }
+
+        bucket.pVao = Vao::create(bucket.vertexBuffers, bucket.pIndexBuffer, ResourceFormat::R32Uint);
+    }
+
+    bool GeometryPool::reserve(Bucket& bucket, uint32_t vertexCount, uint32_t indexCount)
+    {
+        uint64_t vertexCapacity = bucket.vertexAllocator.getCapacity();
+        uint64_t indexCapacity = bucket.indexAllocator.getCapacity();
+
+        // grow() extends the free range at the end of the resource, so adding the requested size is always enough
+        if(bucket.vertexAllocator.getLargestFreeRange() < vertexCount)
+        {
+            vertexCapacity = std::max(vertexCapacity * 2, vertexCapacity + vertexCount);
+        }
+        if(bucket.indexAllocator.getLargestFreeRange() < indexCount)
+        {
+            indexCapacity = std::max(indexCapacity * 2, indexCapacity + indexCount);
+        }
+
+        if(vertexCapacity > UINT32_MAX || indexCapacity > UINT32_MAX)
+        {
+            Logger::log(Logger::Level::Error, "GeometryPool - bucket size exceeds the 32-bit vertex/index range.");
+            return false;
+        }
+
+        if(vertexCapacity != bucket.vertexAllocator.getCapacity() || indexCapacity != bucket.indexAllocator.getCapacity())
+        {
+            reallocateBuffers(bucket, vertexCapacity, indexCapacity);
+        }
+        return true;
+    }
+
+    const GeometryPool::MeshRange* GeometryPool::addMesh(const Mesh* pMesh)
+    {
+        auto existing = mMeshRanges.find(pMesh);
+        if(existing != mMeshRanges.end())
+        {
+            return &existing->second;
+        }
+
+        if(pMesh->getVertexCount() == 0 || pMesh->getIndexCount() == 0)
+        {
+            Logger::log(Logger::Level::Warning, "GeometryPool::addMesh() - mesh has no vertices or indices.");
+            return nullptr;
+        }
+
+        uint32_t bucketID = findOrCreateBucket(pMesh);
+        if(bucketID == kInvalidBucket)
+        {
+            Logger::log(Logger::Level::Warning, "GeometryPool::addMesh() - mesh can't be pooled. Only indexed meshes without per-instance vertex data are supported.");
+            return nullptr;
+        }
+
+        Bucket& bucket = mBuckets[bucketID];
+        MeshRange range;
+        range.bucketID = bucketID;
+        range.vertexCount = pMesh->getVertexCount();
+        range.indexCount = pMesh->getIndexCount();
+        if(reserve(bucket, range.vertexCount, range.indexCount) == false)
+        {
+            return nullptr;
+        }
+        range.firstVertex = (uint32_t)bucket.vertexAllocator.allocate(range.vertexCount);
+        range.firstIndex = (uint32_t)bucket.indexAllocator.allocate(range.indexCount);
+
+        // Vertex data is copied on the GPU
+        const Vao* pVao = pMesh->getVao().get();
+        for(uint32_t vb = 0; vb < (uint32_t)bucket.vertexBuffers.size(); vb++)
+        {
+            const Vao::VertexBufferDesc& desc = bucket.vertexBuffers[vb];
+            const Buffer* pSrc = pVao->getVertexBuffer(vb).get();
+            size_t size = std::min(pSrc->getSize(), (size_t)range.vertexCount * desc.stride);
+            pSrc->copy(desc.pBuffer.get(), 0, (size_t)range.firstVertex * desc.stride, size);
+        }
+
+        // Indices go through the CPU, since 16-bit indices need to be widened. They stay relative to the mesh, baseVertex takes care of the offset.
+        std::vector<uint32_t> indices = pMesh->readIndices();
+        bucket.pIndexBuffer->updateData(indices.data(), (size_t)range.firstIndex * sizeof(uint32_t), indices.size() * sizeof(uint32_t));
+
+        auto it = mMeshRanges.insert(std::make_pair(pMesh, range)).first;
+        return &it->second;
+    }
+
+    uint32_t GeometryPool::addScene(const Scene* pScene)
+    {
+        uint32_t failed = 0;
+        for(uint32_t m = 0; m < pScene->getModelCount(); m++)
+        {
+            const Model* pModel = pScene->getModel(m).get();
+            for(uint32_t i = 0; i < pModel->getMeshCount(); i++)
+            {
+                if(addMesh(pModel->getMesh(i).get()) == nullptr)
+                {
+                    failed++;
+                }
+            }
+        }
+        return failed;
+    }
+
+    bool GeometryPool::removeMesh(const Mesh* pMesh)
+    {
+        auto it = mMeshRanges.find(pMesh);
+        if(it == mMeshRanges.end())
+        {
+            return false;
+        }
+
+        Bucket& bucket = mBuckets[it->second.bucketID];
+        bucket.vertexAllocator.release(it->second.firstVertex);
+        bucket.indexAllocator.release(it->second.firstIndex);
+        mMeshRanges.erase(it);
+        return true;
+    }
+
+    const GeometryPool::MeshRange* GeometryPool::getMeshRange(const Mesh* pMesh) const
+    {
+        auto it = mMeshRanges.find(pMesh);
+        return (it == mMeshRanges.end()) ? nullptr : &it->second;
+    }
+
+    void GeometryPool::defragment()
+    {
+        for(uint32_t b = 0; b < (uint32_t)mBuckets.size(); b++)
+        {
+            Bucket& bucket = mBuckets[b];
+            std::vector<RangeAllocator::Relocation> vertexMoves = bucket.vertexAllocator.defragment();
+            std::vector<RangeAllocator::Relocation> indexMoves = bucket.indexAllocator.defragment();
+            if(vertexMoves.empty() && indexMoves.empty())
+            {
+                continue;
+            }
+
+            std::unordered_map<uint32_t, uint32_t> vertexRemap;
+            for(const auto& move : vertexMoves)
+            {
+                vertexRemap[(uint32_t)move.srcOffset] = (uint32_t)move.dstOffset;
+            }
+            std::unordered_map<uint32_t, uint32_t> indexRemap;
+            for(const auto& move : indexMoves)
+            {
+                indexRemap[(uint32_t)move.srcOffset] = (uint32_t)move.dstOffset;
+            }
+
+            // Copying inside a buffer with overlapping ranges is undefined on the GPU, so the data goes into new buffers
+            Vao::VertexBufferDescVector oldVertexBuffers = bucket.vertexBuffers;
+            for(auto& desc : bucket.vertexBuffers)
+            {
+                desc.pBuffer = Buffer::create(desc.pBuffer->getSize(), Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, nullptr);
+            }
+            Buffer::SharedPtr pOldIndexBuffer = bucket.pIndexBuffer;
+            bucket.pIndexBuffer = Buffer::create(pOldIndexBuffer->getSize(), Buffer::BindFlags::Index, Buffer::AccessFlags::Dynamic, nullptr);
+
+            for(auto& entry : mMeshRanges)
+            {
+                MeshRange& range = entry.second;
+                if(range.bucketID != b)
+                {
+                    continue;
+                }
+
+                auto vIt = vertexRemap.find(range.firstVertex);
+                uint32_t firstVertex = (vIt == vertexRemap.end()) ? range.firstVertex : vIt->second;
+                for(uint32_t vb = 0; vb < (uint32_t)bucket.vertexBuffers.size(); vb++)
+                {
+                    uint32_t stride = bucket.vertexBuffers[vb].stride;
+                    oldVertexBuffers[vb].pBuffer->copy(bucket.vertexBuffers[vb].pBuffer.get(), (size_t)range.firstVertex * stride, (size_t)firstVertex * stride, (size_t)range.vertexCount * stride);
+                }
+
+                auto iIt = indexRemap.find(range.firstIndex);
+                uint32_t firstIndex = (iIt == indexRemap.end()) ? range.firstIndex : iIt->second;
+                pOldIndexBuffer->copy(bucket.pIndexBuffer.get(), (size_t)range.firstIndex * sizeof(uint32_t), (size_t)firstIndex * sizeof(uint32_t), (size_t)range.indexCount * sizeof(uint32_t));
+
+                range.firstVertex = firstVertex;
+                range.firstIndex = firstIndex;
+            }
+
+            bucket.pVao = Vao::create(bucket.vertexBuffers, bucket.pIndexBuffer, ResourceFormat::R32Uint);
+        }
+    }
+
+    void GeometryPool::buildDrawArguments(const std::vector<DrawItem>& items, std::vector<DrawBatch>& batches, std::vector<DrawArguments>& args)
+    {
+        batches.clear();
+        args.resize(items.size());
+        if(items.empty())
+        {
+            return;
+        }
+
+        // Counting sort by bucket. It's stable, so the draws keep the order the user added them in.
+        uint32_t bucketCount = 0;
+        for(const auto& item : items)
+        {
+            bucketCount = std::max(bucketCount, item.range.bucketID + 1);
+        }
+
+        std::vector<uint32_t> offsets(bucketCount + 1, 0);
+        for(const auto& item : items)
+        {
+            offsets[item.range.bucketID + 1]++;
+        }
+        for(uint32_t b = 0; b < bucketCount; b++)
+        {
+            if(offsets[b + 1] > 0)
+            {
+                DrawBatch batch;
+                batch.bucketID = b;
+                batch.firstDraw = offsets[b];
+                batch.drawCount = offsets[b + 1];
+                batches.push_back(batch);
+            }
+            offsets[b + 1] += offsets[b];
+        }
+
+        for(const auto& item : items)
+        {
+            DrawArguments& a = args[offsets[item.range.bucketID]++];
+            a.indexCount = item.range.indexCount;
+            a.instanceCount = item.instanceCount;
+            a.firstIndex = item.range.firstIndex;
+            a.baseVertex = (int32_t)item.range.firstVertex;
+            a.baseInstance = item.baseInstance;
+        }
+    }
+
+    void GeometryPool::submit(RenderContext* pContext, DrawList& drawList) const
+    {
+        buildDrawArguments(drawList.mItems, drawList.mBatches, drawList.mArgs);
+        if(drawList.mArgs.empty())
+        {
+            return;
+        }
+
+        size_t argSize = drawList.mArgs.size() * sizeof(DrawArguments);
+        if(drawList.mpArgBuffer == nullptr || drawList.mpArgBuffer->getSize() < argSize)
+        {
+            // Round up to avoid reallocating every time a draw is added
+            size_t capacity = sizeof(DrawArguments) * 64;
+            while(capacity < argSize)
+            {
+                capacity *= 2;
+            }
+            drawList.mpArgBuffer = Buffer::create(capacity, Buffer::BindFlags::IndirectArgs, Buffer::AccessFlags::Dynamic, nullptr);
+        }
+        drawList.mpArgBuffer->updateData(drawList.mArgs.data(), 0, argSize);
+
+        for(const auto& batch : drawList.mBatches)
+        {
+            const Bucket& bucket = mBuckets[batch.bucketID];
+            pContext->setTopology(bucket.topology);
+            pContext->setVao(bucket.pVao);
+            pContext->multiDrawIndexedIndirect(drawList.mpArgBuffer.get(), batch.drawCount, batch.firstDraw * sizeof(DrawArguments));
+        }
+    }
+
+    GeometryPool::Stats GeometryPool::getStats() const
+    {
+        Stats stats;
+        stats.bucketCount = (uint32_t)mBuckets.size();
+        stats.meshCount = (uint32_t)mMeshRanges.size();
+        for(const auto& bucket : mBuckets)
+        {
+            uint64_t vertexSize = 0;
+            for(const auto& desc : bucket.vertexBuffers)
+            {
+                vertexSize += desc.stride;
+            }
+            stats.vertexBytesUsed += bucket.vertexAllocator.getUsedSize() * vertexSize;
+            stats.vertexBytesAllocated += bucket.vertexAllocator.getCapacity() * vertexSize;
+            stats.indexBytesUsed += bucket.indexAllocator.getUsedSize() * sizeof(uint32_t);
+            stats.indexBytesAllocated += bucket.indexAllocator.getCapacity() * sizeof(uint32_t);
+            stats.maxFragmentation = std::max(stats.maxFragmentation, std::max(bucket.vertexAllocator.getFragmentation(), bucket.indexAllocator.getFragmentation()));
+        }
+        return stats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Core/VAO.h"
+#include "Core/RenderContext.h"
+#include "Utils/RangeAllocator.h"
+
+namespace Falcor
+{
+    class Mesh;
+    class Scene;
+
+    /** Scene-wide vertex and index storage.
+        Meshes are copied into a few large buffers instead of owning a VAO each. Meshes with the same vertex layout and topology share a bucket - a set of vertex buffers, a 32-bit index buffer and a single VAO.
+        Every bucket sub-allocates vertex and index ranges with a RangeAllocator. Buffers grow on demand and can be compacted with defragment().
+        A pass collects its draws into a DrawList, and submit() renders each bucket with a single RenderContext#multiDrawIndexedIndirect() call.
+        Only the geometry is pooled. Draws in a batch share the program and the bound uniform buffers, so per-draw data (transforms, material IDs) has to be fetched in the shader using the baseInstance value of the draw.
+        SceneRenderer doesn't use the pool yet and still draws every mesh from its own VAO.
+    */
+    class GeometryPool
+    {
+    public:
+        using SharedPtr = std::shared_ptr<GeometryPool>;
+        using SharedConstPtr = std::shared_ptr<const GeometryPool>;
+
+        static const uint32_t kInvalidBucket = uint32_t(-1);
+
+        /** Indirect draw arguments. The layout matches both DrawElementsIndirectCommand and D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS.
+        */
+        struct DrawArguments
+        {
+            uint32_t indexCount;
+            uint32_t instanceCount;
+            uint32_t firstIndex;
+            int32_t baseVertex;
+            uint32_t baseInstance;
+        };
+
+        /** The location of a mesh inside the pool
+        */
+        struct MeshRange
+        {
+            uint32_t bucketID = kInvalidBucket;
+            uint32_t firstVertex = 0;
+            uint32_t vertexCount = 0;
+            uint32_t firstIndex = 0;
+            uint32_t indexCount = 0;
+        };
+
+        /** A single draw request
+        */
+        struct DrawItem
+        {
+            MeshRange range;
+            uint32_t instanceCount;
+            uint32_t baseInstance;
+        };
+
+        /** A run of draws which use the same bucket and can be submitted with a single multi-draw call
+        */
+        struct DrawBatch
+        {
+            uint32_t bucketID;
+            uint32_t firstDraw;     ///< Index of the first record in the argument array
+            uint32_t drawCount;
+        };
+
+        /** A list of draws for a single pass. The list can be reused between frames to avoid reallocating the argument buffer.
+        */
+        class DrawList
+        {
+        public:
+            /** Remove all the draws. Keeps the allocated memory.
+            */
+            void clear() { mItems.clear(); }
+
+            /** Add a draw
+                \param[in] range The mesh range, as returned from GeometryPool#getMeshRange()
+                \param[in] instanceCount Number of instances to draw
+                \param[in] baseInstance Added to the instance ID. Use it to index per-draw data in the shader.
+            */
+            void addDraw(const MeshRange& range, uint32_t instanceCount, uint32_t baseInstance);
+
+            /** Get the number of draws in the list
+            */
+            uint32_t getDrawCount() const { return (uint32_t)mItems.size(); }
+
+            /** Get the batches generated by the last GeometryPool#submit() call
+            */
+            const std::vector<DrawBatch>& getBatches() const { return mBatches; }
+
+        private:
+            friend class GeometryPool;
+            std::vector<DrawItem> mItems;
+            std::vector<DrawBatch> mBatches;
+            std::vector<DrawArguments> mArgs;
+            Buffer::SharedPtr mpArgBuffer;
+        };
+
+        /** Memory statistics
+        */
+        struct Stats
+        {
+            uint32_t bucketCount = 0;
+            uint32_t meshCount = 0;
+            uint64_t vertexBytesUsed = 0;       ///< Bytes used by live vertex ranges
+            uint64_t vertexBytesAllocated = 0;  ///< Total size of the vertex buffers
+            uint64_t indexBytesUsed = 0;
+            uint64_t indexBytesAllocated = 0;
+            float maxFragmentation = 0;         ///< The highest RangeAllocator#getFragmentation() value of all buckets
+        };
+
+        /** Create a new object
+            \param[in] initialVertexCount The initial vertex capacity of each bucket
+            \param[in] initialIndexCount The initial index capacity of each bucket
+        */
+        static SharedPtr create(uint32_t initialVertexCount = 1 << 18, uint32_t initialIndexCount = 1 << 20);
+
+        /** Copy a mesh into the pool. Adding a mesh which is already in the pool does nothing.
+            The pool doesn't keep a reference to the mesh. Remove the mesh from the pool before releasing it.
+            \return The mesh range, or nullptr if the mesh can't be pooled (empty meshes, non-indexed meshes and meshes with per-instance vertex data)
+        */
+        const MeshRange* addMesh(const Mesh* pMesh);
+
+        /** Add all the meshes used by a scene
+            \return The number of meshes which couldn't be pooled
+        */
+        uint32_t addScene(const Scene* pScene);
+
+        /** Remove a mesh and release its ranges
+            \return false if the mesh is not in the pool, otherwise true
+        */
+        bool removeMesh(const Mesh* pMesh);
+
+        /** Get the range of a mesh, or nullptr if the mesh is not in the pool
+        */
+        const MeshRange* getMeshRange(const Mesh* pMesh) const;
+
+        /** Compact all the buckets, so that each has a single free range. This copies the live data into new buffers and updates the mesh ranges.
+            Ranges previously added to a DrawList are invalidated.
+        */
+        void defragment();
+
+        /** Render a draw list. Sets the VAO and topology of each bucket and issues one multi-draw call per batch. The program and uniform buffers should already be bound.
+        */
+        void submit(RenderContext* pContext, DrawList& drawList) const;
+
+        /** Get the number of buckets
+        */
+        uint32_t getBucketCount() const { return (uint32_t)mBuckets.size(); }
+
+        /** Get a bucket's VAO
+        */
+        const Vao::SharedPtr& getBucketVao(uint32_t bucketID) const { return mBuckets[bucketID].pVao; }
+
+        /** Get a bucket's topology
+        */
+        RenderContext::Topology getBucketTopology(uint32_t bucketID) const { return mBuckets[bucketID].topology; }
+
+        /** Get memory statistics
+        */
+        Stats getStats() const;
+
+        /** Sort draw items by bucket and generate the indirect arguments. Doesn't touch the GPU.
+            \param[in] items The draw items. Items in the same bucket keep their relative order.
+            \param[out] batches One batch per bucket used by the items, sorted by bucket ID
+            \param[out] args The draw arguments, laid out contiguously per batch
+        */
+        static void buildDrawArguments(const std::vector<DrawItem>& items, std::vector<DrawBatch>& batches, std::vector<DrawArguments>& args);
+
+    private:
+        GeometryPool(uint32_t initialVertexCount, uint32_t initialIndexCount);
+
+        struct Bucket
+        {
+            std::string layoutKey;
+            RenderContext::Topology topology;
+            Vao::VertexBufferDescVector vertexBuffers;
+            Buffer::SharedPtr pIndexBuffer;
+            Vao::SharedPtr pVao;
+            RangeAllocator vertexAllocator;
+            RangeAllocator indexAllocator;
+        };
+
+        uint32_t findOrCreateBucket(const Mesh* pMesh);
+        bool reserve(Bucket& bucket, uint32_t vertexCount, uint32_t indexCount);
+        void reallocateBuffers(Bucket& bucket, uint64_t vertexCapacity, uint64_t indexCapacity);
+        static std::string getLayoutKey(const Mesh* pMesh);
+
+        uint32_t mInitialVertexCount;
+        uint32_t mInitialIndexCount;
+        std::vector<Bucket> mBuckets;
+        std::unordered_map<const Mesh*, MeshRange> mMeshRanges;
+    };
+}
\ No newline at end of file
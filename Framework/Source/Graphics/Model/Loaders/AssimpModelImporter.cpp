@@ -215,9 +215,17 @@ namespace Falcor
                 }
                 else
                 {
-                    // create a new texture
+                    // create a new texture. Images which readFile() decoded are only uploaded here.
                     std::string fullpath = folder + '\\' + s;
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    const auto& image = mpFileData->images.find(s);
+                    if(image != mpFileData->images.end())
+                    {
+                        pTex = createTextureFromImage(image->second.get(), fullpath);
+                    }
+                    else
+                    {
+                        pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb), (mFlags & Model::GenerateMipsOnCpu) != 0);
+                    }
                     if(pTex)
                     {
                         mpModel->addTexture(pTex);
@@ -412,7 +420,39 @@ namespace Falcor
         return parseAiSceneNode(pRoot, pScene, aiToFalcorMesh);
     }
 
-    bool AssimpModelImporter::initModel(const std::string& filename)
+    AssimpModelImporter::FileData::~FileData() = default;
+
+    static void decodeTextures(const aiScene* pScene, const std::string& modelFolder, uint32_t flags, std::map<std::string, TextureImage::UniqueConstPtr>& images)
+    {
+        // Decode the same files loadTextures() loads, in the same order, so that a file shared by several texture types is decoded for the first one like loadTextures() does.
+        // DDS files are mapped directly into the texture, so there's nothing to decode for them.
+        bool useSrgb = (flags & Model::AssumeLinearSpaceTextures) == 0;
+        bool generateMipsOnCpu = (flags & Model::GenerateMipsOnCpu) != 0;
+        for(uint32_t m = 0; m < pScene->mNumMaterials; m++)
+        {
+            const aiMaterial* pAiMaterial = pScene->mMaterials[m];
+            for(int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
+            {
+                aiTextureType aiType = (aiTextureType)i;
+                if(pAiMaterial->GetTextureCount(aiType) != 1)
+                {
+                    continue;
+                }
+
+                aiString path;
+                pAiMaterial->GetTexture(aiType, 0, &path);
+                std::string s(path.data);
+                std::string fullpath = modelFolder + '\\' + s;
+                if(s.empty() || (images.find(s) != images.end()) || (isBitmapTextureFile(fullpath) == false))
+                {
+                    continue;
+                }
+                images[s] = loadTextureImage(fullpath, true, isSrgbRequired(aiType, useSrgb), generateMipsOnCpu);
+            }
+        }
+    }
+
+    AssimpModelImporter::FileData::UniquePtr AssimpModelImporter::readFile(const std::string& filename, uint32_t flags)
     {
         std::string fullpath;
         if(findFileInDataDirectories(filename, fullpath) == false)
@@ -427,34 +467,52 @@ namespace Falcor
             0;
 
         // aiProcessPreset_TargetRealtime_MaxQuality enabled some optimizations the user might not want
-        if((mFlags & Model::FindDegeneratePrimitives) == 0)
+        if((flags & Model::FindDegeneratePrimitives) == 0)
         {
             AssimpFlags &= ~aiProcess_FindDegenerates;
         }
         // Avoid merging original meshes
-        if((mFlags & Model::DontMergeMeshes) != 0)
+        if((flags & Model::DontMergeMeshes) != 0)
         {
             AssimpFlags &= ~aiProcess_OptimizeGraph;
         }
-        if((mFlags & Model::GenerateTangentSpace) == 0)
+        if((flags & Model::GenerateTangentSpace) == 0)
         {
             AssimpFlags &= ~(aiProcess_CalcTangentSpace);
         }
 
-        Assimp::Importer importer;
-        const aiScene* pScene = importer.ReadFile(fullpath, AssimpFlags);
+        FileData::UniquePtr pData = FileData::UniquePtr(new FileData);
+        pData->filename = filename;
+        pData->fullpath = fullpath;
+        pData->flags = flags;
+        pData->pImporter = std::unique_ptr<Assimp::Importer>(new Assimp::Importer);
+        pData->pScene = pData->pImporter->ReadFile(fullpath, AssimpFlags);
 
-        if((pScene == nullptr) || (verifyScene(pScene) == false))
+        if((pData->pScene == nullptr) || (verifyScene(pData->pScene) == false))
         {
             std::string str("Can't open model file '");
-            str = str + std::string(filename) + "'\n" + importer.GetErrorString();
+            str = str + std::string(filename) + "'\n" + pData->pImporter->GetErrorString();
             Logger::log(Logger::Level::Error, str, true);
-            return false;
+            return nullptr;
         }
 
         // Extract the folder name
         auto last = fullpath.find_last_of("/\\");
         std::string modelFolder = fullpath.substr(0, last);
+        decodeTextures(pData->pScene, modelFolder, flags, pData->images);
+
+        return pData;
+    }
+
+    bool AssimpModelImporter::initModel(const FileData* pData)
+    {
+        const std::string& filename = pData->filename;
+        const aiScene* pScene = pData->pScene;
+        mpFileData = pData;
+
+        // Extract the folder name
+        auto last = pData->fullpath.find_last_of("/\\");
+        std::string modelFolder = pData->fullpath.substr(0, last);
 
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
@@ -474,12 +532,12 @@ namespace Falcor
         return true;
     }
 
-    Model::SharedPtr AssimpModelImporter::createFromFile(const std::string& filename, uint32_t flags)
+    Model::SharedPtr AssimpModelImporter::createFromFileData(const FileData* pData)
     {
-        AssimpModelImporter loader(flags);
+        AssimpModelImporter loader(pData->flags);
 
         // Init the model
-        if(loader.initModel(filename) == false)
+        if(loader.initModel(pData) == false)
         {
             loader.mpModel = nullptr;
         }
@@ -487,6 +545,12 @@ namespace Falcor
         return loader.mpModel;
     }
 
+    Model::SharedPtr AssimpModelImporter::createFromFile(const std::string& filename, uint32_t flags)
+    {
+        FileData::UniquePtr pData = readFile(filename, flags);
+        return pData ? createFromFileData(pData.get()) : nullptr;
+    }
+
     uint32_t AssimpModelImporter::initBone(const aiNode* pCurNode, uint32_t parentID, uint32_t boneID)
     {
         assert(mBoneNameToIdMap.find(pCurNode->mName.C_Str()) != mBoneNameToIdMap.end());
@@ -644,7 +708,8 @@ namespace Falcor
     {
         uint32_t vertexCount = pAiMesh->mNumVertices;
         uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
+        ResourceFormat indexFormat;
+        auto pIB = createIndexBuffer(pAiMesh, indexFormat);
         BoundingBox boundingBox;
 
         bool manualTangentGen = pAiMesh->HasTangentsAndBitangents() == false && (mFlags & Model::GenerateTangentSpace);
@@ -686,7 +751,23 @@ namespace Falcor
         auto pMaterial = mAiMaterialToFalcor[pAiMesh->mMaterialIndex];
         assert(pMaterial);
 
-        Mesh::SharedPtr pMesh = Mesh::create(vbDescVec, vertexCount, pIB, indexCount, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        Mesh::SharedPtr pMesh = Mesh::create(vbDescVec, vertexCount, pIB, indexCount, topology, pMaterial, boundingBox, pAiMesh->HasBones(), indexFormat);
+
+        if(mFlags & Model::KeepCpuGeometry)
+        {
+            auto pVertexData = CpuGeometry::VertexData::create(vertexCount);
+            pVertexData->addAttribute(VERTEX_POSITION_LOC, kLayoutData[VERTEX_POSITION_LOC].format, pAiMesh->mVertices, sizeof(aiVector3D));
+            if(pAiMesh->HasNormals())
+            {
+                pVertexData->addAttribute(VERTEX_NORMAL_LOC, kLayoutData[VERTEX_NORMAL_LOC].format, pAiMesh->mNormals, sizeof(aiVector3D));
+            }
+            if(pAiMesh->HasTextureCoords(0))
+            {
+                pVertexData->addAttribute(VERTEX_TEXCOORD_LOC, kLayoutData[VERTEX_TEXCOORD_LOC].format, pAiMesh->mTextureCoords[0], sizeof(aiVector3D));
+            }
+            std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
+            pMesh->setCpuGeometry(CpuGeometry::create(pVertexData, indices.data(), (uint32_t)indices.size()));
+        }
 
         if(manualTangentGen)
         {
@@ -698,10 +779,10 @@ namespace Falcor
         return pMesh;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
+    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh, ResourceFormat& indexFormat)
     {
         std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
-        auto pBuffer = Buffer::create(uint32_t(sizeof(uint32_t)*indices.size()), Buffer::BindFlags::Index, Buffer::AccessFlags::None, indices.data());
+        auto pBuffer = Mesh::createIndexBuffer(indices.data(), (uint32_t)indices.size(), pAiMesh->mNumVertices, Buffer::AccessFlags::None, indexFormat);
         mpModel->addBuffer(pBuffer);
         return pBuffer;
     }
@@ -31,6 +31,7 @@
 #include "../AnimationController.h"
 #include "../Mesh.h"
 #include "../Model.h"
+#include "Graphics/TextureHelper.h"
 
 struct aiScene;
 struct aiNode;
@@ -38,6 +39,11 @@ struct aiAnimation;
 struct aiMesh;
 struct aiMaterial;
 
+namespace Assimp
+{
+    class Importer;
+}
+
 namespace Falcor
 {
     class Animation;
@@ -48,6 +54,21 @@ namespace Falcor
     class AssimpModelImporter
     {
     public:
+        /** A model file after readFile(). Holds the ASSIMP scene and the decoded textures, but no GPU resources.
+        */
+        struct FileData
+        {
+            using UniquePtr = std::unique_ptr<FileData>;
+            ~FileData();
+
+            std::string filename;
+            std::string fullpath;
+            uint32_t flags = 0;
+            std::unique_ptr<Assimp::Importer> pImporter;                // Owns pScene
+            const aiScene* pScene = nullptr;
+            std::map<std::string, TextureImage::UniqueConstPtr> images; // Decoded textures and their CPU-generated mips, keyed by the path stored in the material. Files which failed to decode have a nullptr entry.
+        };
+
         /** create a new model using ASSIMP
             \param[in] filename Model's filename. Loader will look for it in the data directories.
             \param[in] flags Flags controlling model creation
@@ -55,12 +76,24 @@ namespace Falcor
         */
         static Model::SharedPtr createFromFile(const std::string& filename, uint32_t flags);
 
+        /** Read and post-process a model file and decode its textures. This is the part of createFromFile() which doesn't use the graphics API, so it can run on any thread.
+            \param[in] filename Model's filename. Loader will look for it in the data directories.
+            \param[in] flags Flags controlling model creation
+            returns nullptr if reading failed
+        */
+        static FileData::UniquePtr readFile(const std::string& filename, uint32_t flags);
+
+        /** create a new model from a file read by readFile(). Creates the GPU resources, so it must be called from the thread which owns the graphics context.
+            returns nullptr if loading failed, otherwise a new Model object
+        */
+        static Model::SharedPtr createFromFileData(const FileData* pData);
+
     private:
         AssimpModelImporter(uint32_t flags);
         AssimpModelImporter(const AssimpModelImporter&) = delete;        
         void operator=(const AssimpModelImporter&) = delete;
 
-        bool initModel(const std::string& filename);
+        bool initModel(const FileData* pData);
         bool createDrawList(const aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrnet, const aiScene* pScene, std::map<uint32_t, Mesh::SharedPtr>& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
@@ -74,7 +107,7 @@ namespace Falcor
 
         Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
         bool createVertexLayouts(const aiMesh* pAiMesh, Vao::VertexBufferDescVector& layouts);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
+        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh, ResourceFormat& indexFormat);
         Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, uint32_t vertexCount, BoundingBox& boundingBox, const VertexLayout* pLayout);
         void loadBones(const aiMesh* pAiMesh, uint8_t* pVertexData, uint32_t vertexCount, uint32_t vertexStride);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb);
@@ -91,5 +124,6 @@ namespace Falcor
         uint32_t mBoneIDOffset = 0;
         uint32_t mBoneWeightOffset = 0;
         std::map<const std::string, Texture::SharedPtr> mTextureCache;
+        const FileData* mpFileData = nullptr;
     };
 }
@@ -227,7 +227,7 @@ namespace Falcor
     bool BinaryModelExporter::writeHeader()
     {
         mStream.write("BinScene", 8);
-        mStream << (int32_t)8 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
+        mStream << (int32_t)9 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
         return true;
     }
 
@@ -256,6 +256,7 @@ namespace Falcor
         struct vertexBufferInfo 
         {
             Buffer::SharedPtr pBuffer;
+            std::vector<uint8_t> cpuData;
             size_t            pData; //this had the p flag because it represents the pointer to the vertex buffers data
             uint32_t          stride;
         };
@@ -283,6 +284,21 @@ namespace Falcor
             }
             mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
 
+            vbInfo[i].stride = pLayout->getTotalStride();
+
+            // Use the CPU copy of the geometry if it holds the attribute
+            const CpuGeometry* pCpuGeometry = pMesh->getCpuGeometry().get();
+            if(pCpuGeometry)
+            {
+                vbInfo[i].cpuData.resize(size_t(vbInfo[i].stride) * pMesh->getVertexCount());
+                if(pCpuGeometry->getVertexData()->readAttribute(pLayout->getElementShaderLocation(0), pLayout->getElementFormat(0), vbInfo[i].cpuData.data(), vbInfo[i].stride))
+                {
+                    vbInfo[i].pData = (size_t)vbInfo[i].cpuData.data();
+                    continue;
+                }
+                vbInfo[i].cpuData.clear();
+            }
+
             // Most of the buffers we use were created without any access flags, so can't be mapped.
             // We create a temporary staging buffer to overcome this.
 			const Buffer* pVB = pVao->getVertexBuffer(i).get();
@@ -290,9 +306,6 @@ namespace Falcor
             pVB->copy(vbInfo[i].pBuffer.get());
 
             vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
-
-
-            vbInfo[i].stride = pLayout->getTotalStride();
         }
 
         // Write the vertex buffer
@@ -307,7 +320,10 @@ namespace Falcor
 
         for (auto& a : vbInfo)
 		{
-			a.pBuffer->unmap();
+            if(a.pBuffer)
+            {
+                a.pBuffer->unmap();
+            }
 		}
 
         return true;
@@ -350,16 +366,17 @@ namespace Falcor
 
         mStream << (int32_t)primCount;
 
-        // Output the index buffer
-        // Most of the buffers we use were created without any access flags, so can't be mapped.
-        // We create a temporary staging buffer to overcome this.
-        auto pStaging = Buffer::create(pMesh->getVao()->getIndexBuffer()->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
-        pMesh->getVao()->getIndexBuffer()->copy(pStaging.get());
-
-        const void* pIndices = pStaging->map(Buffer::MapType::Read);
-        mStream.write(pIndices, indexCount * sizeof(uint32_t));
-
-        pStaging->unmap();
+        // Output the index buffer. Meshes which fit in 16-bit indices are stored as such (v9)
+        std::vector<uint32_t> indices = pMesh->readIndices();
+        if(pMesh->getVertexCount() <= Mesh::kMax16BitIndexVertexCount)
+        {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            mStream.write(shortIndices.data(), indexCount * sizeof(uint16_t));
+        }
+        else
+        {
+            mStream.write(indices.data(), indexCount * sizeof(uint32_t));
+        }
 
         return true;
     }
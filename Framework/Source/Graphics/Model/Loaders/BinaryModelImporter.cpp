@@ -39,6 +39,7 @@
 #include "Core/Formats.h"
 #include "Core/Texture.h"
 #include "Graphics/Material/Material.h"
+#include "Utils/ImageProcessing.h"
 #include "glm/geometric.hpp"
 
 namespace Falcor
@@ -453,13 +454,7 @@ namespace Falcor
         // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
         if(bpp == 3)
         {
-            for(int32_t i=texelCount-1;i>=0;--i)
-            {
-                data.data[i * 4 + 0] = data.data[i * 3 + 0];
-                data.data[i * 4 + 1] = data.data[i * 3 + 1];
-                data.data[i * 4 + 2] = data.data[i * 3 + 2];
-                data.data[i * 4 + 3] = 0xff;
-            }
+            ImageProcessing::expandRgbToRgba(data.data.data(), data.data.data(), texelCount);
         }
 
         return true;
@@ -503,7 +498,7 @@ namespace Falcor
     {
         if(std::string(formatID) == "BinScene")
         {
-            if(version < 6 || version > 8)
+            if(version < 6 || version > 9)
             {
                 std::string Msg = "Error when loading model " + modelName + ".\nUnsupported binary scene version " + std::to_string(version);
                 Logger::log(Logger::Level::Error, Msg);
@@ -546,6 +541,8 @@ namespace Falcor
             return ResourceFormat::BC2UnormSrgb;
         case ResourceFormat::BC3Unorm:
             return ResourceFormat::BC3UnormSrgb;
+        case ResourceFormat::BC7Unorm:
+            return ResourceFormat::BC7UnormSrgb;
         default:
             Logger::log(Logger::Level::Warning, "BinaryModelImporter::ConvertFormatToSrgb() warning. Provided format doesn't have a matching sRGB format");
             return format;
@@ -605,6 +602,7 @@ namespace Falcor
         case 6:     numTextureSlots = TextureType_Specular + 1; break;
         case 7:     numTextureSlots = TextureType_Glossiness + 1; break;
         case 8:     numTextureSlots = TextureType_Glossiness + 1; numAttributesType = AttribType_Max; break;
+        case 9:     numTextureSlots = TextureType_Glossiness + 1; numAttributesType = AttribType_Max; break;
         default:
             should_not_get_here();
             return nullptr;
@@ -644,6 +642,8 @@ namespace Falcor
         // create objects
         auto pModel = Model::SharedPtr(new Model());
         bool shouldGenerateTangents = (flags & Model::GenerateTangentSpace) != 0;
+        bool generateMipsOnCpu = (flags & Model::GenerateMipsOnCpu) != 0;
+        bool keepCpuGeometry = (flags & Model::KeepCpuGeometry) != 0;
 
         std::vector<TextureData> texData;
 
@@ -815,6 +815,17 @@ namespace Falcor
                 pModel->addBuffer(vbDescs[i].pBuffer);
 			}
 
+            // The submeshes share the vertex buffers, so they share the CPU copy of the vertices as well
+            CpuGeometry::VertexData::SharedPtr pCpuVertexData;
+            if(keepCpuGeometry)
+            {
+                pCpuVertexData = CpuGeometry::VertexData::create(numVertices);
+                for(int32_t i = 0; i < numAttribs; ++i)
+                {
+                    pCpuVertexData->addVertexBuffer(vbDescs[i].pLayout.get(), buffers[i].data(), vbDescs[i].stride);
+                }
+            }
+
             if(version <= 5)
             {
                 importTextures(texData, numTextures, mStream, mModelName);
@@ -879,7 +890,17 @@ namespace Falcor
                         }
                         else
                         {
-                            auto pTexture = Texture::create2D(texData[texID].width, texData[texID].height, texSig.format, 1, Texture::kEntireMipChain, texSig.pData);
+                            Texture::SharedPtr pTexture;
+                            if(generateMipsOnCpu && ImageProcessing::isMipGenerationSupported(texSig.format))
+                            {
+                                uint32_t mipCount;
+                                std::vector<uint8_t> mipChain = ImageProcessing::generateMipChain(texSig.pData, texData[texID].width, texData[texID].height, texSig.format, ImageProcessing::MipFilter::Box, mipCount);
+                                pTexture = Texture::create2D(texData[texID].width, texData[texID].height, texSig.format, 1, mipCount, mipChain.data());
+                            }
+                            else
+                            {
+                                pTexture = Texture::create2D(texData[texID].width, texData[texID].height, texSig.format, 1, Texture::kEntireMipChain, texSig.pData);
+                            }
                             pTexture->setSourceFilename(texData[texID].name);
                             textures[texSig] = pTexture;
                             pModel->addTexture(pTexture);
@@ -906,13 +927,26 @@ namespace Falcor
                     return nullptr;
                 }
 
-                // create the index buffer
+                // Read the indices. Starting with v9, meshes with a small enough vertex count store 16-bit indices
                 uint32_t numIndices = numTriangles * 3;
                 std::vector<uint32_t> indices(numIndices);
-                uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
-                mStream.read(&indices[0], ibSize);
+                if((version >= 9) && (numVertices <= Mesh::kMax16BitIndexVertexCount))
+                {
+                    std::vector<uint16_t> shortIndices(numIndices);
+                    mStream.read(shortIndices.data(), numIndices * sizeof(uint16_t));
+                    for(uint32_t i = 0; i < numIndices; i++)
+                    {
+                        indices[i] = shortIndices[i];
+                    }
+                }
+                else
+                {
+                    mStream.read(indices.data(), numIndices * sizeof(uint32_t));
+                }
 
-                auto pIB = Buffer::create(ibSize, Buffer::BindFlags::Index, Buffer::AccessFlags::MapRead, indices.data());
+                // create the index buffer
+                ResourceFormat indexFormat;
+                auto pIB = Mesh::createIndexBuffer(indices.data(), numIndices, numVertices, Buffer::AccessFlags::MapRead, indexFormat);
                 pModel->addBuffer(pIB);
 
                 
@@ -965,7 +999,11 @@ namespace Falcor
                 BoundingBox box = BoundingBox::fromMinMax(min, max);
 
                 // create the mesh                
-                auto pMesh = Mesh::create(vbDescs, numVertices, pIB, numIndices, RenderContext::Topology::TriangleList, pMaterial, box, false);
+                auto pMesh = Mesh::create(vbDescs, numVertices, pIB, numIndices, RenderContext::Topology::TriangleList, pMaterial, box, false, indexFormat);
+                if(pCpuVertexData)
+                {
+                    pMesh->setCpuGeometry(CpuGeometry::create(pCpuVertexData, indices.data(), numIndices));
+                }
                 pModel->addMesh(std::move(pMesh));
                 meshToSubmeshesID[meshIdx].push_back(pModel->getMeshCount() - 1);
             }
@@ -30,7 +30,7 @@
 //------------------------------------------------------------------------
 /*
 
-Binary scene file format v8
+Binary scene file format v9
 ---------------------------
 
 - The basic units of data are 32-bit little-endian ints and floats.
@@ -41,7 +41,7 @@ Binary scene file format v8
 
 File
 0       2       string8 v6  formatID            ("BinScene")
-2       1       int     v6  formatVersion       (6)
+2       1       int     v6  formatVersion       (6 .. 9)
 3       1       int     v6  numTextures
 4       1       int     v6  numMeshes
 5       1       int     v6  numInstances
@@ -102,7 +102,7 @@ Submesh
 17      1       int     v4  environmentTexture  (-1 if none)
 18      1       int     v5  specularTexture     (-1 if none)
 19      1       int     v1  numTriangles
-20      n*3     int     v1  indices             (numTriangles * 3)
+20      n*3     int     v1  indices             (numTriangles * 3. Starting with v9, stored as 16-bit uints if the Mesh numVertices <= 0xFFFF)
 ?
 
 Instance
@@ -87,14 +87,15 @@ namespace Falcor
         vbDesc.pBuffer = Buffer::create( vboSz, Buffer::BindFlags::Vertex, Buffer::AccessFlags::None, vboData );
         pModel->addBuffer( vbDesc.pBuffer );
 
-        // Create index buffer and add to the model
-        Buffer::SharedPtr pIB = Buffer::create( idxBufSz, Buffer::BindFlags::Index, Buffer::AccessFlags::MapRead, idxBufData );
-        pModel->addBuffer( pIB );
-
         // Compute more explicit / traditional counts needed internally
         uint32_t numVertices = vboSz / vertexStride;
         uint32_t numIndicies = idxBufSz / (sizeof( uint32_t ));
 
+        // Create index buffer and add to the model. Uses 16-bit indices if the vertex count allows it
+        ResourceFormat indexFormat;
+        Buffer::SharedPtr pIB = Mesh::createIndexBuffer( idxBufData, numIndicies, numVertices, Buffer::AccessFlags::MapRead, indexFormat );
+        pModel->addBuffer( pIB );
+
         // Create a really simple, dumb material for this mesh
         BasicMaterial basicMat;
         if ( diffuseTexture )
@@ -122,7 +123,7 @@ namespace Falcor
         BoundingBox box = BoundingBox::fromMinMax( posMin, posMax );
 
         // create a mesh containing this index & vertex data.
-        Mesh::SharedPtr pMesh = Mesh::create( vbDescVec, numVertices, pIB, numIndicies, geomTopology, pSimpleMaterial, box, false );
+        Mesh::SharedPtr pMesh = Mesh::create( vbDescVec, numVertices, pIB, numIndicies, geomTopology, pSimpleMaterial, box, false, indexFormat );
         pMesh->addInstance( glm::mat4() );      // Add one instance of this mesh, with no transform matrix
         pModel->addMesh( std::move( pMesh ) );  // Add this mesh to the model
 
@@ -49,9 +49,126 @@ namespace Falcor
         RenderContext::Topology topology,
         const Material::SharedPtr& pMaterial,
         const BoundingBox& boundingBox,
-        bool hasBones)
+        bool hasBones,
+        ResourceFormat indexFormat)
     {
-        return SharedPtr(new Mesh(vertexBuffers, vertexCount, pIndexBuffer, indexCount, topology, pMaterial, boundingBox, hasBones));
+        return SharedPtr(new Mesh(vertexBuffers, vertexCount, pIndexBuffer, indexCount, topology, pMaterial, boundingBox, hasBones, indexFormat));
+    }
+
+    Buffer::SharedPtr Mesh::createIndexBuffer(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, Buffer::AccessFlags accessFlags, ResourceFormat& indexFormat)
+    {
+        indexFormat = getCompactIndexFormat(vertexCount);
+        if(indexFormat == ResourceFormat::R16Uint)
+        {
+            std::vector<uint16_t> shortIndices(indexCount);
+            for(uint32_t i = 0; i < indexCount; i++)
+            {
+                assert(pIndices[i] < vertexCount);
+                shortIndices[i] = (uint16_t)pIndices[i];
+            }
+            return Buffer::create(sizeof(uint16_t) * indexCount, Buffer::BindFlags::Index, accessFlags, shortIndices.data());
+        }
+        return Buffer::create(sizeof(uint32_t) * indexCount, Buffer::BindFlags::Index, accessFlags, pIndices);
+    }
+
+    std::vector<uint32_t> Mesh::readIndices() const
+    {
+        if(mpCpuGeometry && mpCpuGeometry->isAvailable())
+        {
+            // The size doesn't match if the data was lost while paging it in
+            const std::vector<uint32_t>& cpuIndices = mpCpuGeometry->getIndices();
+            if(cpuIndices.size() == mIndexCount)
+            {
+                return cpuIndices;
+            }
+        }
+
+        std::vector<uint32_t> indices(mIndexCount);
+        const Buffer* pIB = mpVao->getIndexBuffer().get();
+        if(pIB == nullptr)
+        {
+            return indices;
+        }
+
+        // Most of the buffers we use were created without any access flags, so can't be mapped.
+        // We create a temporary staging buffer to overcome this.
+        auto pStaging = Buffer::create(pIB->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+        pIB->copy(pStaging.get());
+        const void* pData = pStaging->map(Buffer::MapType::Read);
+
+        if(getIndexFormat() == ResourceFormat::R16Uint)
+        {
+            const uint16_t* pShortIndices = (const uint16_t*)pData;
+            for(uint32_t i = 0; i < mIndexCount; i++)
+            {
+                indices[i] = pShortIndices[i];
+            }
+        }
+        else
+        {
+            memcpy(indices.data(), pData, sizeof(uint32_t) * mIndexCount);
+        }
+
+        pStaging->unmap();
+        return indices;
+    }
+
+    std::vector<glm::vec3> Mesh::readVertexAttribute(uint32_t shaderLocation) const
+    {
+        std::vector<glm::vec3> values;
+        if(mpCpuGeometry)
+        {
+            values = mpCpuGeometry->getVertexData()->getAttribute(shaderLocation);
+            if(values.size())
+            {
+                return values;
+            }
+        }
+
+        const Vao::ElementDesc desc = mpVao->getElementIndexByLocation(shaderLocation);
+        if(desc.vbIndex == Vao::ElementDesc::kInvalidIndex)
+        {
+            return values;
+        }
+
+        const auto& pLayout = mpVao->getVertexBufferLayout(desc.vbIndex);
+        uint32_t componentCount;
+        switch(pLayout->getElementFormat(desc.elementIndex))
+        {
+        case ResourceFormat::R32Float:
+            componentCount = 1;
+            break;
+        case ResourceFormat::RG32Float:
+            componentCount = 2;
+            break;
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA32Float:
+            componentCount = 3;
+            break;
+        default:
+            return values;
+        }
+
+        // The VB was created without access flags, so go through a staging buffer
+        const Buffer* pVB = mpVao->getVertexBuffer(desc.vbIndex).get();
+        const uint32_t stride = mpVao->getVertexBufferStride(desc.vbIndex);
+        const uint32_t offset = pLayout->getElementOffset(desc.elementIndex);
+        auto pStaging = Buffer::create(pVB->getSize(), Buffer::BindFlags::None, Buffer::AccessFlags::MapRead, nullptr);
+        pVB->copy(pStaging.get());
+        const uint8_t* pData = (const uint8_t*)pStaging->map(Buffer::MapType::Read);
+
+        values.resize(mVertexCount, glm::vec3(0));
+        for(uint32_t i = 0; i < mVertexCount; i++)
+        {
+            const float* pSrc = (const float*)(pData + i * stride + offset);
+            for(uint32_t c = 0; c < componentCount; c++)
+            {
+                values[i][c] = pSrc[c];
+            }
+        }
+
+        pStaging->unmap();
+        return values;
     }
 
     Mesh::Mesh(const Vao::VertexBufferDescVector& vertexBuffers,
@@ -61,7 +178,8 @@ namespace Falcor
         RenderContext::Topology topology,
         const Material::SharedPtr& pMaterial,
         const BoundingBox& boundingBox,
-		bool hasBones) : mId(sMeshCounter++)
+		bool hasBones,
+        ResourceFormat indexFormat) : mId(sMeshCounter++)
     {
         mVertexCount = vertexCount;
         uint32_t VertsPerPrim;
@@ -87,11 +205,38 @@ namespace Falcor
         mBoundingBox = boundingBox;
         mHasBones = hasBones;
 
-        mpVao = Vao::create(vertexBuffers, pIndexBuffer);
+        mpVao = Vao::create(vertexBuffers, pIndexBuffer, indexFormat);
+    }
+
+    // Build a vertex buffer's data from the CPU geometry copy. Fails if the copy doesn't hold all of the buffer's elements.
+    static bool buildVertexBufferData(const CpuGeometry::VertexData* pCpuVertices, const VertexLayout* pLayout, uint32_t stride, size_t bufferSize, std::vector<uint8_t>& data)
+    {
+        if(bufferSize != size_t(stride) * pCpuVertices->getVertexCount())
+        {
+            return false;
+        }
+
+        data.assign(bufferSize, 0);
+        for(uint32_t j = 0; j < pLayout->getElementCount(); j++)
+        {
+            if(pCpuVertices->readAttribute(pLayout->getElementShaderLocation(j), pLayout->getElementFormat(j), data.data() + pLayout->getElementOffset(j), stride) == false)
+            {
+                return false;
+            }
+        }
+        return true;
     }
 
     void Mesh::applyTransform(const glm::mat4& Transform) 
     {
+        // Transform the CPU copy first. Vertex buffers it can rebuild are uploaded from it, the rest are read back from the GPU.
+        CpuGeometry::VertexData* pCpuVertices = mpCpuGeometry ? mpCpuGeometry->getVertexData().get() : nullptr;
+        if(pCpuVertices)
+        {
+            pCpuVertices->transform(Transform);
+        }
+        std::vector<uint8_t> cpuData;
+
         // Transform geometry, keeping track of min/max
         glm::vec3 posMin(std::numeric_limits<float>::max(),std::numeric_limits<float>::max(),std::numeric_limits<float>::max());
         glm::vec3 posMax(std::numeric_limits<float>::min(),std::numeric_limits<float>::min(),std::numeric_limits<float>::min());
@@ -102,6 +247,24 @@ namespace Falcor
             Buffer* pBuffer = const_cast<Buffer*>(mpVao->getVertexBuffer(i).get());
             size_t numVerts = pBuffer->getSize() / stride;
 
+            // Skip buffers without positions or normals
+            bool needsTransform = false;
+            for(uint32_t j = 0u; j < pLayout->getElementCount(); ++j)
+            {
+                uint32_t location = pLayout->getElementShaderLocation(j);
+                needsTransform = needsTransform || (location == VERTEX_POSITION_LOC) || (location == VERTEX_NORMAL_LOC);
+            }
+            if(needsTransform == false)
+            {
+                continue;
+            }
+
+            if(pCpuVertices && buildVertexBufferData(pCpuVertices, pLayout.get(), stride, pBuffer->getSize(), cpuData))
+            {
+                pBuffer->updateData(cpuData.data(), 0, cpuData.size(), true);
+                continue;
+            }
+
             float* tempData = new float[(pBuffer->getSize()+sizeof(float)-1)/sizeof(float)];
             pBuffer->readData(tempData, 0,pBuffer->getSize());
 
@@ -175,7 +338,14 @@ namespace Falcor
         }
 
         // Update bounding box
-        mBoundingBox = BoundingBox::fromMinMax(posMin,posMax);
+        if(pCpuVertices && pCpuVertices->hasAttribute(VERTEX_POSITION_LOC))
+        {
+            mBoundingBox = pCpuVertices->calcBoundingBox();
+        }
+        else
+        {
+            mBoundingBox = BoundingBox::fromMinMax(posMin,posMax);
+        }
 
         // Update instances
         mInstanceBoundingBox.clear();
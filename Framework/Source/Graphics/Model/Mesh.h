@@ -35,6 +35,7 @@
 #include "utils/AABB.h"
 #include "Graphics/Material/Material.h"
 #include "Graphics/Paths/MovableObject.h"
+#include "Graphics/Model/CpuGeometry.h"
 
 namespace Falcor
 {
@@ -65,6 +66,7 @@ namespace Falcor
             \param[in] pMaterial The material of the mesh
             \param[in] BoundingBox The mesh's axis-aligned bounding-box
             \param[in] bHasBones Indicates the the mesh uses bones for animation
+            \param[in] indexFormat The format of the index buffer elements. Either ResourceFormat#R16Uint or ResourceFormat#R32Uint
         */
         static SharedPtr create(const Vao::VertexBufferDescVector& vertexBuffers,
             uint32_t vertexCount,
@@ -73,7 +75,27 @@ namespace Falcor
             RenderContext::Topology topology,
             const Material::SharedPtr& pMaterial,
             const BoundingBox& boundingBox,
-            bool hasBones);
+            bool hasBones,
+            ResourceFormat indexFormat = ResourceFormat::R32Uint);
+
+        /** The largest vertex count that can be addressed with 16-bit indices. We don't use 0xFFFF, since DX11 reserves it as the strip-cut index.
+        */
+        static const uint32_t kMax16BitIndexVertexCount = 0xFFFF;
+
+        /** Get the most compact index format which can address a vertex range
+            \param[in] vertexCount The number of vertices the indices point into
+            \return ResourceFormat#R16Uint if the vertex count allows it, otherwise ResourceFormat#R32Uint
+        */
+        static ResourceFormat getCompactIndexFormat(uint32_t vertexCount) { return (vertexCount <= kMax16BitIndexVertexCount) ? ResourceFormat::R16Uint : ResourceFormat::R32Uint; }
+
+        /** Create an index buffer, narrowing the indices to 16-bit when the vertex range allows it. Importers should use this function to create their index buffers.
+            \param[in] pIndices The indices
+            \param[in] indexCount Number of indices
+            \param[in] vertexCount The number of vertices the indices point into
+            \param[in] accessFlags The buffer's CPU access flags
+            \param[out] indexFormat The format the buffer was created with
+        */
+        static Buffer::SharedPtr createIndexBuffer(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, Buffer::AccessFlags accessFlags, ResourceFormat& indexFormat);
 
         /** Destructor
         */
@@ -97,6 +119,30 @@ namespace Falcor
         */
         uint32_t getIndexCount() const { return mIndexCount; }
 
+        /** Get the format of the index buffer elements
+        */
+        ResourceFormat getIndexFormat() const { return mpVao->getIndexBufferFormat(); }
+
+        /** Read the index buffer back from the GPU. 16-bit indices are expanded, so the result is always 32-bit.
+            If the mesh has a CPU geometry copy, the indices are read from it. Otherwise this function stalls the pipeline, so avoid calling it every frame.
+        */
+        std::vector<uint32_t> readIndices() const;
+
+        /** Read a float vertex attribute back from the GPU, as 3 components. Missing components are set to zero.
+            If the mesh has a CPU geometry copy which holds the attribute, it is read from it. Otherwise this function stalls the pipeline, so avoid calling it every frame.
+            \param[in] shaderLocation The attribute's shader location (see Data/VertexAttrib.h)
+            \return The attribute values, one per vertex. Empty if the mesh doesn't have the attribute or it's not a float format.
+        */
+        std::vector<glm::vec3> readVertexAttribute(uint32_t shaderLocation) const;
+
+        /** Attach a CPU copy of the geometry. The importers do it when the model is loaded with Model::KeepCpuGeometry.
+        */
+        void setCpuGeometry(const CpuGeometry::SharedPtr& pCpuGeometry) { mpCpuGeometry = pCpuGeometry; }
+
+        /** Get the CPU copy of the geometry, or nullptr if the mesh doesn't have one
+        */
+        const CpuGeometry::SharedPtr& getCpuGeometry() const { return mpCpuGeometry; }
+
         /** Get a pointer to the mesh's material
         */
         const Material::SharedPtr& getMaterial() const { return mpMaterial; }
@@ -165,7 +211,8 @@ namespace Falcor
             RenderContext::Topology topology,
             const Material::SharedPtr& pMaterial,
             const BoundingBox& boundingBox,
-            bool hasBones);
+            bool hasBones,
+            ResourceFormat indexFormat);
 
 		static uint32_t sMeshCounter;
 
@@ -179,6 +226,7 @@ namespace Falcor
         BoundingBox mBoundingBox;
 
         Vao::SharedPtr mpVao;
+        CpuGeometry::SharedPtr mpCpuGeometry;
         std::vector<glm::mat4> mInstanceMatrices;
         std::vector<glm::mat4> mOriginalInstanceMatrices;
         bool mDirty = true;
@@ -41,6 +41,12 @@
 #include "Utils/StringUtils.h"
 #include "Graphics/Camera/Camera.h"
 #include "core/VAO.h"
+#include "Utils/TextureCompressor.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/ParallelFor.h"
+#include <condition_variable>
+#include <future>
+#include <mutex>
 
 namespace Falcor
 {
@@ -89,17 +95,144 @@ namespace Falcor
 
         if(pModel)
         {
-            if(flags & CompressTextures)
+            pModel->finishLoading(flags);
+        }
+
+        return pModel;
+    }
+
+    void Model::finishLoading(uint32_t flags)
+    {
+        if(flags & CompressTextures)
+        {
+            compressAllTextures();
+        }
+
+        calculateModelProperties();
+    }
+
+    /** Binary models are parsed by their importer while it creates the GPU resources, so reading one only brings the file into the OS file cache
+    */
+    class ModelFileData : public Model::FileData
+    {
+    public:
+        std::string filename;
+        uint32_t flags = 0;
+        AssimpModelImporter::FileData::UniquePtr pAssimpData;
+    };
+
+    static void prefetchFile(const std::string& filename)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath))
+        {
+            MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(fullpath, false);
+            if(pFile)
+            {
+                pFile->prefetch(0, pFile->getSize());
+            }
+        }
+    }
+
+    Model::FileData::UniquePtr Model::readFile(const std::string& filename, uint32_t flags)
+    {
+        std::unique_ptr<ModelFileData> pData(new ModelFileData);
+        pData->filename = filename;
+        pData->flags = flags;
+        if(hasSuffix(filename, ".bin", false))
+        {
+            prefetchFile(filename);
+        }
+        else
+        {
+            pData->pAssimpData = AssimpModelImporter::readFile(filename, flags);
+            if(pData->pAssimpData == nullptr)
             {
-                pModel->compressAllTextures();
+                return nullptr;
             }
+        }
+        return std::move(pData);
+    }
 
-            pModel->calculateModelProperties();
+    Model::SharedPtr Model::createFromFileData(const FileData* pData)
+    {
+        const ModelFileData* pModelData = static_cast<const ModelFileData*>(pData);
+        SharedPtr pModel;
+        if(pModelData->pAssimpData)
+        {
+            pModel = AssimpModelImporter::createFromFileData(pModelData->pAssimpData.get());
+        }
+        else
+        {
+            pModel = BinaryModelImporter::createFromFile(pModelData->filename, pModelData->flags);
         }
 
+        if(pModel)
+        {
+            pModel->finishLoading(pModelData->flags);
+        }
         return pModel;
     }
 
+    std::vector<Model::SharedPtr> Model::createFromFiles(const std::vector<std::string>& filenames, uint32_t flags)
+    {
+        const uint32_t count = (uint32_t)filenames.size();
+        std::vector<FileData::UniquePtr> fileData(count);
+        std::vector<bool> isRead(count, false);
+        std::mutex mutex;
+        std::condition_variable readCondition;
+        std::condition_variable createCondition;
+
+        // Like AsyncModelLoader, bound the number of files which were read but not created yet, so that the decoded data doesn't pile up in memory
+        const uint32_t maxReadAhead = getParallelThreadCount() * 2;
+        uint32_t createdCount = 0;
+
+        // Read the files on the worker threads
+        auto reader = std::async(std::launch::async, [&]()
+        {
+            parallelFor(count, 1, [&](uint32_t begin, uint32_t end)
+            {
+                for(uint32_t i = begin; i < end; i++)
+                {
+                    {
+                        // Files are handed out in order, so the file the creation loop waits for is never blocked here
+                        std::unique_lock<std::mutex> lock(mutex);
+                        createCondition.wait(lock, [&]() { return i < createdCount + maxReadAhead; });
+                    }
+                    FileData::UniquePtr pData = readFile(filenames[i], flags);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    fileData[i] = std::move(pData);
+                    isRead[i] = true;
+                    readCondition.notify_all();
+                }
+            });
+        });
+
+        // Create the models in order, each one as soon as it was read
+        std::vector<SharedPtr> models(count);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            FileData::UniquePtr pData;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                readCondition.wait(lock, [&]() { return isRead[i]; });
+                pData = std::move(fileData[i]);
+            }
+            models[i] = pData ? createFromFileData(pData.get()) : nullptr;
+            pData = nullptr;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                createdCount++;
+            }
+            createCondition.notify_all();
+        }
+
+        reader.get();
+        return models;
+    }
+
     void Model::exportToBinaryFile(const std::string& filename)
     {
         if(hasSuffix(filename, ".bin", false) == false)
@@ -217,6 +350,41 @@ namespace Falcor
 		}
 	}
 
+    bool Model::setCpuGeometryResidency(CpuGeometry::Residency residency)
+    {
+        bool success = true;
+        for(const auto& pMesh : mpMeshes)
+        {
+            const auto& pCpuGeometry = pMesh->getCpuGeometry();
+            if(pCpuGeometry)
+            {
+                success = pCpuGeometry->setResidency(residency) && success;
+            }
+        }
+        return success;
+    }
+
+    size_t Model::getCpuGeometryMemorySize() const
+    {
+        std::map<const CpuGeometry::VertexData*, bool> vertexDataFound;
+        size_t size = 0;
+        for(const auto& pMesh : mpMeshes)
+        {
+            const auto& pCpuGeometry = pMesh->getCpuGeometry();
+            if(pCpuGeometry)
+            {
+                size += pCpuGeometry->getMemorySize();
+                const CpuGeometry::VertexData* pVertexData = pCpuGeometry->getVertexData().get();
+                if(vertexDataFound[pVertexData] == false)
+                {
+                    vertexDataFound[pVertexData] = true;
+                    size += pVertexData->getMemorySize();
+                }
+            }
+        }
+        return size;
+    }
+
     void Model::setAnimationController(AnimationController::UniquePtr pAnimController)
     {
         mpAnimationController = std::move(pAnimController);
@@ -349,12 +517,30 @@ namespace Falcor
         removeNullElements(mpTextures);
     }
 
+    static bool isCpuCompressible(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::R8Unorm:
+        case ResourceFormat::RG8Unorm:
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+            return true;
+        default:
+            return false;
+        }
+    }
+
     void Model::compressAllTextures()
     {
         std::map<const Texture*, uint32_t> texturesIndex;
         std::vector<bool> isNormalMap(mpTextures.size(), false);
 
-        // Find all normal maps. We don't compress them.
+        // Find all normal maps. They are compressed to BC5, and the shader reconstructs Z.
         for(uint32_t i = 0; i < mpTextures.size(); i++)
         {
             texturesIndex[mpTextures[i].get()] = i;
@@ -370,20 +556,73 @@ namespace Falcor
             }
         }
 
-        std::vector<uint8_t> texData;
-
-        // Now create the textures
+        // Read back the textures the CPU compressor supports. Other formats fall back to the driver.
+        std::vector<std::vector<uint8_t>> texData;
+        texData.reserve(mpTextures.size());
+        std::vector<TextureCompressor::Job> jobs;
+        std::vector<uint32_t> jobTextures;
         for(uint32_t i = 0; i < mpTextures.size(); i++)
         {
-            if(isNormalMap[i] == true)
+            Texture* pTexture = const_cast<Texture*>(mpTextures[i].get());
+            assert(pTexture->getType() == Texture::Type::Texture2D);
+            ResourceFormat format = pTexture->getFormat();
+            if(isCompressedFormat(format))
             {
-                // Not compressing normal map
                 continue;
             }
 
-            Texture* pTexture = const_cast<Texture*>(mpTextures[i].get());
-            assert(pTexture->getType() == Texture::Type::Texture2D);
-            pTexture->compress2DTexture();            
+            if(isCpuCompressible(format) == false || pTexture->getArraySize() > 1)
+            {
+                pTexture->compress2DTexture();
+                continue;
+            }
+
+            uint32_t size = pTexture->getMipLevelDataSize(0);
+            texData.push_back(std::vector<uint8_t>(size));
+            std::vector<uint8_t>& data = texData.back();
+            pTexture->readSubresourceData(data.data(), size, 0, 0);
+
+            uint32_t channelCount = getFormatChannelCount(format);
+            if(format == ResourceFormat::RGBA8Unorm || format == ResourceFormat::RGBA8UnormSrgb)
+            {
+                // The compressor expects BGRA
+                for(uint32_t j = 0; j < size; j += 4)
+                {
+                    std::swap(data[j], data[j + 2]);
+                }
+            }
+
+            TextureCompressor::Job job;
+            job.image.width = pTexture->getWidth();
+            job.image.height = pTexture->getHeight();
+            job.image.bytesPerPixel = getFormatBytesPerBlock(format);
+            job.image.pData = data.data();
+            bool isOpaque = (format == ResourceFormat::BGRX8Unorm) || (format == ResourceFormat::BGRX8UnormSrgb) || (TextureCompressor::hasTransparentTexels(job.image) == false);
+            job.format = TextureCompressor::chooseFormat(channelCount, isNormalMap[i], isOpaque, false);
+            job.isSrgb = isSrgbFormat(format) && (isNormalMap[i] == false);
+            job.generateMips = pTexture->getMipLevels() > 1;
+            jobs.push_back(job);
+            jobTextures.push_back(i);
+        }
+
+        if(jobs.empty())
+        {
+            return;
+        }
+
+        // Compress all the textures together, and replace the textures in the materials
+        std::vector<TextureCompressor::CompressedTexture> compressed = TextureCompressor::compressTextures(jobs);
+        for(uint32_t j = 0; j < jobs.size(); j++)
+        {
+            const TextureCompressor::CompressedTexture& tex = compressed[j];
+            const Texture* pOld = mpTextures[jobTextures[j]].get();
+            Texture::SharedPtr pNew = Texture::create2D(tex.width, tex.height, tex.format, 1, tex.mipCount, tex.data.data());
+            pNew->setSourceFilename(pOld->getSourceFilename());
+            for(auto& pMaterial : mpMaterials)
+            {
+                pMaterial->replaceTexture(pOld, pNew);
+            }
+            mpTextures[jobTextures[j]] = pNew;
         }
     }
 }
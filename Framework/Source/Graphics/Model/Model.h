@@ -60,12 +60,44 @@ namespace Falcor
             FindDegeneratePrimitives    = 4,    ///< Replace degenerate triangles/lines with lines/points. This can create a meshes with topology that wasn't present in the original model.
             AssumeLinearSpaceTextures   = 8,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 16,   ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
+            GenerateMipsOnCpu           = 32,   ///< Generate texture mip-chains on the CPU with sRGB-correct filtering, instead of on the GPU
+            KeepCpuGeometry             = 64,   ///< Keep a CPU copy of the mesh geometry (see CpuGeometry), so that CPU algorithms don't need to read the GPU buffers back
         };
 
         /** create a new model from file
         */
         static SharedPtr createFromFile(const std::string& filename, uint32_t flags);
 
+        /** create models from several files. The files are read, parsed and their textures decoded on worker threads, while the calling thread creates the GPU resources of each model as soon as it was read, in the order of the filenames. Reading stays at most two files per worker thread ahead of the creation.
+            \param[in] filenames The model files
+            \param[in] flags Flags controlling model creation, used for all of the models
+            \return The models, in the same order as the filenames. Files which fail to load have a nullptr entry.
+        */
+        static std::vector<SharedPtr> createFromFiles(const std::vector<std::string>& filenames, uint32_t flags);
+
+        /** A model file after readFile(), before any GPU resources were created
+        */
+        class FileData
+        {
+        public:
+            using UniquePtr = std::unique_ptr<FileData>;
+            virtual ~FileData() = default;
+        protected:
+            FileData() = default;
+        };
+
+        /** The part of loading a model file which doesn't use the graphics API: reading, parsing and decoding textures. Can be called from any thread.
+            \param[in] filename Model's filename. Loader will look for it in the data directories.
+            \param[in] flags Flags controlling model creation
+            \return nullptr if reading failed
+        */
+        static FileData::UniquePtr readFile(const std::string& filename, uint32_t flags);
+
+        /** create a new model from the data returned by readFile(). Creates the GPU resources, so it must be called from the thread which owns the graphics context.
+            \return nullptr if loading failed, otherwise a new Model object
+        */
+        static SharedPtr createFromFileData(const FileData* pData);
+
         static const char* kSupportedFileFormatsStr;
 
         ~Model();
@@ -162,6 +194,16 @@ namespace Falcor
         */
         void bindSamplerToMaterials(const Sampler::SharedPtr& pSampler);
 
+        /** Change the residency of the meshes' CPU geometry copies. Does nothing for meshes without one.
+            \param[in] residency The new residency
+            \return false if some of the data couldn't be paged to disk, otherwise true
+        */
+        bool setCpuGeometryResidency(CpuGeometry::Residency residency);
+
+        /** Get the number of bytes the CPU geometry copies hold in memory. Vertex data shared between meshes is counted once.
+        */
+        size_t getCpuGeometryMemorySize() const;
+
         /** Delete meshes from the model culled by the camera's frustum.\n
             The function will also delete buffers, textures and materials not in use anymore.
         */
@@ -217,5 +259,6 @@ namespace Falcor
         void deleteUnusedMaterials(std::map<const Material*, bool> usedMaterials);
         void deleteUnusedBuffers(std::map<const Buffer*, bool> usedBuffers);
         void compressAllTextures();
+        void finishLoading(uint32_t flags);
     };
 }
@@ -89,7 +89,16 @@ namespace Falcor
         if(mKeyFrames.size() == 0)
             return;
 
-        bool shouldInterpolate = true;
+        updateSections();
+        uint32_t section;
+        float factor;
+        findSection(currentTime, section, factor);
+        evaluateSection(mSections[section], factor, mCurrentFrame);
+        moveObjects();
+    }
+
+    void ObjectPath::findSection(double currentTime, uint32_t& section, float& factor)
+    {
         double animTime = currentTime;
         const auto& firstFrame = mKeyFrames[0];
         const auto& lastFrame = mKeyFrames[mKeyFrames.size() - 1];
@@ -104,69 +113,69 @@ namespace Falcor
             else
                 animTime = lastFrame.time;
         }
+        mCurrentFrame.time = float(animTime);
 
+        factor = 0;
         if(animTime >= lastFrame.time)
         {
-            mCurrentFrame = lastFrame;
+            section = (uint32_t)mKeyFrames.size() - 1;
+            return;
         }
         else if(animTime <= firstFrame.time)
         {
-            mCurrentFrame = firstFrame;
+            section = 0;
+            return;
         }
-        else
+
+        // Find out where we are. Try the last section first, otherwise binary-search the key frames.
+        section = mLastSection;
+        if(section >= mKeyFrames.size() - 1 || animTime < mKeyFrames[section].time || animTime >= mKeyFrames[section + 1].time)
         {
-            // Find out where we are
-            bool foundFrame = false;
-            for(uint32_t i = 0 ; i < (uint32_t)mKeyFrames.size() - 1; i++)
-            {
-                const auto& curKey = mKeyFrames[i];
-                const auto& nextKey = mKeyFrames[i + 1];
+            auto it = std::upper_bound(mKeyFrames.begin(), mKeyFrames.end(), animTime, [](double time, const Frame& frame) { return time < frame.time; });
+            section = (uint32_t)(it - mKeyFrames.begin()) - 1;
+            mLastSection = section;
+        }
 
-                if(animTime >= curKey.time && animTime < nextKey.time)
-                {
-                    // Found the animation keys. Interpolate
-                    switch(mMode)
-                    {
-                    case Interpolation::Linear:
-                        linearInterpolation(i, animTime);
-                        break;
-                    case Interpolation::CubicSpline:
-                        cubicSplineInterpolation(i, animTime);
-                        break;
-                    default:
-                        should_not_get_here();
-                    }
-                    foundFrame = true;
-                    break;
-                }
-            }
-            assert(foundFrame);
+        const Frame& current = mKeyFrames[section];
+        const Frame& next = mKeyFrames[section + 1];
+        double delta = next.time - current.time;
+        double curTime = animTime - current.time;
+        factor = float(curTime / delta);
+    }
+
+    void ObjectPath::evaluateSection(const Section& section, float factor, Frame& frame)
+    {
+        float* pResult[9] = {&frame.position.x, &frame.position.y, &frame.position.z, &frame.target.x, &frame.target.y, &frame.target.z, &frame.up.x, &frame.up.y, &frame.up.z};
+        for(uint32_t i = 0; i < 9; i++)
+        {
+            const float* c = section.coeffs[i];
+            *pResult[i] = ((c[3] * factor + c[2]) * factor + c[1]) * factor + c[0];
         }
+    }
 
+    void ObjectPath::moveObjects()
+    {
         for(auto& pObj : mpObjects)
         {
             pObj->move(mCurrentFrame.position, mCurrentFrame.target, mCurrentFrame.up);
         }
     }
 
-    void ObjectPath::linearInterpolation(uint32_t currentFrame, double currentTime)
+    void ObjectPath::updateSections()
     {
-        const Frame& current = mKeyFrames[currentFrame];
-        const Frame& next = mKeyFrames[currentFrame + 1];
-        double delta = next.time - current.time;
-        double curTime = currentTime - current.time;
-        float factor = float(curTime / delta);
-
-        mCurrentFrame.position = glm::mix(current.position, next.position, factor);
-        mCurrentFrame.target = glm::mix(current.target, next.target, factor);
-        mCurrentFrame.up = glm::mix(current.up, next.up, factor);
-    }
+        if(mDirty == false)
+        {
+            return;
+        }
+        mDirty = false;
+        mLastSection = 0;
 
-    void ObjectPath::cubicSplineInterpolation(uint32_t currentFrame, double currentTime)
-    {
-        if(mDirty)
+        const uint32_t keyCount = (uint32_t)mKeyFrames.size();
+        mpPositionSpline = nullptr;
+        mpTargetSpline = nullptr;
+        mpUpSpline = nullptr;
+        if(mMode == Interpolation::CubicSpline && keyCount >= 2)
         {
-            mDirty = false;
             std::vector<glm::vec3> positions, targets, ups;
             for(auto& a : mKeyFrames)
             {
@@ -175,20 +184,113 @@ namespace Falcor
                 ups.push_back(a.up);
             }
 
-            mpPositionSpline = std::make_unique<Vec3CubicSpline>(positions.data(), uint32_t(mKeyFrames.size()));
-            mpTargetSpline   = std::make_unique<Vec3CubicSpline>(targets.data(),   uint32_t(mKeyFrames.size()));
-            mpUpSpline       = std::make_unique<Vec3CubicSpline>(ups.data(),       uint32_t(mKeyFrames.size()));
+            mpPositionSpline = std::make_unique<Vec3CubicSpline>(positions.data(), keyCount);
+            mpTargetSpline   = std::make_unique<Vec3CubicSpline>(targets.data(),   keyCount);
+            mpUpSpline       = std::make_unique<Vec3CubicSpline>(ups.data(),       keyCount);
         }
 
-        const Frame& current = mKeyFrames[currentFrame];
-        const Frame& next = mKeyFrames[currentFrame + 1];
-        double delta = next.time - current.time;
-        double curTime = currentTime - current.time;
-        float factor = (float)(curTime / delta);
+        mSections.resize(keyCount);
+        for(uint32_t section = 0; section < keyCount; section++)
+        {
+            packSection(section);
+        }
+    }
+
+    void ObjectPath::packSection(uint32_t section)
+    {
+        const Frame& current = mKeyFrames[section];
+        Section& packed = mSections[section];
+        const glm::vec3* pCurrent[3] = {&current.position, &current.target, &current.up};
+
+        if(section == mKeyFrames.size() - 1)
+        {
+            // Constant
+            for(uint32_t v = 0; v < 3; v++)
+            {
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    float* row = packed.coeffs[v * 3 + c];
+                    row[0] = (*pCurrent[v])[c];
+                    row[1] = row[2] = row[3] = 0;
+                }
+            }
+        }
+        else if(mpPositionSpline)
+        {
+            const Vec3CubicSpline* pSplines[3] = {mpPositionSpline.get(), mpTargetSpline.get(), mpUpSpline.get()};
+            for(uint32_t v = 0; v < 3; v++)
+            {
+                const auto& coeff = pSplines[v]->getCoefficients(section);
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    float* row = packed.coeffs[v * 3 + c];
+                    row[0] = coeff.a[c];
+                    row[1] = coeff.b[c];
+                    row[2] = coeff.c[c];
+                    row[3] = coeff.d[c];
+                }
+            }
+        }
+        else
+        {
+            // Linear. Same as glm::mix(), x + (y - x) * t
+            const Frame& next = mKeyFrames[section + 1];
+            const glm::vec3* pNext[3] = {&next.position, &next.target, &next.up};
+            for(uint32_t v = 0; v < 3; v++)
+            {
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    float* row = packed.coeffs[v * 3 + c];
+                    row[0] = (*pCurrent[v])[c];
+                    row[1] = (*pNext[v])[c] - (*pCurrent[v])[c];
+                    row[2] = row[3] = 0;
+                }
+            }
+        }
+    }
+
+    void ObjectPath::updateKeyFrame(uint32_t frameID, Vec3CubicSpline* pSpline, const glm::vec3& value)
+    {
+        if(mDirty)
+        {
+            // The sections will be rebuilt anyway
+            return;
+        }
 
-        mCurrentFrame.position = mpPositionSpline->interpolate(currentFrame, factor);
-        mCurrentFrame.target = mpTargetSpline->interpolate(currentFrame, factor);
-        mCurrentFrame.up = mpUpSpline->interpolate(currentFrame, factor);
+        uint32_t firstSection = (frameID > 0) ? frameID - 1 : 0;
+        uint32_t lastSection = frameID;
+        if(pSpline)
+        {
+            pSpline->setControlPoint(frameID, value, firstSection, lastSection);
+            // The constant last section isn't part of the spline
+            if(frameID == mKeyFrames.size() - 1)
+            {
+                lastSection = frameID;
+            }
+        }
+
+        for(uint32_t section = firstSection; section <= lastSection; section++)
+        {
+            packSection(section);
+        }
+    }
+
+    void ObjectPath::setFramePosition(uint32_t frameID, const glm::vec3& pos)
+    {
+        mKeyFrames[frameID].position = pos;
+        updateKeyFrame(frameID, mpPositionSpline.get(), pos);
+    }
+
+    void ObjectPath::setFrameTarget(uint32_t frameID, const glm::vec3& target)
+    {
+        mKeyFrames[frameID].target = target;
+        updateKeyFrame(frameID, mpTargetSpline.get(), target);
+    }
+
+    void ObjectPath::setFrameUp(uint32_t frameID, const glm::vec3& up)
+    {
+        mKeyFrames[frameID].up = up;
+        updateKeyFrame(frameID, mpUpSpline.get(), up);
     }
 
     void ObjectPath::attachObject(const IMovableObject::SharedPtr& pObject)
@@ -212,10 +314,20 @@ namespace Falcor
     void ObjectPath::removeKeyFrame(uint32_t frameID)
     {
         mKeyFrames.erase(mKeyFrames.begin() + frameID);
+        mDirty = true;
     }
 
     uint32_t ObjectPath::setFrameTime(uint32_t frameID, float time)
     {
+        // The curves are parameterized per section, not by time, so they only change if the key frame order does
+        bool isAfterPrevious = (frameID == 0) || (mKeyFrames[frameID - 1].time < time);
+        bool isBeforeNext = (frameID == mKeyFrames.size() - 1) || (time < mKeyFrames[frameID + 1].time);
+        if(isAfterPrevious && isBeforeNext)
+        {
+            mKeyFrames[frameID].time = time;
+            return frameID;
+        }
+
         const auto Frame = mKeyFrames[frameID];
         removeKeyFrame(frameID);
         return addKeyFrame(time, Frame.position, Frame.target, Frame.up);
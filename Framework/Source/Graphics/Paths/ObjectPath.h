@@ -34,6 +34,7 @@
 namespace Falcor
 {
     using Vec3CubicSpline = CubicSpline <glm::vec3>;
+    class ObjectPathSet;
 
     class ObjectPath : public std::enable_shared_from_this<ObjectPath>
     {
@@ -50,10 +51,13 @@ namespace Falcor
             CubicSpline
         };
 
-        void setInterpolationMode(Interpolation mode) { mMode = mode; }
+        void setInterpolationMode(Interpolation mode) { mMode = mode; mDirty = true; }
+        Interpolation getInterpolationMode() const { return mMode; }
         uint32_t addKeyFrame(float time, const glm::vec3& position, const glm::vec3& target, const glm::vec3& up);
         void removeKeyFrame(uint32_t frameID);
 
+        /** Evaluate the path and move the attached objects. To animate many paths, use ObjectPathSet.
+        */
         void animate(double currentTime);
 
         void attachObject(const IMovableObject::SharedPtr& pObject);
@@ -80,15 +84,32 @@ namespace Falcor
         uint32_t getKeyFrameCount() const {return (uint32_t)mKeyFrames.size();}
         const Frame& getKeyFrame(uint32_t frameID) const { return mKeyFrames[frameID]; }
 
-        void setFramePosition(uint32_t frameID, const glm::vec3& pos) { mKeyFrames[frameID].position = pos; }
-        void setFrameTarget(uint32_t frameID, const glm::vec3& target) { mKeyFrames[frameID].target = target; }
-        void setFrameUp(uint32_t frameID, const glm::vec3& up) { mKeyFrames[frameID].up = up; }
+        /** Key frame edits only update the part of the curve the key influences
+        */
+        void setFramePosition(uint32_t frameID, const glm::vec3& pos);
+        void setFrameTarget(uint32_t frameID, const glm::vec3& target);
+        void setFrameUp(uint32_t frameID, const glm::vec3& up);
         uint32_t setFrameTime(uint32_t frameID, float time);
+
     private:
+        friend class ObjectPathSet;
         ObjectPath() = default;
-        void linearInterpolation(uint32_t currentFrame, double currentTime);
-        void cubicSplineInterpolation(uint32_t currentFrame, double currentTime);
-        
+
+        /** The position, target and up polynomials of the time between two key frames, for t in [0, 1). Each row holds the (a, b, c, d) coefficients of one component, evaluated as ((d * t + c) * t + b) * t + a.
+            There is a section per key frame. The last one is constant, so that times past the end evaluate to the last key frame exactly.
+        */
+        struct Section
+        {
+            float coeffs[9][4];
+        };
+
+        void updateSections();
+        void updateKeyFrame(uint32_t frameID, Vec3CubicSpline* pSpline, const glm::vec3& value);
+        void packSection(uint32_t section);
+        void findSection(double currentTime, uint32_t& section, float& factor);
+        void moveObjects();
+        static void evaluateSection(const Section& section, float factor, Frame& frame);
+
         std::vector<Frame> mKeyFrames;
         std::vector<IMovableObject::SharedPtr> mpObjects;
         std::string mName;
@@ -96,8 +117,10 @@ namespace Falcor
 
         Frame mCurrentFrame;
         Interpolation mMode = Interpolation::CubicSpline;
-        bool mDirty = false;
+        bool mDirty = false;                // The sections need to be rebuilt
+        uint32_t mLastSection = 0;          // Playback is usually coherent, so the last section is tried before searching
 
+        std::vector<Section> mSections;
         std::unique_ptr<Vec3CubicSpline> mpPositionSpline;
         std::unique_ptr<Vec3CubicSpline> mpTargetSpline;
         std::unique_ptr<Vec3CubicSpline> mpUpSpline;
@@ -0,0 +1,148 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ObjectPathSet.h"
+#include <algorithm>
+#include "Utils/ParallelFor.h"
+#include "Utils/Math/SseMath.h"
+
+namespace Falcor
+{
+    ObjectPathSet::SharedPtr ObjectPathSet::create()
+    {
+        return SharedPtr(new ObjectPathSet);
+    }
+
+    bool ObjectPathSet::addPath(const ObjectPath::SharedPtr& pPath)
+    {
+        // Each path is evaluated by a single thread, so it must not appear twice
+        if(std::find(mpPaths.begin(), mpPaths.end(), pPath) != mpPaths.end())
+        {
+            Logger::log(Logger::Level::Warning, "ObjectPathSet::addPath() - path '" + pPath->getName() + "' is already in the set");
+            return false;
+        }
+        mpPaths.push_back(pPath);
+        return true;
+    }
+
+    void ObjectPathSet::removePath(const ObjectPath::SharedPtr& pPath)
+    {
+        auto it = std::find(mpPaths.begin(), mpPaths.end(), pPath);
+        if(it != mpPaths.end())
+        {
+            mpPaths.erase(it);
+        }
+    }
+
+    static float& getFrameComponent(ObjectPath::Frame& frame, uint32_t row)
+    {
+        glm::vec3* pVectors[3] = {&frame.position, &frame.target, &frame.up};
+        return (*pVectors[row / 3])[row % 3];
+    }
+
+    void ObjectPathSet::evaluateRange(double currentTime, uint32_t begin, uint32_t end)
+    {
+        // Used for the unused lanes of partial blocks and for paths without key frames
+        const ObjectPath::Section emptySection = {};
+        for(uint32_t block = begin; block < end; block += 4)
+        {
+            ObjectPath* pLanes[4];
+            const ObjectPath::Section* pSections[4];
+            float factors[4];
+            for(uint32_t lane = 0; lane < 4; lane++)
+            {
+                ObjectPath* pPath = (block + lane < end) ? mpPaths[block + lane].get() : nullptr;
+                pLanes[lane] = nullptr;
+                pSections[lane] = &emptySection;
+                factors[lane] = 0;
+                if(pPath && pPath->mKeyFrames.size())
+                {
+                    uint32_t section;
+                    pPath->updateSections();
+                    pPath->findSection(currentTime, section, factors[lane]);
+                    pLanes[lane] = pPath;
+                    pSections[lane] = &pPath->mSections[section];
+                }
+            }
+
+#ifdef FALCOR_SSE_MATH_AVAILABLE
+            // Each section row holds a component's (a, b, c, d). Transposing four rows gives the same coefficient for all the lanes.
+            const __m128 t = _mm_loadu_ps(factors);
+            for(uint32_t row = 0; row < 9; row++)
+            {
+                __m128 a = _mm_loadu_ps(pSections[0]->coeffs[row]);
+                __m128 b = _mm_loadu_ps(pSections[1]->coeffs[row]);
+                __m128 c = _mm_loadu_ps(pSections[2]->coeffs[row]);
+                __m128 d = _mm_loadu_ps(pSections[3]->coeffs[row]);
+                _MM_TRANSPOSE4_PS(a, b, c, d);
+                __m128 result = _mm_add_ps(_mm_mul_ps(d, t), c);
+                result = _mm_add_ps(_mm_mul_ps(result, t), b);
+                result = _mm_add_ps(_mm_mul_ps(result, t), a);
+
+                float values[4];
+                _mm_storeu_ps(values, result);
+                for(uint32_t lane = 0; lane < 4; lane++)
+                {
+                    if(pLanes[lane])
+                    {
+                        getFrameComponent(pLanes[lane]->mCurrentFrame, row) = values[lane];
+                    }
+                }
+            }
+#else
+            for(uint32_t lane = 0; lane < 4; lane++)
+            {
+                if(pLanes[lane])
+                {
+                    ObjectPath::evaluateSection(*pSections[lane], factors[lane], pLanes[lane]->mCurrentFrame);
+                }
+            }
+#endif
+        }
+    }
+
+    void ObjectPathSet::evaluate(double currentTime)
+    {
+        // Ranges are multiples of the SIMD width, so only the last one has a partial block
+        uint32_t pathCount = (uint32_t)mpPaths.size();
+        uint32_t blockCount = (pathCount + 3) / 4;
+        parallelFor(blockCount, 64, [&](uint32_t begin, uint32_t end)
+        {
+            evaluateRange(currentTime, begin * 4, (std::min)(end * 4, pathCount));
+        });
+    }
+
+    void ObjectPathSet::animate(double currentTime)
+    {
+        evaluate(currentTime);
+        for(auto& pPath : mpPaths)
+        {
+            pPath->moveObjects();
+        }
+    }
+}
\ No newline at end of file
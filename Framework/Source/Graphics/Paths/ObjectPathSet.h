@@ -0,0 +1,74 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Graphics/Paths/ObjectPath.h"
+
+namespace Falcor
+{
+    /** Animates many object paths at once.
+        Each path keeps its curves as packed per-section polynomials, which are only updated around the key frames that were edited. Evaluation finds the current section with a binary search (after trying the last section), then evaluates four paths at once with SSE2.
+        The batch is split between threads with parallelFor(). The attached objects are moved afterwards on the calling thread, since paths can share objects.
+    */
+    class ObjectPathSet
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ObjectPathSet>;
+        using SharedConstPtr = std::shared_ptr<const ObjectPathSet>;
+
+        /** Create an empty set
+        */
+        static SharedPtr create();
+
+        /** Add a path to the set
+            \return false if the path is already in the set
+        */
+        bool addPath(const ObjectPath::SharedPtr& pPath);
+
+        /** Remove a path from the set
+        */
+        void removePath(const ObjectPath::SharedPtr& pPath);
+
+        uint32_t getPathCount() const { return (uint32_t)mpPaths.size(); }
+        const ObjectPath::SharedPtr& getPath(uint32_t index) const { return mpPaths[index]; }
+
+        /** Evaluate all the paths, using SIMD and all worker threads, without moving the attached objects. The results are available through the paths' getCurrentXXX() functions.
+        */
+        void evaluate(double currentTime);
+
+        /** Evaluate all the paths and move the attached objects. Gives the same results as calling ObjectPath::animate() for each path.
+        */
+        void animate(double currentTime);
+
+    private:
+        ObjectPathSet() = default;
+        void evaluateRange(double currentTime, uint32_t begin, uint32_t end);
+
+        std::vector<ObjectPath::SharedPtr> mpPaths;
+    };
+}
\ No newline at end of file
@@ -30,6 +30,10 @@
 #include "SceneImporter.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include "Utils/OS.h"
 
 namespace Falcor
 {
@@ -37,13 +41,18 @@ namespace Falcor
 
     const Scene::UserVariable Scene::kInvalidVar;
 
-    const char* Scene::kFileFormatString = "Falcor Scene File\n*.fscene\0\0";
+    const char* Scene::kFileFormatString = "Falcor Scene File\0*.fscene;*.fsceneb\0\0";
 
     Scene::SharedPtr Scene::loadFromFile(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags)
     {
         return SceneImporter::loadScene(filename, modelLoadFlags, sceneLoadFlags);
     }
 
+    Scene::SharedPtr Scene::loadFromFileAsync(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags)
+    {
+        return SceneImporter::loadSceneAsync(filename, modelLoadFlags, sceneLoadFlags);
+    }
+
     Scene::SharedPtr Scene::create(float cameraAspectRatio)
     {
         return SharedPtr(new Scene(cameraAspectRatio));
@@ -63,6 +72,118 @@ namespace Falcor
 
     Scene::~Scene() = default;
 
+    static uint64_t getModelFileSize(const std::string& filename)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath) == false)
+        {
+            return 0;
+        }
+        std::ifstream file(fullpath, std::ios::binary | std::ios::ate);
+        return file.good() ? (uint64_t)file.tellg() : 0;
+    }
+
+    void Scene::startAsyncLoad(uint32_t modelLoadFlags, uint32_t sceneLoadFlags, const ModelInitFunc& initModel)
+    {
+        // Load the models nearest to the camera first, so that the first frames show what's in front of the viewer. Among equally near models, smaller files arrive sooner.
+        const glm::vec3 cameraPosition = getActiveCamera()->getPosition();
+        std::vector<float> distances(mModels.size(), FLT_MAX);
+        std::vector<uint64_t> fileSizes(mModels.size());
+        for(uint32_t modelID = 0; modelID < (uint32_t)mModels.size(); modelID++)
+        {
+            auto& model = mModels[modelID];
+            model.isPlaceholder = true;
+            for(const auto& instance : model.instances)
+            {
+                distances[modelID] = glm::min(distances[modelID], glm::length(instance.translation - cameraPosition));
+            }
+            fileSizes[modelID] = getModelFileSize(model.Filename);
+        }
+
+        std::vector<std::string> filenames;
+        mLoadOrder = AsyncModelLoader::calcLoadOrder(distances, fileSizes);
+        for(uint32_t modelID : mLoadOrder)
+        {
+            filenames.push_back(mModels[modelID].Filename);
+        }
+
+        mInitLoadedModel = initModel;
+        mAsyncSceneLoadFlags = sceneLoadFlags;
+        mLoadProgress = LoadProgress();
+        mLoadProgress.modelCount = (uint32_t)mModels.size();
+        mpModelLoader = AsyncModelLoader::create(filenames, modelLoadFlags);
+
+        if(mLoadProgress.isComplete())
+        {
+            onLoadComplete();
+        }
+    }
+
+    void Scene::onModelLoaded(uint32_t modelID, const Model::SharedPtr& pModel)
+    {
+        auto& model = mModels[modelID];
+        if(pModel)
+        {
+            mInitLoadedModel(modelID, pModel.get());
+            model.pModel = pModel;
+            model.isPlaceholder = false;
+            mLoadProgress.loadedModelCount++;
+        }
+        else
+        {
+            for(auto& instance : model.instances)
+            {
+                instance.isVisible = false;
+            }
+            mLoadProgress.failedModelCount++;
+        }
+
+        if(mModelLoadedCallback)
+        {
+            mModelLoadedCallback(modelID, pModel != nullptr);
+        }
+    }
+
+    void Scene::onLoadComplete()
+    {
+        // Release the loader's threads and the importer
+        mpModelLoader = nullptr;
+        mInitLoadedModel = nullptr;
+        mLoadOrder.clear();
+
+        if(mAsyncSceneLoadFlags == GenerateAreaLights)
+        {
+            createAreaLights();
+        }
+
+        if(mLoadCompleteCallback)
+        {
+            mLoadCompleteCallback();
+        }
+    }
+
+    bool Scene::updateLoading(float timeBudgetInMs)
+    {
+        if(mpModelLoader)
+        {
+            mpModelLoader->update(timeBudgetInMs, [this](uint32_t fileIndex, const Model::SharedPtr& pModel) { onModelLoaded(mLoadOrder[fileIndex], pModel); });
+            if(mpModelLoader->isComplete())
+            {
+                onLoadComplete();
+            }
+        }
+        return mLoadProgress.isComplete();
+    }
+
+    void Scene::finishLoading()
+    {
+        if(mpModelLoader)
+        {
+            mpModelLoader->finish([this](uint32_t fileIndex, const Model::SharedPtr& pModel) { onModelLoaded(mLoadOrder[fileIndex], pModel); });
+            onLoadComplete();
+        }
+    }
+
     bool Scene::updateCamera(double currentTime, CameraController* cameraController)
     {
         auto pCamera = getActiveCamera();
@@ -29,7 +29,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <functional>
 #include "Graphics/Model/Model.h"
+#include "Graphics/Model/AsyncModelLoader.h"
 #include "Graphics/Light.h"
 #include "Graphics/Material/Material.h"
 #include "Graphics/Camera/Camera.h"
@@ -104,7 +106,27 @@ namespace Falcor
 			GenerateAreaLights = 1,    ///< Create area light(s) for meshes that have emissive material
 		};
 
+        /** Progress of loadFromFileAsync(). Scenes which were loaded synchronously are always complete.
+        */
+        struct LoadProgress
+        {
+            uint32_t modelCount = 0;            ///< The number of models in the scene file and its included files
+            uint32_t loadedModelCount = 0;      ///< Models which replaced their placeholder
+            uint32_t failedModelCount = 0;      ///< Models which failed to load. Their instances are hidden.
+
+            bool isComplete() const { return loadedModelCount + failedModelCount == modelCount; }
+        };
+
+        using ModelLoadedCallback = std::function<void(uint32_t modelID, bool success)>;
+        using LoadCompleteCallback = std::function<void()>;
+
         static Scene::SharedPtr loadFromFile(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags = 0);
+
+        /** Load a scene file without waiting for the models. The scene file is parsed before the function returns, so the cameras, lights, paths and materials are available right away.
+            Each model starts as a placeholder drawn at its instances. The placeholder is a fixed-size unit box, transformed by each instance's transform, since a model's bounds are unknown until its file was read. The model files are read on worker threads, the ones nearest to the active camera first and smaller files first among equally near ones.
+            updateLoading() replaces the placeholders as the files arrive. Models must not be added or deleted until the load is complete.
+        */
+        static Scene::SharedPtr loadFromFileAsync(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags = 0);
         static Scene::SharedPtr create(float cameraAspectRatio = 1.0f);
 
         ~Scene();
@@ -117,6 +139,21 @@ namespace Falcor
         const Model::SharedPtr& getModel(uint32_t index) const { return mModels[index].pModel; }
         const std::string& getModelFilename(uint32_t index) const { return mModels[index].Filename; }
 
+        /** Create the models which were read since the last call, replace their placeholders and call the callbacks. Must be called from the rendering thread, usually once per frame.
+            \param[in] timeBudgetInMs Stop creating models once this much time was spent. At least one model is created per call if one was read.
+            \return true if the scene is completely loaded
+        */
+        bool updateLoading(float timeBudgetInMs = 10);
+
+        /** Wait for the remaining models of an asynchronous load and create them
+        */
+        void finishLoading();
+
+        const LoadProgress& getLoadProgress() const { return mLoadProgress; }
+        bool isModelPlaceholder(uint32_t modelID) const { return mModels[modelID].isPlaceholder; }
+        void setModelLoadedCallback(const ModelLoadedCallback& callback) { mModelLoadedCallback = callback; }
+        void setLoadCompleteCallback(const LoadCompleteCallback& callback) { mLoadCompleteCallback = callback; }
+
         // Model instances
         uint32_t getModelInstanceCount(uint32_t modelID) const { return (uint32_t)mModels[modelID].instances.size(); }
         const ModelInstance& getModelInstance(uint32_t modelID, uint32_t instanceID) const { return mModels[modelID].instances[instanceID]; }
@@ -201,8 +238,14 @@ namespace Falcor
 		void deleteAreaLights();
 
     private:
+        friend class SceneImporter;
         Scene(float cameraAspectRatio);
 
+        using ModelInitFunc = std::function<void(uint32_t modelID, Model* pModel)>;
+        void startAsyncLoad(uint32_t modelLoadFlags, uint32_t sceneLoadFlags, const ModelInitFunc& initModel);
+        void onModelLoaded(uint32_t modelID, const Model::SharedPtr& pModel);
+        void onLoadComplete();
+
 		static uint32_t sSceneCounter;
 
 		uint32_t mId;
@@ -216,6 +259,7 @@ namespace Falcor
             Model::SharedPtr pModel;
             std::string Filename;
             std::vector<ModelInstance> instances;
+            bool isPlaceholder = false;
 
             ModelData(const Model::SharedPtr& pModel, const std::string& _Filename) : pModel(pModel), Filename(_Filename) {}
         };
@@ -236,5 +280,14 @@ namespace Falcor
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
         static const UserVariable kInvalidVar;
+
+        // Asynchronous loading
+        AsyncModelLoader::UniquePtr mpModelLoader;
+        std::vector<uint32_t> mLoadOrder;       // The model ID of each file given to the loader
+        ModelInitFunc mInitLoadedModel;
+        uint32_t mAsyncSceneLoadFlags = 0;
+        LoadProgress mLoadProgress;
+        ModelLoadedCallback mModelLoadedCallback;
+        LoadCompleteCallback mLoadCompleteCallback;
     };
 }
\ No newline at end of file
@@ -0,0 +1,613 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneBinaryFormat.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include "SceneExportImportCommon.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/OS.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/writer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+
+namespace Falcor
+{
+    const char* SceneBinaryFormat::kBinaryExtension = ".fsceneb";
+
+    /** File layout:
+        - Header
+        - The root value. Each value starts with a ValueTag followed by its payload.
+        - The string table: (stringCount + 1) offsets into the character data, followed by the null-terminated strings
+        All values are little-endian and unaligned.
+    */
+    static const uint32_t kMagic = 0x42435346; // 'FSCB'
+    static const uint32_t kVersion = 1;
+    static const uint32_t kMaxDepth = 256;
+
+    struct BinarySceneHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t stringCount;
+        uint32_t reserved;
+        uint64_t stringTableOffset;
+    };
+
+    enum class ValueTag : uint8_t
+    {
+        Null,
+        False,
+        True,
+        Int,            ///< int32_t
+        Uint,           ///< uint32_t
+        Int64,          ///< int64_t
+        Uint64,         ///< uint64_t
+        Float,          ///< A double which is exactly representable as a float, stored as a float
+        Double,         ///< double
+        String,         ///< uint32_t string index
+        Array,          ///< uint32_t element count followed by the elements
+        Object,         ///< uint32_t member count followed by (uint32_t key string index, value) pairs
+        FloatArray,     ///< uint32_t element count followed by floats. Used for arrays of doubles which are exactly representable as floats, such as vectors.
+    };
+
+    static bool isFloatExact(double d)
+    {
+        return (double)(float)d == d;
+    }
+
+    static bool isFloatArray(const rapidjson::Value& value)
+    {
+        if(value.Empty())
+        {
+            return false;
+        }
+
+        for(auto it = value.Begin(); it != value.End(); it++)
+        {
+            if((it->IsDouble() == false) || (isFloatExact(it->GetDouble()) == false))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /************************************************************************/
+    /* Writer                                                               */
+    /************************************************************************/
+    class BinarySceneWriter
+    {
+    public:
+        BinarySceneWriter(std::vector<uint8_t>& data) : mData(data) {}
+
+        void writeValue(const rapidjson::Value& value)
+        {
+            switch(value.GetType())
+            {
+            case rapidjson::kNullType:
+                writeTag(ValueTag::Null);
+                break;
+            case rapidjson::kFalseType:
+                writeTag(ValueTag::False);
+                break;
+            case rapidjson::kTrueType:
+                writeTag(ValueTag::True);
+                break;
+            case rapidjson::kStringType:
+                writeTag(ValueTag::String);
+                write(getStringIndex(value));
+                break;
+            case rapidjson::kNumberType:
+                writeNumber(value);
+                break;
+            case rapidjson::kArrayType:
+                if(isFloatArray(value))
+                {
+                    writeTag(ValueTag::FloatArray);
+                    write((uint32_t)value.Size());
+                    for(auto it = value.Begin(); it != value.End(); it++)
+                    {
+                        write((float)it->GetDouble());
+                    }
+                }
+                else
+                {
+                    writeTag(ValueTag::Array);
+                    write((uint32_t)value.Size());
+                    for(auto it = value.Begin(); it != value.End(); it++)
+                    {
+                        writeValue(*it);
+                    }
+                }
+                break;
+            case rapidjson::kObjectType:
+                writeTag(ValueTag::Object);
+                write((uint32_t)value.MemberCount());
+                for(auto it = value.MemberBegin(); it != value.MemberEnd(); it++)
+                {
+                    write(getStringIndex(it->name));
+                    writeValue(it->value);
+                }
+                break;
+            default:
+                should_not_get_here();
+            }
+        }
+
+        void writeStringTable()
+        {
+            uint32_t offset = 0;
+            for(const std::string* pString : mStrings)
+            {
+                write(offset);
+                offset += (uint32_t)pString->size() + 1;
+            }
+            write(offset);
+
+            for(const std::string* pString : mStrings)
+            {
+                size_t start = mData.size();
+                mData.resize(start + pString->size() + 1);
+                memcpy(&mData[start], pString->c_str(), pString->size() + 1);
+            }
+        }
+
+        uint32_t getStringCount() const { return (uint32_t)mStrings.size(); }
+
+    private:
+        template<typename T>
+        void write(const T& value)
+        {
+            size_t offset = mData.size();
+            mData.resize(offset + sizeof(T));
+            memcpy(&mData[offset], &value, sizeof(T));
+        }
+
+        void writeTag(ValueTag tag)
+        {
+            mData.push_back((uint8_t)tag);
+        }
+
+        void writeNumber(const rapidjson::Value& value)
+        {
+            // Check the types in the same order as the JSON writer, so that the number is read back with the same flags
+            if(value.IsDouble())
+            {
+                double d = value.GetDouble();
+                if(isFloatExact(d))
+                {
+                    writeTag(ValueTag::Float);
+                    write((float)d);
+                }
+                else
+                {
+                    writeTag(ValueTag::Double);
+                    write(d);
+                }
+            }
+            else if(value.IsInt())
+            {
+                writeTag(ValueTag::Int);
+                write((int32_t)value.GetInt());
+            }
+            else if(value.IsUint())
+            {
+                writeTag(ValueTag::Uint);
+                write((uint32_t)value.GetUint());
+            }
+            else if(value.IsInt64())
+            {
+                writeTag(ValueTag::Int64);
+                write((int64_t)value.GetInt64());
+            }
+            else
+            {
+                writeTag(ValueTag::Uint64);
+                write((uint64_t)value.GetUint64());
+            }
+        }
+
+        uint32_t getStringIndex(const rapidjson::Value& value)
+        {
+            auto result = mStringIndices.insert(std::make_pair(std::string(value.GetString(), value.GetStringLength()), (uint32_t)mStrings.size()));
+            if(result.second)
+            {
+                mStrings.push_back(&result.first->first);
+            }
+            return result.first->second;
+        }
+
+        std::vector<uint8_t>& mData;
+        std::unordered_map<std::string, uint32_t> mStringIndices;
+        std::vector<const std::string*> mStrings;
+    };
+
+    bool SceneBinaryFormat::isBinaryScene(const uint8_t* pData, size_t size)
+    {
+        uint32_t magic;
+        if(size < sizeof(BinarySceneHeader))
+        {
+            return false;
+        }
+        memcpy(&magic, pData, sizeof(magic));
+        return magic == kMagic;
+    }
+
+    void SceneBinaryFormat::write(const rapidjson::Value& root, std::vector<uint8_t>& data)
+    {
+        data.resize(sizeof(BinarySceneHeader));
+        BinarySceneWriter writer(data);
+        writer.writeValue(root);
+
+        BinarySceneHeader header;
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.stringCount = writer.getStringCount();
+        header.reserved = 0;
+        header.stringTableOffset = data.size();
+        writer.writeStringTable();
+        memcpy(data.data(), &header, sizeof(header));
+    }
+
+    /************************************************************************/
+    /* Reader                                                               */
+    /************************************************************************/
+    class BinarySceneReader
+    {
+    public:
+        BinarySceneReader(const uint8_t* pData, size_t valuesEnd, const uint8_t* pOffsets, uint32_t stringCount, const char* pChars, size_t charsSize, rapidjson::Document::AllocatorType& allocator) :
+            mpData(pData), mOffset(sizeof(BinarySceneHeader)), mValuesEnd(valuesEnd), mpOffsets(pOffsets), mStringCount(stringCount), mpChars(pChars), mCharsSize(charsSize), mAllocator(allocator) {}
+
+        bool readValue(rapidjson::Value& value, uint32_t depth)
+        {
+            if(depth >= kMaxDepth)
+            {
+                return error("Values are nested too deeply");
+            }
+
+            uint8_t tag;
+            if(read(tag) == false)
+            {
+                return false;
+            }
+
+            switch((ValueTag)tag)
+            {
+            case ValueTag::Null:
+                value.SetNull();
+                return true;
+            case ValueTag::False:
+                value.SetBool(false);
+                return true;
+            case ValueTag::True:
+                value.SetBool(true);
+                return true;
+            case ValueTag::Int:
+                return readNumber<int32_t>(value, &rapidjson::Value::SetInt);
+            case ValueTag::Uint:
+                return readNumber<uint32_t>(value, &rapidjson::Value::SetUint);
+            case ValueTag::Int64:
+                return readNumber<int64_t>(value, &rapidjson::Value::SetInt64);
+            case ValueTag::Uint64:
+                return readNumber<uint64_t>(value, &rapidjson::Value::SetUint64);
+            case ValueTag::Double:
+                return readNumber<double>(value, &rapidjson::Value::SetDouble);
+            case ValueTag::Float:
+            {
+                float f;
+                if(read(f) == false)
+                {
+                    return false;
+                }
+                value.SetDouble(f);
+                return true;
+            }
+            case ValueTag::String:
+                return readString(value);
+            case ValueTag::FloatArray:
+                return readFloatArray(value);
+            case ValueTag::Array:
+                return readArray(value, depth);
+            case ValueTag::Object:
+                return readObject(value, depth);
+            default:
+                return error("Unknown value tag " + std::to_string(tag));
+            }
+        }
+
+        bool isAtEnd() const { return mOffset == mValuesEnd; }
+        const std::string& getError() const { return mError; }
+
+    private:
+        template<typename T>
+        bool read(T& value)
+        {
+            if(mValuesEnd - mOffset < sizeof(T))
+            {
+                return error("Unexpected end of data");
+            }
+            memcpy(&value, mpData + mOffset, sizeof(T));
+            mOffset += sizeof(T);
+            return true;
+        }
+
+        template<typename T, typename SetFunc>
+        bool readNumber(rapidjson::Value& value, SetFunc func)
+        {
+            T number;
+            if(read(number) == false)
+            {
+                return false;
+            }
+            (value.*func)(number);
+            return true;
+        }
+
+        bool readCount(uint32_t& count, size_t elementSize)
+        {
+            // Every element takes at least elementSize bytes, so a count which doesn't fit in the remaining data is invalid. This also keeps corrupt data from reserving huge arrays.
+            if(read(count) == false)
+            {
+                return false;
+            }
+            if((size_t)count > (mValuesEnd - mOffset) / elementSize)
+            {
+                return error("Element count " + std::to_string(count) + " exceeds the size of the data");
+            }
+            return true;
+        }
+
+        bool getString(uint32_t index, rapidjson::Value& value)
+        {
+            if(index >= mStringCount)
+            {
+                return error("String index " + std::to_string(index) + " is out of range");
+            }
+
+            uint32_t offsets[2];
+            memcpy(offsets, mpOffsets + index * sizeof(uint32_t), sizeof(offsets));
+            if((offsets[0] >= offsets[1]) || (offsets[1] > mCharsSize) || (mpChars[offsets[1] - 1] != '\0'))
+            {
+                return error("String " + std::to_string(index) + " is invalid");
+            }
+            value.SetString(rapidjson::StringRef(mpChars + offsets[0], offsets[1] - offsets[0] - 1));
+            return true;
+        }
+
+        bool readString(rapidjson::Value& value)
+        {
+            uint32_t index;
+            return read(index) && getString(index, value);
+        }
+
+        bool readFloatArray(rapidjson::Value& value)
+        {
+            uint32_t count;
+            if(readCount(count, sizeof(float)) == false)
+            {
+                return false;
+            }
+
+            value.SetArray();
+            value.Reserve(count, mAllocator);
+            for(uint32_t i = 0; i < count; i++)
+            {
+                float f;
+                read(f);
+                rapidjson::Value element((double)f);
+                value.PushBack(element, mAllocator);
+            }
+            return true;
+        }
+
+        bool readArray(rapidjson::Value& value, uint32_t depth)
+        {
+            uint32_t count;
+            if(readCount(count, sizeof(uint8_t)) == false)
+            {
+                return false;
+            }
+
+            value.SetArray();
+            value.Reserve(count, mAllocator);
+            for(uint32_t i = 0; i < count; i++)
+            {
+                rapidjson::Value element;
+                if(readValue(element, depth + 1) == false)
+                {
+                    return false;
+                }
+                value.PushBack(element, mAllocator);
+            }
+            return true;
+        }
+
+        bool readObject(rapidjson::Value& value, uint32_t depth)
+        {
+            uint32_t count;
+            if(readCount(count, sizeof(uint32_t) + sizeof(uint8_t)) == false)
+            {
+                return false;
+            }
+
+            value.SetObject();
+            for(uint32_t i = 0; i < count; i++)
+            {
+                rapidjson::Value key;
+                rapidjson::Value member;
+                if((readString(key) == false) || (readValue(member, depth + 1) == false))
+                {
+                    return false;
+                }
+                value.AddMember(key, member, mAllocator);
+            }
+            return true;
+        }
+
+        bool error(const std::string& msg)
+        {
+            if(mError.empty())
+            {
+                mError = msg + " (offset " + std::to_string(mOffset) + ")";
+            }
+            return false;
+        }
+
+        const uint8_t* mpData;
+        size_t mOffset;
+        size_t mValuesEnd;
+        const uint8_t* mpOffsets;
+        uint32_t mStringCount;
+        const char* mpChars;
+        size_t mCharsSize;
+        rapidjson::Document::AllocatorType& mAllocator;
+        std::string mError;
+    };
+
+    bool SceneBinaryFormat::read(const uint8_t* pData, size_t size, rapidjson::Document& doc, std::string& errorMsg)
+    {
+        if(isBinaryScene(pData, size) == false)
+        {
+            errorMsg = "The data is not a binary scene";
+            return false;
+        }
+
+        BinarySceneHeader header;
+        memcpy(&header, pData, sizeof(header));
+        if(header.version != kVersion)
+        {
+            errorMsg = "Unsupported binary scene version " + std::to_string(header.version) + ". Expected version " + std::to_string(kVersion);
+            return false;
+        }
+
+        size_t offsetsSize = ((size_t)header.stringCount + 1) * sizeof(uint32_t);
+        if((header.stringTableOffset < sizeof(BinarySceneHeader)) || (header.stringTableOffset > size) || (size - header.stringTableOffset < offsetsSize))
+        {
+            errorMsg = "The string table is out of range";
+            return false;
+        }
+
+        size_t valuesEnd = (size_t)header.stringTableOffset;
+        const uint8_t* pOffsets = pData + valuesEnd;
+        const char* pChars = (const char*)(pOffsets + offsetsSize);
+        BinarySceneReader reader(pData, valuesEnd, pOffsets, header.stringCount, pChars, size - valuesEnd - offsetsSize, doc.GetAllocator());
+
+        if(reader.readValue(doc, 0) == false)
+        {
+            errorMsg = reader.getError();
+            return false;
+        }
+        if(reader.isAtEnd() == false)
+        {
+            errorMsg = "Unexpected data after the root value";
+            return false;
+        }
+        return true;
+    }
+
+    /************************************************************************/
+    /* Conversion                                                           */
+    /************************************************************************/
+    static bool writeFile(const std::string& filename, const char* pData, size_t size, bool isBinary)
+    {
+        std::ofstream outputStream(filename.c_str(), isBinary ? std::ios::binary : std::ios::out);
+        if(outputStream.fail())
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat - can't open output file " + filename);
+            return false;
+        }
+        outputStream.write(pData, size);
+        return outputStream.good();
+    }
+
+    static void writeJson(const rapidjson::Value& root, rapidjson::StringBuffer& buffer)
+    {
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.SetIndent(' ', 4);
+        root.Accept(writer);
+    }
+
+    bool SceneBinaryFormat::convertJsonToBinary(const std::string& jsonFilename, const std::string& binaryFilename)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(jsonFilename, fullpath) == false)
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat::convertJsonToBinary() - can't find file " + jsonFilename);
+            return false;
+        }
+
+        std::ifstream fileStream(fullpath);
+        std::stringstream strStream;
+        strStream << fileStream.rdbuf();
+        std::string jsonData = strStream.str();
+
+        rapidjson::Document doc;
+        doc.Parse(jsonData.c_str());
+        if(doc.HasParseError())
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat::convertJsonToBinary() - JSON parse error in " + fullpath + " at offset " + std::to_string(doc.GetErrorOffset()));
+            return false;
+        }
+
+        std::vector<uint8_t> data;
+        write(doc, data);
+        return writeFile(binaryFilename, (const char*)data.data(), data.size(), true);
+    }
+
+    bool SceneBinaryFormat::convertBinaryToJson(const std::string& binaryFilename, const std::string& jsonFilename)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(binaryFilename, fullpath) == false)
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat::convertBinaryToJson() - can't find file " + binaryFilename);
+            return false;
+        }
+
+        MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(fullpath, false);
+        if(pFile == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat::convertBinaryToJson() - can't read file " + fullpath);
+            return false;
+        }
+
+        rapidjson::Document doc;
+        std::string errorMsg;
+        if(read(pFile->getData(), pFile->getSize(), doc, errorMsg) == false)
+        {
+            Logger::log(Logger::Level::Error, "SceneBinaryFormat::convertBinaryToJson() - invalid binary scene " + fullpath + ". " + errorMsg);
+            return false;
+        }
+
+        rapidjson::StringBuffer buffer;
+        writeJson(doc, buffer);
+        return writeFile(jsonFilename, buffer.GetString(), buffer.GetSize(), false);
+    }
+}
\ No newline at end of file
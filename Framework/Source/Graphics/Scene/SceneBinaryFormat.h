@@ -0,0 +1,72 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Externals/RapidJson/include/rapidjson/document.h"
+
+namespace Falcor
+{
+    /** Binary encoding of .fscene files.
+        A binary scene holds the same document as the JSON file, so it has the same content (models, instances, lights, cameras, paths, materials and user variables) and converts to JSON and back without loss.
+        Numbers are stored in binary, vectors of floats are packed, and each string is stored once in a string table. Reading a binary scene doesn't parse any text, and the strings in the resulting document point into the source data instead of being copied.
+        SceneImporter detects binary scenes by their header, and SceneExporter writes one when the filename has the kBinaryExtension extension.
+    */
+    class SceneBinaryFormat
+    {
+    public:
+        static const char* kBinaryExtension;
+
+        /** Check if data starts with the header of a binary scene
+        */
+        static bool isBinaryScene(const uint8_t* pData, size_t size);
+
+        /** Encode a document
+            \param[in] root The root of the document
+            \param[out] data The binary scene
+        */
+        static void write(const rapidjson::Value& root, std::vector<uint8_t>& data);
+
+        /** Decode a binary scene. The strings in the document reference pData, so the data must outlive the document.
+            \param[in] pData The binary scene
+            \param[in] size The size of the data in bytes
+            \param[out] doc The document
+            \param[out] errorMsg Receives a description of the problem if the data is invalid
+            \return true if the data was decoded
+        */
+        static bool read(const uint8_t* pData, size_t size, rapidjson::Document& doc, std::string& errorMsg);
+
+        /** Convert a JSON scene file to a binary scene file. Included files are not converted.
+        */
+        static bool convertJsonToBinary(const std::string& jsonFilename, const std::string& binaryFilename);
+
+        /** Convert a binary scene file to a JSON scene file, formatted like the files SceneExporter writes
+        */
+        static bool convertBinaryToJson(const std::string& binaryFilename, const std::string& jsonFilename);
+    };
+}
\ No newline at end of file
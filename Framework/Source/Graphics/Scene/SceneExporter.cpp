@@ -33,6 +33,8 @@
 #include "SceneExportImportCommon.h"
 #include "glm/detail/func_trigonometric.hpp"
 #include "Utils/OS.h"
+#include "Utils/StringUtils.h"
+#include "SceneBinaryFormat.h"
 
 namespace Falcor
 {
@@ -109,6 +111,22 @@ namespace Falcor
         if(exportOptions & ExportPaths)             writePaths();
         if(exportOptions & ExportMaterials)         writeMaterials();
 
+        // Binary scenes store the same document
+        if(hasSuffix(mFilename, SceneBinaryFormat::kBinaryExtension, false))
+        {
+            std::vector<uint8_t> data;
+            SceneBinaryFormat::write(mJDoc, data);
+            std::ofstream outputStream(mFilename.c_str(), std::ios::binary);
+            if(outputStream.fail())
+            {
+                Logger::log(Logger::Level::Error, "Can't open output scene file " + mFilename + ".\nExporting failed.");
+                return false;
+            }
+            outputStream.write((const char*)data.data(), data.size());
+            outputStream.close();
+            return true;
+        }
+
         // Get the output string
         rapidjson::StringBuffer buffer;
         rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
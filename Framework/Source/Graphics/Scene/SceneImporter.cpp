@@ -35,6 +35,10 @@
 #include "Graphics/TextureHelper.h"
 #include "glm/detail/func_trigonometric.hpp"
 #include "SceneExportImportCommon.h"
+#include "SceneBinaryFormat.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Graphics/Model/Loaders/SimpleModelImporter.h"
+#include "Externals/RapidJson/include/rapidjson/memorystream.h"
 
 namespace Falcor
 {
@@ -149,32 +153,18 @@ namespace Falcor
         return true;
     }
 
-    bool SceneImporter::createModel(const rapidjson::Value& jsonModel)
+    bool SceneImporter::createModel(const rapidjson::Value& jsonModel, const Model::SharedPtr& pModel, bool isPlaceholder)
     {
-        // Model must have at least a filename
-        if(jsonModel.HasMember(SceneKeys::kFilename) == false)
-        {
-            error("Model must have a filename");
-            return false;
-        }
+        // The filename was validated by parseModels()
         const auto& modelFile = jsonModel[SceneKeys::kFilename];
-        if(modelFile.IsString() == false)
-        {
-            error("Model filename must be a string");
-            return false;
-        }
-
-        // Load the model
-        auto pModel = Model::createFromFile(modelFile.GetString(), mModelLoadFlags);
         if(pModel == nullptr)
         {
             return false;
         }
 
-        pModel->setName(modelFile.GetString());
         uint32_t modelID = mpScene->addModel(pModel, modelFile.GetString(), false);
 
-        // Loop over the other members
+        // Loop over the other members. The name and active animation are validated here and applied by applyModelSettings().
         for(auto& jval = jsonModel.MemberBegin(); jval != jsonModel.MemberEnd(); jval++)
         {
             std::string keyName(jval->name.GetString());
@@ -189,7 +179,6 @@ namespace Falcor
                     error("Model name should be a string value.");
                     return false;
                 }
-                pModel->setName(std::string(jval->value.GetString()));
             }
             else if(keyName == SceneKeys::kModelInstances)
             {
@@ -205,17 +194,6 @@ namespace Falcor
                     error("Model active animation should be an unsigned integer");
                     return false;
                 }
-                uint32_t activeAnimation = jval->value.GetUint();
-                if(activeAnimation >= pModel->getAnimationsCount())
-                {
-                    std::string msg = "Warning when parsing scene file \"" + mFilename + "\".\nModel " + pModel->getName() + " was specified with active animation " + std::to_string(activeAnimation);
-                    msg += ", but model only has " + std::to_string(pModel->getAnimationsCount()) + " animations. Ignoring field";
-                    Logger::log(Logger::Level::Warning, msg);
-                }
-                else
-                {
-                    pModel->setActiveAnimation(activeAnimation);
-                }
             }
             else
             {
@@ -228,9 +206,43 @@ namespace Falcor
         {
             mpScene->addModelInstance(modelID, "Instance 0", glm::vec3(0, 0, 0), glm::vec3(1, 1, 1), glm::vec3(0, 0, 0));
         }
+
+        // A placeholder is shared by all of the models, their settings are applied once they are loaded
+        if(isPlaceholder == false)
+        {
+            applyModelSettings(jsonModel, pModel.get());
+        }
         return true;
     }
 
+    void SceneImporter::applyModelSettings(const rapidjson::Value& jsonModel, Model* pModel) const
+    {
+        pModel->setName(jsonModel[SceneKeys::kFilename].GetString());
+
+        for(auto& jval = jsonModel.MemberBegin(); jval != jsonModel.MemberEnd(); jval++)
+        {
+            std::string keyName(jval->name.GetString());
+            if(keyName == SceneKeys::kName)
+            {
+                pModel->setName(std::string(jval->value.GetString()));
+            }
+            else if(keyName == SceneKeys::kActiveAnimation)
+            {
+                uint32_t activeAnimation = jval->value.GetUint();
+                if(activeAnimation >= pModel->getAnimationsCount())
+                {
+                    std::string msg = "Warning when parsing scene file \"" + mFilename + "\".\nModel " + pModel->getName() + " was specified with active animation " + std::to_string(activeAnimation);
+                    msg += ", but model only has " + std::to_string(pModel->getAnimationsCount()) + " animations. Ignoring field";
+                    Logger::log(Logger::Level::Warning, msg);
+                }
+                else
+                {
+                    pModel->setActiveAnimation(activeAnimation);
+                }
+            }
+        }
+    }
+
     bool SceneImporter::parseModels(const rapidjson::Value& jsonVal)
     {
         if(jsonVal.IsArray() == false)
@@ -239,13 +251,23 @@ namespace Falcor
             return false;
         }
 
-        // Loop over the array
+        // Loop over the array. The models are loaded together with the models of the included files after everything was parsed, see load().
         for(uint32_t i = 0; i < jsonVal.Size(); i++)
         {
-            if(createModel(jsonVal[i]) == false)
+            const auto& jsonModel = jsonVal[i];
+
+            // Model must have at least a filename
+            if(jsonModel.HasMember(SceneKeys::kFilename) == false)
             {
+                error("Model must have a filename");
                 return false;
             }
+            if(jsonModel[SceneKeys::kFilename].IsString() == false)
+            {
+                error("Model filename must be a string");
+                return false;
+            }
+            mPendingModels.push_back(&jsonModel);
         }
         return true;
     }
@@ -1069,7 +1091,7 @@ namespace Falcor
     }
 
 
-    Scene::SharedPtr SceneImporter::load(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags)
+    bool SceneImporter::parseFile(const std::string& filename, uint32_t modelLoadFlags, uint32_t sceneLoadFlags)
     {
         std::string fullpath;
         mFilename = filename;
@@ -1078,36 +1100,117 @@ namespace Falcor
 
         if(findFileInDataDirectories(filename, fullpath))
         {
-            // Load the file
-            std::ifstream fileStream(fullpath);
-            std::stringstream strStream;
-            strStream << fileStream.rdbuf();
-            std::string jsonData = strStream.str();
-            rapidjson::StringStream JStream(jsonData.c_str());
+            // Map the file. The DOM is created directly from the mapped data, and strings read from a binary scene point into it.
+            mpFile = MemoryMappedFile::create(fullpath, false);
+            if(mpFile == nullptr)
+            {
+                error("Can't read the file.");
+                return false;
+            }
+            const uint8_t* pData = mpFile->getData();
+            size_t size = mpFile->getSize();
 
             // Get the file directory
             auto last = fullpath.find_last_of("/\\");
             mDirectory = fullpath.substr(0, last);
 
             // create the DOM
-            mJDoc.ParseStream(JStream);
-
-            if(mJDoc.HasParseError())
+            if(SceneBinaryFormat::isBinaryScene(pData, size))
             {
-                size_t line;
-                line = std::count(jsonData.begin(), jsonData.begin() + mJDoc.GetErrorOffset(), '\n');
-                error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
-                return nullptr;
+                std::string errorMsg;
+                if(SceneBinaryFormat::read(pData, size, mJDoc, errorMsg) == false)
+                {
+                    error("Invalid binary scene. " + errorMsg);
+                    return false;
+                }
+            }
+            else
+            {
+                rapidjson::MemoryStream JStream((const char*)pData, size);
+                mJDoc.ParseStream<rapidjson::kParseDefaultFlags, rapidjson::UTF8<>>(JStream);
+
+                if(mJDoc.HasParseError())
+                {
+                    size_t line;
+                    line = std::count(pData, pData + mJDoc.GetErrorOffset(), '\n');
+                    error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
+                    return false;
+                }
             }
 
             // create the scene
             mpScene = Scene::create();
 
-            if(topLevelLoop() == false)
+            return topLevelLoop();
+        }
+        else
+        {
+            error("File not found.");
+            return false;
+        }
+    }
+
+    Scene::SharedPtr SceneImporter::load(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags)
+    {
+        // Parse the file and the files it includes. parseModels() only collects the models.
+        if(parseFile(filename, modelLoadFlags, sceneLoadFlags) == false)
+        {
+            return nullptr;
+        }
+
+        // Load the models of all the files together, so that they are read concurrently
+        std::vector<SceneImporter*> importers;
+        collectImporters(importers);
+        std::vector<std::string> modelFiles;
+        for(const SceneImporter* pImporter : importers)
+        {
+            for(const rapidjson::Value* pJsonModel : pImporter->mPendingModels)
             {
-                return nullptr;
+                modelFiles.push_back((*pJsonModel)[SceneKeys::kFilename].GetString());
             }
+        }
+        std::vector<Model::SharedPtr> models = Model::createFromFiles(modelFiles, mModelLoadFlags);
 
+        size_t modelIndex = 0;
+        if(finishScene(models, modelIndex, false) == false)
+        {
+            return nullptr;
+        }
+        return mpScene;
+    }
+
+    void SceneImporter::collectImporters(std::vector<SceneImporter*>& importers)
+    {
+        importers.push_back(this);
+        for(auto& pInclude : mIncludes)
+        {
+            pInclude->collectImporters(importers);
+        }
+    }
+
+    bool SceneImporter::finishScene(const std::vector<Model::SharedPtr>& models, size_t& modelIndex, bool arePlaceholders)
+    {
+        // Add the models in declaration order, then merge the included scenes. This is the order in which the models were added when each file loaded its own models.
+        for(const rapidjson::Value* pJsonModel : mPendingModels)
+        {
+            if(createModel(*pJsonModel, models[modelIndex++], arePlaceholders) == false)
+            {
+                return false;
+            }
+        }
+
+        for(auto& pInclude : mIncludes)
+        {
+            if(pInclude->finishScene(models, modelIndex, arePlaceholders) == false)
+            {
+                return false;
+            }
+            mpScene->merge(pInclude->mpScene.get());
+        }
+
+        // Placeholders don't emit light. Scene::updateLoading() creates the area lights once the models were loaded.
+        if(arePlaceholders == false)
+        {
 			switch (mSceneLoadFlags)
 			{
 				case Scene::GenerateAreaLights:
@@ -1115,14 +1218,99 @@ namespace Falcor
 					mpScene->createAreaLights();
 					break;
 			}
-			
-            return mpScene;
         }
-        else
+        return true;
+    }
+
+    static Model::SharedPtr createPlaceholderModel()
+    {
+        // A unit box, with a face per axis direction
+        struct Vertex
+        {
+            glm::vec3 position;
+            glm::vec3 normal;
+            glm::vec2 texCoord;
+        };
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        for(uint32_t axis = 0; axis < 3; axis++)
+        {
+            for(float side = -1; side <= 1; side += 2)
+            {
+                glm::vec3 normal(0, 0, 0);
+                normal[axis] = side;
+                glm::vec3 u(0, 0, 0);
+                glm::vec3 v(0, 0, 0);
+                u[(axis + 1) % 3] = 0.5f;
+                v[(axis + 2) % 3] = 0.5f * side;
+
+                uint32_t first = (uint32_t)vertices.size();
+                const glm::vec2 corners[] = {glm::vec2(-1, -1), glm::vec2(1, -1), glm::vec2(1, 1), glm::vec2(-1, 1)};
+                for(const auto& corner : corners)
+                {
+                    Vertex vertex;
+                    vertex.position = normal * 0.5f + u * corner.x + v * corner.y;
+                    vertex.normal = normal;
+                    vertex.texCoord = corner * 0.5f + 0.5f;
+                    vertices.push_back(vertex);
+                }
+                const uint32_t faceIndices[] = {0, 1, 2, 0, 2, 3};
+                for(uint32_t index : faceIndices)
+                {
+                    indices.push_back(first + index);
+                }
+            }
+        }
+
+        SimpleModelImporter::VertexFormat vertLayout;
+        vertLayout.attribs.push_back({SimpleModelImporter::AttribType::Position, 3, AttribFormat::AttribFormat_F32});
+        vertLayout.attribs.push_back({SimpleModelImporter::AttribType::Normal, 3, AttribFormat::AttribFormat_F32});
+        vertLayout.attribs.push_back({SimpleModelImporter::AttribType::TexCoord, 2, AttribFormat::AttribFormat_F32});
+        Model::SharedPtr pModel = SimpleModelImporter::create(vertLayout, (uint32_t)(vertices.size() * sizeof(Vertex)), vertices.data(), (uint32_t)(indices.size() * sizeof(uint32_t)), indices.data());
+        pModel->setName("Placeholder");
+        return pModel;
+    }
+
+    Scene::SharedPtr SceneImporter::loadSceneAsync(const std::string& filename, uint32_t modelLoadFlags, uint32_t sceneLoadFlags)
+    {
+        // The importer is kept until the models were loaded, since each model's settings are applied from its JSON entry when it replaces its placeholder
+        std::shared_ptr<SceneImporter> pImporter(new SceneImporter);
+        if(pImporter->parseFile(filename, modelLoadFlags, sceneLoadFlags) == false)
         {
-            error("File not found.");
             return nullptr;
         }
+
+        // Model IDs follow the order of finishScene()
+        std::vector<SceneImporter*> importers;
+        pImporter->collectImporters(importers);
+        std::vector<std::pair<const SceneImporter*, const rapidjson::Value*>> modelEntries;
+        for(const SceneImporter* pFileImporter : importers)
+        {
+            for(const rapidjson::Value* pJsonModel : pFileImporter->mPendingModels)
+            {
+                modelEntries.push_back(std::make_pair(pFileImporter, pJsonModel));
+            }
+        }
+
+        std::vector<Model::SharedPtr> placeholders(modelEntries.size(), modelEntries.empty() ? nullptr : createPlaceholderModel());
+        size_t modelIndex = 0;
+        if(pImporter->finishScene(placeholders, modelIndex, true) == false)
+        {
+            return nullptr;
+        }
+
+        // The scene keeps the importer alive, so the importer must not keep the scene alive
+        Scene::SharedPtr pScene = pImporter->mpScene;
+        for(SceneImporter* pFileImporter : importers)
+        {
+            pFileImporter->mpScene = nullptr;
+        }
+
+        pScene->startAsyncLoad(modelLoadFlags, sceneLoadFlags, [pImporter, modelEntries](uint32_t modelID, Model* pModel)
+        {
+            modelEntries[modelID].first->applyModelSettings(*modelEntries[modelID].second, pModel);
+        });
+        return pScene;
     }
 
     bool SceneImporter::parseAmbientIntensity(const rapidjson::Value& jsonVal)
@@ -1311,12 +1499,13 @@ namespace Falcor
             }
         }
 
-        Scene::SharedPtr pScene = SceneImporter::loadScene(fullpath, mModelLoadFlags, mSceneLoadFlags);
-        if(pScene == nullptr)
+        // The included scene is merged by finishScene(), after the models were loaded
+        std::unique_ptr<SceneImporter> pInclude(new SceneImporter);
+        if(pInclude->parseFile(fullpath, mModelLoadFlags, mSceneLoadFlags) == false)
         {
             return false;
         }
-        mpScene->merge(pScene.get());
+        mIncludes.push_back(std::move(pInclude));
 
         return true;
     }
@@ -33,6 +33,7 @@
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
 #include "Scene.h"
+#include "Utils/MemoryMappedFile.h"
 
 namespace Falcor
 {    
@@ -41,10 +42,14 @@ namespace Falcor
     protected:
         friend class Scene;
         static Scene::SharedPtr loadScene(const std::string& filename, uint32_t modelLoadFlags, uint32_t sceneLoadFlags);
+        static Scene::SharedPtr loadSceneAsync(const std::string& filename, uint32_t modelLoadFlags, uint32_t sceneLoadFlags);
 
     private:
         SceneImporter() = default;
         Scene::SharedPtr load(const std::string& filename, const uint32_t& modelLoadFlags, uint32_t sceneLoadFlags);
+        bool parseFile(const std::string& filename, uint32_t modelLoadFlags, uint32_t sceneLoadFlags);
+        void collectImporters(std::vector<SceneImporter*>& importers);
+        bool finishScene(const std::vector<Model::SharedPtr>& models, size_t& modelIndex, bool arePlaceholders);
 
         bool parseVersion(const rapidjson::Value& jsonVal);
         bool parseModels(const rapidjson::Value& jsonVal);
@@ -64,7 +69,8 @@ namespace Falcor
 
         bool loadIncludeFile(const std::string& Include);
 
-        bool createModel(const rapidjson::Value& jsonModel);
+        bool createModel(const rapidjson::Value& jsonModel, const Model::SharedPtr& pModel, bool isPlaceholder);
+        void applyModelSettings(const rapidjson::Value& jsonModel, Model* pModel) const;
         bool createModelInstances(const rapidjson::Value& jsonVal, uint32_t modelID);
         bool createPointLight(const rapidjson::Value& jsonLight);
         bool createDirLight(const rapidjson::Value& jsonLight);
@@ -88,12 +94,15 @@ namespace Falcor
 
         template<uint32_t VecSize>
         bool getFloatVec(const rapidjson::Value& jsonVal, const std::string& desc, float vec[VecSize]);
+        MemoryMappedFile::UniquePtr mpFile;     // Declared before mJDoc, since strings read from a binary scene reference the mapped data
         rapidjson::Document mJDoc;
         Scene::SharedPtr mpScene = nullptr;
         std::string mFilename;
         std::string mDirectory;
         uint32_t mModelLoadFlags = 0;
 		uint32_t mSceneLoadFlags = 0;
+        std::vector<const rapidjson::Value*> mPendingModels;        // Model entries collected by parseModels(), created by finishScene()
+        std::vector<std::unique_ptr<SceneImporter>> mIncludes;      // Parsed included files, merged by finishScene()
 
         struct FuncValue
         {
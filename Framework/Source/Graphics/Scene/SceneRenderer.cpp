@@ -37,6 +37,8 @@
 #include "Core/Window.h"
 #include "glm/matrix.hpp"
 #include "Graphics/Material/MaterialSystem.h"
+#include "Graphics/TextureStreamer.h"
+#include "Core/CommandList.h"
 
 namespace Falcor
 {
@@ -89,19 +91,31 @@ namespace Falcor
 
         // Per skinned mesh
         uint32_t bufferLoc = pProgram->getUniformBufferBinding(kPerSkinnedMeshCbName);
-        pRenderContext->setUniformBuffer(bufferLoc, sPerSkinnedMeshCB);
+        setUniformBuffer(pRenderContext, bufferLoc, sPerSkinnedMeshCB);
 
         // Per static mesh
         bufferLoc = pProgram->getUniformBufferBinding(kPerStaticMeshCbName);
-        pRenderContext->setUniformBuffer(bufferLoc, sPerStaticMeshCB);
+        setUniformBuffer(pRenderContext, bufferLoc, sPerStaticMeshCB);
 
         // Per material
         bufferLoc = pProgram->getUniformBufferBinding(kPerMaterialCbName);
-        pRenderContext->setUniformBuffer(bufferLoc, sPerMaterialCB);
+        setUniformBuffer(pRenderContext, bufferLoc, sPerMaterialCB);
 
         // Per frame
         bufferLoc = pProgram->getUniformBufferBinding(kPerFrameCbName);
-        pRenderContext->setUniformBuffer(bufferLoc, sPerFrameCB);
+        setUniformBuffer(pRenderContext, bufferLoc, sPerFrameCB);
+    }
+
+    void SceneRenderer::setUniformBuffer(RenderContext* pContext, uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer)
+    {
+        if(mpCommandList)
+        {
+            mpCommandList->setUniformBuffer(index, pBuffer);
+        }
+        else
+        {
+            pContext->setUniformBuffer(index, pBuffer);
+        }
     }
 
     void SceneRenderer::setPerFrameData(RenderContext* pContext, const CurrentWorkingData& currentData)
@@ -166,15 +180,34 @@ namespace Falcor
             if(mCompileMaterialWithProgram)
             {
                 ProgramVersion::SharedConstPtr pPatchedProgram = MaterialSystem::patchActiveProgramVersion(currentData.pProgram, mpLastMaterial);
-                pContext->setProgram(pPatchedProgram);
+                setProgram(pContext, pPatchedProgram);
             }
         }
 
         // Draw
-        pContext->drawIndexedInstanced(pMesh->getIndexCount(), instanceCount, 0, 0, 0);
+        if(mpCommandList)
+        {
+            mpCommandList->drawIndexedInstanced(pMesh->getIndexCount(), instanceCount, 0, 0, 0);
+        }
+        else
+        {
+            pContext->drawIndexedInstanced(pMesh->getIndexCount(), instanceCount, 0, 0, 0);
+        }
         postFlushDraw(pContext, currentData);
     }
 
+    void SceneRenderer::setProgram(RenderContext* pContext, const ProgramVersion::SharedConstPtr& pProgram)
+    {
+        if(mpCommandList)
+        {
+            mpCommandList->setProgram(pProgram);
+        }
+        else
+        {
+            pContext->setProgram(pProgram);
+        }
+    }
+
     void SceneRenderer::postFlushDraw(RenderContext* pContext, const CurrentWorkingData& currentData)
     {
 
@@ -187,8 +220,16 @@ namespace Falcor
 		if (setPerMeshData(pContext, currentData))
 		{
 			// Bind VAO and set topology
-			pContext->setVao(pMesh->getVao());
-			pContext->setTopology(pMesh->getTopology());
+			if(mpCommandList)
+			{
+				mpCommandList->setVao(pMesh->getVao());
+				mpCommandList->setTopology(pMesh->getTopology());
+			}
+			else
+			{
+				pContext->setVao(pMesh->getVao());
+				pContext->setTopology(pMesh->getTopology());
+			}
 
 			uint32_t InstanceCount = pMesh->getInstanceCount();
 
@@ -201,6 +242,12 @@ namespace Falcor
 
 				if ((mCullEnabled == false) || (pCamera->isObjectCulled(box) == false))
 				{
+					if(mpTextureStreamer)
+					{
+						glm::mat4 worldMat = pMesh->hasBones() ? translation : translation * pMesh->getInstanceMatrix(instanceID);
+						mpTextureStreamer->requestMesh(pMesh, worldMat, box);
+					}
+
 					if (setPerMeshInstanceData(pContext, translation, instanceID, activeInstances, currentData))
 					{
 						activeInstances++;
@@ -208,7 +255,7 @@ namespace Falcor
 						if (activeInstances == mMaxInstanceCount)
 						{
 
-							pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
+							setProgram(pContext, currentData.pProgram->getActiveProgramVersion());
 							flushDraw(pContext, pMesh, activeInstances, currentData);
 							activeInstances = 0;
 						}
@@ -217,7 +264,7 @@ namespace Falcor
 			}
 			if(activeInstances != 0)
 			{
-				pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
+				setProgram(pContext, currentData.pProgram->getActiveProgramVersion());
 				flushDraw(pContext, currentData.pMesh, activeInstances, currentData);
 			}
 		}
@@ -294,6 +341,11 @@ namespace Falcor
         setupVR();
         setPerFrameData(pContext, currentData);
 
+        if(mpTextureStreamer && pCamera && pContext)
+        {
+            mpTextureStreamer->setView(pCamera, pContext->getViewport(0).height);
+        }
+
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
         {
             for (uint32_t InstanceID = 0; InstanceID < mpScene->getModelInstanceCount(modelID); InstanceID++)
@@ -307,6 +359,13 @@ namespace Falcor
         }
     }
 
+    void SceneRenderer::recordScene(CommandList* pList, Program* pProgram, Camera* pCamera)
+    {
+        mpCommandList = pList;
+        renderScene(nullptr, pProgram, pCamera);
+        mpCommandList = nullptr;
+    }
+
     void SceneRenderer::setCameraControllerType(CameraControllerType type)
     {
         switch(type)
@@ -33,6 +33,7 @@
 #include "SceneEditor.h"
 #include "utils/CpuTimer.h"
 #include "Core/UniformBuffer.h"
+#include "Core/ProgramVersion.h"
 
 namespace Falcor
 {
@@ -42,6 +43,8 @@ namespace Falcor
     class Material;
     class Mesh;
     class Camera;
+    class TextureStreamer;
+    class CommandList;
 
     class SceneRenderer
     {
@@ -67,7 +70,16 @@ namespace Falcor
             Call update() before using this function otherwise model animation will not work
         */
         void renderScene(RenderContext* pContext, Program* pProgram, Camera* pCamera);
-        
+
+        /** Record the scene's draws into a command list instead of rendering them. Execute the list to render the scene.
+            The uniform buffers are shared by all the scene renderers and their data is captured when the draws are recorded, so only one thread at a time may record or render a scene.
+            The texture streamer's view isn't updated, call TextureStreamer#setView() before recording. Subclasses' per-frame/model/mesh hooks receive a null render-context.
+            \param[in] pList The list to append the commands to
+            \param[in] pProgram The program to render with
+            \param[in] pCamera The camera to render from
+        */
+        void recordScene(CommandList* pList, Program* pProgram, Camera* pCamera);
+
         /** Update the camera and model animation.
             Should be called before renderScene(), unless not animations are used and you update the camera manualy
         */
@@ -89,6 +101,11 @@ namespace Falcor
         */
         void setUnloadTexturesOnMaterialChange(bool unload) { mUnloadTexturesOnMaterialChange = unload; }
 
+        /** Set a texture streamer to report the drawn meshes to. The streamer should have been initialized with TextureStreamer#addScene() for this scene, and TextureStreamer#update() should be called once per frame.\n
+        This is a better alternative to setUnloadTexturesOnMaterialChange() for scenes which don't fit into GPU memory. Pass nullptr to disable.
+        */
+        void setTextureStreamer(TextureStreamer* pStreamer) { mpTextureStreamer = pStreamer; }
+
         enum class CameraControllerType
         {
             FirstPerson,
@@ -129,6 +146,7 @@ namespace Falcor
     private:
         void createUniformBuffers(Program* pProgram);
         void bindUniformBuffers(RenderContext* pRenderContext, Program* pProgram);
+        void setUniformBuffer(RenderContext* pContext, uint32_t index, const UniformBuffer::SharedConstPtr& pBuffer);
 
         virtual void setPerFrameData(RenderContext* pContext, const CurrentWorkingData& currentData);
         virtual bool setPerModelData(RenderContext* pContext, const CurrentWorkingData& currentData);
@@ -140,6 +158,7 @@ namespace Falcor
         void renderModel(RenderContext* pContext, Program* pProgram, const Model* pModel, const glm::mat4& instanceMatrix, Camera* pCamera, CurrentWorkingData& currentData);
         void renderMesh(RenderContext* pContext, const Mesh* pMesh, const glm::mat4& translation, Camera* pCamera, CurrentWorkingData& currentData);
         void flushDraw(RenderContext* pContext, const Mesh* pMesh, uint32_t instanceCount, CurrentWorkingData& currentData);
+        void setProgram(RenderContext* pContext, const ProgramVersion::SharedConstPtr& pProgram);
 
     protected:
         void setupVR();
@@ -151,7 +170,9 @@ namespace Falcor
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
         bool mUnloadTexturesOnMaterialChange = false;
+        TextureStreamer* mpTextureStreamer = nullptr;
         RenderMode mRenderMode = RenderMode::Mono;
         bool mCompileMaterialWithProgram = true;
+        CommandList* mpCommandList = nullptr;      ///< Set while recording, the draws go into the list instead of the render-context
     };
 }
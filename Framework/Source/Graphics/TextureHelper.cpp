@@ -30,8 +30,10 @@
 #include "Core/Texture.h"
 #include "Utils/Bitmap.h"
 #include "Core/DDSHeader.h"
-#include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/ImageProcessing.h"
+#include "Utils/ParallelFor.h"
 
 #ifdef FALCOR_GL
 static const bool kTopDown = false;
@@ -114,8 +116,6 @@ namespace Falcor
 		case DXGI_FORMAT_BC6H_UF16:
 		case DXGI_FORMAT_BC6H_SF16:
 		case DXGI_FORMAT_BC7_TYPELESS:
-		case DXGI_FORMAT_BC7_UNORM:
-		case DXGI_FORMAT_BC7_UNORM_SRGB:
 			return ResourceFormat::Unknown;
 		case DXGI_FORMAT_R32G32B32A32_FLOAT:
 			return ResourceFormat::RGBA32Float;
@@ -245,6 +245,10 @@ namespace Falcor
 			return ResourceFormat::BC5Unorm;
 		case DXGI_FORMAT_BC5_SNORM:
 			return ResourceFormat::BC5Snorm;
+		case DXGI_FORMAT_BC7_UNORM:
+			return ResourceFormat::BC7Unorm;
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return ResourceFormat::BC7UnormSrgb;
 		default:
 			return ResourceFormat::Unknown;
 		}
@@ -493,16 +497,12 @@ namespace Falcor
 		}
 	}
 
-	//Flip the data so it follows opengl conventions
-	void flipData(DdsData& ddsData, ResourceFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipDepth, bool isCubemap = false)
+	//Flip the data in-place so it follows opengl conventions
+	void flipData(uint8_t* pData, ResourceFormat format, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipDepth, bool isCubemap = false)
 	{
 		if (!isCompressedFormat(format) && !kTopDown)
 		{
-			std::vector<uint8_t> oldData(ddsData.data.size());
-			oldData.swap(ddsData.data);
-			const uint8_t* currentTexture = oldData.data();
-			const uint8_t* currentDepth = oldData.data();
-			uint8_t* currentPos = ddsData.data.data();
+			uint8_t* currentDepth = pData;
 
 			for (uint32_t mipCounter = 0; mipCounter < mipDepth; ++mipCounter)
 			{
@@ -512,26 +512,25 @@ namespace Falcor
 
 				for (uint32_t depthCounter = 0; depthCounter < depth; ++depthCounter)
 				{
-					currentTexture = currentDepth + depthPitch * depthCounter;
+					uint8_t* currentTexture = currentDepth + depthPitch * depthCounter;
 					
-					if (isCubemap)
+					if (isCubemap && (depthCounter % 6 == 2))
 					{
-						if (depthCounter % 6 == 2)
-						{
-							currentTexture += depthPitch;
-						}
-						else if (depthCounter % 6 == 3)
+						// Swap the +Y and -Y faces, flipping both of them
+						uint8_t* nextTexture = currentTexture + depthPitch;
+						for (uint32_t heightCounter = 0; heightCounter < currentMipHeight; ++heightCounter)
 						{
-							currentTexture -= depthPitch;
+							ImageProcessing::swapRows(currentTexture + heightCounter * heightPitch, nextTexture + (currentMipHeight - 1 - heightCounter) * heightPitch, heightPitch);
 						}
+						++depthCounter;
 					}
-					
-					for (uint32_t heightCounter = 1; heightCounter <= currentMipHeight; ++heightCounter)
+					else
 					{
-						memcpy(currentPos, currentTexture + (currentMipHeight - heightCounter) * heightPitch, heightPitch);
-						currentPos += heightPitch;
+						for (uint32_t heightCounter = 0; heightCounter < currentMipHeight / 2; ++heightCounter)
+						{
+							ImageProcessing::swapRows(currentTexture + heightCounter * heightPitch, currentTexture + (currentMipHeight - 1 - heightCounter) * heightPitch, heightPitch);
+						}
 					}
-					
 				}
 
 				currentDepth += depthPitch * depth;
@@ -539,196 +538,378 @@ namespace Falcor
 		}
 	}
 
-	void loadDDSDataFromFile(const std::string filename, DdsData& ddsData)
+    /** Get the texture type of a DDS file, and the number of 2D images in its most detailed mip-level
+        \return false if the file's dimension isn't supported
+    */
+    static bool getDdsLayout(const DdsData& ddsData, Texture::Type& type, uint32_t& imageCount)
+    {
+        if(ddsData.hasDX10Header)
+        {
+            uint32_t arraySize = ddsData.dx10Header.arraySize;
+            switch(ddsData.dx10Header.resourceDimension)
+            {
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE1D:
+                type = Texture::Type::Texture1D;
+                imageCount = arraySize;
+                return true;
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE2D:
+                if(ddsData.dx10Header.miscFlag & DdsHeaderDX10::kCubeMapMask)
+                {
+                    type = Texture::Type::TextureCube;
+                    imageCount = 6 * arraySize;
+                }
+                else
+                {
+                    type = Texture::Type::Texture2D;
+                    imageCount = arraySize;
+                }
+                return true;
+            case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE3D:
+                type = Texture::Type::Texture3D;
+                imageCount = ddsData.header.depth;
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        if(ddsData.header.flags & DdsHeader::kDepthMask)
+        {
+            type = Texture::Type::Texture3D;
+            imageCount = ddsData.header.depth;
+        }
+        else if(ddsData.header.caps[1] & DdsHeader::kCaps2CubeMapMask)
+        {
+            type = Texture::Type::TextureCube;
+            imageCount = 6;
+        }
+        else
+        {
+            type = Texture::Type::Texture2D;
+            imageCount = 1;
+        }
+        return true;
+    }
+
+    /** Calculate the size of the data a DDS file must contain
+    */
+    static size_t calcDdsDataSize(ResourceFormat format, uint32_t width, uint32_t height, Texture::Type type, uint32_t imageCount, uint32_t mipLevels)
+    {
+        uint32_t blockWidth = getFormatWidthCompressionRatio(format);
+        uint32_t blockHeight = getFormatHeightCompressionRatio(format);
+        size_t size = 0;
+        for(uint32_t mip = 0; mip < mipLevels; mip++)
+        {
+            size_t rowSize = ((max(width >> mip, 1U) + blockWidth - 1) / blockWidth) * getFormatBytesPerBlock(format);
+            size_t rowCount = (max(height >> mip, 1U) + blockHeight - 1) / blockHeight;
+            size_t images = (type == Texture::Type::Texture3D) ? max(imageCount >> mip, 1U) : imageCount;
+            size += rowSize * rowCount * images;
+        }
+        return size;
+    }
+
+    /** Map a DDS file, validate its headers and prepare its data for upload. The headers are read from the mapped range and the texture data is never copied.
+        Uncompressed data is flipped in-place for backends which expect bottom-up rows. The mapping is copy-on-write, so the file itself is never modified.
+        \return false if the file can't be loaded
+    */
+	bool loadDDSDataFromFile(const std::string filename, DdsData& ddsData, bool generateMips)
 	{
         std::string fullpath;
 		if (findFileInDataDirectories(filename, fullpath) == false)
 		{
 			Logger::log(Logger::Level::Error, std::string("Can't find texture file ") + filename);
 			//could not find file
-			return;
+			return false;
 		}
 
-		BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+        ddsData.pFile = MemoryMappedFile::create(fullpath, !kTopDown);
+        if(ddsData.pFile == nullptr)
+        {
+            return false;
+        }
+
+        const uint8_t* pFileData = ddsData.pFile->getData();
+        size_t fileSize = ddsData.pFile->getSize();
+        size_t offset = sizeof(uint32_t) + sizeof(DdsHeader);
 
 		//check the dds identifier
-		uint32_t ddsIdentifier;
-		stream >> ddsIdentifier;
-		if (ddsIdentifier != kDdsMagicNumber)
+		uint32_t ddsIdentifier = 0;
+        if(fileSize >= offset)
+        {
+            memcpy(&ddsIdentifier, pFileData, sizeof(uint32_t));
+            memcpy(&ddsData.header, pFileData + sizeof(uint32_t), sizeof(DdsHeader));
+        }
+
+		if (ddsIdentifier != kDdsMagicNumber || ddsData.header.headerSize != sizeof(DdsHeader))
 		{
 			//not valid dds file apparently
 			Logger::log(Logger::Level::Error, std::string("The dds file ") + filename + std::string(" is not a valid dds file"));
-			return;
+			return false;
 		}
 
-        stream >> ddsData.header;
-
-        if((ddsData.header.pixelFormat.flags & DdsHeader::PixelFormat::kFourCCFlag) && (makeFourCC("DX10") == ddsData.header.pixelFormat.fourCC))
+        ddsData.hasDX10Header = (ddsData.header.pixelFormat.flags & DdsHeader::PixelFormat::kFourCCFlag) && (makeFourCC("DX10") == ddsData.header.pixelFormat.fourCC);
+        if(ddsData.hasDX10Header)
 		{
-            ddsData.hasDX10Header = true;
-            stream >> ddsData.dx10Header;
+            if(fileSize < offset + sizeof(DdsHeaderDX10))
+            {
+                Logger::log(Logger::Level::Error, std::string("The dds file ") + filename + std::string(" is truncated"));
+                return false;
+            }
+            memcpy(&ddsData.dx10Header, pFileData + offset, sizeof(DdsHeaderDX10));
+            offset += sizeof(DdsHeaderDX10);
 		}
-		else
+
+		ddsData.format = getDdsResourceFormat(ddsData);
+
+        // One reason to hit this error is files that use an old header with R10G10B10A2 format.
+        // Older exporters used to swap the R and B channels. Newer exporter probably don't do that or they specify the format using the DX10 header.
+        // Our loader compiles with the older behavior. If you have an R10G10B10A2 texture, try one of the following:
+        //  - Re-export the texture with an exporter that supports DX10 header
+        //  - Switch the r and g masks in the 'checkDdsChannelMask()' call
+        if(ddsData.format == ResourceFormat::Unknown)
+        {
+            Logger::log(Logger::Level::Error, std::string("The dds file ") + filename + std::string(" has an unsupported format"));
+            return false;
+        }
+
+        Texture::Type type;
+        uint32_t imageCount;
+        if(getDdsLayout(ddsData, type, imageCount) == false || imageCount == 0 || ddsData.header.width == 0)
+        {
+            //these file formats are not supported 
+            Logger::log(Logger::Level::Error, std::string("the resource dimension specified in ") + filename + std::string(" is not supported by Falcor"));
+            return false;
+        }
+
+		ddsData.mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
+		// Use the file's mip-chain if it has one. Compressed formats can't generate mips on the GPU.
+		if (generateMips && ddsData.mipLevels == 1)
 		{
-            ddsData.hasDX10Header = false;
+			ddsData.mipLevels = Texture::kEntireMipChain;
 		}
 
-        uint32_t dataSize = stream.getRemainingStreamSize();
-        ddsData.data.resize(dataSize);
-        stream.read(ddsData.data.data(), dataSize);
-	}
+        uint32_t storedMips = (ddsData.mipLevels == Texture::kEntireMipChain) ? 1 : ddsData.mipLevels;
+        uint32_t height = max(ddsData.header.height, 1U);
+        ddsData.dataSize = calcDdsDataSize(ddsData.format, ddsData.header.width, height, type, imageCount, storedMips);
+        if(fileSize - offset < ddsData.dataSize)
+        {
+            Logger::log(Logger::Level::Error, std::string("The dds file ") + filename + std::string(" is truncated"));
+            return false;
+        }
 
-    Texture::SharedPtr createTextureFromDx10Dds(DdsData& ddsData, const std::string& filename, ResourceFormat format, uint32_t mipLevels)
-    {
-        uint32_t arraySize = ddsData.dx10Header.arraySize;
-        assert(arraySize > 0);
+        // Read the pages now, so that loading many files in parallel also reads from the disk in parallel
+        ddsData.pFile->prefetch(offset, ddsData.dataSize);
 
-        switch(ddsData.dx10Header.resourceDimension)
+        // Legacy cubemaps are not flipped
+        bool isLegacyCube = (ddsData.hasDX10Header == false) && (type == Texture::Type::TextureCube);
+        if(isCompressedFormat(ddsData.format) || kTopDown || isLegacyCube || type == Texture::Type::Texture1D)
         {
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE1D:
-            return Texture::create1D(ddsData.header.width, format, arraySize, mipLevels, ddsData.data.data());
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE2D:
-            if(ddsData.dx10Header.miscFlag & DdsHeaderDX10::kCubeMapMask)
+            ddsData.pData = const_cast<uint8_t*>(pFileData) + offset;
+        }
+        else
+        {
+            ddsData.pData = ddsData.pFile->getWritableData() + offset;
+            if(type == Texture::Type::Texture3D)
             {
-                flipData(ddsData, format, ddsData.header.width, ddsData.header.height, 6 * arraySize, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels, true);
-                return Texture::createCube(ddsData.header.width, ddsData.header.height, format, arraySize, mipLevels, ddsData.data.data());
+                // Each mip-level of a volume has half the slices of the previous one
+                uint8_t* pMip = ddsData.pData;
+                for(uint32_t mip = 0; mip < storedMips; mip++)
+                {
+                    uint32_t depth = max(imageCount >> mip, 1U);
+                    flipData(pMip, ddsData.format, max(ddsData.header.width >> mip, 1U), max(height >> mip, 1U), depth, 1);
+                    pMip += calcDdsDataSize(ddsData.format, max(ddsData.header.width >> mip, 1U), max(height >> mip, 1U), Texture::Type::Texture2D, depth, 1);
+                }
             }
             else
             {
-                flipData(ddsData, format, ddsData.header.width, ddsData.header.height, arraySize, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels);
-                return Texture::create2D(ddsData.header.width, ddsData.header.height, format, arraySize, mipLevels, ddsData.data.data());
+                flipData(ddsData.pData, ddsData.format, ddsData.header.width, height, imageCount, storedMips, type == Texture::Type::TextureCube);
             }
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_TEXTURE3D:
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, ddsData.header.depth, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels);
-            return Texture::create3D(ddsData.header.width, ddsData.header.height, ddsData.header.depth, format, mipLevels, ddsData.data.data());
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_BUFFER:
-        case D3D10_RESOURCE_DIMENSION::D3D10_RESOURCE_DIMENSION_UNKNOWN:
-            //these file formats are not supported 
-            Logger::log(Logger::Level::Error, std::string("the resource dimension specified in ") + filename + std::string(" is not supported by Falcor"));
+        }
+        return true;
+	}
+
+    /** Create a texture from a DDS file loaded with loadDDSDataFromFile(). The data is uploaded directly from the mapped file.
+    */
+    Texture::SharedPtr createTextureFromDdsData(const DdsData& ddsData)
+    {
+        Texture::Type type;
+        uint32_t imageCount;
+        getDdsLayout(ddsData, type, imageCount);
+        uint32_t arraySize = ddsData.hasDX10Header ? ddsData.dx10Header.arraySize : 1;
+
+        switch(type)
+        {
+        case Texture::Type::Texture1D:
+            return Texture::create1D(ddsData.header.width, ddsData.format, arraySize, ddsData.mipLevels, ddsData.pData);
+        case Texture::Type::Texture2D:
+            return Texture::create2D(ddsData.header.width, ddsData.header.height, ddsData.format, arraySize, ddsData.mipLevels, ddsData.pData);
+        case Texture::Type::Texture3D:
+            return Texture::create3D(ddsData.header.width, ddsData.header.height, ddsData.header.depth, ddsData.format, ddsData.mipLevels, ddsData.pData);
+        case Texture::Type::TextureCube:
+            return Texture::createCube(ddsData.header.width, ddsData.header.height, ddsData.format, arraySize, ddsData.mipLevels, ddsData.pData);
         default:
             should_not_get_here();
             return nullptr;
         }
     }
 
-    Texture::SharedPtr createTextureFromLegacyDds(DdsData& ddsData, const std::string& filename, ResourceFormat format, uint32_t mipLevels)
+	Texture::SharedPtr createTextureFromDDSFile(const std::string filename, bool generateMips)
+	{
+		DdsData ddsData;
+		if (loadDDSDataFromFile(filename, ddsData, generateMips) == false)
+		{
+			return nullptr;
+		}
+
+		return createTextureFromDdsData(ddsData);
+	}
+
+    std::vector<Texture::SharedPtr> createTexturesFromDDSFiles(const std::vector<std::string>& filenames, bool generateMipLevels, DdsLoadStats* pStats)
     {
-        //load the volume or 3D texture
-        if(ddsData.header.flags & DdsHeader::kDepthMask)
+        // Map, validate and flip the files in parallel. Textures must be created on the thread which owns the device.
+        auto start = CpuTimer::getCurrentTimePoint();
+        std::vector<DdsData> ddsData(filenames.size());
+        parallelFor((uint32_t)filenames.size(), 1, [&](uint32_t begin, uint32_t end)
         {
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, ddsData.header.depth, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels);
-            return Texture::create3D(ddsData.header.width, ddsData.header.height, ddsData.header.depth, format, mipLevels, ddsData.data.data());
-        }
-        //load the cubemap texture
-        else if(ddsData.header.caps[1] & DdsHeader::kCaps2CubeMapMask)
+            for(uint32_t i = begin; i < end; i++)
+            {
+                if(loadDDSDataFromFile(filenames[i], ddsData[i], generateMipLevels) == false)
+                {
+                    ddsData[i].pFile = nullptr;
+                }
+            }
+        });
+        auto loaded = CpuTimer::getCurrentTimePoint();
+
+        std::vector<Texture::SharedPtr> textures(filenames.size());
+        DdsLoadStats stats;
+        for(size_t i = 0; i < filenames.size(); i++)
         {
-            //				flipData(data, fmt, data.header.width, data.header.height, 6, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels, true);
-            return Texture::createCube(ddsData.header.width, ddsData.header.height, format, 1, mipLevels, ddsData.data.data());
+            if(ddsData[i].pFile)
+            {
+                textures[i] = createTextureFromDdsData(ddsData[i]);
+                stats.fileCount++;
+                stats.dataSize += ddsData[i].dataSize;
+
+                // Unmap the file as soon as its data is uploaded
+                ddsData[i].pFile = nullptr;
+            }
         }
-        //This is a 2D Texture
-        else
+
+        if(pStats)
         {
-            flipData(ddsData, format, ddsData.header.width, ddsData.header.height, 1, mipLevels == Texture::kEntireMipChain ? 1 : mipLevels);
-            return Texture::create2D(ddsData.header.width, ddsData.header.height, format, 1, mipLevels, ddsData.data.data());
+            stats.readTime = CpuTimer::calcDuration(start, loaded);
+            stats.uploadTime = CpuTimer::calcDuration(loaded, CpuTimer::getCurrentTimePoint());
+            *pStats = stats;
         }
-
-        should_not_get_here();
-        return nullptr;
+        return textures;
     }
 
-	Texture::SharedPtr createTextureFromDDSFile(const std::string filename, bool generateMips)
-	{
-		DdsData ddsData;
-		loadDDSDataFromFile(filename, ddsData);
-		
-		ResourceFormat format = getDdsResourceFormat(ddsData);
-
-        // One reason to hit this assertion is files that use an old header with R10G10B10A2 format.
-        // Older exporters used to swap the R and B channels. Newer exporter probably don't do that or they specify the format using the DX10 header.
-        // Our loader compiles with the older behavior. If you have an R10G10B10A2 texture, try one of the following:
-        //  - Re-export the texture with an exporter that supports DX10 header
-        //  - Switch the r and g masks in the 'checkDdsChannelMask()' call
-		assert(format != ResourceFormat::Unknown);
+    DdsLoadStats benchmarkDDSLoading(const std::vector<std::string>& filenames, uint32_t iterations)
+    {
+        DdsLoadStats average;
+        iterations = max(iterations, 1U);
+        for(uint32_t i = 0; i < iterations; i++)
+        {
+            DdsLoadStats stats;
+            createTexturesFromDDSFiles(filenames, false, &stats);
+            average.fileCount = stats.fileCount;
+            average.dataSize = stats.dataSize;
+            average.readTime += stats.readTime / iterations;
+            average.uploadTime += stats.uploadTime / iterations;
+        }
 
-		uint32_t mipLevels;
+        Logger::log(Logger::Level::Info, "DDS loading - " + std::to_string(average.fileCount) + " files, " + std::to_string(average.dataSize >> 20) + " MB. Read " + std::to_string(average.readTime) + " ms, upload " + std::to_string(average.uploadTime) + " ms.");
+        return average;
+    }
 
-		if (generateMips)
-		{
-			mipLevels = Texture::kEntireMipChain;
-		} 
-		else
-		{
-			mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
-		}
-	
-		if (ddsData.hasDX10Header)
-		{
-            return createTextureFromDx10Dds(ddsData, filename, format, mipLevels);
-		}
-		else
-		{
-            return createTextureFromLegacyDds(ddsData, filename, format, mipLevels);
-		}
-		
-		return nullptr;
-	}
+    bool isBitmapTextureFile(const std::string& filename)
+    {
+        return hasSuffix(filename, ".dds") == false;
+    }
 
-	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb)
+    TextureImage::UniqueConstPtr loadTextureImage(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool generateMipsOnCpu)
     {
 #define no_srgb()   \
     if(loadAsSrgb)  \
     {               \
         Logger::log(Logger::Level::Warning, "createTexture2DFromFile() warning. " + std::to_string(pBitmap->getBytesPerPixel()) + " channel images doesn't have a matching sRGB format. Loading in linear space.");  \
     }
-			
-		if (hasSuffix(filename, ".dds"))
-		{
-			return createTextureFromDDSFile(filename, generateMipLevels);
-		}
 
         Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-        Texture::SharedPtr pTex;
+        if(pBitmap == nullptr)
+        {
+            return nullptr;
+        }
 
-        if(pBitmap)
+        ResourceFormat texFormat = ResourceFormat::Unknown;
+        switch(pBitmap->getBytesPerPixel())
         {
-            ResourceFormat texFormat;
-            switch(pBitmap->getBytesPerPixel())
-            {
-            case 16:
-                texFormat = ResourceFormat::RGBA32Float;
-                break;
-            case 12:
-                texFormat = ResourceFormat::RGB32Float;
-                break;
-            case 8:
-                texFormat = ResourceFormat::RGBA16Float;
-                break;
-            case 6:
-                texFormat = ResourceFormat::RGB16Float;
-                break;
-            case 4:
-                texFormat = loadAsSrgb ? ResourceFormat::BGRA8UnormSrgb : ResourceFormat::BGRA8Unorm;
-                break;
-            case 3:
-                texFormat = loadAsSrgb ? ResourceFormat::BGRX8UnormSrgb : ResourceFormat::BGRX8Unorm;
-                break;
-            case 2:
-                no_srgb();
-                texFormat = ResourceFormat::RG8Unorm;
-                break;
-            case 1:
-                no_srgb();
-                texFormat = ResourceFormat::R8Unorm;
-                break;
-            default:
-                should_not_get_here();
-                break;
-            }
+        case 16:
+            texFormat = ResourceFormat::RGBA32Float;
+            break;
+        case 12:
+            texFormat = ResourceFormat::RGB32Float;
+            break;
+        case 8:
+            texFormat = ResourceFormat::RGBA16Float;
+            break;
+        case 6:
+            texFormat = ResourceFormat::RGB16Float;
+            break;
+        case 4:
+            texFormat = loadAsSrgb ? ResourceFormat::BGRA8UnormSrgb : ResourceFormat::BGRA8Unorm;
+            break;
+        case 3:
+            texFormat = loadAsSrgb ? ResourceFormat::BGRX8UnormSrgb : ResourceFormat::BGRX8Unorm;
+            break;
+        case 2:
+            no_srgb();
+            texFormat = ResourceFormat::RG8Unorm;
+            break;
+        case 1:
+            no_srgb();
+            texFormat = ResourceFormat::R8Unorm;
+            break;
+        default:
+            should_not_get_here();
+            return nullptr;
+        }
 
-            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kEntireMipChain : 1, pBitmap->getData());
-            pTex->setSourceFilename(filename);
+        TextureImage::UniquePtr pImage(new TextureImage);
+        pImage->format = texFormat;
+        pImage->mipLevels = generateMipLevels ? Texture::kEntireMipChain : 1;
+        if(generateMipLevels && generateMipsOnCpu && ImageProcessing::isMipGenerationSupported(texFormat) && getFormatBytesPerBlock(texFormat) == pBitmap->getBytesPerPixel())
+        {
+            pImage->mipChain = ImageProcessing::generateMipChain(pBitmap->getData(), pBitmap->getWidth(), pBitmap->getHeight(), texFormat, ImageProcessing::MipFilter::Box, pImage->mipLevels);
         }
-        return pTex;
+        pImage->pBitmap = std::move(pBitmap);
+        return std::move(pImage);
     }
 #undef no_srgb
+
+    Texture::SharedPtr createTextureFromImage(const TextureImage* pImage, const std::string& filename)
+    {
+        if(pImage == nullptr)
+        {
+            return nullptr;
+        }
+
+        const Bitmap* pBitmap = pImage->pBitmap.get();
+        const void* pData = pImage->mipChain.empty() ? pBitmap->getData() : pImage->mipChain.data();
+        Texture::SharedPtr pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), pImage->format, 1, pImage->mipLevels, pData);
+        pTex->setSourceFilename(filename);
+        return pTex;
+    }
+
+	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool generateMipsOnCpu)
+    {
+		if (isBitmapTextureFile(filename) == false)
+		{
+			return createTextureFromDDSFile(filename, generateMipLevels);
+		}
+
+        TextureImage::UniqueConstPtr pImage = loadTextureImage(filename, generateMipLevels, loadAsSrgb, generateMipsOnCpu);
+        return createTextureFromImage(pImage.get(), filename);
+    }
 }
@@ -27,7 +27,9 @@
 ***************************************************************************/
 #pragma once
 #include <string>
+#include <vector>
 #include "Core/Texture.h"
+#include "Utils/Bitmap.h"
 namespace Falcor
 {
     /*!
@@ -39,8 +41,62 @@ namespace Falcor
         \param[in] Filename Filename
         \param[in] bCreateMipChain true is mip-chain should be generated, otherwise false
         \param[in] bSrgb Load the texture using sRGB format. Only valid for 3/4 component textures.
+        \param[in] generateMipsOnCpu Generate the mip-chain on the CPU with sRGB-correct filtering, instead of on the GPU. DDS files always use their own mip-chain.
     */
-	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb);
+	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool generateMipsOnCpu = false);
+
+    /** Check if createTextureFromFile() loads a file through loadTextureImage(). DDS files are loaded directly into the texture instead.
+    */
+    bool isBitmapTextureFile(const std::string& filename);
+
+    /** An image file decoded by loadTextureImage(), ready to be uploaded
+    */
+    struct TextureImage
+    {
+        using UniquePtr = std::unique_ptr<TextureImage>;
+        using UniqueConstPtr = std::unique_ptr<const TextureImage>;
+
+        Bitmap::UniqueConstPtr pBitmap;
+        ResourceFormat format = ResourceFormat::Unknown;
+        uint32_t mipLevels = 1;             ///< The number of levels to create. Texture::kEntireMipChain if the GPU generates them.
+        std::vector<uint8_t> mipChain;      ///< The levels generated on the CPU, if any
+    };
+
+    /** Decode an image file for createTextureFromImage(). When generating mips on the CPU, the mip-chain is generated here too. Doesn't use the graphics API, so it can be called from any thread.
+        \param[in] filename The image file. Must be a file for which isBitmapTextureFile() returns true.
+        \param[in] generateMipLevels, loadAsSrgb, generateMipsOnCpu See createTextureFromFile()
+        \return The decoded image, or nullptr if the file can't be loaded
+    */
+    TextureImage::UniqueConstPtr loadTextureImage(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, bool generateMipsOnCpu = false);
+
+    /** Create a texture from an image decoded by loadTextureImage(). Together, the two functions do what createTextureFromFile() does, split into a part which can run on any thread and a part which creates the texture.
+        \param[in] pImage The decoded image. If it's nullptr, the function returns nullptr.
+        \param[in] filename The image's filename, used as the texture's source filename
+    */
+    Texture::SharedPtr createTextureFromImage(const TextureImage* pImage, const std::string& filename);
+
+    /** Timings of createTexturesFromDDSFiles()
+    */
+    struct DdsLoadStats
+    {
+        uint32_t fileCount = 0;     ///< The number of files which loaded successfully
+        uint64_t dataSize = 0;      ///< The size of the texture data in bytes
+        float readTime = 0;         ///< Time in ms spent mapping, validating and flipping the files on the worker threads
+        float uploadTime = 0;       ///< Time in ms spent creating the textures
+    };
+
+    /** Load several DDS files. The files are memory-mapped, validated and flipped in parallel, then the textures are created on the calling thread directly from the mapped data.
+        \param[in] filenames The files to load
+        \param[in] generateMipLevels Generate a mip-chain for files which don't have one
+        \param[out] pStats Optional. Receives the time spent loading the files.
+        \return The textures, in the same order as the filenames. Files which fail to load have a nullptr entry.
+    */
+    std::vector<Texture::SharedPtr> createTexturesFromDDSFiles(const std::vector<std::string>& filenames, bool generateMipLevels, DdsLoadStats* pStats = nullptr);
+
+    /** Measure how long it takes to load a set of DDS files. The textures are released after each iteration.
+        \return The average timings of the iterations
+    */
+    DdsLoadStats benchmarkDDSLoading(const std::vector<std::string>& filenames, uint32_t iterations);
     
     /*! @} */
 }
\ No newline at end of file
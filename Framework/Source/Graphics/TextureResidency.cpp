@@ -0,0 +1,335 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Falcor
+{
+    TextureResidency::UniquePtr TextureResidency::create(uint64_t budget)
+    {
+        return UniquePtr(new TextureResidency(budget));
+    }
+
+    uint32_t TextureResidency::addTexture(const std::vector<uint64_t>& mipSizes, uint32_t baseMip)
+    {
+        if(mipSizes.empty())
+        {
+            Logger::log(Logger::Level::Error, "TextureResidency::addTexture() - the texture must have at least one mip-level");
+            return kInvalidHandle;
+        }
+
+        TextureData tex;
+        tex.tailSizes.resize(mipSizes.size() + 1, 0);
+        for(size_t i = mipSizes.size(); i > 0; i--)
+        {
+            tex.tailSizes[i - 1] = tex.tailSizes[i] + mipSizes[i - 1];
+        }
+        tex.baseMip = std::min(baseMip, (uint32_t)mipSizes.size() - 1);
+        tex.residentMip = tex.baseMip;
+        tex.requiredMip = tex.baseMip;
+        tex.requestedMip = tex.baseMip;
+        tex.isValid = true;
+
+        mResidentBytes += tex.tailSizes[tex.residentMip];
+        mTextureCount++;
+        mTextures.push_back(tex);
+        return (uint32_t)mTextures.size() - 1;
+    }
+
+    void TextureResidency::removeTexture(uint32_t handle)
+    {
+        if(handle >= mTextures.size() || mTextures[handle].isValid == false)
+        {
+            return;
+        }
+
+        TextureData& tex = mTextures[handle];
+        if(tex.pendingMip != kInvalidHandle)
+        {
+            mPendingBytes -= tex.tailSizes[tex.pendingMip] - tex.tailSizes[tex.residentMip];
+            mPendingLoads--;
+        }
+        mResidentBytes -= tex.tailSizes[tex.residentMip];
+        mTextureCount--;
+
+        // Keep the slot, so that handles stay stable
+        tex = TextureData();
+    }
+
+    void TextureResidency::requestMip(uint32_t handle, float lod)
+    {
+        if(handle >= mTextures.size() || mTextures[handle].isValid == false)
+        {
+            return;
+        }
+        TextureData& tex = mTextures[handle];
+
+        uint32_t mip = tex.baseMip;
+        if(lod < (float)tex.baseMip)
+        {
+            mip = (lod > 0) ? (uint32_t)lod : 0;
+        }
+
+        if(tex.lastUsedFrame != mFrame)
+        {
+            tex.lastUsedFrame = mFrame;
+            tex.requestedMip = mip;
+        }
+        else
+        {
+            tex.requestedMip = std::min(tex.requestedMip, mip);
+        }
+    }
+
+    void TextureResidency::update(uint32_t maxLoads, std::vector<Request>& loads, std::vector<Request>& evictions)
+    {
+        loads.clear();
+        evictions.clear();
+
+        // Resolve this frame's requirements. Textures which weren't used only need their base level.
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> evictionOrder;
+        uint64_t evictableBytes = 0;
+        for(uint32_t handle = 0; handle < (uint32_t)mTextures.size(); handle++)
+        {
+            TextureData& tex = mTextures[handle];
+            if(tex.isValid == false)
+            {
+                continue;
+            }
+
+            tex.requiredMip = (tex.lastUsedFrame == mFrame) ? tex.requestedMip : tex.baseMip;
+            if(tex.pendingMip != kInvalidHandle)
+            {
+                continue;
+            }
+
+            if(tex.requiredMip < tex.residentMip)
+            {
+                candidates.push_back(handle);
+            }
+            else if(tex.requiredMip > tex.residentMip)
+            {
+                evictionOrder.push_back(handle);
+                evictableBytes += tex.tailSizes[tex.residentMip] - tex.tailSizes[tex.requiredMip];
+            }
+        }
+
+        // The textures missing the most levels come first. Ties go to the cheaper load, so that more textures improve per frame.
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+        {
+            const TextureData& texA = mTextures[a];
+            const TextureData& texB = mTextures[b];
+            uint32_t missingA = texA.residentMip - texA.requiredMip;
+            uint32_t missingB = texB.residentMip - texB.requiredMip;
+            if(missingA != missingB)
+            {
+                return missingA > missingB;
+            }
+            return texA.tailSizes[texA.requiredMip] < texB.tailSizes[texB.requiredMip];
+        });
+
+        // Least recently used first
+        std::sort(evictionOrder.begin(), evictionOrder.end(), [this](uint32_t a, uint32_t b)
+        {
+            return mTextures[a].lastUsedFrame < mTextures[b].lastUsedFrame;
+        });
+
+        size_t nextEviction = 0;
+        auto evictNext = [&]()
+        {
+            uint32_t handle = evictionOrder[nextEviction++];
+            TextureData& tex = mTextures[handle];
+            uint64_t freed = tex.tailSizes[tex.residentMip] - tex.tailSizes[tex.requiredMip];
+            mResidentBytes -= freed;
+            evictableBytes -= freed;
+            tex.residentMip = tex.requiredMip;
+            mEvictionCount++;
+            Request r = {handle, tex.requiredMip};
+            evictions.push_back(r);
+        };
+
+        // The budget might have shrunk since the last update
+        while(mResidentBytes + mPendingBytes > mBudget && nextEviction < evictionOrder.size())
+        {
+            evictNext();
+        }
+
+        mStarvedTextures = 0;
+        for(uint32_t handle : candidates)
+        {
+            if(loads.size() >= maxLoads)
+            {
+                break;
+            }
+
+            // Try the required level first, then fall back to fewer levels. Evict only if the load will fit afterwards, so we don't throw away data for nothing.
+            TextureData& tex = mTextures[handle];
+            bool issued = false;
+            for(uint32_t mip = tex.requiredMip; mip < tex.residentMip; mip++)
+            {
+                uint64_t size = tex.tailSizes[mip] - tex.tailSizes[tex.residentMip];
+                uint64_t used = mResidentBytes + mPendingBytes + size;
+                if(used > mBudget + evictableBytes)
+                {
+                    continue;
+                }
+
+                while(mResidentBytes + mPendingBytes + size > mBudget)
+                {
+                    evictNext();
+                }
+
+                tex.pendingMip = mip;
+                mPendingBytes += size;
+                mPendingLoads++;
+                mLoadCount++;
+                Request r = {handle, mip};
+                loads.push_back(r);
+                issued = true;
+                break;
+            }
+
+            if(issued == false || tex.pendingMip != tex.requiredMip)
+            {
+                mStarvedTextures++;
+            }
+        }
+
+        mFrame++;
+    }
+
+    void TextureResidency::completeLoad(uint32_t handle, bool success)
+    {
+        if(handle >= mTextures.size())
+        {
+            return;
+        }
+
+        TextureData& tex = mTextures[handle];
+        if(tex.isValid == false || tex.pendingMip == kInvalidHandle)
+        {
+            return;
+        }
+
+        uint64_t size = tex.tailSizes[tex.pendingMip] - tex.tailSizes[tex.residentMip];
+        mPendingBytes -= size;
+        mPendingLoads--;
+        if(success)
+        {
+            mResidentBytes += size;
+            tex.residentMip = tex.pendingMip;
+        }
+        tex.pendingMip = kInvalidHandle;
+    }
+
+    const TextureResidency::TextureData* TextureResidency::getTexture(uint32_t handle) const
+    {
+        if(handle >= mTextures.size() || mTextures[handle].isValid == false)
+        {
+            return nullptr;
+        }
+        return &mTextures[handle];
+    }
+
+    uint32_t TextureResidency::getResidentMip(uint32_t handle) const
+    {
+        const TextureData* pTex = getTexture(handle);
+        return pTex ? pTex->residentMip : kInvalidHandle;
+    }
+
+    uint32_t TextureResidency::getRequiredMip(uint32_t handle) const
+    {
+        const TextureData* pTex = getTexture(handle);
+        return pTex ? pTex->requiredMip : kInvalidHandle;
+    }
+
+    bool TextureResidency::isLoadPending(uint32_t handle) const
+    {
+        const TextureData* pTex = getTexture(handle);
+        return pTex ? (pTex->pendingMip != kInvalidHandle) : false;
+    }
+
+    uint32_t TextureResidency::getPendingMip(uint32_t handle) const
+    {
+        const TextureData* pTex = getTexture(handle);
+        return pTex ? pTex->pendingMip : kInvalidHandle;
+    }
+
+    uint64_t TextureResidency::getResidentSize(uint32_t handle) const
+    {
+        const TextureData* pTex = getTexture(handle);
+        return pTex ? pTex->tailSizes[pTex->residentMip] : 0;
+    }
+
+    TextureResidency::Stats TextureResidency::getStats() const
+    {
+        Stats stats;
+        stats.budget = mBudget;
+        stats.residentBytes = mResidentBytes;
+        stats.pendingBytes = mPendingBytes;
+        stats.textureCount = mTextureCount;
+        stats.pendingLoads = mPendingLoads;
+        stats.starvedTextures = mStarvedTextures;
+        stats.loadCount = mLoadCount;
+        stats.evictionCount = mEvictionCount;
+        return stats;
+    }
+
+    std::vector<uint64_t> TextureResidency::calcMipSizes(uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+    {
+        std::vector<uint64_t> sizes;
+        width = std::max(width, 1u);
+        height = std::max(height, 1u);
+        while(true)
+        {
+            sizes.push_back((uint64_t)width * height * bytesPerPixel);
+            if(width == 1 && height == 1)
+            {
+                break;
+            }
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        return sizes;
+    }
+
+    float TextureResidency::calcLod(float texelsPerWorldUnit, float worldUnitsPerPixel)
+    {
+        // A texel which is smaller than a pixel means minification, so coarser mips are enough
+        float texelsPerPixel = texelsPerWorldUnit * worldUnitsPerPixel;
+        return (texelsPerPixel > 0) ? std::log(texelsPerPixel) / std::log(2.0f) : 0;
+    }
+
+    float TextureResidency::calcWorldUnitsPerPixel(float distance, float projScaleY, float viewportHeight)
+    {
+        return 2 * distance / (projScaleY * viewportHeight);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+
+namespace Falcor
+{
+    /** Decides which mip-levels of streamed textures should be resident, under a global memory budget.
+        This class only does the bookkeeping - it doesn't touch the GPU, so it can be used and tested without a device. TextureStreamer owns one and applies its decisions.
+        Each frame, the renderer reports the level-of-detail it samples every texture at by calling requestMip(). update() then compares the requests with the resident mip-levels, and returns the loads and evictions to perform.
+        Textures which weren't used recently are evicted first (LRU). Textures never drop below their base mip-level, which is always resident.
+        Mip-level 0 is the most detailed level. A texture whose resident mip is N has all the levels from N to the end of the chain in memory.
+    */
+    class TextureResidency
+    {
+    public:
+        using UniquePtr = std::unique_ptr<TextureResidency>;
+        using UniqueConstPtr = std::unique_ptr<const TextureResidency>;
+
+        static const uint32_t kInvalidHandle = (uint32_t)-1;
+
+        /** A change in the residency of a texture
+        */
+        struct Request
+        {
+            uint32_t handle;
+            uint32_t mipLevel;  ///< The new most detailed resident mip-level
+        };
+
+        struct Stats
+        {
+            uint64_t budget = 0;
+            uint64_t residentBytes = 0;     ///< Memory used by the resident mip-levels
+            uint64_t pendingBytes = 0;      ///< Memory reserved for loads which weren't completed yet
+            uint32_t textureCount = 0;
+            uint32_t pendingLoads = 0;
+            uint32_t starvedTextures = 0;   ///< Textures which needed more detail in the last update() but didn't fit into the budget
+            uint64_t loadCount = 0;         ///< Total number of loads issued
+            uint64_t evictionCount = 0;     ///< Total number of evictions issued
+        };
+
+        /** Create a new object
+            \param[in] budget The memory budget in bytes
+        */
+        static UniquePtr create(uint64_t budget);
+
+        /** Register a texture.
+            \param[in] mipSizes The size in bytes of each mip-level, starting from mip 0.
+            \param[in] baseMip The mip-level which is always resident. Its memory is accounted for, even if it exceeds the budget.
+            \return A handle to the texture. Handles are never reused.
+        */
+        uint32_t addTexture(const std::vector<uint64_t>& mipSizes, uint32_t baseMip);
+
+        /** Unregister a texture. Its pending load, if any, is discarded.
+        */
+        void removeTexture(uint32_t handle);
+
+        /** Report that a texture is sampled at a level-of-detail in the current frame. Can be called multiple times per frame, the most detailed request is kept.
+            \param[in] handle The texture handle
+            \param[in] lod The level-of-detail, as calculated by calcLod(). The texture needs mip-level floor(lod) to be sampled at full quality.
+        */
+        void requestMip(uint32_t handle, float lod);
+
+        /** Process the requests reported since the last call and start a new frame.
+            Loads are prioritized by how many mip-levels the texture is missing. If a load doesn't fit into the budget, the least recently used textures which are more detailed than required are evicted to make room. If that's not enough, the load is retried with fewer mip-levels.
+            The evictions take effect immediately. The loads are reserved until completeLoad() is called.
+            \param[in] maxLoads Maximal number of loads to issue. Textures which already have a pending load are skipped.
+            \param[out] loads The loads to perform
+            \param[out] evictions The evictions to perform. Apply them before the loads, since the budget relies on their memory being freed.
+        */
+        void update(uint32_t maxLoads, std::vector<Request>& loads, std::vector<Request>& evictions);
+
+        /** Report that a load issued by update() finished
+            \param[in] handle The texture handle
+            \param[in] success If false, the texture keeps its previous residency and the load will be reissued by a later update()
+        */
+        void completeLoad(uint32_t handle, bool success);
+
+        /** Change the memory budget. Takes effect on the next update().
+        */
+        void setBudget(uint64_t budget) { mBudget = budget; }
+        uint64_t getBudget() const { return mBudget; }
+
+        /** Get the most detailed resident mip-level of a texture
+            \return The mip-level, or kInvalidHandle if the handle doesn't belong to a registered texture
+        */
+        uint32_t getResidentMip(uint32_t handle) const;
+
+        /** Get the mip-level a texture needed in the last update()
+            \return The mip-level, or kInvalidHandle if the handle doesn't belong to a registered texture
+        */
+        uint32_t getRequiredMip(uint32_t handle) const;
+
+        /** Check if a texture has a load in flight
+        */
+        bool isLoadPending(uint32_t handle) const;
+
+        /** Get the mip-level of a texture's load in flight
+            \return The mip-level, or kInvalidHandle if the texture doesn't have a pending load or the handle doesn't belong to a registered texture
+        */
+        uint32_t getPendingMip(uint32_t handle) const;
+
+        /** Get the memory used by the resident mip-levels of a texture
+            \return The size in bytes, or 0 if the handle doesn't belong to a registered texture
+        */
+        uint64_t getResidentSize(uint32_t handle) const;
+
+        /** Get the statistics
+        */
+        Stats getStats() const;
+
+        /** Calculate the size of each mip-level of an uncompressed 2D texture
+        */
+        static std::vector<uint64_t> calcMipSizes(uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+
+        /** Calculate the level-of-detail a texture is sampled at.
+            \param[in] texelsPerWorldUnit The texel density on the surface. For a texture of WxH texels mapped onto a surface with D units of UV area per unit of world area, it's sqrt(W * H * D).
+            \param[in] worldUnitsPerPixel The size of a pixel at the surface's distance. See calcWorldUnitsPerPixel().
+        */
+        static float calcLod(float texelsPerWorldUnit, float worldUnitsPerPixel);
+
+        /** Calculate the size of a pixel at some distance from the camera
+            \param[in] distance The view-space distance
+            \param[in] projScaleY The [1][1] element of the projection matrix, which is 1/tan(fovY/2)
+            \param[in] viewportHeight The viewport height in pixels
+        */
+        static float calcWorldUnitsPerPixel(float distance, float projScaleY, float viewportHeight);
+
+    private:
+        TextureResidency(uint64_t budget) : mBudget(budget) {}
+
+        struct TextureData
+        {
+            std::vector<uint64_t> tailSizes;    ///< tailSizes[i] is the size of mip-levels i to the end of the chain
+            uint32_t baseMip = 0;
+            uint32_t residentMip = 0;
+            uint32_t requiredMip = 0;
+            uint32_t requestedMip = 0;          ///< The most detailed mip requested in the current frame
+            uint32_t pendingMip = kInvalidHandle;
+            uint64_t lastUsedFrame = 0;
+            bool isValid = false;
+        };
+
+        const TextureData* getTexture(uint32_t handle) const;
+
+        std::vector<TextureData> mTextures;
+        uint64_t mBudget;
+        uint64_t mResidentBytes = 0;
+        uint64_t mPendingBytes = 0;
+        uint64_t mFrame = 1;
+        uint32_t mTextureCount = 0;
+        uint32_t mPendingLoads = 0;
+        uint32_t mStarvedTextures = 0;
+        uint64_t mLoadCount = 0;
+        uint64_t mEvictionCount = 0;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,630 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "Graphics/TextureHelper.h"
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Camera/Camera.h"
+#include "Graphics/Model/Mesh.h"
+#include "Data/VertexAttrib.h"
+#include "Utils/Bitmap.h"
+#include "Utils/StringUtils.h"
+#include "Utils/ImageProcessing.h"
+
+#ifdef FALCOR_GL
+static const bool kTopDown = false;
+#elif defined FALCOR_DX11
+static const bool kTopDown = true;
+#endif
+
+namespace Falcor
+{
+    static uint32_t getStreamableBytesPerPixel(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::R8Unorm:
+            return 1;
+        case ResourceFormat::RG8Unorm:
+            return 2;
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::BGRX8UnormSrgb:
+            return 4;
+        case ResourceFormat::RGB32Float:
+            return 12;
+        case ResourceFormat::RGBA32Float:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    // Matches createTextureFromFile(). Bitmap expands 24-bit images to 32-bit, so 3 bytes-per-pixel never shows up.
+    static ResourceFormat getBitmapFormat(uint32_t bytesPerPixel, bool loadAsSrgb)
+    {
+        switch(bytesPerPixel)
+        {
+        case 1:
+            return ResourceFormat::R8Unorm;
+        case 2:
+            return ResourceFormat::RG8Unorm;
+        case 4:
+            return loadAsSrgb ? ResourceFormat::BGRA8UnormSrgb : ResourceFormat::BGRA8Unorm;
+        case 12:
+            return ResourceFormat::RGB32Float;
+        case 16:
+            return ResourceFormat::RGBA32Float;
+        default:
+            return ResourceFormat::Unknown;
+        }
+    }
+
+    /** Create a texture containing the mip-levels of another texture, starting from mostDetailedMip. The copy is done on the GPU.
+    */
+    static Texture::SharedPtr createMipTail(const Texture* pTexture, uint32_t mostDetailedMip)
+    {
+        uint32_t width = std::max(pTexture->getWidth() >> mostDetailedMip, 1u);
+        uint32_t height = std::max(pTexture->getHeight() >> mostDetailedMip, 1u);
+        uint32_t mipCount = pTexture->getMipLevels() - mostDetailedMip;
+        Texture::SharedPtr pTail = Texture::create2D(width, height, pTexture->getFormat(), 1, mipCount, nullptr);
+        if(pTail)
+        {
+            for(uint32_t mip = 0; mip < mipCount; mip++)
+            {
+                pTexture->copySubresource(pTail.get(), mostDetailedMip + mip, 0, mip, 0);
+            }
+            pTail->setSourceFilename(pTexture->getSourceFilename());
+        }
+        return pTail;
+    }
+
+    /** Calculate the UV area per unit of object-space area, averaged over the mesh.
+        The geometry is read from the mesh's CPU geometry copy if it has one, otherwise from the GPU buffers.
+    */
+    static float calcUvDensity(const Mesh* pMesh)
+    {
+        if(pMesh->getTopology() != RenderContext::Topology::TriangleList)
+        {
+            return 0;
+        }
+
+        std::vector<glm::vec3> positions = pMesh->readVertexAttribute(VERTEX_POSITION_LOC);
+        std::vector<glm::vec3> texCrds = pMesh->readVertexAttribute(VERTEX_TEXCOORD_LOC);
+        if(positions.empty() || texCrds.empty())
+        {
+            return 0;
+        }
+
+        std::vector<uint32_t> indices = pMesh->readIndices();
+        double area = 0;
+        double uvArea = 0;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t a = indices[i];
+            uint32_t b = indices[i + 1];
+            uint32_t c = indices[i + 2];
+            if(a >= positions.size() || b >= positions.size() || c >= positions.size())
+            {
+                continue;
+            }
+
+            // Both are twice the triangle area, which cancels out
+            area += glm::length(glm::cross(positions[b] - positions[a], positions[c] - positions[a]));
+            glm::vec2 e1 = glm::vec2(texCrds[b] - texCrds[a]);
+            glm::vec2 e2 = glm::vec2(texCrds[c] - texCrds[a]);
+            uvArea += std::abs(e1.x * e2.y - e1.y * e2.x);
+        }
+
+        return (area > 0) ? (float)(uvArea / area) : 0;
+    }
+
+    static float calcLog2(float value)
+    {
+        return std::log(value) / std::log(2.0f);
+    }
+
+    TextureStreamer::MipChainPtr TextureStreamer::createMipChain(const Bitmap* pBitmap, ResourceFormat format)
+    {
+        std::shared_ptr<MipChain> pMips = std::make_shared<MipChain>();
+        pMips->width = pBitmap->getWidth();
+        pMips->height = pBitmap->getHeight();
+        uint32_t mipCount;
+        pMips->data = ImageProcessing::generateMipChain(pBitmap->getData(), pMips->width, pMips->height, format, ImageProcessing::MipFilter::Box, mipCount);
+        if(pMips->data.empty())
+        {
+            return nullptr;
+        }
+
+        size_t offset = 0;
+        for(uint64_t size : TextureResidency::calcMipSizes(pMips->width, pMips->height, pBitmap->getBytesPerPixel()))
+        {
+            pMips->offsets.push_back(offset);
+            offset += (size_t)size;
+        }
+        assert(pMips->offsets.size() == mipCount && offset == pMips->data.size());
+        return pMips;
+    }
+
+    TextureStreamer::MipChainPtr TextureStreamer::findCachedMips(uint32_t handle)
+    {
+        for(auto it = mMipCache.begin(); it != mMipCache.end(); it++)
+        {
+            if(it->first == handle)
+            {
+                mMipCache.splice(mMipCache.begin(), mMipCache, it);
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    void TextureStreamer::cacheMips(uint32_t handle, const MipChainPtr& pMips)
+    {
+        if(pMips->data.size() > mDesc.cacheSize || findCachedMips(handle))
+        {
+            return;
+        }
+
+        mMipCache.push_front(std::make_pair(handle, pMips));
+        mMipCacheSize += pMips->data.size();
+        while(mMipCacheSize > mDesc.cacheSize)
+        {
+            mMipCacheSize -= mMipCache.back().second->data.size();
+            mMipCache.pop_back();
+        }
+    }
+
+    TextureStreamer::UniquePtr TextureStreamer::create(const Desc& desc)
+    {
+        return UniquePtr(new TextureStreamer(desc));
+    }
+
+    TextureStreamer::TextureStreamer(const Desc& desc) : mDesc(desc)
+    {
+        mDesc.baseResolution = std::max(mDesc.baseResolution, 1u);
+        mDesc.maxLoadsPerFrame = std::max(mDesc.maxLoadsPerFrame, 1u);
+        mDesc.threadCount = std::max(mDesc.threadCount, 1u);
+        mpResidency = TextureResidency::create(mDesc.budget);
+
+        for(uint32_t i = 0; i < mDesc.threadCount; i++)
+        {
+            mWorkers.push_back(std::thread(&TextureStreamer::workerFunc, this));
+        }
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mJobQueuedCV.notify_all();
+        for(auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    uint32_t TextureStreamer::calcBaseMip(uint32_t width, uint32_t height) const
+    {
+        uint32_t mip = 0;
+        uint32_t size = std::max(width, height);
+        while((size >> mip) > mDesc.baseResolution)
+        {
+            mip++;
+        }
+        return mip;
+    }
+
+    Texture::SharedPtr TextureStreamer::createTextureFromFile(const std::string& filename, bool loadAsSrgb)
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
+        if(pBitmap == nullptr)
+        {
+            return nullptr;
+        }
+
+        ResourceFormat format = getBitmapFormat(pBitmap->getBytesPerPixel(), loadAsSrgb);
+        uint32_t baseMip = calcBaseMip(pBitmap->getWidth(), pBitmap->getHeight());
+        if(format == ResourceFormat::Unknown || baseMip == 0)
+        {
+            // Can't stream it, or not worth it
+            pBitmap = nullptr;
+            return Falcor::createTextureFromFile(filename, true, loadAsSrgb);
+        }
+
+        std::string key = filename + '|' + std::to_string((uint32_t)format);
+        auto it = mFileHandles.find(key);
+        if(it != mFileHandles.end())
+        {
+            return mTextures[it->second].pTexture;
+        }
+
+        // Filter the whole chain once. It goes into the cache, so the first loads don't decode the file again.
+        MipChainPtr pMips = createMipChain(pBitmap.get(), format);
+        if(pMips == nullptr)
+        {
+            return nullptr;
+        }
+        uint32_t width = std::max(pMips->width >> baseMip, 1u);
+        uint32_t height = std::max(pMips->height >> baseMip, 1u);
+        Texture::SharedPtr pTexture = Texture::create2D(width, height, format, 1, (uint32_t)pMips->offsets.size() - baseMip, pMips->data.data() + pMips->offsets[baseMip]);
+        if(pTexture == nullptr)
+        {
+            return nullptr;
+        }
+        pTexture->setSourceFilename(filename);
+
+        StreamedTexture tex;
+        tex.filename = filename;
+        tex.width = pBitmap->getWidth();
+        tex.height = pBitmap->getHeight();
+        tex.bytesPerPixel = pBitmap->getBytesPerPixel();
+        tex.format = format;
+        tex.residentMip = baseMip;
+        tex.pTexture = pTexture;
+
+        uint32_t handle = mpResidency->addTexture(TextureResidency::calcMipSizes(tex.width, tex.height, tex.bytesPerPixel), baseMip);
+        assert(handle == mTextures.size());
+        mTextures.push_back(tex);
+        mFileHandles[key] = handle;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        cacheMips(handle, pMips);
+        return pTexture;
+    }
+
+    uint32_t TextureStreamer::registerTexture(const Texture::SharedPtr& pTexture)
+    {
+        const std::string& filename = pTexture->getSourceFilename();
+        uint32_t bytesPerPixel = getStreamableBytesPerPixel(pTexture->getFormat());
+        if(filename.empty() || hasSuffix(filename, ".dds", false) || bytesPerPixel == 0 || pTexture->getType() != Texture::Type::Texture2D || pTexture->getArraySize() != 1)
+        {
+            return TextureResidency::kInvalidHandle;
+        }
+
+        std::string key = filename + '|' + std::to_string((uint32_t)pTexture->getFormat());
+        auto it = mFileHandles.find(key);
+        if(it != mFileHandles.end())
+        {
+            return it->second;
+        }
+
+        // Textures without a full mip-chain are left alone, streaming would change how they are sampled
+        uint32_t baseMip = calcBaseMip(pTexture->getWidth(), pTexture->getHeight());
+        std::vector<uint64_t> mipSizes = TextureResidency::calcMipSizes(pTexture->getWidth(), pTexture->getHeight(), bytesPerPixel);
+        if(baseMip == 0 || pTexture->getMipLevels() != mipSizes.size())
+        {
+            return TextureResidency::kInvalidHandle;
+        }
+
+        Texture::SharedPtr pBase = createMipTail(pTexture.get(), baseMip);
+        if(pBase == nullptr)
+        {
+            return TextureResidency::kInvalidHandle;
+        }
+
+        StreamedTexture tex;
+        tex.filename = filename;
+        tex.width = pTexture->getWidth();
+        tex.height = pTexture->getHeight();
+        tex.bytesPerPixel = bytesPerPixel;
+        tex.format = pTexture->getFormat();
+        tex.residentMip = baseMip;
+        tex.pTexture = pBase;
+
+        uint32_t handle = mpResidency->addTexture(mipSizes, baseMip);
+        assert(handle == mTextures.size());
+        mTextures.push_back(tex);
+        mFileHandles[key] = handle;
+        return handle;
+    }
+
+    void TextureStreamer::addMaterial(const Material::SharedPtr& pMaterial)
+    {
+        if(mMaterialTextures.find(pMaterial.get()) != mMaterialTextures.end())
+        {
+            return;
+        }
+
+        std::vector<Texture::SharedConstPtr> textures;
+        pMaterial->getActiveTextures(textures);
+        std::vector<uint32_t>& handles = mMaterialTextures[pMaterial.get()];
+        for(const auto& pConstTexture : textures)
+        {
+            Texture::SharedPtr pTexture = std::const_pointer_cast<Texture>(pConstTexture);
+            uint32_t handle = registerTexture(pTexture);
+            if(handle == TextureResidency::kInvalidHandle)
+            {
+                continue;
+            }
+
+            StreamedTexture& tex = mTextures[handle];
+            if(tex.pTexture != pTexture)
+            {
+                pMaterial->replaceTexture(pTexture.get(), tex.pTexture);
+            }
+
+            if(std::find(handles.begin(), handles.end(), handle) == handles.end())
+            {
+                handles.push_back(handle);
+                tex.materials.push_back(pMaterial);
+            }
+        }
+    }
+
+    void TextureStreamer::addScene(const Scene* pScene)
+    {
+        uint32_t readbackCount = 0;
+        for(uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                const Material::SharedPtr& pMaterial = pMesh->getMaterial();
+                if(pMaterial == nullptr || mMeshTextures.find(pMesh) != mMeshTextures.end())
+                {
+                    continue;
+                }
+
+                addMaterial(pMaterial);
+                const std::vector<uint32_t>& handles = mMaterialTextures[pMaterial.get()];
+                if(handles.empty())
+                {
+                    continue;
+                }
+
+                const CpuGeometry::SharedPtr& pCpuGeometry = pMesh->getCpuGeometry();
+                if(pCpuGeometry == nullptr || pCpuGeometry->isAvailable() == false)
+                {
+                    readbackCount++;
+                }
+                float uvDensity = calcUvDensity(pMesh);
+                if(uvDensity <= 0)
+                {
+                    continue;
+                }
+
+                std::vector<MeshTexture>& meshTextures = mMeshTextures[pMesh];
+                for(uint32_t handle : handles)
+                {
+                    const StreamedTexture& tex = mTextures[handle];
+                    MeshTexture meshTex;
+                    meshTex.handle = handle;
+                    meshTex.log2TexelDensity = 0.5f * calcLog2((float)tex.width * (float)tex.height * uvDensity);
+                    meshTextures.push_back(meshTex);
+                }
+            }
+        }
+
+        if(readbackCount)
+        {
+            Logger::log(Logger::Level::Warning, "TextureStreamer::addScene() - " + std::to_string(readbackCount) + " meshes don't have a CPU geometry copy, so their vertices were read back from the GPU. Load the models with Model::KeepCpuGeometry to avoid the stall.");
+        }
+    }
+
+    void TextureStreamer::setView(const Camera* pCamera, float viewportHeight)
+    {
+        mCameraPosition = pCamera->getPosition();
+        mPixelScale = TextureResidency::calcWorldUnitsPerPixel(1, pCamera->getProjMatrix()[1][1], viewportHeight);
+    }
+
+    void TextureStreamer::requestMesh(const Mesh* pMesh, const glm::mat4& worldMat, const BoundingBox& worldBox)
+    {
+        auto it = mMeshTextures.find(pMesh);
+        if(it == mMeshTextures.end() || mPixelScale <= 0)
+        {
+            return;
+        }
+
+        // Use the closest point of the bounding-box. If the camera is inside it, the mesh needs its most detailed level.
+        glm::vec3 closest = glm::clamp(mCameraPosition, worldBox.center - worldBox.extent, worldBox.center + worldBox.extent);
+        float distance = glm::length(mCameraPosition - closest);
+
+        // The texel density is in object space. Convert the pixel size using the instance's average scale.
+        float scale = std::pow(std::abs(glm::determinant(glm::mat3(worldMat))), 1.0f / 3.0f);
+        float pixelSize = (scale > 0) ? distance * mPixelScale / scale : 0;
+
+        // Same as TextureResidency::calcLod(), with the texel density's log precomputed
+        float lodOffset = (pixelSize > 0) ? calcLog2(pixelSize) + mDesc.lodBias : -FLT_MAX;
+        for(const MeshTexture& meshTex : it->second)
+        {
+            mpResidency->requestMip(meshTex.handle, meshTex.log2TexelDensity + lodOffset);
+        }
+    }
+
+    void TextureStreamer::swapTexture(StreamedTexture& tex, const Texture::SharedPtr& pNew, uint32_t residentMip)
+    {
+        for(const auto& pMaterial : tex.materials)
+        {
+            pMaterial->replaceTexture(tex.pTexture.get(), pNew);
+        }
+        tex.pTexture = pNew;
+        tex.residentMip = residentMip;
+    }
+
+    void TextureStreamer::shrinkTexture(uint32_t handle, uint32_t mipLevel)
+    {
+        StreamedTexture& tex = mTextures[handle];
+        if(mipLevel <= tex.residentMip)
+        {
+            return;
+        }
+
+        Texture::SharedPtr pTail = createMipTail(tex.pTexture.get(), mipLevel - tex.residentMip);
+        if(pTail)
+        {
+            swapTexture(tex, pTail, mipLevel);
+        }
+    }
+
+    void TextureStreamer::applyLoad(LoadJob& job)
+    {
+        StreamedTexture& tex = mTextures[job.handle];
+        Texture::SharedPtr pTexture;
+        const MipChain* pMips = job.pMips.get();
+        if(pMips && pMips->width == tex.width && pMips->height == tex.height && job.mipLevel < pMips->offsets.size())
+        {
+            // Upload all the levels, they were already filtered on the CPU
+            uint32_t width = std::max(tex.width >> job.mipLevel, 1u);
+            uint32_t height = std::max(tex.height >> job.mipLevel, 1u);
+            pTexture = Texture::create2D(width, height, tex.format, 1, (uint32_t)pMips->offsets.size() - job.mipLevel, pMips->data.data() + pMips->offsets[job.mipLevel]);
+        }
+
+        if(pTexture)
+        {
+            pTexture->setSourceFilename(tex.filename);
+            swapTexture(tex, pTexture, job.mipLevel);
+            mpResidency->completeLoad(job.handle, true);
+        }
+        else
+        {
+            // Stop streaming the texture, otherwise the load would be retried every frame
+            Logger::log(Logger::Level::Warning, "TextureStreamer - failed to load mip-level " + std::to_string(job.mipLevel) + " of '" + tex.filename + "'. The texture won't be streamed anymore.");
+            mpResidency->completeLoad(job.handle, false);
+            mpResidency->removeTexture(job.handle);
+        }
+    }
+
+    void TextureStreamer::update()
+    {
+        // Apply the finished loads. The number of uploads per frame is limited to avoid hitches.
+        std::list<LoadJob> finishedJobs;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto end = mFinishedJobs.begin();
+            std::advance(end, std::min((size_t)mDesc.maxLoadsPerFrame, mFinishedJobs.size()));
+            finishedJobs.splice(finishedJobs.begin(), mFinishedJobs, mFinishedJobs.begin(), end);
+        }
+
+        for(auto& job : finishedJobs)
+        {
+            applyLoad(job);
+        }
+
+        // Don't let the queue grow beyond what the workers can handle
+        uint32_t pendingLoads = mpResidency->getStats().pendingLoads;
+        uint32_t maxPendingLoads = 2 * std::max(mDesc.maxLoadsPerFrame, mDesc.threadCount);
+        uint32_t maxLoads = (pendingLoads < maxPendingLoads) ? std::min(maxPendingLoads - pendingLoads, mDesc.maxLoadsPerFrame) : 0;
+        mpResidency->update(maxLoads, mLoads, mEvictions);
+
+        for(const auto& eviction : mEvictions)
+        {
+            shrinkTexture(eviction.handle, eviction.mipLevel);
+        }
+
+        if(mLoads.size())
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for(const auto& load : mLoads)
+            {
+                const StreamedTexture& tex = mTextures[load.handle];
+                LoadJob job;
+                job.handle = load.handle;
+                job.mipLevel = load.mipLevel;
+                job.filename = tex.filename;
+                job.bytesPerPixel = tex.bytesPerPixel;
+                job.format = tex.format;
+                mQueuedJobs.push_back(job);
+            }
+            mJobQueuedCV.notify_all();
+        }
+    }
+
+    void TextureStreamer::flush()
+    {
+        std::list<LoadJob> finishedJobs;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobFinishedCV.wait(lock, [this] { return mQueuedJobs.empty() && mActiveJobs == 0; });
+            finishedJobs.splice(finishedJobs.begin(), mFinishedJobs);
+        }
+
+        for(auto& job : finishedJobs)
+        {
+            applyLoad(job);
+        }
+    }
+
+    void TextureStreamer::loadMip(LoadJob& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            job.pMips = findCachedMips(job.handle);
+        }
+        if(job.pMips)
+        {
+            return;
+        }
+
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(job.filename, kTopDown);
+        if(pBitmap == nullptr || pBitmap->getBytesPerPixel() != job.bytesPerPixel)
+        {
+            return;
+        }
+
+        job.pMips = createMipChain(pBitmap.get(), job.format);
+        if(job.pMips)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            cacheMips(job.handle, job.pMips);
+        }
+    }
+
+    void TextureStreamer::workerFunc()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(true)
+        {
+            mJobQueuedCV.wait(lock, [this] { return mStopping || mQueuedJobs.empty() == false; });
+            if(mStopping)
+            {
+                break;
+            }
+
+            // Move the job out of the queue without copying it, VS2013 doesn't generate move constructors
+            std::list<LoadJob> job;
+            job.splice(job.begin(), mQueuedJobs, mQueuedJobs.begin());
+            mActiveJobs++;
+            lock.unlock();
+
+            loadMip(job.front());
+
+            lock.lock();
+            mActiveJobs--;
+            mFinishedJobs.splice(mFinishedJobs.end(), job);
+            mJobFinishedCV.notify_all();
+        }
+    }
+}
\ No newline at end of file
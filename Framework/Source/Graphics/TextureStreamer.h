@@ -0,0 +1,205 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Core/Texture.h"
+#include "Graphics/TextureResidency.h"
+#include "Graphics/Material/Material.h"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    class Scene;
+    class Mesh;
+    class Camera;
+    class Bitmap;
+
+    /** Streams the mip-levels of material textures under a global memory budget.
+        Streamed textures start with only their low-detail mip-levels. The renderer reports the meshes it draws with requestMesh(), and the streamer estimates the level-of-detail each of the mesh's textures is sampled at from the mesh's UV density and its distance from the camera.
+        update() decides which textures need more detail (see TextureResidency), loads them on worker threads and swaps the new textures into the materials. When the budget is exceeded, the least recently used textures are shrunk back.
+        A source file is decoded and its whole mip-chain is filtered once. The chains are kept in a CPU cache, so that later loads of the same texture only upload them.
+        Only 2D textures loaded from 8-bit or 32-bit float image files can be streamed. Other textures are left untouched.
+    */
+    class TextureStreamer
+    {
+    public:
+        using UniquePtr = std::unique_ptr<TextureStreamer>;
+        using UniqueConstPtr = std::unique_ptr<const TextureStreamer>;
+
+        struct Desc
+        {
+            uint64_t budget = 512 * 1024 * 1024;    ///< Memory budget in bytes for all the streamed textures
+            uint32_t baseResolution = 64;           ///< Mip-levels up to this resolution are always resident
+            uint32_t maxLoadsPerFrame = 4;          ///< Maximal number of loads to issue and textures to upload in a single update()
+            uint32_t threadCount = 1;               ///< Number of threads decoding image files
+            uint64_t cacheSize = 256 * 1024 * 1024; ///< Memory budget in bytes for the decoded mip-chains kept on the CPU. The least recently used chains are released first. 0 decodes the file on every load.
+            float lodBias = 0;                      ///< Added to the estimated level-of-detail. Positive values save memory at the cost of detail.
+        };
+
+        /** Create a new object
+        */
+        static UniquePtr create(const Desc& desc);
+
+        /** Destructor. Waits for the workers, but doesn't apply the pending loads.
+        */
+        ~TextureStreamer();
+
+        /** Load a texture with only its low-detail mip-levels, and register it for streaming
+            \param[in] filename The image file
+            \param[in] loadAsSrgb Use an sRGB format. Only valid for 3/4 component textures.
+            \return The texture, or nullptr if the file couldn't be loaded. If the image can't be streamed, the entire mip-chain is loaded.
+        */
+        Texture::SharedPtr createTextureFromFile(const std::string& filename, bool loadAsSrgb);
+
+        /** Register the textures of a material. Textures which were loaded with all their mip-levels are replaced with a low-detail version.
+        */
+        void addMaterial(const Material::SharedPtr& pMaterial);
+
+        /** Register the materials of all the meshes in a scene, and calculate the UV density of the meshes. Call it once after loading the scene.
+            The UV density is calculated from the meshes' CPU geometry copy (see Model::KeepCpuGeometry). Meshes without one are read back from the GPU, which stalls the pipeline and copies the whole vertex and index buffers. Load the models with Model::KeepCpuGeometry to avoid it.
+        */
+        void addScene(const Scene* pScene);
+
+        /** Set the camera used to estimate the level-of-detail by the following requestMesh() calls
+            \param[in] pCamera The camera
+            \param[in] viewportHeight The height of the render-target in pixels
+        */
+        void setView(const Camera* pCamera, float viewportHeight);
+
+        /** Report that a mesh instance is drawn in the current frame
+            \param[in] pMesh The mesh. Meshes which weren't registered by addScene() are ignored.
+            \param[in] worldMat The instance's world matrix
+            \param[in] worldBox The instance's world space bounding-box
+        */
+        void requestMesh(const Mesh* pMesh, const glm::mat4& worldMat, const BoundingBox& worldBox);
+
+        /** Apply the finished loads, then issue new loads and evictions based on the meshes reported since the last call. Call it once per frame.
+        */
+        void update();
+
+        /** Wait until all the pending loads are finished and apply them
+        */
+        void flush();
+
+        /** Change the memory budget
+        */
+        void setBudget(uint64_t budget) { mpResidency->setBudget(budget); }
+
+        /** Change the level-of-detail bias
+        */
+        void setLodBias(float bias) { mDesc.lodBias = bias; }
+
+        /** Get the residency bookkeeping, for statistics and debugging
+        */
+        const TextureResidency* getResidency() const { return mpResidency.get(); }
+
+    private:
+        TextureStreamer(const Desc& desc);
+
+        struct StreamedTexture
+        {
+            std::string filename;
+            uint32_t width;
+            uint32_t height;
+            uint32_t bytesPerPixel;
+            ResourceFormat format;
+            uint32_t residentMip;
+            Texture::SharedPtr pTexture;                ///< The texture the materials currently reference
+            std::vector<Material::SharedPtr> materials; ///< The materials to update when the texture is swapped
+        };
+
+        /** A texture's entire mip-chain, decoded and filtered once on the CPU
+        */
+        struct MipChain
+        {
+            uint32_t width;
+            uint32_t height;
+            std::vector<uint8_t> data;      ///< All the levels, in the layout Texture::create2D() expects
+            std::vector<size_t> offsets;    ///< The offset of each level in data
+        };
+        using MipChainPtr = std::shared_ptr<const MipChain>;
+
+        struct MeshTexture
+        {
+            uint32_t handle;
+            float log2TexelDensity;     ///< log2 of the texels per object-space unit
+        };
+
+        struct LoadJob
+        {
+            uint32_t handle;
+            uint32_t mipLevel;
+            std::string filename;
+            uint32_t bytesPerPixel;
+            ResourceFormat format;
+            MipChainPtr pMips;          ///< nullptr if the load failed
+        };
+
+        static MipChainPtr createMipChain(const Bitmap* pBitmap, ResourceFormat format);
+        MipChainPtr findCachedMips(uint32_t handle);
+        void cacheMips(uint32_t handle, const MipChainPtr& pMips);
+        void loadMip(LoadJob& job);
+
+        uint32_t registerTexture(const Texture::SharedPtr& pTexture);
+        uint32_t calcBaseMip(uint32_t width, uint32_t height) const;
+        void swapTexture(StreamedTexture& tex, const Texture::SharedPtr& pNew, uint32_t residentMip);
+        void shrinkTexture(uint32_t handle, uint32_t mipLevel);
+        void applyLoad(LoadJob& job);
+        void workerFunc();
+
+        Desc mDesc;
+        TextureResidency::UniquePtr mpResidency;
+        std::vector<StreamedTexture> mTextures;     // Indexed by the residency handle
+        std::unordered_map<std::string, uint32_t> mFileHandles;    // Key is the filename and the format, so that textures loaded twice are streamed once
+        std::unordered_map<const Material*, std::vector<uint32_t>> mMaterialTextures;
+        std::unordered_map<const Mesh*, std::vector<MeshTexture>> mMeshTextures;
+        std::vector<TextureResidency::Request> mLoads;
+        std::vector<TextureResidency::Request> mEvictions;
+
+        glm::vec3 mCameraPosition;
+        float mPixelScale = 0;      // World units per pixel at unit distance
+
+        std::list<std::pair<uint32_t, MipChainPtr>> mMipCache;    // Keyed by the residency handle, most recently used first. Protected by the mutex, like the job lists.
+        uint64_t mMipCacheSize = 0;
+
+        std::list<LoadJob> mQueuedJobs;
+        std::list<LoadJob> mFinishedJobs;
+        uint32_t mActiveJobs = 0;
+        bool mStopping = false;
+        std::mutex mMutex;
+        std::condition_variable mJobQueuedCV;
+        std::condition_variable mJobFinishedCV;
+        std::vector<std::thread> mWorkers;
+    };
+}
\ No newline at end of file
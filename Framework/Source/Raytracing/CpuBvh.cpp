@@ -0,0 +1,582 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuBvh.h"
+#include "glm/geometric.hpp"
+#include "Utils/ParallelFor.h"
+#include <emmintrin.h>
+#include <algorithm>
+
+namespace Falcor
+{
+namespace RT
+{
+    static const uint32_t kBinCount = 16;
+    static const uint32_t kMaxStackDepth = 128;
+    static_assert(kMaxStackDepth > kMaxBvhDepth + 1, "The traversal stack holds one node per level, plus both children of the deepest node");
+    static const float kTraversalCost = 1.0f;   ///< Cost of visiting a node, relative to intersecting a triangle
+
+    static const uint32_t kParallelBuildThreshold = 4096;   ///< Smaller inputs are built on the calling thread
+
+    namespace
+    {
+        struct BuildInput
+        {
+            const glm::vec3* pPrimMin;
+            const glm::vec3* pPrimMax;
+            std::vector<glm::vec3> centroids;
+            uint32_t maxLeafSize;
+        };
+    }
+
+    static void updateNodeBounds(BvhNode& node, const BuildInput& input, const std::vector<uint32_t>& primitiveIds)
+    {
+        node.boundsMin = glm::vec3(FLT_MAX);
+        node.boundsMax = glm::vec3(-FLT_MAX);
+        for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+        {
+            uint32_t prim = primitiveIds[i];
+            node.boundsMin = glm::min(node.boundsMin, input.pPrimMin[prim]);
+            node.boundsMax = glm::max(node.boundsMax, input.pPrimMax[prim]);
+        }
+    }
+
+    static bool findSplit(const BvhNode& node, const BuildInput& input, const std::vector<uint32_t>& primitiveIds, uint32_t& axis, float& splitPos)
+    {
+        // Bin the centroids
+        glm::vec3 centroidMin(FLT_MAX);
+        glm::vec3 centroidMax(-FLT_MAX);
+        for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+        {
+            centroidMin = glm::min(centroidMin, input.centroids[primitiveIds[i]]);
+            centroidMax = glm::max(centroidMax, input.centroids[primitiveIds[i]]);
+        }
+
+        // Small nodes don't need as many candidate planes
+        const uint32_t binCount = std::min(kBinCount, std::max(node.count, 4u));
+        float bestCost = FLT_MAX;
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            const float extent = centroidMax[a] - centroidMin[a];
+            if(extent <= 0)
+            {
+                continue;
+            }
+
+            struct Bin
+            {
+                BvhNode bounds = {glm::vec3(FLT_MAX), 0, glm::vec3(-FLT_MAX), 0};
+                uint32_t count = 0;
+            } bins[kBinCount];
+
+            const float scale = binCount / extent;
+            for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                uint32_t prim = primitiveIds[i];
+                uint32_t b = std::min(binCount - 1, (uint32_t)((input.centroids[prim][a] - centroidMin[a]) * scale));
+                bins[b].count++;
+                bins[b].bounds.boundsMin = glm::min(bins[b].bounds.boundsMin, input.pPrimMin[prim]);
+                bins[b].bounds.boundsMax = glm::max(bins[b].bounds.boundsMax, input.pPrimMax[prim]);
+            }
+
+            // Sweep from both sides to evaluate the cost of the binCount - 1 candidate planes
+            float leftArea[kBinCount - 1];
+            float rightArea[kBinCount - 1];
+            uint32_t leftCount[kBinCount - 1];
+            uint32_t rightCount[kBinCount - 1];
+            BvhNode left = {glm::vec3(FLT_MAX), 0, glm::vec3(-FLT_MAX), 0};
+            BvhNode right = left;
+            uint32_t leftSum = 0, rightSum = 0;
+            for(uint32_t i = 0; i < binCount - 1; i++)
+            {
+                leftSum += bins[i].count;
+                leftCount[i] = leftSum;
+                left.boundsMin = glm::min(left.boundsMin, bins[i].bounds.boundsMin);
+                left.boundsMax = glm::max(left.boundsMax, bins[i].bounds.boundsMax);
+                leftArea[i] = left.getArea();
+
+                const uint32_t r = binCount - 1 - i;
+                rightSum += bins[r].count;
+                rightCount[r - 1] = rightSum;
+                right.boundsMin = glm::min(right.boundsMin, bins[r].bounds.boundsMin);
+                right.boundsMax = glm::max(right.boundsMax, bins[r].bounds.boundsMax);
+                rightArea[r - 1] = right.getArea();
+            }
+
+            for(uint32_t i = 0; i < binCount - 1; i++)
+            {
+                if(leftCount[i] == 0 || rightCount[i] == 0)
+                {
+                    continue;
+                }
+                float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if(cost < bestCost)
+                {
+                    bestCost = cost;
+                    axis = a;
+                    splitPos = centroidMin[a] + extent * float(i + 1) / binCount;
+                }
+            }
+        }
+
+        // Only split if it's cheaper than intersecting all of the primitives
+        const float leafCost = node.count * node.getArea();
+        return bestCost + kTraversalCost * node.getArea() < leafCost;
+    }
+
+    namespace
+    {
+        /** A node waiting to be split, and its depth in the tree
+        */
+        struct PendingNode
+        {
+            uint32_t index;
+            uint32_t depth;
+        };
+    }
+
+    /** Builds the subtree under nodes[root.index].
+        If pDeferred is not null, nodes with deferCount primitives or fewer are left unsplit and returned in pDeferred, so they can be built in parallel.
+    */
+    static void buildSubtree(std::vector<BvhNode>& nodes, const PendingNode& root, const BuildInput& input, std::vector<uint32_t>& primitiveIds, uint32_t deferCount, std::vector<PendingNode>* pDeferred)
+    {
+        // The caller reserves space for all of the nodes, which keeps the node references valid
+        std::vector<PendingNode> stack;
+        stack.push_back(root);
+        while(stack.empty() == false)
+        {
+            const PendingNode pending = stack.back();
+            BvhNode& node = nodes[pending.index];
+            stack.pop_back();
+            updateNodeBounds(node, input, primitiveIds);
+
+            if(pDeferred && node.count <= deferCount)
+            {
+                pDeferred->push_back(pending);
+                continue;
+            }
+
+            // Degenerate inputs can produce very unbalanced trees. Stop at the maximum depth, even if the leaf gets large.
+            uint32_t axis;
+            float splitPos;
+            if(node.count <= input.maxLeafSize || pending.depth >= kMaxBvhDepth || findSplit(node, input, primitiveIds, axis, splitPos) == false)
+            {
+                continue;
+            }
+
+            auto begin = primitiveIds.begin() + node.leftOrFirst;
+            auto middle = std::partition(begin, begin + node.count, [&](uint32_t prim) { return input.centroids[prim][axis] < splitPos; });
+            const uint32_t leftCount = (uint32_t)(middle - begin);
+            if(leftCount == 0 || leftCount == node.count)
+            {
+                continue;
+            }
+
+            const uint32_t leftIndex = (uint32_t)nodes.size();
+            nodes.push_back({glm::vec3(0), node.leftOrFirst, glm::vec3(0), leftCount});
+            nodes.push_back({glm::vec3(0), node.leftOrFirst + leftCount, glm::vec3(0), node.count - leftCount});
+            node.leftOrFirst = leftIndex;
+            node.count = 0;
+            stack.push_back({leftIndex + 1, pending.depth + 1});
+            stack.push_back({leftIndex, pending.depth + 1});
+        }
+    }
+
+    void buildSahBvh(const glm::vec3* pPrimMin, const glm::vec3* pPrimMax, uint32_t primCount, uint32_t maxLeafSize, std::vector<BvhNode>& nodes, std::vector<uint32_t>& primitiveIds)
+    {
+        BuildInput input;
+        input.pPrimMin = pPrimMin;
+        input.pPrimMax = pPrimMax;
+        input.maxLeafSize = std::max(maxLeafSize, 1u);
+        input.centroids.resize(primCount);
+        primitiveIds.resize(primCount);
+        for(uint32_t i = 0; i < primCount; i++)
+        {
+            input.centroids[i] = (pPrimMin[i] + pPrimMax[i]) * 0.5f;
+            primitiveIds[i] = i;
+        }
+
+        // A binary tree with N leaves has 2N - 1 nodes
+        nodes.clear();
+        nodes.reserve(primCount * 2);
+        nodes.push_back({glm::vec3(0), 0, glm::vec3(0), primCount});
+
+        const uint32_t threadCount = getParallelThreadCount();
+        if(primCount < kParallelBuildThreshold || threadCount == 1)
+        {
+            buildSubtree(nodes, {0, 0}, input, primitiveIds, 0, nullptr);
+            return;
+        }
+
+        // Split the top of the tree on this thread until there are enough subtrees to keep all of the threads busy
+        const uint32_t deferCount = std::max(primCount / (threadCount * 4), kParallelBuildThreshold / 4);
+        std::vector<PendingNode> deferred;
+        buildSubtree(nodes, {0, 0}, input, primitiveIds, deferCount, &deferred);
+
+        // The subtrees own disjoint ranges of primitiveIds, so they can be partitioned concurrently
+        std::vector<std::vector<BvhNode>> subtrees(deferred.size());
+        parallelFor((uint32_t)deferred.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                std::vector<BvhNode>& subtree = subtrees[i];
+                subtree.reserve(nodes[deferred[i].index].count * 2);
+                subtree.push_back(nodes[deferred[i].index]);
+                buildSubtree(subtree, {0, deferred[i].depth}, input, primitiveIds, 0, nullptr);
+            }
+        });
+
+        // Append the subtrees. Local node 0 is the subtree root, the rest are remapped to the end of the node list.
+        for(uint32_t i = 0; i < deferred.size(); i++)
+        {
+            const uint32_t base = (uint32_t)nodes.size() - 1;
+            for(uint32_t j = 0; j < subtrees[i].size(); j++)
+            {
+                BvhNode node = subtrees[i][j];
+                if(node.count == 0)
+                {
+                    node.leftOrFirst += base;
+                }
+
+                if(j == 0)
+                {
+                    nodes[deferred[i].index] = node;
+                }
+                else
+                {
+                    nodes.push_back(node);
+                }
+            }
+        }
+    }
+
+    Bvh::SharedPtr Bvh::create(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t triangleCount)
+    {
+        if(triangleCount == 0 || vertexCount == 0)
+        {
+            Logger::log(Logger::Level::Error, "Bvh::create() - can't build a BVH without triangles");
+            return nullptr;
+        }
+        SharedPtr pBvh = SharedPtr(new Bvh);
+        pBvh->build(pPositions, pIndices, triangleCount);
+        return pBvh;
+    }
+
+    void Bvh::build(const glm::vec3* pPositions, const uint32_t* pIndices, uint32_t triangleCount)
+    {
+        std::vector<glm::vec3> triMin(triangleCount);
+        std::vector<glm::vec3> triMax(triangleCount);
+        for(uint32_t i = 0; i < triangleCount; i++)
+        {
+            const glm::vec3& p0 = pPositions[pIndices[i * 3 + 0]];
+            const glm::vec3& p1 = pPositions[pIndices[i * 3 + 1]];
+            const glm::vec3& p2 = pPositions[pIndices[i * 3 + 2]];
+            triMin[i] = glm::min(p0, glm::min(p1, p2));
+            triMax[i] = glm::max(p0, glm::max(p1, p2));
+        }
+        buildSahBvh(triMin.data(), triMax.data(), triangleCount, 2, mNodes, mPrimitiveIds);
+
+        // Store the triangles in leaf order
+        mTriangles.resize(triangleCount);
+        for(uint32_t i = 0; i < triangleCount; i++)
+        {
+            const uint32_t tri = mPrimitiveIds[i];
+            const glm::vec3& p0 = pPositions[pIndices[tri * 3 + 0]];
+            mTriangles[i].v0 = p0;
+            mTriangles[i].e1 = pPositions[pIndices[tri * 3 + 1]] - p0;
+            mTriangles[i].e2 = pPositions[pIndices[tri * 3 + 2]] - p0;
+        }
+    }
+
+    BoundingBox Bvh::getBounds() const
+    {
+        return BoundingBox::fromMinMax(mNodes[0].boundsMin, mNodes[0].boundsMax);
+    }
+
+    bool Bvh::intersectTriangle(uint32_t index, const Ray& ray, Hit& hit) const
+    {
+        // Moller-Trumbore
+        const Triangle& tri = mTriangles[index];
+        glm::vec3 pvec = glm::cross(ray.direction, tri.e2);
+        float det = glm::dot(tri.e1, pvec);
+        if(fabs(det) < 1e-12f)
+        {
+            return false;
+        }
+        float invDet = 1.0f / det;
+        glm::vec3 tvec = ray.origin - tri.v0;
+        float u = glm::dot(tvec, pvec) * invDet;
+        if(u < 0 || u > 1)
+        {
+            return false;
+        }
+        glm::vec3 qvec = glm::cross(tvec, tri.e1);
+        float v = glm::dot(ray.direction, qvec) * invDet;
+        if(v < 0 || u + v > 1)
+        {
+            return false;
+        }
+        float t = glm::dot(tri.e2, qvec) * invDet;
+        if(t < ray.tMin || t >= hit.t)
+        {
+            return false;
+        }
+
+        hit.t = t;
+        hit.barycentrics = glm::vec2(u, v);
+        hit.primitiveId = mPrimitiveIds[index];
+        return true;
+    }
+
+    bool Bvh::intersect(const Ray& ray, Hit& hit, const HitFilter* pFilter) const
+    {
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        Hit closest = hit;
+        closest.t = std::min(hit.t, ray.tMax);
+        bool found = false;
+
+        float tEnter;
+        if(mNodes[0].intersect(ray.origin, invDir, ray.tMin, closest.t, tEnter) == false)
+        {
+            return false;
+        }
+
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            if(node.count > 0)
+            {
+                for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+                {
+                    Hit candidate = closest;
+                    if(intersectTriangle(i, ray, candidate) && (pFilter == nullptr || (*pFilter)(ray, candidate)))
+                    {
+                        closest = candidate;
+                        found = true;
+                    }
+                }
+                continue;
+            }
+
+            // Visit the nearer child first
+            const BvhNode& left = mNodes[node.leftOrFirst];
+            const BvhNode& right = mNodes[node.leftOrFirst + 1];
+            float tLeft, tRight;
+            bool hitLeft = left.intersect(ray.origin, invDir, ray.tMin, closest.t, tLeft);
+            bool hitRight = right.intersect(ray.origin, invDir, ray.tMin, closest.t, tRight);
+            if(hitLeft && hitRight)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[stackSize++] = leftFirst ? node.leftOrFirst + 1 : node.leftOrFirst;
+                stack[stackSize++] = leftFirst ? node.leftOrFirst : node.leftOrFirst + 1;
+            }
+            else if(hitLeft)
+            {
+                stack[stackSize++] = node.leftOrFirst;
+            }
+            else if(hitRight)
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+            }
+            assert(stackSize < kMaxStackDepth);
+        }
+        if(found)
+        {
+            hit = closest;
+        }
+        return found;
+    }
+
+    bool Bvh::occluded(const Ray& ray, const HitFilter* pFilter) const
+    {
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            float tEnter;
+            if(node.intersect(ray.origin, invDir, ray.tMin, ray.tMax, tEnter) == false)
+            {
+                continue;
+            }
+
+            if(node.count > 0)
+            {
+                for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+                {
+                    Hit candidate;
+                    candidate.t = ray.tMax;
+                    if(intersectTriangle(i, ray, candidate) && (pFilter == nullptr || (*pFilter)(ray, candidate)))
+                    {
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+                assert(stackSize < kMaxStackDepth);
+            }
+        }
+        return false;
+    }
+
+    void Bvh::intersect4(const Ray rays[4], Hit hits[4], uint32_t activeMask, const HitFilter* pFilter) const
+    {
+        // Load the packet in SoA form
+        __m128 origin[3], invDir[3], dir[3];
+        for(uint32_t a = 0; a < 3; a++)
+        {
+            origin[a] = _mm_setr_ps(rays[0].origin[a], rays[1].origin[a], rays[2].origin[a], rays[3].origin[a]);
+            dir[a] = _mm_setr_ps(rays[0].direction[a], rays[1].direction[a], rays[2].direction[a], rays[3].direction[a]);
+            invDir[a] = _mm_div_ps(_mm_set1_ps(1.0f), dir[a]);
+        }
+        const __m128 tMin = _mm_setr_ps(rays[0].tMin, rays[1].tMin, rays[2].tMin, rays[3].tMin);
+        float tMaxArray[4];
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            tMaxArray[i] = std::min(hits[i].t, rays[i].tMax);
+        }
+        __m128 tMax = _mm_loadu_ps(tMaxArray);
+
+        // Returns the mask of the rays which hit the box
+        auto testBox = [&](const BvhNode& node) -> int
+        {
+            __m128 tEnter = tMin;
+            __m128 tExit = tMax;
+            for(uint32_t a = 0; a < 3; a++)
+            {
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin[a]), origin[a]), invDir[a]);
+                __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax[a]), origin[a]), invDir[a]);
+                tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0, t1));
+                tExit = _mm_min_ps(tExit, _mm_max_ps(t0, t1));
+            }
+            return _mm_movemask_ps(_mm_cmple_ps(tEnter, tExit)) & activeMask;
+        };
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 eps = _mm_set1_ps(1e-12f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            if(testBox(node) == 0)
+            {
+                continue;
+            }
+
+            if(node.count == 0)
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+                assert(stackSize < kMaxStackDepth);
+                continue;
+            }
+
+            for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                // Moller-Trumbore, one triangle against 4 rays
+                const Triangle& tri = mTriangles[i];
+                __m128 e1[3] = {_mm_set1_ps(tri.e1.x), _mm_set1_ps(tri.e1.y), _mm_set1_ps(tri.e1.z)};
+                __m128 e2[3] = {_mm_set1_ps(tri.e2.x), _mm_set1_ps(tri.e2.y), _mm_set1_ps(tri.e2.z)};
+
+                __m128 pvec[3] =
+                {
+                    _mm_sub_ps(_mm_mul_ps(dir[1], e2[2]), _mm_mul_ps(dir[2], e2[1])),
+                    _mm_sub_ps(_mm_mul_ps(dir[2], e2[0]), _mm_mul_ps(dir[0], e2[2])),
+                    _mm_sub_ps(_mm_mul_ps(dir[0], e2[1]), _mm_mul_ps(dir[1], e2[0]))
+                };
+                __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], pvec[0]), _mm_mul_ps(e1[1], pvec[1])), _mm_mul_ps(e1[2], pvec[2]));
+                __m128 invDet = _mm_div_ps(one, det);
+
+                __m128 tvec[3] =
+                {
+                    _mm_sub_ps(origin[0], _mm_set1_ps(tri.v0.x)),
+                    _mm_sub_ps(origin[1], _mm_set1_ps(tri.v0.y)),
+                    _mm_sub_ps(origin[2], _mm_set1_ps(tri.v0.z))
+                };
+                __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tvec[0], pvec[0]), _mm_mul_ps(tvec[1], pvec[1])), _mm_mul_ps(tvec[2], pvec[2])), invDet);
+
+                __m128 qvec[3] =
+                {
+                    _mm_sub_ps(_mm_mul_ps(tvec[1], e1[2]), _mm_mul_ps(tvec[2], e1[1])),
+                    _mm_sub_ps(_mm_mul_ps(tvec[2], e1[0]), _mm_mul_ps(tvec[0], e1[2])),
+                    _mm_sub_ps(_mm_mul_ps(tvec[0], e1[1]), _mm_mul_ps(tvec[1], e1[0]))
+                };
+                __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dir[0], qvec[0]), _mm_mul_ps(dir[1], qvec[1])), _mm_mul_ps(dir[2], qvec[2])), invDet);
+                __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], qvec[0]), _mm_mul_ps(e2[1], qvec[1])), _mm_mul_ps(e2[2], qvec[2])), invDet);
+
+                __m128 valid = _mm_cmpgt_ps(_mm_and_ps(det, absMask), eps);
+                valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+                valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+                valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                valid = _mm_and_ps(valid, _mm_cmpge_ps(t, tMin));
+                valid = _mm_and_ps(valid, _mm_cmplt_ps(t, tMax));
+                int mask = _mm_movemask_ps(valid) & activeMask;
+                if(mask == 0)
+                {
+                    continue;
+                }
+
+                float tArray[4], uArray[4], vArray[4];
+                _mm_storeu_ps(tArray, t);
+                _mm_storeu_ps(uArray, u);
+                _mm_storeu_ps(vArray, v);
+                _mm_storeu_ps(tMaxArray, tMax);
+                for(uint32_t r = 0; r < 4; r++)
+                {
+                    if(mask & (1 << r))
+                    {
+                        Hit candidate = hits[r];
+                        candidate.t = tArray[r];
+                        candidate.barycentrics = glm::vec2(uArray[r], vArray[r]);
+                        candidate.primitiveId = mPrimitiveIds[i];
+                        if(pFilter == nullptr || (*pFilter)(rays[r], candidate))
+                        {
+                            hits[r] = candidate;
+                            tMaxArray[r] = candidate.t;
+                        }
+                    }
+                }
+                tMax = _mm_loadu_ps(tMaxArray);
+            }
+        }
+    }
+}
+}
\ No newline at end of file
@@ -0,0 +1,185 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <float.h>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/common.hpp"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+namespace RT
+{
+    /** A ray for the CPU ray-tracer
+    */
+    struct Ray
+    {
+        glm::vec3 origin;
+        float tMin = 0;
+        glm::vec3 direction;
+        float tMax = FLT_MAX;
+    };
+
+    /** Ray-triangle intersection result
+    */
+    struct Hit
+    {
+        static const uint32_t kInvalidId = uint32_t(-1);
+        float t = FLT_MAX;                  ///< Distance along the ray
+        glm::vec2 barycentrics;             ///< Barycentrics of the 2nd and 3rd vertices
+        uint32_t primitiveId = kInvalidId;  ///< Index of the triangle
+        uint32_t instanceId = kInvalidId;   ///< Index of the geometry instance. Set by the context, not by Bvh.
+
+        bool isValid() const { return primitiveId != kInvalidId; }
+    };
+
+    /** Called for each candidate intersection. Return false to ignore the hit (for example, alpha-tested geometry).
+    */
+    using HitFilter = std::function<bool(const Ray& ray, const Hit& hit)>;
+
+    /** A BVH node. Used by both the triangle and the instance hierarchies.
+    */
+    struct BvhNode
+    {
+        glm::vec3 boundsMin;
+        uint32_t leftOrFirst;   ///< Interior nodes: index of the left child, the right child follows it. Leaves: first primitive.
+        glm::vec3 boundsMax;
+        uint32_t count;         ///< Number of primitives, 0 for interior nodes
+
+        float getArea() const
+        {
+            glm::vec3 e = boundsMax - boundsMin;
+            return (e.x < 0) ? 0.0f : 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+
+        /** Ray-box slab test
+            \param[out] tEnter The distance at which the ray enters the box
+            \return true if the ray overlaps the box between tMin and tMax
+        */
+        bool intersect(const glm::vec3& origin, const glm::vec3& invDir, float tMin, float tMax, float& tEnter) const
+        {
+            glm::vec3 t0 = (boundsMin - origin) * invDir;
+            glm::vec3 t1 = (boundsMax - origin) * invDir;
+            glm::vec3 tNear = glm::min(t0, t1);
+            glm::vec3 tFar = glm::max(t0, t1);
+            tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tMin));
+            float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+            return tEnter <= tExit;
+        }
+    };
+
+    /** Build a BVH over a set of bounding boxes with the binned surface-area heuristic. Large inputs are built in parallel.
+        Child nodes are always stored after their parent and siblings are adjacent.
+        \param[in] pPrimMin Per-primitive bounding-box minimum
+        \param[in] pPrimMax Per-primitive bounding-box maximum
+        \param[in] primCount Number of primitives
+        \param[in] maxLeafSize Nodes with this many primitives or fewer are never split
+        \param[out] nodes The nodes. The root is the first node.
+        \param[out] primitiveIds The primitive indices in leaf order
+    */
+    void buildSahBvh(const glm::vec3* pPrimMin, const glm::vec3* pPrimMax, uint32_t primCount, uint32_t maxLeafSize, std::vector<BvhNode>& nodes, std::vector<uint32_t>& primitiveIds);
+
+    /** The maximum depth of the trees built by buildSahBvh(). Deeper nodes are left as leaves, whatever their size, so that traversal can use fixed-size stacks.
+    */
+    static const uint32_t kMaxBvhDepth = 64;
+
+    /** Bounding volume hierarchy over a triangle list, built with the binned surface-area heuristic.
+        Supports single rays and 4-ray packets traced with SSE.
+    */
+    class Bvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<Bvh>;
+        using SharedConstPtr = std::shared_ptr<const Bvh>;
+
+        /** Build a BVH
+            \param[in] pPositions Vertex positions
+            \param[in] vertexCount Number of vertices
+            \param[in] pIndices Triangle list indices
+            \param[in] triangleCount Number of triangles
+            \return A new object, or nullptr if there are no triangles
+        */
+        static SharedPtr create(const glm::vec3* pPositions, uint32_t vertexCount, const uint32_t* pIndices, uint32_t triangleCount);
+
+        /** Find the closest intersection
+            \param[in] ray The ray
+            \param[in,out] hit The closest hit. Only hits closer than ray.tMax are reported.
+            \param[in] pFilter Optional. Called for each candidate hit.
+            \return true if a hit was found
+        */
+        bool intersect(const Ray& ray, Hit& hit, const HitFilter* pFilter = nullptr) const;
+
+        /** Check if there is any intersection along the ray. Stops at the first hit.
+        */
+        bool occluded(const Ray& ray, const HitFilter* pFilter = nullptr) const;
+
+        /** Find the closest intersections of 4 rays. The rays are traversed together, which is efficient for coherent rays.
+            \param[in] rays The rays
+            \param[in,out] hits The closest hits
+            \param[in] activeMask Bit i set means ray i is traced
+            \param[in] pFilter Optional. Called for each candidate hit.
+        */
+        void intersect4(const Ray rays[4], Hit hits[4], uint32_t activeMask = 0xF, const HitFilter* pFilter = nullptr) const;
+
+        /** Get the bounds of the geometry
+        */
+        BoundingBox getBounds() const;
+
+        /** Get the number of triangles
+        */
+        uint32_t getTriangleCount() const { return (uint32_t)mTriangles.size(); }
+
+        /** Get the number of nodes
+        */
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+    private:
+        Bvh() = default;
+
+        /** Triangles are stored pre-processed for the intersection test, in leaf order
+        */
+        struct Triangle
+        {
+            glm::vec3 v0;
+            glm::vec3 e1;
+            glm::vec3 e2;
+        };
+
+        void build(const glm::vec3* pPositions, const uint32_t* pIndices, uint32_t triangleCount);
+        bool intersectTriangle(uint32_t index, const Ray& ray, Hit& hit) const;
+
+        std::vector<BvhNode> mNodes;
+        std::vector<Triangle> mTriangles;
+        std::vector<uint32_t> mPrimitiveIds;    ///< Maps a leaf-ordered triangle to the original triangle index
+    };
+}
+}
\ No newline at end of file
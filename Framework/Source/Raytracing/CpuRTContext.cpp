@@ -0,0 +1,368 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuRTContext.h"
+#include "Data/VertexAttrib.h"
+#include "Utils/ParallelFor.h"
+#include "glm/geometric.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+#include <algorithm>
+
+namespace Falcor
+{
+namespace RT
+{
+    static const uint32_t kTileSize = 8;
+
+    CpuRTContext::Image::SharedPtr CpuRTContext::Image::create(uint32_t width, uint32_t height)
+    {
+        if(width == 0 || height == 0)
+        {
+            Logger::log(Logger::Level::Error, "CpuRTContext::Image::create() - image dimensions must be greater than zero");
+            return nullptr;
+        }
+        return SharedPtr(new Image(width, height));
+    }
+
+    void CpuRTContext::Image::saveToFile(const std::string& filename, Bitmap::FileFormat format) const
+    {
+        if(format == Bitmap::FileFormat::PfmFile)
+        {
+            Bitmap::saveImage(filename, mWidth, mHeight, format, sizeof(glm::vec4), true, (void*)mPixels.data());
+            return;
+        }
+
+        std::vector<uint8_t> rgba8(mPixels.size() * 4);
+        for(size_t i = 0; i < mPixels.size(); i++)
+        {
+            glm::vec4 c = glm::clamp(mPixels[i], 0.0f, 1.0f);
+            for(uint32_t ch = 0; ch < 4; ch++)
+            {
+                rgba8[i * 4 + ch] = (uint8_t)(c[ch] * 255.0f + 0.5f);
+            }
+        }
+        Bitmap::saveImage(filename, mWidth, mHeight, format, 4, true, rgba8.data());
+    }
+
+    CpuRTContext::SharedPtr CpuRTContext::create()
+    {
+        return SharedPtr(new CpuRTContext);
+    }
+
+    void CpuRTContext::newScene()
+    {
+        mMeshCache.clear();
+        mInstances.clear();
+        mPositions.clear();
+        mNormals.clear();
+        mTexCoords.clear();
+        mIndices.clear();
+        mpBvh = nullptr;
+        mDirty = false;
+    }
+
+    void CpuRTContext::newScene(const Scene::SharedPtr& pScene)
+    {
+        newScene();
+        for(uint32_t modelId = 0; modelId < pScene->getModelCount(); modelId++)
+        {
+            for(uint32_t instanceId = 0; instanceId < pScene->getModelInstanceCount(modelId); instanceId++)
+            {
+                const Scene::ModelInstance& instance = pScene->getModelInstance(modelId, instanceId);
+                if(instance.isVisible)
+                {
+                    addObject(pScene->getModel(modelId), instance.transformMatrix);
+                }
+            }
+        }
+    }
+
+    const CpuRTContext::MeshData& CpuRTContext::getMeshData(const Mesh* pMesh)
+    {
+        // Meshes are often instanced, only read them back once
+        auto it = mMeshCache.find(pMesh);
+        if(it != mMeshCache.end())
+        {
+            return it->second;
+        }
+
+        MeshData& data = mMeshCache[pMesh];
+        data.positions = pMesh->readVertexAttribute(VERTEX_POSITION_LOC);
+        data.normals = pMesh->readVertexAttribute(VERTEX_NORMAL_LOC);
+        data.texCoords = pMesh->readVertexAttribute(VERTEX_TEXCOORD_LOC);
+        data.indices = pMesh->readIndices();
+        return data;
+    }
+
+    void CpuRTContext::addObject(const Model::SharedPtr& pModel, const glm::mat4& transform)
+    {
+        for(uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
+        {
+            const Mesh::SharedPtr& pMesh = pModel->getMesh(meshId);
+            if(pMesh->getTopology() != RenderContext::Topology::TriangleList)
+            {
+                Logger::log(Logger::Level::Error, "Submesh of a model '" + pModel->getName() + "' has unsupported geometry topology (only triangle list is supported)");
+                continue;
+            }
+
+            const MeshData& data = getMeshData(pMesh.get());
+            if(data.positions.empty() || data.indices.empty())
+            {
+                Logger::log(Logger::Level::Error, "A submesh in model '" + pModel->getName() + "' has no positions or indices");
+                continue;
+            }
+
+            for(uint32_t meshInstance = 0; meshInstance < pMesh->getInstanceCount(); meshInstance++)
+            {
+                const glm::mat4 world = transform * pMesh->getInstanceMatrix(meshInstance);
+                const glm::mat3 normalMat = glm::inverseTranspose(glm::mat3(world));
+
+                Instance instance;
+                instance.pMesh = pMesh;
+                instance.firstVertex = (uint32_t)mPositions.size();
+                instance.firstTriangle = (uint32_t)mIndices.size() / 3;
+                instance.hasNormals = data.normals.empty() == false;
+                instance.hasTexCoords = data.texCoords.empty() == false;
+                mInstances.push_back(instance);
+
+                for(size_t v = 0; v < data.positions.size(); v++)
+                {
+                    mPositions.push_back(glm::vec3(world * glm::vec4(data.positions[v], 1.0f)));
+                    mNormals.push_back(instance.hasNormals ? glm::normalize(normalMat * data.normals[v]) : glm::vec3(0));
+                    mTexCoords.push_back(instance.hasTexCoords ? glm::vec2(data.texCoords[v]) : glm::vec2(0));
+                }
+                for(uint32_t index : data.indices)
+                {
+                    mIndices.push_back(instance.firstVertex + index);
+                }
+            }
+        }
+        mDirty = true;
+    }
+
+    void CpuRTContext::resolveInstance(Hit& hit) const
+    {
+        // Find the last instance starting at or before the primitive
+        auto it = std::upper_bound(mInstances.begin(), mInstances.end(), hit.primitiveId, [](uint32_t primitiveId, const Instance& instance) { return primitiveId < instance.firstTriangle; });
+        hit.instanceId = (uint32_t)(it - mInstances.begin()) - 1;
+        hit.primitiveId -= mInstances[hit.instanceId].firstTriangle;
+    }
+
+    void CpuRTContext::updateScene()
+    {
+        if(mDirty)
+        {
+            mpBvh = mIndices.empty() ? nullptr : Bvh::create(mPositions.data(), (uint32_t)mPositions.size(), mIndices.data(), (uint32_t)mIndices.size() / 3);
+            mDirty = false;
+        }
+
+        // The user routine sees instance-relative primitive IDs
+        mBvhFilter = nullptr;
+        if(mAnyHit)
+        {
+            mBvhFilter = [this](const Ray& ray, const Hit& hit)
+            {
+                Hit resolved = hit;
+                resolveInstance(resolved);
+                return mAnyHit(ray, resolved);
+            };
+        }
+    }
+
+    bool CpuRTContext::trace(const Ray& ray, Hit& hit) const
+    {
+        assert(mDirty == false);
+        mRayCount++;
+        if(mpBvh && mpBvh->intersect(ray, hit, mBvhFilter ? &mBvhFilter : nullptr))
+        {
+            resolveInstance(hit);
+            return true;
+        }
+        return false;
+    }
+
+    bool CpuRTContext::occluded(const Ray& ray) const
+    {
+        assert(mDirty == false);
+        mRayCount++;
+        return mpBvh && mpBvh->occluded(ray, mBvhFilter ? &mBvhFilter : nullptr);
+    }
+
+    void CpuRTContext::trace4(const Ray rays[4], Hit hits[4], uint32_t activeMask) const
+    {
+        assert(mDirty == false);
+        if(mpBvh == nullptr)
+        {
+            return;
+        }
+
+        uint32_t rayCount = 0;
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            rayCount += (activeMask >> i) & 1;
+        }
+        mRayCount += rayCount;
+
+        mpBvh->intersect4(rays, hits, activeMask, mBvhFilter ? &mBvhFilter : nullptr);
+        for(uint32_t i = 0; i < 4; i++)
+        {
+            if(((activeMask >> i) & 1) && hits[i].isValid())
+            {
+                resolveInstance(hits[i]);
+            }
+        }
+    }
+
+    CpuRTContext::HitAttributes CpuRTContext::getHitAttributes(const Ray& ray, const Hit& hit) const
+    {
+        assert(hit.isValid());
+        const Instance& instance = mInstances[hit.instanceId];
+        const uint32_t* pIndices = &mIndices[(instance.firstTriangle + hit.primitiveId) * 3];
+        const glm::vec3 bary(1.0f - hit.barycentrics.x - hit.barycentrics.y, hit.barycentrics.x, hit.barycentrics.y);
+
+        HitAttributes attribs;
+        attribs.pMesh = instance.pMesh;
+        attribs.position = ray.origin + ray.direction * hit.t;
+
+        const glm::vec3& p0 = mPositions[pIndices[0]];
+        attribs.geometricNormal = glm::normalize(glm::cross(mPositions[pIndices[1]] - p0, mPositions[pIndices[2]] - p0));
+        if(glm::dot(attribs.geometricNormal, ray.direction) > 0)
+        {
+            attribs.geometricNormal = -attribs.geometricNormal;
+        }
+
+        attribs.normal = attribs.geometricNormal;
+        if(instance.hasNormals)
+        {
+            attribs.normal = glm::normalize(mNormals[pIndices[0]] * bary.x + mNormals[pIndices[1]] * bary.y + mNormals[pIndices[2]] * bary.z);
+        }
+        attribs.texCoord = mTexCoords[pIndices[0]] * bary.x + mTexCoords[pIndices[1]] * bary.y + mTexCoords[pIndices[2]] * bary.z;
+        return attribs;
+    }
+
+    Ray CpuRTContext::generateCameraRay(const Camera* pCamera, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+    {
+        const glm::mat4& invViewProj = pCamera->getInvViewProjMatrix();
+        const glm::vec2 ndc(2.0f * (x + 0.5f) / width - 1.0f, 1.0f - 2.0f * (y + 0.5f) / height);
+        // Falcor's projection matrices map the near plane to 0 and the far plane to 1 with both APIs (the GL backend uses glClipControl())
+        glm::vec4 nearPos = invViewProj * glm::vec4(ndc, 0.0f, 1.0f);
+        glm::vec4 farPos = invViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+
+        Ray ray;
+        ray.origin = glm::vec3(nearPos) / nearPos.w;
+        ray.direction = glm::normalize(glm::vec3(farPos) / farPos.w - ray.origin);
+        return ray;
+    }
+
+    void CpuRTContext::beginStats()
+    {
+        mRayCount = 0;
+        mStartTime = CpuTimer::getCurrentTimePoint();
+    }
+
+    void CpuRTContext::endStats()
+    {
+        mStats.rayCount = mRayCount;
+        mStats.timeInMs = CpuTimer::calcDuration(mStartTime, CpuTimer::getCurrentTimePoint());
+        mStats.raysPerSecond = (mStats.timeInMs > 0) ? double(mStats.rayCount) * 1000.0 / mStats.timeInMs : 0;
+    }
+
+    void CpuRTContext::render(Image* pImage, const Camera* pCamera, const ClosestHitFunc& closestHit, const MissFunc& miss)
+    {
+        updateScene();
+        beginStats();
+
+        const uint32_t width = pImage->getWidth();
+        const uint32_t height = pImage->getHeight();
+        const uint32_t tilesX = (width + kTileSize - 1) / kTileSize;
+        const uint32_t tilesY = (height + kTileSize - 1) / kTileSize;
+
+        parallelFor(tilesX * tilesY, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t tile = begin; tile < end; tile++)
+            {
+                const uint32_t tileX = (tile % tilesX) * kTileSize;
+                const uint32_t tileY = (tile / tilesX) * kTileSize;
+
+                // Trace 2x2 pixel quads
+                for(uint32_t y = tileY; y < std::min(tileY + kTileSize, height); y += 2)
+                {
+                    for(uint32_t x = tileX; x < std::min(tileX + kTileSize, width); x += 2)
+                    {
+                        Ray rays[4];
+                        Hit hits[4];
+                        uint32_t activeMask = 0;
+                        for(uint32_t i = 0; i < 4; i++)
+                        {
+                            const uint32_t px = x + (i & 1);
+                            const uint32_t py = y + (i >> 1);
+                            if(px < width && py < height)
+                            {
+                                rays[i] = generateCameraRay(pCamera, px, py, width, height);
+                                activeMask |= 1 << i;
+                            }
+                        }
+
+                        trace4(rays, hits, activeMask);
+                        for(uint32_t i = 0; i < 4; i++)
+                        {
+                            if(activeMask & (1 << i))
+                            {
+                                glm::vec4 color = hits[i].isValid() ? closestHit(rays[i], hits[i]) : miss(rays[i]);
+                                pImage->setPixel(x + (i & 1), y + (i >> 1), color);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+        endStats();
+    }
+
+    void CpuRTContext::launch(Image* pImage, const RayGenFunc& rayGen)
+    {
+        updateScene();
+        beginStats();
+
+        const uint32_t width = pImage->getWidth();
+        parallelFor(pImage->getHeight(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t y = begin; y < end; y++)
+            {
+                for(uint32_t x = 0; x < width; x++)
+                {
+                    pImage->setPixel(x, y, rayGen(x, y));
+                }
+            }
+        });
+
+        endStats();
+    }
+}
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <map>
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "Raytracing/CpuBvh.h"
+#include "Graphics/Scene/Scene.h"
+#include "Utils/Bitmap.h"
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+namespace RT
+{
+    /** CPU ray-tracing context.
+        A software counterpart of RTContext which doesn't need a GPU. It imports the same geometry as RTContext::newScene(), builds a SAH BVH over it, and traces rays on all of the CPU cores.
+        Shading routines are C++ callbacks. Primary rays are traced in 2x2 packets using SSE.
+    */
+    class CpuRTContext
+    {
+    public:
+        using SharedPtr = std::shared_ptr<CpuRTContext>;
+        using SharedConstPtr = std::shared_ptr<const CpuRTContext>;
+
+        /** An RGBA float image the context renders into
+        */
+        class Image
+        {
+        public:
+            using SharedPtr = std::shared_ptr<Image>;
+            static SharedPtr create(uint32_t width, uint32_t height);
+
+            uint32_t getWidth() const { return mWidth; }
+            uint32_t getHeight() const { return mHeight; }
+
+            /** Get a pixel. (0, 0) is the top-left pixel.
+            */
+            const glm::vec4& getPixel(uint32_t x, uint32_t y) const { return mPixels[y * mWidth + x]; }
+            void setPixel(uint32_t x, uint32_t y, const glm::vec4& value) { mPixels[y * mWidth + x] = value; }
+            const glm::vec4* getData() const { return mPixels.data(); }
+
+            /** Save the image. PNG files are clamped to [0, 1] and quantized to 8 bits per channel.
+            */
+            void saveToFile(const std::string& filename, Bitmap::FileFormat format) const;
+
+        private:
+            Image(uint32_t width, uint32_t height) : mWidth(width), mHeight(height), mPixels(width * height) {}
+            uint32_t mWidth;
+            uint32_t mHeight;
+            std::vector<glm::vec4> mPixels;
+        };
+
+        /** Surface attributes at a hit point, in world space
+        */
+        struct HitAttributes
+        {
+            glm::vec3 position;
+            glm::vec3 geometricNormal;      ///< Normalized, facing the ray origin
+            glm::vec3 normal;               ///< Interpolated vertex normal. Same as geometricNormal if the mesh has no normals.
+            glm::vec2 texCoord;             ///< Zero if the mesh has no texture coordinates
+            Mesh::SharedPtr pMesh;
+        };
+
+        /** Closest-hit routine. Returns the value written to the image.
+        */
+        using ClosestHitFunc = std::function<glm::vec4(const Ray& ray, const Hit& hit)>;
+
+        /** Miss routine. Returns the value written to the image.
+        */
+        using MissFunc = std::function<glm::vec4(const Ray& ray)>;
+
+        /** Ray-generation routine for launch(). Called once per pixel, returns the value written to the image.
+        */
+        using RayGenFunc = std::function<glm::vec4(uint32_t x, uint32_t y)>;
+
+        /** Performance counters of the last render() or launch() call
+        */
+        struct Stats
+        {
+            uint64_t rayCount = 0;
+            float timeInMs = 0;
+            double raysPerSecond = 0;
+        };
+
+        /** Creates a new instance.
+        */
+        static SharedPtr create();
+
+        /** Creates a new, empty scene
+        */
+        void newScene();
+
+        /** Creates a new scene from a Falcor scene. Like RTContext, only the geometry is imported. All the visible model instances are added.
+        */
+        void newScene(const Scene::SharedPtr& pScene);
+
+        /** Adds a model to the scene. The model's geometry is read back from the GPU and transformed to world space.
+            \param[in] pModel The model
+            \param[in] transform Model-to-world transformation. It is combined with the mesh instance matrices.
+        */
+        void addObject(const Model::SharedPtr& pModel, const glm::mat4& transform = glm::mat4());
+
+        /** Sets a routine called for every candidate intersection, for example to implement alpha testing. Pass nullptr to remove it.
+        */
+        void setAnyHitRoutine(const HitFilter& anyHit) { mAnyHit = anyHit; }
+
+        /** Builds the acceleration structure if objects were added. render() and launch() call it automatically, call it before using trace() directly.
+        */
+        void updateScene();
+
+        /** Finds the closest intersection along a ray. Thread-safe.
+            \return true if something was hit
+        */
+        bool trace(const Ray& ray, Hit& hit) const;
+
+        /** Checks if anything intersects a ray. Cheaper than trace(). Thread-safe.
+        */
+        bool occluded(const Ray& ray) const;
+
+        /** Traces a packet of 4 rays. Thread-safe.
+            \param[in] rays The rays
+            \param[out] hits The closest hits
+            \param[in] activeMask Bit i set means ray i is traced
+        */
+        void trace4(const Ray rays[4], Hit hits[4], uint32_t activeMask = 0xF) const;
+
+        /** Computes the surface attributes of a hit
+        */
+        HitAttributes getHitAttributes(const Ray& ray, const Hit& hit) const;
+
+        /** Generates a pinhole camera ray through a pixel center. The ray starts on the camera's near plane.
+            \param[in] pCamera The camera
+            \param[in] x Pixel X coordinate, left to right
+            \param[in] y Pixel Y coordinate, top to bottom
+            \param[in] width Image width
+            \param[in] height Image height
+        */
+        static Ray generateCameraRay(const Camera* pCamera, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+        /** Renders the scene from a camera, one primary ray per pixel.
+            \param[in] pImage The destination image
+            \param[in] pCamera The camera
+            \param[in] closestHit Called for each primary ray that hit the scene
+            \param[in] miss Called for each primary ray that missed the scene
+        */
+        void render(Image* pImage, const Camera* pCamera, const ClosestHitFunc& closestHit, const MissFunc& miss);
+
+        /** Runs a ray-generation routine for every pixel of an image, using all of the cores. Use this for AO baking and other custom passes.
+        */
+        void launch(Image* pImage, const RayGenFunc& rayGen);
+
+        /** Get the statistics of the last render() or launch() call
+        */
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        CpuRTContext() : mRayCount(0) {}
+
+        struct MeshData
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec3> texCoords;
+            std::vector<uint32_t> indices;
+        };
+
+        struct Instance
+        {
+            Mesh::SharedPtr pMesh;
+            uint32_t firstVertex;
+            uint32_t firstTriangle;
+            bool hasNormals;
+            bool hasTexCoords;
+        };
+
+        const MeshData& getMeshData(const Mesh* pMesh);
+        void beginStats();
+        void endStats();
+        void resolveInstance(Hit& hit) const;
+
+        std::map<const Mesh*, MeshData> mMeshCache;
+        std::vector<Instance> mInstances;
+
+        // World-space geometry of all of the instances
+        std::vector<glm::vec3> mPositions;
+        std::vector<glm::vec3> mNormals;
+        std::vector<glm::vec2> mTexCoords;
+        std::vector<uint32_t> mIndices;
+
+        Bvh::SharedPtr mpBvh;
+        bool mDirty = false;
+        HitFilter mAnyHit;
+        HitFilter mBvhFilter;   ///< Wraps mAnyHit, converting the BVH's primitive IDs to instance IDs
+
+        mutable std::atomic<uint64_t> mRayCount;
+        CpuTimer::TimePoint mStartTime;
+        Stats mStats;
+    };
+}
+}
\ No newline at end of file
@@ -0,0 +1,460 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "CpuTwoLevelBvh.h"
+#include "Data/VertexAttrib.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/CpuTimer.h"
+#include "glm/mat3x3.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+
+namespace Falcor
+{
+namespace RT
+{
+    static const uint32_t kMaxStackDepth = 128;
+    static_assert(kMaxStackDepth > kMaxBvhDepth + 1, "The top-level tree is built with buildSahBvh(), so its depth is bounded by kMaxBvhDepth");
+
+    TwoLevelBvh::SharedPtr TwoLevelBvh::create()
+    {
+        return SharedPtr(new TwoLevelBvh);
+    }
+
+    TwoLevelBvh::SharedPtr TwoLevelBvh::create(const Scene::SharedPtr& pScene)
+    {
+        SharedPtr pBvh = create();
+        pBvh->mpScene = pScene;
+
+        // Instanced meshes share the bottom level
+        std::map<const Mesh*, Bvh::SharedConstPtr> bottomLevels;
+        for(uint32_t modelId = 0; modelId < pScene->getModelCount(); modelId++)
+        {
+            const Model::SharedPtr& pModel = pScene->getModel(modelId);
+            for(uint32_t meshId = 0; meshId < pModel->getMeshCount(); meshId++)
+            {
+                const Mesh::SharedPtr& pMesh = pModel->getMesh(meshId);
+                if(pMesh->getTopology() != RenderContext::Topology::TriangleList)
+                {
+                    Logger::log(Logger::Level::Error, "Submesh of a model '" + pModel->getName() + "' has unsupported geometry topology (only triangle list is supported)");
+                    continue;
+                }
+
+                Bvh::SharedConstPtr& pBottomLevel = bottomLevels[pMesh.get()];
+                if(pBottomLevel == nullptr)
+                {
+                    std::vector<glm::vec3> positions = pMesh->readVertexAttribute(VERTEX_POSITION_LOC);
+                    std::vector<uint32_t> indices = pMesh->readIndices();
+                    pBottomLevel = Bvh::create(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size() / 3);
+                    if(pBottomLevel == nullptr)
+                    {
+                        continue;
+                    }
+                }
+
+                for(uint32_t modelInstanceId = 0; modelInstanceId < pScene->getModelInstanceCount(modelId); modelInstanceId++)
+                {
+                    const Scene::ModelInstance& modelInstance = pScene->getModelInstance(modelId, modelInstanceId);
+                    for(uint32_t meshInstanceId = 0; meshInstanceId < pMesh->getInstanceCount(); meshInstanceId++)
+                    {
+                        SceneRef ref;
+                        ref.modelId = modelId;
+                        ref.modelInstanceId = modelInstanceId;
+                        ref.meshTransform = pMesh->getInstanceMatrix(meshInstanceId);
+                        ref.pMesh = pMesh;
+                        pBvh->mSceneRefs.push_back(ref);
+
+                        uint32_t instanceId = pBvh->addInstance(pBottomLevel, modelInstance.transformMatrix * ref.meshTransform);
+                        pBvh->setVisible(instanceId, modelInstance.isVisible);
+                    }
+                }
+            }
+        }
+        return pBvh;
+    }
+
+    uint32_t TwoLevelBvh::addInstance(const Bvh::SharedConstPtr& pBottomLevel, const glm::mat4& transform)
+    {
+        Instance instance;
+        instance.pBottomLevel = pBottomLevel;
+        instance.transform = transform;
+        mInstances.push_back(instance);
+        mInstanceMin.push_back(glm::vec3(0));
+        mInstanceMax.push_back(glm::vec3(0));
+
+        const uint32_t instanceId = (uint32_t)mInstances.size() - 1;
+        mDirtyInstances.push_back(instanceId);
+        mNeedsRebuild = true;
+        return instanceId;
+    }
+
+    void TwoLevelBvh::setTransform(uint32_t instanceId, const glm::mat4& transform)
+    {
+        Instance& instance = mInstances[instanceId];
+        instance.transform = transform;
+        if(instance.isDirty == false)
+        {
+            instance.isDirty = true;
+            mDirtyInstances.push_back(instanceId);
+        }
+    }
+
+    void TwoLevelBvh::updateFromScene()
+    {
+        if(mpScene == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "TwoLevelBvh::updateFromScene() - the hierarchy wasn't created from a scene");
+            return;
+        }
+
+        for(uint32_t instanceId = 0; instanceId < mSceneRefs.size(); instanceId++)
+        {
+            const SceneRef& ref = mSceneRefs[instanceId];
+            const Scene::ModelInstance& modelInstance = mpScene->getModelInstance(ref.modelId, ref.modelInstanceId);
+            const glm::mat4 transform = modelInstance.transformMatrix * ref.meshTransform;
+            if(transform != mInstances[instanceId].transform)
+            {
+                setTransform(instanceId, transform);
+            }
+            setVisible(instanceId, modelInstance.isVisible);
+        }
+    }
+
+    void TwoLevelBvh::updateInstances()
+    {
+        // Transform the bottom-level bounds of the instances which moved
+        parallelFor((uint32_t)mDirtyInstances.size(), 256, [this](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                const uint32_t instanceId = mDirtyInstances[i];
+                Instance& instance = mInstances[instanceId];
+                instance.invTransform = glm::inverse(instance.transform);
+                instance.isDirty = false;
+
+                BoundingBox box = instance.pBottomLevel->getBounds().transform(instance.transform);
+                mInstanceMin[instanceId] = box.center - box.extent;
+                mInstanceMax[instanceId] = box.center + box.extent;
+            }
+        });
+        mDirtyInstances.clear();
+    }
+
+    float TwoLevelBvh::refit()
+    {
+        // Leaves are independent of each other
+        parallelFor((uint32_t)mNodes.size(), 1024, [this](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                BvhNode& node = mNodes[i];
+                if(node.count > 0)
+                {
+                    node.boundsMin = glm::vec3(FLT_MAX);
+                    node.boundsMax = glm::vec3(-FLT_MAX);
+                    for(uint32_t j = node.leftOrFirst; j < node.leftOrFirst + node.count; j++)
+                    {
+                        node.boundsMin = glm::min(node.boundsMin, mInstanceMin[mLeafInstances[j]]);
+                        node.boundsMax = glm::max(node.boundsMax, mInstanceMax[mLeafInstances[j]]);
+                    }
+                }
+            }
+        });
+
+        // Children are stored after their parents, so a reverse sweep visits the children first. This also sums up the SAH cost.
+        float cost = 0;
+        for(uint32_t i = (uint32_t)mNodes.size(); i-- > 0;)
+        {
+            BvhNode& node = mNodes[i];
+            if(node.count == 0)
+            {
+                const BvhNode& left = mNodes[node.leftOrFirst];
+                const BvhNode& right = mNodes[node.leftOrFirst + 1];
+                node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+                node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+                cost += node.getArea();
+            }
+            else
+            {
+                cost += node.getArea() * node.count;
+            }
+        }
+
+        const float rootArea = mNodes[0].getArea();
+        return (rootArea > 0) ? cost / rootArea : 0;
+    }
+
+    void TwoLevelBvh::rebuild()
+    {
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        updateInstances();
+        mNodes.clear();
+        mLeafInstances.clear();
+        if(mInstances.size())
+        {
+            buildSahBvh(mInstanceMin.data(), mInstanceMax.data(), (uint32_t)mInstances.size(), 1, mNodes, mLeafInstances);
+            mBuildSahCost = refit();
+        }
+        mNeedsRebuild = false;
+
+        mStats.buildTimeInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        mStats.buildCount++;
+        mStats.sahCost = 1;
+    }
+
+    void TwoLevelBvh::update()
+    {
+        if(mNeedsRebuild)
+        {
+            rebuild();
+            return;
+        }
+        if(mDirtyInstances.empty() || mNodes.empty())
+        {
+            return;
+        }
+
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        updateInstances();
+        const float cost = refit();
+        mStats.refitTimeInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        mStats.refitCount++;
+        mStats.sahCost = (mBuildSahCost > 0) ? cost / mBuildSahCost : 1;
+
+        // Refitting keeps the topology, which gets worse as the instances move apart
+        if(mStats.sahCost > mRebuildThreshold)
+        {
+            rebuild();
+        }
+    }
+
+    BoundingBox TwoLevelBvh::getBounds() const
+    {
+        assert(mNodes.size());
+        return BoundingBox::fromMinMax(mNodes[0].boundsMin, mNodes[0].boundsMax);
+    }
+
+    bool TwoLevelBvh::intersectInstance(uint32_t instanceId, const Ray& ray, Hit& hit, const HitFilter* pFilter) const
+    {
+        const Instance& instance = mInstances[instanceId];
+        if(instance.isVisible == false)
+        {
+            return false;
+        }
+
+        // The direction isn't normalized, so distances are the same in object and world space
+        Ray localRay = ray;
+        localRay.origin = glm::vec3(instance.invTransform * glm::vec4(ray.origin, 1.0f));
+        localRay.direction = glm::mat3(instance.invTransform) * ray.direction;
+
+        Hit localHit = hit;
+        localHit.instanceId = instanceId;
+        if(instance.pBottomLevel->intersect(localRay, localHit, pFilter))
+        {
+            hit = localHit;
+            return true;
+        }
+        return false;
+    }
+
+    bool TwoLevelBvh::occludedInstance(uint32_t instanceId, const Ray& ray, const HitFilter* pFilter) const
+    {
+        const Instance& instance = mInstances[instanceId];
+        if(instance.isVisible == false)
+        {
+            return false;
+        }
+
+        Ray localRay = ray;
+        localRay.origin = glm::vec3(instance.invTransform * glm::vec4(ray.origin, 1.0f));
+        localRay.direction = glm::mat3(instance.invTransform) * ray.direction;
+        if(pFilter == nullptr)
+        {
+            return instance.pBottomLevel->occluded(localRay);
+        }
+
+        // The filter needs to know the instance
+        HitFilter filter = [&](const Ray& r, const Hit& h)
+        {
+            Hit instanceHit = h;
+            instanceHit.instanceId = instanceId;
+            return (*pFilter)(r, instanceHit);
+        };
+        return instance.pBottomLevel->occluded(localRay, &filter);
+    }
+
+    bool TwoLevelBvh::intersect(const Ray& ray, Hit& hit, const HitFilter* pFilter) const
+    {
+        assert(mNeedsRebuild == false && mDirtyInstances.empty());
+        if(mNodes.empty())
+        {
+            return false;
+        }
+
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        Hit closest = hit;
+        closest.t = std::min(hit.t, ray.tMax);
+        bool found = false;
+
+        float tEnter;
+        if(mNodes[0].intersect(ray.origin, invDir, ray.tMin, closest.t, tEnter) == false)
+        {
+            return false;
+        }
+
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            if(node.count > 0)
+            {
+                for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+                {
+                    found = intersectInstance(mLeafInstances[i], ray, closest, pFilter) || found;
+                }
+                continue;
+            }
+
+            // Visit the nearer child first
+            const BvhNode& left = mNodes[node.leftOrFirst];
+            const BvhNode& right = mNodes[node.leftOrFirst + 1];
+            float tLeft, tRight;
+            bool hitLeft = left.intersect(ray.origin, invDir, ray.tMin, closest.t, tLeft);
+            bool hitRight = right.intersect(ray.origin, invDir, ray.tMin, closest.t, tRight);
+            if(hitLeft && hitRight)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[stackSize++] = leftFirst ? node.leftOrFirst + 1 : node.leftOrFirst;
+                stack[stackSize++] = leftFirst ? node.leftOrFirst : node.leftOrFirst + 1;
+            }
+            else if(hitLeft)
+            {
+                stack[stackSize++] = node.leftOrFirst;
+            }
+            else if(hitRight)
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+            }
+            assert(stackSize < kMaxStackDepth);
+        }
+        if(found)
+        {
+            hit = closest;
+        }
+        return found;
+    }
+
+    bool TwoLevelBvh::occluded(const Ray& ray, const HitFilter* pFilter) const
+    {
+        assert(mNeedsRebuild == false && mDirtyInstances.empty());
+        if(mNodes.empty())
+        {
+            return false;
+        }
+
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            float tEnter;
+            if(node.intersect(ray.origin, invDir, ray.tMin, ray.tMax, tEnter) == false)
+            {
+                continue;
+            }
+
+            if(node.count > 0)
+            {
+                for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+                {
+                    if(occludedInstance(mLeafInstances[i], ray, pFilter))
+                    {
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+                assert(stackSize < kMaxStackDepth);
+            }
+        }
+        return false;
+    }
+
+    uint32_t TwoLevelBvh::pick(const Ray& ray) const
+    {
+        Hit hit;
+        return intersect(ray, hit) ? hit.instanceId : kInvalidInstance;
+    }
+
+    void TwoLevelBvh::cull(const Camera* pCamera, std::vector<uint32_t>& instanceIds) const
+    {
+        assert(mNeedsRebuild == false && mDirtyInstances.empty());
+        instanceIds.clear();
+        if(mNodes.empty())
+        {
+            return;
+        }
+
+        uint32_t stack[kMaxStackDepth];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while(stackSize > 0)
+        {
+            const BvhNode& node = mNodes[stack[--stackSize]];
+            if(pCamera->isObjectCulled(BoundingBox::fromMinMax(node.boundsMin, node.boundsMax)))
+            {
+                continue;
+            }
+
+            if(node.count > 0)
+            {
+                for(uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+                {
+                    const uint32_t instanceId = mLeafInstances[i];
+                    if(mInstances[instanceId].isVisible && (node.count == 1 || pCamera->isObjectCulled(getInstanceBounds(instanceId)) == false))
+                    {
+                        instanceIds.push_back(instanceId);
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+                assert(stackSize < kMaxStackDepth);
+            }
+        }
+    }
+}
+}
\ No newline at end of file
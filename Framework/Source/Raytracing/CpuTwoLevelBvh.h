@@ -0,0 +1,187 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <map>
+#include "glm/mat4x4.hpp"
+#include "Raytracing/CpuBvh.h"
+#include "Graphics/Scene/Scene.h"
+
+namespace Falcor
+{
+namespace RT
+{
+    /** Two-level BVH for scenes with moving objects.
+        Each mesh has an object-space Bvh which is built once. The top level is a BVH over the world-space bounds of the instances.
+        When transforms change it is refit, and rebuilt once refitting degraded it too much. Both run in parallel.
+        Hits report the instance in Hit::instanceId and the triangle of the instance's mesh in Hit::primitiveId.
+    */
+    class TwoLevelBvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TwoLevelBvh>;
+        using SharedConstPtr = std::shared_ptr<const TwoLevelBvh>;
+
+        static const uint32_t kInvalidInstance = uint32_t(-1);
+
+        /** Statistics of the top-level updates
+        */
+        struct Stats
+        {
+            float buildTimeInMs = 0;        ///< Duration of the last rebuild, including the instance bounds
+            float refitTimeInMs = 0;        ///< Duration of the last refit, including the instance bounds
+            uint32_t buildCount = 0;
+            uint32_t refitCount = 0;
+            float sahCost = 0;              ///< Current SAH cost of the top level, relative to the cost right after the last rebuild
+        };
+
+        /** Create an empty hierarchy
+        */
+        static SharedPtr create();
+
+        /** Create a hierarchy from a scene. Builds a bottom-level BVH for every mesh and adds an instance for every model instance and mesh instance.
+            Call updateFromScene() after moving the model instances. If models or model instances are added or removed, create a new object.
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene);
+
+        /** Add an instance
+            \param[in] pBottomLevel The object-space BVH of the instance
+            \param[in] transform Object-to-world transformation
+            \return The instance ID
+        */
+        uint32_t addInstance(const Bvh::SharedConstPtr& pBottomLevel, const glm::mat4& transform);
+
+        /** Set an instance's transformation. Takes effect on the next update().
+        */
+        void setTransform(uint32_t instanceId, const glm::mat4& transform);
+
+        /** Show or hide an instance. Hidden instances are ignored by the queries.
+        */
+        void setVisible(uint32_t instanceId, bool isVisible) { mInstances[instanceId].isVisible = isVisible; }
+
+        const glm::mat4& getTransform(uint32_t instanceId) const { return mInstances[instanceId].transform; }
+        const Bvh::SharedConstPtr& getBottomLevel(uint32_t instanceId) const { return mInstances[instanceId].pBottomLevel; }
+        bool isVisible(uint32_t instanceId) const { return mInstances[instanceId].isVisible; }
+        uint32_t getInstanceCount() const { return (uint32_t)mInstances.size(); }
+
+        /** For hierarchies created from a scene, get the mesh of an instance
+        */
+        const Mesh::SharedPtr& getMesh(uint32_t instanceId) const { return mSceneRefs[instanceId].pMesh; }
+
+        /** Read the model instance transformations and visibility from the scene the hierarchy was created from
+        */
+        void updateFromScene();
+
+        /** Bring the top level up to date. Rebuilds it if instances were added or the refit SAH cost exceeded the rebuild threshold, otherwise refits it if transforms changed.
+            Must be called before running queries.
+        */
+        void update();
+
+        /** Rebuild the top level from scratch
+        */
+        void rebuild();
+
+        /** Set the SAH cost increase, relative to a freshly built top level, at which update() rebuilds instead of refitting. The default is 1.5.
+        */
+        void setRebuildThreshold(float threshold) { mRebuildThreshold = threshold; }
+
+        /** Find the closest intersection
+            \param[in] ray The world-space ray
+            \param[in,out] hit The closest hit. Only hits closer than ray.tMax are reported.
+            \param[in] pFilter Optional. Called for each candidate hit with the object-space ray. The hit distance is the same in both spaces.
+            \return true if a hit was found
+        */
+        bool intersect(const Ray& ray, Hit& hit, const HitFilter* pFilter = nullptr) const;
+
+        /** Check if there is any intersection along the ray
+        */
+        bool occluded(const Ray& ray, const HitFilter* pFilter = nullptr) const;
+
+        /** Get the instance closest along a ray, or kInvalidInstance if nothing was hit
+        */
+        uint32_t pick(const Ray& ray) const;
+
+        /** Find the visible instances whose bounds overlap the camera frustum
+            \param[in] pCamera The camera
+            \param[out] instanceIds The instance IDs
+        */
+        void cull(const Camera* pCamera, std::vector<uint32_t>& instanceIds) const;
+
+        /** Get the world-space bounds of an instance
+        */
+        BoundingBox getInstanceBounds(uint32_t instanceId) const { return BoundingBox::fromMinMax(mInstanceMin[instanceId], mInstanceMax[instanceId]); }
+
+        /** Get the world-space bounds of all of the instances
+        */
+        BoundingBox getBounds() const;
+
+        const Stats& getStats() const { return mStats; }
+
+    private:
+        TwoLevelBvh() = default;
+
+        struct Instance
+        {
+            Bvh::SharedConstPtr pBottomLevel;
+            glm::mat4 transform;
+            glm::mat4 invTransform;
+            bool isVisible = true;
+            bool isDirty = true;
+        };
+
+        /** The scene objects an instance was created from
+        */
+        struct SceneRef
+        {
+            uint32_t modelId;
+            uint32_t modelInstanceId;
+            glm::mat4 meshTransform;
+            Mesh::SharedPtr pMesh;
+        };
+
+        void updateInstances();
+        float refit();
+        bool intersectInstance(uint32_t instanceId, const Ray& ray, Hit& hit, const HitFilter* pFilter) const;
+        bool occludedInstance(uint32_t instanceId, const Ray& ray, const HitFilter* pFilter) const;
+
+        std::vector<Instance> mInstances;
+        std::vector<uint32_t> mDirtyInstances;
+        std::vector<glm::vec3> mInstanceMin;
+        std::vector<glm::vec3> mInstanceMax;
+
+        Scene::SharedPtr mpScene;
+        std::vector<SceneRef> mSceneRefs;
+
+        std::vector<BvhNode> mNodes;
+        std::vector<uint32_t> mLeafInstances;   ///< Instance IDs in leaf order
+        bool mNeedsRebuild = true;
+        float mBuildSahCost = 0;
+        float mRebuildThreshold = 1.5f;
+        Stats mStats;
+    };
+}
+}
\ No newline at end of file
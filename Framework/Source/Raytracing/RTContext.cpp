@@ -383,7 +383,8 @@ void RTContext::addGeometryToGroup(ObjectHandle groupToAddGeometry, const Model:
             Logger::log(Logger::Level::Error, "Vertex buffer of a submesh in model '" + model->getName() + "' had wrong stride or size");
             continue;
         }
-        if(ib->getSize() % (sizeof(uint32_t) * 3) != 0 || triCount != ib->getSize() / (sizeof(uint32_t) * 3))
+        const size_t indexSize = getFormatBytesPerBlock(vao->getIndexBufferFormat());
+        if(ib->getSize() % (indexSize * 3) != 0 || triCount != ib->getSize() / (indexSize * 3))
         {
             Logger::log(Logger::Level::Error, "Index buffer of a submesh in model '" + model->getName() + "' had wrong stride or size");
             continue;
@@ -429,7 +430,13 @@ void RTContext::addGeometryToGroup(ObjectHandle groupToAddGeometry, const Model:
                 assert(vao->getVertexBufferLayout(uvIdx)->getElementFormat(0) == ResourceFormat::RGB32Float);  // Assuming at least float2 for texcoords
         }
 
-        // Share index buffer
+        // Share index buffer. OptiX expects 32-bit indices, so 16-bit index buffers are widened first
+        if(vao->getIndexBufferFormat() == ResourceFormat::R16Uint)
+        {
+            std::vector<uint32_t> indices = mesh->readIndices();
+            inst.pWideIndexBuffer = Buffer::create(indices.size() * sizeof(uint32_t), Buffer::BindFlags::Index, Buffer::AccessFlags::None, indices.data());
+            ib = inst.pWideIndexBuffer;
+        }
         inst.geo.indices = createSharedBuffer(ib->getApiHandle(), RT_FORMAT_INT3, triCount);
 
         // Share vertex buffers, or create if needed
@@ -453,8 +460,7 @@ void RTContext::addGeometryToGroup(ObjectHandle groupToAddGeometry, const Model:
                 inst.geo.bitangents = mpContext->createBuffer(RT_BUFFER_INPUT, RT_FORMAT_FLOAT3, vtxCount);
                 tg_data = (vec3*)inst.geo.tangents->map();
                 bt_data = (vec3*)inst.geo.bitangents->map();
-                nrmData.resize(vao->getVertexBuffer(VERTEX_NORMAL_LOC)->getSize() / sizeof(vec3));
-                vao->getVertexBuffer(VERTEX_NORMAL_LOC)->readData(nrmData.data(), 0, nrmData.size() * sizeof(vec3));
+                nrmData = mesh->readVertexAttribute(VERTEX_NORMAL_LOC);
             }
             if(hasUv)
                 inst.geo.texcoord = createSharedBuffer(vao->getVertexBuffer(uvIdx)->getApiHandle(), RT_FORMAT_FLOAT3, vtxCount);
@@ -734,6 +740,7 @@ void RTContext::setLights(const std::vector<Light::SharedPtr>& list)
 							assert(pAreaLight->getTexCoordBuffer()->getSize() % sizeof(glm::vec3) == 0);
 						}
 						cachedInst.meshCDFPtr.ptrLoHi[0] = createSharedBuffer(pAreaLight->getMeshCDFBuffer()->getApiHandle(), RT_FORMAT_FLOAT, pAreaLight->getMeshCDFBuffer()->getSize() / sizeof(float))->getId();
+						cachedInst.aliasTablePtr.ptrLoHi[0] = createSharedBuffer(pAreaLight->getAliasTableBuffer()->getApiHandle(), RT_FORMAT_UNSIGNED_INT2, pAreaLight->getAliasTableBuffer()->getSize() / sizeof(AliasTable::Entry))->getId();
 					}
 				}
 				break;
@@ -752,6 +759,7 @@ void RTContext::setLights(const std::vector<Light::SharedPtr>& list)
             cLight.vertexPtr = oldLightPtrs.vertexPtr;
             cLight.texCoordPtr = oldLightPtrs.texCoordPtr;
             cLight.meshCDFPtr = oldLightPtrs.meshCDFPtr;
+            cLight.aliasTablePtr = oldLightPtrs.aliasTablePtr;
         }
 
         memcpy(lights, &(mCachedLights[elem]), sizeof(*lights));
@@ -250,6 +250,7 @@ namespace RT
             int32_t             modelId = -1;
             ModelGeometry       geo;
             MaterialData        material;
+            Buffer::SharedConstPtr pWideIndexBuffer;    ///< 32-bit copy of a 16-bit mesh index buffer, kept alive while shared with OptiX
         };
         std::list<ModelInstance>  mInstances;
         bool                      mSceneDirty = true;
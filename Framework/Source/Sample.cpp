@@ -153,24 +153,28 @@ namespace Falcor
         {
             endVideoCapture();
         }
+        endImageSequenceCapture();
         VRSystem::cleanup();
     }
 
-    void Sample::run(const SampleConfig& config)
+    int Sample::run(const SampleConfig& config)
     {
         mTimeScale = config.timeScale;
         mFreezeTime = config.freezeTimeOnStartup;
+        const bool isBenchmark = (config.benchmark.runs.empty() == false);
 
-        // Start the logger
+        // Start the logger. Benchmarks run unattended, so errors shouldn't block them.
         Logger::init();
-        Logger::showBoxOnError(config.showMessageBoxOnError);
+        Logger::showBoxOnError(config.showMessageBoxOnError && (isBenchmark == false));
 
-        mpWindow = Window::create(config.windowDesc, this);
+        Window::Desc windowDesc = config.windowDesc;
+        windowDesc.isHidden = windowDesc.isHidden || (isBenchmark && config.benchmark.headless);
+        mpWindow = Window::create(windowDesc, this);
 
         if(mpWindow == nullptr)
         {
             Logger::log(Logger::Level::Error, "Failed to create device and window");
-            return;
+            return 1;
         }
 
         // Set the icon
@@ -198,16 +202,27 @@ namespace Falcor
         // Call the load callback
         onLoad();
         handleFrameBufferSizeChange(mpWindow->getDefaultFBO());
+
+        if(isBenchmark)
+        {
+            startBenchmark(config.benchmark);
+        }
         
         mpWindow->msgLoop();
 
         onShutdown();
         Logger::shutdown();
+        return mExitCode;
     }
 
     void Sample::calculateTime()
     {
-        if(mVideoCapture.pVideoCapture)
+        if(mpBenchmark)
+        {
+            // Fixed time step, independent of the frame rate
+            mCurrentTime = mpBenchmark->getCurrentTime();
+        }
+        else if(mVideoCapture.pVideoCapture)
         {
             // We are capturing video at a constant FPS
             mCurrentTime += mVideoCapture.timeDelta * mTimeScale;
@@ -222,6 +237,8 @@ namespace Falcor
     void Sample::renderFrame()
     {
         mFrameRate.newFrame();
+        CpuTimer::TimePoint frameStart = CpuTimer::getCurrentTimePoint();
+        mpRenderContext->resetStats();
         {
             PROFILE(onFrameRender);
             calculateTime();
@@ -241,12 +258,28 @@ namespace Falcor
                 mpGui->drawAll();
             }
         }
+
+        bool isCapturing = mCaptureScreen || mVideoCapture.pVideoCapture || mImageSequence.pWriter;
         captureVideoFrame();
+        captureImageSequenceFrame();
         if(mCaptureScreen)
         {
             captureScreen();
         }
-        printProfileData();
+        if(isCapturing)
+        {
+            // The captures read back the screen with raw API calls, which bypass the render-context
+            mpRenderContext->invalidateApiState();
+        }
+
+        if(mpBenchmark)
+        {
+            endBenchmarkFrame(CpuTimer::calcDuration(frameStart, CpuTimer::getCurrentTimePoint()));
+        }
+        else
+        {
+            printProfileData();
+        }
     }
 
     void Sample::captureScreen()
@@ -410,10 +443,14 @@ namespace Falcor
         desc.bitrateMbps = mVideoCapture.pUI->getBitrate();
         desc.gopSize    = mVideoCapture.pUI->getGopSize();
 
-        mVideoCapture.pVideoCapture = VideoEncoder::create(desc);
+        // Readback and encoding are pipelined, so the render thread only issues the copy. See captureVideoFrame().
+        mVideoCapture.pScreenCapture = AsyncScreenCapture::create(desc.width, desc.height, ResourceFormat::RGBA8Unorm);
+        AsyncVideoEncoder::Desc queueDesc;
+        queueDesc.frameSize = mVideoCapture.pScreenCapture->getFrameSize();
+        queueDesc.policy = mVideoCapture.pUI->dropFrames() ? AsyncVideoEncoder::OverflowPolicy::Drop : AsyncVideoEncoder::OverflowPolicy::Block;
+        mVideoCapture.pVideoCapture = AsyncVideoEncoder::create(VideoEncoder::create(desc), queueDesc);
 
         assert(mVideoCapture.pVideoCapture);
-        mVideoCapture.pFrame = new uint8_t[desc.width*desc.height * 4];
 
         mVideoCapture.timeDelta = 1 / (float)desc.fps;
 
@@ -433,20 +470,62 @@ namespace Falcor
     {
         if(mVideoCapture.pVideoCapture)
         {
+            encodeCapturedFrames(true);
             mVideoCapture.pVideoCapture->endCapture();
             mShowUI = true;
+
+            AsyncVideoEncoder::Stats stats = mVideoCapture.pVideoCapture->getStats();
+            Logger::log(Logger::Level::Info, "Video capture finished. " + std::to_string(stats.encodedFrames) + " frames encoded, " + std::to_string(stats.droppedFrames) + " frames dropped, max queue depth " + std::to_string(stats.maxQueueDepth) + ".");
         }
         mVideoCapture.pUI = nullptr;
         mVideoCapture.pVideoCapture = nullptr;
-        safe_delete_array(mVideoCapture.pFrame);
+        mVideoCapture.pScreenCapture = nullptr;
+    }
+
+    void Sample::encodeCapturedFrames(bool waitForAll)
+    {
+        AsyncScreenCapture* pScreenCapture = mVideoCapture.pScreenCapture.get();
+        while(pScreenCapture->getPendingCount() > 0)
+        {
+            if(waitForAll == false && pScreenCapture->isFrameReady() == false)
+            {
+                break;
+            }
+
+            encodeOldestCapturedFrame();
+        }
+    }
+
+    void Sample::encodeOldestCapturedFrame()
+    {
+        // The readback goes straight into the encoder's queue. If the encoder dropped the frame, we still need to release the staging buffer.
+        uint8_t* pFrame = mVideoCapture.pVideoCapture->acquireFrame();
+        bool success = mVideoCapture.pScreenCapture->readFrame(pFrame);
+        if(pFrame)
+        {
+            if(success)
+            {
+                mVideoCapture.pVideoCapture->submitFrame(pFrame);
+            }
+            else
+            {
+                mVideoCapture.pVideoCapture->dropFrame(pFrame);
+            }
+        }
     }
 
     void Sample::captureVideoFrame()
     {
         if(mVideoCapture.pVideoCapture)
         {
-            ScreenCapture::captureToMemory(mpDefaultFBO->getWidth(), mpDefaultFBO->getHeight(), ResourceFormat::RGBA8Unorm, mVideoCapture.pFrame);
-            mVideoCapture.pVideoCapture->appendFrame(mVideoCapture.pFrame);
+            AsyncScreenCapture* pScreenCapture = mVideoCapture.pScreenCapture.get();
+            if(pScreenCapture->getPendingCount() == pScreenCapture->getRingSize())
+            {
+                // All the staging buffers are in flight. Wait for the oldest one.
+                encodeOldestCapturedFrame();
+            }
+            pScreenCapture->capture();
+            encodeCapturedFrames(false);
 
             if(mVideoCapture.pUI->useTimeRange())
             {
@@ -465,6 +544,136 @@ namespace Falcor
         }
     }
 
+    void Sample::startImageSequenceCapture(const ImageSequenceWriter::Desc& desc)
+    {
+        endImageSequenceCapture();
+
+        ImageSequenceWriter::Desc writerDesc = desc;
+        bool isHdr = (desc.format == ImageSequenceWriter::FileFormat::Pfm) || (desc.format == ImageSequenceWriter::FileFormat::Exr);
+        ResourceFormat format = isHdr ? ResourceFormat::RGBA32Float : ResourceFormat::BGRA8Unorm;
+        writerDesc.width = mpDefaultFBO->getWidth();
+        writerDesc.height = mpDefaultFBO->getHeight();
+        writerDesc.bytesPerPixel = getFormatBytesPerBlock(format);
+        writerDesc.isTopDown = false;
+
+        mImageSequence.pWriter = ImageSequenceWriter::create(writerDesc);
+        if(mImageSequence.pWriter)
+        {
+            mImageSequence.pScreenCapture = AsyncScreenCapture::create(writerDesc.width, writerDesc.height, format);
+        }
+    }
+
+    void Sample::endImageSequenceCapture()
+    {
+        if(mImageSequence.pWriter == nullptr)
+        {
+            return;
+        }
+
+        while(mImageSequence.pScreenCapture->getPendingCount() > 0)
+        {
+            writeOldestImageSequenceFrame();
+        }
+        mImageSequence.pWriter->flush();
+
+        ImageSequenceWriter::Stats stats = mImageSequence.pWriter->getStats();
+        Logger::log(Logger::Level::Info, "Image sequence capture finished. " + std::to_string(stats.writtenFrames) + " frames written, " + std::to_string(stats.failedFrames) + " failed.");
+        mImageSequence.pWriter = nullptr;
+        mImageSequence.pScreenCapture = nullptr;
+    }
+
+    void Sample::writeOldestImageSequenceFrame()
+    {
+        uint8_t* pFrame = mImageSequence.pWriter->acquireFrame();
+        if(mImageSequence.pScreenCapture->readFrame(pFrame))
+        {
+            mImageSequence.pWriter->submitFrame(pFrame);
+        }
+        else
+        {
+            mImageSequence.pWriter->dropFrame(pFrame);
+        }
+    }
+
+    void Sample::captureImageSequenceFrame()
+    {
+        if(mImageSequence.pWriter == nullptr)
+        {
+            return;
+        }
+
+        // Same pipelining as the video capture. Frames are read back a few frames late, and compressed on the writer's worker threads.
+        AsyncScreenCapture* pScreenCapture = mImageSequence.pScreenCapture.get();
+        if(pScreenCapture->getPendingCount() == pScreenCapture->getRingSize())
+        {
+            writeOldestImageSequenceFrame();
+        }
+        pScreenCapture->capture();
+        while(pScreenCapture->isFrameReady())
+        {
+            writeOldestImageSequenceFrame();
+        }
+    }
+
+    void Sample::startBenchmark(const Benchmark::Desc& desc)
+    {
+        mpBenchmark = Benchmark::create(desc);
+        if(mpBenchmark == nullptr)
+        {
+            mExitCode = 1;
+            shutdownApp();
+            return;
+        }
+
+        // The UI and the text aren't part of the measurement
+        toggleUI(false);
+        setTextMode(TextMode::NoText);
+        mpRenderContext->setApiSubmission(desc.headless == false);
+        gProfileEnabled = true;
+        startBenchmarkRun();
+    }
+
+    void Sample::startBenchmarkRun()
+    {
+        while(mpBenchmark->isComplete() == false)
+        {
+            const Benchmark::Run& run = mpBenchmark->getCurrentRun();
+            Logger::log(Logger::Level::Info, "Benchmark run " + std::to_string(mpBenchmark->getCurrentRunIndex()) + ": " + run.sceneFilename + (run.pathName.empty() ? "" : ", path " + run.pathName));
+            if(onBenchmarkRun(run))
+            {
+                mpBenchmark->beginRun();
+                return;
+            }
+            mpBenchmark->failRun();
+        }
+        endBenchmark();
+    }
+
+    void Sample::endBenchmarkFrame(float cpuTime)
+    {
+        std::vector<Profiler::EventTimes> events;
+        if(gProfileEnabled)
+        {
+            Profiler::endFrame(events);
+        }
+
+        if(mpBenchmark->endFrame(cpuTime, events, mpRenderContext->getStats()))
+        {
+            startBenchmarkRun();
+        }
+    }
+
+    void Sample::endBenchmark()
+    {
+        bool passed = mpBenchmark->writeReport() && mpBenchmark->hasPassed();
+        Logger::log(passed ? Logger::Level::Info : Logger::Level::Error, std::string("Benchmark ") + (passed ? "passed" : "failed"));
+        mExitCode = passed ? 0 : 1;
+
+        mpBenchmark = nullptr;
+        mpRenderContext->setApiSubmission(true);
+        shutdownApp();
+    }
+
     void Sample::shutdownApp()
     {
         mpWindow->shutdown();
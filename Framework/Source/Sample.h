@@ -36,6 +36,10 @@
 #include "utils/TextRenderer.h"
 #include "core/RenderContext.h"
 #include "Utils/Video/VideoEncoderUI.h"
+#include "Utils/Video/AsyncVideoEncoder.h"
+#include "Core/AsyncScreenCapture.h"
+#include "Utils/ImageSequenceWriter.h"
+#include "Utils/Benchmark.h"
 
 namespace Falcor
 {
@@ -55,6 +59,7 @@ namespace Falcor
         float timeScale = 1;                ///< A scaling factor for the time elapsed between frames.
         bool freezeTimeOnStartup = false;   ///< Control whether or not to start the clock when the sample start running.
         bool enableVR            = false;   ///< If you need VR support, set it to true to let Sample control the VR calls. Alternatively, if you want better control, you can call the VRSystem yourself
+        Benchmark::Desc benchmark;          ///< If it has runs, the sample runs the benchmark and exits when it ends. See Sample#onBenchmarkRun().
     };
 
     /** Bootstrapper class for Falcor.
@@ -72,8 +77,9 @@ namespace Falcor
         /** Entry-point to CSample().
             User should call this to start processing.
             \param Config Requested sample configuration
+            \return The process exit code. Non-zero if the window couldn't be created or the benchmark failed.
         */
-        virtual void run(const SampleConfig& config) final;
+        virtual int run(const SampleConfig& config) final;
 
     protected:
         // Callbacks
@@ -102,6 +108,11 @@ namespace Falcor
         \return true if the event was consumed by the callback, otherwise false
         */
         virtual bool onMouseEvent(const MouseEvent& mouseEvent) { return false; }
+        /** Called when a benchmark run starts. The sample should load the run's scene and activate its camera path (see Benchmark#setActivePath()).
+        \param run The run
+        \return false if the run couldn't be set up. The run is then reported as failed.
+        */
+        virtual bool onBenchmarkRun(const Benchmark::Run& run) { return false; }
         
         /** Resize the swap-chain buffers
             \param width Requested width
@@ -143,6 +154,20 @@ namespace Falcor
         void setWindowTitle(std::string title);
         
         void toggleUI(bool showUI);
+
+        /** Start writing every rendered frame to an image sequence. Meant for offline rendering.
+            \param desc The writer description. The frame size and pixel layout are set by the sample - 8-bit BGRA for PNG and raw files, 32-bit float RGBA for HDR formats.
+        */
+        void startImageSequenceCapture(const ImageSequenceWriter::Desc& desc);
+
+        /** Write the remaining frames and stop the image sequence capture
+        */
+        void endImageSequenceCapture();
+
+        /** Check if the sample is running a benchmark
+        */
+        bool isBenchmarkRunning() const { return mpBenchmark != nullptr; }
+
         Gui::UniquePtr mpGui;                             ///< Main sample GUI
         RenderContext::SharedPtr mpRenderContext;         ///< The rendering context
         Fbo::SharedPtr mpDefaultFBO;                      ///< The default FBO object
@@ -177,6 +202,14 @@ namespace Falcor
         void startVideoCapture();
         void endVideoCapture();
         void captureVideoFrame();
+        void encodeCapturedFrames(bool waitForAll);
+        void encodeOldestCapturedFrame();
+        void captureImageSequenceFrame();
+        void writeOldestImageSequenceFrame();
+        void startBenchmark(const Benchmark::Desc& desc);
+        void startBenchmarkRun();
+        void endBenchmarkFrame(float cpuTime);
+        void endBenchmark();
 
         Window::UniquePtr mpWindow;
         bool mVsyncOn = false;
@@ -188,13 +221,24 @@ namespace Falcor
         struct VideoCaptureData
         {
             VideoEncoderUI::UniquePtr pUI;
-            VideoEncoder::UniquePtr pVideoCapture;
-            uint8_t* pFrame = nullptr;
+            AsyncVideoEncoder::UniquePtr pVideoCapture;
+            AsyncScreenCapture::UniquePtr pScreenCapture;
             float timeDelta;
         };
 
         VideoCaptureData mVideoCapture;
 
+        struct ImageSequenceCaptureData
+        {
+            ImageSequenceWriter::UniquePtr pWriter;
+            AsyncScreenCapture::UniquePtr pScreenCapture;
+        };
+
+        ImageSequenceCaptureData mImageSequence;
+
+        Benchmark::UniquePtr mpBenchmark;
+        int mExitCode = 0;
+
         FrameRate mFrameRate;
         float mTimeScale;
         TextMode mTextMode = TextMode::All;
@@ -28,7 +28,9 @@
 
 #ifndef _FALCOR_SHADING_HELPERS_H_
 #define _FALCOR_SHADING_HELPERS_H_
+#ifndef HOST_CODE
 #include "HlslGlslCommon.h"
+#endif
 
 /**
 	Helper macro to iterate through layers
@@ -278,7 +280,13 @@ void _fn perturbNormal(in const MaterialData mat, _ref(ShadingAttribs) shAttr, b
 	if(forceSample || mat.desc.hasNormalMap != 0)
 	{
 		vec3 texValue = v3(sampleTexture(mat.values.normalMap.texture.ptr, shAttr));
-        applyNormalMap(RGBToNormal(texValue), shAttr.N, shAttr.T, shAttr.B);
+		vec3 normal = RGBToNormal(texValue);
+		// Two-channel (BC5) normal maps don't store Z
+		if(mat.desc.hasNormalMap == NormalMapRG)
+		{
+			normal.z = sqrt(max(0.f, 1.f - normal.x * normal.x - normal.y * normal.y));
+		}
+		applyNormalMap(normal, shAttr.N, shAttr.T, shAttr.B);
 	}
 }
 #endif
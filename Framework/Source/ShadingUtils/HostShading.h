@@ -0,0 +1,124 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "glm/glm.hpp"
+#include "Core/Texture.h"
+#include "Data/HostDeviceData.h"
+
+/** Host build of the shared shading headers (Shading.h, BSDFs.h, Lights.h and Helpers.h).
+    The headers are written for GLSL/HLSL/CUDA. This file supplies the few shader-language constructs they use and compiles them as C++,
+    so the same material and BSDF code the shaders run can be called on the CPU - for reference renders, validating shader math and offline baking.
+    The functions live in Falcor::HostShading. They are not inline, so they are wrapped in an unnamed namespace and every translation unit gets its own copy.
+    Limitations:
+    - Bindless texture handles can't be sampled on the CPU. Textures and alpha test are disabled, materials use their constant colors.
+    - perturbNormal() does nothing. Apply normal maps before calling prepareShadingAttribs().
+    For batched evaluation of many samples see CpuMaterialEvaluator.
+*/
+
+#ifndef _MS_DISABLE_TEXTURES
+#define _MS_DISABLE_TEXTURES
+#define HOST_SHADING_DEFINED_DISABLE_TEXTURES
+#endif
+#ifndef _MS_DISABLE_ALPHA_TEST
+#define _MS_DISABLE_ALPHA_TEST
+#define HOST_SHADING_DEFINED_DISABLE_ALPHA_TEST
+#endif
+#ifndef _MS_USER_NORMAL_MAPPING
+#define _MS_USER_NORMAL_MAPPING
+#define HOST_SHADING_DEFINED_USER_NORMAL_MAPPING
+#endif
+
+#define in
+#define _ref(__x) __x&
+
+namespace Falcor
+{
+    namespace HostShading
+    {
+        namespace
+        {
+            // GLSL types and built-ins used by the shading headers
+            typedef uint32_t uint;
+            using glm::uvec2;
+            using glm::ivec3;
+            using glm::abs;
+            using glm::min;
+            using glm::max;
+            using glm::mix;
+            using glm::sqrt;
+            using glm::exp;
+            using glm::log;
+            using glm::pow;
+            using glm::sin;
+            using glm::cos;
+            using glm::acos;
+            using glm::atan;
+            using glm::length;
+            using glm::normalize;
+            using glm::cross;
+            using glm::uintBitsToFloat;
+
+            inline vec4 mul(const mat4& m, const vec4& v)
+            {
+                return m * v;
+            }
+
+            // Texture handles can't be sampled on the host. Texture fetches are disabled above, this only needs to compile.
+            typedef uint64_t sampler2D;
+            typedef uint64_t sampler2DArray;
+
+            template<typename CoordType>
+            inline vec4 textureBias(uint64_t, const CoordType&, float)
+            {
+                return vec4(1.f);
+            }
+
+#include "ShadingUtils/Shading.h"
+
+            void perturbNormal(const MaterialData mat, ShadingAttribs& shAttr, bool forceSample)
+            {
+            }
+        }
+    }
+}
+
+#undef in
+#undef _ref
+
+#ifdef HOST_SHADING_DEFINED_DISABLE_TEXTURES
+#undef _MS_DISABLE_TEXTURES
+#undef HOST_SHADING_DEFINED_DISABLE_TEXTURES
+#endif
+#ifdef HOST_SHADING_DEFINED_DISABLE_ALPHA_TEST
+#undef _MS_DISABLE_ALPHA_TEST
+#undef HOST_SHADING_DEFINED_DISABLE_ALPHA_TEST
+#endif
+#ifdef HOST_SHADING_DEFINED_USER_NORMAL_MAPPING
+#undef _MS_USER_NORMAL_MAPPING
+#undef HOST_SHADING_DEFINED_USER_NORMAL_MAPPING
+#endif
\ No newline at end of file
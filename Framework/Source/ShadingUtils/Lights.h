@@ -156,12 +156,18 @@ void _fn sampleLight(in const vec3 shadingHitPos, in const LightData lData, cons
 		{
 			if (lData.numIndices != 0)
 			{
-				// Randomly pick a triangle on the mesh
-				// TODO: Pick a triangle mesh based on probability distributions
-				int index = min((int)(rSample.z * lData.numIndices), (int)(lData.numIndices - 1));
+				// Pick a triangle proportionally to its area using the alias table
+				float scaledSample = rSample.z * lData.numIndices;
+				int index = min((int)(scaledSample), (int)(lData.numIndices - 1));
+				float remainder = scaledSample - float(index);
 
 				// Access the geometry buffers
 #ifdef CUDA_CODE
+				optix::bufferId<uint2, 1> aliasTable(lData.aliasTablePtr.ptr);
+				const uint2 aliasEntry = aliasTable[index];
+				if (remainder >= __uint_as_float(aliasEntry.x))
+					index = (int)aliasEntry.y;
+
 				optix::bufferId<int3, 1> indices(lData.indexPtr.ptr);
 				optix::bufferId<vec3, 1> vertices(lData.vertexPtr.ptr);
 				// Retrieve indices
@@ -171,6 +177,10 @@ void _fn sampleLight(in const vec3 shadingHitPos, in const LightData lData, cons
 				vec3 p1 = vertices[pId.y];
 				vec3 p2 = vertices[pId.z];
 #else
+				uint* aliasTable = (uint*)(lData.aliasTablePtr.ptr);
+				if (remainder >= uintBitsToFloat(aliasTable[index * 2 + 0]))
+					index = (int)aliasTable[index * 2 + 1];
+
 				int* indices = (int*)(lData.indexPtr.ptr);
 				float* vertices = (float*)(lData.vertexPtr.ptr);
 				// Retrieve indices
@@ -213,4 +223,32 @@ void _fn sampleLight(in const vec3 shadingHitPos, in const LightData lData, cons
 		break;
 	}
 }
+#ifndef CUDA_CODE
+/**
+    This routine finds the light cluster containing a shading point, and returns its {offset, count} pair. See LightClusters.
+    \param ndcXY The NDC position of the shading point
+    \param viewDepth The view-space depth of the shading point (positive, along the view direction)
+*/
+uvec2 _fn getLightCluster(in const LightClusterData cData, in const vec2 ndcXY, in const float viewDepth)
+{
+	uint x = min(uint(max(ndcXY.x * 0.5f + 0.5f, 0.f) * cData.tileCountX), cData.tileCountX - 1);
+	uint y = min(uint(max(ndcXY.y * 0.5f + 0.5f, 0.f) * cData.tileCountY), cData.tileCountY - 1);
+	uint slice = uint(clamp(log(viewDepth / cData.nearZ) * cData.logDepthScale, 0.f, float(cData.sliceCount - 1)));
+	uint cluster = (slice * cData.tileCountY + y) * cData.tileCountX + x;
+
+	uint* clusters = (uint*)(cData.clusterPtr.ptr);
+	return uvec2(clusters[cluster * 2 + 0], clusters[cluster * 2 + 1]);
+}
+
+/**
+    This routine fetches the i-th light of a cluster returned by getLightCluster()
+*/
+LightData _fn getClusterLight(in const LightClusterData cData, in const uvec2 cluster, in const uint i)
+{
+	uint* lightIndices = (uint*)(cData.lightIndexPtr.ptr);
+	LightData* lights = (LightData*)(cData.lightDataPtr.ptr);
+	return lights[lightIndices[cluster.x + i]];
+}
+#endif
+
 #endif	// _FALCOR_LIGHTS_H_
@@ -0,0 +1,540 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Benchmark.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include "Graphics/Scene/Scene.h"
+#include "Utils/OS.h"
+#include "Utils/StringUtils.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+#include "Externals/RapidJson/include/rapidjson/error/en.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+
+namespace Falcor
+{
+    namespace BenchmarkKeys
+    {
+        static const char* kRuns = "runs";
+        static const char* kScene = "scene";
+        static const char* kPath = "path";
+        static const char* kTimeStep = "time_step";
+        static const char* kWarmupFrames = "warmup_frames";
+        static const char* kFrameCount = "frame_count";
+        static const char* kReport = "report";
+        static const char* kMaxAverageFrameTime = "max_average_frame_time";
+        static const char* kHeadless = "headless";
+    }
+
+    // RFC 4180 field: quoted, with embedded quotes doubled, so names containing commas or quotes keep the columns aligned
+    static std::string quoteCsvField(const std::string& field)
+    {
+        return '"' + replaceSubstring(field, "\"", "\"\"") + '"';
+    }
+
+    bool Benchmark::readDesc(const std::string& filename, Desc& desc)
+    {
+        std::string fullpath;
+        if(findFileInDataDirectories(filename, fullpath) == false)
+        {
+            Logger::log(Logger::Level::Error, "Can't find benchmark file " + filename);
+            return false;
+        }
+
+        std::ifstream file(fullpath);
+        std::stringstream strStream;
+        strStream << file.rdbuf();
+        std::string content = strStream.str();
+
+        rapidjson::Document jdoc;
+        if(jdoc.Parse(content.c_str()).HasParseError())
+        {
+            size_t line = std::count(content.begin(), content.begin() + jdoc.GetErrorOffset(), '\n') + 1;
+            Logger::log(Logger::Level::Error, "Error when parsing benchmark file " + filename + " at line " + std::to_string(line) + ": " + rapidjson::GetParseError_En(jdoc.GetParseError()));
+            return false;
+        }
+        if(jdoc.IsObject() == false)
+        {
+            Logger::log(Logger::Level::Error, "Benchmark file " + filename + " should contain a JSON object");
+            return false;
+        }
+
+        for(auto it = jdoc.MemberBegin(); it != jdoc.MemberEnd(); it++)
+        {
+            const std::string key = it->name.GetString();
+            const rapidjson::Value& value = it->value;
+            bool valid = true;
+
+            if(key == BenchmarkKeys::kRuns && value.IsArray())
+            {
+                desc.runs.clear();
+                for(uint32_t i = 0; i < value.Size(); i++)
+                {
+                    const rapidjson::Value& jrun = value[i];
+                    if(jrun.IsObject() == false || jrun.HasMember(BenchmarkKeys::kScene) == false || jrun[BenchmarkKeys::kScene].IsString() == false)
+                    {
+                        Logger::log(Logger::Level::Error, "Benchmark file " + filename + ": each run must be an object with a 'scene' string");
+                        return false;
+                    }
+
+                    Run run;
+                    run.sceneFilename = jrun[BenchmarkKeys::kScene].GetString();
+                    if(jrun.HasMember(BenchmarkKeys::kPath) && jrun[BenchmarkKeys::kPath].IsString())
+                    {
+                        run.pathName = jrun[BenchmarkKeys::kPath].GetString();
+                    }
+                    desc.runs.push_back(run);
+                }
+            }
+            else if(key == BenchmarkKeys::kTimeStep && value.IsNumber())
+            {
+                desc.timeStep = value.GetDouble();
+            }
+            else if(key == BenchmarkKeys::kWarmupFrames && value.IsUint())
+            {
+                desc.warmupFrames = value.GetUint();
+            }
+            else if(key == BenchmarkKeys::kFrameCount && value.IsUint())
+            {
+                desc.frameCount = value.GetUint();
+            }
+            else if(key == BenchmarkKeys::kReport && value.IsString())
+            {
+                desc.reportFilename = value.GetString();
+            }
+            else if(key == BenchmarkKeys::kMaxAverageFrameTime && value.IsNumber())
+            {
+                desc.maxAverageFrameTime = (float)value.GetDouble();
+            }
+            else if(key == BenchmarkKeys::kHeadless && value.IsBool())
+            {
+                desc.headless = value.GetBool();
+            }
+            else
+            {
+                valid = false;
+            }
+
+            if(valid == false)
+            {
+                Logger::log(Logger::Level::Error, "Benchmark file " + filename + ": invalid or unknown key '" + key + "'");
+                return false;
+            }
+        }
+
+        if(desc.timeStep <= 0 || desc.frameCount == 0)
+        {
+            Logger::log(Logger::Level::Error, "Benchmark file " + filename + ": the time step and the frame count must be positive");
+            return false;
+        }
+        return true;
+    }
+
+    Benchmark::UniquePtr Benchmark::create(const Desc& desc)
+    {
+        if(desc.runs.empty())
+        {
+            Logger::log(Logger::Level::Error, "Can't create a benchmark without runs");
+            return nullptr;
+        }
+        return UniquePtr(new Benchmark(desc));
+    }
+
+    Benchmark::Benchmark(const Desc& desc) : mDesc(desc)
+    {
+        mResults.resize(desc.runs.size());
+        for(size_t i = 0; i < desc.runs.size(); i++)
+        {
+            mResults[i].run = desc.runs[i];
+            mResults[i].frames.reserve(desc.frameCount);
+        }
+    }
+
+    bool Benchmark::setActivePath(Scene* pScene, const std::string& pathName)
+    {
+        if(pathName.empty())
+        {
+            return true;
+        }
+
+        for(uint32_t pathID = 0; pathID < pScene->getPathCount(); pathID++)
+        {
+            if(pScene->getPath(pathID)->getName() == pathName)
+            {
+                pScene->setActivePath(pathID);
+                return true;
+            }
+        }
+        Logger::log(Logger::Level::Error, "Benchmark: the scene has no path named '" + pathName + "'");
+        return false;
+    }
+
+    void Benchmark::animateModels(Scene* pScene, double currentTime)
+    {
+        for(uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            pScene->getModel(modelID)->animate(currentTime);
+        }
+    }
+
+    void Benchmark::beginRun()
+    {
+        assert(isComplete() == false);
+        mResults[mRunIndex].loaded = true;
+        mFrameIndex = 0;
+        mLastFrameEnd = CpuTimer::getCurrentTimePoint();
+    }
+
+    void Benchmark::failRun()
+    {
+        assert(isComplete() == false);
+        Logger::log(Logger::Level::Error, "Benchmark run " + std::to_string(mRunIndex) + " (" + getCurrentRun().sceneFilename + ") failed to load");
+        mRunIndex++;
+    }
+
+    double Benchmark::getCurrentTime() const
+    {
+        if(mFrameIndex < mDesc.warmupFrames)
+        {
+            return 0;
+        }
+        // Multiply rather than accumulate, so the time doesn't drift
+        return (mFrameIndex - mDesc.warmupFrames) * mDesc.timeStep;
+    }
+
+    uint32_t Benchmark::getEventIndex(RunResult& result, const Profiler::EventTimes& event)
+    {
+        auto it = std::find(result.eventNames.begin(), result.eventNames.end(), event.name);
+        if(it != result.eventNames.end())
+        {
+            return (uint32_t)(it - result.eventNames.begin());
+        }
+        result.eventNames.push_back(event.name);
+        result.eventLevels.push_back(event.level);
+        return (uint32_t)result.eventNames.size() - 1;
+    }
+
+    bool Benchmark::endFrame(float cpuTime, const std::vector<Profiler::EventTimes>& events, const RenderContext::Stats& stats)
+    {
+        assert(isComplete() == false);
+        CpuTimer::TimePoint now = CpuTimer::getCurrentTimePoint();
+        float frameTime = CpuTimer::calcDuration(mLastFrameEnd, now);
+        mLastFrameEnd = now;
+
+        RunResult& result = mResults[mRunIndex];
+        if(mFrameIndex >= mDesc.warmupFrames)
+        {
+            uint32_t measuredIndex = mFrameIndex - mDesc.warmupFrames;
+
+            // The profiler's GPU timers are double-buffered, so these GPU times belong to the previous frame
+            if(measuredIndex > 0)
+            {
+                Frame& previousFrame = result.frames[measuredIndex - 1];
+                for(const auto& event : events)
+                {
+                    uint32_t eventIndex = getEventIndex(result, event);
+                    if(eventIndex >= previousFrame.eventGpuTimes.size())
+                    {
+                        previousFrame.eventGpuTimes.resize(eventIndex + 1, 0.0f);
+                    }
+                    previousFrame.eventGpuTimes[eventIndex] = event.gpuMs;
+                }
+            }
+
+            // The run renders an extra frame to get the GPU times of the last measured frame. That frame isn't recorded.
+            if(measuredIndex < mDesc.frameCount)
+            {
+                Frame frame;
+                frame.time = getCurrentTime();
+                frame.frameTime = frameTime;
+                frame.cpuTime = cpuTime;
+                frame.drawCount = stats.drawCount;
+                frame.appliedStateChanges = stats.getTotalAppliedChanges();
+                frame.filteredStateChanges = stats.getTotalFilteredChanges();
+                for(const auto& event : events)
+                {
+                    uint32_t eventIndex = getEventIndex(result, event);
+                    if(eventIndex >= frame.eventCpuTimes.size())
+                    {
+                        frame.eventCpuTimes.resize(eventIndex + 1, 0.0f);
+                    }
+                    frame.eventCpuTimes[eventIndex] = event.cpuMs;
+                }
+                result.frames.push_back(frame);
+            }
+        }
+
+        mFrameIndex++;
+        if(mFrameIndex > mDesc.warmupFrames + mDesc.frameCount)
+        {
+            mRunIndex++;
+            return true;
+        }
+        return false;
+    }
+
+    Benchmark::Summary Benchmark::summarize(std::vector<float> values)
+    {
+        Summary summary;
+        if(values.empty())
+        {
+            return summary;
+        }
+
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for(float v : values)
+        {
+            sum += v;
+        }
+        summary.average = (float)(sum / values.size());
+        summary.min = values.front();
+        summary.max = values.back();
+        summary.median = values[values.size() / 2];
+        summary.percentile95 = values[std::min(values.size() - 1, (values.size() * 95) / 100)];
+        return summary;
+    }
+
+    bool Benchmark::hasPassed() const
+    {
+        for(const auto& result : mResults)
+        {
+            if(result.loaded == false || result.frames.size() != mDesc.frameCount)
+            {
+                return false;
+            }
+
+            if(mDesc.maxAverageFrameTime > 0)
+            {
+                std::vector<float> frameTimes;
+                for(const auto& frame : result.frames)
+                {
+                    frameTimes.push_back(frame.frameTime);
+                }
+                if(summarize(frameTimes).average > mDesc.maxAverageFrameTime)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool Benchmark::writeReport() const
+    {
+        std::ofstream file(mDesc.reportFilename, std::ios::trunc);
+        if(file.fail())
+        {
+            Logger::log(Logger::Level::Error, "Can't open benchmark report file " + mDesc.reportFilename);
+            return false;
+        }
+
+        bool success = hasSuffix(mDesc.reportFilename, ".csv", false) ? writeCsv(file) : writeJson(file);
+        file.close();
+        if(success == false || file.fail())
+        {
+            Logger::log(Logger::Level::Error, "Failed to write benchmark report file " + mDesc.reportFilename);
+            return false;
+        }
+        Logger::log(Logger::Level::Info, "Benchmark report written to " + mDesc.reportFilename);
+        return true;
+    }
+
+    bool Benchmark::writeJson(std::ofstream& file) const
+    {
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        auto writeString = [&writer](const std::string& str)
+        {
+            writer.String(str.c_str(), (rapidjson::SizeType)str.size());
+        };
+
+        auto writeSummary = [&writer](const char* key, const std::vector<float>& values)
+        {
+            Summary summary = summarize(values);
+            writer.Key(key);
+            writer.StartObject();
+            writer.Key("average");
+            writer.Double(summary.average);
+            writer.Key("min");
+            writer.Double(summary.min);
+            writer.Key("max");
+            writer.Double(summary.max);
+            writer.Key("median");
+            writer.Double(summary.median);
+            writer.Key("p95");
+            writer.Double(summary.percentile95);
+            writer.EndObject();
+        };
+
+        writer.StartObject();
+        writer.Key("passed");
+        writer.Bool(hasPassed());
+        writer.Key(BenchmarkKeys::kTimeStep);
+        writer.Double(mDesc.timeStep);
+        writer.Key(BenchmarkKeys::kWarmupFrames);
+        writer.Uint(mDesc.warmupFrames);
+        writer.Key(BenchmarkKeys::kFrameCount);
+        writer.Uint(mDesc.frameCount);
+        writer.Key(BenchmarkKeys::kHeadless);
+        writer.Bool(mDesc.headless);
+
+        writer.Key(BenchmarkKeys::kRuns);
+        writer.StartArray();
+        for(const auto& result : mResults)
+        {
+            writer.StartObject();
+            writer.Key(BenchmarkKeys::kScene);
+            writeString(result.run.sceneFilename);
+            writer.Key(BenchmarkKeys::kPath);
+            writeString(result.run.pathName);
+            writer.Key("loaded");
+            writer.Bool(result.loaded);
+
+            std::vector<float> frameTimes, cpuTimes;
+            for(const auto& frame : result.frames)
+            {
+                frameTimes.push_back(frame.frameTime);
+                cpuTimes.push_back(frame.cpuTime);
+            }
+            writeSummary("frame_time", frameTimes);
+            writeSummary("cpu_time", cpuTimes);
+
+            writer.Key("events");
+            writer.StartArray();
+            for(uint32_t eventIndex = 0; eventIndex < result.eventNames.size(); eventIndex++)
+            {
+                std::vector<float> eventCpuTimes, eventGpuTimes;
+                for(const auto& frame : result.frames)
+                {
+                    eventCpuTimes.push_back(getEventTime(frame.eventCpuTimes, eventIndex));
+                    eventGpuTimes.push_back(getEventTime(frame.eventGpuTimes, eventIndex));
+                }
+                writer.StartObject();
+                writer.Key("name");
+                writeString(result.eventNames[eventIndex]);
+                writer.Key("level");
+                writer.Uint(result.eventLevels[eventIndex]);
+                writeSummary("cpu_time", eventCpuTimes);
+                writeSummary("gpu_time", eventGpuTimes);
+                writer.EndObject();
+            }
+            writer.EndArray();
+
+            writer.Key("frames");
+            writer.StartArray();
+            for(const auto& frame : result.frames)
+            {
+                writer.StartObject();
+                writer.Key("time");
+                writer.Double(frame.time);
+                writer.Key("frame_time");
+                writer.Double(frame.frameTime);
+                writer.Key("cpu_time");
+                writer.Double(frame.cpuTime);
+                writer.Key("draws");
+                writer.Uint(frame.drawCount);
+                writer.Key("applied_state_changes");
+                writer.Uint(frame.appliedStateChanges);
+                writer.Key("filtered_state_changes");
+                writer.Uint(frame.filteredStateChanges);
+                writer.Key("event_cpu_times");
+                writer.StartArray();
+                for(uint32_t eventIndex = 0; eventIndex < result.eventNames.size(); eventIndex++)
+                {
+                    writer.Double(getEventTime(frame.eventCpuTimes, eventIndex));
+                }
+                writer.EndArray();
+                writer.Key("event_gpu_times");
+                writer.StartArray();
+                for(uint32_t eventIndex = 0; eventIndex < result.eventNames.size(); eventIndex++)
+                {
+                    writer.Double(getEventTime(frame.eventGpuTimes, eventIndex));
+                }
+                writer.EndArray();
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+
+        file.write(buffer.GetString(), buffer.GetSize());
+        return writer.IsComplete();
+    }
+
+    bool Benchmark::writeCsv(std::ofstream& file) const
+    {
+        // One row per frame. The event columns are the union of the events of all runs.
+        std::vector<std::string> eventNames;
+        for(const auto& result : mResults)
+        {
+            for(const auto& name : result.eventNames)
+            {
+                if(std::find(eventNames.begin(), eventNames.end(), name) == eventNames.end())
+                {
+                    eventNames.push_back(name);
+                }
+            }
+        }
+
+        file << "run,scene,path,frame,time,frame_time,cpu_time,draws,applied_state_changes,filtered_state_changes";
+        for(const auto& name : eventNames)
+        {
+            file << "," << quoteCsvField(name + " cpu") << "," << quoteCsvField(name + " gpu");
+        }
+        file << "\n";
+
+        for(uint32_t runIndex = 0; runIndex < mResults.size(); runIndex++)
+        {
+            const RunResult& result = mResults[runIndex];
+            std::vector<uint32_t> columnEvents(eventNames.size());
+            for(size_t column = 0; column < eventNames.size(); column++)
+            {
+                auto it = std::find(result.eventNames.begin(), result.eventNames.end(), eventNames[column]);
+                columnEvents[column] = (uint32_t)(it - result.eventNames.begin());
+            }
+
+            for(uint32_t frameIndex = 0; frameIndex < result.frames.size(); frameIndex++)
+            {
+                const Frame& frame = result.frames[frameIndex];
+                file << runIndex << "," << quoteCsvField(result.run.sceneFilename) << "," << quoteCsvField(result.run.pathName) << "," << frameIndex << "," << frame.time << "," << frame.frameTime << "," << frame.cpuTime;
+                file << "," << frame.drawCount << "," << frame.appliedStateChanges << "," << frame.filteredStateChanges;
+                for(uint32_t eventIndex : columnEvents)
+                {
+                    file << "," << getEventTime(frame.eventCpuTimes, eventIndex) << "," << getEventTime(frame.eventGpuTimes, eventIndex);
+                }
+                file << "\n";
+            }
+        }
+        return true;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "Utils/CpuTimer.h"
+#include "Utils/Profiler.h"
+#include "Core/RenderContext.h"
+
+namespace Falcor
+{
+    class Scene;
+
+    /** Records a deterministic benchmark. Sample drives it when SampleConfig#benchmark has runs.
+        A benchmark is a list of runs, each a scene file and a camera path. A run renders a number of warm-up frames at time 0, then the measured frames. The global time advances by a fixed step per measured frame, so every run renders the same frames no matter how fast they're rendered.
+        For every measured frame the wall-clock frame time, the CPU time spent in Sample::renderFrame(), the Profiler events and the render-context counters are recorded. The report is written as JSON or CSV when the benchmark ends.
+    */
+    class Benchmark
+    {
+    public:
+        using UniquePtr = std::unique_ptr<Benchmark>;
+        using UniqueConstPtr = std::unique_ptr<const Benchmark>;
+
+        struct Run
+        {
+            std::string sceneFilename;
+            std::string pathName;                   ///< The camera path to play. If empty, the scene's active path is kept.
+        };
+
+        struct Desc
+        {
+            std::vector<Run> runs;                  ///< The benchmark is disabled if this is empty
+            double timeStep = 1.0 / 60.0;           ///< Global time step between measured frames, in seconds
+            uint32_t warmupFrames = 60;             ///< Frames rendered at time 0 before the measurement starts
+            uint32_t frameCount = 600;              ///< Measured frames per run
+            std::string reportFilename = "Benchmark.json"; ///< Written as CSV if the extension is .csv, otherwise as JSON
+            float maxAverageFrameTime = 0;          ///< The benchmark fails if the average frame time of a run exceeds this, in milliseconds. 0 disables the check.
+            bool headless = false;                  ///< Hide the window and disable API submission (see RenderContext#setApiSubmission()). Only the CPU side of the frame is measured.
+        };
+
+        /** Read a benchmark description from a JSON file. Members which aren't in the file keep their value. For example:\n
+            { "runs": [{"scene": "Sponza.fscene", "path": "Flythrough"}], "time_step": 0.0166667, "warmup_frames": 60, "frame_count": 600, "report": "Sponza.csv", "max_average_frame_time": 16.6, "headless": false }
+            \return false if the file couldn't be read or parsed
+        */
+        static bool readDesc(const std::string& filename, Desc& desc);
+
+        /** Create a benchmark
+        */
+        static UniquePtr create(const Desc& desc);
+
+        /** Activate a camera path by name and attach the active camera to it. Helper for Sample#onBenchmarkRun().
+            \param[in] pScene The scene
+            \param[in] pathName The path name. If empty, the active path is kept.
+            \return false if the scene has no path with this name
+        */
+        static bool setActivePath(Scene* pScene, const std::string& pathName);
+
+        /** Animate all of the scene's models. SceneRenderer#update() only updates the camera, so a sample which renders animated models in a benchmark should call this every frame.
+            \param[in] pScene The scene
+            \param[in] currentTime The global time, see getCurrentTime()
+        */
+        static void animateModels(Scene* pScene, double currentTime);
+
+        const Desc& getDesc() const { return mDesc; }
+
+        /** Get the run which is being recorded, or will be recorded once it's started
+        */
+        const Run& getCurrentRun() const { return mDesc.runs[mRunIndex]; }
+        uint32_t getCurrentRunIndex() const { return mRunIndex; }
+
+        /** Check if all of the runs ended
+        */
+        bool isComplete() const { return mRunIndex == mDesc.runs.size(); }
+
+        /** Start recording the current run. Call after the run's scene was loaded.
+        */
+        void beginRun();
+
+        /** Record the current run as failed and move to the next one. Call if the run's scene couldn't be loaded.
+        */
+        void failRun();
+
+        /** Get the global time of the next frame
+        */
+        double getCurrentTime() const;
+
+        /** Record a frame
+            \param[in] cpuTime CPU time spent rendering the frame, in milliseconds
+            \param[in] events The Profiler events of the frame. The GPU times are a frame late and are assigned to the previous frame.
+            \param[in] stats The render-context counters of the frame
+            \return true if this was the run's last frame. The next run should be started.
+        */
+        bool endFrame(float cpuTime, const std::vector<Profiler::EventTimes>& events, const RenderContext::Stats& stats);
+
+        /** Write the report to Desc#reportFilename
+            \return false if the file couldn't be written
+        */
+        bool writeReport() const;
+
+        /** Check if every run was loaded and met the frame time threshold
+        */
+        bool hasPassed() const;
+
+    private:
+        Benchmark(const Desc& desc);
+
+        struct Frame
+        {
+            double time = 0;
+            float frameTime = 0;                    ///< Wall-clock time since the previous frame ended, in milliseconds
+            float cpuTime = 0;
+            uint32_t drawCount = 0;
+            uint32_t appliedStateChanges = 0;
+            uint32_t filteredStateChanges = 0;
+            std::vector<float> eventCpuTimes;       ///< Indexed like RunResult#eventNames. Events which appeared later in the run are missing.
+            std::vector<float> eventGpuTimes;
+        };
+
+        struct RunResult
+        {
+            Run run;
+            bool loaded = false;
+            std::vector<std::string> eventNames;
+            std::vector<uint32_t> eventLevels;
+            std::vector<Frame> frames;
+        };
+
+        struct Summary
+        {
+            float average = 0;
+            float min = 0;
+            float max = 0;
+            float median = 0;
+            float percentile95 = 0;
+        };
+
+        static Summary summarize(std::vector<float> values);
+        static uint32_t getEventIndex(RunResult& result, const Profiler::EventTimes& event);
+        static float getEventTime(const std::vector<float>& times, uint32_t eventIndex) { return eventIndex < times.size() ? times[eventIndex] : 0; }
+        bool writeJson(std::ofstream& file) const;
+        bool writeCsv(std::ofstream& file) const;
+
+        Desc mDesc;
+        std::vector<RunResult> mResults;
+        uint32_t mRunIndex = 0;
+        uint32_t mFrameIndex = 0;                   ///< Frames rendered in the current run, including the warm-up frames
+        CpuTimer::TimePoint mLastFrameEnd;
+    };
+}
\ No newline at end of file
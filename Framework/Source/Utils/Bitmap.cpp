@@ -146,6 +146,8 @@ namespace Falcor
             return FIF_PNG;
         case Bitmap::FileFormat::PfmFile:
             return FIF_PFM;
+        case Bitmap::FileFormat::ExrFile:
+            return FIF_EXR;
         default:
             should_not_get_here();
         }
@@ -167,8 +169,28 @@ namespace Falcor
         return FIT_BITMAP;
     }
 
-    void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat format, uint32_t bytesPerPixel, bool isTopDown, void* pData)
+    static int getSaveFlags(Bitmap::FileFormat format, int32_t compressionLevel)
     {
+        if(compressionLevel < 0)
+        {
+            return 0;
+        }
+
+        switch(format)
+        {
+        case Bitmap::FileFormat::PngFile:
+            // Level 0 has its own flag, since 0 means default
+            return (compressionLevel == 0) ? PNG_Z_NO_COMPRESSION : std::min(compressionLevel, 9);
+        case Bitmap::FileFormat::ExrFile:
+            return (compressionLevel == 0) ? EXR_NONE : EXR_ZIP;
+        default:
+            return 0;
+        }
+    }
+
+    bool Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat format, uint32_t bytesPerPixel, bool isTopDown, void* pData, int32_t compressionLevel)
+    {
+        bool success = false;
         if(pData)
         {
             FIBITMAP* pImage;
@@ -177,13 +199,21 @@ namespace Falcor
                 pImage = FreeImage_ConvertFromRawBits((BYTE*)pData, width, height, bytesPerPixel * width, bytesPerPixel*8, FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, isTopDown);
             else
             {
-                if(format != Bitmap::FileFormat::PfmFile || (bytesPerPixel != 16 && bytesPerPixel != 12))
+                if((format != Bitmap::FileFormat::PfmFile && format != Bitmap::FileFormat::ExrFile) || (bytesPerPixel != 16 && bytesPerPixel != 12))
+                {
                     Logger::log(Logger::Level::Error, "Bitmap::saveImage supports only 32-bit/channel RGB/RGBA images as HDR source.");
+                    return false;
+                }
                 // Upload the image manually
                 pImage = FreeImage_AllocateT(getImageType(bytesPerPixel), width, height);
+                if(pImage == nullptr)
+                {
+                    return false;
+                }
                 BYTE* head = (BYTE*)pData;
                 for(unsigned y = 0; y < height; y++) {
-                    float* dstBits = (float*)FreeImage_GetScanLine(pImage, y);
+                    // FreeImage scanlines are stored bottom-up
+                    float* dstBits = (float*)FreeImage_GetScanLine(pImage, isTopDown ? height - 1 - y : y);
                     if(bytesPerPixel == 12)
                         memcpy(dstBits, head, bytesPerPixel * width);
                     else
@@ -198,10 +228,15 @@ namespace Falcor
                 }
             }
 
+            if(pImage == nullptr)
+            {
+                return false;
+            }
             FREE_IMAGE_TYPE type = FreeImage_GetImageType(pImage);
 
-            FreeImage_Save(toFreeImageFormat(format), pImage, filename.c_str(), 0);
+            success = FreeImage_Save(toFreeImageFormat(format), pImage, filename.c_str(), getSaveFlags(format, compressionLevel)) != FALSE;
             FreeImage_Unload(pImage);
         }
+        return success;
     }
 }
\ No newline at end of file
@@ -38,7 +38,8 @@ namespace Falcor
         enum class FileFormat
         {
             PngFile,            //< PNG file for lossless compressed 8-bits images with optional alpha
-            PfmFile             //< PFM file for floating point HDR images with 32-bit float per channel
+            PfmFile,            //< PFM file for floating point HDR images with 32-bit float per channel
+            ExrFile             //< OpenEXR file for floating point HDR images
         };
 
         using UniquePtr = std::unique_ptr<Bitmap>;
@@ -58,8 +59,10 @@ namespace Falcor
             \param[in] bytesPerPixel The number of bytes in each pixel
             \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel will be stored first, otherwise the bottom-left pixel will be stored first
             \param[in] pData Pointer to the buffer containing the image
+            \param[in] compressionLevel For PNG files, the zlib compression level between 0 (none) and 9 (best). For EXR files, 0 disables compression and any other value uses ZIP compression. -1 uses the format's default.
+            \return false if the image couldn't be written
         */
-        static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat format, uint32_t bytesPerPixel, bool isTopDown, void* pData);
+        static bool saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat format, uint32_t bytesPerPixel, bool isTopDown, void* pData, int32_t compressionLevel = -1);
         ~Bitmap();
 
         /** Get a pointer to the bitmap's data store
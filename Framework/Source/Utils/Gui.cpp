@@ -274,6 +274,8 @@ namespace Falcor
         spRenderContext->pushState();
         spRenderContext->setRasterizerState(nullptr);
         TwDraw();
+        // AntTweakBar makes raw API calls
+        spRenderContext->invalidateApiState();
         spRenderContext->popState();
     }
 
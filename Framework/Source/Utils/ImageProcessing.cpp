@@ -0,0 +1,713 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageProcessing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "Utils/ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define IMAGE_PROCESSING_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Falcor
+{
+    /************************************************************************/
+    /* Scalar conversions                                                   */
+    /************************************************************************/
+    static uint32_t asUint(float f)
+    {
+        uint32_t u;
+        memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    static float asFloat(uint32_t u)
+    {
+        float f;
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+    static float halfToFloat(uint16_t h)
+    {
+        static const uint32_t kShiftedExp = 0x7c00 << 13;
+        uint32_t o = (h & 0x7fff) << 13;
+        uint32_t exp = kShiftedExp & o;
+        o += (127 - 15) << 23;
+        if(exp == kShiftedExp)
+        {
+            // Inf/NaN
+            o += (128 - 16) << 23;
+        }
+        else if(exp == 0)
+        {
+            // Zero/denormal
+            o = asUint(asFloat(o + (1 << 23)) - asFloat(113 << 23));
+        }
+        return asFloat(o | ((h & 0x8000) << 16));
+    }
+
+    static uint16_t floatToHalf(float value)
+    {
+        static const uint32_t kF32Infinity = 255 << 23;
+        static const uint32_t kF16Max = (127 + 16) << 23;
+        static const uint32_t kDenormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+        uint32_t f = asUint(value);
+        uint32_t sign = f & 0x80000000;
+        f ^= sign;
+
+        uint32_t o;
+        if(f >= kF16Max)
+        {
+            // Overflow becomes Inf, NaN stays NaN
+            o = (f > kF32Infinity) ? 0x7e00 : 0x7c00;
+        }
+        else if(f < (113 << 23))
+        {
+            // Denormals, rounded by the FPU when adding the magic number
+            o = asUint(asFloat(f) + asFloat(kDenormMagic)) - kDenormMagic;
+        }
+        else
+        {
+            uint32_t mantissaOdd = (f >> 13) & 1;
+            f += ((15 - 127) << 23) + 0xfff;
+            f += mantissaOdd;
+            o = f >> 13;
+        }
+        return (uint16_t)(o | (sign >> 16));
+    }
+
+    static float srgbToLinear(float c)
+    {
+        return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    /** Conversion tables for 8-bit values. Built during static initialization, so they are ready before any thread uses them.
+    */
+    struct Unorm8Tables
+    {
+        static const uint32_t kSrgbBucketCount = 4096;
+
+        Unorm8Tables()
+        {
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                toFloat[i] = i / 255.0f;
+                srgbToFloat[i] = srgbToLinear(i / 255.0f);
+            }
+            for(uint32_t i = 0; i < 255; i++)
+            {
+                srgbThresholds[i] = (srgbToFloat[i] + srgbToFloat[i + 1]) * 0.5f;
+            }
+            srgbThresholds[255] = FLT_MAX;
+
+            uint32_t code = 0;
+            for(uint32_t i = 0; i < kSrgbBucketCount; i++)
+            {
+                while(srgbThresholds[code] <= (float)i / kSrgbBucketCount)
+                {
+                    code++;
+                }
+                srgbBuckets[i] = (uint8_t)code;
+            }
+        }
+
+        float toFloat[256];
+        float srgbToFloat[256];
+        float srgbThresholds[256];                  ///< Midpoints between consecutive sRGB values, in linear space
+        uint8_t srgbBuckets[kSrgbBucketCount];      ///< The sRGB value at the start of each bucket of linear values
+    };
+    static const Unorm8Tables sUnorm8Tables;
+
+    /** Encode a linear value to the closest 8-bit sRGB value. The bucket table gives a starting point which is at most a few values away.
+    */
+    static uint8_t linearToSrgb8(float value)
+    {
+        value = std::max(0.0f, std::min(1.0f, value));
+        uint32_t code = sUnorm8Tables.srgbBuckets[std::min((uint32_t)(value * Unorm8Tables::kSrgbBucketCount), Unorm8Tables::kSrgbBucketCount - 1)];
+        while(sUnorm8Tables.srgbThresholds[code] <= value)
+        {
+            code++;
+        }
+        return (uint8_t)code;
+    }
+
+    static uint8_t floatToUnorm8(float value)
+    {
+        return (uint8_t)(std::max(0.0f, std::min(1.0f, value)) * 255.0f + 0.5f);
+    }
+
+    /************************************************************************/
+    /* Pixel layouts                                                        */
+    /************************************************************************/
+    enum class ComponentType
+    {
+        Unorm8,
+        Float16,
+        Float32,
+    };
+
+    struct PixelLayout
+    {
+        ComponentType type;
+        uint32_t channelCount;
+        uint32_t srgbChannelCount;      ///< The number of leading channels stored as sRGB
+        uint32_t bytesPerPixel;
+    };
+
+    static bool getPixelLayout(ResourceFormat format, PixelLayout& layout)
+    {
+        layout.srgbChannelCount = 0;
+        switch(format)
+        {
+        case ResourceFormat::RGBA8UnormSrgb:
+        case ResourceFormat::BGRA8UnormSrgb:
+        case ResourceFormat::RGBX8UnormSrgb:
+        case ResourceFormat::BGRX8UnormSrgb:
+            layout.srgbChannelCount = 3;
+            // Fall through
+        case ResourceFormat::R8Unorm:
+        case ResourceFormat::RG8Unorm:
+        case ResourceFormat::RGBA8Unorm:
+        case ResourceFormat::BGRA8Unorm:
+        case ResourceFormat::RGBX8Unorm:
+        case ResourceFormat::BGRX8Unorm:
+        case ResourceFormat::Alpha8Unorm:
+            layout.type = ComponentType::Unorm8;
+            layout.channelCount = getFormatBytesPerBlock(format);
+            break;
+        case ResourceFormat::R16Float:
+        case ResourceFormat::RG16Float:
+        case ResourceFormat::RGB16Float:
+        case ResourceFormat::RGBA16Float:
+            layout.type = ComponentType::Float16;
+            layout.channelCount = getFormatBytesPerBlock(format) / 2;
+            break;
+        case ResourceFormat::R32Float:
+        case ResourceFormat::RG32Float:
+        case ResourceFormat::RGB32Float:
+        case ResourceFormat::RGBA32Float:
+        case ResourceFormat::Alpha32Float:
+            layout.type = ComponentType::Float32;
+            layout.channelCount = getFormatBytesPerBlock(format) / 4;
+            break;
+        default:
+            return false;
+        }
+        layout.bytesPerPixel = getFormatBytesPerBlock(format);
+        return true;
+    }
+
+    static void decodeRow(const uint8_t* pSrc, uint32_t width, const PixelLayout& layout, float* pDst)
+    {
+        uint32_t count = width * layout.channelCount;
+        switch(layout.type)
+        {
+        case ComponentType::Unorm8:
+            {
+                const float* pTables[4];
+                for(uint32_t c = 0; c < layout.channelCount; c++)
+                {
+                    pTables[c] = (c < layout.srgbChannelCount) ? sUnorm8Tables.srgbToFloat : sUnorm8Tables.toFloat;
+                }
+                for(uint32_t i = 0; i < count; i += layout.channelCount)
+                {
+                    for(uint32_t c = 0; c < layout.channelCount; c++)
+                    {
+                        pDst[i + c] = pTables[c][pSrc[i + c]];
+                    }
+                }
+            }
+            break;
+        case ComponentType::Float16:
+            ImageProcessing::convertHalfToFloat((const uint16_t*)pSrc, pDst, count);
+            break;
+        case ComponentType::Float32:
+            memcpy(pDst, pSrc, count * sizeof(float));
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    static void encodeRow(const float* pSrc, uint32_t width, const PixelLayout& layout, uint8_t* pDst)
+    {
+        uint32_t count = width * layout.channelCount;
+        switch(layout.type)
+        {
+        case ComponentType::Unorm8:
+            for(uint32_t i = 0; i < count; i += layout.channelCount)
+            {
+                for(uint32_t c = 0; c < layout.srgbChannelCount; c++)
+                {
+                    pDst[i + c] = linearToSrgb8(pSrc[i + c]);
+                }
+                for(uint32_t c = layout.srgbChannelCount; c < layout.channelCount; c++)
+                {
+                    pDst[i + c] = floatToUnorm8(pSrc[i + c]);
+                }
+            }
+            break;
+        case ComponentType::Float16:
+            ImageProcessing::convertFloatToHalf(pSrc, (uint16_t*)pDst, count);
+            break;
+        case ComponentType::Float32:
+            memcpy(pDst, pSrc, count * sizeof(float));
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    /************************************************************************/
+    /* Filters                                                              */
+    /************************************************************************/
+    static const float kKaiserRadius = 3.0f;    // In destination texels
+    static const float kKaiserAlpha = 4.0f;
+    static const float kPi = 3.14159265358979f;
+
+    static float besselI0(float x)
+    {
+        float sum = 1;
+        float term = 1;
+        for(uint32_t k = 1; k < 20; k++)
+        {
+            float t = x / (2.0f * k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    static float sinc(float x)
+    {
+        return (std::abs(x) < 1e-6f) ? 1.0f : std::sin(kPi * x) / (kPi * x);
+    }
+
+    /** The source texels and weights for each destination texel, along one axis. Indices are clamped to the edge.
+    */
+    struct FilterTaps
+    {
+        uint32_t tapCount;
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    static void buildTaps(uint32_t srcSize, uint32_t dstSize, ImageProcessing::MipFilter filter, FilterTaps& taps)
+    {
+        float scale = (float)srcSize / (float)dstSize;
+        float halfWidth = (filter == ImageProcessing::MipFilter::Box) ? scale * 0.5f : kKaiserRadius * scale;
+        taps.tapCount = (uint32_t)std::ceil(2 * halfWidth) + 1;
+        taps.indices.resize(dstSize * taps.tapCount);
+        taps.weights.resize(dstSize * taps.tapCount);
+
+        for(uint32_t x = 0; x < dstSize; x++)
+        {
+            float center = (x + 0.5f) * scale;
+            int32_t first = (int32_t)std::floor(center - halfWidth);
+            float sum = 0;
+            for(uint32_t t = 0; t < taps.tapCount; t++)
+            {
+                int32_t i = first + (int32_t)t;
+                float w;
+                if(filter == ImageProcessing::MipFilter::Box)
+                {
+                    float begin = std::max((float)i, center - halfWidth);
+                    float end = std::min((float)(i + 1), center + halfWidth);
+                    w = std::max(0.0f, end - begin);
+                }
+                else
+                {
+                    float u = (i + 0.5f - center) / scale;
+                    float r = u / kKaiserRadius;
+                    w = (std::abs(r) < 1) ? sinc(u) * besselI0(kKaiserAlpha * std::sqrt(1 - r * r)) / besselI0(kKaiserAlpha) : 0.0f;
+                }
+                taps.indices[x * taps.tapCount + t] = (uint32_t)std::max(0, std::min((int32_t)srcSize - 1, i));
+                taps.weights[x * taps.tapCount + t] = w;
+                sum += w;
+            }
+
+            for(uint32_t t = 0; t < taps.tapCount; t++)
+            {
+                taps.weights[x * taps.tapCount + t] /= sum;
+            }
+        }
+    }
+
+    /** Filter a decoded row horizontally
+    */
+    static void filterRow(const float* pSrc, uint32_t channelCount, const FilterTaps& taps, uint32_t dstWidth, float* pDst)
+    {
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        if(channelCount == 4)
+        {
+            for(uint32_t x = 0; x < dstWidth; x++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                const uint32_t* pIndices = &taps.indices[x * taps.tapCount];
+                const float* pWeights = &taps.weights[x * taps.tapCount];
+                for(uint32_t t = 0; t < taps.tapCount; t++)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(pWeights[t]), _mm_loadu_ps(pSrc + pIndices[t] * 4)));
+                }
+                _mm_storeu_ps(pDst + x * 4, sum);
+            }
+            return;
+        }
+#endif
+        for(uint32_t x = 0; x < dstWidth; x++)
+        {
+            const uint32_t* pIndices = &taps.indices[x * taps.tapCount];
+            const float* pWeights = &taps.weights[x * taps.tapCount];
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                float sum = 0;
+                for(uint32_t t = 0; t < taps.tapCount; t++)
+                {
+                    sum += pWeights[t] * pSrc[pIndices[t] * channelCount + c];
+                }
+                pDst[x * channelCount + c] = sum;
+            }
+        }
+    }
+
+    static void accumulateRow(float* pDst, const float* pSrc, float weight, uint32_t count)
+    {
+        uint32_t i = 0;
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        __m128 w = _mm_set1_ps(weight);
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(pDst + i, _mm_add_ps(_mm_loadu_ps(pDst + i), _mm_mul_ps(w, _mm_loadu_ps(pSrc + i))));
+        }
+#endif
+        for(; i < count; i++)
+        {
+            pDst[i] += weight * pSrc[i];
+        }
+    }
+
+    /** Produce a band of destination rows. The source rows the band needs are filtered horizontally into a scratch buffer, then combined vertically.
+    */
+    static void resampleRows(const uint8_t* pSrc, uint32_t srcWidth, const PixelLayout& layout, const FilterTaps& xTaps, const FilterTaps& yTaps, uint32_t dstWidth, uint32_t dstBegin, uint32_t dstEnd, uint8_t* pDst)
+    {
+        uint32_t rowFloats = dstWidth * layout.channelCount;
+        uint32_t srcBegin = UINT32_MAX;
+        uint32_t srcEnd = 0;
+        for(uint32_t i = dstBegin * yTaps.tapCount; i < dstEnd * yTaps.tapCount; i++)
+        {
+            srcBegin = std::min(srcBegin, yTaps.indices[i]);
+            srcEnd = std::max(srcEnd, yTaps.indices[i] + 1);
+        }
+
+        std::vector<float> decoded(srcWidth * layout.channelCount);
+        std::vector<float> filtered((srcEnd - srcBegin) * rowFloats);
+        for(uint32_t y = srcBegin; y < srcEnd; y++)
+        {
+            decodeRow(pSrc + (size_t)y * srcWidth * layout.bytesPerPixel, srcWidth, layout, decoded.data());
+            filterRow(decoded.data(), layout.channelCount, xTaps, dstWidth, filtered.data() + (y - srcBegin) * rowFloats);
+        }
+
+        std::vector<float> sum(rowFloats);
+        for(uint32_t y = dstBegin; y < dstEnd; y++)
+        {
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            for(uint32_t t = 0; t < yTaps.tapCount; t++)
+            {
+                float w = yTaps.weights[y * yTaps.tapCount + t];
+                if(w != 0)
+                {
+                    accumulateRow(sum.data(), filtered.data() + (yTaps.indices[y * yTaps.tapCount + t] - srcBegin) * rowFloats, w, rowFloats);
+                }
+            }
+            encodeRow(sum.data(), dstWidth, layout, pDst + (size_t)y * dstWidth * layout.bytesPerPixel);
+        }
+    }
+
+    /************************************************************************/
+    /* ImageProcessing                                                      */
+    /************************************************************************/
+    bool ImageProcessing::isMipGenerationSupported(ResourceFormat format)
+    {
+        PixelLayout layout;
+        return getPixelLayout(format, layout);
+    }
+
+    bool ImageProcessing::downsample(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat format, MipFilter filter, void* pDst)
+    {
+        PixelLayout layout;
+        if(getPixelLayout(format, layout) == false)
+        {
+            Logger::log(Logger::Level::Error, "ImageProcessing::downsample() - unsupported format " + to_string(format));
+            return false;
+        }
+
+        uint32_t dstWidth = std::max(width / 2, 1u);
+        uint32_t dstHeight = std::max(height / 2, 1u);
+        FilterTaps xTaps, yTaps;
+        buildTaps(width, dstWidth, filter, xTaps);
+        buildTaps(height, dstHeight, filter, yTaps);
+
+        // Bands of about 64K texels. Larger bands recompute fewer overlapping source rows.
+        uint32_t grainSize = std::max(4u, 65536u / dstWidth);
+        parallelFor(dstHeight, grainSize, [&](uint32_t begin, uint32_t end)
+        {
+            resampleRows((const uint8_t*)pSrc, width, layout, xTaps, yTaps, dstWidth, begin, end, (uint8_t*)pDst);
+        });
+        return true;
+    }
+
+    std::vector<uint8_t> ImageProcessing::generateMipChain(const void* pData, uint32_t width, uint32_t height, ResourceFormat format, MipFilter filter, uint32_t& mipCount)
+    {
+        std::vector<uint8_t> chain;
+        mipCount = 0;
+        if(isMipGenerationSupported(format) == false)
+        {
+            Logger::log(Logger::Level::Error, "ImageProcessing::generateMipChain() - unsupported format " + to_string(format));
+            return chain;
+        }
+
+        uint32_t bpp = getFormatBytesPerBlock(format);
+        size_t size = 0;
+        for(uint32_t w = width, h = height; ; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u))
+        {
+            size += (size_t)w * h * bpp;
+            mipCount++;
+            if(w == 1 && h == 1)
+            {
+                break;
+            }
+        }
+
+        chain.resize(size);
+        memcpy(chain.data(), pData, (size_t)width * height * bpp);
+        size_t offset = 0;
+        for(uint32_t mip = 1; mip < mipCount; mip++)
+        {
+            size_t levelSize = (size_t)width * height * bpp;
+            downsample(chain.data() + offset, width, height, format, filter, chain.data() + offset + levelSize);
+            offset += levelSize;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        return chain;
+    }
+
+    std::vector<uint8_t> ImageProcessing::generateMipLevel(const void* pData, uint32_t& width, uint32_t& height, ResourceFormat format, MipFilter filter, uint32_t mipLevel)
+    {
+        std::vector<uint8_t> result;
+        if(isMipGenerationSupported(format) == false)
+        {
+            Logger::log(Logger::Level::Error, "ImageProcessing::generateMipLevel() - unsupported format " + to_string(format));
+            return result;
+        }
+
+        uint32_t bpp = getFormatBytesPerBlock(format);
+        std::vector<uint8_t> scratch;
+        const uint8_t* pSrc = (const uint8_t*)pData;
+        for(uint32_t i = 0; i < mipLevel && (width > 1 || height > 1); i++)
+        {
+            scratch.resize((size_t)std::max(width / 2, 1u) * std::max(height / 2, 1u) * bpp);
+            downsample(pSrc, width, height, format, filter, scratch.data());
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            result.swap(scratch);
+            pSrc = result.data();
+        }
+
+        if(pSrc == pData)
+        {
+            result.assign(pSrc, pSrc + (size_t)width * height * bpp);
+        }
+        return result;
+    }
+
+    void ImageProcessing::expandRgbToRgba(const uint8_t* pSrc, uint8_t* pDst, size_t texelCount, uint8_t alpha)
+    {
+        // Work backwards, so that the expansion can be done in-place. Each group of 4 texels is loaded as 3 words before the 4 output words are stored.
+        size_t groupCount = texelCount / 4;
+        uint32_t alphaBits = (uint32_t)alpha << 24;
+        for(size_t i = texelCount; i > groupCount * 4; i--)
+        {
+            size_t t = i - 1;
+            uint8_t r = pSrc[t * 3 + 0], g = pSrc[t * 3 + 1], b = pSrc[t * 3 + 2];
+            pDst[t * 4 + 0] = r;
+            pDst[t * 4 + 1] = g;
+            pDst[t * 4 + 2] = b;
+            pDst[t * 4 + 3] = alpha;
+        }
+
+        for(size_t group = groupCount; group > 0; group--)
+        {
+            uint32_t w[3];
+            memcpy(w, pSrc + (group - 1) * 12, sizeof(w));
+            uint32_t texels[4];
+            texels[0] = (w[0] & 0xFFFFFF) | alphaBits;
+            texels[1] = ((w[0] >> 24) | (w[1] << 8)) & 0xFFFFFF;
+            texels[1] |= alphaBits;
+            texels[2] = ((w[1] >> 16) | (w[2] << 16)) & 0xFFFFFF;
+            texels[2] |= alphaBits;
+            texels[3] = (w[2] >> 8) | alphaBits;
+            memcpy(pDst + (group - 1) * 16, texels, sizeof(texels));
+        }
+    }
+
+    void ImageProcessing::swapRedBlue(uint8_t* pData, size_t texelCount)
+    {
+        size_t i = 0;
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        const __m128i kGreenAlpha = _mm_set1_epi32(0xFF00FF00);
+        const __m128i kLowByte = _mm_set1_epi32(0xFF);
+        for(; i + 4 <= texelCount; i += 4)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)(pData + i * 4));
+            __m128i ga = _mm_and_si128(v, kGreenAlpha);
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, kLowByte), 16);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), kLowByte);
+            _mm_storeu_si128((__m128i*)(pData + i * 4), _mm_or_si128(ga, _mm_or_si128(r, b)));
+        }
+#endif
+        for(; i < texelCount; i++)
+        {
+            std::swap(pData[i * 4], pData[i * 4 + 2]);
+        }
+    }
+
+    void ImageProcessing::convertHalfToFloat(const uint16_t* pSrc, float* pDst, size_t count)
+    {
+        size_t i = 0;
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        const __m128i kNoSign = _mm_set1_epi32(0x7fff);
+        const __m128 kMagic = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+        const __m128i kWasInfNan = _mm_set1_epi32(0x7bff);
+        const __m128i kInfNanExp = _mm_set1_epi32(255 << 23);
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i halves = _mm_loadu_si128((const __m128i*)(pSrc + i));
+            __m128i words[2] = {_mm_unpacklo_epi16(halves, _mm_setzero_si128()), _mm_unpackhi_epi16(halves, _mm_setzero_si128())};
+            for(uint32_t j = 0; j < 2; j++)
+            {
+                __m128i expMantissa = _mm_and_si128(kNoSign, words[j]);
+                __m128i sign = _mm_slli_epi32(_mm_xor_si128(words[j], expMantissa), 16);
+                // Rebias the exponent with a multiply, which also normalizes denormals
+                __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMantissa, 13)), kMagic);
+                __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMantissa, kWasInfNan), kInfNanExp);
+                _mm_storeu_ps(pDst + i + j * 4, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan))));
+            }
+        }
+#endif
+        for(; i < count; i++)
+        {
+            pDst[i] = halfToFloat(pSrc[i]);
+        }
+    }
+
+    void ImageProcessing::convertFloatToHalf(const float* pSrc, uint16_t* pDst, size_t count)
+    {
+        size_t i = 0;
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        const __m128i kSignMask = _mm_set1_epi32(0x80000000);
+        const __m128i kF16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i kNanBit = _mm_set1_epi32(0x200);
+        const __m128i kInfinity = _mm_set1_epi32(0x7c00);
+        const __m128 kMinNormal = _mm_castsi128_ps(_mm_set1_epi32((127 - 14) << 23));
+        const __m128i kDenormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i kNormalBias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+        for(; i + 8 <= count; i += 8)
+        {
+            __m128i halves[2];
+            for(uint32_t j = 0; j < 2; j++)
+            {
+                __m128 f = _mm_loadu_ps(pSrc + i + j * 4);
+                __m128i sign = _mm_and_si128(_mm_castps_si128(f), kSignMask);
+                __m128 absF = _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(f), sign));
+                __m128i absI = _mm_castps_si128(absF);
+
+                __m128i isDenorm = _mm_castps_si128(_mm_cmplt_ps(absF, kMinNormal));
+                __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+                __m128i isRegular = _mm_cmpgt_epi32(kF16Max, absI);
+                __m128i infNan = _mm_or_si128(_mm_and_si128(isNan, kNanBit), kInfinity);
+
+                // Denormals are rounded by the FPU when adding the magic number
+                __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(kDenormMagic))), kDenormMagic);
+
+                // Normals round to nearest-even by adding the bias and the odd bit of the mantissa
+                __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absI, 31 - 13), 31);
+                __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absI, kNormalBias), mantissaOdd), 13);
+
+                __m128i finite = _mm_or_si128(_mm_and_si128(isDenorm, denorm), _mm_andnot_si128(isDenorm, normal));
+                __m128i result = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infNan));
+                result = _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+
+                // Sign-extend so that the signed pack doesn't saturate
+                halves[j] = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+            }
+            _mm_storeu_si128((__m128i*)(pDst + i), _mm_packs_epi32(halves[0], halves[1]));
+        }
+#endif
+        for(; i < count; i++)
+        {
+            pDst[i] = floatToHalf(pSrc[i]);
+        }
+    }
+
+    void ImageProcessing::swapRows(uint8_t* pRow0, uint8_t* pRow1, size_t size)
+    {
+        size_t offset = 0;
+#ifdef IMAGE_PROCESSING_USE_SSE2
+        for(; offset + 16 <= size; offset += 16)
+        {
+            __m128i row0 = _mm_loadu_si128((const __m128i*)(pRow0 + offset));
+            __m128i row1 = _mm_loadu_si128((const __m128i*)(pRow1 + offset));
+            _mm_storeu_si128((__m128i*)(pRow0 + offset), row1);
+            _mm_storeu_si128((__m128i*)(pRow1 + offset), row0);
+        }
+#endif
+        for(; offset < size; offset++)
+        {
+            std::swap(pRow0[offset], pRow1[offset]);
+        }
+    }
+
+    void ImageProcessing::flipVertically(void* pData, size_t rowSize, uint32_t rowCount)
+    {
+        uint8_t* pRows = (uint8_t*)pData;
+        uint32_t grainSize = (uint32_t)std::max((size_t)1, (1 << 20) / std::max(rowSize, (size_t)1));
+        parallelFor(rowCount / 2, grainSize, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t y = begin; y < end; y++)
+            {
+                swapRows(pRows + y * rowSize, pRows + (rowCount - 1 - y) * rowSize, rowSize);
+            }
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "Core/Formats.h"
+
+namespace Falcor
+{
+    /** CPU image processing on raw texture data, for loaders which hold the data before creating textures.
+        The loops use SSE2 where it is available, and mip generation splits the rows between threads with parallelFor(), so the functions can be called from loader threads to precompute full mip-chains before the texture is created.
+    */
+    class ImageProcessing
+    {
+    public:
+        enum class MipFilter
+        {
+            Box,        ///< Area average. Handles odd dimensions without dropping texels.
+            Kaiser,     ///< Kaiser-windowed sinc. Sharper than the box filter. Unorm results are clamped to [0, 1].
+        };
+
+        /** Check if downsample() and generateMipChain() support a format.
+            Supported formats are 8-bit unorm (including sRGB and Alpha8), 16-bit float and 32-bit float formats with 1 to 4 channels.
+        */
+        static bool isMipGenerationSupported(ResourceFormat format);
+
+        /** Downsample an image to the next mip-level. sRGB formats are filtered in linear space. Alpha and X channels are always linear.
+            \param[in] pSrc The source image, tightly packed
+            \param[in] width The width of the source image
+            \param[in] height The height of the source image
+            \param[in] format The format of the source and destination images
+            \param[in] filter The filter
+            \param[out] pDst The destination image. Its size is max(width / 2, 1) by max(height / 2, 1).
+            \return false if the format isn't supported
+        */
+        static bool downsample(const void* pSrc, uint32_t width, uint32_t height, ResourceFormat format, MipFilter filter, void* pDst);
+
+        /** Generate an entire mip-chain
+            \param[in] pData The most detailed level
+            \param[in] width The width of the most detailed level
+            \param[in] height The height of the most detailed level
+            \param[in] format The texture format
+            \param[in] filter The filter
+            \param[out] mipCount The number of levels in the result
+            \return All the levels, starting with a copy of the most detailed one, in the layout Texture::create2D() expects. Empty if the format isn't supported.
+        */
+        static std::vector<uint8_t> generateMipChain(const void* pData, uint32_t width, uint32_t height, ResourceFormat format, MipFilter filter, uint32_t& mipCount);
+
+        /** Generate a single mip-level
+            \param[in] pData The most detailed level
+            \param[in, out] width The width of the most detailed level. Receives the width of the result.
+            \param[in, out] height The height of the most detailed level. Receives the height of the result.
+            \param[in] mipLevel The level to generate. Stops early at 1x1.
+            \return The level. Empty if the format isn't supported.
+        */
+        static std::vector<uint8_t> generateMipLevel(const void* pData, uint32_t& width, uint32_t& height, ResourceFormat format, MipFilter filter, uint32_t mipLevel);
+
+        /** Expand 3-byte texels to 4 bytes, adding an alpha channel. pSrc and pDst may point to the same buffer, which must hold texelCount * 4 bytes.
+        */
+        static void expandRgbToRgba(const uint8_t* pSrc, uint8_t* pDst, size_t texelCount, uint8_t alpha = 0xFF);
+
+        /** Swap the first and third bytes of 4-byte texels in-place, converting RGBA to BGRA or the other way around
+        */
+        static void swapRedBlue(uint8_t* pData, size_t texelCount);
+
+        /** Convert half-precision floats to single-precision
+        */
+        static void convertHalfToFloat(const uint16_t* pSrc, float* pDst, size_t count);
+
+        /** Convert single-precision floats to half-precision, rounding to nearest-even. Values which are too large become infinity.
+        */
+        static void convertFloatToHalf(const float* pSrc, uint16_t* pDst, size_t count);
+
+        /** Flip an image vertically in-place
+        */
+        static void flipVertically(void* pData, size_t rowSize, uint32_t rowCount);
+
+        /** Swap the contents of two rows. The rows must not overlap.
+        */
+        static void swapRows(uint8_t* pRow0, uint8_t* pRow1, size_t size);
+    };
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageSequenceWriter.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/OS.h"
+#include <fstream>
+
+namespace Falcor
+{
+    static const char* getExtension(ImageSequenceWriter::FileFormat format)
+    {
+        switch(format)
+        {
+        case ImageSequenceWriter::FileFormat::Png:
+            return "png";
+        case ImageSequenceWriter::FileFormat::Pfm:
+            return "pfm";
+        case ImageSequenceWriter::FileFormat::Exr:
+            return "exr";
+        case ImageSequenceWriter::FileFormat::Raw:
+            return "raw";
+        default:
+            should_not_get_here();
+            return "";
+        }
+    }
+
+    ImageSequenceWriter::UniquePtr ImageSequenceWriter::create(const Desc& desc)
+    {
+        if(desc.width == 0 || desc.height == 0 || desc.bytesPerPixel == 0)
+        {
+            Logger::log(Logger::Level::Error, "ImageSequenceWriter::create() - frame dimensions must be larger than 0.");
+            return nullptr;
+        }
+
+        bool isHdr = (desc.format == FileFormat::Pfm) || (desc.format == FileFormat::Exr);
+        if((desc.format == FileFormat::Png && desc.bytesPerPixel != 4) || (isHdr && desc.bytesPerPixel != 12 && desc.bytesPerPixel != 16))
+        {
+            Logger::log(Logger::Level::Error, "ImageSequenceWriter::create() - PNG requires 4 bytes per pixel, PFM and EXR require 12 or 16 bytes per pixel.");
+            return nullptr;
+        }
+        return UniquePtr(new ImageSequenceWriter(desc));
+    }
+
+    ImageSequenceWriter::ImageSequenceWriter(const Desc& desc) : mDesc(desc)
+    {
+        if(mDesc.directory.empty())
+        {
+            mDesc.directory = getExecutableDirectory();
+        }
+        if(mDesc.threadCount == 0)
+        {
+            // hardware_concurrency() returns 0 when the count is unknown
+            mDesc.threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+        }
+        if(mDesc.queueSize == 0)
+        {
+            mDesc.queueSize = mDesc.threadCount * 2;
+        }
+        mNextFrameIndex = mDesc.firstFrameIndex;
+
+        mFrameStorage.resize(mDesc.queueSize);
+        for(auto& frame : mFrameStorage)
+        {
+            frame.resize(getFrameSize());
+            mFreeFrames.push_back(frame.data());
+        }
+
+        for(uint32_t i = 0; i < mDesc.threadCount; i++)
+        {
+            mWorkers.push_back(std::thread(&ImageSequenceWriter::workerFunc, this));
+        }
+    }
+
+    ImageSequenceWriter::~ImageSequenceWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mFrameQueuedCV.notify_all();
+        for(auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    std::string ImageSequenceWriter::getFilename(uint32_t frameIndex) const
+    {
+        std::string index = std::to_string(frameIndex);
+        if(index.size() < mDesc.digitCount)
+        {
+            index.insert(0, mDesc.digitCount - index.size(), '0');
+        }
+        return mDesc.directory + '/' + mDesc.prefix + index + '.' + getExtension(mDesc.format);
+    }
+
+    uint8_t* ImageSequenceWriter::acquireFrame()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(mFreeFrames.empty())
+        {
+            auto start = CpuTimer::getCurrentTimePoint();
+            mFrameFreedCV.wait(lock, [this] {return mFreeFrames.empty() == false; });
+            mStats.blockedTimeInMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        }
+
+        uint8_t* pFrame = mFreeFrames.back();
+        mFreeFrames.pop_back();
+        return pFrame;
+    }
+
+    uint32_t ImageSequenceWriter::submitFrame(uint8_t* pFrame)
+    {
+        uint32_t frameIndex;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            frameIndex = mNextFrameIndex++;
+            mQueuedFrames.push_back(std::make_pair(frameIndex, pFrame));
+            mStats.submittedFrames++;
+            mStats.queueDepth = (uint32_t)mQueuedFrames.size() + mWritingCount;
+            mStats.maxQueueDepth = std::max(mStats.maxQueueDepth, mStats.queueDepth);
+        }
+        mFrameQueuedCV.notify_one();
+        return frameIndex;
+    }
+
+    void ImageSequenceWriter::dropFrame(uint8_t* pFrame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFreeFrames.push_back(pFrame);
+            mStats.submittedFrames++;
+            mStats.failedFrames++;
+        }
+        mFrameFreedCV.notify_all();
+    }
+
+    uint32_t ImageSequenceWriter::appendFrame(const void* pData)
+    {
+        uint8_t* pFrame = acquireFrame();
+        memcpy(pFrame, pData, getFrameSize());
+        return submitFrame(pFrame);
+    }
+
+    bool ImageSequenceWriter::writeFrame(uint32_t frameIndex, const uint8_t* pData) const
+    {
+        std::string filename = getFilename(frameIndex);
+        switch(mDesc.format)
+        {
+        case FileFormat::Raw:
+            {
+                std::ofstream file(filename, std::ios::binary);
+                file.write((const char*)pData, getFrameSize());
+                return file.good();
+            }
+        case FileFormat::Png:
+            return Bitmap::saveImage(filename, mDesc.width, mDesc.height, Bitmap::FileFormat::PngFile, mDesc.bytesPerPixel, mDesc.isTopDown, const_cast<uint8_t*>(pData), mDesc.compressionLevel);
+        case FileFormat::Pfm:
+            return Bitmap::saveImage(filename, mDesc.width, mDesc.height, Bitmap::FileFormat::PfmFile, mDesc.bytesPerPixel, mDesc.isTopDown, const_cast<uint8_t*>(pData), mDesc.compressionLevel);
+        case FileFormat::Exr:
+            return Bitmap::saveImage(filename, mDesc.width, mDesc.height, Bitmap::FileFormat::ExrFile, mDesc.bytesPerPixel, mDesc.isTopDown, const_cast<uint8_t*>(pData), mDesc.compressionLevel);
+        default:
+            should_not_get_here();
+            return false;
+        }
+    }
+
+    void ImageSequenceWriter::workerFunc()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(true)
+        {
+            mFrameQueuedCV.wait(lock, [this] {return mStopping || mQueuedFrames.empty() == false; });
+            if(mQueuedFrames.empty())
+            {
+                // Stopping and the queue was drained
+                break;
+            }
+
+            auto frame = mQueuedFrames.front();
+            mQueuedFrames.pop_front();
+            mWritingCount++;
+
+            lock.unlock();
+            auto start = CpuTimer::getCurrentTimePoint();
+            bool success = writeFrame(frame.first, frame.second);
+            double writeTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            lock.lock();
+
+            mWritingCount--;
+            mFreeFrames.push_back(frame.second);
+            mStats.writeTimeInMs += writeTime;
+            if(success)
+            {
+                mStats.writtenFrames++;
+            }
+            else
+            {
+                mStats.failedFrames++;
+                Logger::log(Logger::Level::Error, "ImageSequenceWriter - failed to write " + getFilename(frame.first));
+            }
+            mStats.queueDepth = (uint32_t)mQueuedFrames.size() + mWritingCount;
+            // flush() waits on the same condition, so wake everyone
+            mFrameFreedCV.notify_all();
+        }
+    }
+
+    void ImageSequenceWriter::flush()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mFrameFreedCV.wait(lock, [this] {return mQueuedFrames.empty() && (mWritingCount == 0); });
+    }
+
+    ImageSequenceWriter::Stats ImageSequenceWriter::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Utils/Bitmap.h"
+
+namespace Falcor
+{
+    /** Writes a sequence of images to disk using a pool of worker threads.
+        Frames are copied into a bounded queue and compressed in parallel. Each frame is numbered when it's submitted, so the file names follow the submission order no matter which worker writes the file.
+    */
+    class ImageSequenceWriter
+    {
+    public:
+        using UniquePtr = std::unique_ptr<ImageSequenceWriter>;
+        using UniqueConstPtr = std::unique_ptr<const ImageSequenceWriter>;
+
+        enum class FileFormat
+        {
+            Png,    ///< 8-bit PNG. Frames must have 4 bytes per pixel.
+            Pfm,    ///< HDR PFM. Frames must have 12 or 16 bytes per pixel (32-bit float RGB/RGBA).
+            Exr,    ///< HDR OpenEXR. Same input as Pfm.
+            Raw,    ///< The frame memory as-is, without a header
+        };
+
+        struct Desc
+        {
+            std::string directory;              ///< Output directory. Must exist. If empty, the executable directory is used.
+            std::string prefix = "frame";       ///< File name prefix. Files are named <prefix><index>.<extension>.
+            uint32_t digitCount = 6;            ///< Minimum number of digits in the frame index. The index is padded with zeros.
+            uint32_t firstFrameIndex = 0;
+            FileFormat format = FileFormat::Png;
+            int32_t compressionLevel = -1;      ///< See Bitmap#saveImage(). -1 uses the format's default.
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t bytesPerPixel = 4;
+            bool isTopDown = false;             ///< Memory layout of the frames. See Bitmap#saveImage().
+            uint32_t threadCount = 0;           ///< Number of worker threads. 0 uses one thread per core, minus one for the caller.
+            uint32_t queueSize = 0;             ///< Number of frame buffers. Bounds the memory usage. 0 uses twice the thread count.
+        };
+
+        struct Stats
+        {
+            uint64_t submittedFrames = 0;
+            uint64_t writtenFrames = 0;
+            uint64_t failedFrames = 0;
+            uint32_t queueDepth = 0;        ///< Frames submitted but not written yet
+            uint32_t maxQueueDepth = 0;
+            double blockedTimeInMs = 0;     ///< Total time the caller waited for a free frame buffer
+            double writeTimeInMs = 0;       ///< Total time spent compressing and writing, summed over all workers
+        };
+
+        /** Create a new object
+            \return A new object, or nullptr if the description is invalid
+        */
+        static UniquePtr create(const Desc& desc);
+
+        /** Destructor. Writes the remaining frames and stops the workers.
+        */
+        ~ImageSequenceWriter();
+
+        /** Get a free frame buffer of getFrameSize() bytes. Blocks if all the buffers are in use. The buffer must be passed to submitFrame().
+        */
+        uint8_t* acquireFrame();
+
+        /** Queue a buffer returned by acquireFrame() for writing
+            \return The index of the frame, which determines its file name
+        */
+        uint32_t submitFrame(uint8_t* pFrame);
+
+        /** Return a buffer from acquireFrame() without writing it, for example because it couldn't be filled. The frame is counted as failed and doesn't use a frame index.
+        */
+        void dropFrame(uint8_t* pFrame);
+
+        /** Copy a frame and queue it for writing
+            \return The index of the frame, which determines its file name
+        */
+        uint32_t appendFrame(const void* pData);
+
+        /** Wait until all the submitted frames were written
+        */
+        void flush();
+
+        /** Get the file name of a frame
+        */
+        std::string getFilename(uint32_t frameIndex) const;
+
+        /** Get the size of a frame in bytes
+        */
+        uint32_t getFrameSize() const { return mDesc.width * mDesc.height * mDesc.bytesPerPixel; }
+
+        /** Get the statistics
+        */
+        Stats getStats() const;
+
+    private:
+        ImageSequenceWriter(const Desc& desc);
+        void workerFunc();
+        bool writeFrame(uint32_t frameIndex, const uint8_t* pData) const;
+
+        Desc mDesc;
+        std::vector<std::vector<uint8_t>> mFrameStorage;
+        std::vector<uint8_t*> mFreeFrames;
+        std::deque<std::pair<uint32_t, uint8_t*>> mQueuedFrames;
+        uint32_t mNextFrameIndex = 0;
+        uint32_t mWritingCount = 0;
+        bool mStopping = false;
+        Stats mStats;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mFrameQueuedCV;
+        std::condition_variable mFrameFreedCV;
+        std::vector<std::thread> mWorkers;
+    };
+}
\ No newline at end of file
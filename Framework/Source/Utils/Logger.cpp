@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "Logger.h"
 #include "Utils/OS.h"
+#include <mutex>
 
 namespace Falcor
 {
@@ -40,6 +41,7 @@ namespace Falcor
     // FIXME: global variables...
     static bool gInit = false;
     static FILE* gLogFile = nullptr;
+    static std::mutex gLogMutex;    // Loaders log from worker threads
 
     static FILE* openLogFile()
     {
@@ -109,6 +111,7 @@ namespace Falcor
     void Logger::log(Level L, const std::string& msg, const bool forceMsgBox /* = false*/)
     {
 #if _LOG_ENABLED
+        std::unique_lock<std::mutex> lock(gLogMutex);
         if(gInit)
         {
             fprintf_s(gLogFile, "%-12s", getLogLevelString(L));
@@ -116,6 +119,7 @@ namespace Falcor
             fprintf_s(gLogFile, "\n");
             fflush(gLogFile);   // Slows down execution, but ensures that the message will be printed in case of a crash
         }
+        lock.unlock();
 #endif
 
         if(L >= Level::Error)
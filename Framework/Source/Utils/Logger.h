@@ -66,7 +66,7 @@ namespace Falcor
         */
         static bool isBoxShownOnError() { return sShowErrorBox; }
 
-        /** Write a message to the log.
+        /** Write a message to the log. Can be called from any thread.
             \param[in] L Message level
             \param[in] Msg The message to write
         */
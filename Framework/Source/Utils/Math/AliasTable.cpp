@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AliasTable.h"
+
+namespace Falcor
+{
+    static_assert(sizeof(AliasTable::Entry) == 2 * sizeof(uint32_t), "AliasTable::Entry should be tightly packed for GPU upload");
+
+    AliasTable::SharedPtr AliasTable::create(const std::vector<float>& weights)
+    {
+        if(weights.empty())
+        {
+            Logger::log(Logger::Level::Error, "AliasTable::create() - can't create a table without weights");
+            return nullptr;
+        }
+        return SharedPtr(new AliasTable(weights));
+    }
+
+    AliasTable::AliasTable(const std::vector<float>& weights)
+    {
+        const uint32_t count = (uint32_t)weights.size();
+        mEntries.resize(count);
+        mProbabilities.resize(count);
+
+        // Accumulate in double, tables for large meshes have a lot of small weights
+        double sum = 0;
+        for(float w : weights)
+        {
+            assert(w >= 0);
+            sum += w;
+        }
+        mWeightSum = (float)sum;
+
+        if(sum <= 0)
+        {
+            Logger::log(Logger::Level::Warning, "AliasTable - all of the weights are zero. Using a uniform distribution.");
+            for(uint32_t i = 0; i < count; i++)
+            {
+                mEntries[i] = {1.0f, i};
+                mProbabilities[i] = 1.0f / count;
+            }
+            return;
+        }
+
+        // Vose's algorithm. Scale the probabilities so that the average bucket holds 1, then pair each under-full bucket with an over-full one
+        std::vector<double> scaled(count);
+        std::vector<uint32_t> underfull;
+        std::vector<uint32_t> overfull;
+        underfull.reserve(count);
+        overfull.reserve(count);
+
+        for(uint32_t i = 0; i < count; i++)
+        {
+            mProbabilities[i] = (float)(weights[i] / sum);
+            scaled[i] = weights[i] * count / sum;
+            if(scaled[i] < 1.0)
+            {
+                underfull.push_back(i);
+            }
+            else
+            {
+                overfull.push_back(i);
+            }
+        }
+
+        while(underfull.empty() == false && overfull.empty() == false)
+        {
+            uint32_t s = underfull.back();
+            underfull.pop_back();
+            uint32_t l = overfull.back();
+
+            mEntries[s] = {(float)scaled[s], l};
+            scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+            if(scaled[l] < 1.0)
+            {
+                overfull.pop_back();
+                underfull.push_back(l);
+            }
+        }
+
+        // Whatever is left is full up to floating-point error
+        for(uint32_t i : overfull)
+        {
+            mEntries[i] = {1.0f, i};
+        }
+        for(uint32_t i : underfull)
+        {
+            mEntries[i] = {1.0f, i};
+        }
+    }
+
+    uint32_t AliasTable::sample(float u) const
+    {
+        const uint32_t count = getCount();
+        float x = u * count;
+        uint32_t index = std::min((uint32_t)x, count - 1);
+        float remainder = x - (float)index;
+        const Entry& e = mEntries[index];
+        return (remainder < e.threshold) ? index : e.alias;
+    }
+
+    uint32_t AliasTable::sample(float u0, float u1) const
+    {
+        const uint32_t count = getCount();
+        uint32_t index = std::min((uint32_t)(u0 * count), count - 1);
+        const Entry& e = mEntries[index];
+        return (u1 < e.threshold) ? index : e.alias;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <memory>
+
+namespace Falcor
+{
+    /** Walker/Vose alias table for O(1) sampling of a discrete distribution.
+        The table is built on the CPU. Each entry is 8 bytes, so the entries can be uploaded to the GPU as-is.
+    */
+    class AliasTable
+    {
+    public:
+        using SharedPtr = std::shared_ptr<AliasTable>;
+        using SharedConstPtr = std::shared_ptr<const AliasTable>;
+
+        /** A single bucket of the table. A bucket is chosen uniformly, then either the bucket itself or its alias is returned.
+        */
+        struct Entry
+        {
+            float threshold;    ///< Probability of keeping the bucket's own index
+            uint32_t alias;     ///< Index to return otherwise
+        };
+
+        /** Create an alias table
+            \param[in] weights Non-negative, unnormalized weights. If all of the weights are zero, the table falls back to a uniform distribution.
+            \return A new object, or nullptr if the weights vector is empty
+        */
+        static SharedPtr create(const std::vector<float>& weights);
+
+        /** Sample an index using a single uniform random number in [0, 1)
+        */
+        uint32_t sample(float u) const;
+
+        /** Sample an index using two uniform random numbers in [0, 1). Uses all the bits of both numbers, so is better suited for large tables.
+        */
+        uint32_t sample(float u0, float u1) const;
+
+        /** Get the normalized probability of an index
+        */
+        float getProbability(uint32_t index) const { return mProbabilities[index]; }
+
+        /** Get the number of entries in the table
+        */
+        uint32_t getCount() const { return (uint32_t)mEntries.size(); }
+
+        /** Get the sum of the weights the table was created with
+        */
+        float getWeightSum() const { return mWeightSum; }
+
+        /** Get the table entries
+        */
+        const std::vector<Entry>& getEntries() const { return mEntries; }
+
+    private:
+        AliasTable(const std::vector<float>& weights);
+        std::vector<Entry> mEntries;
+        std::vector<float> mProbabilities;
+        float mWeightSum = 0;
+    };
+}
\ No newline at end of file
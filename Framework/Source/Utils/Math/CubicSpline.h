@@ -26,6 +26,8 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <algorithm>
+#include <vector>
 
 namespace Falcor
 {
@@ -33,52 +35,92 @@ namespace Falcor
     class CubicSpline
     {
     public:
-        CubicSpline(const T* controlPoints, uint32_t pointCount)
+        CubicSpline(const T* controlPoints, uint32_t pointCount) : mPoints(controlPoints, controlPoints + pointCount)
         {
             // The following code is based on the article from http://graphicsrunner.blogspot.co.uk/2008/05/camera-animation-part-ii.html
-            static const T kHalf  = T(0.5f);
+            // The intermediate results of the tridiagonal solve are kept, so that setControlPoint() can update them
             static const T kOne = T(1);
             static const T kTwo = T(2);
-            static const T kThree = T(3);
             static const T kFour = T(4);
 
             // Calculate Gamma
-            std::vector<T> gamma(pointCount);
-            gamma[0] = kHalf;
+            mGamma.resize(pointCount);
+            mGamma[0] = T(0.5f);
             for(uint32_t i = 1; i < pointCount - 1; i++)
             {
-                gamma[i] = kOne / (kFour - gamma[i - 1]);
+                mGamma[i] = kOne / (kFour - mGamma[i - 1]);
             }
-            gamma[pointCount - 1] = kOne / (kTwo - gamma[pointCount - 2]);
+            mGamma[pointCount - 1] = kOne / (kTwo - mGamma[pointCount - 2]);
 
             // Calculate Delta
-            std::vector<T> delta(pointCount);
-            delta[0] = kThree * (controlPoints[1] - controlPoints[0]) * gamma[0];
-
-            for(uint32_t i = 1; i < pointCount; i++)
+            mDelta.resize(pointCount);
+            for(uint32_t i = 0; i < pointCount; i++)
             {
-                uint32_t index = (i == (pointCount - 1)) ? i : i + 1;
-                delta[i] = (kThree * (controlPoints[index] - controlPoints[i - 1]) - delta[i - 1]) * gamma[i];
+                mDelta[i] = calcDelta(i);
             }
 
             // Calculate D
-            std::vector<T> D(pointCount);
-            D[pointCount - 1] = delta[pointCount - 1];
-
-            for(int32_t i = int32_t(pointCount - 2); i >= 0; i--)
+            mD.resize(pointCount);
+            for(int32_t i = int32_t(pointCount - 1); i >= 0; i--)
             {
-                D[i] = delta[i] - gamma[i] * D[i + 1];
+                mD[i] = calcD(i);
             }
 
             // Calculate the coefficients
             mCoefficient.resize(pointCount - 1);
-
             for(uint32_t i = 0; i < pointCount - 1; i++)
             {
-                mCoefficient[i].a = controlPoints[i];
-                mCoefficient[i].b = D[i];
-                mCoefficient[i].c = kThree * (controlPoints[i + 1] - controlPoints[i]) - kTwo * D[i] - D[i + 1];
-                mCoefficient[i].d = kTwo * (controlPoints[i] - controlPoints[i + 1]) + D[i] + D[i + 1];
+                updateCoefficient(i);
+            }
+        }
+
+        /** Move a control point of a spline created with the uniform constructor, and update the coefficients.
+            The solve is redone from the point outwards and stops where the intermediate values no longer change. The result is the same as rebuilding the spline, but since the influence of a point decays quickly, an edit usually touches a few dozen sections instead of all of them.
+            \param[in] index The control point index
+            \param[in] value The new control point
+            \param[out] firstSection The first section whose coefficients were updated
+            \param[out] lastSection The last section whose coefficients were updated
+        */
+        void setControlPoint(uint32_t index, const T& value, uint32_t& firstSection, uint32_t& lastSection)
+        {
+            assert(mPoints.size() >= 2);
+            const uint32_t pointCount = (uint32_t)mPoints.size();
+            mPoints[index] = value;
+
+            // Delta[i] depends on the points around i and on Delta[i - 1]. Past the points which use the edited one, stop once a value comes out unchanged.
+            const uint32_t deltaBegin = (index > 0) ? index - 1 : 0;
+            uint32_t deltaEnd = deltaBegin;
+            while(deltaEnd < pointCount)
+            {
+                T delta = calcDelta(deltaEnd);
+                if(deltaEnd > index + 1 && delta == mDelta[deltaEnd])
+                {
+                    break;
+                }
+                mDelta[deltaEnd] = delta;
+                deltaEnd++;
+            }
+
+            // D[i] depends on Delta[i] and D[i + 1], so it's unchanged from deltaEnd on. Below deltaBegin, stop once a value comes out unchanged.
+            int32_t dBegin = int32_t(deltaEnd) - 1;
+            while(dBegin >= 0)
+            {
+                T d = calcD(dBegin);
+                if(dBegin < int32_t(deltaBegin) && d == mD[dBegin])
+                {
+                    break;
+                }
+                mD[dBegin] = d;
+                dBegin--;
+            }
+            dBegin++;
+
+            // A section uses the points and D values at both of its ends
+            firstSection = (uint32_t)(std::max)((std::min)(dBegin, int32_t(index)) - 1, 0);
+            lastSection = (std::min)((std::max)(deltaEnd - 1, index), pointCount - 2);
+            for(uint32_t i = firstSection; i <= lastSection; i++)
+            {
+                updateCoefficient(i);
             }
         }
 
@@ -134,11 +176,50 @@ namespace Falcor
             T result = (((coeff.d * point) + coeff.c) * point + coeff.b) * point + coeff.a;
             return result;
         }
-    private:
+
+        /** The polynomial of a section, evaluated as ((d * t + c) * t + b) * t + a
+        */
         struct CubicCoeff
         {
             T a, b, c, d;
         };
+
+        const CubicCoeff& getCoefficients(uint32_t section) const { return mCoefficient[section]; }
+        uint32_t getSectionCount() const { return (uint32_t)mCoefficient.size(); }
+
+    private:
+        T calcDelta(uint32_t i) const
+        {
+            static const T kThree = T(3);
+            if(i == 0)
+            {
+                return kThree * (mPoints[1] - mPoints[0]) * mGamma[0];
+            }
+            uint32_t index = (i == (mPoints.size() - 1)) ? i : i + 1;
+            return (kThree * (mPoints[index] - mPoints[i - 1]) - mDelta[i - 1]) * mGamma[i];
+        }
+
+        T calcD(uint32_t i) const
+        {
+            return (i == mPoints.size() - 1) ? mDelta[i] : mDelta[i] - mGamma[i] * mD[i + 1];
+        }
+
+        void updateCoefficient(uint32_t i)
+        {
+            static const T kTwo = T(2);
+            static const T kThree = T(3);
+            mCoefficient[i].a = mPoints[i];
+            mCoefficient[i].b = mD[i];
+            mCoefficient[i].c = kThree * (mPoints[i + 1] - mPoints[i]) - kTwo * mD[i] - mD[i + 1];
+            mCoefficient[i].d = kTwo * (mPoints[i] - mPoints[i + 1]) + mD[i] + mD[i + 1];
+        }
+
         std::vector<CubicCoeff> mCoefficient;
+
+        // State of the uniform solve. Empty for splines created with durations.
+        std::vector<T> mPoints;
+        std::vector<T> mGamma;
+        std::vector<T> mDelta;
+        std::vector<T> mD;
     };
 }
\ No newline at end of file
@@ -29,15 +29,31 @@
 #include "ParallelReduction.h"
 #include "Graphics/FboHelper.h"
 #include "Core/RenderContext.h"
+#include "Core/Texture.h"
 #include "glm/vec2.hpp"
+#include <cfloat>
+#include <cmath>
 
 namespace Falcor
 {
     const char* fsFilename = "Framework/ParallelReduction.fs";
 
-    ParallelReduction::ParallelReduction(ParallelReduction::Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height) : mReductionType(reductionType)
+    uint32_t ParallelReduction::getResultCount(Type reductionType, uint32_t histogramBinCount)
     {
-        ResourceFormat texFormat;
+        switch(reductionType)
+        {
+        case Type::ChannelMinMax:
+            return 2;
+        case Type::Histogram:
+            return histogramBinCount / 4;
+        default:
+            return 1;
+        }
+    }
+
+    ParallelReduction::ParallelReduction(ParallelReduction::Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t histogramBinCount) : mReductionType(reductionType)
+    {
+        ResourceFormat texFormat = ResourceFormat::RGBA32Float;
         Program::DefineList defines;
         defines.add("_TILE_SIZE", std::to_string(kTileSize));
         switch(reductionType)
@@ -46,11 +62,31 @@ namespace Falcor
            texFormat = ResourceFormat::RG32Float;
            defines.add("_MIN_MAX_REDUCTION");
            break;
+        case Type::ChannelMinMax:
+            defines.add("_CHANNEL_MIN_MAX_REDUCTION");
+            break;
+        case Type::Sum:
+        case Type::Average:
+            defines.add("_SUM_REDUCTION");
+            break;
+        case Type::LogAverageLuminance:
+            defines.add("_LOG_LUMINANCE_REDUCTION");
+            break;
+        case Type::Histogram:
+            defines.add("_HISTOGRAM_REDUCTION");
+            defines.add("_BIN_COUNT", std::to_string(histogramBinCount));
+            break;
         default:
             should_not_get_here();
             return;
         }
 
+        mResultCount = getResultCount(reductionType, histogramBinCount);
+        mPixelCount = width * height;
+        mResults.assign(mResultCount, glm::vec4(0));
+        defines.add("_TARGET_COUNT", std::to_string(mResultCount));
+        std::vector<ResourceFormat> formats(mResultCount, texFormat);
+
         Sampler::Desc samplerDesc;
         samplerDesc.setAddressingMode(Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp, Sampler::AddressMode::Clamp).setFilterMode(Sampler::Filter::Point, Sampler::Filter::Point, Sampler::Filter::Point).setLodParams(0, 0, 0);
         mpPointSampler = Sampler::create(samplerDesc);
@@ -58,7 +94,7 @@ namespace Falcor
         mpResultFbo.resize(readbackLatency + 1);
         for(auto& pFbo : mpResultFbo)
         {
-            pFbo = FboHelper::create2D(1, 1, &texFormat);
+            pFbo = FboHelper::create2D(1, 1, formats.data(), 1, mResultCount);
         }
         mpFirstIterProg = FullScreenPass::create(fsFilename, defines);
         mpFirstIterProg->getProgram()->addDefine("_FIRST_ITERATION");
@@ -76,20 +112,27 @@ namespace Falcor
                 width = max(width, 1u);
                 height = max(height, 1u);
 
-                mpTmpResultFbo.push_back(FboHelper::create2D(width, height, &texFormat));
+                mpTmpResultFbo.push_back(FboHelper::create2D(width, height, formats.data(), 1, mResultCount));
             }
         }
     }
 
-    ParallelReduction::UniquePtr ParallelReduction::create(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height)
+    ParallelReduction::UniquePtr ParallelReduction::create(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t histogramBinCount)
     {
-        return ParallelReduction::UniquePtr(new ParallelReduction(reductionType, readbackLatency, width, height));
+        if(reductionType == Type::Histogram && (histogramBinCount < 4 || histogramBinCount > 32 || (histogramBinCount % 4) != 0))
+        {
+            Logger::log(Logger::Level::Error, "ParallelReduction::create() - unsupported histogram bin count " + std::to_string(histogramBinCount) + ". The bin count must be a multiple of 4 in the range [4, 32].");
+            return nullptr;
+        }
+        return ParallelReduction::UniquePtr(new ParallelReduction(reductionType, readbackLatency, width, height, histogramBinCount));
     }
 
-    void runProgram(RenderContext* pRenderCtx, const Texture* pInput, const FullScreenPass* pProgram, Fbo::SharedPtr pDst, UniformBuffer::SharedPtr pUbo, Sampler::SharedPtr pPointSampler)
+    static const uint32_t kMaxResultCount = 8;
+
+    void runProgram(RenderContext* pRenderCtx, const Texture* pInputs[], uint32_t inputCount, const FullScreenPass* pProgram, Fbo::SharedPtr pDst, UniformBuffer::SharedPtr pUbo, Sampler::SharedPtr pPointSampler)
     {
-        // Bind the input texture
-        pUbo->setTexture(0, pInput, pPointSampler.get());
+        // Bind the input textures
+        pUbo->setTextureArray("gInputTex", pInputs, pPointSampler.get(), inputCount);
         pRenderCtx->setUniformBuffer(0, pUbo);
 
         // Set draw params
@@ -109,32 +152,126 @@ namespace Falcor
 
     glm::vec4 ParallelReduction::reduce(RenderContext* pRenderCtx, const Texture* pInput)
     {
+        if(mReductionType == Type::Histogram)
+        {
+            mpUbo->setVariable("gHistogramRange", mHistogramRange);
+        }
+
+        // The first pass reads the input texture, the others read all the render-targets of the previous pass
         const FullScreenPass* pProgram = mpFirstIterProg.get();
+        const Texture* pInputs[kMaxResultCount] = {pInput};
+        uint32_t inputCount = 1;
 
         for(size_t i = 0; i < mpTmpResultFbo.size(); i++)
         {
-            runProgram(pRenderCtx, pInput, pProgram, mpTmpResultFbo[i], mpUbo, mpPointSampler);
+            runProgram(pRenderCtx, pInputs, inputCount, pProgram, mpTmpResultFbo[i], mpUbo, mpPointSampler);
             pProgram = mpRestIterProg.get();
-            pInput = mpTmpResultFbo[i]->getColorTexture(0).get();
+            inputCount = mResultCount;
+            for(uint32_t j = 0; j < inputCount; j++)
+            {
+                pInputs[j] = mpTmpResultFbo[i]->getColorTexture(j).get();
+            }
         }
 
-        runProgram(pRenderCtx, pInput, pProgram, mpResultFbo[mCurFbo], mpUbo, mpPointSampler);
+        runProgram(pRenderCtx, pInputs, inputCount, pProgram, mpResultFbo[mCurFbo], mpUbo, mpPointSampler);
 
         // Read back the results
         mCurFbo = (mCurFbo + 1) % mpResultFbo.size();
 
-        uint32_t bytesToRead = 0;
-        glm::vec4 result(0);
+        uint32_t bytesToRead = (mReductionType == Type::MinMax) ? sizeof(glm::vec2) : sizeof(glm::vec4);
+        for(uint32_t i = 0; i < mResultCount; i++)
+        {
+            mResults[i] = glm::vec4(0);
+            mpResultFbo[mCurFbo]->getColorTexture(i)->readSubresourceData(&mResults[i], bytesToRead, 0, 0);
+        }
+
+        // The readback bypasses the render-context
+        pRenderCtx->invalidateApiState();
+
         switch(mReductionType)
         {
+        case Type::Average:
+            mResults[0] /= (float)mPixelCount;
+            break;
+        case Type::LogAverageLuminance:
+            mResults[0].y = mResults[0].x / (float)mPixelCount;
+            mResults[0].x = exp(mResults[0].y);
+            break;
+        default:
+            break;
+        }
+        return mResults[0];
+    }
+
+    void ParallelReduction::reduceCpu(Type reductionType, const float* pTexels, uint32_t width, uint32_t height, std::vector<glm::vec4>& results, uint32_t histogramBinCount, const glm::vec2& histogramRange)
+    {
+        const size_t texelCount = (size_t)width * height;
+        results.assign(getResultCount(reductionType, histogramBinCount), glm::vec4(0));
+
+        // Sums are accumulated in double precision, so the reference is more accurate than the GPU passes
+        glm::dvec4 sum(0);
+        switch(reductionType)
+        {
         case Type::MinMax:
-            bytesToRead = sizeof(glm::vec2);
+            results[0] = glm::vec4(1, 0, 0, 0);
+            for(size_t i = 0; i < texelCount; i++)
+            {
+                float depth = pTexels[i * 4];
+                if(depth != 1.0f)
+                {
+                    results[0].x = min(results[0].x, depth);
+                    results[0].y = max(results[0].y, depth);
+                }
+            }
+            break;
+        case Type::ChannelMinMax:
+            results[0] = glm::vec4(FLT_MAX);
+            results[1] = glm::vec4(-FLT_MAX);
+            for(size_t i = 0; i < texelCount; i++)
+            {
+                glm::vec4 value(pTexels[i * 4], pTexels[i * 4 + 1], pTexels[i * 4 + 2], pTexels[i * 4 + 3]);
+                results[0] = glm::min(results[0], value);
+                results[1] = glm::max(results[1], value);
+            }
+            break;
+        case Type::Sum:
+        case Type::Average:
+            for(size_t i = 0; i < texelCount; i++)
+            {
+                sum += glm::dvec4(pTexels[i * 4], pTexels[i * 4 + 1], pTexels[i * 4 + 2], pTexels[i * 4 + 3]);
+            }
+            if(reductionType == Type::Average && texelCount > 0)
+            {
+                sum /= (double)texelCount;
+            }
+            results[0] = glm::vec4(sum);
+            break;
+        case Type::LogAverageLuminance:
+            for(size_t i = 0; i < texelCount; i++)
+            {
+                float luminance = glm::dot(glm::vec3(pTexels[i * 4], pTexels[i * 4 + 1], pTexels[i * 4 + 2]), glm::vec3(0.299f, 0.587f, 0.114f));
+                sum.x += log(max(0.0001f, luminance));
+            }
+            if(texelCount > 0)
+            {
+                results[0].y = (float)(sum.x / texelCount);
+                results[0].x = exp(results[0].y);
+            }
+            break;
+        case Type::Histogram:
+            for(size_t i = 0; i < texelCount; i++)
+            {
+                // Same math as the shader, so values on bin edges land in the same bins
+                float bin = floor((pTexels[i * 4] - histogramRange.x) / (histogramRange.y - histogramRange.x) * histogramBinCount);
+                if(bin >= 0 && bin < histogramBinCount)
+                {
+                    uint32_t index = (uint32_t)bin;
+                    results[index / 4][index % 4] += 1;
+                }
+            }
             break;
         default:
             should_not_get_here();
         }
-
-        mpResultFbo[mCurFbo]->getColorTexture(0)->readSubresourceData(&result, bytesToRead, 0, 0);
-        return result;
     }
 }
\ No newline at end of file
@@ -37,19 +37,62 @@ namespace Falcor
     class RenderContext;
     class Texture;
 
+    /** Reduces a texture to a few values, with a chain of full-screen passes. Each pass reduces 16x16 tiles of the previous one.
+        The results are read back with a latency of a few calls, so that reduce() doesn't stall the GPU.
+    */
     class ParallelReduction
     {
     public:
         using UniquePtr = std::unique_ptr<ParallelReduction>;
         enum class Type
         {
-            MinMax
+            MinMax,                 ///< Range of a depth-buffer. Depth values of 1 are ignored. The result is (min, max) in x and y, or (1, 0) if all the values are 1.
+            ChannelMinMax,          ///< Per-channel range. The results are the minimum and the maximum.
+            Sum,                    ///< Per-channel sum
+            Average,                ///< Per-channel average
+            LogAverageLuminance,    ///< Geometric mean of the luminance, the average ToneMapping uses. The result is the mean in x and the average log-luminance in y.
+            Histogram,              ///< Histogram of the red channel. The count of bin i is in component (i % 4) of result (i / 4). Counts are exact up to 2^24 texels per bin.
         };
-        static UniquePtr create(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height);
+
+        /** Create a new object
+            \param[in] reductionType The reduction type
+            \param[in] readbackLatency The number of reduce() calls between running a reduction and reading back its results
+            \param[in] width The width of the input textures
+            \param[in] height The height of the input textures
+            \param[in] histogramBinCount The number of bins for Type::Histogram. Must be a multiple of 4 in the range [4, 32].
+        */
+        static UniquePtr create(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t histogramBinCount = 16);
+
+        /** Run the reduction
+            \return The first result of the reduction which ran readbackLatency calls earlier. The other results are available through getResults().
+        */
         glm::vec4 reduce(RenderContext* pRenderCtx, const Texture* pInput);
 
+        /** Get the results read back by the last reduce() call
+        */
+        const std::vector<glm::vec4>& getResults() const { return mResults; }
+
+        /** Set the range of values Type::Histogram distributes between the bins. Values outside [minValue, maxValue) are ignored.
+        */
+        void setHistogramRange(float minValue, float maxValue) { mHistogramRange = glm::vec2(minValue, maxValue); }
+
+        /** Get the number of results a reduction produces
+        */
+        static uint32_t getResultCount(Type reductionType, uint32_t histogramBinCount = 16);
+
+        /** Single-threaded CPU version of the reduction, for testing the GPU results
+            \param[in] reductionType The reduction type
+            \param[in] pTexels The input, tightly packed RGBA32F. For Type::MinMax only the red channel is used.
+            \param[in] width The width of the input
+            \param[in] height The height of the input
+            \param[out] results The results, laid out like getResults()
+            \param[in] histogramBinCount The number of bins for Type::Histogram
+            \param[in] histogramRange The range for Type::Histogram, see setHistogramRange()
+        */
+        static void reduceCpu(Type reductionType, const float* pTexels, uint32_t width, uint32_t height, std::vector<glm::vec4>& results, uint32_t histogramBinCount = 16, const glm::vec2& histogramRange = glm::vec2(0, 1));
+
     private:
-        ParallelReduction(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height);
+        ParallelReduction(Type reductionType, uint32_t readbackLatency, uint32_t width, uint32_t height, uint32_t histogramBinCount);
         FullScreenPass::UniquePtr mpFirstIterProg;
         FullScreenPass::UniquePtr mpRestIterProg;
         UniformBuffer::SharedPtr mpUbo;
@@ -57,6 +100,10 @@ namespace Falcor
         uint32_t mCurFbo = 0;
         Type mReductionType;
         Sampler::SharedPtr mpPointSampler;
+        uint32_t mResultCount;
+        uint32_t mPixelCount;
+        glm::vec2 mHistogramRange = glm::vec2(0, 1);
+        std::vector<glm::vec4> mResults;
 
         std::vector<Fbo::SharedPtr> mpTmpResultFbo;
         static const uint32_t kTileSize = 16;
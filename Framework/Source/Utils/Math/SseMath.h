@@ -0,0 +1,110 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define FALCOR_SSE_MATH_AVAILABLE
+#include <emmintrin.h>
+
+namespace Falcor
+{
+    /** Transcendental functions on 4 floats, for the SSE2 paths of the CPU image and shading code.
+        They use the Cephes polynomials. The relative error is about 1e-7.
+    */
+
+    /** exp(). Results are clamped to the normalized float range.
+    */
+    inline __m128 exp4(__m128 x)
+    {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.3f)), _mm_set1_ps(88.3f));
+
+        // Split into 2^n * exp(r)
+        __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)), _mm_set1_ps(0.5f));
+        __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+        fx = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, fx), _mm_set1_ps(1.f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(0.693359375f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(-2.12194440e-4f)));
+
+        __m128 y = _mm_set1_ps(1.9875691500e-4f);
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.3981999507e-3f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(8.3334519073e-3f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(4.1665795894e-2f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.6666665459e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(5.0000001201e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), x);
+        y = _mm_add_ps(y, _mm_set1_ps(1.f));
+
+        __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127));
+        return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+    }
+
+    /** Natural logarithm. Zero and denormals return log(FLT_MIN), negative inputs and NaNs return NaN.
+    */
+    inline __m128 log4(__m128 x)
+    {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 invalid = _mm_cmpnge_ps(x, _mm_setzero_ps());
+        x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+
+        // Split into 2^e * m, with m in [0.5, 1)
+        __m128i exponent = _mm_srli_epi32(_mm_castps_si128(x), 23);
+        x = _mm_or_ps(_mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000))), _mm_set1_ps(0.5f));
+        __m128 e = _mm_add_ps(_mm_cvtepi32_ps(_mm_sub_epi32(exponent, _mm_set1_epi32(0x7f))), one);
+
+        // Move m to [sqrt(0.5), sqrt(2))
+        __m128 small = _mm_cmplt_ps(x, _mm_set1_ps(0.707106781186547524f));
+        __m128 tmp = _mm_and_ps(x, small);
+        x = _mm_sub_ps(x, one);
+        e = _mm_sub_ps(e, _mm_and_ps(one, small));
+        x = _mm_add_ps(x, tmp);
+
+        __m128 z = _mm_mul_ps(x, x);
+        __m128 y = _mm_set1_ps(7.0376836292e-2f);
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.1514610310e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.1676998740e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.2420140846e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(1.4249322787e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-1.6668057665e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(2.0000714765e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(-2.4999993993e-1f));
+        y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(3.3333331174e-1f));
+        y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+        y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+        y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        x = _mm_add_ps(_mm_add_ps(x, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+        return _mm_or_ps(x, invalid);
+    }
+
+    /** pow() for non-negative bases. pow(0, y) returns 0.
+    */
+    inline __m128 pow4(__m128 x, __m128 y)
+    {
+        return _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), exp4(_mm_mul_ps(y, log4(x))));
+    }
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MemoryMappedFile.h"
+#include <windows.h>
+
+namespace Falcor
+{
+    MemoryMappedFile::UniquePtr MemoryMappedFile::create(const std::string& fullpath, bool copyOnWrite)
+    {
+        HANDLE file = CreateFileA(fullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            Logger::log(Logger::Level::Error, "MemoryMappedFile::create() - can't open file '" + fullpath + "'");
+            return nullptr;
+        }
+
+        LARGE_INTEGER size;
+        if(GetFileSizeEx(file, &size) == FALSE || size.QuadPart == 0 || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+        {
+            // Empty files can't be mapped
+            Logger::log(Logger::Level::Error, "MemoryMappedFile::create() - file '" + fullpath + "' is empty or too large to map");
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        void* pView = mapping ? MapViewOfFile(mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if(pView == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "MemoryMappedFile::create() - can't map file '" + fullpath + "'");
+            if(mapping)
+            {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        UniquePtr pFile = UniquePtr(new MemoryMappedFile);
+        pFile->mFile = file;
+        pFile->mMapping = mapping;
+        pFile->mpData = (uint8_t*)pView;
+        pFile->mSize = (size_t)size.QuadPart;
+        pFile->mIsWritable = copyOnWrite;
+        return pFile;
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        UnmapViewOfFile(mpData);
+        CloseHandle(mMapping);
+        CloseHandle(mFile);
+    }
+
+    void MemoryMappedFile::prefetch(size_t offset, size_t size) const
+    {
+        static const size_t kPageSize = 4096;
+        size_t end = (std::min)(offset + size, mSize);
+        volatile uint8_t sum = 0;
+        for(size_t i = offset; i < end; i += kPageSize)
+        {
+            sum += mpData[i];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <string>
+
+namespace Falcor
+{
+    /** A read-only view of a file, mapped into the address space of the process.
+        Pages are read from disk on first access, so mapping a file is cheap and only the parts which are used are loaded.
+    */
+    class MemoryMappedFile
+    {
+    public:
+        using UniquePtr = std::unique_ptr<MemoryMappedFile>;
+
+        /** Map a file
+            \param[in] fullpath The full path of the file
+            \param[in] copyOnWrite If true, the mapped range is writable. Modified pages are private to the process and are never written back to the file.
+            \return A new object, or nullptr if the file can't be mapped
+        */
+        static UniquePtr create(const std::string& fullpath, bool copyOnWrite);
+        ~MemoryMappedFile();
+
+        /** Get the mapped data
+        */
+        const uint8_t* getData() const { return mpData; }
+
+        /** Get the mapped data for writing. Only valid for files mapped with copyOnWrite.
+        */
+        uint8_t* getWritableData() { assert(mIsWritable); return mpData; }
+
+        /** Get the size of the file in bytes
+        */
+        size_t getSize() const { return mSize; }
+
+        /** Touch every page in a range, so that the disk reads happen on the calling thread instead of the first thread which accesses the data
+        */
+        void prefetch(size_t offset, size_t size) const;
+
+    private:
+        MemoryMappedFile() = default;
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        void* mFile = nullptr;
+        void* mMapping = nullptr;
+        uint8_t* mpData = nullptr;
+        size_t mSize = 0;
+        bool mIsWritable = false;
+    };
+}
\ No newline at end of file
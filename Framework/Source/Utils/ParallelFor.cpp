@@ -0,0 +1,85 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ParallelFor.h"
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+namespace Falcor
+{
+    uint32_t getParallelThreadCount()
+    {
+        static const uint32_t sThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        return sThreadCount;
+    }
+
+    void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& func)
+    {
+        if(count == 0)
+        {
+            return;
+        }
+        grainSize = std::max(1u, grainSize);
+
+        const uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+        const uint32_t threadCount = std::min(getParallelThreadCount(), chunkCount);
+        if(threadCount <= 1)
+        {
+            func(0, count);
+            return;
+        }
+
+        // Threads pull chunks from a shared counter, so uneven work balances itself
+        std::atomic<uint32_t> nextChunk(0);
+        auto worker = [&]()
+        {
+            for(uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+            {
+                uint32_t begin = chunk * grainSize;
+                uint32_t end = std::min(begin + grainSize, count);
+                func(begin, end);
+            }
+        };
+
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(threadCount - 1);
+        for(uint32_t i = 0; i < threadCount - 1; i++)
+        {
+            tasks.push_back(std::async(std::launch::async, worker));
+        }
+        worker();
+
+        for(auto& t : tasks)
+        {
+            t.get();
+        }
+    }
+}
\ No newline at end of file
@@ -112,17 +112,36 @@ namespace Falcor
 
     void Profiler::endFrame(std::string& profileResults)
     {
+        std::vector<EventTimes> events;
+        endFrame(events);
+
         profileResults = "Name\t\t\tCPU time(ms)\t\t\tGPU time(ms)\n";
+        for(const EventTimes& times : events)
+        {
+			char event[1000];
+			uint32_t nameIndent = times.level * 2 + 1;
+			uint32_t cpuIndent = 32 - (nameIndent + (uint32_t)times.name.size());
+			sprintf_s(event, "%#*s%s %*.3f %36.3f\n", nameIndent, " ", times.name.c_str(), cpuIndent, times.cpuMs, times.gpuMs);
+            profileResults += event;
+        }
+    }
+
+    void Profiler::endFrame(std::vector<EventTimes>& events)
+    {
+        events.clear();
+        events.reserve(sProfilerVector.size());
 
 		for (EventData* pData : sProfilerVector)
 		{
 			float gpuTime = pData->gpuTotal;
 			pData->pGpuTimer[1 - sGpuTimerIndex]->getElapsedTime(true, gpuTime);
 
-			char event[1000];
-			uint32_t nameIndent = pData->level * 2 + 1;
-			uint32_t cpuIndent = 32 - (nameIndent + (uint32_t)pData->name.size());
-			sprintf_s(event, "%#*s%s %*.3f %36.3f\n", nameIndent, " ", pData->name.c_str(), cpuIndent, pData->cpuTotal, gpuTime);
+            EventTimes times;
+            times.name = pData->name;
+            times.level = pData->level;
+            times.cpuMs = pData->cpuTotal;
+            times.gpuMs = gpuTime;
+            events.push_back(times);
 #if _PROFILING_LOG == 1
 			pData->cpuMs[pData->stepNr] = pData->cpuTotal;
 			pData->gpuMs[pData->stepNr] = gpuTime;
@@ -143,7 +162,6 @@ namespace Falcor
 #endif
             pData->cpuTotal = 0;
 			pData->gpuTotal = 0;
-            profileResults += event;
         }
 
         sGpuTimerIndex = 1 - sGpuTimerIndex;
@@ -82,6 +82,16 @@ namespace Falcor
 #endif
         };
 
+        /** The timings of an event in a single frame
+        */
+        struct EventTimes
+        {
+            std::string name;
+            uint32_t level;     ///< Nesting depth of the event
+            float cpuMs;
+            float gpuMs;
+        };
+
         /** Start profiling a new event and update the events hierarchies.
             \param[in] Name The event name.
         */
@@ -111,6 +121,12 @@ namespace Falcor
         */
         static void endFrame(std::string& profileResults);
 
+        /** Finish profiling for the entire frame and get the timings of each event, in the order the events were first seen.
+            Like the other version, the GPU times are for the previous frame.
+            \param[out] events The event timings. The vector is overwritten.
+        */
+        static void endFrame(std::vector<EventTimes>& events);
+
 		/** Create a new event and register and initialize it using \ref initNewEvent.
 		*/
 		static EventData* createNewEvent(const HashedString& name);
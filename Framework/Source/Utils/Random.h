@@ -0,0 +1,63 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** A small deterministic pseudo-random number generator. It's a 32-bit linear congruential generator, with the same constants as rand_next() in ShadingUtils/Helpers.h.
+        The sequence only depends on the seed, which makes it a good fit for reproducible test data. The low bits are weak, so it shouldn't be used for Monte Carlo sampling.
+    */
+    class RandomGenerator
+    {
+    public:
+        /** Constructor
+            \param[in] seed The initial state
+        */
+        RandomGenerator(uint32_t seed = 1) : mState(seed) {}
+
+        /** Get the next 32-bit number
+        */
+        uint32_t next()
+        {
+            mState = mState * 1664525u + 1013904223u;
+            return mState;
+        }
+
+        /** Get a uniform float in [0, 1). Uses the 24 high bits.
+        */
+        float nextFloat() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+        /** Get a uniform float in [minValue, maxValue)
+        */
+        float nextFloat(float minValue, float maxValue) { return minValue + nextFloat() * (maxValue - minValue); }
+
+    private:
+        uint32_t mState;
+    };
+}
@@ -0,0 +1,193 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RangeAllocator.h"
+
+namespace Falcor
+{
+    RangeAllocator::RangeAllocator(uint64_t capacity) : mCapacity(capacity)
+    {
+        if(capacity > 0)
+        {
+            insertFreeRange(0, capacity);
+        }
+    }
+
+    void RangeAllocator::insertFreeRange(uint64_t offset, uint64_t size)
+    {
+        mFreeByOffset[offset] = size;
+        mFreeBySize.insert(std::make_pair(size, offset));
+    }
+
+    void RangeAllocator::eraseFreeRange(std::map<uint64_t, uint64_t>::iterator it)
+    {
+        mFreeBySize.erase(std::make_pair(it->second, it->first));
+        mFreeByOffset.erase(it);
+    }
+
+    uint64_t RangeAllocator::allocate(uint64_t size)
+    {
+        if(size == 0)
+        {
+            return kInvalidOffset;
+        }
+
+        // Best fit - the smallest free range which is large enough. Ties are broken by the lowest offset.
+        auto bestIt = mFreeBySize.lower_bound(std::make_pair(size, uint64_t(0)));
+        if(bestIt == mFreeBySize.end())
+        {
+            return kInvalidOffset;
+        }
+
+        uint64_t offset = bestIt->second;
+        uint64_t freeSize = bestIt->first;
+        eraseFreeRange(mFreeByOffset.find(offset));
+        if(freeSize > size)
+        {
+            insertFreeRange(offset + size, freeSize - size);
+        }
+
+        mAllocations[offset] = size;
+        mUsedSize += size;
+        return offset;
+    }
+
+    bool RangeAllocator::release(uint64_t offset)
+    {
+        auto allocIt = mAllocations.find(offset);
+        if(allocIt == mAllocations.end())
+        {
+            return false;
+        }
+
+        uint64_t size = allocIt->second;
+        mAllocations.erase(allocIt);
+        mUsedSize -= size;
+
+        // Merge with the next free range
+        auto nextIt = mFreeByOffset.find(offset + size);
+        if(nextIt != mFreeByOffset.end())
+        {
+            size += nextIt->second;
+            eraseFreeRange(nextIt);
+        }
+
+        // Merge with the previous free range
+        auto prevIt = mFreeByOffset.lower_bound(offset);
+        if(prevIt != mFreeByOffset.begin())
+        {
+            --prevIt;
+            if(prevIt->first + prevIt->second == offset)
+            {
+                offset = prevIt->first;
+                size += prevIt->second;
+                eraseFreeRange(prevIt);
+            }
+        }
+
+        insertFreeRange(offset, size);
+        return true;
+    }
+
+    void RangeAllocator::grow(uint64_t capacity)
+    {
+        if(capacity <= mCapacity)
+        {
+            return;
+        }
+
+        uint64_t offset = mCapacity;
+        uint64_t size = capacity - mCapacity;
+        mCapacity = capacity;
+
+        // Extend the last free range if it ends at the old capacity
+        if(mFreeByOffset.empty() == false)
+        {
+            auto lastIt = std::prev(mFreeByOffset.end());
+            if(lastIt->first + lastIt->second == offset)
+            {
+                offset = lastIt->first;
+                size += lastIt->second;
+                eraseFreeRange(lastIt);
+            }
+        }
+        insertFreeRange(offset, size);
+    }
+
+    std::vector<RangeAllocator::Relocation> RangeAllocator::defragment()
+    {
+        std::vector<Relocation> relocations;
+        std::map<uint64_t, uint64_t> packed;
+        uint64_t dstOffset = 0;
+
+        // mAllocations is sorted by offset, so every destination is at or before its source and before the sources of all the following ranges
+        for(const auto& a : mAllocations)
+        {
+            if(a.first != dstOffset)
+            {
+                Relocation r;
+                r.srcOffset = a.first;
+                r.dstOffset = dstOffset;
+                r.size = a.second;
+                relocations.push_back(r);
+            }
+            packed[dstOffset] = a.second;
+            dstOffset += a.second;
+        }
+
+        mAllocations.swap(packed);
+        mFreeByOffset.clear();
+        mFreeBySize.clear();
+        if(dstOffset < mCapacity)
+        {
+            insertFreeRange(dstOffset, mCapacity - dstOffset);
+        }
+        return relocations;
+    }
+
+    uint64_t RangeAllocator::getAllocationSize(uint64_t offset) const
+    {
+        auto it = mAllocations.find(offset);
+        return (it == mAllocations.end()) ? 0 : it->second;
+    }
+
+    uint64_t RangeAllocator::getLargestFreeRange() const
+    {
+        return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+    }
+
+    float RangeAllocator::getFragmentation() const
+    {
+        uint64_t freeSize = getFreeSize();
+        if(freeSize == 0)
+        {
+            return 0;
+        }
+        return 1.0f - float(getLargestFreeRange()) / float(freeSize);
+    }
+}
\ No newline at end of file
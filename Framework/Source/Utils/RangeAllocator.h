@@ -0,0 +1,122 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Falcor
+{
+    /** Free-list allocator for sub-ranges of a linear resource.
+        The allocator only does the bookkeeping. It doesn't own any memory, so the same code manages GPU buffers and CPU arrays. Units are up to the user (bytes, vertices, indices, etc.).
+        Allocations use a best-fit policy and freed ranges are merged with their neighbors.
+    */
+    class RangeAllocator
+    {
+    public:
+        static const uint64_t kInvalidOffset = uint64_t(-1);
+
+        /** Describes a range which was moved by defragment()
+        */
+        struct Relocation
+        {
+            uint64_t srcOffset;     ///< The offset of the range before defragmentation
+            uint64_t dstOffset;     ///< The offset of the range after defragmentation
+            uint64_t size;          ///< The size of the range
+        };
+
+        /** Constructor
+            \param[in] capacity The size of the managed resource
+        */
+        RangeAllocator(uint64_t capacity = 0);
+
+        /** Allocate a range.
+            \param[in] size The size of the range. Must be larger than 0.
+            \return The offset of the new range, or kInvalidOffset if there's no free range large enough.
+        */
+        uint64_t allocate(uint64_t size);
+
+        /** Release a range which was returned by allocate()
+            \param[in] offset The range offset
+            \return false if the offset doesn't match a live allocation, otherwise true
+        */
+        bool release(uint64_t offset);
+
+        /** Increase the capacity of the resource. Existing allocations are not moved.
+            \param[in] capacity The new capacity. Must be at least the current capacity.
+        */
+        void grow(uint64_t capacity);
+
+        /** Pack all live allocations at the start of the resource, leaving a single free range at the end.
+            \return The list of moved ranges, sorted by offset. A range may overlap its own source, but never the source of a later range, so applying the moves in order with memmove() semantics is safe.
+        */
+        std::vector<Relocation> defragment();
+
+        /** Get the size of an allocation, or 0 if the offset doesn't match a live allocation
+        */
+        uint64_t getAllocationSize(uint64_t offset) const;
+
+        /** Get the capacity of the resource
+        */
+        uint64_t getCapacity() const { return mCapacity; }
+
+        /** Get the total size of the live allocations
+        */
+        uint64_t getUsedSize() const { return mUsedSize; }
+
+        /** Get the total size of the free ranges
+        */
+        uint64_t getFreeSize() const { return mCapacity - mUsedSize; }
+
+        /** Get the size of the largest free range. This is the largest allocation which can succeed without growing or defragmenting.
+        */
+        uint64_t getLargestFreeRange() const;
+
+        /** Get the number of live allocations
+        */
+        uint32_t getAllocationCount() const { return (uint32_t)mAllocations.size(); }
+
+        /** Get the number of free ranges
+        */
+        uint32_t getFreeRangeCount() const { return (uint32_t)mFreeByOffset.size(); }
+
+        /** Get the fragmentation ratio, 1 - largestFreeRange/freeSize. 0 means all the free space is contiguous.
+        */
+        float getFragmentation() const;
+
+    private:
+        void insertFreeRange(uint64_t offset, uint64_t size);
+        void eraseFreeRange(std::map<uint64_t, uint64_t>::iterator it);
+
+        uint64_t mCapacity = 0;
+        uint64_t mUsedSize = 0;
+        std::map<uint64_t, uint64_t> mAllocations;                  // Offset -> size
+        std::map<uint64_t, uint64_t> mFreeByOffset;                 // Offset -> size. Used for merging neighbors
+        std::set<std::pair<uint64_t, uint64_t>> mFreeBySize;        // (size, offset). Used for best-fit lookup
+    };
+}
\ No newline at end of file
@@ -0,0 +1,1267 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureCompressor.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include "Core/DDSHeader.h"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/Bitmap.h"
+#include "Utils/ImageProcessing.h"
+#include "Utils/ParallelFor.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TEXTURE_COMPRESSOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef FALCOR_GL
+static const bool kTopDown = false;
+#elif defined FALCOR_DX11
+static const bool kTopDown = true;
+#endif
+
+namespace Falcor
+{
+    using namespace DdsHelper;
+
+    static const uint32_t kDdsMagicNumber = 0x20534444;     // "DDS "
+    static const uint32_t kDx10FourCC = 0x30315844;         // "DX10"
+
+    /** A 4x4 block, one array per channel so that the index search can process 4 texels at once
+    */
+    struct Block
+    {
+        float texels[4][16];
+    };
+
+    static void loadBlock(const uint8_t rgba[64], Block& block)
+    {
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                block.texels[c][t] = rgba[t * 4 + c];
+            }
+        }
+    }
+
+    /** Find the axis the block's colors spread along, using power iteration on the covariance matrix
+    */
+    static void calcPrincipalAxis(const float* const* pChannels, uint32_t channelCount, float mean[4], float axis[4])
+    {
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            float sum = 0;
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                sum += pChannels[c][t];
+            }
+            mean[c] = sum / 16;
+        }
+
+        float cov[4][4] = {};
+        float farthest = -1;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            float d[4];
+            float dist = 0;
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                d[c] = pChannels[c][t] - mean[c];
+                dist += d[c] * d[c];
+            }
+            for(uint32_t i = 0; i < channelCount; i++)
+            {
+                for(uint32_t j = 0; j < channelCount; j++)
+                {
+                    cov[i][j] += d[i] * d[j];
+                }
+            }
+
+            // Start from the texel farthest from the mean. It can't be orthogonal to the principal axis.
+            if(dist > farthest)
+            {
+                farthest = dist;
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    axis[c] = d[c];
+                }
+            }
+        }
+
+        for(uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            float v[4];
+            float length = 0;
+            for(uint32_t i = 0; i < channelCount; i++)
+            {
+                v[i] = 0;
+                for(uint32_t j = 0; j < channelCount; j++)
+                {
+                    v[i] += cov[i][j] * axis[j];
+                }
+                length += v[i] * v[i];
+            }
+
+            if(length < 1e-12f)
+            {
+                break;
+            }
+            length = 1 / std::sqrt(length);
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                axis[c] = v[c] * length;
+            }
+        }
+
+        float length = 0;
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            length += axis[c] * axis[c];
+        }
+        length = (length > 0) ? 1 / std::sqrt(length) : 0;
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            axis[c] *= length;
+        }
+    }
+
+    /** Place the endpoints at the extremes of the block's projection on its principal axis
+    */
+    static void calcInitialEndpoints(const float* const* pChannels, uint32_t channelCount, float e0[4], float e1[4])
+    {
+        float mean[4];
+        float axis[4];
+        calcPrincipalAxis(pChannels, channelCount, mean, axis);
+
+        float minT = FLT_MAX;
+        float maxT = -FLT_MAX;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            float proj = 0;
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                proj += (pChannels[c][t] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, proj);
+            maxT = std::max(maxT, proj);
+        }
+
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            e0[c] = mean[c] + axis[c] * maxT;
+            e1[c] = mean[c] + axis[c] * minT;
+        }
+    }
+
+    /** Select the closest palette entry for each texel
+        \return The squared error
+    */
+    static float selectIndices(const float* const* pChannels, uint32_t channelCount, const float palette[16][4], uint32_t paletteSize, uint8_t indices[16])
+    {
+#ifdef TEXTURE_COMPRESSOR_USE_SSE2
+        __m128 totalError = _mm_setzero_ps();
+        for(uint32_t t = 0; t < 16; t += 4)
+        {
+            __m128 texels[4];
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                texels[c] = _mm_loadu_ps(pChannels[c] + t);
+            }
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for(uint32_t p = 0; p < paletteSize; p++)
+            {
+                __m128 error = _mm_setzero_ps();
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    __m128 d = _mm_sub_ps(texels[c], _mm_set1_ps(palette[p][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(d, d));
+                }
+                __m128i isBetter = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_si128(_mm_and_si128(isBetter, _mm_set1_epi32(p)), _mm_andnot_si128(isBetter, bestIndex));
+            }
+
+            totalError = _mm_add_ps(totalError, bestError);
+            int32_t index[4];
+            _mm_storeu_si128((__m128i*)index, bestIndex);
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                indices[t + i] = (uint8_t)index[i];
+            }
+        }
+
+        float error[4];
+        _mm_storeu_ps(error, totalError);
+        return error[0] + error[1] + error[2] + error[3];
+#else
+        float totalError = 0;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            float bestError = FLT_MAX;
+            for(uint32_t p = 0; p < paletteSize; p++)
+            {
+                float error = 0;
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    float d = pChannels[c][t] - palette[p][c];
+                    error += d * d;
+                }
+                if(error < bestError)
+                {
+                    bestError = error;
+                    indices[t] = (uint8_t)p;
+                }
+            }
+            totalError += bestError;
+        }
+        return totalError;
+#endif
+    }
+
+    /** Least-squares fit of the endpoints, given the indices. Each index interpolates the endpoints with a weight from pWeights, 0 being e0 and 1 being e1.
+        \return false if the system is degenerate, in which case the endpoints are unchanged
+    */
+    static bool fitEndpoints(const float* const* pChannels, uint32_t channelCount, const uint8_t indices[16], const float* pWeights, float e0[4], float e1[4])
+    {
+        float a = 0, b = 0, c = 0;
+        float x[4] = {};
+        float y[4] = {};
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            float w = pWeights[indices[t]];
+            float iw = 1 - w;
+            a += iw * iw;
+            b += iw * w;
+            c += w * w;
+            for(uint32_t ch = 0; ch < channelCount; ch++)
+            {
+                x[ch] += iw * pChannels[ch][t];
+                y[ch] += w * pChannels[ch][t];
+            }
+        }
+
+        float det = a * c - b * b;
+        if(std::abs(det) < 1e-6f)
+        {
+            return false;
+        }
+
+        det = 1 / det;
+        for(uint32_t ch = 0; ch < channelCount; ch++)
+        {
+            e0[ch] = (c * x[ch] - b * y[ch]) * det;
+            e1[ch] = (a * y[ch] - b * x[ch]) * det;
+        }
+        return true;
+    }
+
+    static int32_t quantize(float value, float scale, int32_t maxValue)
+    {
+        return std::max(0, std::min(maxValue, (int32_t)(value * scale + 0.5f)));
+    }
+
+    /************************************************************************/
+    /* BC1                                                                  */
+    /************************************************************************/
+    static const float kBC1Weights4[4] = {0, 1, 1.0f / 3.0f, 2.0f / 3.0f};
+    static const float kBC1Weights3[4] = {0, 1, 0.5f, 0};
+
+    static uint16_t packColor565(const float color[4])
+    {
+        return (uint16_t)((quantize(color[0], 31.0f / 255.0f, 31) << 11) | (quantize(color[1], 63.0f / 255.0f, 63) << 5) | quantize(color[2], 31.0f / 255.0f, 31));
+    }
+
+    static void unpackColor565(uint16_t color, uint32_t rgb[3])
+    {
+        uint32_t r = (color >> 11) & 31;
+        uint32_t g = (color >> 5) & 63;
+        uint32_t b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    static uint32_t buildBC1Palette(uint16_t c0, uint16_t c1, bool threeColor, float palette[16][4])
+    {
+        uint32_t rgb0[3], rgb1[3];
+        unpackColor565(c0, rgb0);
+        unpackColor565(c1, rgb1);
+        const float* pWeights = threeColor ? kBC1Weights3 : kBC1Weights4;
+        uint32_t count = threeColor ? 3 : 4;
+        for(uint32_t i = 0; i < count; i++)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                palette[i][c] = rgb0[c] * (1 - pWeights[i]) + rgb1[c] * pWeights[i];
+            }
+        }
+        return count;
+    }
+
+    /** Encode a BC1 block.
+        \param[in] allowTransparency Use the 3-color mode for blocks with texels whose alpha is below 128. Must be false for the color block of BC3, which always uses 4 colors.
+    */
+    static void encodeBC1(const Block& block, bool allowTransparency, uint8_t* pDst)
+    {
+        Block work = block;
+        uint32_t transparentMask = 0;
+        if(allowTransparency)
+        {
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                transparentMask |= (block.texels[3][t] < 128) ? (1 << t) : 0;
+            }
+        }
+
+        if(transparentMask == 0xFFFF)
+        {
+            // c0 <= c1 selects the 3-color mode, and index 3 is transparent black
+            memset(pDst, 0, 4);
+            memset(pDst + 4, 0xFF, 4);
+            return;
+        }
+
+        bool threeColor = (transparentMask != 0);
+        if(threeColor)
+        {
+            // Move the transparent texels to the mean color, so that they don't affect the endpoints
+            float mean[3] = {};
+            uint32_t count = 0;
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                if((transparentMask & (1 << t)) == 0)
+                {
+                    for(uint32_t c = 0; c < 3; c++)
+                    {
+                        mean[c] += block.texels[c][t];
+                    }
+                    count++;
+                }
+            }
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                if(transparentMask & (1 << t))
+                {
+                    for(uint32_t c = 0; c < 3; c++)
+                    {
+                        work.texels[c][t] = mean[c] / count;
+                    }
+                }
+            }
+        }
+
+        const float* pChannels[3] = {work.texels[0], work.texels[1], work.texels[2]};
+        float e0[4], e1[4];
+        calcInitialEndpoints(pChannels, 3, e0, e1);
+
+        uint16_t bestC0 = 0, bestC1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+        for(uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            uint16_t c0 = packColor565(e0);
+            uint16_t c1 = packColor565(e1);
+            float palette[16][4];
+            uint32_t paletteSize = buildBC1Palette(c0, c1, threeColor, palette);
+            uint8_t indices[16];
+            float error = selectIndices(pChannels, 3, palette, paletteSize, indices);
+            if(error >= bestError)
+            {
+                break;
+            }
+
+            bestError = error;
+            bestC0 = c0;
+            bestC1 = c1;
+            memcpy(bestIndices, indices, sizeof(indices));
+            if(fitEndpoints(pChannels, 3, indices, threeColor ? kBC1Weights3 : kBC1Weights4, e0, e1) == false)
+            {
+                break;
+            }
+        }
+
+        // The order of the endpoints selects the mode
+        if(threeColor)
+        {
+            if(bestC0 > bestC1)
+            {
+                std::swap(bestC0, bestC1);
+                for(uint32_t t = 0; t < 16; t++)
+                {
+                    bestIndices[t] = (bestIndices[t] < 2) ? (bestIndices[t] ^ 1) : bestIndices[t];
+                }
+            }
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                bestIndices[t] = (transparentMask & (1 << t)) ? 3 : bestIndices[t];
+            }
+        }
+        else if(bestC0 < bestC1)
+        {
+            // Swaps 0 with 1 and 2 with 3
+            std::swap(bestC0, bestC1);
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                bestIndices[t] ^= 1;
+            }
+        }
+        else if(bestC0 == bestC1)
+        {
+            memset(bestIndices, 0, sizeof(bestIndices));
+        }
+
+        uint32_t bits = 0;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            bits |= bestIndices[t] << (t * 2);
+        }
+        pDst[0] = (uint8_t)(bestC0 & 0xFF);
+        pDst[1] = (uint8_t)(bestC0 >> 8);
+        pDst[2] = (uint8_t)(bestC1 & 0xFF);
+        pDst[3] = (uint8_t)(bestC1 >> 8);
+        memcpy(pDst + 4, &bits, sizeof(bits));
+    }
+
+    static void decodeBC1(const uint8_t* pSrc, bool isBC3ColorBlock, uint8_t rgba[64])
+    {
+        uint16_t c0 = (uint16_t)(pSrc[0] | (pSrc[1] << 8));
+        uint16_t c1 = (uint16_t)(pSrc[2] | (pSrc[3] << 8));
+        uint32_t colors[4][4];
+        unpackColor565(c0, colors[0]);
+        unpackColor565(c1, colors[1]);
+        colors[0][3] = colors[1][3] = colors[2][3] = colors[3][3] = 255;
+
+        bool fourColor = isBC3ColorBlock || (c0 > c1);
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            if(fourColor)
+            {
+                colors[2][c] = (2 * colors[0][c] + colors[1][c] + 1) / 3;
+                colors[3][c] = (colors[0][c] + 2 * colors[1][c] + 1) / 3;
+            }
+            else
+            {
+                colors[2][c] = (colors[0][c] + colors[1][c]) / 2;
+                colors[3][c] = 0;
+            }
+        }
+        if(fourColor == false)
+        {
+            colors[3][3] = 0;
+        }
+
+        uint32_t bits;
+        memcpy(&bits, pSrc + 4, sizeof(bits));
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            uint32_t index = (bits >> (t * 2)) & 3;
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                rgba[t * 4 + c] = (uint8_t)colors[index][c];
+            }
+        }
+    }
+
+    /************************************************************************/
+    /* BC4                                                                  */
+    /************************************************************************/
+    static const float kBC4Weights8[8] = {0, 1, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f};
+
+    static void buildBC4Palette(int32_t r0, int32_t r1, float palette[16][4])
+    {
+        palette[0][0] = (float)r0;
+        palette[1][0] = (float)r1;
+        if(r0 > r1)
+        {
+            for(uint32_t i = 1; i < 7; i++)
+            {
+                palette[i + 1][0] = ((7 - i) * r0 + i * r1) / 7.0f;
+            }
+        }
+        else
+        {
+            for(uint32_t i = 1; i < 5; i++)
+            {
+                palette[i + 1][0] = ((5 - i) * r0 + i * r1) / 5.0f;
+            }
+            palette[6][0] = 0;
+            palette[7][0] = 255;
+        }
+    }
+
+    static void encodeBC4(const float values[16], uint8_t* pDst)
+    {
+        const float* pChannels[1] = {values};
+        float minValue = 255, maxValue = 0;
+        float innerMin = 255, innerMax = 0;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            minValue = std::min(minValue, values[t]);
+            maxValue = std::max(maxValue, values[t]);
+            if(values[t] > 0 && values[t] < 255)
+            {
+                innerMin = std::min(innerMin, values[t]);
+                innerMax = std::max(innerMax, values[t]);
+            }
+        }
+
+        float palette[16][4];
+        uint8_t indices[16];
+        uint8_t bestIndices[16] = {};
+        int32_t bestR0 = quantize(maxValue, 1, 255);
+        int32_t bestR1 = quantize(minValue, 1, 255);
+        float bestError = FLT_MAX;
+
+        // The 8 values mode. It requires r0 > r1.
+        float e0[4] = {maxValue};
+        float e1[4] = {minValue};
+        for(uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            int32_t r0 = quantize(std::max(e0[0], e1[0]), 1, 255);
+            int32_t r1 = quantize(std::min(e0[0], e1[0]), 1, 255);
+            if(r0 == r1)
+            {
+                // Can't use the mode. A constant block is exact with indices set to 0.
+                if(iteration == 0)
+                {
+                    buildBC4Palette(r0, r1, palette);
+                    bestError = selectIndices(pChannels, 1, palette, 1, bestIndices);
+                    bestR0 = r0;
+                    bestR1 = r1;
+                }
+                break;
+            }
+
+            buildBC4Palette(r0, r1, palette);
+            float error = selectIndices(pChannels, 1, palette, 8, indices);
+            if(error >= bestError)
+            {
+                break;
+            }
+            bestError = error;
+            bestR0 = r0;
+            bestR1 = r1;
+            memcpy(bestIndices, indices, sizeof(indices));
+            e0[0] = (float)r0;
+            e1[0] = (float)r1;
+            if(fitEndpoints(pChannels, 1, indices, kBC4Weights8, e0, e1) == false)
+            {
+                break;
+            }
+        }
+
+        // The 6 values mode has exact 0 and 255, which helps blocks with values at the extremes
+        if((minValue == 0 || maxValue == 255) && bestError > 0)
+        {
+            int32_t r0 = quantize(std::min(innerMin, innerMax), 1, 255);
+            int32_t r1 = quantize(std::max(innerMin, innerMax), 1, 255);
+            buildBC4Palette(r0, r1, palette);
+            float error = selectIndices(pChannels, 1, palette, 8, indices);
+            if(error < bestError)
+            {
+                bestR0 = r0;
+                bestR1 = r1;
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+
+        uint64_t bits = 0;
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            bits |= (uint64_t)bestIndices[t] << (t * 3);
+        }
+        pDst[0] = (uint8_t)bestR0;
+        pDst[1] = (uint8_t)bestR1;
+        for(uint32_t i = 0; i < 6; i++)
+        {
+            pDst[2 + i] = (uint8_t)(bits >> (i * 8));
+        }
+    }
+
+    static void decodeBC4(const uint8_t* pSrc, uint8_t* pDst, uint32_t dstStride)
+    {
+        uint32_t r0 = pSrc[0];
+        uint32_t r1 = pSrc[1];
+        uint32_t values[8] = {r0, r1};
+        if(r0 > r1)
+        {
+            for(uint32_t i = 1; i < 7; i++)
+            {
+                values[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for(uint32_t i = 1; i < 5; i++)
+            {
+                values[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+            }
+            values[6] = 0;
+            values[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        for(uint32_t i = 0; i < 6; i++)
+        {
+            bits |= (uint64_t)pSrc[2 + i] << (i * 8);
+        }
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            pDst[t * dstStride] = (uint8_t)values[(bits >> (t * 3)) & 7];
+        }
+    }
+
+    /************************************************************************/
+    /* BC7                                                                  */
+    /************************************************************************/
+    static const uint32_t kBC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    class BitWriter
+    {
+    public:
+        BitWriter(uint8_t* pDst) : mpDst(pDst) { memset(pDst, 0, 16); }
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            for(uint32_t i = 0; i < bitCount; i++, mOffset++)
+            {
+                mpDst[mOffset / 8] |= (uint8_t)(((value >> i) & 1) << (mOffset % 8));
+            }
+        }
+    private:
+        uint8_t* mpDst;
+        uint32_t mOffset = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t* pSrc) : mpSrc(pSrc) {}
+        uint32_t read(uint32_t bitCount)
+        {
+            uint32_t value = 0;
+            for(uint32_t i = 0; i < bitCount; i++, mOffset++)
+            {
+                value |= ((mpSrc[mOffset / 8] >> (mOffset % 8)) & 1) << i;
+            }
+            return value;
+        }
+    private:
+        const uint8_t* mpSrc;
+        uint32_t mOffset = 0;
+    };
+
+    /** Encode a BC7 block using mode 6 - a single subset with 7-bit RGBA endpoints, a p-bit per endpoint and 4-bit indices
+    */
+    static void encodeBC7(const Block& block, uint8_t* pDst)
+    {
+        const float* pChannels[4] = {block.texels[0], block.texels[1], block.texels[2], block.texels[3]};
+        float e0[4], e1[4];
+        calcInitialEndpoints(pChannels, 4, e0, e1);
+
+        float weights[16];
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            weights[i] = kBC7Weights4[i] / 64.0f;
+        }
+
+        uint32_t bestQ0[4] = {}, bestQ1[4] = {};
+        uint32_t bestP0 = 0, bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+        for(uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            bool improved = false;
+
+            // Try all the p-bit combinations
+            for(uint32_t p = 0; p < 4; p++)
+            {
+                uint32_t p0 = p & 1;
+                uint32_t p1 = p >> 1;
+                uint32_t q0[4], q1[4];
+                uint32_t v0[4], v1[4];
+                for(uint32_t c = 0; c < 4; c++)
+                {
+                    q0[c] = quantize(e0[c] - p0, 0.5f, 127);
+                    q1[c] = quantize(e1[c] - p1, 0.5f, 127);
+                    v0[c] = (q0[c] << 1) | p0;
+                    v1[c] = (q1[c] << 1) | p1;
+                }
+
+                float palette[16][4];
+                for(uint32_t i = 0; i < 16; i++)
+                {
+                    for(uint32_t c = 0; c < 4; c++)
+                    {
+                        palette[i][c] = (float)(((64 - kBC7Weights4[i]) * v0[c] + kBC7Weights4[i] * v1[c] + 32) >> 6);
+                    }
+                }
+
+                uint8_t indices[16];
+                float error = selectIndices(pChannels, 4, palette, 16, indices);
+                if(error < bestError)
+                {
+                    bestError = error;
+                    memcpy(bestQ0, q0, sizeof(q0));
+                    memcpy(bestQ1, q1, sizeof(q1));
+                    bestP0 = p0;
+                    bestP1 = p1;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                    improved = true;
+                }
+            }
+
+            if(improved == false || bestError == 0 || fitEndpoints(pChannels, 4, bestIndices, weights, e0, e1) == false)
+            {
+                break;
+            }
+        }
+
+        // The MSB of the first index is implicitly 0
+        if(bestIndices[0] & 8)
+        {
+            std::swap(bestQ0, bestQ1);
+            std::swap(bestP0, bestP1);
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                bestIndices[t] = 15 - bestIndices[t];
+            }
+        }
+
+        BitWriter writer(pDst);
+        writer.write(1 << 6, 7);
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            writer.write(bestQ0[c], 7);
+            writer.write(bestQ1[c], 7);
+        }
+        writer.write(bestP0, 1);
+        writer.write(bestP1, 1);
+        writer.write(bestIndices[0], 3);
+        for(uint32_t t = 1; t < 16; t++)
+        {
+            writer.write(bestIndices[t], 4);
+        }
+    }
+
+    static void decodeBC7(const uint8_t* pSrc, uint8_t rgba[64])
+    {
+        BitReader reader(pSrc);
+        if(reader.read(7) != (1 << 6))
+        {
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                rgba[t * 4 + 0] = 255;
+                rgba[t * 4 + 1] = 0;
+                rgba[t * 4 + 2] = 255;
+                rgba[t * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        uint32_t v0[4], v1[4];
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            v0[c] = reader.read(7) << 1;
+            v1[c] = reader.read(7) << 1;
+        }
+        uint32_t p0 = reader.read(1);
+        uint32_t p1 = reader.read(1);
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            v0[c] |= p0;
+            v1[c] |= p1;
+        }
+
+        for(uint32_t t = 0; t < 16; t++)
+        {
+            uint32_t w = kBC7Weights4[reader.read(t == 0 ? 3 : 4)];
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                rgba[t * 4 + c] = (uint8_t)(((64 - w) * v0[c] + w * v1[c] + 32) >> 6);
+            }
+        }
+    }
+
+    /************************************************************************/
+    /* Images                                                               */
+    /************************************************************************/
+    static std::vector<uint8_t> convertToRgba(const TextureCompressor::Image& image)
+    {
+        std::vector<uint8_t> rgba;
+        uint32_t bpp = image.bytesPerPixel;
+        if(bpp != 1 && bpp != 2 && bpp != 4)
+        {
+            Logger::log(Logger::Level::Error, "TextureCompressor - images must have 1, 2 or 4 bytes-per-pixel, got " + std::to_string(bpp));
+            return rgba;
+        }
+
+        size_t texelCount = (size_t)image.width * image.height;
+        rgba.resize(texelCount * 4);
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            const uint8_t* pSrc = image.pData + i * bpp;
+            uint8_t* pDst = rgba.data() + i * 4;
+            if(bpp == 4)
+            {
+                // BGRA
+                pDst[0] = pSrc[2];
+                pDst[1] = pSrc[1];
+                pDst[2] = pSrc[0];
+                pDst[3] = pSrc[3];
+            }
+            else
+            {
+                pDst[0] = pSrc[0];
+                pDst[1] = (bpp == 2) ? pSrc[1] : 0;
+                pDst[2] = 0;
+                pDst[3] = 255;
+            }
+        }
+        return rgba;
+    }
+
+    /** Compress a range of block rows of an RGBA image
+    */
+    static void compressBlockRows(const uint8_t* pRgba, uint32_t width, uint32_t height, TextureCompressor::Format format, uint32_t firstRow, uint32_t rowCount, uint8_t* pDst)
+    {
+        uint32_t blocksX = std::max((width + 3) / 4, 1u);
+        uint32_t blockSize = TextureCompressor::getBlockSize(format);
+        for(uint32_t by = firstRow; by < firstRow + rowCount; by++)
+        {
+            for(uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                // Partial blocks replicate the edge texels
+                uint8_t rgba[64];
+                for(uint32_t y = 0; y < 4; y++)
+                {
+                    uint32_t srcY = std::min(by * 4 + y, height - 1);
+                    for(uint32_t x = 0; x < 4; x++)
+                    {
+                        uint32_t srcX = std::min(bx * 4 + x, width - 1);
+                        memcpy(rgba + (y * 4 + x) * 4, pRgba + ((size_t)srcY * width + srcX) * 4, 4);
+                    }
+                }
+                TextureCompressor::compressBlock(format, rgba, pDst + ((size_t)by * blocksX + bx) * blockSize);
+            }
+        }
+    }
+
+    static DXGI_FORMAT getDxgiFormat(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BC1Unorm:
+            return DXGI_FORMAT_BC1_UNORM;
+        case ResourceFormat::BC1UnormSrgb:
+            return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case ResourceFormat::BC3Unorm:
+            return DXGI_FORMAT_BC3_UNORM;
+        case ResourceFormat::BC3UnormSrgb:
+            return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case ResourceFormat::BC4Unorm:
+            return DXGI_FORMAT_BC4_UNORM;
+        case ResourceFormat::BC5Unorm:
+            return DXGI_FORMAT_BC5_UNORM;
+        case ResourceFormat::BC7Unorm:
+            return DXGI_FORMAT_BC7_UNORM;
+        case ResourceFormat::BC7UnormSrgb:
+            return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    /************************************************************************/
+    /* TextureCompressor                                                    */
+    /************************************************************************/
+    ResourceFormat TextureCompressor::getResourceFormat(Format format, bool isSrgb)
+    {
+        switch(format)
+        {
+        case Format::BC1:
+            return isSrgb ? ResourceFormat::BC1UnormSrgb : ResourceFormat::BC1Unorm;
+        case Format::BC3:
+            return isSrgb ? ResourceFormat::BC3UnormSrgb : ResourceFormat::BC3Unorm;
+        case Format::BC4:
+            return ResourceFormat::BC4Unorm;
+        case Format::BC5:
+            return ResourceFormat::BC5Unorm;
+        case Format::BC7:
+            return isSrgb ? ResourceFormat::BC7UnormSrgb : ResourceFormat::BC7Unorm;
+        default:
+            should_not_get_here();
+            return ResourceFormat::Unknown;
+        }
+    }
+
+    uint32_t TextureCompressor::getBlockSize(Format format)
+    {
+        return (format == Format::BC1 || format == Format::BC4) ? 8 : 16;
+    }
+
+    uint32_t TextureCompressor::getChannelCount(Format format)
+    {
+        switch(format)
+        {
+        case Format::BC1:
+            return 3;
+        case Format::BC4:
+            return 1;
+        case Format::BC5:
+            return 2;
+        default:
+            return 4;
+        }
+    }
+
+    TextureCompressor::Format TextureCompressor::chooseFormat(uint32_t channelCount, bool isNormalMap, bool isOpaque, bool highQuality)
+    {
+        if(isNormalMap || channelCount == 2)
+        {
+            return Format::BC5;
+        }
+        if(channelCount == 1)
+        {
+            return Format::BC4;
+        }
+        if(highQuality)
+        {
+            return Format::BC7;
+        }
+        return (channelCount == 4 && isOpaque == false) ? Format::BC3 : Format::BC1;
+    }
+
+    bool TextureCompressor::hasTransparentTexels(const Image& image)
+    {
+        if(image.bytesPerPixel != 4)
+        {
+            return false;
+        }
+
+        size_t texelCount = (size_t)image.width * image.height;
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            if(image.pData[i * 4 + 3] != 255)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t TextureCompressor::getCompressedSize(uint32_t width, uint32_t height, Format format)
+    {
+        return std::max((width + 3) / 4, 1u) * std::max((height + 3) / 4, 1u) * getBlockSize(format);
+    }
+
+    void TextureCompressor::compressBlock(Format format, const uint8_t rgba[64], uint8_t* pDst)
+    {
+        Block block;
+        loadBlock(rgba, block);
+        switch(format)
+        {
+        case Format::BC1:
+            encodeBC1(block, true, pDst);
+            break;
+        case Format::BC3:
+            encodeBC4(block.texels[3], pDst);
+            encodeBC1(block, false, pDst + 8);
+            break;
+        case Format::BC4:
+            encodeBC4(block.texels[0], pDst);
+            break;
+        case Format::BC5:
+            encodeBC4(block.texels[0], pDst);
+            encodeBC4(block.texels[1], pDst + 8);
+            break;
+        case Format::BC7:
+            encodeBC7(block, pDst);
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    void TextureCompressor::decompressBlock(Format format, const uint8_t* pSrc, uint8_t rgba[64])
+    {
+        switch(format)
+        {
+        case Format::BC1:
+            decodeBC1(pSrc, false, rgba);
+            break;
+        case Format::BC3:
+            decodeBC1(pSrc + 8, true, rgba);
+            decodeBC4(pSrc, rgba + 3, 4);
+            break;
+        case Format::BC4:
+        case Format::BC5:
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                rgba[t * 4 + 1] = 0;
+                rgba[t * 4 + 2] = 0;
+                rgba[t * 4 + 3] = 255;
+            }
+            decodeBC4(pSrc, rgba, 4);
+            if(format == Format::BC5)
+            {
+                decodeBC4(pSrc + 8, rgba + 1, 4);
+            }
+            break;
+        case Format::BC7:
+            decodeBC7(pSrc, rgba);
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    std::vector<uint8_t> TextureCompressor::compressImage(const Image& image, Format format)
+    {
+        std::vector<Job> jobs(1);
+        jobs[0].image = image;
+        jobs[0].format = format;
+        jobs[0].generateMips = false;
+        std::vector<CompressedTexture> textures = compressTextures(jobs);
+        std::vector<uint8_t> data;
+        data.swap(textures[0].data);
+        return data;
+    }
+
+    std::vector<uint8_t> TextureCompressor::decompressImage(const uint8_t* pBlocks, uint32_t width, uint32_t height, Format format)
+    {
+        std::vector<uint8_t> rgba((size_t)width * height * 4);
+        uint32_t blocksX = std::max((width + 3) / 4, 1u);
+        uint32_t blocksY = std::max((height + 3) / 4, 1u);
+        uint32_t blockSize = getBlockSize(format);
+        parallelFor(blocksY, 4, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t by = begin; by < end; by++)
+            {
+                for(uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    uint8_t block[64];
+                    decompressBlock(format, pBlocks + ((size_t)by * blocksX + bx) * blockSize, block);
+                    for(uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                    {
+                        for(uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+                        {
+                            memcpy(rgba.data() + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, block + (y * 4 + x) * 4, 4);
+                        }
+                    }
+                }
+            }
+        });
+        return rgba;
+    }
+
+    std::vector<TextureCompressor::CompressedTexture> TextureCompressor::compressTextures(const std::vector<Job>& jobs)
+    {
+        std::vector<CompressedTexture> textures(jobs.size());
+        std::vector<std::vector<std::vector<uint8_t>>> levels(jobs.size());
+        std::vector<std::vector<size_t>> levelOffsets(jobs.size());
+
+        // Convert the images and generate the mip-chains, one texture per thread
+        parallelFor((uint32_t)jobs.size(), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t j = begin; j < end; j++)
+            {
+                const Job& job = jobs[j];
+                std::vector<uint8_t> rgba = convertToRgba(job.image);
+                if(rgba.empty() || job.image.width == 0 || job.image.height == 0)
+                {
+                    continue;
+                }
+
+                CompressedTexture& texture = textures[j];
+                texture.format = getResourceFormat(job.format, job.isSrgb);
+                texture.width = job.image.width;
+                texture.height = job.image.height;
+
+                uint32_t width = texture.width;
+                uint32_t height = texture.height;
+                size_t size = 0;
+                levels[j].push_back(std::vector<uint8_t>());
+                levels[j].back().swap(rgba);
+                while(true)
+                {
+                    levelOffsets[j].push_back(size);
+                    size += getCompressedSize(width, height, job.format);
+                    if(job.generateMips == false || (width == 1 && height == 1))
+                    {
+                        break;
+                    }
+                    std::vector<uint8_t> mip((size_t)std::max(width / 2, 1u) * std::max(height / 2, 1u) * 4);
+                    ImageProcessing::downsample(levels[j].back().data(), width, height, job.isSrgb ? ResourceFormat::RGBA8UnormSrgb : ResourceFormat::RGBA8Unorm, ImageProcessing::MipFilter::Box, mip.data());
+                    levels[j].push_back(std::vector<uint8_t>());
+                    levels[j].back().swap(mip);
+                    width = std::max(width / 2, 1u);
+                    height = std::max(height / 2, 1u);
+                }
+                texture.mipCount = (uint32_t)levels[j].size();
+                texture.data.resize(size);
+            }
+        });
+
+        // Compress the block rows of all the textures and levels together, so that small textures and the tails of the mip-chains don't leave threads idle
+        struct Task
+        {
+            uint32_t job;
+            uint32_t mipLevel;
+            uint32_t blockRow;
+        };
+        std::vector<Task> tasks;
+        for(uint32_t j = 0; j < (uint32_t)jobs.size(); j++)
+        {
+            for(uint32_t mip = 0; mip < (uint32_t)levels[j].size(); mip++)
+            {
+                uint32_t height = std::max(textures[j].height >> mip, 1u);
+                for(uint32_t row = 0; row < (height + 3) / 4; row++)
+                {
+                    Task task = {j, mip, row};
+                    tasks.push_back(task);
+                }
+            }
+        }
+
+        parallelFor((uint32_t)tasks.size(), 4, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+            {
+                const Task& task = tasks[i];
+                CompressedTexture& texture = textures[task.job];
+                uint32_t width = std::max(texture.width >> task.mipLevel, 1u);
+                uint32_t height = std::max(texture.height >> task.mipLevel, 1u);
+                uint8_t* pDst = texture.data.data() + levelOffsets[task.job][task.mipLevel];
+                compressBlockRows(levels[task.job][task.mipLevel].data(), width, height, jobs[task.job].format, task.blockRow, 1, pDst);
+            }
+        });
+
+        return textures;
+    }
+
+    float TextureCompressor::calcPsnr(const Image& reference, const uint8_t* pBlocks, Format format)
+    {
+        std::vector<uint8_t> expected = convertToRgba(reference);
+        if(expected.empty())
+        {
+            return 0;
+        }
+        std::vector<uint8_t> actual = decompressImage(pBlocks, reference.width, reference.height, format);
+
+        uint32_t channelCount = getChannelCount(format);
+        double sum = 0;
+        size_t texelCount = (size_t)reference.width * reference.height;
+        for(size_t i = 0; i < texelCount; i++)
+        {
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                double d = (double)expected[i * 4 + c] - (double)actual[i * 4 + c];
+                sum += d * d;
+            }
+        }
+
+        double mse = sum / (texelCount * channelCount);
+        if(mse == 0)
+        {
+            return std::numeric_limits<float>::infinity();
+        }
+        return (float)(10 * std::log10(255.0 * 255.0 / mse));
+    }
+
+    bool TextureCompressor::saveDdsFile(const std::string& filename, const CompressedTexture& texture)
+    {
+        DXGI_FORMAT dxgiFormat = getDxgiFormat(texture.format);
+        if(dxgiFormat == DXGI_FORMAT_UNKNOWN)
+        {
+            Logger::log(Logger::Level::Error, "TextureCompressor::saveDdsFile() - unsupported format");
+            return false;
+        }
+
+        DdsHeader header;
+        memset(&header, 0, sizeof(header));
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kLinearSizeMask | DdsHeader::kMipCountMask;
+        header.height = texture.height;
+        header.width = texture.width;
+        header.linearSize = std::max((texture.width + 3) / 4, 1u) * std::max((texture.height + 3) / 4, 1u) * getFormatBytesPerBlock(texture.format);
+        header.mipCount = texture.mipCount;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = kDx10FourCC;
+        header.caps[0] = DdsHeader::kCapsTextureMask | ((texture.mipCount > 1) ? (DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask) : 0);
+
+        DdsHeaderDX10 dx10Header;
+        memset(&dx10Header, 0, sizeof(dx10Header));
+        dx10Header.dxgiFormat = dxgiFormat;
+        dx10Header.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        if(stream.isGood() == false)
+        {
+            Logger::log(Logger::Level::Error, "TextureCompressor::saveDdsFile() - can't open '" + filename + "' for writing");
+            return false;
+        }
+
+        stream << kDdsMagicNumber << header << dx10Header;
+        stream.write(texture.data.data(), texture.data.size());
+        return stream.isGood();
+    }
+
+    bool TextureCompressor::compressImageFile(const std::string& srcFilename, const std::string& ddsFilename, Format format, bool isSrgb, bool generateMips)
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(srcFilename, kTopDown);
+        if(pBitmap == nullptr)
+        {
+            return false;
+        }
+
+        std::vector<Job> jobs(1);
+        jobs[0].image.width = pBitmap->getWidth();
+        jobs[0].image.height = pBitmap->getHeight();
+        jobs[0].image.bytesPerPixel = pBitmap->getBytesPerPixel();
+        jobs[0].image.pData = pBitmap->getData();
+        jobs[0].format = format;
+        jobs[0].isSrgb = isSrgb;
+        jobs[0].generateMips = generateMips;
+
+        std::vector<CompressedTexture> textures = compressTextures(jobs);
+        if(textures[0].format == ResourceFormat::Unknown)
+        {
+            Logger::log(Logger::Level::Error, "TextureCompressor::compressImageFile() - can't compress '" + srcFilename + "'");
+            return false;
+        }
+        return saveDdsFile(ddsFilename, textures[0]);
+    }
+}
\ No newline at end of file
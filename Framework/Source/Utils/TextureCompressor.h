@@ -0,0 +1,154 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <vector>
+#include "Core/Formats.h"
+
+namespace Falcor
+{
+    /** CPU block compressor for textures.
+        Supports BC1 and BC3 for color, BC4 and BC5 for single-channel and two-channel data (including normal maps), and BC7 for high-quality color.
+        Endpoints are fit along the principal axis of each block and refined with least-squares. Index selection uses SSE2. Work is split between threads over the blocks of all the textures and mip-levels at once.
+        The compressed textures can be saved as DDS files, which createTextureFromDDSFile() loads directly.
+    */
+    class TextureCompressor
+    {
+    public:
+        enum class Format
+        {
+            BC1,    ///< RGB with optional 1-bit alpha. 4 bits per texel.
+            BC3,    ///< RGBA. 8 bits per texel.
+            BC4,    ///< Single channel. 4 bits per texel.
+            BC5,    ///< Two channels, usually tangent-space normal XY. 8 bits per texel.
+            BC7,    ///< High-quality RGBA. 8 bits per texel. Only mode 6 is used.
+        };
+
+        /** An uncompressed image. 4 bytes-per-pixel images are in BGRA order, like Bitmap and the BGRA8 texture formats. 1 and 2 bytes-per-pixel images are R and RG.
+        */
+        struct Image
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t bytesPerPixel = 4;
+            const uint8_t* pData = nullptr;
+        };
+
+        /** A compressed texture. The mip-levels are stored one after another, starting from the most detailed level.
+        */
+        struct CompressedTexture
+        {
+            ResourceFormat format = ResourceFormat::Unknown;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t mipCount = 0;
+            std::vector<uint8_t> data;
+        };
+
+        /** A texture to compress with compressTextures()
+        */
+        struct Job
+        {
+            Image image;
+            Format format = Format::BC1;
+            bool isSrgb = false;
+            bool generateMips = true;   ///< Generate the mip-chain with a box filter, in linear space for sRGB textures. Compressed formats can't generate mips on the GPU.
+        };
+
+        /** Get the resource format matching a block format
+        */
+        static ResourceFormat getResourceFormat(Format format, bool isSrgb);
+
+        /** Get the size of a 4x4 block in bytes
+        */
+        static uint32_t getBlockSize(Format format);
+
+        /** Get the number of channels the format stores, out of RGBA
+        */
+        static uint32_t getChannelCount(Format format);
+
+        /** Pick a format for a texture
+            \param[in] channelCount The number of channels in the texture
+            \param[in] isNormalMap Normal maps are compressed to BC5. Shaders reconstruct Z.
+            \param[in] isOpaque If true, 4-channel textures use a format without alpha
+            \param[in] highQuality Use BC7 for color instead of BC1/BC3
+        */
+        static Format chooseFormat(uint32_t channelCount, bool isNormalMap, bool isOpaque, bool highQuality);
+
+        /** Check if an image has texels which aren't fully opaque. Images without an alpha channel are always opaque.
+        */
+        static bool hasTransparentTexels(const Image& image);
+
+        /** Get the size of a compressed mip-level in bytes
+        */
+        static uint32_t getCompressedSize(uint32_t width, uint32_t height, Format format);
+
+        /** Compress a single 4x4 block
+            \param[in] format The block format
+            \param[in] rgba 16 texels in RGBA order, row by row
+            \param[out] pDst The compressed block, getBlockSize() bytes
+        */
+        static void compressBlock(Format format, const uint8_t rgba[64], uint8_t* pDst);
+
+        /** Decompress a single 4x4 block. BC7 blocks which weren't produced by this class (modes other than 6) decode to magenta.
+            \param[out] rgba 16 texels in RGBA order. Channels which the format doesn't store are set to 0, alpha to 255.
+        */
+        static void decompressBlock(Format format, const uint8_t* pSrc, uint8_t rgba[64]);
+
+        /** Compress the most detailed level of an image
+        */
+        static std::vector<uint8_t> compressImage(const Image& image, Format format);
+
+        /** Decompress an image into RGBA texels
+        */
+        static std::vector<uint8_t> decompressImage(const uint8_t* pBlocks, uint32_t width, uint32_t height, Format format);
+
+        /** Compress several textures, including their mip-chains. The blocks of all the textures are compressed in parallel.
+        */
+        static std::vector<CompressedTexture> compressTextures(const std::vector<Job>& jobs);
+
+        /** Calculate the peak signal-to-noise ratio in dB of a compressed image, over the channels the format stores
+            \return The PSNR, or infinity if the images are identical
+        */
+        static float calcPsnr(const Image& reference, const uint8_t* pBlocks, Format format);
+
+        /** Save a compressed texture to a DDS file with a DX10 header
+        */
+        static bool saveDdsFile(const std::string& filename, const CompressedTexture& texture);
+
+        /** Compress an image file into a DDS file. Use this to bake textures offline instead of compressing them on every load.
+            The rows are stored in the order createTextureFromFile() uses on the current backend, so loading the DDS file with createTextureFromDDSFile() gives the same texture as loading and compressing the image.
+            \param[in] srcFilename The image file. Must have 8-bit channels.
+            \param[in] ddsFilename The output file
+            \param[in] format The block format
+            \param[in] isSrgb Use an sRGB format. Only valid for BC1, BC3 and BC7.
+            \param[in] generateMips Store the entire mip-chain
+        */
+        static bool compressImageFile(const std::string& srcFilename, const std::string& ddsFilename, Format format, bool isSrgb, bool generateMips);
+    };
+}
\ No newline at end of file
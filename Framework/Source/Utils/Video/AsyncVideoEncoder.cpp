@@ -0,0 +1,201 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AsyncVideoEncoder.h"
+#include "Utils/CpuTimer.h"
+
+namespace Falcor
+{
+    AsyncVideoEncoder::UniquePtr AsyncVideoEncoder::create(VideoEncoder::UniquePtr pEncoder, const Desc& desc)
+    {
+        if(pEncoder == nullptr)
+        {
+            return nullptr;
+        }
+        VideoEncoder* pRawEncoder = pEncoder.get();
+        UniquePtr pAsync = create([pRawEncoder](const uint8_t* pData) {pRawEncoder->appendFrame(pData); }, desc);
+        if(pAsync)
+        {
+            pAsync->mpEncoder = std::move(pEncoder);
+        }
+        return pAsync;
+    }
+
+    AsyncVideoEncoder::UniquePtr AsyncVideoEncoder::create(const FrameFunc& frameFunc, const Desc& desc)
+    {
+        if(desc.frameSize == 0 || desc.queueSize == 0)
+        {
+            Logger::log(Logger::Level::Error, "AsyncVideoEncoder::create() - frame size and queue size must be larger than 0.");
+            return nullptr;
+        }
+        return UniquePtr(new AsyncVideoEncoder(frameFunc, desc));
+    }
+
+    AsyncVideoEncoder::AsyncVideoEncoder(const FrameFunc& frameFunc, const Desc& desc) : mDesc(desc), mFrameFunc(frameFunc)
+    {
+        mFrameStorage.resize(desc.queueSize);
+        for(auto& frame : mFrameStorage)
+        {
+            frame.resize(desc.frameSize);
+            mFreeFrames.push_back(frame.data());
+        }
+        mWorker = std::thread(&AsyncVideoEncoder::workerFunc, this);
+    }
+
+    AsyncVideoEncoder::~AsyncVideoEncoder()
+    {
+        endCapture();
+    }
+
+    uint8_t* AsyncVideoEncoder::acquireFrame()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if(mStopping)
+        {
+            mStats.submittedFrames++;
+            mStats.droppedFrames++;
+            return nullptr;
+        }
+
+        if(mFreeFrames.empty())
+        {
+            if(mDesc.policy == OverflowPolicy::Drop)
+            {
+                mStats.submittedFrames++;
+                mStats.droppedFrames++;
+                return nullptr;
+            }
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            mFrameFreedCV.wait(lock, [this] {return mFreeFrames.empty() == false; });
+            mStats.blockedTimeInMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        }
+
+        uint8_t* pFrame = mFreeFrames.back();
+        mFreeFrames.pop_back();
+        return pFrame;
+    }
+
+    void AsyncVideoEncoder::submitFrame(uint8_t* pFrame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueuedFrames.push_back(pFrame);
+            mStats.submittedFrames++;
+            mStats.queueDepth = (uint32_t)mQueuedFrames.size() + (mEncoding ? 1 : 0);
+            mStats.maxQueueDepth = std::max(mStats.maxQueueDepth, mStats.queueDepth);
+        }
+        mFrameQueuedCV.notify_one();
+    }
+
+    void AsyncVideoEncoder::dropFrame(uint8_t* pFrame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFreeFrames.push_back(pFrame);
+            mStats.submittedFrames++;
+            mStats.droppedFrames++;
+        }
+        mFrameFreedCV.notify_all();
+    }
+
+    bool AsyncVideoEncoder::appendFrame(const void* pData)
+    {
+        uint8_t* pFrame = acquireFrame();
+        if(pFrame == nullptr)
+        {
+            return false;
+        }
+        memcpy(pFrame, pData, mDesc.frameSize);
+        submitFrame(pFrame);
+        return true;
+    }
+
+    void AsyncVideoEncoder::workerFunc()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(true)
+        {
+            mFrameQueuedCV.wait(lock, [this] {return mStopping || mQueuedFrames.empty() == false; });
+            if(mQueuedFrames.empty())
+            {
+                // Stopping and the queue was drained
+                break;
+            }
+
+            uint8_t* pFrame = mQueuedFrames.front();
+            mQueuedFrames.pop_front();
+            mEncoding = true;
+
+            lock.unlock();
+            auto start = CpuTimer::getCurrentTimePoint();
+            mFrameFunc(pFrame);
+            double encodeTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            lock.lock();
+
+            mEncoding = false;
+            mFreeFrames.push_back(pFrame);
+            mStats.encodedFrames++;
+            mStats.encodeTimeInMs += encodeTime;
+            mStats.queueDepth = (uint32_t)mQueuedFrames.size();
+            // flush() waits on the same condition, so wake everyone
+            mFrameFreedCV.notify_all();
+        }
+    }
+
+    void AsyncVideoEncoder::flush()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mFrameFreedCV.wait(lock, [this] {return mQueuedFrames.empty() && (mEncoding == false); });
+    }
+
+    void AsyncVideoEncoder::endCapture()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if(mStopping)
+            {
+                return;
+            }
+            mStopping = true;
+        }
+        mFrameQueuedCV.notify_one();
+        mWorker.join();
+
+        if(mpEncoder)
+        {
+            mpEncoder->endCapture();
+        }
+    }
+
+    AsyncVideoEncoder::Stats AsyncVideoEncoder::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+}
\ No newline at end of file
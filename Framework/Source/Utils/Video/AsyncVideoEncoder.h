@@ -0,0 +1,143 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "VideoEncoder.h"
+
+namespace Falcor
+{
+    /** Moves video encoding off the render thread.
+        Frames are written into a fixed pool of frame buffers and queued to a worker thread, which passes them to a VideoEncoder (or any other frame consumer).
+        When the queue is full, the overflow policy decides whether the caller waits for the worker or the frame is dropped.
+    */
+    class AsyncVideoEncoder
+    {
+    public:
+        using UniquePtr = std::unique_ptr<AsyncVideoEncoder>;
+        using UniqueConstPtr = std::unique_ptr<const AsyncVideoEncoder>;
+
+        /** Called on the worker thread for every queued frame, in submission order
+        */
+        using FrameFunc = std::function<void(const uint8_t* pData)>;
+
+        /** What to do when all the frame buffers are in use
+        */
+        enum class OverflowPolicy
+        {
+            Block,  ///< Wait for the worker to free a buffer. No frames are lost, but the render thread stalls when encoding is slower than rendering.
+            Drop,   ///< Drop the new frame. The render thread never waits.
+        };
+
+        struct Desc
+        {
+            uint32_t frameSize = 0;                         ///< Size of a frame in bytes
+            uint32_t queueSize = 4;                         ///< Number of frame buffers. Bounds the memory usage and the latency.
+            OverflowPolicy policy = OverflowPolicy::Block;
+        };
+
+        struct Stats
+        {
+            uint64_t submittedFrames = 0;   ///< Frames passed to submitFrame() or appendFrame(), including dropped ones
+            uint64_t encodedFrames = 0;
+            uint64_t droppedFrames = 0;
+            uint32_t queueDepth = 0;        ///< Frames waiting for the worker, including the one being encoded
+            uint32_t maxQueueDepth = 0;
+            double blockedTimeInMs = 0;     ///< Total time the caller waited for a free buffer
+            double encodeTimeInMs = 0;      ///< Total time spent in the frame consumer
+        };
+
+        /** Create an object which encodes into a video file
+            \param[in] pEncoder The encoder. The object takes ownership and calls VideoEncoder#endCapture() from endCapture().
+            \param[in] desc The queue description
+        */
+        static UniquePtr create(VideoEncoder::UniquePtr pEncoder, const Desc& desc);
+
+        /** Create an object which passes the frames to a user function
+        */
+        static UniquePtr create(const FrameFunc& frameFunc, const Desc& desc);
+
+        /** Destructor. Calls endCapture().
+        */
+        ~AsyncVideoEncoder();
+
+        /** Get a free frame buffer to write a frame into. The buffer must be passed to submitFrame().
+            \return A buffer of Desc#frameSize bytes, or nullptr if the frame was dropped
+        */
+        uint8_t* acquireFrame();
+
+        /** Queue a buffer returned by acquireFrame() for encoding
+        */
+        void submitFrame(uint8_t* pFrame);
+
+        /** Return a buffer from acquireFrame() without encoding it, for example because it couldn't be filled. The frame is counted as dropped.
+        */
+        void dropFrame(uint8_t* pFrame);
+
+        /** Copy a frame and queue it for encoding
+            \return false if the frame was dropped
+        */
+        bool appendFrame(const void* pData);
+
+        /** Wait until all the queued frames were encoded
+        */
+        void flush();
+
+        /** Encode the remaining frames, stop the worker thread and finalize the encoder. Further frames are dropped.
+        */
+        void endCapture();
+
+        /** Get the statistics
+        */
+        Stats getStats() const;
+
+    private:
+        AsyncVideoEncoder(const FrameFunc& frameFunc, const Desc& desc);
+        void workerFunc();
+
+        Desc mDesc;
+        FrameFunc mFrameFunc;
+        VideoEncoder::UniquePtr mpEncoder;
+
+        std::vector<std::vector<uint8_t>> mFrameStorage;
+        std::vector<uint8_t*> mFreeFrames;
+        std::deque<uint8_t*> mQueuedFrames;
+        bool mEncoding = false;
+        bool mStopping = false;
+        Stats mStats;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mFrameQueuedCV;
+        std::condition_variable mFrameFreedCV;
+        std::thread mWorker;
+    };
+}
\ No newline at end of file
@@ -37,9 +37,46 @@ extern "C"
 }
 
 #include <cstdio>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Utils/CpuTimer.h"
 
 namespace Falcor
 {
+    struct VideoDecoder::StreamingState
+    {
+        StreamingDesc desc;
+        SwsContext* pSwsContext = nullptr;
+
+        // Shared between the worker and the main thread. Protected by the mutex.
+        std::mutex mutex;
+        std::condition_variable workerCV;
+        std::condition_variable frameReadyCV;
+        std::vector<std::unique_ptr<Frame>> frameStorage;
+        std::vector<Frame*> freeFrames;
+        std::deque<std::pair<int64_t, Frame*>> readyFrames;    // Frames are tagged with their index on the unwrapped playback timeline (loop * fileFrameCount + frame)
+        bool stop = false;
+        bool loop = true;
+        bool endOfStream = false;               // The worker reached the end of the file and isn't looping
+        int64_t endFrame = -1;                  // One past the last frame on the playback timeline, once known
+        int64_t fileFrameCount = -1;            // Number of frames in the file, once known
+        bool seekPending = false;
+        int64_t seekFrame = 0;
+        uint32_t seekGeneration = 0;
+        StreamingStats stats;
+
+        // Main thread only
+        double mediaTime = 0;
+        float lastCallTime = -1;
+        int64_t currentFrame = -1;
+        uint32_t nextTexture = 0;
+        Texture::SharedPtr pCurrentTexture;
+
+        std::thread worker;
+    };
+
     float VideoDecoder::rationalToFloat(const AVRational& r)
     {
         return ((float)r.num / (float)r.den);
@@ -56,6 +93,17 @@ namespace Falcor
         return pVideo;
     }
 
+    VideoDecoder::UniquePtr VideoDecoder::createStreaming(const std::string& filename, const StreamingDesc& desc)
+    {
+        auto pVideo = UniquePtr(new VideoDecoder());
+        if(pVideo->startStreaming(filename, desc) == false)
+        {
+            pVideo = nullptr;
+        }
+
+        return pVideo;
+    }
+
     VideoDecoder::VideoDecoder()
     {
     }
@@ -83,6 +131,21 @@ namespace Falcor
             mAsyncDecoding->get();
         }
 
+        // Stop the streaming worker
+        if(mpStream)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mpStream->mutex);
+                mpStream->stop = true;
+            }
+            mpStream->workerCV.notify_one();
+            if(mpStream->worker.joinable())
+            {
+                mpStream->worker.join();
+            }
+            sws_freeContext(mpStream->pSwsContext);
+        }
+
         av_free(mpFrame);
 
         // Close the codec
@@ -90,8 +153,11 @@ namespace Falcor
         // Close the video file
         avformat_close_input(&mpFormatCtx);
 
-        for(auto& tex : (*mFrameTextures))
-            if(tex) tex->makeNonResident(nullptr);
+        if(mFrameTextures)
+        {
+            for(auto& tex : (*mFrameTextures))
+                if(tex) tex->makeNonResident(nullptr);
+        }
     }
 
     void FlipRGBFrame(AVFrame* pFrame, int H)
@@ -113,14 +179,8 @@ namespace Falcor
         delete[] templine;
     }
 
-    void VideoDecoder::bufferFrames()
+    bool VideoDecoder::openFile()
     {
-        if(mAsyncDecoding)
-        {
-            setThreadPriority(getCurrentThread(), ThreadPriorityType::Low);
-            setThreadAffinity(getCurrentThread(), (1<<5)|(1<<6)|(1<<7)|(1<<8));
-        }
-
         if(mpFrame)
         {
             av_free(mpFrame);
@@ -147,13 +207,13 @@ namespace Falcor
         if(avformat_open_input(&mpFormatCtx, mFilename.c_str(), NULL, NULL) != 0)
         {
             printf("Cannot open file\n");
-            return;
+            return false;
         }
 
         if(avformat_find_stream_info(mpFormatCtx, NULL) < 0)
         {
             printf("Couldn't find stream information.\n");
-            return;
+            return false;
         }
 
         for(uint32_t i = 0; i < mpFormatCtx->nb_streams; i++)
@@ -168,7 +228,7 @@ namespace Falcor
 
         if(mVideoStream == -1)
         {
-            return;
+            return false;
         }
 
         auto& stream = mpFormatCtx->streams[mVideoStream];
@@ -184,7 +244,7 @@ namespace Falcor
         if(mpCodec == NULL)
         {
             printf("Unsupported codec!\n");
-            return; // Codec not found
+            return false; // Codec not found
         }
 
         // Copy context
@@ -192,18 +252,32 @@ namespace Falcor
         if(avcodec_copy_context(mpCodecCtx, mpCodecCtxOrig) != 0)
         {
             printf("Couldn't copy codec context\n");
-            return; // Error copying codec context
+            return false; // Error copying codec context
         }
 
         // Open codec
         if(avcodec_open2(mpCodecCtx, mpCodec, nullptr) < 0)
         {
-            return; // Could not open codec
+            return false; // Could not open codec
         }
 
         // Allocate video frame
         mpFrame = av_frame_alloc();
+        return true;
+    }
+
+    void VideoDecoder::bufferFrames()
+    {
+        if(mAsyncDecoding)
+        {
+            setThreadPriority(getCurrentThread(), ThreadPriorityType::Low);
+            setThreadAffinity(getCurrentThread(), (1<<5)|(1<<6)|(1<<7)|(1<<8));
+        }
 
+        if(openFile() == false)
+        {
+            return;
+        }
 
         mFrames.clear();
         mFrames.reserve(mVidBufferCount);
@@ -273,6 +347,87 @@ namespace Falcor
 
     Texture::SharedPtr VideoDecoder::getTextureForNextFrame(float curTime)
     {
+        if(mpStream)
+        {
+            StreamingState& stream = *mpStream;
+            if(stream.lastCallTime >= 0)
+            {
+                stream.mediaTime += (curTime - stream.lastCallTime) * stream.desc.playbackRate;
+            }
+            stream.lastCallTime = curTime;
+            int64_t targetFrame = (int64_t)floor(stream.mediaTime * mFPS);
+
+            Frame* pFrame = nullptr;
+            int64_t frameIndex = -1;
+            {
+                std::unique_lock<std::mutex> lock(stream.mutex);
+                if(stream.endFrame >= 0 && targetFrame >= stream.endFrame)
+                {
+                    // Hold the last frame
+                    targetFrame = stream.endFrame - 1;
+                }
+
+                // Nothing was shown yet (first call or first frame after a seek into an empty texture pool). Wait for the first frame instead of returning nullptr.
+                if(stream.pCurrentTexture == nullptr)
+                {
+                    stream.frameReadyCV.wait(lock, [&stream] {return stream.readyFrames.empty() == false || stream.endOfStream; });
+                    if(stream.readyFrames.empty() == false)
+                    {
+                        targetFrame = std::max(targetFrame, stream.readyFrames.front().first);
+                    }
+                }
+
+                // Take the latest frame which is due. Older frames were never shown.
+                while(stream.readyFrames.empty() == false && stream.readyFrames.front().first <= targetFrame)
+                {
+                    if(pFrame)
+                    {
+                        stream.freeFrames.push_back(pFrame);
+                        stream.stats.skippedFrames++;
+                    }
+                    frameIndex = stream.readyFrames.front().first;
+                    pFrame = stream.readyFrames.front().second;
+                    stream.readyFrames.pop_front();
+                }
+
+                if(pFrame == nullptr && targetFrame > stream.currentFrame)
+                {
+                    stream.stats.underruns++;
+                }
+            }
+
+            if(pFrame)
+            {
+                // The frame is owned by this thread until it's returned to the free list, so the upload doesn't need the lock
+                if(mFrameTextures == nullptr)
+                {
+                    mFrameTextures = std::make_shared<TexturePool>();
+                }
+                TexturePool& textures = *mFrameTextures;
+                uint32_t texIndex = stream.nextTexture;
+                stream.nextTexture = (stream.nextTexture + 1) % stream.desc.textureCount;
+                if(texIndex >= textures.size())
+                {
+                    textures.push_back(Texture::create2D(mpCodecCtx->width, mpCodecCtx->height, ResourceFormat::RGBA8UnormSrgb, 1, 1, pFrame->mpFrameRGB->data[0]));
+                    textures.back()->makeResident(nullptr);
+                }
+                else
+                {
+                    textures[texIndex]->uploadSubresourceData(pFrame->mpFrameRGB->data[0], pFrame->mFrameSize);
+                }
+                stream.pCurrentTexture = textures[texIndex];
+                stream.currentFrame = frameIndex;
+
+                {
+                    std::lock_guard<std::mutex> lock(stream.mutex);
+                    stream.freeFrames.push_back(pFrame);
+                    stream.stats.uploadedFrames++;
+                }
+                stream.workerCV.notify_one();
+            }
+            return stream.pCurrentTexture;
+        }
+
         // Flush the async operation, upload everything to video memory
         if(mAsyncDecoding)
         {
@@ -288,6 +443,19 @@ namespace Falcor
 
     float VideoDecoder::getDuration()
     {
+        if(mpStream)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mpStream->mutex);
+                if(mpStream->fileFrameCount >= 0)
+                {
+                    return (float)mpStream->fileFrameCount / mFPS;
+                }
+            }
+            // The worker didn't reach the end of the file yet, use the container's estimate
+            return (mpFormatCtx->duration > 0) ? (float)mpFormatCtx->duration / (float)AV_TIME_BASE : 0;
+        }
+
         // Flush the async operation, upload everything to video memory
         if(mAsyncDecoding)
         {
@@ -299,6 +467,317 @@ namespace Falcor
         return ((float)mRealFrameCount) / mFPS;
     }
 
+    bool VideoDecoder::startStreaming(const std::string& filename, const StreamingDesc& desc)
+    {
+        mFilename = filename;
+        if(openFile() == false)
+        {
+            return false;
+        }
+
+        mpStream = std::unique_ptr<StreamingState>(new StreamingState);
+        StreamingState& stream = *mpStream;
+        stream.desc = desc;
+        stream.desc.ringSize = std::max(desc.ringSize, 1u);
+        stream.desc.textureCount = std::max(desc.textureCount, 1u);
+        stream.desc.playbackRate = std::max(desc.playbackRate, 0.0f);
+        stream.loop = desc.loop;
+
+        stream.frameStorage.resize(stream.desc.ringSize);
+        for(auto& pFrame : stream.frameStorage)
+        {
+            pFrame = std::unique_ptr<Frame>(new Frame(mpCodecCtx));
+            stream.freeFrames.push_back(pFrame.get());
+        }
+
+        stream.pSwsContext = sws_getContext(mpCodecCtx->width, mpCodecCtx->height, mpCodecCtx->pix_fmt, mpCodecCtx->width, mpCodecCtx->height, PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL);
+        if(stream.pSwsContext == nullptr)
+        {
+            Logger::log(Logger::Level::Error, "VideoDecoder - failed to allocate SWScale context for " + filename);
+            return false;
+        }
+
+        stream.worker = std::thread(&VideoDecoder::streamFrames, this);
+        return true;
+    }
+
+    bool VideoDecoder::decodeNextFrame(int64_t& fileFrame)
+    {
+        AVPacket packet;
+        int32_t isFrameDone = 0;
+        while(isFrameDone == 0)
+        {
+            if(av_read_frame(mpFormatCtx, &packet) < 0)
+            {
+                // End of file. Drain the frames the decoder is still holding (B-frames are decoded out of order).
+                av_init_packet(&packet);
+                packet.data = nullptr;
+                packet.size = 0;
+                avcodec_decode_video2(mpCodecCtx, mpFrame, &isFrameDone, &packet);
+                if(isFrameDone == 0)
+                {
+                    return false;
+                }
+                break;
+            }
+
+            if(packet.stream_index == mVideoStream)
+            {
+                avcodec_decode_video2(mpCodecCtx, mpFrame, &isFrameDone, &packet);
+            }
+            av_free_packet(&packet);
+        }
+
+        // Frame index from the timestamp, so that seeking lands on the right frame. Fall back to counting if the stream has no timestamps.
+        const AVStream* pStream = mpFormatCtx->streams[mVideoStream];
+        int64_t timestamp = av_frame_get_best_effort_timestamp(mpFrame);
+        if(timestamp == AV_NOPTS_VALUE)
+        {
+            fileFrame = mLastFileFrame + 1;
+        }
+        else
+        {
+            if(pStream->start_time != AV_NOPTS_VALUE)
+            {
+                timestamp -= pStream->start_time;
+            }
+            fileFrame = (int64_t)floor(timestamp * av_q2d(pStream->time_base) * mFPS + 0.5);
+        }
+        mLastFileFrame = fileFrame;
+        return true;
+    }
+
+    void VideoDecoder::seekFile(int64_t fileFrame)
+    {
+        const AVStream* pStream = mpFormatCtx->streams[mVideoStream];
+        int64_t timestamp = (int64_t)((double)fileFrame / mFPS / av_q2d(pStream->time_base));
+        if(pStream->start_time != AV_NOPTS_VALUE)
+        {
+            timestamp += pStream->start_time;
+        }
+
+        // Seeking lands on the previous keyframe. The frames until the requested one are decoded and discarded by the caller.
+        av_seek_frame(mpFormatCtx, mVideoStream, timestamp, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(mpCodecCtx);
+        mLastFileFrame = fileFrame - 1;
+    }
+
+    void VideoDecoder::convertFrame(Frame* pFrame, SwsContext* pSwsContext)
+    {
+        // Flip while converting by writing the rows bottom-up, instead of swapping them afterwards
+        uint8_t* pDst[4] = {pFrame->mpFrameRGB->data[0], nullptr, nullptr, nullptr};
+        int32_t dstStride[4] = {pFrame->mpFrameRGB->linesize[0], 0, 0, 0};
+        if(mFlipY)
+        {
+            pDst[0] += (mpCodecCtx->height - 1) * dstStride[0];
+            dstStride[0] = -dstStride[0];
+        }
+        sws_scale(pSwsContext, (uint8_t const * const *)mpFrame->data, mpFrame->linesize, 0, mpCodecCtx->height, pDst, dstStride);
+    }
+
+    void VideoDecoder::streamFrames()
+    {
+        setThreadPriority(getCurrentThread(), ThreadPriorityType::Low);
+
+        StreamingState& stream = *mpStream;
+        int64_t loopBase = 0;       // Playback-timeline index of the first frame of the current pass over the file
+        int64_t skipUntil = 0;      // Frames before this one are decoded but not kept (after seeking to a keyframe)
+        int64_t maxFileFrame = -1;  // Used to find the frame count when reaching the end of the file
+
+        std::unique_lock<std::mutex> lock(stream.mutex);
+        while(true)
+        {
+            stream.workerCV.wait(lock, [&stream] {return stream.stop || stream.seekPending || (stream.freeFrames.empty() == false && stream.endOfStream == false); });
+            if(stream.stop)
+            {
+                break;
+            }
+
+            if(stream.seekPending)
+            {
+                stream.seekPending = false;
+                int64_t target = stream.seekFrame;
+                int64_t fileFrameCount = stream.fileFrameCount;
+                lock.unlock();
+
+                int64_t fileFrame = (fileFrameCount > 0) ? target % fileFrameCount : target;
+                loopBase = target - fileFrame;
+                skipUntil = fileFrame;
+                seekFile(fileFrame);
+
+                lock.lock();
+                continue;
+            }
+
+            Frame* pFrame = stream.freeFrames.back();
+            stream.freeFrames.pop_back();
+            uint32_t generation = stream.seekGeneration;
+            bool loop = stream.loop;
+            lock.unlock();
+
+            auto start = CpuTimer::getCurrentTimePoint();
+            int64_t fileFrame = 0;
+            bool gotFrame = decodeNextFrame(fileFrame);
+            bool keepFrame = gotFrame && (fileFrame >= skipUntil);
+            if(keepFrame)
+            {
+                convertFrame(pFrame, stream.pSwsContext);
+            }
+            double decodeTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+            if(gotFrame)
+            {
+                maxFileFrame = std::max(maxFileFrame, fileFrame);
+            }
+            else if(loop)
+            {
+                seekFile(0);
+            }
+
+            lock.lock();
+            stream.stats.decodeTimeInMs += decodeTime;
+            if(gotFrame)
+            {
+                stream.stats.decodedFrames++;
+            }
+
+            if(generation != stream.seekGeneration)
+            {
+                // A seek was requested while decoding. The frame and the end-of-file state belong to the old position.
+                stream.freeFrames.push_back(pFrame);
+                continue;
+            }
+
+            if(gotFrame == false)
+            {
+                if(stream.fileFrameCount < 0)
+                {
+                    stream.fileFrameCount = maxFileFrame + 1;
+                }
+
+                // An empty file can't loop
+                if(loop && stream.fileFrameCount > 0)
+                {
+                    loopBase += stream.fileFrameCount;
+                    skipUntil = 0;
+                }
+                else
+                {
+                    stream.endOfStream = true;
+                    stream.endFrame = loopBase + stream.fileFrameCount;
+                    stream.frameReadyCV.notify_all();
+                }
+            }
+
+            if(keepFrame)
+            {
+                stream.readyFrames.push_back(std::make_pair(loopBase + fileFrame, pFrame));
+                stream.frameReadyCV.notify_all();
+            }
+            else
+            {
+                stream.freeFrames.push_back(pFrame);
+            }
+        }
+    }
+
+    void VideoDecoder::seek(float time)
+    {
+        if(mpStream == nullptr)
+        {
+            Logger::log(Logger::Level::Warning, "VideoDecoder::seek() is only supported in streaming mode.");
+            return;
+        }
+
+        StreamingState& stream = *mpStream;
+        time = std::max(time, 0.0f);
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            if(stream.loop == false && stream.fileFrameCount > 0)
+            {
+                time = std::min(time, (float)(stream.fileFrameCount - 1) / mFPS);
+            }
+
+            for(auto& ready : stream.readyFrames)
+            {
+                stream.freeFrames.push_back(ready.second);
+            }
+            stream.readyFrames.clear();
+            stream.seekPending = true;
+            stream.seekFrame = (int64_t)floor(time * mFPS);
+            stream.seekGeneration++;
+            stream.endOfStream = false;
+            stream.endFrame = -1;
+        }
+        stream.workerCV.notify_one();
+
+        stream.mediaTime = time;
+        stream.currentFrame = -1;
+    }
+
+    void VideoDecoder::setLoop(bool loop)
+    {
+        if(mpStream == nullptr)
+        {
+            Logger::log(Logger::Level::Warning, "VideoDecoder::setLoop() is only supported in streaming mode.");
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mpStream->mutex);
+            mpStream->loop = loop;
+            if(loop && mpStream->endOfStream)
+            {
+                // The worker stopped at the end of the file. The next decode fails and takes the looping path.
+                mpStream->endOfStream = false;
+                mpStream->endFrame = -1;
+            }
+        }
+        mpStream->workerCV.notify_one();
+    }
+
+    void VideoDecoder::setPlaybackRate(float rate)
+    {
+        if(mpStream == nullptr)
+        {
+            Logger::log(Logger::Level::Warning, "VideoDecoder::setPlaybackRate() is only supported in streaming mode.");
+            return;
+        }
+        mpStream->desc.playbackRate = std::max(rate, 0.0f);
+    }
+
+    VideoDecoder::StreamingStats VideoDecoder::getStreamingStats() const
+    {
+        StreamingStats stats;
+        if(mpStream)
+        {
+            std::lock_guard<std::mutex> lock(mpStream->mutex);
+            stats = mpStream->stats;
+            stats.bufferedFrames = (uint32_t)mpStream->readyFrames.size();
+        }
+        stats.decodeFps = (stats.decodeTimeInMs > 0) ? (float)(stats.decodedFrames * 1000.0 / stats.decodeTimeInMs) : 0;
+        return stats;
+    }
+
+    int64_t VideoDecoder::getCurrentFrame() const
+    {
+        return mpStream ? mpStream->currentFrame : -1;
+    }
+
+    bool VideoDecoder::waitForFrame(int64_t frameIndex)
+    {
+        if(mpStream == nullptr)
+        {
+            return false;
+        }
+
+        // The worker can't make progress once every frame in the ring is decoded and waiting to be shown
+        StreamingState& stream = *mpStream;
+        std::unique_lock<std::mutex> lock(stream.mutex);
+        stream.frameReadyCV.wait(lock, [&] {return stream.endOfStream || stream.readyFrames.size() == stream.frameStorage.size() || (stream.readyFrames.empty() == false && stream.readyFrames.back().first >= frameIndex); });
+        return stream.readyFrames.empty() == false && stream.readyFrames.back().first >= frameIndex;
+    }
+
     VideoDecoder::TexturePoolPtr VideoDecoder::getTexturePool()
     {
         return mFrameTextures;
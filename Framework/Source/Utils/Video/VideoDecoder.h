@@ -42,8 +42,10 @@ struct AVRational;
 namespace Falcor
 {        
     /** Simple video decoder for high-framerate and high-resolution
-    playback of rendered videos. Currently decodes the first N frames
+    playback of rendered videos. By default decodes the first N frames
     as textures before playing.
+    In streaming mode (see createStreaming()) a worker thread decodes a few frames ahead of the playback time into a fixed ring of CPU frames,
+    which are uploaded into a small pool of reusable textures. Memory usage doesn't depend on the clip length.
     */
     class VideoDecoder
     {
@@ -54,14 +56,48 @@ namespace Falcor
         typedef std::vector<Texture::SharedPtr> TexturePool;
         typedef std::shared_ptr<TexturePool> TexturePoolPtr;
 
+        /** Streaming mode settings
+        */
+        struct StreamingDesc
+        {
+            uint32_t ringSize = 8;          ///< Number of decoded frames buffered on the CPU ahead of playback
+            uint32_t textureCount = 3;      ///< Number of textures the frames are uploaded into, round-robin. More than 1 avoids updating a texture the GPU is still reading.
+            bool loop = true;               ///< Restart the clip when reaching the end
+            float playbackRate = 1;         ///< Playback speed multiplier. Must not be negative.
+        };
+
+        /** Streaming mode statistics
+        */
+        struct StreamingStats
+        {
+            uint64_t decodedFrames = 0;
+            uint64_t uploadedFrames = 0;
+            uint64_t skippedFrames = 0;     ///< Decoded frames which were never shown, because playback had already moved past them
+            uint64_t underruns = 0;         ///< Calls to getTextureForNextFrame() where the frame wasn't decoded yet, so the previous frame was shown again
+            double decodeTimeInMs = 0;      ///< Total time spent decoding and converting frames
+            float decodeFps = 0;            ///< Decoding throughput in frames per second of decode time
+            uint32_t bufferedFrames = 0;    ///< Frames currently waiting in the ring
+        };
+
         /** create a new videoplay object
             \param[in] filename Input video file (with path)
             \param[in] bufferFrames The maximum number of input frames to buffer as Texture objects. Default is 300.
         */
         static UniquePtr create(const std::string& filename, uint32_t bufferedFrames = 300, bool async = false);
+
+        /** create a new videoplay object in streaming mode
+            \param[in] filename Input video file (with path)
+            \param[in] desc Streaming settings
+        */
+        static UniquePtr createStreaming(const std::string& filename, const StreamingDesc& desc);
+
+        /** create a new videoplay object in streaming mode, using the default settings
+        */
+        static UniquePtr createStreaming(const std::string& filename) { return createStreaming(filename, StreamingDesc()); }
         ~VideoDecoder();
 
         /** Get a texture object for the frame at current time
+            In streaming mode, the playback position advances by the time passed since the previous call, scaled by the playback rate. The texture is only valid until the next textureCount calls.
             \param[in] curTime Time for which frame is sought
             \return Texture pointer to texture object
         */
@@ -83,6 +119,40 @@ namespace Falcor
 
         bool load(const std::string& filename, uint32_t bufferedFrames, bool async);
 
+        /** Jump to a position in the clip. Streaming mode only.
+            \param[in] time The new playback position in seconds
+        */
+        void seek(float time);
+
+        /** Enable or disable looping. Streaming mode only.
+        */
+        void setLoop(bool loop);
+
+        /** Set the playback speed multiplier. Streaming mode only.
+        */
+        void setPlaybackRate(float rate);
+
+        /** Check if the object was created in streaming mode
+        */
+        bool isStreaming() const { return mpStream != nullptr; }
+
+        /** Get the streaming statistics
+        */
+        StreamingStats getStreamingStats() const;
+
+        /** Get the index of the frame shown by the last getTextureForNextFrame() call. Streaming mode only.
+            Indices are on the playback timeline, so looping playback keeps counting past the end of the clip.
+            \return The frame index, or -1 if no frame was shown since the decoder was created or since the last seek()
+        */
+        int64_t getCurrentFrame() const;
+
+        /** Wait until a frame is decoded, so that the next getTextureForNextFrame() call doesn't depend on the decoding speed. Streaming mode only.
+            Useful when rendering offline, for example when capturing a video.
+            \param[in] frameIndex The frame index on the playback timeline
+            \return true if the frame is ready. false if the clip ended before it, or if the ring holds StreamingDesc#ringSize earlier frames which weren't shown yet.
+        */
+        bool waitForFrame(int64_t frameIndex);
+
     private:
         /** Holds a single video frame on CPU
         */
@@ -96,9 +166,17 @@ namespace Falcor
             int         mFrameSize = 0;
         };
 
+        struct StreamingState;
+
         VideoDecoder();
 
         void uploadToGPU(int frameStart = 0);
+        bool openFile();
+        bool startStreaming(const std::string& filename, const StreamingDesc& desc);
+        void streamFrames();
+        bool decodeNextFrame(int64_t& fileFrame);
+        void seekFile(int64_t fileFrame);
+        void convertFrame(Frame* pFrame, SwsContext* pSwsContext);
 
         std::string mFilename;
 
@@ -118,6 +196,8 @@ namespace Falcor
         std::shared_ptr<std::future<void>>        mAsyncDecoding = nullptr;
 
         TexturePoolPtr                          mFrameTextures;
+        std::unique_ptr<StreamingState>         mpStream;
+        int64_t                                 mLastFileFrame    = -1;
 
         // helper routines
         void  bufferFrames();
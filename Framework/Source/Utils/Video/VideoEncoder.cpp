@@ -293,10 +293,8 @@ namespace Falcor
 
         mForamt = desc.format;
         mRowPitch = getInputFormatBytesPerPixel(desc.format) * desc.width;
-        if(desc.flipY)
-        {
-            mpFlippedImage = new uint8_t[desc.height * mRowPitch];
-        }
+        mFlipY = desc.flipY;
+        mHeight = desc.height;
 
         AVPixelFormat pixFormat = getPictureFormatFromCodec(pOutputFormat->video_codec);
 
@@ -337,26 +335,19 @@ namespace Falcor
             sws_freeContext(mpSwsContext);
             mpSwsContext = nullptr;
         }
-        safe_delete(mpFlippedImage)
     }
 
     void VideoEncoder::appendFrame(const void* pData)
     {
-        if(mpFlippedImage)
+        // Convert input data to YUV. Flipping is done by pointing sws_scale() at the last row and using a negative stride, which saves a copy of the frame.
+        const uint8_t* pSrc = (const uint8_t*)pData;
+        int32_t srcStride = (int32_t)mRowPitch;
+        if(mFlipY)
         {
-            // Flip the image
-            for(int32_t h = 0; h < mpOutputStream->codec->height; h++)
-            {
-                const uint8_t* pSrc = (uint8_t*)pData + h * mRowPitch;
-                uint8_t* pDst = mpFlippedImage + (mpOutputStream->codec->height - 1 - h) * mRowPitch;
-                memcpy(pDst, pSrc, mRowPitch);
-            }
-
-            pData = mpFlippedImage;
+            pSrc += (mHeight - 1) * mRowPitch;
+            srcStride = -srcStride;
         }
-
-        // Convert input data to YUV
-        sws_scale(mpSwsContext, (uint8_t**)&pData, (int32_t*)&mRowPitch, 0, mpOutputStream->codec->height, mpYUVPicture->data, mpYUVPicture->linesize);
+        sws_scale(mpSwsContext, &pSrc, &srcStride, 0, mHeight, mpYUVPicture->data, mpYUVPicture->linesize);
 
         // Initialize the packet
         AVPacket packet = {0};
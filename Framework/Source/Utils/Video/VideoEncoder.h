@@ -90,6 +90,7 @@ namespace Falcor
         InputFormat mForamt;
         uint32_t mRowPitch = 0;
         uint32_t mFrameCount = 0;
-        uint8_t* mpFlippedImage = nullptr; // Used in case the image memory layout if bottom->top
+        uint32_t mHeight = 0;
+        bool mFlipY = false;    // Used in case the image memory layout is bottom->top
     };
 }
\ No newline at end of file
@@ -53,6 +53,7 @@ namespace Falcor
         mpUI->addIntVar("GOP Size", (int32_t*)&mGopSize, "Codec Options", 0, 100000, 1);
 
         mpUI->addCheckBox("Capture UI", &mCaptureUI);
+        mpUI->addCheckBox("Drop Frames When Encoder Is Busy", &mDropFrames);
         
         mpUI->addCheckBox("Use Time-Range", &mUseTimeRange);
         mpUI->addFloatVar("Start Time", &mStartTime, "Time Range", 0, FLT_MAX, 0.001f);
@@ -49,6 +49,7 @@ namespace Falcor
         const std::string& getFilename() const { return mFilename; }
         float getBitrate() const {return mBitrate; }
         uint32_t getGopSize() const {return mGopSize; }
+        bool dropFrames() const { return mDropFrames; }
 
     private:
         VideoEncoderUI(uint32_t topLeftX, uint32_t topLeftY, uint32_t width, uint32_t height, Gui::ButtonCallback startCaptureCB, Gui::ButtonCallback endCaptureCB, void* pUserData);
@@ -68,6 +69,7 @@ namespace Falcor
 
         bool mUseTimeRange = false;
         bool mCaptureUI = false;
+        bool mDropFrames = false;
         float mStartTime = 0;
         float mEndTime = FLT_MAX;
 
@@ -48,6 +48,10 @@ layout(binding = 0) uniform PerImageCB
 	vec3 gAmbient;
     // Debug mode
 	uint gDebugMode;
+#ifdef _CLUSTERED_LIGHTS
+    // Point lights culled on the CPU, see LightClusters
+	LightClusterData gLightClusters;
+#endif
 };
 
 out vec4 fragColor;
@@ -81,6 +85,16 @@ void main()
 	evalMaterial(shAttr, gDirLight, result, true);
 	// Point light
 	evalMaterial(shAttr, gPointLight, result, false);
+#ifdef _CLUSTERED_LIGHTS
+	// The lights of the cluster containing the pixel
+	vec4 posV = gCam.viewMat * vec4(posW, 1.f);
+	vec4 posH = gCam.viewProjMat * vec4(posW, 1.f);
+	uvec2 cluster = getLightCluster(gLightClusters, posH.xy / posH.w, -posV.z);
+	for(uint i = 0; i < cluster.y; i++)
+	{
+		evalMaterial(shAttr, getClusterLight(gLightClusters, cluster, i), result, false);
+	}
+#endif
 	// Add ambient term
 	result.finalValue += gAmbient * result.diffuseAlbedo;
 	result.diffuseIllumination += gAmbient;
@@ -70,6 +70,25 @@ void SimpleDeferred::loadModelFromFile(const std::string& filename)
 
     float Radius = mpModel->getRadius();
     mpPointLight->setWorldPosition(glm::vec3(0, Radius*1.25f, 0));
+    mClusteredLights.clear();
+}
+
+void SimpleDeferred::createClusteredLights()
+{
+    // Scatter small colored lights inside the model's bounding sphere. Each one reaches about a tenth of the model radius before falling below the cluster threshold.
+    const float radius = mpModel->getRadius();
+    const float reach = radius * 0.1f;
+    const float intensity = reach * reach * mpLightClusters->getIntensityThreshold();
+    mClusteredLights.clear();
+    for(int32_t i = 0; i < mClusteredLightCount; i++)
+    {
+        PointLight::SharedPtr pLight = PointLight::create();
+        glm::vec3 offset = glm::vec3(rand(), rand(), rand()) / float(RAND_MAX) * 2.0f - 1.0f;
+        glm::vec3 color = glm::vec3(rand(), rand(), rand()) / float(RAND_MAX);
+        pLight->setWorldPosition(mpModel->getCenter() + offset * radius);
+        pLight->setIntensity(color * intensity);
+        mClusteredLights.push_back(pLight);
+    }
 }
 
 void SimpleDeferred::loadModel()
@@ -110,6 +129,8 @@ void SimpleDeferred::initUI()
     mpGui->nestGroups(lightGroup, "Directional Light");
     mpPointLight->setUiElements(mpGui.get(), "Point Light");
     mpGui->nestGroups(lightGroup, "Point Light");
+    mpGui->addCheckBox("Clustered Lights", &mUseClusteredLights, lightGroup);
+    mpGui->addIntVar("Clustered Light Count", &mClusteredLightCount, lightGroup, 1, 65536);
 
     Gui::dropdown_list cameraList;
     cameraList.push_back({ModelViewCamera, "Model-View"});
@@ -171,6 +192,10 @@ void SimpleDeferred::onLoad()
 	mpDeferredPassProgram = Program::createFromFile("", "DeferredPass.fs");
 
     mpLightingPass = FullScreenPass::create("LightingPass.fs");
+    Program::DefineList clusteredDefines;
+    clusteredDefines.add("_CLUSTERED_LIGHTS");
+    mpClusteredLightingPass = FullScreenPass::create("LightingPass.fs", clusteredDefines);
+    mpLightClusters = LightClusters::create();
 
     // create rasterizer state
     RasterizerState::Desc rsDesc;
@@ -204,6 +229,7 @@ void SimpleDeferred::onLoad()
 
     mpDeferredPerFrameCB = UniformBuffer::create(mpDeferredPassProgram->getActiveProgramVersion().get(), "PerFrameCB");
     mpLightingFrameCB = UniformBuffer::create(mpLightingPass->getProgram()->getActiveProgramVersion().get(), "PerImageCB");
+    mpClusteredLightingFrameCB = UniformBuffer::create(mpClusteredLightingPass->getProgram()->getActiveProgramVersion().get(), "PerImageCB");
 
     // Load default model
     loadModelFromFile("Ogre/bs_rest.obj");
@@ -265,22 +291,28 @@ void SimpleDeferred::onFrameRender()
         mpRenderContext->setBlendState(mpOpaqueBS);
         mpRenderContext->setDepthStencilState(mpNoDepthDS, 0);
 
-        // Set lighting params
-        mpLightingFrameCB->setVariable("gAmbient", mAmbientIntensity);
-        mpDirLight->setIntoUniformBuffer(mpLightingFrameCB.get(), "gDirLight");
-        mpPointLight->setIntoUniformBuffer(mpLightingFrameCB.get(), "gPointLight");
-
-        // Set GBuffer as input
-        mpLightingFrameCB->setTexture("gGBuf0", mpGBufferFbo->getColorTexture(0).get(), nullptr);
-        mpLightingFrameCB->setTexture("gGBuf1", mpGBufferFbo->getColorTexture(1).get(), nullptr);
-        mpLightingFrameCB->setTexture("gGBuf2", mpGBufferFbo->getColorTexture(2).get(), nullptr);
-
-        // Debug mode
-        mpLightingFrameCB->setVariable("gDebugMode", (uint32_t)mDebugMode);
-
-        // Kick it off
-        mpRenderContext->setUniformBuffer(0, mpLightingFrameCB);
-        mpLightingPass->execute(mpRenderContext.get());
+        if(mUseClusteredLights && mpModel)
+        {
+            // Build the light lists for the current view
+            if(mClusteredLights.size() != (size_t)mClusteredLightCount)
+            {
+                createClusteredLights();
+            }
+            {
+                PROFILE(BuildLightClusters);
+                mpLightClusters->update(mpCamera.get(), mClusteredLights);
+            }
+            setLightingParams(mpClusteredLightingFrameCB.get());
+            mpLightClusters->setIntoUniformBuffer(mpClusteredLightingFrameCB.get(), "gLightClusters");
+            mpRenderContext->setUniformBuffer(0, mpClusteredLightingFrameCB);
+            mpClusteredLightingPass->execute(mpRenderContext.get());
+        }
+        else
+        {
+            setLightingParams(mpLightingFrameCB.get());
+            mpRenderContext->setUniformBuffer(0, mpLightingFrameCB);
+            mpLightingPass->execute(mpRenderContext.get());
+        }
     }
 
 	// Display upscaling pass
@@ -301,6 +333,22 @@ void SimpleDeferred::onFrameRender()
     renderText(getGlobalSampleMessage(true), glm::vec2(10, 10));
 }
 
+void SimpleDeferred::setLightingParams(UniformBuffer* pBuffer)
+{
+    // Set lighting params
+    pBuffer->setVariable("gAmbient", mAmbientIntensity);
+    mpDirLight->setIntoUniformBuffer(pBuffer, "gDirLight");
+    mpPointLight->setIntoUniformBuffer(pBuffer, "gPointLight");
+
+    // Set GBuffer as input
+    pBuffer->setTexture("gGBuf0", mpGBufferFbo->getColorTexture(0).get(), nullptr);
+    pBuffer->setTexture("gGBuf1", mpGBufferFbo->getColorTexture(1).get(), nullptr);
+    pBuffer->setTexture("gGBuf2", mpGBufferFbo->getColorTexture(2).get(), nullptr);
+
+    // Debug mode
+    pBuffer->setVariable("gDebugMode", (uint32_t)mDebugMode);
+}
+
 void SimpleDeferred::onShutdown()
 {
 
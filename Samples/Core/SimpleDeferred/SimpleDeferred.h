@@ -51,6 +51,8 @@ private:
     void loadModelFromFile(const std::string& filename);
     void resetCamera();
     void setModelUIElements();
+    void createClusteredLights();
+    void setLightingParams(UniformBuffer* pBuffer);
 
     Model::SharedPtr mpModel = nullptr;
     ModelViewCameraController mModelViewCameraController;
@@ -63,6 +65,14 @@ private:
     UniformBuffer::SharedPtr mpLightingFrameCB;
     FullScreenPass::UniquePtr mpLightingPass;
 
+    // Many point lights, culled with LightClusters
+    bool mUseClusteredLights = false;
+    int32_t mClusteredLightCount = 1024;
+    LightClusters::UniquePtr mpLightClusters;
+    std::vector<Light::SharedPtr> mClusteredLights;
+    UniformBuffer::SharedPtr mpClusteredLightingFrameCB;
+    FullScreenPass::UniquePtr mpClusteredLightingPass;
+
     float mAspectRatio = 0;
 
     enum
@@ -35,6 +35,7 @@ void Shadows::initUI()
     mpGui->addCheckBox("Visualize Cascades", &mControls.visualizeCascades);
     mpGui->addCheckBox("Display Shadow Map", &mControls.showShadowMap);
     mpGui->addIntVar("Displayed Cascade", &mControls.displayedCascade, "", 0, mControls.cascadeCount - 1);
+    mpGui->addCheckBox("Record Main Pass", &mControls.recordMainPass);
 
     Gui::setGlobalHelpMessage("Sample application to load and display a model.\nUse the UI to switch between wireframe and solid mode.");
     // Load model group
@@ -106,14 +107,32 @@ void Shadows::onLoad()
 
 void Shadows::runMainPass()
 {
-    mpRenderContext->setBlendState(nullptr);
-    mpRenderContext->setDepthStencilState(nullptr, 0);
     setSceneLightsIntoUniformBuffer(mpScene.get(), mLightingPass.pPerFrameCB.get());
     mLightingPass.pPerFrameCB->setVariable("visualizeCascades", mControls.visualizeCascades);
     mLightingPass.pPerFrameCB->setVariable("lightIndex", mControls.lightIndex);
     mLightingPass.pPerFrameCB->setVariable("camVpAtLastCsmUpdate", mCamVpAtLastCsmUpdate);
-    mpRenderContext->setUniformBuffer(0, mLightingPass.pPerFrameCB);
-    mpRenderer->renderScene(mpRenderContext.get(), mLightingPass.pProgram.get());
+
+    if(mControls.recordMainPass)
+    {
+        // Record the pass into a command list, then replay it. The result should be identical to rendering directly.
+        if(mpMainPassList == nullptr)
+        {
+            mpMainPassList = CommandList::create();
+        }
+        mpMainPassList->reset();
+        mpMainPassList->setBlendState(nullptr);
+        mpMainPassList->setDepthStencilState(nullptr, 0);
+        mpMainPassList->setUniformBuffer(0, mLightingPass.pPerFrameCB);
+        mpRenderer->recordScene(mpMainPassList.get(), mLightingPass.pProgram.get(), mpScene->getActiveCamera().get());
+        mpMainPassList->execute(mpRenderContext.get());
+    }
+    else
+    {
+        mpRenderContext->setBlendState(nullptr);
+        mpRenderContext->setDepthStencilState(nullptr, 0);
+        mpRenderContext->setUniformBuffer(0, mLightingPass.pPerFrameCB);
+        mpRenderer->renderScene(mpRenderContext.get(), mLightingPass.pProgram.get());
+    }
 }
 
 void Shadows::displayShadowMap()
@@ -160,7 +179,12 @@ void Shadows::onFrameRender()
         }
     }
 
-    renderText(getGlobalSampleMessage(true), glm::vec2(10, 10));
+    std::string msg = getGlobalSampleMessage(true);
+    if(mControls.recordMainPass && mpMainPassList)
+    {
+        msg += "\nMain pass: " + std::to_string(mpMainPassList->getCommandCount()) + " commands, " + std::to_string(mpMainPassList->getSize() / 1024) + " KB";
+    }
+    renderText(msg, glm::vec2(10, 10));
 }
 
 void Shadows::onShutdown()
@@ -70,6 +70,7 @@ private:
 
     glm::vec3 mAmbientIntensity = glm::vec3(0.1f, 0.1f, 0.1f);
     SceneRenderer::UniquePtr mpRenderer;
+    CommandList::SharedPtr mpMainPassList;
     glm::mat4 mCamVpAtLastCsmUpdate;
 
     struct Controls
@@ -80,6 +81,7 @@ private:
         int32_t displayedCascade = 0;
         uint32_t cascadeCount = 4;
         int32_t lightIndex = 0;
+        bool recordMainPass = false;
     };
     Controls mControls;
 
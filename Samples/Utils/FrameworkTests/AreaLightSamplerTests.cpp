@@ -0,0 +1,273 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include <algorithm>
+
+/** Pearson's chi-square test of observed counts against expected counts. Bins with an expected count of zero must stay empty.
+    The threshold is about five standard deviations above the mean of the chi-square distribution, so a correct sampler practically never fails with the fixed seeds.
+*/
+static bool checkChiSquare(const std::string& name, const std::vector<uint32_t>& counts, const std::vector<double>& expected)
+{
+    double chiSquare = 0;
+    uint32_t degreesOfFreedom = 0;
+    for(size_t i = 0; i < counts.size(); i++)
+    {
+        if(expected[i] <= 0)
+        {
+            if(counts[i] != 0)
+            {
+                Logger::log(Logger::Level::Error, "testAreaLightSampler() - " + name + " sampled bin " + std::to_string(i) + ", which has a zero probability");
+                return false;
+            }
+            continue;
+        }
+        double delta = counts[i] - expected[i];
+        chiSquare += delta * delta / expected[i];
+        degreesOfFreedom++;
+    }
+    degreesOfFreedom = (degreesOfFreedom > 0) ? degreesOfFreedom - 1 : 0;
+    double threshold = degreesOfFreedom + 5 * sqrt(2.0 * degreesOfFreedom);
+    if(chiSquare > threshold)
+    {
+        Logger::log(Logger::Level::Error, "testAreaLightSampler() - " + name + " failed the chi-square test: " + std::to_string(chiSquare) + " with " + std::to_string(degreesOfFreedom) + " degrees of freedom");
+        return false;
+    }
+    return true;
+}
+
+static bool testAliasTable(const std::string& name, const std::vector<float>& weights, RandomGenerator& rng)
+{
+    AliasTable::SharedPtr pTable = AliasTable::create(weights);
+    double sum = 0;
+    for(float w : weights)
+    {
+        sum += w;
+    }
+
+    // The probability of an index is its own bucket's threshold, plus the leftovers of the buckets aliasing to it
+    const uint32_t count = pTable->getCount();
+    const auto& entries = pTable->getEntries();
+    std::vector<double> tableProbabilities(count, 0);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        tableProbabilities[i] += entries[i].threshold / (double)count;
+        tableProbabilities[entries[i].alias] += (1.0 - entries[i].threshold) / (double)count;
+    }
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        double expected = (sum > 0) ? weights[i] / sum : 1.0 / count;
+        if(std::abs(tableProbabilities[i] - expected) > 1e-5 || std::abs(pTable->getProbability(i) - expected) > 1e-5)
+        {
+            Logger::log(Logger::Level::Error, "testAreaLightSampler() - " + name + " alias table probability mismatch at index " + std::to_string(i) + ": " +
+                std::to_string(tableProbabilities[i]) + ", expected " + std::to_string(expected));
+            return false;
+        }
+    }
+
+    // Both sampling functions
+    const uint32_t sampleCount = 200000;
+    std::vector<double> expected(count);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        expected[i] = ((sum > 0) ? weights[i] / sum : 1.0 / count) * sampleCount;
+    }
+    std::vector<uint32_t> counts(count, 0);
+    std::vector<uint32_t> countsTwoNumbers(count, 0);
+    for(uint32_t i = 0; i < sampleCount; i++)
+    {
+        counts[pTable->sample(rng.nextFloat())]++;
+        countsTwoNumbers[pTable->sample(rng.nextFloat(), rng.nextFloat())]++;
+    }
+    bool success = checkChiSquare(name + " AliasTable::sample(u)", counts, expected);
+    success = checkChiSquare(name + " AliasTable::sample(u0, u1)", countsTwoNumbers, expected) && success;
+    return success;
+}
+
+/** Checks the alias table against the weights it was built from, and the triangle and position distributions of AreaLightSampler::samplePosition() with chi-square tests
+*/
+bool testAreaLightSampler(RenderContext* pRenderContext)
+{
+    bool success = true;
+    RandomGenerator rng;
+
+    // Alias tables, including zero weights, a dominant weight and the uniform fallback
+    std::vector<float> randomWeights(100);
+    std::vector<float> zeroWeights(64);
+    std::vector<float> dominantWeights(50, 0.001f);
+    for(size_t i = 0; i < randomWeights.size(); i++)
+    {
+        randomWeights[i] = rng.nextFloat(0, 10);
+    }
+    for(size_t i = 0; i < zeroWeights.size(); i++)
+    {
+        zeroWeights[i] = (i % 3) ? rng.nextFloat() : 0.0f;
+    }
+    dominantWeights[17] = 1000;
+    success = testAliasTable("random weights", randomWeights, rng) && success;
+    success = testAliasTable("zero weights", zeroWeights, rng) && success;
+    success = testAliasTable("a dominant weight", dominantWeights, rng) && success;
+    success = testAliasTable("a single weight", std::vector<float>(1, 2.0f), rng) && success;
+    success = testAliasTable("all-zero weights", std::vector<float>(8, 0.0f), rng) && success;
+
+    // Triangle selection is proportional to the area, including degenerate triangles
+    const uint32_t triangleCount = 40;
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for(uint32_t i = 0; i < triangleCount; i++)
+    {
+        glm::vec3 p0(rng.nextFloat(-1, 1), rng.nextFloat(-1, 1), rng.nextFloat(-1, 1));
+        float scale = (i % 8 == 0) ? 10.0f : 1.0f;
+        glm::vec3 p1 = p0 + scale * glm::vec3(rng.nextFloat(-1, 1), rng.nextFloat(-1, 1), rng.nextFloat(-1, 1));
+        glm::vec3 p2 = (i % 13 == 5) ? p1 : p0 + glm::vec3(rng.nextFloat(-1, 1), rng.nextFloat(-1, 1), rng.nextFloat(-1, 1));
+        for(const glm::vec3& p : {p0, p1, p2})
+        {
+            indices.push_back((uint32_t)positions.size());
+            positions.push_back(p);
+        }
+    }
+
+    AreaLightSampler::SharedPtr pSampler = AreaLightSampler::create(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size());
+    const std::vector<float>& cdf = pSampler->getCDF();
+    if(std::abs(pSampler->getAreaPdf() * pSampler->getSurfaceArea() - 1) > 1e-5f || cdf.back() != 1.0f)
+    {
+        Logger::log(Logger::Level::Error, "testAreaLightSampler() - the PDF or the CDF isn't normalized");
+        success = false;
+    }
+
+    const uint32_t sampleCount = 400000;
+    std::vector<uint32_t> triangleCounts(triangleCount, 0);
+    std::vector<double> expectedTriangleCounts(triangleCount);
+    for(uint32_t i = 0; i < triangleCount; i++)
+    {
+        expectedTriangleCounts[i] = (cdf[i + 1] - cdf[i]) * (double)sampleCount;
+    }
+    for(uint32_t i = 0; i < sampleCount; i++)
+    {
+        uint32_t triangleId;
+        pSampler->samplePosition(glm::vec3(rng.nextFloat(), rng.nextFloat(), rng.nextFloat()), triangleId);
+        triangleCounts[triangleId]++;
+    }
+    success = checkChiSquare("triangle selection", triangleCounts, expectedTriangleCounts) && success;
+
+    // Points are uniform over a triangle. Split the triangle into kGrid * kGrid cells of equal area and count the samples in each one.
+    // With p0 at the origin, p1 on X and p2 on Y, the position's X and Y are the barycentrics of p1 and p2.
+    const glm::vec3 triangle[] = {glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0)};
+    const uint32_t triangleIndices[] = {0, 1, 2};
+    AreaLightSampler::SharedPtr pTriangleSampler = AreaLightSampler::create(triangle, 3, triangleIndices, 3);
+
+    const uint32_t kGrid = 8;
+    std::vector<uint32_t> cellCounts(kGrid * kGrid * 2, 0);
+    std::vector<double> expectedCellCounts(kGrid * kGrid * 2, 0);
+    for(uint32_t i = 0; i < sampleCount; i++)
+    {
+        uint32_t triangleId;
+        glm::vec3 p = pTriangleSampler->samplePosition(glm::vec3(rng.nextFloat(), rng.nextFloat(), rng.nextFloat()), triangleId);
+        float x = (std::min)((std::max)(p.x, 0.0f), 1.0f) * kGrid;
+        float y = (std::min)((std::max)(p.y, 0.0f), 1.0f) * kGrid;
+        uint32_t cellX = (std::min)((uint32_t)x, kGrid - 1);
+        uint32_t cellY = (std::min)((uint32_t)y, kGrid - 1);
+        uint32_t isUpper = ((x - cellX) + (y - cellY) >= 1) ? 1 : 0;
+        // Rounding can put points on the hypotenuse just outside of the triangle
+        isUpper = (cellX + cellY + 1 < kGrid) ? isUpper : 0;
+        cellCounts[(cellY * kGrid + cellX) * 2 + isUpper]++;
+    }
+    for(uint32_t cellY = 0; cellY < kGrid; cellY++)
+    {
+        for(uint32_t cellX = 0; cellX + cellY < kGrid; cellX++)
+        {
+            // The lower half of a cell is inside the triangle if the cell touches it, the upper half only if the whole cell is inside
+            expectedCellCounts[(cellY * kGrid + cellX) * 2] = (double)sampleCount / (kGrid * kGrid);
+            if(cellX + cellY + 1 < kGrid)
+            {
+                expectedCellCounts[(cellY * kGrid + cellX) * 2 + 1] = (double)sampleCount / (kGrid * kGrid);
+            }
+        }
+    }
+    success = checkChiSquare("the position distribution", cellCounts, expectedCellCounts) && success;
+    return success;
+}
+
+/** Measures the build time and the sampling throughput on a random mesh, and compares the alias table with a binary search of the CDF, as done before the alias table
+*/
+bool benchmarkAreaLightSampler(RenderContext* pRenderContext)
+{
+    const uint32_t triangleCount = 100000;
+    RandomGenerator rng;
+    std::vector<glm::vec3> positions(triangleCount * 3);
+    std::vector<uint32_t> indices(triangleCount * 3);
+    for(uint32_t i = 0; i < triangleCount * 3; i++)
+    {
+        positions[i] = glm::vec3(rng.nextFloat(-10, 10), rng.nextFloat(-10, 10), rng.nextFloat(-10, 10));
+        indices[i] = i;
+    }
+
+    const uint32_t sampleCount = 1 << 22;
+    std::vector<glm::vec3> samples(1024);
+    for(auto& s : samples)
+    {
+        s = glm::vec3(rng.nextFloat(), rng.nextFloat(), rng.nextFloat());
+    }
+
+    // The build time includes creating the GPU buffers
+    auto start = CpuTimer::getCurrentTimePoint();
+    AreaLightSampler::SharedPtr pSampler = AreaLightSampler::create(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size());
+    double buildInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    // Accumulate the positions so the loops can't be optimized away
+    glm::vec3 sum(0);
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < sampleCount; i++)
+    {
+        uint32_t triangleId;
+        sum += pSampler->samplePosition(samples[i % samples.size()], triangleId);
+    }
+    double aliasInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    const auto& cdf = pSampler->getCDF();
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < sampleCount; i++)
+    {
+        const glm::vec3& rSample = samples[i % samples.size()];
+        uint32_t triangleId = (uint32_t)(std::upper_bound(cdf.begin(), cdf.end(), rSample.z) - cdf.begin()) - 1;
+        triangleId = (std::min)(triangleId, triangleCount - 1);
+        float a = sqrt(rSample.x);
+        glm::vec2 bary(1.0f - a, a * rSample.y);
+        sum += positions[indices[triangleId * 3 + 0]] * bary.x + positions[indices[triangleId * 3 + 1]] * bary.y + positions[indices[triangleId * 3 + 2]] * (1.0f - bary.x - bary.y);
+    }
+    double cdfInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    double aliasMSamplesPerSecond = (aliasInMs > 0) ? sampleCount / (aliasInMs * 1000) : 0;
+    double cdfMSamplesPerSecond = (cdfInMs > 0) ? sampleCount / (cdfInMs * 1000) : 0;
+    Logger::log(Logger::Level::Info, "benchmarkAreaLightSampler() - " + std::to_string(triangleCount) + " triangles" +
+        ": build " + std::to_string(buildInMs) + " ms" +
+        ", alias table " + std::to_string(aliasMSamplesPerSecond) + " MSamples/s" +
+        ", CDF search " + std::to_string(cdfMSamplesPerSecond) + " MSamples/s" +
+        " (checksum " + std::to_string(sum.x + sum.y + sum.z) + ")");
+    return true;
+}
@@ -0,0 +1,185 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/Model/AsyncModelLoader.h"
+#include <atomic>
+#include <cfloat>
+
+// The simulated files are named by their index. Every fifth file fails to read.
+class SimulatedFileData : public Model::FileData
+{
+public:
+    uint32_t fileIndex = 0;
+};
+
+static bool isFailedFile(uint32_t fileIndex)
+{
+    return fileIndex % 5 == 3;
+}
+
+static std::vector<std::string> createFilenames(uint32_t fileCount)
+{
+    std::vector<std::string> filenames;
+    for(uint32_t i = 0; i < fileCount; i++)
+    {
+        filenames.push_back(std::to_string(i));
+    }
+    return filenames;
+}
+
+/** Checks the loader with simulated files, without the disk or the GPU: every file is reported exactly once and with its own data, reading stays within the read-ahead limit, update() with a budget of 0 creates one model at a time, finish() creates the remaining files and destroying the loader early stops the workers. Also checks calcLoadOrder().
+*/
+bool testAsyncModelLoader(RenderContext* pRenderContext)
+{
+    using ReadFunc = AsyncModelLoader::ReadFunc;
+    using CreateFunc = AsyncModelLoader::CreateFunc;
+    using LoadedCallback = AsyncModelLoader::LoadedCallback;
+
+    bool passed = true;
+
+    {
+        const std::vector<float> distances = {5, 1, 5, FLT_MAX, 1, 5};
+        const std::vector<uint64_t> fileSizes = {300, 200, 100, 10, 100, 100};
+        const std::vector<uint32_t> expected = {4, 1, 2, 5, 0, 3};
+        if(AsyncModelLoader::calcLoadOrder(distances, fileSizes) != expected)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncModelLoader() - calcLoadOrder() returned the wrong order");
+            passed = false;
+        }
+    }
+
+    const uint32_t kThreadCount = 3;
+    const uint32_t kMaxReadAhead = kThreadCount * 2;
+    std::atomic<uint32_t> readCount(0);
+    std::atomic<uint32_t> reportedCount(0);
+    std::atomic<bool> exceededReadAhead(false);
+    uint32_t createdIndex = (uint32_t)-1;
+
+    ReadFunc readFunc = [&](const std::string& filename, uint32_t flags) -> Model::FileData::UniquePtr
+    {
+        uint32_t fileIndex = (uint32_t)std::stoul(filename);
+        // The callback runs right after the loaded count is incremented, so the reported count can lag by one
+        if(fileIndex >= reportedCount + kMaxReadAhead + 1)
+        {
+            exceededReadAhead = true;
+        }
+        readCount++;
+        std::this_thread::sleep_for(std::chrono::microseconds(100 * (fileIndex % 4)));
+        if(isFailedFile(fileIndex))
+        {
+            return nullptr;
+        }
+        std::unique_ptr<SimulatedFileData> pData(new SimulatedFileData);
+        pData->fileIndex = fileIndex;
+        return std::move(pData);
+    };
+    CreateFunc createFunc = [&](const Model::FileData* pData) -> Model::SharedPtr
+    {
+        // Only record which file was created, the check doesn't need the models
+        createdIndex = static_cast<const SimulatedFileData*>(pData)->fileIndex;
+        return nullptr;
+    };
+
+    auto runLoader = [&](uint32_t fileCount, bool useFinish, const std::string& name)
+    {
+        readCount = 0;
+        reportedCount = 0;
+        exceededReadAhead = false;
+
+        std::vector<uint32_t> reportCount(fileCount, 0);
+        bool wrongData = false;
+        LoadedCallback callback = [&](uint32_t fileIndex, const Model::SharedPtr& pModel)
+        {
+            if(fileIndex >= fileCount)
+            {
+                wrongData = true;
+                return;
+            }
+            reportCount[fileIndex]++;
+            uint32_t expectedIndex = isFailedFile(fileIndex) ? (uint32_t)-1 : fileIndex;
+            wrongData = wrongData || (createdIndex != expectedIndex);
+            createdIndex = (uint32_t)-1;
+            reportedCount++;
+        };
+
+        AsyncModelLoader::UniquePtr pLoader = AsyncModelLoader::create(createFilenames(fileCount), 0, kThreadCount, readFunc, createFunc);
+        if(useFinish)
+        {
+            pLoader->finish(callback);
+        }
+        else
+        {
+            // With a budget of 0, each call creates at most one model
+            while(pLoader->isComplete() == false)
+            {
+                uint32_t before = reportedCount;
+                pLoader->update(0, callback);
+                if(reportedCount > before + 1)
+                {
+                    Logger::log(Logger::Level::Error, "testAsyncModelLoader() - " + name + " created more than one model in an update() with a budget of 0");
+                    passed = false;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+        if(wrongData)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncModelLoader() - " + name + " reported a file with another file's data");
+            passed = false;
+        }
+        if(std::any_of(reportCount.begin(), reportCount.end(), [](uint32_t count) { return count != 1; }) || pLoader->getLoadedCount() != fileCount)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncModelLoader() - " + name + " didn't report every file exactly once");
+            passed = false;
+        }
+        if(exceededReadAhead)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncModelLoader() - " + name + " read further ahead than the limit");
+            passed = false;
+        }
+    };
+    runLoader(40, false, "update()");
+    runLoader(20, true, "finish()");
+    runLoader(0, true, "an empty file list");
+
+    // Without update() calls, the workers stop at the read-ahead limit, and destroying the loader doesn't wait for the other files
+    {
+        readCount = 0;
+        reportedCount = 0;
+        AsyncModelLoader::UniquePtr pLoader = AsyncModelLoader::create(createFilenames(100), 0, kThreadCount, readFunc, createFunc);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pLoader = nullptr;
+        if(readCount > kMaxReadAhead)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncModelLoader() - the workers read " + std::to_string(readCount) + " files without any update() call, the limit is " + std::to_string(kMaxReadAhead));
+            passed = false;
+        }
+    }
+    return passed;
+}
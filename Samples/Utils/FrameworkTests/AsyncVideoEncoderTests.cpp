@@ -0,0 +1,241 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/Video/AsyncVideoEncoder.h"
+
+static void fillSyntheticFrame(uint8_t* pData, uint32_t frameSize, uint32_t frameIndex)
+{
+    // The first word holds the frame index, the rest is a pattern which depends on it
+    for(uint32_t i = 0; i < frameSize; i++)
+    {
+        pData[i] = (uint8_t)(i * 7 + frameIndex * 13);
+    }
+    memcpy(pData, &frameIndex, std::min(frameSize, (uint32_t)sizeof(frameIndex)));
+}
+
+static bool checkValue(uint64_t value, uint64_t expected, const std::string& name)
+{
+    if(value != expected)
+    {
+        Logger::log(Logger::Level::Error, "testAsyncVideoEncoder() - " + name + " is " + std::to_string(value) + ", expected " + std::to_string(expected));
+        return false;
+    }
+    return true;
+}
+
+/** Checks the frame order, the overflow policies and the statistics, using synthetic frames and a frame consumer which doesn't encode
+*/
+bool testAsyncVideoEncoder(RenderContext* pRenderContext)
+{
+    using FrameFunc = AsyncVideoEncoder::FrameFunc;
+    using OverflowPolicy = AsyncVideoEncoder::OverflowPolicy;
+
+    const uint32_t kFrameSize = 256;
+    const uint32_t kFrameCount = 64;
+    bool passed = true;
+
+    // The consumer records the frames it receives and checks their content
+    std::vector<uint32_t> consumed;
+    uint32_t corruptFrames = 0;
+    std::vector<uint8_t> expected(kFrameSize);
+    FrameFunc recordFrame = [&](const uint8_t* pData)
+    {
+        uint32_t frameIndex;
+        memcpy(&frameIndex, pData, sizeof(frameIndex));
+        fillSyntheticFrame(expected.data(), kFrameSize, frameIndex);
+        if(memcmp(expected.data(), pData, kFrameSize) != 0)
+        {
+            corruptFrames++;
+        }
+        consumed.push_back(frameIndex);
+    };
+
+    // Blocking policy, through both submission paths. Every frame arrives, in order.
+    AsyncVideoEncoder::Desc desc;
+    desc.frameSize = kFrameSize;
+    desc.queueSize = 3;
+    desc.policy = OverflowPolicy::Block;
+    AsyncVideoEncoder::UniquePtr pEncoder = AsyncVideoEncoder::create(recordFrame, desc);
+    std::vector<uint8_t> frame(kFrameSize);
+    for(uint32_t i = 0; i < kFrameCount; i++)
+    {
+        if(i % 2)
+        {
+            fillSyntheticFrame(frame.data(), kFrameSize, i);
+            pEncoder->appendFrame(frame.data());
+        }
+        else
+        {
+            uint8_t* pFrame = pEncoder->acquireFrame();
+            fillSyntheticFrame(pFrame, kFrameSize, i);
+            pEncoder->submitFrame(pFrame);
+        }
+    }
+    pEncoder->flush();
+    AsyncVideoEncoder::Stats stats = pEncoder->getStats();
+    passed = checkValue(consumed.size(), kFrameCount, "blocking policy consumed frame count") && passed;
+    for(uint32_t i = 0; i < (uint32_t)consumed.size(); i++)
+    {
+        if(consumed[i] != i)
+        {
+            Logger::log(Logger::Level::Error, "testAsyncVideoEncoder() - blocking policy consumed frame " + std::to_string(consumed[i]) + " at position " + std::to_string(i));
+            passed = false;
+            break;
+        }
+    }
+    passed = checkValue(stats.submittedFrames, kFrameCount, "blocking policy submitted frames") && passed;
+    passed = checkValue(stats.encodedFrames, kFrameCount, "blocking policy encoded frames") && passed;
+    passed = checkValue(stats.droppedFrames, 0, "blocking policy dropped frames") && passed;
+    passed = checkValue(stats.queueDepth, 0, "blocking policy queue depth after flush()") && passed;
+    if(stats.maxQueueDepth > desc.queueSize)
+    {
+        Logger::log(Logger::Level::Error, "testAsyncVideoEncoder() - the queue depth exceeded the queue size");
+        passed = false;
+    }
+
+    // Frames submitted after endCapture() are dropped
+    pEncoder->endCapture();
+    passed = checkValue(pEncoder->appendFrame(frame.data()), false, "appendFrame() after endCapture()") && passed;
+    passed = checkValue(pEncoder->getStats().droppedFrames, 1, "dropped frames after endCapture()") && passed;
+    pEncoder = nullptr;
+
+    // Drop policy. The consumer is held on the first frame, so the buffers run out after queueSize frames and the rest are dropped.
+    std::mutex gateMutex;
+    std::condition_variable gateCV;
+    bool isGateOpen = false;
+    FrameFunc gatedRecordFrame = [&](const uint8_t* pData)
+    {
+        {
+            std::unique_lock<std::mutex> lock(gateMutex);
+            gateCV.wait(lock, [&isGateOpen] {return isGateOpen; });
+        }
+        recordFrame(pData);
+    };
+
+    consumed.clear();
+    desc.policy = OverflowPolicy::Drop;
+    pEncoder = AsyncVideoEncoder::create(gatedRecordFrame, desc);
+    uint32_t acceptedFrames = 0;
+    for(uint32_t i = 0; i < kFrameCount; i++)
+    {
+        fillSyntheticFrame(frame.data(), kFrameSize, i);
+        acceptedFrames += pEncoder->appendFrame(frame.data()) ? 1 : 0;
+    }
+    {
+        std::lock_guard<std::mutex> lock(gateMutex);
+        isGateOpen = true;
+    }
+    gateCV.notify_all();
+    pEncoder->flush();
+    stats = pEncoder->getStats();
+    passed = checkValue(acceptedFrames, desc.queueSize, "drop policy accepted frames") && passed;
+    passed = checkValue(stats.submittedFrames, kFrameCount, "drop policy submitted frames") && passed;
+    passed = checkValue(stats.encodedFrames, desc.queueSize, "drop policy encoded frames") && passed;
+    passed = checkValue(stats.droppedFrames, kFrameCount - desc.queueSize, "drop policy dropped frames") && passed;
+    for(uint32_t i = 0; i < (uint32_t)consumed.size(); i++)
+    {
+        // The first queueSize frames are the ones which got buffers
+        passed = checkValue(consumed[i], i, "drop policy consumed frame") && passed;
+    }
+    pEncoder = nullptr;
+
+    passed = checkValue(corruptFrames, 0, "corrupt frame count") && passed;
+    return passed;
+}
+
+/** Compares encoding on the calling thread with encoding through the queue, using synthetic 720p frames and the H.264 encoder.
+    Writes sync_FrameworkTests.mp4 and async_FrameworkTests.mp4 into the executable's directory.
+*/
+bool benchmarkAsyncVideoEncoder(RenderContext* pRenderContext)
+{
+    const uint32_t frameCount = 300;
+    VideoEncoder::Desc desc;
+    desc.width = 1280;
+    desc.height = 720;
+    desc.codec = VideoEncoder::CodecID::H264;
+
+    VideoEncoder::Desc syncDesc = desc;
+    syncDesc.filename = getExecutableDirectory() + "/sync_FrameworkTests.mp4";
+    VideoEncoder::UniquePtr pSyncEncoder = VideoEncoder::create(syncDesc);
+    VideoEncoder::Desc asyncDesc = desc;
+    asyncDesc.filename = getExecutableDirectory() + "/async_FrameworkTests.mp4";
+    AsyncVideoEncoder::Desc queueDesc;
+    queueDesc.frameSize = desc.width * desc.height * 4;
+    AsyncVideoEncoder::UniquePtr pAsyncEncoder = AsyncVideoEncoder::create(VideoEncoder::create(asyncDesc), queueDesc);
+    if(pSyncEncoder == nullptr || pAsyncEncoder == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkAsyncVideoEncoder() - can't create the encoders");
+        return false;
+    }
+
+    // Synthetic RGBA frames. A moving gradient, so that the encoder has real motion to work with.
+    const uint32_t kFramePatternCount = 16;
+    std::vector<std::vector<uint8_t>> frames(kFramePatternCount, std::vector<uint8_t>(queueDesc.frameSize));
+    for(uint32_t f = 0; f < kFramePatternCount; f++)
+    {
+        uint8_t* pPixel = frames[f].data();
+        for(uint32_t y = 0; y < desc.height; y++)
+        {
+            for(uint32_t x = 0; x < desc.width; x++)
+            {
+                pPixel[0] = (uint8_t)(x + f * 4);
+                pPixel[1] = (uint8_t)(y + f * 2);
+                pPixel[2] = (uint8_t)(x ^ y);
+                pPixel[3] = 255;
+                pPixel += 4;
+            }
+        }
+    }
+
+    // Encode on the calling thread
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < frameCount; i++)
+    {
+        pSyncEncoder->appendFrame(frames[i % kFramePatternCount].data());
+    }
+    double syncTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    pSyncEncoder->endCapture();
+
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < frameCount; i++)
+    {
+        pAsyncEncoder->appendFrame(frames[i % kFramePatternCount].data());
+    }
+    double submitTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    pAsyncEncoder->flush();
+    double asyncTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    pAsyncEncoder->endCapture();
+
+    // The submit rate excludes the time spent waiting for the final frames, the async rate includes the final flush
+    double syncFps = frameCount * 1000.0 / std::max(syncTime, 1e-3);
+    double submitFps = frameCount * 1000.0 / std::max(submitTime, 1e-3);
+    double asyncFps = frameCount * 1000.0 / std::max(asyncTime, 1e-3);
+    Logger::log(Logger::Level::Info, "benchmarkAsyncVideoEncoder() - " + std::to_string(frameCount) + " frames at " + std::to_string(desc.width) + "x" + std::to_string(desc.height) +
+        ": " + std::to_string(syncFps) + " fps on the calling thread, " + std::to_string(submitFps) + " fps submitted, " + std::to_string(asyncFps) + " fps through the queue");
+    return true;
+}
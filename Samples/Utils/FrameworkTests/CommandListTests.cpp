@@ -0,0 +1,139 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+
+/** Records a list with every kind of GPU-free command, then checks that execute() passes back the recorded payloads in order.
+    Doesn't use uniform buffers, so the list never touches the GPU.
+*/
+bool testCommandList(RenderContext* pRenderContext)
+{
+    using Command = CommandList::Command;
+    CommandList::SharedPtr pList = CommandList::create(16);
+
+    RasterizerState::Desc rsDesc;
+    RasterizerState::SharedConstPtr pCullNone = RasterizerState::create(rsDesc.setCullMode(RasterizerState::CullMode::None));
+    RenderContext::Viewport vp;
+    vp.originX = 8;
+    vp.width = 64;
+    vp.height = 32;
+
+    // Record more than the initial arena size, so the arena grows while recording
+    const uint32_t kDrawCount = 100;
+    pList->setRasterizerState(pCullNone);
+    pList->setBlendState(nullptr, 0x5);
+    pList->setDepthStencilState(nullptr, 3);
+    pList->setTopology(RenderContext::Topology::TriangleStrip);
+    pList->setViewport(1, vp);
+    pList->pushState();
+    for(uint32_t i = 0; i < kDrawCount; i++)
+    {
+        pList->setRasterizerState(pCullNone);
+        pList->drawIndexedInstanced(3 * i, i + 1, i, -(int)i, 2 * i);
+    }
+    pList->popState();
+    pList->draw(6, 2);
+
+    bool passed = true;
+    auto check = [&passed](bool condition, const std::string& msg)
+    {
+        if(condition == false)
+        {
+            Logger::log(Logger::Level::Error, "testCommandList() - " + msg);
+            passed = false;
+        }
+    };
+
+    const uint32_t expectedCount = 8 + 2 * kDrawCount;
+    check(pList->getCommandCount() == expectedCount, "expected " + std::to_string(expectedCount) + " commands, got " + std::to_string(pList->getCommandCount()));
+    check(pList->getCommandCount(Command::SetRasterizerState) == kDrawCount + 1, "wrong SetRasterizerState count");
+    check(pList->getCommandCount(Command::DrawIndexedInstanced) == kDrawCount, "wrong DrawIndexedInstanced count");
+    check(pList->getCommandCount(Command::UpdateUniformBuffer) == 0, "no uniform buffer is bound, but buffer data was captured");
+
+    uint32_t index = 0;
+    uint32_t drawIndex = 0;
+    pList->execute([&](Command command, const void* pPayload)
+    {
+        check(((uintptr_t)pPayload & 3) == 0, "command " + std::to_string(index) + " payload is misaligned");
+        switch(command)
+        {
+        case Command::SetRasterizerState:
+        {
+            const CommandList::ObjectCmd* pCmd = (const CommandList::ObjectCmd*)pPayload;
+            check(pList->getObject<const RasterizerState>(pCmd->object) == pCullNone, "the rasterizer state doesn't round-trip");
+            break;
+        }
+        case Command::SetBlendState:
+        {
+            const CommandList::ObjectValueCmd* pCmd = (const CommandList::ObjectValueCmd*)pPayload;
+            check(pCmd->object == CommandList::kNullObject && pCmd->value == 0x5, "wrong blend state payload");
+            check(pList->getObject<const BlendState>(pCmd->object) == nullptr, "the null blend state doesn't round-trip");
+            break;
+        }
+        case Command::SetDepthStencilState:
+            check(((const CommandList::ObjectValueCmd*)pPayload)->value == 3, "wrong stencil reference");
+            break;
+        case Command::SetTopology:
+            check(((const CommandList::TopologyCmd*)pPayload)->topology == RenderContext::Topology::TriangleStrip, "wrong topology");
+            break;
+        case Command::SetViewport:
+        {
+            const CommandList::ViewportCmd* pCmd = (const CommandList::ViewportCmd*)pPayload;
+            check(pCmd->index == 1 && pCmd->vp == vp, "wrong viewport payload");
+            break;
+        }
+        case Command::DrawIndexedInstanced:
+        {
+            const CommandList::DrawIndexedInstancedCmd* pCmd = (const CommandList::DrawIndexedInstancedCmd*)pPayload;
+            const uint32_t i = drawIndex++;
+            check(pCmd->indexCount == 3 * i && pCmd->instanceCount == i + 1 && pCmd->startIndexLocation == i && pCmd->baseVertexLocation == -(int)i && pCmd->startInstanceLocation == 2 * i,
+                "wrong payload for draw " + std::to_string(i));
+            break;
+        }
+        case Command::Draw:
+        {
+            const CommandList::DrawCmd* pCmd = (const CommandList::DrawCmd*)pPayload;
+            check(index == expectedCount - 1, "the last draw isn't the last command");
+            check(pCmd->vertexCount == 6 && pCmd->startVertexLocation == 2, "wrong draw payload");
+            break;
+        }
+        case Command::PushState:
+        case Command::PopState:
+            break;
+        default:
+            check(false, "unexpected command " + std::to_string((uint32_t)command));
+        }
+        index++;
+    });
+    check(index == expectedCount, "execute() returned " + std::to_string(index) + " commands");
+    check(drawIndex == kDrawCount, "execute() returned " + std::to_string(drawIndex) + " indexed draws");
+
+    pList->reset();
+    check(pList->getCommandCount() == 0 && pList->getSize() == 0 && pList->getCommandCount(Command::DrawIndexedInstanced) == 0, "reset() didn't clear the list");
+    pList->execute([&check](Command command, const void* pPayload) { check(false, "execute() after reset() returned a command"); });
+    return passed;
+}
@@ -0,0 +1,303 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/Material/CpuMaterialEvaluator.h"
+#include "ShadingUtils/HostShading.h"
+#include <cmath>
+
+static float nextFloat(RandomGenerator& rng, float minValue, float maxValue)
+{
+    return minValue + (rng.next() >> 8) / (float)(1 << 24) * (maxValue - minValue);
+}
+
+static glm::vec3 nextDirection(RandomGenerator& rng)
+{
+    return HostShading::uniform_sample_sphere(nextFloat(rng, 0, 1), nextFloat(rng, 0, 1));
+}
+
+/** Materials covering every layer type, NDF and blend mode
+*/
+static std::vector<MaterialData> createTestMaterials(uint32_t count, RandomGenerator& rng)
+{
+    std::vector<MaterialData> materials(count);
+    for(uint32_t i = 0; i < count; i++)
+    {
+        MaterialDesc& desc = materials[i].desc;
+        MaterialValues& values = materials[i].values;
+        glm::vec3 color(nextFloat(rng, 0, 1), nextFloat(rng, 0, 1), nextFloat(rng, 0, 1));
+        float roughness = nextFloat(rng, 0.05f, 1);
+        switch(i % 6)
+        {
+        case 0:
+            HostShading::initDiffuseLayer(desc.layers[0], values.layers[0], color);
+            break;
+        case 1:
+            HostShading::initDiffuseLayer(desc.layers[0], values.layers[0], color);
+            HostShading::initConductorLayer(desc.layers[1], values.layers[1], glm::vec3(1) - color, roughness, nextFloat(rng, 0.2f, 3), nextFloat(rng, 0, 5));
+            break;
+        case 2:
+            // Anisotropic Beckmann conductor
+            HostShading::initConductorLayer(desc.layers[0], values.layers[0], color, roughness);
+            desc.layers[0].ndf = NDFBeckmann;
+            values.layers[0].roughness.constantColor.y = nextFloat(rng, 0.05f, 1);
+            break;
+        case 3:
+            HostShading::initDiffuseLayer(desc.layers[0], values.layers[0], color);
+            HostShading::initDielectricLayer(desc.layers[1], values.layers[1], glm::vec3(1), roughness, nextFloat(rng, 1.1f, 2.5f));
+            break;
+        case 4:
+            // Constant-blended conductors under a Beckmann coating
+            HostShading::initConductorLayer(desc.layers[0], values.layers[0], color, roughness);
+            HostShading::initConductorLayer(desc.layers[1], values.layers[1], glm::vec3(1), nextFloat(rng, 0.05f, 1));
+            desc.layers[1].blending = BlendConstant;
+            values.layers[1].albedo.constantColor.w = nextFloat(rng, 0, 1);
+            HostShading::initDielectricLayer(desc.layers[2], values.layers[2], glm::vec3(1), nextFloat(rng, 0.05f, 1), 1.5f);
+            desc.layers[2].ndf = NDFBeckmann;
+            break;
+        case 5:
+            desc.layers[0].type = MatEmissive;
+            values.layers[0].albedo.constantColor = glm::vec4(color * 10.f, 1);
+            break;
+        }
+    }
+    return materials;
+}
+
+/** Random samples in structure-of-arrays layout
+*/
+struct TestSamples
+{
+    std::vector<uint32_t> materialIndex;
+    std::vector<float> data[18];
+    CpuMaterialEvaluator::Samples samples;
+
+    TestSamples(uint32_t count, uint32_t materialCount, bool useTangents, RandomGenerator& rng)
+    {
+        materialIndex.resize(count);
+        for(auto& channel : data)
+        {
+            channel.resize(count);
+        }
+
+        for(uint32_t i = 0; i < count; i++)
+        {
+            materialIndex[i] = rng.next() % materialCount;
+            glm::vec3 normal = nextDirection(rng);
+            glm::vec3 tangent;
+            glm::vec3 bitangent;
+            HostShading::reflectFrame(normal, nextDirection(rng), tangent, bitangent);
+            // Mostly front-facing views and lights, with some back-facing ones
+            glm::vec3 view = nextDirection(rng);
+            view = (glm::dot(view, normal) < -0.5f) ? view : normal * 0.5f + view;
+            glm::vec3 light = nextDirection(rng);
+            light = glm::normalize((glm::dot(light, normal) < -0.5f) ? light : normal * 0.5f + light);
+            glm::vec3 intensity(nextFloat(rng, 0, 2), nextFloat(rng, 0, 2), nextFloat(rng, 0, 2));
+            const glm::vec3 vectors[] = {normal, tangent, bitangent, view, light, intensity};
+            for(uint32_t v = 0; v < arraysize(vectors); v++)
+            {
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    data[v * 3 + c][i] = vectors[v][c];
+                }
+            }
+        }
+
+        CpuMaterialEvaluator::InputArray* pArrays[] = {&samples.normal, &samples.tangent, &samples.bitangent, &samples.view, &samples.light, &samples.lightIntensity};
+        for(uint32_t v = 0; v < arraysize(pArrays); v++)
+        {
+            pArrays[v]->x = data[v * 3 + 0].data();
+            pArrays[v]->y = data[v * 3 + 1].data();
+            pArrays[v]->z = data[v * 3 + 2].data();
+        }
+        if(useTangents == false)
+        {
+            samples.tangent = CpuMaterialEvaluator::InputArray();
+            samples.bitangent = CpuMaterialEvaluator::InputArray();
+        }
+        samples.count = count;
+        samples.pMaterialIndex = materialIndex.data();
+    }
+};
+
+/** Storage for all the outputs
+*/
+struct TestResults
+{
+    std::vector<float> data[15];
+    CpuMaterialEvaluator::Results results;
+
+    TestResults(uint32_t count)
+    {
+        CpuMaterialEvaluator::OutputArray* pArrays[] = {&results.value, &results.diffuseAlbedo, &results.diffuseIllumination, &results.specularAlbedo, &results.specularIllumination};
+        for(uint32_t v = 0; v < arraysize(pArrays); v++)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                data[v * 3 + c].assign(count, 0);
+            }
+            pArrays[v]->x = data[v * 3 + 0].data();
+            pArrays[v]->y = data[v * 3 + 1].data();
+            pArrays[v]->z = data[v * 3 + 2].data();
+        }
+    }
+};
+
+static bool checkValue(const std::string& name, float value, float expected)
+{
+    if(std::abs(value - expected) > 1e-5f * std::max(1.f, std::abs(expected)))
+    {
+        Logger::log(Logger::Level::Error, "testCpuMaterialEvaluator() - " + name + " returned " + std::to_string(value) + ", expected " + std::to_string(expected));
+        return false;
+    }
+    return true;
+}
+
+/** Checks the shading functions against closed-form values, and evaluate() against evaluateReference() on random materials and directions.
+    The sample count isn't a multiple of the SIMD width and is large enough to be split between threads.
+*/
+bool testCpuMaterialEvaluator(RenderContext* pRenderContext)
+{
+    bool passed = true;
+
+    const glm::vec3 up(0, 0, 1);
+    const float r = 0.5f;
+    const float n = 1.5f;
+    const float k = 3.f;
+    const float R0 = ((n - 1) / (n + 1)) * ((n - 1) / (n + 1));
+    passed = checkValue("evalDiffuseBSDF()", HostShading::evalDiffuseBSDF(up, up), M_1_PIf) && passed;
+    passed = checkValue("evalDiffuseBSDF() below the horizon", HostShading::evalDiffuseBSDF(up, -up), 0) && passed;
+    passed = checkValue("evalGGXDistribution() at normal incidence", HostShading::evalGGXDistribution(up, glm::vec2(r)), 1 / (M_PIf * r * r)) && passed;
+    passed = checkValue("evalBeckmannDistribution() at normal incidence", HostShading::evalBeckmannDistribution(up, glm::vec2(r)), 1 / (M_PIf * r * r)) && passed;
+    passed = checkValue("conductorFresnel() at normal incidence", HostShading::conductorFresnel(1, n, k), ((n - 1) * (n - 1) + k * k) / ((n + 1) * (n + 1) + k * k)) && passed;
+    passed = checkValue("dielectricFresnel() at normal incidence", HostShading::dielectricFresnel(1, n), R0) && passed;
+    passed = checkValue("dielectricFresnelSchlick() at normal incidence", HostShading::dielectricFresnelSchlick(1, n), R0) && passed;
+    passed = checkValue("dielectricFresnel() with total internal reflection", HostShading::dielectricFresnel(-0.1f, n), 1) && passed;
+    passed = checkValue("GSmith() at normal incidence", HostShading::GSmith(up, up, glm::vec2(r), NDFGGX), 1) && passed;
+
+    RandomGenerator rng;
+    const uint32_t kMaterialCount = 24;
+    const uint32_t kSampleCount = 4099;
+    CpuMaterialEvaluator::SharedPtr pEvaluator = CpuMaterialEvaluator::create(createTestMaterials(kMaterialCount, rng));
+    if(pEvaluator == nullptr || pEvaluator->getMaterialCount() != kMaterialCount)
+    {
+        Logger::log(Logger::Level::Error, "testCpuMaterialEvaluator() - create() failed");
+        return false;
+    }
+
+    for(uint32_t useTangents = 0; useTangents < 2; useTangents++)
+    {
+        TestSamples samples(kSampleCount, kMaterialCount, useTangents != 0, rng);
+        TestResults expected(kSampleCount);
+        TestResults actual(kSampleCount);
+        pEvaluator->evaluateReference(samples.samples, expected.results);
+        pEvaluator->evaluate(samples.samples, actual.results);
+
+        bool match = true;
+        for(uint32_t channel = 0; channel < arraysize(expected.data) && match; channel++)
+        {
+            for(uint32_t i = 0; i < kSampleCount; i++)
+            {
+                float e = expected.data[channel][i];
+                float a = actual.data[channel][i];
+                // Degenerate configurations produce the same NaNs and infinities in both paths, there's nothing to compare
+                if(std::isfinite(e) && std::abs(a - e) > 1e-4f * std::max(1.f, std::abs(e)))
+                {
+                    Logger::log(Logger::Level::Error, "testCpuMaterialEvaluator() - evaluate() mismatch at sample " + std::to_string(i) + ", output " + std::to_string(channel) +
+                        ": " + std::to_string(a) + ", expected " + std::to_string(e) + (useTangents ? " (with tangents)" : ""));
+                    match = false;
+                    break;
+                }
+            }
+        }
+        passed = passed && match;
+    }
+    return passed;
+}
+
+/** Offset every array of a batch
+*/
+static CpuMaterialEvaluator::Samples sliceSamples(const CpuMaterialEvaluator::Samples& samples, uint32_t begin, uint32_t count)
+{
+    CpuMaterialEvaluator::Samples slice = samples;
+    slice.count = count;
+    slice.pMaterialIndex += begin;
+    CpuMaterialEvaluator::InputArray* pArrays[] = {&slice.normal, &slice.tangent, &slice.bitangent, &slice.view, &slice.light, &slice.lightIntensity};
+    for(auto pArray : pArrays)
+    {
+        pArray->x += begin;
+        pArray->y += begin;
+        pArray->z += begin;
+    }
+    return slice;
+}
+
+static CpuMaterialEvaluator::Results sliceResults(const CpuMaterialEvaluator::Results& results, uint32_t begin)
+{
+    CpuMaterialEvaluator::Results slice = results;
+    CpuMaterialEvaluator::OutputArray* pArrays[] = {&slice.value, &slice.diffuseAlbedo, &slice.diffuseIllumination, &slice.specularAlbedo, &slice.specularIllumination};
+    for(auto pArray : pArrays)
+    {
+        pArray->x += begin;
+        pArray->y += begin;
+        pArray->z += begin;
+    }
+    return slice;
+}
+
+/** Measures the throughput of the reference path, the SIMD path on the calling thread and the SIMD path on all threads, on a batch of 1M random samples
+*/
+bool benchmarkCpuMaterialEvaluator(RenderContext* pRenderContext)
+{
+    const uint32_t kSampleCount = 1 << 20;
+    const uint32_t kMaterialCount = 64;
+    // evaluate() splits batches into ranges of 1024 samples, so a batch of that size stays on the calling thread
+    const uint32_t kSingleThreadBatchSize = 1024;
+    RandomGenerator rng;
+    CpuMaterialEvaluator::SharedPtr pEvaluator = CpuMaterialEvaluator::create(createTestMaterials(kMaterialCount, rng));
+    TestSamples samples(kSampleCount, kMaterialCount, true, rng);
+    TestResults results(kSampleCount);
+
+    auto measure = [&](const std::string& name, const std::function<void()>& func)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        func();
+        double durationInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        Logger::log(Logger::Level::Info, "benchmarkCpuMaterialEvaluator() - " + name + ": " + std::to_string(kSampleCount / (std::max(durationInMs, 1e-3) * 1000)) + " MSamples/s");
+    };
+
+    measure("reference", [&]() { pEvaluator->evaluateReference(samples.samples, results.results); });
+    measure("SIMD on 1 thread", [&]()
+    {
+        for(uint32_t begin = 0; begin < kSampleCount; begin += kSingleThreadBatchSize)
+        {
+            pEvaluator->evaluate(sliceSamples(samples.samples, begin, std::min(kSingleThreadBatchSize, kSampleCount - begin)), sliceResults(results.results, begin));
+        }
+    });
+    measure("SIMD on " + std::to_string(getParallelThreadCount()) + " threads", [&]() { pEvaluator->evaluate(samples.samples, results.results); });
+    return true;
+}
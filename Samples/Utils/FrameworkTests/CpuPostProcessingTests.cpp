@@ -0,0 +1,384 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Effects/Utils/CpuPostProcessing.h"
+#include "Utils/ImageProcessing.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <cmath>
+
+using ToneMappingParams = CpuPostProcessing::ToneMappingParams;
+
+static float nextFloat(RandomGenerator& rng)
+{
+    return (rng.next() >> 8) / (float)(1 << 24);
+}
+
+static bool compareImages(const std::vector<float>& result, const std::vector<float>& reference, float tolerance, const std::string& name)
+{
+    for(size_t i = 0; i < result.size(); i++)
+    {
+        if((std::abs(result[i] - reference[i]) <= tolerance * std::max(1.0f, std::abs(reference[i]))) == false)
+        {
+            Logger::log(Logger::Level::Error, "testCpuPostProcessing() - " + name + " mismatch at value " + std::to_string(i) + ". Expected " + std::to_string(reference[i]) + ", got " + std::to_string(result[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Generate an HDR image with a wide range of luminance values
+*/
+static std::vector<float> createHdrImage(uint32_t width, uint32_t height, RandomGenerator& rng)
+{
+    std::vector<float> image((size_t)width * height * 4);
+    for(size_t i = 0; i < image.size(); i++)
+    {
+        image[i] = ((i % 4) == 3) ? nextFloat(rng) : std::exp(nextFloat(rng) * 8 - 4);
+    }
+    return image;
+}
+
+static std::vector<float> createDepthBuffer(uint32_t width, uint32_t height, float backgroundFraction, RandomGenerator& rng)
+{
+    std::vector<float> depth((size_t)width * height);
+    for(auto& d : depth)
+    {
+        d = (nextFloat(rng) < backgroundFraction) ? 1.0f : nextFloat(rng);
+    }
+    return depth;
+}
+
+static float calcLuminance(const glm::vec3& color)
+{
+    return glm::dot(color, glm::vec3(0.299f, 0.587f, 0.114f));
+}
+
+/** Bilinear sample of one level of the luminance mip-chain with wrap addressing
+*/
+static float sampleLuminanceLevel(const float* pLevel, int32_t width, int32_t height, float u, float v)
+{
+    float x = u * width - 0.5f;
+    float y = v * height - 0.5f;
+    int32_t x0 = (int32_t)std::floor(x);
+    int32_t y0 = (int32_t)std::floor(y);
+    auto fetch = [&](int32_t tx, int32_t ty)
+    {
+        return pLevel[((ty % height + height) % height) * width + (tx % width + width) % width];
+    };
+    float fx = x - x0;
+    float fy = y - y0;
+    return glm::mix(glm::mix(fetch(x0, y0), fetch(x0 + 1, y0), fx), glm::mix(fetch(x0, y0 + 1), fetch(x0 + 1, y0 + 1), fx), fy);
+}
+
+static glm::vec3 uc2Operator(const glm::vec3& color)
+{
+    const float A = 0.15f;
+    const float B = 0.50f;
+    const float C = 0.10f;
+    const float D = 0.20f;
+    const float E = 0.01f;
+    const float F = 0.30f;
+    return ((color * (A * color + C * B) + D * E) / (color * (A * color + B) + D * F)) - (E / F);
+}
+
+/** Single-threaded, per-pixel tone-mapping, following ToneMapping.fs. The log-luminance mip-chain is box-filtered with ImageProcessing.
+*/
+static void toneMapReference(const float* pSrc, uint32_t width, uint32_t height, const ToneMappingParams& params, float* pDst)
+{
+    std::vector<float> logLuminance((size_t)width * height);
+    for(size_t i = 0; i < logLuminance.size(); i++)
+    {
+        logLuminance[i] = std::log(std::max(0.0001f, calcLuminance(glm::vec3(pSrc[i * 4], pSrc[i * 4 + 1], pSrc[i * 4 + 2]))));
+    }
+    uint32_t mipCount;
+    std::vector<uint8_t> chain = ImageProcessing::generateMipChain(logLuminance.data(), width, height, ResourceFormat::R32Float, ImageProcessing::MipFilter::Box, mipCount);
+    std::vector<const float*> levels(mipCount);
+    levels[0] = (const float*)chain.data();
+    for(uint32_t mip = 1; mip < mipCount; mip++)
+    {
+        levels[mip] = levels[mip - 1] + (size_t)std::max(width >> (mip - 1), 1u) * std::max(height >> (mip - 1), 1u);
+    }
+    float lod = glm::clamp(params.luminanceLod, 0.0f, (float)(mipCount - 1));
+    uint32_t mip = (uint32_t)lod;
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            float u = (x + 0.5f) / width;
+            float v = (y + 0.5f) / height;
+            float avgLogLuminance = sampleLuminanceLevel(levels[mip], std::max(width >> mip, 1u), std::max(height >> mip, 1u), u, v);
+            if(lod > mip)
+            {
+                float next = sampleLuminanceLevel(levels[mip + 1], std::max(width >> (mip + 1), 1u), std::max(height >> (mip + 1), 1u), u, v);
+                avgLogLuminance = glm::mix(avgLogLuminance, next, lod - mip);
+            }
+
+            const float* pColor = pSrc + ((size_t)y * width + x) * 4;
+            glm::vec4 color(pColor[0], pColor[1], pColor[2], pColor[3]);
+            glm::vec3 exposed = glm::vec3(color) * (params.middleGray / std::exp(avgLogLuminance));
+            glm::vec4 result;
+            switch(params.op)
+            {
+            case ToneMapping::Operator::Clamp:
+                result = glm::clamp(color, 0.0f, 1.0f);
+                break;
+            case ToneMapping::Operator::Linear:
+                result = glm::vec4(exposed, color.a);
+                break;
+            case ToneMapping::Operator::Reinhard:
+            {
+                float luminance = calcLuminance(exposed);
+                result = glm::vec4(exposed * (1 / (luminance + 1)), color.a);
+                break;
+            }
+            case ToneMapping::Operator::ReinhardModified:
+            {
+                float luminance = calcLuminance(exposed);
+                result = glm::vec4(exposed * (1 + luminance / (params.whiteMaxLuminance * params.whiteMaxLuminance)) * (1 + luminance), color.a);
+                break;
+            }
+            case ToneMapping::Operator::HejiHableAlu:
+            {
+                glm::vec3 c = glm::max(glm::vec3(0.0f), exposed - 0.004f);
+                c = (c * (6.2f * c + 0.5f)) / (c * (6.2f * c + 1.7f) + 0.06f);
+                result = glm::vec4(glm::pow(c, glm::vec3(2.2f)), color.a);
+                break;
+            }
+            default:
+                result = glm::vec4(uc2Operator(2.0f * exposed) / uc2Operator(glm::vec3(params.whiteScale)), color.a);
+            }
+            memcpy(pDst + ((size_t)y * width + x) * 4, &result, sizeof(result));
+        }
+    }
+}
+
+/** Single-threaded, per-pixel blur with the weights in GaussianBlur.fs
+*/
+static void gaussianBlurReference(const float* pSrc, uint32_t width, uint32_t height, uint32_t kernelSize, float* pDst)
+{
+    static const float kWeights[6][11] =
+    {
+        {1},
+        {0.27901f, 0.44198f, 0.27901f},
+        {0.06136f, 0.24477f, 0.38774f, 0.24477f, 0.06136f},
+        {0.00598f, 0.060626f, 0.241843f, 0.383103f, 0.241843f, 0.060626f, 0.00598f},
+        {0.000229f, 0.005977f, 0.060598f, 0.241732f, 0.382928f, 0.241732f, 0.060598f, 0.005977f, 0.000229f},
+        {0.000003f, 0.000229f, 0.005977f, 0.060598f, 0.24173f, 0.382925f, 0.24173f, 0.060598f, 0.005977f, 0.000229f, 0.000003f},
+    };
+    const float* pWeights = kWeights[kernelSize / 2];
+    const int32_t radius = kernelSize / 2;
+    std::vector<glm::vec4> horizontal((size_t)width * height);
+    for(int32_t y = 0; y < (int32_t)height; y++)
+    {
+        for(int32_t x = 0; x < (int32_t)width; x++)
+        {
+            glm::vec4 c(0);
+            for(int32_t i = 0; i < (int32_t)kernelSize; i++)
+            {
+                int32_t sx = glm::clamp(x - radius + i, 0, (int32_t)width - 1);
+                const float* pTexel = pSrc + ((size_t)y * width + sx) * 4;
+                c += glm::vec4(pTexel[0], pTexel[1], pTexel[2], pTexel[3]) * pWeights[i];
+            }
+            horizontal[y * width + x] = c;
+        }
+    }
+
+    for(int32_t y = 0; y < (int32_t)height; y++)
+    {
+        for(int32_t x = 0; x < (int32_t)width; x++)
+        {
+            glm::vec4 c(0);
+            for(int32_t i = 0; i < (int32_t)kernelSize; i++)
+            {
+                int32_t sy = glm::clamp(y - radius + i, 0, (int32_t)height - 1);
+                c += horizontal[sy * width + x] * pWeights[i];
+            }
+            memcpy(pDst + ((size_t)y * width + x) * 4, &c, sizeof(c));
+        }
+    }
+}
+
+/** Generate a cube-map whose texels store their direction, mapped to [0, 1]. The faces follow the OpenGL specification.
+*/
+static std::vector<float> createDirectionCubeMap(uint32_t size, CpuPostProcessing::CubeMap& cubeMap)
+{
+    std::vector<float> data((size_t)size * size * 4 * 6);
+    cubeMap.size = size;
+    for(uint32_t face = 0; face < 6; face++)
+    {
+        float* pFace = data.data() + (size_t)face * size * size * 4;
+        cubeMap.pFaces[face] = pFace;
+        for(uint32_t y = 0; y < size; y++)
+        {
+            for(uint32_t x = 0; x < size; x++)
+            {
+                float sc = (x + 0.5f) / size * 2 - 1;
+                float tc = (y + 0.5f) / size * 2 - 1;
+                const glm::vec3 kDirs[6] = {glm::vec3(1, -tc, -sc), glm::vec3(-1, -tc, sc), glm::vec3(sc, 1, tc), glm::vec3(sc, -1, -tc), glm::vec3(sc, -tc, 1), glm::vec3(-sc, -tc, -1)};
+                glm::vec3 color = glm::normalize(kDirs[face]) * 0.5f + 0.5f;
+                float* pTexel = pFace + ((size_t)y * size + x) * 4;
+                pTexel[0] = color.r;
+                pTexel[1] = color.g;
+                pTexel[2] = color.b;
+                pTexel[3] = 1;
+            }
+        }
+    }
+    return data;
+}
+
+/** The sky box colors for a direction cube-map, following SkyBox.vs. Each pixel gets the direction of its view ray, so face selection and filtering don't need a reference.
+*/
+static void renderSkyBoxReference(const glm::mat4& viewMat, const glm::mat4& projMat, float scale, const float* pDepth, uint32_t width, uint32_t height, bool isTopDown, float* pDst)
+{
+    glm::mat4 invViewProj = glm::inverse(projMat * glm::mat4(glm::mat3(viewMat)));
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            size_t pixel = (size_t)y * width + x;
+            if(pDepth && pDepth[pixel] < 1.0f)
+            {
+                continue;
+            }
+
+            float ndcY = (y + 0.5f) / height * 2 - 1;
+            glm::vec2 ndc((x + 0.5f) / width * 2 - 1, isTopDown ? -ndcY : ndcY);
+            glm::vec4 worldPos = invViewProj * glm::vec4(ndc / scale, 0, 1);
+            glm::vec4 color(glm::normalize(glm::vec3(worldPos) / worldPos.w) * 0.5f + 0.5f, 1);
+            memcpy(pDst + pixel * 4, &color, sizeof(color));
+        }
+    }
+}
+
+/** Compares the vectorized and multi-threaded functions with single-threaded, per-pixel implementations of the shaders.
+    The image has an odd size, to exercise the scalar tails, and is tall enough to be split into several bands.
+*/
+bool testCpuPostProcessing(RenderContext* pRenderContext)
+{
+    bool passed = true;
+    RandomGenerator rng;
+
+    const uint32_t kWidth = 45;
+    const uint32_t kHeight = 77;
+    std::vector<float> image = createHdrImage(kWidth, kHeight, rng);
+    std::vector<float> result(image.size());
+    std::vector<float> reference(image.size());
+
+    const ToneMapping::Operator kOperators[] = {ToneMapping::Operator::Clamp, ToneMapping::Operator::Linear, ToneMapping::Operator::Reinhard, ToneMapping::Operator::ReinhardModified, ToneMapping::Operator::HejiHableAlu, ToneMapping::Operator::HableUc2};
+    const float kLods[] = {0.0f, 2.5f, 16.0f};
+    for(uint32_t op = 0; op < arraysize(kOperators); op++)
+    {
+        for(uint32_t lod = 0; lod < arraysize(kLods); lod++)
+        {
+            ToneMappingParams params;
+            params.op = kOperators[op];
+            params.luminanceLod = kLods[lod];
+            params.whiteMaxLuminance = 2.0f;
+            CpuPostProcessing::toneMap(image.data(), kWidth, kHeight, params, result.data());
+            toneMapReference(image.data(), kWidth, kHeight, params, reference.data());
+            passed = compareImages(result, reference, 1e-4f, "toneMap() with operator " + std::to_string(op) + " and LOD " + std::to_string(kLods[lod])) && passed;
+        }
+    }
+
+    for(uint32_t kernelSize = 1; kernelSize <= 11; kernelSize += 2)
+    {
+        CpuPostProcessing::gaussianBlur(image.data(), kWidth, kHeight, kernelSize, result.data());
+        gaussianBlurReference(image.data(), kWidth, kHeight, kernelSize, reference.data());
+        passed = compareImages(result, reference, 1e-5f, "gaussianBlur() with kernel size " + std::to_string(kernelSize)) && passed;
+    }
+
+    std::vector<float> depth = createDepthBuffer(kWidth, kHeight, 0.25f, rng);
+    glm::vec2 referenceRange(1, 0);
+    for(float d : depth)
+    {
+        referenceRange = (d != 1.0f) ? glm::vec2(std::min(referenceRange.x, d), std::max(referenceRange.y, d)) : referenceRange;
+    }
+    glm::vec2 range = CpuPostProcessing::reduceMinMax(depth.data(), kWidth, kHeight);
+    std::vector<float> emptyDepth(depth.size(), 1.0f);
+    glm::vec2 emptyRange = CpuPostProcessing::reduceMinMax(emptyDepth.data(), kWidth, kHeight);
+    if(range != referenceRange || emptyRange != glm::vec2(1, 0))
+    {
+        Logger::log(Logger::Level::Error, "testCpuPostProcessing() - reduceMinMax() mismatch");
+        passed = false;
+    }
+
+    // One view towards each face. The tolerance covers the bilinear filtering of the directions and the unfiltered seams.
+    CpuPostProcessing::CubeMap cubeMap;
+    std::vector<float> cubeData = createDirectionCubeMap(128, cubeMap);
+    depth = createDepthBuffer(kWidth, kHeight, 0.5f, rng);
+    const glm::vec3 kViewDirs[] = {glm::vec3(1, 0.2f, 0.3f), glm::vec3(-1, 0.3f, -0.2f), glm::vec3(0.2f, 1, 0.3f), glm::vec3(0.3f, -1, 0.2f), glm::vec3(0.2f, 0.3f, 1), glm::vec3(-0.3f, 0.2f, -1)};
+    glm::mat4 projMat = glm::perspective(glm::radians(70.0f), (float)kWidth / kHeight, 0.1f, 1000.0f);
+    for(uint32_t face = 0; face < arraysize(kViewDirs); face++)
+    {
+        glm::mat4 viewMat = glm::lookAt(glm::vec3(3, 1, -2), glm::vec3(3, 1, -2) + kViewDirs[face], glm::vec3(0, 1, 0));
+        for(uint32_t topDown = 0; topDown < 2; topDown++)
+        {
+            const float kScale = 1.3f;
+            std::fill(result.begin(), result.end(), -1.0f);
+            std::fill(reference.begin(), reference.end(), -1.0f);
+            CpuPostProcessing::renderSkyBox(cubeMap, viewMat, projMat, kScale, depth.data(), kWidth, kHeight, topDown != 0, result.data());
+            renderSkyBoxReference(viewMat, projMat, kScale, depth.data(), kWidth, kHeight, topDown != 0, reference.data());
+            passed = compareImages(result, reference, 1e-2f, std::string(topDown ? "top-down " : "") + "renderSkyBox() towards face " + std::to_string(face)) && passed;
+        }
+    }
+    return passed;
+}
+
+/** Measures the throughput of the functions on a 1920x1080 image
+*/
+bool benchmarkCpuPostProcessing(RenderContext* pRenderContext)
+{
+    const uint32_t kWidth = 1920;
+    const uint32_t kHeight = 1080;
+    const double kPixelCount = (double)kWidth * kHeight;
+    RandomGenerator rng;
+    std::vector<float> image = createHdrImage(kWidth, kHeight, rng);
+    std::vector<float> result(image.size());
+    std::vector<float> depth = createDepthBuffer(kWidth, kHeight, 0.25f, rng);
+    CpuPostProcessing::CubeMap cubeMap;
+    std::vector<float> cubeData = createDirectionCubeMap(256, cubeMap);
+
+    auto measure = [&](const std::string& name, const std::function<void()>& func)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        func();
+        double durationInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        Logger::log(Logger::Level::Info, "benchmarkCpuPostProcessing() - " + name + ": " + std::to_string(kPixelCount / (std::max(durationInMs, 1e-3) * 1000)) + " MPixels/s");
+    };
+
+    ToneMappingParams params;
+    glm::mat4 viewMat = glm::lookAt(glm::vec3(0), glm::vec3(1, 0.2f, 0.5f), glm::vec3(0, 1, 0));
+    glm::mat4 projMat = glm::perspective(glm::radians(60.0f), (float)kWidth / kHeight, 0.1f, 1000.0f);
+    measure("Uncharted 2 tone mapping", [&]() { CpuPostProcessing::toneMap(image.data(), kWidth, kHeight, params, result.data()); });
+    measure("Gaussian blur with a kernel size of 11", [&]() { CpuPostProcessing::gaussianBlur(image.data(), kWidth, kHeight, 11, result.data()); });
+    measure("min/max reduction", [&]() { CpuPostProcessing::reduceMinMax(depth.data(), kWidth, kHeight); });
+    measure("sky box", [&]() { CpuPostProcessing::renderSkyBox(cubeMap, viewMat, projMat, 1.0f, nullptr, kWidth, kHeight, false, result.data()); });
+    return true;
+}
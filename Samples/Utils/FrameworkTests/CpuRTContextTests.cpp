@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Raytracing/CpuRTContext.h"
+
+/** Checks that CpuRTContext::generateCameraRay() starts the rays on the near plane and points them through the pixel centers
+*/
+bool testCpuRTContext(RenderContext* pRenderContext)
+{
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setAspectRatio(16.0f / 9.0f);
+    pCamera->setDepthRange(0.1f, 1000.0f);
+    pCamera->setPosition(glm::vec3(1, 2, 3));
+    pCamera->setTarget(glm::vec3(-4, 1, -2));
+    pCamera->setUpVector(glm::vec3(0, 1, 0));
+
+    const uint32_t width = 1280;
+    const uint32_t height = 720;
+    const glm::mat4& viewMat = pCamera->getViewMatrix();
+    const glm::mat4& viewProjMat = pCamera->getViewProjMatrix();
+    const uint32_t pixels[][2] = {{0, 0}, {width - 1, 0}, {0, height - 1}, {width - 1, height - 1}, {width / 2, height / 2}, {17, 611}};
+
+    bool success = true;
+    for(const auto& pixel : pixels)
+    {
+        const std::string name = "pixel (" + std::to_string(pixel[0]) + ", " + std::to_string(pixel[1]) + ")";
+        RT::Ray ray = RT::CpuRTContext::generateCameraRay(pCamera.get(), pixel[0], pixel[1], width, height);
+
+        // The camera looks down -Z
+        float depth = -(viewMat * glm::vec4(ray.origin, 1.0f)).z;
+        if(std::abs(depth - pCamera->getNearPlane()) > 1e-3f * pCamera->getNearPlane())
+        {
+            Logger::log(Logger::Level::Error, "testCpuRTContext() - the ray of " + name + " starts at depth " + std::to_string(depth) + ", expected the near plane");
+            success = false;
+        }
+        if(std::abs(glm::length(ray.direction) - 1) > 1e-5f)
+        {
+            Logger::log(Logger::Level::Error, "testCpuRTContext() - the ray direction of " + name + " isn't normalized");
+            success = false;
+        }
+
+        // Project a point further along the ray. It must land on the pixel center, in front of the camera.
+        glm::vec4 clip = viewProjMat * glm::vec4(ray.origin + ray.direction * 10.0f, 1.0f);
+        glm::vec2 expected((pixel[0] + 0.5f) / width, (pixel[1] + 0.5f) / height);
+        glm::vec2 screen(clip.x / clip.w * 0.5f + 0.5f, 0.5f - clip.y / clip.w * 0.5f);
+        if(clip.w <= 0 || glm::length(screen - expected) > 1e-4f)
+        {
+            Logger::log(Logger::Level::Error, "testCpuRTContext() - the ray of " + name + " doesn't go through the pixel center");
+            success = false;
+        }
+    }
+    return success;
+}
+
+/** Measures the primary ray throughput of CpuRTContext::render(), which traces 2x2 packets, and of single rays traced with CpuRTContext::trace() from launch()
+*/
+bool benchmarkCpuRTContext(RenderContext* pRenderContext)
+{
+    Model::SharedPtr pModel = Model::createFromFile("teapot.obj", Model::KeepCpuGeometry);
+    if(pModel == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkCpuRTContext() - can't load 'teapot.obj'");
+        return false;
+    }
+
+    // A grid of teapots, so that the BVH has some depth and most rays hit something
+    const uint32_t gridSize = 16;
+    const float spacing = pModel->getRadius() * 2.0f;
+    RT::CpuRTContext::SharedPtr pContext = RT::CpuRTContext::create();
+    pContext->newScene();
+    for(uint32_t z = 0; z < gridSize; z++)
+    {
+        for(uint32_t x = 0; x < gridSize; x++)
+        {
+            pContext->addObject(pModel, glm::translate(glm::mat4(), glm::vec3((x - gridSize * 0.5f) * spacing, 0, -(float)z * spacing)));
+        }
+    }
+    auto start = CpuTimer::getCurrentTimePoint();
+    pContext->updateScene();
+    double buildInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setAspectRatio(16.0f / 9.0f);
+    pCamera->setDepthRange(0.1f, 1000.0f);
+    pCamera->setPosition(glm::vec3(0, spacing * 2, spacing * 2));
+    pCamera->setTarget(glm::vec3(0, 0, -(float)gridSize * spacing * 0.5f));
+    pCamera->setUpVector(glm::vec3(0, 1, 0));
+
+    RT::CpuRTContext::Image::SharedPtr pImage = RT::CpuRTContext::Image::create(1280, 720);
+    auto closestHit = [](const RT::Ray& ray, const RT::Hit& hit) { return glm::vec4(hit.t); };
+    auto miss = [](const RT::Ray& ray) { return glm::vec4(0); };
+    pContext->render(pImage.get(), pCamera.get(), closestHit, miss);
+    const RT::CpuRTContext::Stats packetStats = pContext->getStats();
+
+    const RT::CpuRTContext* pConstContext = pContext.get();
+    const Camera* pConstCamera = pCamera.get();
+    pContext->launch(pImage.get(), [&](uint32_t x, uint32_t y)
+    {
+        RT::Hit hit;
+        pConstContext->trace(RT::CpuRTContext::generateCameraRay(pConstCamera, x, y, pImage->getWidth(), pImage->getHeight()), hit);
+        return glm::vec4(hit.isValid() ? hit.t : 0.0f);
+    });
+    const RT::CpuRTContext::Stats singleStats = pContext->getStats();
+
+    Logger::log(Logger::Level::Info, "benchmarkCpuRTContext() - " + std::to_string(gridSize * gridSize) + " teapots: BVH build " + std::to_string(buildInMs) + " ms" +
+        ", packets " + std::to_string(packetStats.raysPerSecond * 1e-6) + " MRays/s" +
+        ", single rays " + std::to_string(singleStats.raysPerSecond * 1e-6) + " MRays/s" +
+        " on " + std::to_string(getParallelThreadCount()) + " threads");
+    return true;
+}
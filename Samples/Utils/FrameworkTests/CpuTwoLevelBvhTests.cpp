@@ -0,0 +1,235 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Raytracing/CpuTwoLevelBvh.h"
+
+/** A UV sphere of radius 1
+*/
+static RT::Bvh::SharedConstPtr createSphereBvh(uint32_t segments)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    for(uint32_t y = 0; y <= segments; y++)
+    {
+        for(uint32_t x = 0; x <= segments; x++)
+        {
+            float u = x * 2.0f * (float)M_PI / segments;
+            float v = y * (float)M_PI / segments;
+            positions.push_back(glm::vec3(cos(u) * sin(v), cos(v), sin(u) * sin(v)));
+        }
+    }
+    for(uint32_t y = 0; y < segments; y++)
+    {
+        for(uint32_t x = 0; x < segments; x++)
+        {
+            uint32_t i = y * (segments + 1) + x;
+            indices.insert(indices.end(), {i, i + 1, i + segments + 1, i + 1, i + segments + 2, i + segments + 1});
+        }
+    }
+    return RT::Bvh::create(positions.data(), (uint32_t)positions.size(), indices.data(), (uint32_t)indices.size() / 3);
+}
+
+static glm::vec3 randomVec3(RandomGenerator& rng, float extent)
+{
+    return glm::vec3(rng.nextFloat(-extent, extent), rng.nextFloat(-extent, extent), rng.nextFloat(-extent, extent));
+}
+
+static glm::mat4 randomTransform(RandomGenerator& rng, float extent)
+{
+    glm::mat4 transform = glm::translate(glm::mat4(), randomVec3(rng, extent));
+    transform = glm::rotate(transform, rng.nextFloat(0, 2.0f * (float)M_PI), glm::normalize(randomVec3(rng, 1) + glm::vec3(0, 0, 0.01f)));
+    return glm::scale(transform, glm::vec3(rng.nextFloat(0.5f, 2.0f), rng.nextFloat(0.5f, 2.0f), rng.nextFloat(0.5f, 2.0f)));
+}
+
+/** Brute-force closest hit. Intersects every visible instance's bottom level with the object-space ray.
+*/
+static RT::Hit intersectReference(const RT::TwoLevelBvh* pBvh, const RT::Ray& ray)
+{
+    RT::Hit closest;
+    for(uint32_t instanceId = 0; instanceId < pBvh->getInstanceCount(); instanceId++)
+    {
+        if(pBvh->isVisible(instanceId) == false)
+        {
+            continue;
+        }
+        const glm::mat4 invTransform = glm::inverse(pBvh->getTransform(instanceId));
+        RT::Ray localRay = ray;
+        localRay.origin = glm::vec3(invTransform * glm::vec4(ray.origin, 1.0f));
+        localRay.direction = glm::mat3(invTransform) * ray.direction;
+
+        RT::Hit hit = closest;
+        hit.instanceId = instanceId;
+        if(pBvh->getBottomLevel(instanceId)->intersect(localRay, hit))
+        {
+            closest = hit;
+        }
+    }
+    return closest;
+}
+
+static bool checkQueries(const RT::TwoLevelBvh* pBvh, const std::string& name, RandomGenerator& rng)
+{
+    const uint32_t rayCount = 500;
+    uint32_t hitCount = 0;
+    for(uint32_t i = 0; i < rayCount; i++)
+    {
+        RT::Ray ray;
+        ray.origin = randomVec3(rng, 60);
+        ray.direction = glm::normalize(randomVec3(rng, 1) + glm::vec3(0.01f, 0, 0));
+
+        RT::Hit hit;
+        bool found = pBvh->intersect(ray, hit);
+        RT::Hit reference = intersectReference(pBvh, ray);
+        if(found != reference.isValid() || (found && std::abs(hit.t - reference.t) > 1e-4f * (1 + reference.t)))
+        {
+            Logger::log(Logger::Level::Error, "testCpuTwoLevelBvh() - " + name + ": intersect() doesn't match the brute-force reference for ray " + std::to_string(i));
+            return false;
+        }
+        if(pBvh->occluded(ray) != reference.isValid() || (pBvh->pick(ray) != RT::TwoLevelBvh::kInvalidInstance) != reference.isValid())
+        {
+            Logger::log(Logger::Level::Error, "testCpuTwoLevelBvh() - " + name + ": occluded() or pick() doesn't match the brute-force reference for ray " + std::to_string(i));
+            return false;
+        }
+        hitCount += found ? 1 : 0;
+    }
+
+    if(hitCount == 0 || hitCount == rayCount)
+    {
+        Logger::log(Logger::Level::Error, "testCpuTwoLevelBvh() - " + name + ": " + std::to_string(hitCount) + " of " + std::to_string(rayCount) + " rays hit, the test doesn't cover both cases");
+        return false;
+    }
+    return true;
+}
+
+/** Checks the queries against a brute-force reference after a build, after refits, with hidden instances and after a rebuild caused by the SAH cost
+*/
+bool testCpuTwoLevelBvh(RenderContext* pRenderContext)
+{
+    RandomGenerator rng;
+    RT::Bvh::SharedConstPtr pSphere = createSphereBvh(8);
+    RT::TwoLevelBvh::SharedPtr pBvh = RT::TwoLevelBvh::create();
+    const uint32_t instanceCount = 2000;
+    for(uint32_t i = 0; i < instanceCount; i++)
+    {
+        pBvh->addInstance(pSphere, randomTransform(rng, 50));
+    }
+    pBvh->update();
+    bool success = checkQueries(pBvh.get(), "after the build", rng);
+
+    // Small moves are refit
+    const uint32_t buildCount = pBvh->getStats().buildCount;
+    for(uint32_t i = 0; i < instanceCount; i++)
+    {
+        pBvh->setTransform(i, glm::translate(glm::mat4(), randomVec3(rng, 1)) * pBvh->getTransform(i));
+    }
+    pBvh->update();
+    if(pBvh->getStats().buildCount != buildCount || pBvh->getStats().refitCount == 0)
+    {
+        Logger::log(Logger::Level::Error, "testCpuTwoLevelBvh() - small moves should refit the top level, not rebuild it");
+        success = false;
+    }
+    success = checkQueries(pBvh.get(), "after a refit", rng) && success;
+
+    for(uint32_t i = 0; i < instanceCount; i += 3)
+    {
+        pBvh->setVisible(i, false);
+    }
+    success = checkQueries(pBvh.get(), "with hidden instances", rng) && success;
+
+    // Scrambling the instances degrades the refit tree past the rebuild threshold
+    for(uint32_t i = 0; i < instanceCount; i++)
+    {
+        pBvh->setTransform(i, randomTransform(rng, 50));
+    }
+    pBvh->update();
+    if(pBvh->getStats().buildCount == buildCount)
+    {
+        Logger::log(Logger::Level::Error, "testCpuTwoLevelBvh() - scrambling the instances should rebuild the top level");
+        success = false;
+    }
+    success = checkQueries(pBvh.get(), "after a rebuild", rng) && success;
+    return success;
+}
+
+/** Measures the top-level build and refit times for 100k randomly placed instances, and the closest-hit query rate
+*/
+bool benchmarkCpuTwoLevelBvh(RenderContext* pRenderContext)
+{
+    RandomGenerator rng;
+    RT::Bvh::SharedConstPtr pSphere = createSphereBvh(8);
+    RT::TwoLevelBvh::SharedPtr pBvh = RT::TwoLevelBvh::create();
+    const uint32_t instanceCount = 100000;
+    const float extent = 500;
+    std::vector<glm::vec3> positions(instanceCount);
+    for(uint32_t i = 0; i < instanceCount; i++)
+    {
+        positions[i] = randomVec3(rng, extent);
+        pBvh->addInstance(pSphere, glm::translate(glm::mat4(), positions[i]));
+    }
+    pBvh->update();
+    const float buildInMs = pBvh->getStats().buildTimeInMs;
+
+    // Every instance moves a little every frame. Frames which rebuild the top level aren't included in the refit time.
+    const uint32_t frameCount = 10;
+    float refitInMs = 0;
+    uint32_t refitCount = 0;
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        for(uint32_t i = 0; i < instanceCount; i++)
+        {
+            positions[i] += randomVec3(rng, 0.01f * extent);
+            pBvh->setTransform(i, glm::translate(glm::mat4(), positions[i]));
+        }
+        pBvh->update();
+        if(pBvh->getStats().refitCount != refitCount)
+        {
+            refitCount = pBvh->getStats().refitCount;
+            refitInMs += pBvh->getStats().refitTimeInMs;
+        }
+    }
+    const RT::TwoLevelBvh::Stats& stats = pBvh->getStats();
+
+    const uint32_t rayCount = 100000;
+    uint32_t hitCount = 0;
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < rayCount; i++)
+    {
+        RT::Ray ray;
+        ray.origin = randomVec3(rng, extent);
+        ray.direction = glm::normalize(randomVec3(rng, 1) + glm::vec3(0.01f, 0, 0));
+        RT::Hit hit;
+        hitCount += pBvh->intersect(ray, hit) ? 1 : 0;
+    }
+    double queryInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    Logger::log(Logger::Level::Info, "benchmarkCpuTwoLevelBvh() - " + std::to_string(instanceCount) + " instances on " + std::to_string(getParallelThreadCount()) + " threads" +
+        ": build " + std::to_string(buildInMs) + " ms" +
+        ", refit " + std::to_string((refitCount > 0) ? refitInMs / refitCount : 0.0f) + " ms (" + std::to_string(refitCount) + " refits and " + std::to_string(stats.buildCount - 1) + " rebuilds in " + std::to_string(frameCount) + " frames, relative SAH cost " + std::to_string(stats.sahCost) + ")" +
+        ", " + std::to_string(rayCount / (queryInMs * 1000)) + " MRays/s on one thread (" + std::to_string(hitCount) + " hits)");
+    return true;
+}
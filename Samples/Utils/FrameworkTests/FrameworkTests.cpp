@@ -0,0 +1,158 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+
+static const TestDesc kChecks[] =
+{
+    {"AreaLightSampler", testAreaLightSampler},
+    {"AsyncModelLoader", testAsyncModelLoader},
+    {"AsyncVideoEncoder", testAsyncVideoEncoder},
+    {"CommandList", testCommandList},
+    {"CpuMaterialEvaluator", testCpuMaterialEvaluator},
+    {"CpuPostProcessing", testCpuPostProcessing},
+    {"CpuRTContext", testCpuRTContext},
+    {"CpuTwoLevelBvh", testCpuTwoLevelBvh},
+    {"GeometryPool", testGeometryPool},
+    {"ImageProcessing", testImageProcessing},
+    {"ImageSequenceWriter", testImageSequenceWriter},
+    {"LightClusters", testLightClusters},
+    {"ObjectPathSet", testObjectPathSet},
+    {"ParallelReduction", testParallelReduction},
+    {"RangeAllocator", testRangeAllocator},
+    {"RenderContext", testRenderContext},
+    {"SceneBinaryFormat", testSceneBinaryFormat},
+    {"TextureCompressor", testTextureCompressor},
+    {"TextureResidency", testTextureResidency},
+    {"VideoDecoder", testVideoDecoder},
+};
+
+static const TestDesc kBenchmarks[] =
+{
+    {"AreaLightSampler", benchmarkAreaLightSampler},
+    {"AsyncVideoEncoder", benchmarkAsyncVideoEncoder},
+    {"CpuMaterialEvaluator", benchmarkCpuMaterialEvaluator},
+    {"CpuPostProcessing", benchmarkCpuPostProcessing},
+    {"CpuRTContext", benchmarkCpuRTContext},
+    {"CpuTwoLevelBvh", benchmarkCpuTwoLevelBvh},
+    {"GeometryPool", benchmarkGeometryPool},
+    {"ImageProcessing", benchmarkImageProcessing},
+    {"ImageSequenceWriter", benchmarkImageSequenceWriter},
+    {"LightClusters", benchmarkLightClusters},
+    {"ObjectPathSet", benchmarkObjectPathSet},
+    {"SceneBinaryFormat", benchmarkSceneBinaryFormat},
+    {"TextureCompressor", benchmarkTextureCompressor},
+    {"VideoDecoder", benchmarkVideoDecoder},
+};
+
+void GUI_CALL FrameworkTests::runChecksCallback(void* pUserData)
+{
+    FrameworkTests* pTests = reinterpret_cast<FrameworkTests*>(pUserData);
+    pTests->runTests(kChecks, arraysize(kChecks));
+}
+
+void GUI_CALL FrameworkTests::runBenchmarksCallback(void* pUserData)
+{
+    FrameworkTests* pTests = reinterpret_cast<FrameworkTests*>(pUserData);
+    pTests->runTests(kBenchmarks, arraysize(kBenchmarks));
+}
+
+void FrameworkTests::initUI()
+{
+    Gui::setGlobalHelpMessage("Runs the framework checks and benchmarks. Failures are written to the log.");
+    mpGui->addButton("Run Checks", &FrameworkTests::runChecksCallback, this);
+    mpGui->addButton("Run Benchmarks", &FrameworkTests::runBenchmarksCallback, this);
+}
+
+void FrameworkTests::runTests(const TestDesc* pTests, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; i++)
+    {
+        Logger::log(Logger::Level::Info, std::string("Running ") + pTests[i].name);
+        auto start = CpuTimer::getCurrentTimePoint();
+        Result result;
+        result.name = pTests[i].name;
+        result.passed = pTests[i].func(mpRenderContext.get());
+        result.milliseconds = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        Logger::log(result.passed ? Logger::Level::Info : Logger::Level::Error, result.name + (result.passed ? " passed" : " FAILED") + " in " + std::to_string(result.milliseconds) + " ms");
+
+        mFailedCount += result.passed ? 0 : 1;
+        mResults.push_back(result);
+        // The checks can take a while. Keep the window responsive.
+        pollForEvents();
+    }
+}
+
+void FrameworkTests::onLoad()
+{
+    initUI();
+    runTests(kChecks, arraysize(kChecks));
+    if(mRunBenchmarksOnLoad)
+    {
+        runTests(kBenchmarks, arraysize(kBenchmarks));
+    }
+    if(mExitWhenDone)
+    {
+        shutdownApp();
+    }
+}
+
+void FrameworkTests::onFrameRender()
+{
+    const glm::vec4 clearColor(0.38f, 0.52f, 0.10f, 1);
+    mpDefaultFBO->clear(clearColor, 1.0f, 0, FboAttachmentType::All);
+
+    std::string msg = getGlobalSampleMessage(true);
+    msg += "\n" + std::to_string(mResults.size() - mFailedCount) + " passed, " + std::to_string(mFailedCount) + " failed";
+    for(const auto& result : mResults)
+    {
+        msg += "\n" + result.name + (result.passed ? ": passed, " : ": FAILED, ") + std::to_string(result.milliseconds) + " ms";
+    }
+    renderText(msg, glm::vec2(10, 10));
+}
+
+void FrameworkTests::onResizeSwapChain()
+{
+    RenderContext::Viewport vp;
+    vp.height = (float)mpDefaultFBO->getHeight();
+    vp.width = (float)mpDefaultFBO->getWidth();
+    mpRenderContext->setViewport(0, vp);
+}
+
+int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
+{
+    FrameworkTests sample;
+    SampleConfig config;
+    config.windowDesc.title = "Framework Tests";
+    // Some checks provoke errors on purpose, and the sample must be able to run unattended
+    config.showMessageBoxOnError = false;
+
+    std::string cmdLine = lpCmdLine;
+    sample.setOptions(cmdLine.find("-benchmark") != std::string::npos, cmdLine.find("-exit") != std::string::npos);
+    int exitCode = sample.run(config);
+    return (exitCode == 0 && sample.hasFailed() == false) ? 0 : 1;
+}
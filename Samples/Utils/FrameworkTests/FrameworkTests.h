@@ -0,0 +1,155 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+/** A self-check or a benchmark of a framework class.
+    Checks compare the optimized code paths with simple reference implementations and test invariants with deterministic random inputs. They log every mismatch they find.
+    Benchmarks log their measurements.
+    \return false if a check failed, or if the benchmark couldn't run
+*/
+using TestFunc = bool(*)(RenderContext* pRenderContext);
+
+struct TestDesc
+{
+    const char* name;
+    TestFunc func;
+};
+
+/** Runs the framework checks on startup, and the benchmarks on request.
+    Command line options: "-benchmark" also runs the benchmarks on startup, "-exit" closes the sample once they are done. WinMain returns a non-zero exit code if anything failed, so the sample can run unattended.
+*/
+class FrameworkTests : public Sample
+{
+public:
+    void onLoad() override;
+    void onFrameRender() override;
+    void onResizeSwapChain() override;
+
+    /** Set the startup behavior. Called from WinMain before run().
+    */
+    void setOptions(bool runBenchmarks, bool exitWhenDone) { mRunBenchmarksOnLoad = runBenchmarks; mExitWhenDone = exitWhenDone; }
+
+    /** Check if any check or benchmark failed
+    */
+    bool hasFailed() const { return mFailedCount > 0; }
+
+private:
+    struct Result
+    {
+        std::string name;
+        bool passed;
+        double milliseconds;
+    };
+
+    void initUI();
+    void runTests(const TestDesc* pTests, uint32_t count);
+    static void GUI_CALL runChecksCallback(void* pUserData);
+    static void GUI_CALL runBenchmarksCallback(void* pUserData);
+
+    std::vector<Result> mResults;
+    uint32_t mFailedCount = 0;
+    bool mRunBenchmarksOnLoad = false;
+    bool mExitWhenDone = false;
+};
+
+// AreaLightSamplerTests.cpp
+bool testAreaLightSampler(RenderContext* pRenderContext);
+bool benchmarkAreaLightSampler(RenderContext* pRenderContext);
+
+// LightClustersTests.cpp
+bool testLightClusters(RenderContext* pRenderContext);
+bool benchmarkLightClusters(RenderContext* pRenderContext);
+
+// CpuRTContextTests.cpp
+bool testCpuRTContext(RenderContext* pRenderContext);
+bool benchmarkCpuRTContext(RenderContext* pRenderContext);
+
+// CpuTwoLevelBvhTests.cpp
+bool testCpuTwoLevelBvh(RenderContext* pRenderContext);
+bool benchmarkCpuTwoLevelBvh(RenderContext* pRenderContext);
+
+// RenderContextTests.cpp
+bool testRenderContext(RenderContext* pRenderContext);
+
+// CommandListTests.cpp
+bool testCommandList(RenderContext* pRenderContext);
+
+// GeometryPoolTests.cpp
+bool testGeometryPool(RenderContext* pRenderContext);
+bool benchmarkGeometryPool(RenderContext* pRenderContext);
+
+// RangeAllocatorTests.cpp
+bool testRangeAllocator(RenderContext* pRenderContext);
+
+// AsyncVideoEncoderTests.cpp
+bool testAsyncVideoEncoder(RenderContext* pRenderContext);
+bool benchmarkAsyncVideoEncoder(RenderContext* pRenderContext);
+
+// VideoDecoderTests.cpp
+bool testVideoDecoder(RenderContext* pRenderContext);
+bool benchmarkVideoDecoder(RenderContext* pRenderContext);
+
+// ImageSequenceWriterTests.cpp
+bool testImageSequenceWriter(RenderContext* pRenderContext);
+bool benchmarkImageSequenceWriter(RenderContext* pRenderContext);
+
+// TextureResidencyTests.cpp
+bool testTextureResidency(RenderContext* pRenderContext);
+
+// TextureCompressorTests.cpp
+bool testTextureCompressor(RenderContext* pRenderContext);
+bool benchmarkTextureCompressor(RenderContext* pRenderContext);
+
+// ImageProcessingTests.cpp
+bool testImageProcessing(RenderContext* pRenderContext);
+bool benchmarkImageProcessing(RenderContext* pRenderContext);
+
+// CpuMaterialEvaluatorTests.cpp
+bool testCpuMaterialEvaluator(RenderContext* pRenderContext);
+bool benchmarkCpuMaterialEvaluator(RenderContext* pRenderContext);
+
+// CpuPostProcessingTests.cpp
+bool testCpuPostProcessing(RenderContext* pRenderContext);
+bool benchmarkCpuPostProcessing(RenderContext* pRenderContext);
+
+// ParallelReductionTests.cpp
+bool testParallelReduction(RenderContext* pRenderContext);
+
+// SceneBinaryFormatTests.cpp
+bool testSceneBinaryFormat(RenderContext* pRenderContext);
+bool benchmarkSceneBinaryFormat(RenderContext* pRenderContext);
+
+// AsyncModelLoaderTests.cpp
+bool testAsyncModelLoader(RenderContext* pRenderContext);
+
+// ObjectPathSetTests.cpp
+bool testObjectPathSet(RenderContext* pRenderContext);
+bool benchmarkObjectPathSet(RenderContext* pRenderContext);
@@ -0,0 +1,153 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/Model/GeometryPool.h"
+#include <algorithm>
+
+using DrawItem = GeometryPool::DrawItem;
+using DrawBatch = GeometryPool::DrawBatch;
+using DrawArguments = GeometryPool::DrawArguments;
+
+static std::vector<DrawItem> createRandomDraws(RandomGenerator& rng, uint32_t drawCount, uint32_t bucketCount)
+{
+    std::vector<DrawItem> items(drawCount);
+    for(uint32_t i = 0; i < drawCount; i++)
+    {
+        DrawItem& item = items[i];
+        item.range.bucketID = (rng.next() >> 8) % bucketCount;
+        item.range.firstVertex = (rng.next() >> 8) % 100000;
+        item.range.vertexCount = 1 + (rng.next() >> 8) % 1000;
+        item.range.firstIndex = (rng.next() >> 8) % 300000;
+        item.range.indexCount = 3 * (1 + (rng.next() >> 8) % 1000);
+        item.instanceCount = 1 + (rng.next() >> 8) % 4;
+        item.baseInstance = i;
+    }
+    return items;
+}
+
+/** Compares buildDrawArguments() with a stable sort of the draws by bucket
+*/
+static bool checkDrawArguments(const std::vector<DrawItem>& items, const std::string& name)
+{
+    std::vector<DrawBatch> batches;
+    std::vector<DrawArguments> args;
+    GeometryPool::buildDrawArguments(items, batches, args);
+
+    auto fail = [&name](const std::string& msg)
+    {
+        Logger::log(Logger::Level::Error, "testGeometryPool() - " + name + ": " + msg);
+        return false;
+    };
+
+    std::vector<DrawItem> sorted = items;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const DrawItem& a, const DrawItem& b) { return a.range.bucketID < b.range.bucketID; });
+    if(args.size() != sorted.size())
+    {
+        return fail("expected " + std::to_string(sorted.size()) + " argument records, got " + std::to_string(args.size()));
+    }
+
+    for(size_t i = 0; i < sorted.size(); i++)
+    {
+        const DrawItem& item = sorted[i];
+        const DrawArguments& a = args[i];
+        if(a.indexCount != item.range.indexCount || a.instanceCount != item.instanceCount || a.firstIndex != item.range.firstIndex ||
+            a.baseVertex != (int32_t)item.range.firstVertex || a.baseInstance != item.baseInstance)
+        {
+            return fail("argument record " + std::to_string(i) + " doesn't match its draw");
+        }
+    }
+
+    // One batch per used bucket, in bucket order, covering the records without gaps
+    uint32_t nextDraw = 0;
+    for(size_t b = 0; b < batches.size(); b++)
+    {
+        const DrawBatch& batch = batches[b];
+        if(batch.firstDraw != nextDraw || batch.drawCount == 0 || (b > 0 && batch.bucketID <= batches[b - 1].bucketID))
+        {
+            return fail("batch " + std::to_string(b) + " is out of order or empty");
+        }
+        for(uint32_t d = batch.firstDraw; d < batch.firstDraw + batch.drawCount; d++)
+        {
+            if(sorted[d].range.bucketID != batch.bucketID)
+            {
+                return fail("record " + std::to_string(d) + " is in the batch of another bucket");
+            }
+        }
+        nextDraw += batch.drawCount;
+    }
+    if(nextDraw != args.size())
+    {
+        return fail("the batches cover " + std::to_string(nextDraw) + " of " + std::to_string(args.size()) + " records");
+    }
+    return true;
+}
+
+/** Checks the indirect argument generation. It runs on the CPU, so no meshes or buffers are created.
+*/
+bool testGeometryPool(RenderContext* pRenderContext)
+{
+    RandomGenerator rng;
+    bool passed = true;
+    passed = checkDrawArguments(std::vector<DrawItem>(), "no draws") && passed;
+    passed = checkDrawArguments(createRandomDraws(rng, 1, 1), "single draw") && passed;
+    passed = checkDrawArguments(createRandomDraws(rng, 1000, 1), "single bucket") && passed;
+    passed = checkDrawArguments(createRandomDraws(rng, 1000, 7), "7 buckets") && passed;
+
+    // Buckets which aren't used by any draw don't get a batch
+    std::vector<DrawItem> sparse = createRandomDraws(rng, 200, 2);
+    for(auto& item : sparse)
+    {
+        item.range.bucketID = item.range.bucketID * 5 + 3;
+    }
+    passed = checkDrawArguments(sparse, "sparse buckets") && passed;
+    return passed;
+}
+
+/** Measures the CPU cost of generating the arguments for a large pass
+*/
+bool benchmarkGeometryPool(RenderContext* pRenderContext)
+{
+    const uint32_t kDrawCount = 100000;
+    const uint32_t kBucketCount = 8;
+    const uint32_t kRepeatCount = 20;
+
+    RandomGenerator rng;
+    std::vector<DrawItem> items = createRandomDraws(rng, kDrawCount, kBucketCount);
+    std::vector<DrawBatch> batches;
+    std::vector<DrawArguments> args;
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < kRepeatCount; i++)
+    {
+        GeometryPool::buildDrawArguments(items, batches, args);
+    }
+    double ms = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kRepeatCount;
+
+    Logger::log(Logger::Level::Info, "benchmarkGeometryPool() - buildDrawArguments(): " + std::to_string(kDrawCount) + " draws in " + std::to_string(kBucketCount) + " buckets, " + std::to_string(ms) + " ms");
+    return batches.size() == kBucketCount;
+}
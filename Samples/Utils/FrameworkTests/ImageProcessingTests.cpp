@@ -0,0 +1,465 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/ImageProcessing.h"
+#include <cmath>
+
+using MipFilter = ImageProcessing::MipFilter;
+
+static uint32_t asUint(float f)
+{
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static float asFloat(uint32_t u)
+{
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+/** Scalar half to float conversion
+*/
+static float halfToFloatReference(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+    if(exp == 0x1f)
+    {
+        // Inf/NaN
+        return asFloat(sign | 0x7f800000 | (mantissa << 13));
+    }
+    if(exp == 0)
+    {
+        // Zero/denormal
+        float value = std::ldexp((float)mantissa, -24);
+        return (sign != 0) ? -value : value;
+    }
+    return asFloat(sign | ((exp + 127 - 15) << 23) | (mantissa << 13));
+}
+
+/** Scalar float to half conversion, rounding to nearest-even
+*/
+static uint16_t floatToHalfReference(float value)
+{
+    uint32_t f = asUint(value);
+    uint16_t sign = (uint16_t)((f >> 16) & 0x8000);
+    uint32_t exp = (f >> 23) & 0xff;
+    uint32_t mantissa = f & 0x7fffff;
+    if(exp == 0xff)
+    {
+        return sign | ((mantissa != 0) ? 0x7e00 : 0x7c00);
+    }
+
+    // Round the magnitude to a multiple of the half-precision ulp at its exponent
+    double magnitude = std::abs((double)value);
+    int32_t e = (magnitude > 0) ? std::max(std::ilogb(magnitude), -14) : -14;
+    double ulp = std::ldexp(1.0, e - 10);
+    double rounded = magnitude / ulp;
+    double floored = std::floor(rounded);
+    double fraction = rounded - floored;
+    if(fraction > 0.5 || (fraction == 0.5 && std::fmod(floored, 2.0) != 0))
+    {
+        floored += 1;
+    }
+    rounded = floored * ulp;
+    if(rounded >= 65536.0)
+    {
+        return sign | 0x7c00;
+    }
+
+    int32_t re = (rounded > 0) ? std::ilogb(rounded) : -15;
+    if(re < -14)
+    {
+        return sign | (uint16_t)(rounded / std::ldexp(1.0, -24));
+    }
+    return sign | (uint16_t)(((re + 15) << 10) | ((uint32_t)(rounded / std::ldexp(1.0, re - 10)) & 0x3ff));
+}
+
+static float srgbToLinearReference(float c)
+{
+    return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgbReference(float c)
+{
+    c = std::max(0.0f, std::min(1.0f, c));
+    return (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1 / 2.4f) - 0.055f;
+}
+
+/** The weight of a source texel for a destination texel, along one axis
+    \param[in] i The source texel
+    \param[in] center The center of the destination texel, in source texels
+    \param[in] scale The source size divided by the destination size
+*/
+static float filterWeightReference(int32_t i, float center, float scale, MipFilter filter)
+{
+    if(filter == MipFilter::Box)
+    {
+        // The overlap of the source texel with the destination texel
+        float begin = std::max((float)i, center - scale * 0.5f);
+        float end = std::min((float)(i + 1), center + scale * 0.5f);
+        return std::max(0.0f, end - begin);
+    }
+
+    // Kaiser-windowed sinc with a radius of 3 destination texels and alpha = 4
+    const double kPi = 3.14159265358979;
+    auto besselI0 = [](double x)
+    {
+        double sum = 1;
+        double term = 1;
+        for(uint32_t k = 1; k < 30; k++)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    };
+    double u = (i + 0.5 - center) / scale;
+    double r = u / 3.0;
+    if(std::abs(r) >= 1)
+    {
+        return 0;
+    }
+    double sinc = (std::abs(u) < 1e-6) ? 1.0 : std::sin(kPi * u) / (kPi * u);
+    return (float)(sinc * besselI0(4.0 * std::sqrt(1 - r * r)) / besselI0(4.0));
+}
+
+/** Describes how the reference code reads and writes a format
+*/
+struct TestLayout
+{
+    enum class Type
+    {
+        Unorm8,
+        Float16,
+        Float32,
+    };
+    Type type;
+    uint32_t channelCount;
+    uint32_t srgbChannelCount;
+    uint32_t bytesPerPixel;
+};
+
+static TestLayout getTestLayout(ResourceFormat format)
+{
+    TestLayout layout;
+    layout.bytesPerPixel = getFormatBytesPerBlock(format);
+    layout.srgbChannelCount = isSrgbFormat(format) ? 3 : 0;
+    switch(getFormatType(format))
+    {
+    case FormatType::Float:
+        layout.type = (layout.bytesPerPixel / getFormatChannelCount(format) == 2) ? TestLayout::Type::Float16 : TestLayout::Type::Float32;
+        break;
+    default:
+        layout.type = TestLayout::Type::Unorm8;
+    }
+    layout.channelCount = getFormatChannelCount(format);
+    return layout;
+}
+
+/** Non-separable, single-threaded downsample. Edge texels are repeated.
+*/
+static void downsampleReference(const uint8_t* pSrc, uint32_t width, uint32_t height, ResourceFormat format, MipFilter filter, uint8_t* pDst)
+{
+    TestLayout layout = getTestLayout(format);
+    uint32_t dstWidth = std::max(width / 2, 1u);
+    uint32_t dstHeight = std::max(height / 2, 1u);
+
+    auto decode = [&](uint32_t x, uint32_t y, uint32_t c)
+    {
+        size_t i = ((size_t)y * width + x) * layout.channelCount + c;
+        switch(layout.type)
+        {
+        case TestLayout::Type::Unorm8:
+            return (c < layout.srgbChannelCount) ? srgbToLinearReference(pSrc[i] / 255.0f) : pSrc[i] / 255.0f;
+        case TestLayout::Type::Float16:
+            return halfToFloatReference(((const uint16_t*)pSrc)[i]);
+        default:
+            return ((const float*)pSrc)[i];
+        }
+    };
+
+    float scaleX = (float)width / dstWidth;
+    float scaleY = (float)height / dstHeight;
+    float radiusX = (filter == MipFilter::Box) ? scaleX * 0.5f : 3 * scaleX;
+    float radiusY = (filter == MipFilter::Box) ? scaleY * 0.5f : 3 * scaleY;
+    for(uint32_t y = 0; y < dstHeight; y++)
+    {
+        for(uint32_t x = 0; x < dstWidth; x++)
+        {
+            float centerX = (x + 0.5f) * scaleX;
+            float centerY = (y + 0.5f) * scaleY;
+            for(uint32_t c = 0; c < layout.channelCount; c++)
+            {
+                double sum = 0;
+                double weightSum = 0;
+                for(int32_t sy = (int32_t)std::floor(centerY - radiusY); sy <= (int32_t)std::ceil(centerY + radiusY); sy++)
+                {
+                    float wy = filterWeightReference(sy, centerY, scaleY, filter);
+                    for(int32_t sx = (int32_t)std::floor(centerX - radiusX); sx <= (int32_t)std::ceil(centerX + radiusX); sx++)
+                    {
+                        double w = (double)wy * filterWeightReference(sx, centerX, scaleX, filter);
+                        uint32_t cx = (uint32_t)std::max(0, std::min((int32_t)width - 1, sx));
+                        uint32_t cy = (uint32_t)std::max(0, std::min((int32_t)height - 1, sy));
+                        sum += w * decode(cx, cy, c);
+                        weightSum += w;
+                    }
+                }
+                float value = (float)(sum / weightSum);
+
+                size_t i = ((size_t)y * dstWidth + x) * layout.channelCount + c;
+                switch(layout.type)
+                {
+                case TestLayout::Type::Unorm8:
+                    value = (c < layout.srgbChannelCount) ? linearToSrgbReference(value) : value;
+                    pDst[i] = (uint8_t)(std::max(0.0f, std::min(1.0f, value)) * 255.0f + 0.5f);
+                    break;
+                case TestLayout::Type::Float16:
+                    ((uint16_t*)pDst)[i] = floatToHalfReference(value);
+                    break;
+                default:
+                    ((float*)pDst)[i] = value;
+                }
+            }
+        }
+    }
+}
+
+static bool testDownsample(ResourceFormat format, MipFilter filter, uint32_t width, uint32_t height)
+{
+    TestLayout layout = getTestLayout(format);
+    RandomGenerator rng;
+    std::vector<uint8_t> src((size_t)width * height * layout.bytesPerPixel);
+    uint32_t valueCount = width * height * layout.channelCount;
+    for(uint32_t i = 0; i < valueCount; i++)
+    {
+        float value = (rng.next() >> 8) / (float)(1 << 24);
+        switch(layout.type)
+        {
+        case TestLayout::Type::Unorm8:
+            src[i] = (uint8_t)(value * 255);
+            break;
+        case TestLayout::Type::Float16:
+            ((uint16_t*)src.data())[i] = floatToHalfReference(value * 4 - 2);
+            break;
+        default:
+            ((float*)src.data())[i] = value * 4 - 2;
+        }
+    }
+
+    uint32_t dstWidth = std::max(width / 2, 1u);
+    uint32_t dstHeight = std::max(height / 2, 1u);
+    std::vector<uint8_t> expected((size_t)dstWidth * dstHeight * layout.bytesPerPixel);
+    std::vector<uint8_t> actual(expected.size());
+    downsampleReference(src.data(), width, height, format, filter, expected.data());
+    if(ImageProcessing::downsample(src.data(), width, height, format, filter, actual.data()) == false)
+    {
+        Logger::log(Logger::Level::Error, "testImageProcessing() - downsample() doesn't support format " + to_string(format));
+        return false;
+    }
+
+    std::string filterName = (filter == MipFilter::Box) ? "box" : "Kaiser";
+    uint32_t dstCount = dstWidth * dstHeight * layout.channelCount;
+    for(uint32_t i = 0; i < dstCount; i++)
+    {
+        bool match;
+        switch(layout.type)
+        {
+        case TestLayout::Type::Unorm8:
+            match = std::abs((int32_t)expected[i] - (int32_t)actual[i]) <= 1;
+            break;
+        case TestLayout::Type::Float16:
+            match = std::abs(halfToFloatReference(((uint16_t*)expected.data())[i]) - halfToFloatReference(((uint16_t*)actual.data())[i])) <= 2e-3f;
+            break;
+        default:
+            match = std::abs(((float*)expected.data())[i] - ((float*)actual.data())[i]) <= 1e-5f;
+        }
+
+        if(match == false)
+        {
+            Logger::log(Logger::Level::Error, "testImageProcessing() - " + filterName + " downsample() of a " + std::to_string(width) + "x" + std::to_string(height) + " " + to_string(format) + " image doesn't match the reference at value " + std::to_string(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Compares the vectorized and multi-threaded functions with scalar reference implementations.
+    The conversions are checked on every half value and on random float bit patterns, the texel functions on an odd texel count so that the scalar tails run too.
+*/
+bool testImageProcessing(RenderContext* pRenderContext)
+{
+    bool passed = true;
+
+    // Every half value
+    std::vector<uint16_t> halves(1 << 16);
+    for(uint32_t i = 0; i < halves.size(); i++)
+    {
+        halves[i] = (uint16_t)i;
+    }
+    std::vector<float> floats(halves.size());
+    ImageProcessing::convertHalfToFloat(halves.data(), floats.data(), halves.size());
+    for(uint32_t i = 0; i < halves.size(); i++)
+    {
+        // Single values take the scalar path
+        float single;
+        ImageProcessing::convertHalfToFloat(&halves[i], &single, 1);
+        float expected = halfToFloatReference(halves[i]);
+        // NaN payloads don't have to match
+        bool match = (expected != expected) ? (floats[i] != floats[i] && single != single) : (asUint(floats[i]) == asUint(expected) && asUint(single) == asUint(expected));
+        if(match == false)
+        {
+            Logger::log(Logger::Level::Error, "testImageProcessing() - convertHalfToFloat() mismatch for " + std::to_string(i));
+            passed = false;
+            break;
+        }
+    }
+
+    // Random bit patterns, including NaNs, denormals and values which overflow, and values halfway between two halves
+    RandomGenerator rng;
+    for(uint32_t i = 0; i < floats.size(); i++)
+    {
+        floats[i] = asFloat(rng.next());
+    }
+    const float kSpecialValues[] = {65504.0f, 65520.0f, 65519.99f, -0.0f, 5.96e-8f, 6.1035156e-5f, 1.0f + 1.0f / 2048, 1.0f + 3.0f / 2048, -3.0f * 5.9604645e-8f / 2};
+    for(uint32_t i = 0; i < arraysize(kSpecialValues); i++)
+    {
+        floats[i] = kSpecialValues[i];
+    }
+    ImageProcessing::convertFloatToHalf(floats.data(), halves.data(), floats.size());
+    for(uint32_t i = 0; i < floats.size(); i++)
+    {
+        uint16_t single;
+        ImageProcessing::convertFloatToHalf(&floats[i], &single, 1);
+        uint16_t expected = floatToHalfReference(floats[i]);
+        bool isNan = (expected & 0x7c00) == 0x7c00 && (expected & 0x3ff) != 0;
+        bool match = true;
+        for(uint16_t h : {halves[i], single})
+        {
+            match = match && (isNan ? ((h & 0xfc00) == (expected & 0xfc00) && (h & 0x3ff) != 0) : (h == expected));
+        }
+        if(match == false)
+        {
+            Logger::log(Logger::Level::Error, "testImageProcessing() - convertFloatToHalf() mismatch for value " + std::to_string(floats[i]));
+            passed = false;
+            break;
+        }
+    }
+
+    const size_t kTexelCount = 1031;
+    std::vector<uint8_t> rgb(kTexelCount * 4);
+    for(size_t i = 0; i < kTexelCount * 3; i++)
+    {
+        rgb[i] = (uint8_t)(rng.next() >> 24);
+    }
+    std::vector<uint8_t> expected(kTexelCount * 4);
+    for(size_t i = 0; i < kTexelCount; i++)
+    {
+        expected[i * 4 + 0] = rgb[i * 3 + 0];
+        expected[i * 4 + 1] = rgb[i * 3 + 1];
+        expected[i * 4 + 2] = rgb[i * 3 + 2];
+        expected[i * 4 + 3] = 0x80;
+    }
+    ImageProcessing::expandRgbToRgba(rgb.data(), rgb.data(), kTexelCount, 0x80);
+    if(rgb != expected)
+    {
+        Logger::log(Logger::Level::Error, "testImageProcessing() - in-place expandRgbToRgba() mismatch");
+        passed = false;
+    }
+
+    for(size_t i = 0; i < kTexelCount; i++)
+    {
+        std::swap(expected[i * 4], expected[i * 4 + 2]);
+    }
+    ImageProcessing::swapRedBlue(rgb.data(), kTexelCount);
+    if(rgb != expected)
+    {
+        Logger::log(Logger::Level::Error, "testImageProcessing() - swapRedBlue() mismatch");
+        passed = false;
+    }
+
+    // 1031 texels are 4124 bytes, which is 4 rows of 1031 bytes
+    ImageProcessing::flipVertically(rgb.data(), 1031, 4);
+    for(uint32_t y = 0; y < 4; y++)
+    {
+        if(memcmp(rgb.data() + y * 1031, expected.data() + (3 - y) * 1031, 1031) != 0)
+        {
+            Logger::log(Logger::Level::Error, "testImageProcessing() - flipVertically() mismatch");
+            passed = false;
+            break;
+        }
+    }
+
+    // Odd sizes, and one size with a single row
+    const ResourceFormat kFormats[] = {ResourceFormat::RGBA8UnormSrgb, ResourceFormat::BGRX8Unorm, ResourceFormat::R8Unorm, ResourceFormat::RG16Float, ResourceFormat::RGBA32Float, ResourceFormat::RGB32Float};
+    for(uint32_t f = 0; f < arraysize(kFormats); f++)
+    {
+        passed = testDownsample(kFormats[f], MipFilter::Box, 37, 23) && passed;
+        passed = testDownsample(kFormats[f], MipFilter::Kaiser, 37, 23) && passed;
+        passed = testDownsample(kFormats[f], MipFilter::Box, 64, 1) && passed;
+    }
+    return passed;
+}
+
+/** Measures the throughput of the functions on a random 2048x2048 RGBA8 image
+*/
+bool benchmarkImageProcessing(RenderContext* pRenderContext)
+{
+    const uint32_t kSize = 2048;
+    const size_t kTexelCount = (size_t)kSize * kSize;
+    std::vector<uint8_t> image(kTexelCount * 4);
+    RandomGenerator rng;
+    for(size_t i = 0; i < image.size(); i++)
+    {
+        image[i] = (uint8_t)(rng.next() >> 24);
+    }
+    std::vector<float> floats(kTexelCount * 2);
+    std::vector<uint16_t> halves(floats.size());
+
+    auto measure = [](const std::string& name, const std::string& unit, double amount, const std::function<void()>& func)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        func();
+        double durationInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        Logger::log(Logger::Level::Info, "benchmarkImageProcessing() - " + name + ": " + std::to_string(amount / (std::max(durationInMs, 1e-3) * 1000)) + " " + unit);
+    };
+
+    uint32_t mipCount;
+    measure("box mip-chain", "MTexels/s", (double)kTexelCount, [&]() { ImageProcessing::generateMipChain(image.data(), kSize, kSize, ResourceFormat::RGBA8UnormSrgb, MipFilter::Box, mipCount); });
+    measure("Kaiser mip-chain", "MTexels/s", (double)kTexelCount, [&]() { ImageProcessing::generateMipChain(image.data(), kSize, kSize, ResourceFormat::RGBA8UnormSrgb, MipFilter::Kaiser, mipCount); });
+    measure("RGB expansion", "MTexels/s", (double)kTexelCount, [&]() { ImageProcessing::expandRgbToRgba(image.data(), image.data(), kTexelCount); });
+    measure("red/blue swap", "MTexels/s", (double)kTexelCount, [&]() { ImageProcessing::swapRedBlue(image.data(), kTexelCount); });
+    measure("half to float", "MValues/s", (double)floats.size(), [&]() { ImageProcessing::convertHalfToFloat((const uint16_t*)image.data(), floats.data(), floats.size()); });
+    measure("float to half", "MValues/s", (double)floats.size(), [&]() { ImageProcessing::convertFloatToHalf(floats.data(), halves.data(), floats.size()); });
+    measure("vertical flip", "MB/s", (double)image.size(), [&]() { ImageProcessing::flipVertically(image.data(), kSize * 4, kSize); });
+    return true;
+}
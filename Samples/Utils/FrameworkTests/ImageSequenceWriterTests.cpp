@@ -0,0 +1,156 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/ImageSequenceWriter.h"
+#include <cstdio>
+#include <fstream>
+
+static void fillSyntheticFrame(std::vector<uint8_t>& frame, uint32_t frameIndex)
+{
+    for(size_t i = 0; i < frame.size(); i++)
+    {
+        frame[i] = (uint8_t)(i * 7 + frameIndex * 13);
+    }
+}
+
+/** Checks that the frames are written to the files named after their submission order, even with several workers and a short queue
+*/
+bool testImageSequenceWriter(RenderContext* pRenderContext)
+{
+    ImageSequenceWriter::Desc desc;
+    desc.prefix = "FrameworkTests_";
+    desc.firstFrameIndex = 5;
+    desc.format = ImageSequenceWriter::FileFormat::Raw;
+    desc.width = 16;
+    desc.height = 16;
+    desc.threadCount = 4;
+    desc.queueSize = 2;
+    ImageSequenceWriter::UniquePtr pWriter = ImageSequenceWriter::create(desc);
+    if(pWriter == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "testImageSequenceWriter() - can't create the writer");
+        return false;
+    }
+
+    // Every fourth frame is dropped. Dropped frames must not use a frame index.
+    const uint32_t kFrameCount = 64;
+    std::vector<uint8_t> frame(pWriter->getFrameSize());
+    std::vector<uint32_t> indices;
+    bool passed = true;
+    for(uint32_t i = 0; i < kFrameCount; i++)
+    {
+        if((i % 4) == 3)
+        {
+            pWriter->dropFrame(pWriter->acquireFrame());
+            continue;
+        }
+        fillSyntheticFrame(frame, (uint32_t)indices.size());
+        uint32_t frameIndex = pWriter->appendFrame(frame.data());
+        if(frameIndex != desc.firstFrameIndex + indices.size())
+        {
+            Logger::log(Logger::Level::Error, "testImageSequenceWriter() - frame " + std::to_string(indices.size()) + " got the index " + std::to_string(frameIndex));
+            passed = false;
+        }
+        indices.push_back(frameIndex);
+    }
+    pWriter->flush();
+
+    ImageSequenceWriter::Stats stats = pWriter->getStats();
+    if(stats.submittedFrames != kFrameCount || stats.writtenFrames != indices.size() || stats.failedFrames != kFrameCount - indices.size() || stats.queueDepth != 0)
+    {
+        Logger::log(Logger::Level::Error, "testImageSequenceWriter() - the statistics are wrong. " + std::to_string(stats.submittedFrames) + " submitted, " + std::to_string(stats.writtenFrames) + " written, " +
+            std::to_string(stats.failedFrames) + " failed, " + std::to_string(stats.queueDepth) + " queued.");
+        passed = false;
+    }
+
+    // Each file must hold the frame which got its index
+    std::vector<uint8_t> data(frame.size());
+    for(uint32_t i = 0; i < indices.size(); i++)
+    {
+        std::string filename = pWriter->getFilename(indices[i]);
+        std::ifstream file(filename, std::ios::binary);
+        file.read((char*)data.data(), data.size());
+        fillSyntheticFrame(frame, i);
+        if(file.gcount() != (std::streamsize)data.size() || data != frame)
+        {
+            Logger::log(Logger::Level::Error, "testImageSequenceWriter() - " + filename + " doesn't hold frame " + std::to_string(i));
+            passed = false;
+        }
+        file.close();
+        std::remove(filename.c_str());
+    }
+    return passed;
+}
+
+/** Compares the writer's throughput with calling Bitmap#saveImage() on the calling thread, using synthetic 1280x720 PNG frames
+*/
+bool benchmarkImageSequenceWriter(RenderContext* pRenderContext)
+{
+    const uint32_t frameCount = 60;
+    ImageSequenceWriter::Desc desc;
+    desc.prefix = "FrameworkTests_async_";
+    desc.width = 1280;
+    desc.height = 720;
+    ImageSequenceWriter::UniquePtr pWriter = ImageSequenceWriter::create(desc);
+    if(pWriter == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkImageSequenceWriter() - can't create the writer");
+        return false;
+    }
+
+    // A gradient with some noise compresses like a typical rendered image, unlike a constant color
+    std::vector<uint8_t> frame(pWriter->getFrameSize());
+    RandomGenerator rng;
+    for(size_t i = 0; i < frame.size(); i++)
+    {
+        frame[i] = (uint8_t)((i / desc.bytesPerPixel) % desc.width + (rng.next() >> 29));
+    }
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < frameCount; i++)
+    {
+        std::string filename = getExecutableDirectory() + "/FrameworkTests_sync_" + std::to_string(i) + ".png";
+        Bitmap::saveImage(filename, desc.width, desc.height, Bitmap::FileFormat::PngFile, desc.bytesPerPixel, desc.isTopDown, frame.data());
+    }
+    double syncTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    // Includes the final flush
+    start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < frameCount; i++)
+    {
+        pWriter->appendFrame(frame.data());
+    }
+    pWriter->flush();
+    double asyncTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    double syncFps = frameCount * 1000.0 / std::max(syncTime, 1e-3);
+    double asyncFps = frameCount * 1000.0 / std::max(asyncTime, 1e-3);
+    Logger::log(Logger::Level::Info, "benchmarkImageSequenceWriter() - " + std::to_string(frameCount) + " PNG frames at " + std::to_string(desc.width) + "x" + std::to_string(desc.height) +
+        ": " + std::to_string(syncFps) + " fps on the calling thread, " + std::to_string(asyncFps) + " fps through the writer with " + std::to_string(std::thread::hardware_concurrency()) + " cores");
+    return true;
+}
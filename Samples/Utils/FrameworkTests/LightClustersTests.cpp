@@ -0,0 +1,330 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include <algorithm>
+#include <cfloat>
+
+/** Point lights in a box around the camera, so that some are behind it, some cross the near or far planes, and some cover the whole screen
+*/
+static std::vector<Light::SharedPtr> createTestLights(uint32_t count, float extent, RandomGenerator& rng)
+{
+    std::vector<Light::SharedPtr> lights;
+    for(uint32_t i = 0; i < count; i++)
+    {
+        PointLight::SharedPtr pLight = PointLight::create();
+        pLight->setWorldPosition(glm::vec3(rng.nextFloat(-extent, extent), rng.nextFloat(-extent, extent), rng.nextFloat(-extent, extent)));
+        float intensity = (i % 50 == 0) ? rng.nextFloat(1, 100) : rng.nextFloat(0.001f, 0.1f);
+        pLight->setIntensity(glm::vec3(intensity, rng.nextFloat(0, intensity), 0));
+        lights.push_back(pLight);
+    }
+    lights.push_back(DirectionalLight::create());
+    return lights;
+}
+
+static Camera::SharedPtr createTestCamera(float aspectRatio, float nearZ, float farZ, RandomGenerator& rng)
+{
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setAspectRatio(aspectRatio);
+    pCamera->setDepthRange(nearZ, farZ);
+    pCamera->setPosition(glm::vec3(rng.nextFloat(-1, 1), rng.nextFloat(-1, 1), rng.nextFloat(-1, 1)));
+    pCamera->setTarget(glm::vec3(rng.nextFloat(-10, 10), rng.nextFloat(-10, 10), rng.nextFloat(-10, 10)));
+    pCamera->setUpVector(glm::vec3(0, 1, 0));
+    return pCamera;
+}
+
+/** A cluster's view-space volume, computed independently of LightClusters
+*/
+struct ClusterVolume
+{
+    glm::dvec3 aabbMin;
+    glm::dvec3 aabbMax;
+    glm::dvec4 planes[6];   ///< Pointing outwards. A point p is outside a plane if dot(plane.xyz, p) + plane.w > 0.
+};
+
+/** Find the view-space point with a given depth on the ray through an NDC position.
+    Doubles keep the extrapolation from the two unprojected points accurate, even for a large far/near ratio.
+*/
+static glm::dvec3 unprojectToDepth(const glm::dmat4& invProj, double ndcX, double ndcY, double depth)
+{
+    // Any two NDC depths define the ray. Both the GL and the D3D depth ranges contain 0 and 0.5.
+    glm::dvec4 a = invProj * glm::dvec4(ndcX, ndcY, 0.0, 1.0);
+    glm::dvec4 b = invProj * glm::dvec4(ndcX, ndcY, 0.5, 1.0);
+    glm::dvec3 pa = glm::dvec3(a) / a.w;
+    glm::dvec3 pb = glm::dvec3(b) / b.w;
+    // The camera looks down -Z
+    double t = (-depth - pa.z) / (pb.z - pa.z);
+    return pa + (pb - pa) * t;
+}
+
+static glm::dvec4 createPlane(const glm::dvec3& p0, const glm::dvec3& p1, const glm::dvec3& p2, const glm::dvec3& inside)
+{
+    glm::dvec3 n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+    glm::dvec4 plane(n, -glm::dot(n, p0));
+    if(glm::dot(n, inside) + plane.w > 0)
+    {
+        plane = -plane;
+    }
+    return plane;
+}
+
+/** Computes the corners of every cluster by unprojecting the tile corners at the slice depths. The slices split [near, far] exponentially.
+*/
+static std::vector<ClusterVolume> computeClusterVolumes(const Camera* pCamera, uint32_t tileCountX, uint32_t tileCountY, uint32_t sliceCount)
+{
+    const glm::dmat4 invProj = glm::inverse(glm::dmat4(pCamera->getProjMatrix()));
+    const double nearZ = pCamera->getNearPlane();
+    const double farZ = pCamera->getFarPlane();
+    std::vector<ClusterVolume> volumes(tileCountX * tileCountY * sliceCount);
+    for(uint32_t slice = 0; slice < sliceCount; slice++)
+    {
+        const double depth[2] = {nearZ * pow(farZ / nearZ, double(slice) / sliceCount), nearZ * pow(farZ / nearZ, double(slice + 1) / sliceCount)};
+        for(uint32_t y = 0; y < tileCountY; y++)
+        {
+            for(uint32_t x = 0; x < tileCountX; x++)
+            {
+                const double ndcX[2] = {-1.0 + 2.0 * x / tileCountX, -1.0 + 2.0 * (x + 1) / tileCountX};
+                const double ndcY[2] = {-1.0 + 2.0 * y / tileCountY, -1.0 + 2.0 * (y + 1) / tileCountY};
+
+                // corner[i] has X index bit 0, Y index bit 1 and depth index bit 2
+                glm::dvec3 corner[8];
+                glm::dvec3 center(0);
+                for(uint32_t i = 0; i < 8; i++)
+                {
+                    corner[i] = unprojectToDepth(invProj, ndcX[i & 1], ndcY[(i >> 1) & 1], depth[i >> 2]);
+                    center += corner[i] / 8.0;
+                }
+
+                ClusterVolume& volume = volumes[(slice * tileCountY + y) * tileCountX + x];
+                volume.aabbMin = corner[0];
+                volume.aabbMax = corner[0];
+                for(const glm::dvec3& c : corner)
+                {
+                    volume.aabbMin = glm::min(volume.aabbMin, c);
+                    volume.aabbMax = glm::max(volume.aabbMax, c);
+                }
+
+                volume.planes[0] = createPlane(corner[0], corner[2], corner[4], center);    // Left
+                volume.planes[1] = createPlane(corner[1], corner[3], corner[5], center);    // Right
+                volume.planes[2] = createPlane(corner[0], corner[1], corner[4], center);    // Bottom
+                volume.planes[3] = createPlane(corner[2], corner[3], corner[6], center);    // Top
+                volume.planes[4] = createPlane(corner[0], corner[1], corner[2], center);    // Near
+                volume.planes[5] = createPlane(corner[4], corner[5], corner[6], center);    // Far
+            }
+        }
+    }
+    return volumes;
+}
+
+struct ReferenceResult
+{
+    std::vector<std::vector<uint32_t>> required;    ///< Lights whose sphere clearly overlaps the cluster's AABB and isn't outside any of its planes
+    std::vector<std::vector<uint32_t>> allowed;     ///< Lights whose sphere touches the cluster's AABB, within the tolerance
+};
+
+/** Brute-force reference. Tests every light's bounding sphere against every cluster's AABB, on a single thread.
+    build() also culls with the cluster's side and depth planes, which are tighter than the AABB. So a light which overlaps the AABB but is entirely outside one of the planes may be missing from build()'s list. Lights within a small tolerance of either test may go either way.
+    Only point and directional lights are supported. Directional lights are never clustered.
+*/
+static ReferenceResult buildReference(const Camera* pCamera, const std::vector<Light::SharedPtr>& lights, uint32_t tileCountX, uint32_t tileCountY, uint32_t sliceCount, float intensityThreshold)
+{
+    std::vector<ClusterVolume> volumes = computeClusterVolumes(pCamera, tileCountX, tileCountY, sliceCount);
+    const glm::dmat4 viewMat(pCamera->getViewMatrix());
+
+    ReferenceResult result;
+    result.required.resize(volumes.size());
+    result.allowed.resize(volumes.size());
+    for(uint32_t lightIndex = 0; lightIndex < (uint32_t)lights.size(); lightIndex++)
+    {
+        const LightData& data = lights[lightIndex]->getData();
+        if(lights[lightIndex]->getType() != LightPoint)
+        {
+            continue;
+        }
+
+        // The sphere outside of which the inverse-square irradiance drops below the threshold
+        const double maxIntensity = std::max(data.intensity.x, std::max(data.intensity.y, data.intensity.z));
+        const double radius = sqrt(maxIntensity / intensityThreshold);
+        const glm::dvec3 center = glm::dvec3(viewMat * glm::dvec4(glm::dvec3(data.worldPos), 1.0));
+        // build() works in single precision
+        const double tolerance = 1e-4 * (1.0 + glm::length(center) + radius);
+
+        for(uint32_t cluster = 0; cluster < (uint32_t)volumes.size(); cluster++)
+        {
+            const ClusterVolume& volume = volumes[cluster];
+            const glm::dvec3 closest = glm::clamp(center, volume.aabbMin, volume.aabbMax);
+            const double aabbDistance = glm::length(center - closest);
+            if(aabbDistance > radius + tolerance)
+            {
+                continue;
+            }
+            result.allowed[cluster].push_back(lightIndex);
+
+            double maxPlaneDistance = -DBL_MAX;
+            for(const glm::dvec4& plane : volume.planes)
+            {
+                maxPlaneDistance = std::max(maxPlaneDistance, glm::dot(glm::dvec3(plane), center) + plane.w);
+            }
+            if(aabbDistance < radius - tolerance && maxPlaneDistance < radius - tolerance)
+            {
+                result.required[cluster].push_back(lightIndex);
+            }
+        }
+    }
+    return result;
+}
+
+static bool contains(const std::vector<uint32_t>& sortedList, uint32_t value)
+{
+    return std::binary_search(sortedList.begin(), sortedList.end(), value);
+}
+
+/** Checks the lists built by LightClusters::build() against buildReference(), and checks that they are compact and sorted
+*/
+static bool checkClusters(const LightClusters* pClusters, const ReferenceResult& reference, const std::string& name, uint32_t& requiredCount)
+{
+    const auto& clusters = pClusters->getClusters();
+    const auto& lightIndices = pClusters->getLightIndices();
+    uint32_t offset = 0;
+    for(uint32_t cluster = 0; cluster < pClusters->getClusterCount(); cluster++)
+    {
+        if(clusters[cluster].x != offset || offset + clusters[cluster].y > lightIndices.size())
+        {
+            Logger::log(Logger::Level::Error, "testLightClusters() - " + name + ": the lists aren't compact at cluster " + std::to_string(cluster));
+            return false;
+        }
+        std::vector<uint32_t> list(lightIndices.begin() + offset, lightIndices.begin() + offset + clusters[cluster].y);
+        offset += clusters[cluster].y;
+
+        if(std::adjacent_find(list.begin(), list.end(), std::greater_equal<uint32_t>()) != list.end())
+        {
+            Logger::log(Logger::Level::Error, "testLightClusters() - " + name + ": the list of cluster " + std::to_string(cluster) + " isn't sorted or has duplicates");
+            return false;
+        }
+        for(uint32_t lightIndex : reference.required[cluster])
+        {
+            if(contains(list, lightIndex) == false)
+            {
+                Logger::log(Logger::Level::Error, "testLightClusters() - " + name + ": cluster " + std::to_string(cluster) + " is missing light " + std::to_string(lightIndex) + ", which overlaps it");
+                return false;
+            }
+        }
+        for(uint32_t lightIndex : list)
+        {
+            if(contains(reference.allowed[cluster], lightIndex) == false)
+            {
+                Logger::log(Logger::Level::Error, "testLightClusters() - " + name + ": cluster " + std::to_string(cluster) + " has light " + std::to_string(lightIndex) + ", which doesn't overlap its bounding box");
+                return false;
+            }
+        }
+        requiredCount += (uint32_t)reference.required[cluster].size();
+    }
+
+    if(offset != lightIndices.size())
+    {
+        Logger::log(Logger::Level::Error, "testLightClusters() - " + name + ": the light index list has unused entries");
+        return false;
+    }
+    return true;
+}
+
+/** Checks LightClusters::build() against a brute-force reference for random point and directional lights, with several cameras
+*/
+bool testLightClusters(RenderContext* pRenderContext)
+{
+    RandomGenerator rng;
+    struct Config
+    {
+        uint32_t tileCountX, tileCountY, sliceCount;
+        float aspectRatio, nearZ, farZ;
+    };
+    // Including tile counts which aren't multiples of the SIMD width
+    const Config configs[] =
+    {
+        {16, 8, 24, 16.0f / 9.0f, 0.1f, 100.0f},
+        {13, 7, 5, 1.0f, 0.5f, 20.0f},
+        {1, 1, 1, 0.5f, 0.01f, 1000.0f},
+        {32, 18, 32, 2.0f, 1.0f, 30.0f},
+    };
+
+    bool success = true;
+    for(uint32_t c = 0; c < arraysize(configs); c++)
+    {
+        const Config& config = configs[c];
+        LightClusters::UniquePtr pClusters = LightClusters::create(config.tileCountX, config.tileCountY, config.sliceCount);
+        std::vector<Light::SharedPtr> lights = createTestLights(1000, 30, rng);
+        uint32_t requiredCount = 0;
+        for(uint32_t frame = 0; frame < 3; frame++)
+        {
+            Camera::SharedPtr pCamera = createTestCamera(config.aspectRatio, config.nearZ, config.farZ, rng);
+            pClusters->build(pCamera.get(), lights);
+            ReferenceResult reference = buildReference(pCamera.get(), lights, config.tileCountX, config.tileCountY, config.sliceCount, pClusters->getIntensityThreshold());
+            success = checkClusters(pClusters.get(), reference, "configuration " + std::to_string(c) + ", frame " + std::to_string(frame), requiredCount) && success;
+        }
+        if(requiredCount == 0)
+        {
+            Logger::log(Logger::Level::Error, "testLightClusters() - no lights were clustered for configuration " + std::to_string(c) + ", the test doesn't cover anything");
+            success = false;
+        }
+    }
+    return success;
+}
+
+/** Measures the build time for random point lights around a moving camera, and compares it with the brute-force reference
+*/
+bool benchmarkLightClusters(RenderContext* pRenderContext)
+{
+    const uint32_t lightCount = 10000;
+    const uint32_t frameCount = 20;
+    RandomGenerator rng;
+    LightClusters::UniquePtr pClusters = LightClusters::create();
+    std::vector<Light::SharedPtr> lights = createTestLights(lightCount, 50, rng);
+    std::vector<Camera::SharedPtr> cameras;
+    for(uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        cameras.push_back(createTestCamera(16.0f / 9.0f, 0.1f, 100.0f, rng));
+    }
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(const auto& pCamera : cameras)
+    {
+        pClusters->build(pCamera.get(), lights);
+    }
+    double buildInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / frameCount;
+    double averageLightsPerCluster = double(pClusters->getLightIndices().size()) / pClusters->getClusterCount();
+
+    const LightClusterData& data = pClusters->getData();
+    start = CpuTimer::getCurrentTimePoint();
+    buildReference(cameras.back().get(), lights, data.tileCountX, data.tileCountY, data.sliceCount, pClusters->getIntensityThreshold());
+    double referenceInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    Logger::log(Logger::Level::Info, "benchmarkLightClusters() - " + std::to_string(lightCount) + " lights, " + std::to_string(pClusters->getClusterCount()) + " clusters" +
+        ": build " + std::to_string(buildInMs) + " ms on " + std::to_string(getParallelThreadCount()) + " threads" +
+        ", brute-force reference " + std::to_string(referenceInMs) + " ms" +
+        ", " + std::to_string(averageLightsPerCluster) + " lights per cluster");
+    return true;
+}
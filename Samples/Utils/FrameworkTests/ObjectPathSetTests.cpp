@@ -0,0 +1,324 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/Paths/ObjectPathSet.h"
+
+static glm::vec3 nextVector(RandomGenerator& rng)
+{
+    return glm::vec3(rng.nextFloat(-10, 10), rng.nextFloat(-10, 10), rng.nextFloat(-10, 10));
+}
+
+static ObjectPath::SharedPtr createTestPath(uint32_t keyFrameCount, ObjectPath::Interpolation mode, bool repeat, RandomGenerator& rng)
+{
+    ObjectPath::SharedPtr pPath = ObjectPath::create();
+    pPath->setInterpolationMode(mode);
+    pPath->setAnimationRepeat(repeat);
+    float time = rng.nextFloat(0, 2);
+    for(uint32_t i = 0; i < keyFrameCount; i++)
+    {
+        pPath->addKeyFrame(time, nextVector(rng), nextVector(rng), nextVector(rng));
+        time += rng.nextFloat(0.1f, 2);
+    }
+    return pPath;
+}
+
+static ObjectPath::SharedPtr clonePath(const ObjectPath::SharedPtr& pPath)
+{
+    ObjectPath::SharedPtr pClone = ObjectPath::create();
+    pClone->setInterpolationMode(pPath->getInterpolationMode());
+    pClone->setAnimationRepeat(pPath->isRepeatOn());
+    for(uint32_t i = 0; i < pPath->getKeyFrameCount(); i++)
+    {
+        const auto& frame = pPath->getKeyFrame(i);
+        pClone->addKeyFrame(frame.time, frame.position, frame.target, frame.up);
+    }
+    return pClone;
+}
+
+static ObjectPath::Frame getCurrentFrame(const ObjectPath::SharedPtr& pPath)
+{
+    ObjectPath::Frame frame;
+    frame.position = pPath->getCurrentPosition();
+    frame.target = pPath->getCurrentLookAtVector();
+    frame.up = pPath->getCurrentUpVector();
+    return frame;
+}
+
+/** Evaluate a path the way ObjectPath did before it kept packed sections: a linear search for the key frames, and splines built from scratch
+*/
+static ObjectPath::Frame evaluateReference(const ObjectPath::SharedPtr& pPath, double currentTime)
+{
+    const uint32_t keyCount = pPath->getKeyFrameCount();
+    const auto& firstFrame = pPath->getKeyFrame(0);
+    const auto& lastFrame = pPath->getKeyFrame(keyCount - 1);
+    double animTime = currentTime;
+    if(pPath->isRepeatOn())
+    {
+        float delta = lastFrame.time - firstFrame.time;
+        if(delta)
+        {
+            animTime = float(fmod(currentTime, delta));
+            animTime += firstFrame.time;
+        }
+        else
+            animTime = lastFrame.time;
+    }
+
+    if(animTime >= lastFrame.time)
+    {
+        return lastFrame;
+    }
+    else if(animTime <= firstFrame.time)
+    {
+        return firstFrame;
+    }
+
+    ObjectPath::Frame result;
+    for(uint32_t i = 0; i < keyCount - 1; i++)
+    {
+        const auto& current = pPath->getKeyFrame(i);
+        const auto& next = pPath->getKeyFrame(i + 1);
+        if(animTime >= current.time && animTime < next.time)
+        {
+            float factor = float((animTime - current.time) / (next.time - current.time));
+            if(pPath->getInterpolationMode() == ObjectPath::Interpolation::Linear)
+            {
+                result.position = glm::mix(current.position, next.position, factor);
+                result.target = glm::mix(current.target, next.target, factor);
+                result.up = glm::mix(current.up, next.up, factor);
+            }
+            else
+            {
+                std::vector<glm::vec3> positions, targets, ups;
+                for(uint32_t k = 0; k < keyCount; k++)
+                {
+                    positions.push_back(pPath->getKeyFrame(k).position);
+                    targets.push_back(pPath->getKeyFrame(k).target);
+                    ups.push_back(pPath->getKeyFrame(k).up);
+                }
+                result.position = Vec3CubicSpline(positions.data(), keyCount).interpolate(i, factor);
+                result.target = Vec3CubicSpline(targets.data(), keyCount).interpolate(i, factor);
+                result.up = Vec3CubicSpline(ups.data(), keyCount).interpolate(i, factor);
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+static bool checkFrame(const std::string& msg, const ObjectPath::SharedPtr& pPath, const ObjectPath::Frame& expected)
+{
+    const glm::vec3 actual[] = {pPath->getCurrentPosition(), pPath->getCurrentLookAtVector(), pPath->getCurrentUpVector()};
+    const glm::vec3 reference[] = {expected.position, expected.target, expected.up};
+    for(uint32_t v = 0; v < arraysize(actual); v++)
+    {
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            float e = reference[v][c];
+            float a = actual[v][c];
+            if(std::abs(a - e) > 1e-4f * std::max(1.f, std::abs(e)))
+            {
+                Logger::log(Logger::Level::Error, "testObjectPathSet() - " + msg + " mismatch at component " + std::to_string(v * 3 + c) + ": " + std::to_string(a) + ", expected " + std::to_string(e));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** Checks ObjectPathSet::evaluate() against ObjectPath::animate() and a reference, and incrementally updated paths against paths built from scratch
+*/
+bool testObjectPathSet(RenderContext* pRenderContext)
+{
+    bool success = true;
+    RandomGenerator rng;
+    const uint32_t pathCount = 103;     // Not a multiple of the SIMD width
+
+    // Paths of all the modes, including single key frames and empty paths
+    ObjectPathSet::SharedPtr pSet = ObjectPathSet::create();
+    std::vector<ObjectPath::SharedPtr> pScalarPaths;
+    for(uint32_t i = 0; i < pathCount; i++)
+    {
+        auto mode = (i % 2) ? ObjectPath::Interpolation::Linear : ObjectPath::Interpolation::CubicSpline;
+        auto pPath = createTestPath(i % 9, mode, (i % 3) == 0, rng);
+        pSet->addPath(pPath);
+        pScalarPaths.push_back(clonePath(pPath));
+    }
+
+    const double times[] = {-1, 0, 0.5, 1.25, 3, 2.5, 7.75, 12, 30, 100.5};
+    for(double time : times)
+    {
+        pSet->evaluate(time);
+        for(uint32_t i = 0; i < pathCount && success; i++)
+        {
+            const auto& pPath = pSet->getPath(i);
+            if(pPath->getKeyFrameCount() == 0)
+            {
+                continue;
+            }
+            std::string msg = "path " + std::to_string(i) + " at time " + std::to_string(time);
+            pScalarPaths[i]->animate(time);
+            success = checkFrame("evaluate() against animate() for " + msg, pPath, getCurrentFrame(pScalarPaths[i])) && success;
+            success = checkFrame("evaluate() against the reference for " + msg, pPath, evaluateReference(pPath, time)) && success;
+        }
+    }
+
+    // Key frame edits, applied to paths with up-to-date sections
+    for(uint32_t edit = 0; edit < 500; edit++)
+    {
+        const auto& pPath = pSet->getPath(rng.next() % pathCount);
+        uint32_t keyCount = pPath->getKeyFrameCount();
+        if(keyCount == 0)
+        {
+            continue;
+        }
+        uint32_t frameID = rng.next() % keyCount;
+        switch(rng.next() % 4)
+        {
+        case 0:
+            pPath->setFramePosition(frameID, nextVector(rng));
+            break;
+        case 1:
+            pPath->setFrameTarget(frameID, nextVector(rng));
+            break;
+        case 2:
+            pPath->setFrameUp(frameID, nextVector(rng));
+            break;
+        case 3:
+            // Mostly small moves that keep the key frame order
+            pPath->setFrameTime(frameID, pPath->getKeyFrame(frameID).time + rng.nextFloat(-0.3f, 0.3f));
+            break;
+        }
+
+        if((edit % 10) == 0)
+        {
+            double time = rng.nextFloat(0, 20);
+            pSet->evaluate(time);
+            for(uint32_t i = 0; i < pathCount && success; i++)
+            {
+                const auto& pEdited = pSet->getPath(i);
+                if(pEdited->getKeyFrameCount())
+                {
+                    ObjectPath::SharedPtr pRebuilt = clonePath(pEdited);
+                    pRebuilt->animate(time);
+                    std::string msg = "path " + std::to_string(i) + " after " + std::to_string(edit + 1) + " edits";
+                    success = checkFrame("the incremental update against a rebuild for " + msg, pEdited, getCurrentFrame(pRebuilt)) && success;
+                    success = checkFrame("the incremental update against the reference for " + msg, pEdited, evaluateReference(pEdited, time)) && success;
+                }
+            }
+        }
+    }
+    return success;
+}
+
+/** Measures the playback throughput and the key frame edit cost on random cubic spline paths
+*/
+bool benchmarkObjectPathSet(RenderContext* pRenderContext)
+{
+    const uint32_t kPathCount = 100000;
+    const uint32_t kKeyFrameCount = 16;
+    const uint32_t kFrameCount = 100;
+    // evaluate() splits sets into ranges of 256 paths, so a set of that size stays on the calling thread
+    const uint32_t kSingleThreadSetSize = 256;
+    RandomGenerator rng;
+
+    ObjectPathSet::SharedPtr pSet = ObjectPathSet::create();
+    std::vector<ObjectPathSet::SharedPtr> pSingleThreadSets;
+    for(uint32_t i = 0; i < kPathCount; i++)
+    {
+        ObjectPath::SharedPtr pPath = createTestPath(kKeyFrameCount, ObjectPath::Interpolation::CubicSpline, true, rng);
+        pSet->addPath(pPath);
+        if((i % kSingleThreadSetSize) == 0)
+        {
+            pSingleThreadSets.push_back(ObjectPathSet::create());
+        }
+        pSingleThreadSets.back()->addPath(pPath);
+    }
+    pSet->evaluate(0);
+
+    auto measure = [&](const std::function<void()>& func)
+    {
+        auto start = CpuTimer::getCurrentTimePoint();
+        func();
+        return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    };
+    auto logThroughput = [&](const std::string& name, double durationInMs)
+    {
+        Logger::log(Logger::Level::Info, "benchmarkObjectPathSet() - " + name + ": " + std::to_string(double(kPathCount) * kFrameCount / (std::max(durationInMs, 1e-3) * 1000)) + " MPaths/s");
+    };
+
+    // Playback at 60 frames per second
+    logThroughput("ObjectPath::animate()", measure([&]()
+    {
+        for(uint32_t frame = 0; frame < kFrameCount; frame++)
+        {
+            for(uint32_t i = 0; i < kPathCount; i++)
+            {
+                pSet->getPath(i)->animate(frame / 60.0);
+            }
+        }
+    }));
+    logThroughput("SIMD on 1 thread", measure([&]()
+    {
+        for(uint32_t frame = 0; frame < kFrameCount; frame++)
+        {
+            for(auto& pSingleThreadSet : pSingleThreadSets)
+            {
+                pSingleThreadSet->evaluate(frame / 60.0);
+            }
+        }
+    }));
+    logThroughput("SIMD on " + std::to_string(getParallelThreadCount()) + " threads", measure([&]()
+    {
+        for(uint32_t frame = 0; frame < kFrameCount; frame++)
+        {
+            pSet->evaluate(frame / 60.0);
+        }
+    }));
+
+    // A key frame in the middle of every path, which is the most expensive to update
+    double editInMs = measure([&]()
+    {
+        for(uint32_t i = 0; i < kPathCount; i++)
+        {
+            pSet->getPath(i)->setFramePosition(kKeyFrameCount / 2, nextVector(rng));
+        }
+    });
+    // Changing the interpolation mode rebuilds all the sections on the next evaluation
+    double rebuildInMs = measure([&]()
+    {
+        for(uint32_t i = 0; i < kPathCount; i++)
+        {
+            const auto& pPath = pSet->getPath(i);
+            pPath->setInterpolationMode(ObjectPath::Interpolation::CubicSpline);
+            pPath->animate(0);
+        }
+    });
+    Logger::log(Logger::Level::Info, "benchmarkObjectPathSet() - key frame edit " + std::to_string(editInMs * 1000 / kPathCount) + " us, rebuild " + std::to_string(rebuildInMs * 1000 / kPathCount) + " us per path");
+    return true;
+}
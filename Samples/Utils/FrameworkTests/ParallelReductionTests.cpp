@@ -0,0 +1,159 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/Math/ParallelReduction.h"
+#include <cmath>
+
+static float nextFloat(RandomGenerator& rng)
+{
+    return (float)(rng.next() >> 8) / (float)(1 << 24);
+}
+
+static bool compareResults(const std::vector<glm::vec4>& results, const std::vector<glm::vec4>& reference, float tolerance, const std::string& name)
+{
+    if(results.size() != reference.size())
+    {
+        Logger::log(Logger::Level::Error, "testParallelReduction() - " + name + " returned " + std::to_string(results.size()) + " results, expected " + std::to_string(reference.size()));
+        return false;
+    }
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            // Relative for large values, absolute around 0
+            float expected = reference[i][c];
+            if(std::abs(results[i][c] - expected) > tolerance * std::max(1.0f, std::abs(expected)))
+            {
+                Logger::log(Logger::Level::Error, "testParallelReduction() - " + name + " mismatch in result " + std::to_string(i) + " component " + std::to_string(c) + ". Expected " + std::to_string(expected) + ", got " + std::to_string(results[i][c]));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/** Runs every reduction type on the GPU and compares the results with ParallelReduction::reduceCpu().
+    The inputs include sizes which aren't multiples of the tile size, and the histograms use 4 and 32 bins, so both the single render-target and the 8 render-target passes are covered.
+*/
+bool testParallelReduction(RenderContext* pRenderContext)
+{
+    struct TestCase
+    {
+        ParallelReduction::Type type;
+        uint32_t binCount;
+        float tolerance;    ///< The GPU sums in single precision, with a different order than the CPU
+        const char* name;
+    };
+    const TestCase kTests[] =
+    {
+        {ParallelReduction::Type::MinMax, 16, 0, "MinMax"},
+        {ParallelReduction::Type::ChannelMinMax, 16, 0, "ChannelMinMax"},
+        {ParallelReduction::Type::Sum, 16, 1e-4f, "Sum"},
+        {ParallelReduction::Type::Average, 16, 1e-4f, "Average"},
+        {ParallelReduction::Type::LogAverageLuminance, 16, 1e-4f, "LogAverageLuminance"},
+        {ParallelReduction::Type::Histogram, 4, 0, "Histogram with 4 bins"},
+        {ParallelReduction::Type::Histogram, 32, 0, "Histogram with 32 bins"},
+    };
+
+    // A single tile, sizes which leave partial tiles at the edges, and a size which takes three passes
+    const glm::uvec2 kSizes[] = {{16, 16}, {33, 7}, {300, 170}, {1, 1}};
+    const glm::vec2 histogramRange(0.1f, 0.9f);
+
+    bool passed = true;
+    RandomGenerator rng;
+    for(const auto& size : kSizes)
+    {
+        for(const auto& test : kTests)
+        {
+            std::vector<float> texels((size_t)size.x * size.y * 4);
+            for(size_t i = 0; i < texels.size(); i++)
+            {
+                texels[i] = nextFloat(rng);
+            }
+
+            if(test.type == ParallelReduction::Type::MinMax)
+            {
+                // Some far-plane depths, which are skipped
+                for(size_t i = 0; i < texels.size(); i += 4)
+                {
+                    texels[i] = (rng.next() >> 30) == 0 ? 1.0f : texels[i];
+                }
+            }
+            else if(test.type == ParallelReduction::Type::Histogram)
+            {
+                // Keep the values away from the bin edges, where the GPU might round differently. Some values are out of range.
+                for(size_t i = 0; i < texels.size(); i += 4)
+                {
+                    int32_t bin = (int32_t)(rng.next() % (test.binCount + 4)) - 2;
+                    float offset = 0.1f + 0.8f * texels[i];
+                    texels[i] = histogramRange.x + (histogramRange.y - histogramRange.x) * (bin + offset) / test.binCount;
+                }
+            }
+
+            std::string name = std::string(test.name) + " of " + std::to_string(size.x) + "x" + std::to_string(size.y);
+            Texture::SharedPtr pTexture = Texture::create2D(size.x, size.y, ResourceFormat::RGBA32Float, 1, 1, texels.data());
+            ParallelReduction::UniquePtr pReduction = ParallelReduction::create(test.type, 0, size.x, size.y, test.binCount);
+            pReduction->setHistogramRange(histogramRange.x, histogramRange.y);
+            pReduction->reduce(pRenderContext, pTexture.get());
+
+            std::vector<glm::vec4> reference;
+            ParallelReduction::reduceCpu(test.type, texels.data(), size.x, size.y, reference, test.binCount, histogramRange);
+            passed = compareResults(pReduction->getResults(), reference, test.tolerance, name) && passed;
+        }
+    }
+
+    // With a latency of 1, each call returns the results of the previous input
+    {
+        const glm::uvec2 size(40, 24);
+        std::vector<float> texels[2];
+        Texture::SharedPtr pTextures[2];
+        for(uint32_t t = 0; t < 2; t++)
+        {
+            texels[t].resize((size_t)size.x * size.y * 4);
+            for(auto& texel : texels[t])
+            {
+                texel = nextFloat(rng);
+            }
+            pTextures[t] = Texture::create2D(size.x, size.y, ResourceFormat::RGBA32Float, 1, 1, texels[t].data());
+        }
+
+        ParallelReduction::UniquePtr pReduction = ParallelReduction::create(ParallelReduction::Type::ChannelMinMax, 1, size.x, size.y);
+        std::vector<glm::vec4> reference;
+        for(uint32_t call = 0; call < 3; call++)
+        {
+            pReduction->reduce(pRenderContext, pTextures[call % 2].get());
+            if(call > 0)
+            {
+                ParallelReduction::reduceCpu(ParallelReduction::Type::ChannelMinMax, texels[(call - 1) % 2].data(), size.x, size.y, reference);
+                passed = compareResults(pReduction->getResults(), reference, 0, "ChannelMinMax with a latency of 1, call " + std::to_string(call)) && passed;
+            }
+        }
+    }
+    return passed;
+}
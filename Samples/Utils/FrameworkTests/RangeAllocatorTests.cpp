@@ -0,0 +1,180 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/RangeAllocator.h"
+#include <algorithm>
+
+/** Runs random allocate/release/grow/defragment operations against a shadow copy of the resource, where every unit is tagged with its owner.
+    Checks that allocations never overlap, that defragment() moves the owners' data intact, and that the statistics match the shadow model.
+*/
+bool testRangeAllocator(RenderContext* pRenderContext)
+{
+    const uint32_t kOperationCount = 20000;
+    const uint32_t kMaxSize = 50;
+    const int32_t kFree = -1;
+
+    RandomGenerator rng;
+    RangeAllocator allocator(1000);
+    std::vector<int32_t> owners(allocator.getCapacity(), kFree);
+    std::map<uint64_t, uint64_t> live;        // Offset -> size
+    std::map<uint64_t, int32_t> liveOwners;   // Offset -> owner tag
+    int32_t nextOwner = 0;
+
+    auto fail = [](uint32_t op, const std::string& msg)
+    {
+        Logger::log(Logger::Level::Error, "testRangeAllocator() - operation " + std::to_string(op) + ": " + msg);
+        return false;
+    };
+
+    for(uint32_t op = 0; op < kOperationCount; op++)
+    {
+        uint32_t action = (rng.next() >> 8) % 10;
+        if(action < 5)
+        {
+            uint64_t size = 1 + (rng.next() >> 8) % kMaxSize;
+            uint64_t offset = allocator.allocate(size);
+            if(offset == RangeAllocator::kInvalidOffset)
+            {
+                if(allocator.getLargestFreeRange() >= size)
+                {
+                    return fail(op, "allocate(" + std::to_string(size) + ") failed with a large enough free range");
+                }
+                // grow() extends the last free range, so growing by the requested size is always enough
+                allocator.grow(allocator.getCapacity() + size);
+                owners.resize(allocator.getCapacity(), kFree);
+                offset = allocator.allocate(size);
+                if(offset == RangeAllocator::kInvalidOffset)
+                {
+                    return fail(op, "allocate(" + std::to_string(size) + ") failed after grow()");
+                }
+            }
+
+            if(offset + size > allocator.getCapacity())
+            {
+                return fail(op, "allocation is out of bounds");
+            }
+            for(uint64_t i = offset; i < offset + size; i++)
+            {
+                if(owners[i] != kFree)
+                {
+                    return fail(op, "allocation at " + std::to_string(offset) + " overlaps a live allocation");
+                }
+                owners[i] = nextOwner;
+            }
+            live[offset] = size;
+            liveOwners[offset] = nextOwner++;
+        }
+        else if(action < 9 && live.empty() == false)
+        {
+            auto it = live.begin();
+            std::advance(it, (rng.next() >> 8) % live.size());
+            for(uint64_t i = it->first; i < it->first + it->second; i++)
+            {
+                owners[i] = kFree;
+            }
+            if(allocator.release(it->first) == false)
+            {
+                return fail(op, "release() of a live allocation failed");
+            }
+            liveOwners.erase(it->first);
+            live.erase(it);
+        }
+        else if(action == 9)
+        {
+            std::vector<RangeAllocator::Relocation> moves = allocator.defragment();
+            std::map<uint64_t, uint64_t> movedLive;
+            std::map<uint64_t, int32_t> movedOwners;
+            for(const auto& move : moves)
+            {
+                if(move.dstOffset > move.srcOffset || live.count(move.srcOffset) == 0 || live[move.srcOffset] != move.size)
+                {
+                    return fail(op, "invalid relocation " + std::to_string(move.srcOffset) + " -> " + std::to_string(move.dstOffset));
+                }
+                // Apply the moves in order, the way a user copies the data
+                std::copy(owners.begin() + move.srcOffset, owners.begin() + move.srcOffset + move.size, owners.begin() + move.dstOffset);
+                std::fill(owners.begin() + std::max(move.srcOffset, move.dstOffset + move.size), owners.begin() + move.srcOffset + move.size, kFree);
+                movedLive[move.dstOffset] = move.size;
+                movedOwners[move.dstOffset] = liveOwners[move.srcOffset];
+                live.erase(move.srcOffset);
+                liveOwners.erase(move.srcOffset);
+            }
+            live.insert(movedLive.begin(), movedLive.end());
+            liveOwners.insert(movedOwners.begin(), movedOwners.end());
+
+            if(allocator.getFreeRangeCount() > 1 || allocator.getLargestFreeRange() != allocator.getFreeSize())
+            {
+                return fail(op, "defragment() didn't leave a single free range at the end");
+            }
+            uint64_t packedEnd = 0;
+            for(const auto& l : live)
+            {
+                if(l.first != packedEnd)
+                {
+                    return fail(op, "defragment() left a gap before the allocation at " + std::to_string(l.first));
+                }
+                packedEnd += l.second;
+                for(uint64_t i = l.first; i < l.first + l.second; i++)
+                {
+                    if(owners[i] != liveOwners[l.first])
+                    {
+                        return fail(op, "defragment() corrupted the allocation at " + std::to_string(l.first));
+                    }
+                }
+            }
+        }
+
+        uint64_t used = 0;
+        for(const auto& l : live)
+        {
+            used += l.second;
+            if(allocator.getAllocationSize(l.first) != l.second)
+            {
+                return fail(op, "wrong size for the allocation at " + std::to_string(l.first));
+            }
+        }
+        if(used != allocator.getUsedSize() || allocator.getAllocationCount() != live.size())
+        {
+            return fail(op, "the statistics don't match the live allocations");
+        }
+    }
+
+    // Releasing everything merges the free ranges back into one
+    for(const auto& l : live)
+    {
+        allocator.release(l.first);
+    }
+    if(allocator.getFreeRangeCount() != 1 || allocator.getLargestFreeRange() != allocator.getCapacity())
+    {
+        return fail(kOperationCount, "releasing all the allocations left " + std::to_string(allocator.getFreeRangeCount()) + " free ranges");
+    }
+    if(allocator.allocate(0) != RangeAllocator::kInvalidOffset || allocator.release(allocator.getCapacity()) != false)
+    {
+        return fail(kOperationCount, "invalid allocate()/release() arguments were accepted");
+    }
+    return true;
+}
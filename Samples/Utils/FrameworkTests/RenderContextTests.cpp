@@ -0,0 +1,121 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+
+static bool checkStateCounters(const RenderContext::Stats& stats, RenderContext::StateCategory category, uint32_t applied, uint32_t filtered, const std::string& name)
+{
+    uint32_t index = (uint32_t)category;
+    if(stats.appliedChanges[index] != applied || stats.filteredChanges[index] != filtered)
+    {
+        Logger::log(Logger::Level::Error, "testRenderContext() - " + name + ": expected " + std::to_string(applied) + " applied and " + std::to_string(filtered) + " filtered changes, got " +
+            std::to_string(stats.appliedChanges[index]) + " and " + std::to_string(stats.filteredChanges[index]));
+        return false;
+    }
+    return true;
+}
+
+/** Checks the redundant state filtering, using the statistics counters.
+    Uses its own context with API submission disabled, so no state or draws reach the GPU and the sample's context isn't touched.
+*/
+bool testRenderContext(RenderContext* pRenderContext)
+{
+    using StateCategory = RenderContext::StateCategory;
+    RenderContext::SharedPtr pCtx = RenderContext::create();
+    pCtx->setApiSubmission(false);
+
+    RasterizerState::Desc rsDesc;
+    RasterizerState::SharedConstPtr pCullBack = RasterizerState::create(rsDesc.setCullMode(RasterizerState::CullMode::Back));
+    RasterizerState::SharedConstPtr pCullNone = RasterizerState::create(rsDesc.setCullMode(RasterizerState::CullMode::None));
+    RenderContext::Viewport vp;
+    vp.width = 64;
+    vp.height = 64;
+
+    // Establish a known state. The first pop commits every slot, including the ones which were never set.
+    pCtx->setRasterizerState(pCullBack);
+    pCtx->setTopology(RenderContext::Topology::TriangleList);
+    pCtx->setViewport(0, vp);
+    pCtx->pushState();
+    pCtx->popState();
+
+    bool passed = true;
+    const RenderContext::Stats& stats = pCtx->getStats();
+
+    // Setting the bound value again is filtered, setting a new value isn't
+    pCtx->resetStats();
+    pCtx->setRasterizerState(pCullBack);
+    pCtx->setRasterizerState(pCullNone);
+    pCtx->setRasterizerState(pCullNone);
+    passed = checkStateCounters(stats, StateCategory::RasterizerState, 1, 2, "repeated rasterizer state") && passed;
+
+    pCtx->resetStats();
+    pCtx->setViewport(0, vp);
+    RenderContext::Viewport otherVp = vp;
+    otherVp.width = 32;
+    pCtx->setViewport(0, otherVp);
+    passed = checkStateCounters(stats, StateCategory::Viewport, 1, 1, "repeated viewport") && passed;
+
+    // popState() only re-applies what changed since pushState()
+    pCtx->pushState();
+    pCtx->resetStats();
+    pCtx->setRasterizerState(pCullBack);
+    pCtx->setTopology(RenderContext::Topology::LineList);
+    pCtx->popState();
+    passed = checkStateCounters(stats, StateCategory::RasterizerState, 2, 0, "popState() rasterizer state") && passed;
+    passed = checkStateCounters(stats, StateCategory::Topology, 2, 0, "popState() topology") && passed;
+    passed = checkStateCounters(stats, StateCategory::DepthStencilState, 0, 1, "popState() depth-stencil state") && passed;
+    passed = checkStateCounters(stats, StateCategory::BlendState, 0, 1, "popState() blend state") && passed;
+    passed = checkStateCounters(stats, StateCategory::Viewport, 0, pCtx->getViewportCount(), "popState() viewports") && passed;
+
+    // After invalidateApiState(), the next change is applied even if the value didn't change
+    pCtx->invalidateApiState();
+    pCtx->resetStats();
+    pCtx->setRasterizerState(pCullNone);
+    pCtx->setRasterizerState(pCullNone);
+    passed = checkStateCounters(stats, StateCategory::RasterizerState, 1, 1, "invalidateApiState()") && passed;
+
+    // Without filtering, everything is applied
+    pCtx->setStateFiltering(false);
+    pCtx->resetStats();
+    pCtx->setRasterizerState(pCullNone);
+    pCtx->setRasterizerState(pCullNone);
+    pCtx->setUniformBuffer(0, nullptr);
+    passed = checkStateCounters(stats, StateCategory::RasterizerState, 2, 0, "disabled filtering") && passed;
+    passed = checkStateCounters(stats, StateCategory::UniformBuffer, 1, 0, "disabled filtering uniform buffer") && passed;
+    pCtx->setStateFiltering(true);
+
+    // Draws are counted, but don't reach the API
+    pCtx->resetStats();
+    pCtx->draw(3, 0);
+    pCtx->drawIndexed(3, 0, 0);
+    if(stats.drawCount != 2 || stats.boundBufferCount != 0)
+    {
+        Logger::log(Logger::Level::Error, "testRenderContext() - expected 2 draws and no bound buffers, got " + std::to_string(stats.drawCount) + " and " + std::to_string(stats.boundBufferCount));
+        passed = false;
+    }
+    return passed;
+}
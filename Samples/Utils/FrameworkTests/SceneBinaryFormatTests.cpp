@@ -0,0 +1,285 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/Scene/SceneBinaryFormat.h"
+#include "Graphics/Scene/SceneExportImportCommon.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/writer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+
+static float nextFloat(RandomGenerator& rng)
+{
+    return (rng.next() >> 8) / (float)(1 << 24);
+}
+
+/** Generate a scene document with the same structure as the files SceneExporter writes
+*/
+static void createSyntheticScene(uint32_t instanceCount, rapidjson::Document& doc)
+{
+    auto& allocator = doc.GetAllocator();
+    RandomGenerator rng;
+
+    auto addMember = [&allocator](rapidjson::Value& parent, const char* key, rapidjson::Value& value)
+    {
+        rapidjson::Value jkey(key, allocator);
+        parent.AddMember(jkey, value, allocator);
+    };
+    auto addString = [&allocator, &addMember](rapidjson::Value& parent, const char* key, const std::string& str)
+    {
+        rapidjson::Value jstring(str.c_str(), (rapidjson::SizeType)str.size(), allocator);
+        addMember(parent, key, jstring);
+    };
+    auto addNumber = [&addMember](rapidjson::Value& parent, const char* key, double d)
+    {
+        rapidjson::Value jnumber(d);
+        addMember(parent, key, jnumber);
+    };
+    auto addVector = [&allocator, &addMember, &rng](rapidjson::Value& parent, const char* key, float scale)
+    {
+        rapidjson::Value jvec(rapidjson::kArrayType);
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            jvec.PushBack((double)(nextFloat(rng) * scale), allocator);
+        }
+        addMember(parent, key, jvec);
+    };
+
+    doc.SetObject();
+    rapidjson::Value version(2);
+    addMember(doc, SceneKeys::kVersion, version);
+    addNumber(doc, SceneKeys::kCameraSpeed, 1.5);
+    addNumber(doc, SceneKeys::kLightingScale, 0.1);
+    addString(doc, SceneKeys::kActiveCamera, "Camera0");
+    addVector(doc, SceneKeys::kAmbientIntensity, 1);
+
+    const uint32_t kModelCount = 64;
+    rapidjson::Value models(rapidjson::kArrayType);
+    for(uint32_t m = 0; m < kModelCount; m++)
+    {
+        rapidjson::Value model(rapidjson::kObjectType);
+        addString(model, SceneKeys::kFilename, "Models/Model" + std::to_string(m) + ".obj");
+        addString(model, SceneKeys::kName, "Model" + std::to_string(m));
+        rapidjson::Value instances(rapidjson::kArrayType);
+        for(uint32_t i = m; i < instanceCount; i += kModelCount)
+        {
+            rapidjson::Value instance(rapidjson::kObjectType);
+            addString(instance, SceneKeys::kName, "Instance" + std::to_string(i));
+            addVector(instance, SceneKeys::kTranslationVec, 1000);
+            addVector(instance, SceneKeys::kScalingVec, 2);
+            addVector(instance, SceneKeys::kRotationVec, 360);
+            instances.PushBack(instance, allocator);
+        }
+        addMember(model, SceneKeys::kModelInstances, instances);
+        models.PushBack(model, allocator);
+    }
+    addMember(doc, SceneKeys::kModels, models);
+
+    rapidjson::Value lights(rapidjson::kArrayType);
+    for(uint32_t l = 0; l < 16; l++)
+    {
+        rapidjson::Value light(rapidjson::kObjectType);
+        addString(light, SceneKeys::kName, "Light" + std::to_string(l));
+        addString(light, SceneKeys::kLightType, (l & 1) ? SceneKeys::kPointLight : SceneKeys::kDirLight);
+        addVector(light, SceneKeys::kLightIntensity, 10);
+        addVector(light, (l & 1) ? SceneKeys::kLightPos : SceneKeys::kLightDirection, 100);
+        if(l & 1)
+        {
+            addNumber(light, SceneKeys::kLightOpeningAngle, 180);
+            addNumber(light, SceneKeys::kLightPenumbraAngle, 0);
+        }
+        lights.PushBack(light, allocator);
+    }
+    addMember(doc, SceneKeys::kLights, lights);
+
+    rapidjson::Value cameras(rapidjson::kArrayType);
+    for(uint32_t c = 0; c < 4; c++)
+    {
+        rapidjson::Value camera(rapidjson::kObjectType);
+        addString(camera, SceneKeys::kName, "Camera" + std::to_string(c));
+        addVector(camera, SceneKeys::kCamPosition, 100);
+        addVector(camera, SceneKeys::kCamTarget, 100);
+        addVector(camera, SceneKeys::kCamUp, 1);
+        addNumber(camera, SceneKeys::kCamFovY, 45);
+        rapidjson::Value depthRange(rapidjson::kArrayType);
+        depthRange.PushBack(0.1, allocator);
+        depthRange.PushBack(10000.0, allocator);
+        addMember(camera, SceneKeys::kCamDepthRange, depthRange);
+        addNumber(camera, SceneKeys::kCamAspectRatio, 16.0 / 9.0);
+        cameras.PushBack(camera, allocator);
+    }
+    addMember(doc, SceneKeys::kCameras, cameras);
+
+    rapidjson::Value paths(rapidjson::kArrayType);
+    for(uint32_t p = 0; p < 4; p++)
+    {
+        rapidjson::Value path(rapidjson::kObjectType);
+        addString(path, SceneKeys::kName, "Path" + std::to_string(p));
+        rapidjson::Value loop(p != 0);
+        addMember(path, SceneKeys::kPathLoop, loop);
+        rapidjson::Value frames(rapidjson::kArrayType);
+        for(uint32_t f = 0; f < 256; f++)
+        {
+            rapidjson::Value frame(rapidjson::kObjectType);
+            addNumber(frame, SceneKeys::kFrameTime, f * 0.1);
+            addVector(frame, SceneKeys::kCamPosition, 100);
+            addVector(frame, SceneKeys::kCamTarget, 100);
+            addVector(frame, SceneKeys::kCamUp, 1);
+            frames.PushBack(frame, allocator);
+        }
+        addMember(path, SceneKeys::kPathFrames, frames);
+        paths.PushBack(path, allocator);
+    }
+    addMember(doc, SceneKeys::kPaths, paths);
+
+    // User variables cover the values which don't appear in the rest of the scene
+    rapidjson::Value user(rapidjson::kObjectType);
+    rapidjson::Value value;
+    value.SetInt(-7);
+    addMember(user, "int", value);
+    value.SetUint(0xFFFFFFFFu);
+    addMember(user, "uint", value);
+    value.SetInt64(-(1ll << 40));
+    addMember(user, "int64", value);
+    value.SetUint64(0xFFFFFFFFFFFFFFFFull);
+    addMember(user, "uint64", value);
+    value.SetDouble(-0.0);
+    addMember(user, "negative_zero", value);
+    value.SetDouble(1e300);
+    addMember(user, "large_double", value);
+    value.SetBool(false);
+    addMember(user, "bool", value);
+    value.SetNull();
+    addMember(user, "null", value);
+    static const char kEscapedString[] = "Tab\t, quote \", unicode \xC3\xA9 and null \0 character";
+    addString(user, "escaped_string", std::string(kEscapedString, sizeof(kEscapedString) - 1));
+    addString(user, "empty_string", "");
+    value.SetArray();
+    addMember(user, "empty_array", value);
+    value.SetObject();
+    addMember(user, "empty_object", value);
+    value.SetArray();
+    value.PushBack(1, allocator).PushBack(0.5, allocator).PushBack("string", allocator).PushBack(0.1, allocator);
+    addMember(user, "mixed_array", value);
+    addMember(doc, SceneKeys::kUserDefined, user);
+}
+
+static std::string toJsonString(const rapidjson::Value& root)
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    root.Accept(writer);
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+/** Checks that a generated scene converts to binary and back without changes, that re-encoding reproduces the data, and that truncated data is rejected
+*/
+bool testSceneBinaryFormat(RenderContext* pRenderContext)
+{
+    rapidjson::Document source;
+    createSyntheticScene(1000, source);
+
+    std::vector<uint8_t> data;
+    SceneBinaryFormat::write(source, data);
+    if(SceneBinaryFormat::isBinaryScene(data.data(), data.size()) == false)
+    {
+        Logger::log(Logger::Level::Error, "testSceneBinaryFormat() - isBinaryScene() doesn't recognize the data");
+        return false;
+    }
+
+    rapidjson::Document decoded;
+    std::string errorMsg;
+    if(SceneBinaryFormat::read(data.data(), data.size(), decoded, errorMsg) == false)
+    {
+        Logger::log(Logger::Level::Error, "testSceneBinaryFormat() - can't read the binary scene. " + errorMsg);
+        return false;
+    }
+
+    if((decoded != source) || (toJsonString(decoded) != toJsonString(source)))
+    {
+        Logger::log(Logger::Level::Error, "testSceneBinaryFormat() - the decoded document doesn't match the source document");
+        return false;
+    }
+
+    // Encoding the decoded document should reproduce the data
+    std::vector<uint8_t> reencoded;
+    SceneBinaryFormat::write(decoded, reencoded);
+    if(reencoded != data)
+    {
+        Logger::log(Logger::Level::Error, "testSceneBinaryFormat() - re-encoding the decoded document produced different data");
+        return false;
+    }
+
+    // Truncated data should fail to decode instead of crashing
+    for(size_t size = 0; size < data.size(); size += 1 + size / 4)
+    {
+        rapidjson::Document truncated;
+        if(SceneBinaryFormat::read(data.data(), size, truncated, errorMsg))
+        {
+            Logger::log(Logger::Level::Error, "testSceneBinaryFormat() - truncated data of size " + std::to_string(size) + " was accepted");
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Measures the time it takes to create the document from each format, for a generated scene with 100,000 instances. The JSON is formatted like the files SceneExporter writes.
+*/
+bool benchmarkSceneBinaryFormat(RenderContext* pRenderContext)
+{
+    const uint32_t kInstanceCount = 100000;
+    rapidjson::Document source;
+    createSyntheticScene(kInstanceCount, source);
+
+    rapidjson::StringBuffer jsonBuffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(jsonBuffer);
+    writer.SetIndent(' ', 4);
+    source.Accept(writer);
+    std::vector<uint8_t> data;
+    SceneBinaryFormat::write(source, data);
+
+    auto start = CpuTimer::getCurrentTimePoint();
+    rapidjson::Document jsonDoc;
+    jsonDoc.Parse(jsonBuffer.GetString());
+    double jsonParseTimeInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    start = CpuTimer::getCurrentTimePoint();
+    rapidjson::Document binaryDoc;
+    std::string errorMsg;
+    bool isValid = SceneBinaryFormat::read(data.data(), data.size(), binaryDoc, errorMsg);
+    double binaryReadTimeInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    if(jsonDoc.HasParseError() || isValid == false)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkSceneBinaryFormat() - can't read the scene back. " + errorMsg);
+        return false;
+    }
+
+    Logger::log(Logger::Level::Info, "benchmarkSceneBinaryFormat() - " + std::to_string(kInstanceCount) + " instances" +
+        ": JSON " + std::to_string(jsonBuffer.GetSize()) + " bytes parsed in " + std::to_string(jsonParseTimeInMs) + " ms" +
+        ", binary " + std::to_string(data.size()) + " bytes read in " + std::to_string(binaryReadTimeInMs) + " ms");
+    return true;
+}
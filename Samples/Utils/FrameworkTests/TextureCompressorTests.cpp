@@ -0,0 +1,204 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Utils/TextureCompressor.h"
+#include "Utils/ImageProcessing.h"
+#include <cmath>
+
+using Format = TextureCompressor::Format;
+
+static const Format kFormats[] = {Format::BC1, Format::BC3, Format::BC4, Format::BC5, Format::BC7};
+static const char* kFormatNames[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+
+/** Create a BGRA image with smooth gradients, plus some noise
+    \param[in] noise The noise amplitude, in 8-bit units
+    \param[in] isOpaque If false, alpha is a gradient too. BC1 only stores 1-bit alpha, so use opaque images for it.
+*/
+static std::vector<uint8_t> createSyntheticImage(uint32_t width, uint32_t height, uint32_t noise, bool isOpaque)
+{
+    RandomGenerator rng;
+    std::vector<uint8_t> data((size_t)width * height * 4);
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            float fx = (float)x / width;
+            float fy = (float)y / height;
+            float values[4] = {0.5f + 0.5f * std::sin(fx * 6.0f), fy, fx, isOpaque ? 1.0f : 0.5f + 0.5f * std::cos(fy * 4.0f)};
+            uint8_t* pTexel = data.data() + ((size_t)y * width + x) * 4;
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                int32_t value = (int32_t)(values[c] * 255.0f) + ((noise && (c < 3 || isOpaque == false)) ? (int32_t)((rng.next() >> 8) % (2 * noise + 1)) - (int32_t)noise : 0);
+                pTexel[c] = (uint8_t)std::min(std::max(value, 0), 255);
+            }
+        }
+    }
+    return data;
+}
+
+/** Compress a BGRA image one block at a time with compressBlock(). Partial blocks replicate the edge texels.
+*/
+static std::vector<uint8_t> compressImageReference(const uint8_t* pBgra, uint32_t width, uint32_t height, Format format)
+{
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+    uint32_t blockSize = TextureCompressor::getBlockSize(format);
+    std::vector<uint8_t> blocks((size_t)blocksX * blocksY * blockSize);
+    for(uint32_t by = 0; by < blocksY; by++)
+    {
+        for(uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            uint8_t rgba[64];
+            for(uint32_t t = 0; t < 16; t++)
+            {
+                uint32_t x = std::min(bx * 4 + t % 4, width - 1);
+                uint32_t y = std::min(by * 4 + t / 4, height - 1);
+                const uint8_t* pTexel = pBgra + ((size_t)y * width + x) * 4;
+                rgba[t * 4 + 0] = pTexel[2];
+                rgba[t * 4 + 1] = pTexel[1];
+                rgba[t * 4 + 2] = pTexel[0];
+                rgba[t * 4 + 3] = pTexel[3];
+            }
+            TextureCompressor::compressBlock(format, rgba, blocks.data() + ((size_t)by * blocksX + bx) * blockSize);
+        }
+    }
+    return blocks;
+}
+
+/** Checks that the parallel compression of textures and mip-chains matches compressing the blocks one by one, and that smooth images keep a minimal quality.
+    The image size isn't a multiple of the block size, to cover the partial blocks.
+*/
+bool testTextureCompressor(RenderContext* pRenderContext)
+{
+    const uint32_t kWidth = 131;
+    const uint32_t kHeight = 70;
+    const float kMinPsnr[] = {35, 36, 45, 45, 36};
+    bool passed = true;
+    for(uint32_t f = 0; f < arraysize(kFormats); f++)
+    {
+        const Format format = kFormats[f];
+        const std::string name = kFormatNames[f];
+        std::vector<uint8_t> data = createSyntheticImage(kWidth, kHeight, 0, format == Format::BC1);
+        TextureCompressor::Image image;
+        image.width = kWidth;
+        image.height = kHeight;
+        image.pData = data.data();
+
+        // The same image twice, so that the parallel compression works on several textures
+        TextureCompressor::Job job;
+        job.image = image;
+        job.format = format;
+        std::vector<TextureCompressor::Job> jobs(2, job);
+        std::vector<TextureCompressor::CompressedTexture> textures = TextureCompressor::compressTextures(jobs);
+
+        // Compress each level block by block. The mip-chain is generated the same way compressTextures() does it.
+        std::vector<uint8_t> expected;
+        std::vector<uint8_t> bgra = data;
+        uint32_t width = kWidth;
+        uint32_t height = kHeight;
+        uint32_t mipCount = 0;
+        while(true)
+        {
+            std::vector<uint8_t> blocks = compressImageReference(bgra.data(), width, height, format);
+            if(blocks.size() != TextureCompressor::getCompressedSize(width, height, format))
+            {
+                Logger::log(Logger::Level::Error, "testTextureCompressor() - " + name + " getCompressedSize() doesn't match the block count of a " + std::to_string(width) + "x" + std::to_string(height) + " level");
+                passed = false;
+            }
+            expected.insert(expected.end(), blocks.begin(), blocks.end());
+            mipCount++;
+            if(width == 1 && height == 1)
+            {
+                break;
+            }
+
+            // The image is in BGRA order, which doesn't matter to a box filter
+            std::vector<uint8_t> mip((size_t)std::max(width / 2, 1u) * std::max(height / 2, 1u) * 4);
+            ImageProcessing::downsample(bgra.data(), width, height, ResourceFormat::RGBA8Unorm, ImageProcessing::MipFilter::Box, mip.data());
+            bgra.swap(mip);
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        for(const auto& texture : textures)
+        {
+            if(texture.format != TextureCompressor::getResourceFormat(format, false) || texture.width != kWidth || texture.height != kHeight || texture.mipCount != mipCount)
+            {
+                Logger::log(Logger::Level::Error, "testTextureCompressor() - " + name + " compressTextures() returned the wrong format, size or mip count");
+                passed = false;
+            }
+            else if(texture.data != expected)
+            {
+                Logger::log(Logger::Level::Error, "testTextureCompressor() - " + name + " compressTextures() doesn't match compressing the blocks one by one");
+                passed = false;
+            }
+        }
+
+        float psnr = textures[0].data.empty() ? 0 : TextureCompressor::calcPsnr(image, textures[0].data.data(), format);
+        if(psnr < kMinPsnr[f])
+        {
+            Logger::log(Logger::Level::Error, "testTextureCompressor() - " + name + " PSNR is " + std::to_string(psnr) + " dB, expected at least " + std::to_string(kMinPsnr[f]));
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+/** Measures the throughput and quality of compressing a 2048x2048 image with noise to each format. BC1 gets an opaque version of the image.
+*/
+bool benchmarkTextureCompressor(RenderContext* pRenderContext)
+{
+    const uint32_t kSize = 2048;
+    const uint32_t kIterations = 4;
+    std::vector<uint8_t> opaqueData = createSyntheticImage(kSize, kSize, 8, true);
+    std::vector<uint8_t> data = createSyntheticImage(kSize, kSize, 8, false);
+    TextureCompressor::Job job;
+    job.image.width = kSize;
+    job.image.height = kSize;
+    job.generateMips = false;
+
+    for(uint32_t f = 0; f < arraysize(kFormats); f++)
+    {
+        job.format = kFormats[f];
+        job.image.pData = (job.format == Format::BC1) ? opaqueData.data() : data.data();
+        std::vector<TextureCompressor::Job> jobs(kIterations, job);
+        auto start = CpuTimer::getCurrentTimePoint();
+        std::vector<TextureCompressor::CompressedTexture> textures = TextureCompressor::compressTextures(jobs);
+        double durationInMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        if(textures[0].data.empty())
+        {
+            Logger::log(Logger::Level::Error, "benchmarkTextureCompressor() - can't compress to " + std::string(kFormatNames[f]));
+            return false;
+        }
+
+        double megaTexelsPerSecond = (double)kSize * kSize * kIterations / (std::max(durationInMs, 1e-3) * 1000);
+        float psnr = TextureCompressor::calcPsnr(job.image, textures[0].data.data(), job.format);
+        Logger::log(Logger::Level::Info, "benchmarkTextureCompressor() - " + std::string(kFormatNames[f]) + ": " + std::to_string(megaTexelsPerSecond) + " MTexels/s, PSNR " + std::to_string(psnr) + " dB");
+    }
+    return true;
+}
@@ -0,0 +1,331 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "Graphics/TextureResidency.h"
+#include <map>
+
+using Request = TextureResidency::Request;
+static const uint32_t kInvalidHandle = TextureResidency::kInvalidHandle;
+
+// The mip sizes and base mip-level of the registered textures, to recalculate the totals through the public interface
+struct TestTexture
+{
+    std::vector<uint64_t> mipSizes;
+    uint32_t baseMip;
+};
+using TestTextureMap = std::map<uint32_t, TestTexture>;
+
+static uint64_t calcTailSize(const std::vector<uint64_t>& mipSizes, uint32_t mostDetailedMip)
+{
+    uint64_t size = 0;
+    for(uint32_t i = mostDetailedMip; i < (uint32_t)mipSizes.size(); i++)
+    {
+        size += mipSizes[i];
+    }
+    return size;
+}
+
+static uint32_t addTexture(TextureResidency* pResidency, TestTextureMap& textures, const std::vector<uint64_t>& mipSizes, uint32_t baseMip)
+{
+    uint32_t handle = pResidency->addTexture(mipSizes, baseMip);
+    TestTexture& tex = textures[handle];
+    tex.mipSizes = mipSizes;
+    tex.baseMip = baseMip;
+    return handle;
+}
+
+static void removeTexture(TextureResidency* pResidency, TestTextureMap& textures, uint32_t handle)
+{
+    pResidency->removeTexture(handle);
+    textures.erase(handle);
+}
+
+static bool checkRequests(const std::vector<Request>& requests, const std::vector<Request>& expected, const std::string& name)
+{
+    bool match = requests.size() == expected.size();
+    for(size_t i = 0; match && i < requests.size(); i++)
+    {
+        match = requests[i].handle == expected[i].handle && requests[i].mipLevel == expected[i].mipLevel;
+    }
+    if(match == false)
+    {
+        std::string msg = "testTextureResidency() - " + name + " returned";
+        for(const auto& r : requests)
+        {
+            msg += " {" + std::to_string(r.handle) + ", " + std::to_string(r.mipLevel) + "}";
+        }
+        Logger::log(Logger::Level::Error, msg);
+    }
+    return match;
+}
+
+static bool checkValue(uint64_t value, uint64_t expected, const std::string& name)
+{
+    if(value != expected)
+    {
+        Logger::log(Logger::Level::Error, "testTextureResidency() - " + name + " is " + std::to_string(value) + ", expected " + std::to_string(expected));
+        return false;
+    }
+    return true;
+}
+
+/** Recalculate the totals from the per-texture state, and check that the budget is only exceeded when nothing more can be evicted
+*/
+static bool checkAccounting(const TextureResidency* pResidency, const TestTextureMap& textures, const std::string& name)
+{
+    bool passed = true;
+    uint64_t residentBytes = 0;
+    uint64_t pendingBytes = 0;
+    uint32_t pendingLoads = 0;
+    bool canEvict = false;
+    for(const auto& it : textures)
+    {
+        uint32_t handle = it.first;
+        const TestTexture& tex = it.second;
+        uint32_t residentMip = pResidency->getResidentMip(handle);
+        uint32_t pendingMip = pResidency->getPendingMip(handle);
+        if(residentMip > tex.baseMip || (pendingMip != kInvalidHandle && pendingMip >= residentMip))
+        {
+            Logger::log(Logger::Level::Error, "testTextureResidency() - " + name + " has a texture with an invalid resident or pending mip-level");
+            passed = false;
+            continue;
+        }
+
+        uint64_t residentSize = calcTailSize(tex.mipSizes, residentMip);
+        passed = checkValue(pResidency->getResidentSize(handle), residentSize, name + " resident size") && passed;
+        residentBytes += residentSize;
+        if(pendingMip != kInvalidHandle)
+        {
+            pendingBytes += calcTailSize(tex.mipSizes, pendingMip) - residentSize;
+            pendingLoads++;
+        }
+        else if(pResidency->getRequiredMip(handle) > residentMip)
+        {
+            canEvict = true;
+        }
+    }
+
+    TextureResidency::Stats stats = pResidency->getStats();
+    passed = checkValue(stats.residentBytes, residentBytes, name + " resident bytes") && passed;
+    passed = checkValue(stats.pendingBytes, pendingBytes, name + " pending bytes") && passed;
+    passed = checkValue(stats.pendingLoads, pendingLoads, name + " pending loads") && passed;
+    passed = checkValue(stats.textureCount, textures.size(), name + " texture count") && passed;
+    if(residentBytes + pendingBytes > stats.budget && canEvict)
+    {
+        Logger::log(Logger::Level::Error, "testTextureResidency() - " + name + " is over budget, but didn't evict all the unneeded mip-levels");
+        passed = false;
+    }
+    return passed;
+}
+
+/** Checks the memory accounting, the LRU eviction order, the fallback to fewer mip-levels, budget changes and failed loads.
+    Also runs random requests, loads and removals, checking the accounting after every frame.
+*/
+bool testTextureResidency(RenderContext* pRenderContext)
+{
+    bool passed = true;
+
+    // 64x64 RGBA textures. The base level is mip 4, so each texture takes baseSize bytes when idle and fullSize more when fully loaded.
+    const std::vector<uint64_t> mipSizes = TextureResidency::calcMipSizes(64, 64, 4);
+    const uint32_t kBaseMip = 4;
+    uint64_t baseSize = calcTailSize(mipSizes, kBaseMip);
+    uint64_t fullSize = calcTailSize(mipSizes, 0) - baseSize;
+    std::vector<Request> loads;
+    std::vector<Request> evictions;
+
+    // Room for one fully loaded texture. Loading another one evicts the first.
+    {
+        TextureResidency::UniquePtr pResidency = TextureResidency::create(3 * baseSize + fullSize);
+        TestTextureMap textures;
+        uint32_t a = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        uint32_t b = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        passed = checkValue(pResidency->getStats().residentBytes, 3 * baseSize, "initial resident bytes") && passed;
+
+        pResidency->requestMip(a, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(loads, {{a, 0}}, "first load") && passed;
+        passed = checkRequests(evictions, {}, "first load evictions") && passed;
+        passed = checkValue(pResidency->getStats().pendingBytes, fullSize, "pending bytes") && passed;
+        passed = checkAccounting(pResidency.get(), textures, "first load") && passed;
+        pResidency->completeLoad(a, true);
+        passed = checkValue(pResidency->getResidentMip(a), 0, "resident mip after the first load") && passed;
+
+        pResidency->requestMip(b, 0.5f);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(evictions, {{a, kBaseMip}}, "eviction for the second load") && passed;
+        passed = checkRequests(loads, {{b, 0}}, "second load") && passed;
+        passed = checkAccounting(pResidency.get(), textures, "second load") && passed;
+        pResidency->completeLoad(b, true);
+        passed = checkAccounting(pResidency.get(), textures, "second load completion") && passed;
+    }
+
+    // Room for two fully loaded textures. The least recently used one is evicted first, and a shrinking budget evicts unused textures.
+    {
+        TextureResidency::UniquePtr pResidency = TextureResidency::create(3 * baseSize + 2 * fullSize);
+        TestTextureMap textures;
+        uint32_t a = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        uint32_t b = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        uint32_t c = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        for(uint32_t handle : {a, b})
+        {
+            pResidency->requestMip(handle, 0);
+            pResidency->update(8, loads, evictions);
+            passed = checkRequests(evictions, {}, "LRU setup evictions") && passed;
+            pResidency->completeLoad(handle, true);
+        }
+
+        pResidency->requestMip(c, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(evictions, {{a, kBaseMip}}, "LRU eviction") && passed;
+        passed = checkRequests(loads, {{c, 0}}, "LRU load") && passed;
+        pResidency->completeLoad(c, true);
+
+        pResidency->setBudget(3 * baseSize + fullSize);
+        pResidency->requestMip(c, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(evictions, {{b, kBaseMip}}, "budget shrink evictions") && passed;
+        passed = checkRequests(loads, {}, "budget shrink loads") && passed;
+        passed = checkAccounting(pResidency.get(), textures, "budget shrink") && passed;
+    }
+
+    // Not enough room for mip 0. The load falls back to mip 1 and the texture is reported as starved.
+    {
+        TextureResidency::UniquePtr pResidency = TextureResidency::create(baseSize + mipSizes[1] + mipSizes[2] + mipSizes[3]);
+        uint32_t a = pResidency->addTexture(mipSizes, kBaseMip);
+        pResidency->requestMip(a, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(loads, {{a, 1}}, "fallback load") && passed;
+        passed = checkValue(pResidency->getStats().starvedTextures, 1, "starved textures") && passed;
+    }
+
+    // Pending and failed loads, load priorities and maxLoads
+    {
+        TextureResidency::UniquePtr pResidency = TextureResidency::create(1ull << 30);
+        TestTextureMap textures;
+        uint32_t a = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        uint32_t b = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+        uint32_t c = addTexture(pResidency.get(), textures, mipSizes, kBaseMip);
+
+        pResidency->requestMip(a, 2);
+        pResidency->requestMip(b, 0);
+        pResidency->requestMip(c, 3);
+        pResidency->requestMip(c, 1);
+        pResidency->update(2, loads, evictions);
+        passed = checkRequests(loads, {{b, 0}, {c, 1}}, "prioritized loads") && passed;
+
+        // b is still loading, so it isn't issued again
+        pResidency->requestMip(a, 2);
+        pResidency->requestMip(b, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(loads, {{a, 2}}, "loads while pending") && passed;
+
+        pResidency->completeLoad(b, false);
+        passed = checkValue(pResidency->getResidentMip(b), kBaseMip, "resident mip after a failed load") && passed;
+        passed = checkAccounting(pResidency.get(), textures, "failed load") && passed;
+        pResidency->requestMip(b, 0);
+        pResidency->update(8, loads, evictions);
+        passed = checkRequests(loads, {{b, 0}}, "reissued load") && passed;
+
+        // Invalid and removed handles are ignored
+        removeTexture(pResidency.get(), textures, c);
+        pResidency->requestMip(c, 0);
+        pResidency->requestMip(kInvalidHandle, 0);
+        passed = checkValue(pResidency->getResidentMip(c), kInvalidHandle, "resident mip of a removed texture") && passed;
+        passed = checkValue(pResidency->getResidentMip(1000), kInvalidHandle, "resident mip of an invalid handle") && passed;
+        passed = checkValue(pResidency->getResidentSize(1000), 0, "resident size of an invalid handle") && passed;
+        passed = checkAccounting(pResidency.get(), textures, "removal") && passed;
+    }
+
+    // Random requests, completions, removals and budget changes
+    {
+        RandomGenerator rng;
+        TextureResidency::UniquePtr pResidency = TextureResidency::create(0);
+        TestTextureMap textures;
+        std::vector<uint32_t> handles;
+        auto addRandomTexture = [&]()
+        {
+            std::vector<uint64_t> sizes = TextureResidency::calcMipSizes(16 << (rng.next() >> 29), 16 << (rng.next() >> 29), 4);
+            uint32_t baseMip = (uint32_t)sizes.size() - 1 - (rng.next() >> 30);
+            handles.push_back(addTexture(pResidency.get(), textures, sizes, baseMip));
+        };
+        for(uint32_t i = 0; i < 64; i++)
+        {
+            addRandomTexture();
+        }
+        uint64_t totalBaseSize = pResidency->getStats().residentBytes;
+
+        for(uint32_t frame = 0; frame < 500; frame++)
+        {
+            if(frame % 50 == 0)
+            {
+                pResidency->setBudget(totalBaseSize + (rng.next() >> 8));
+            }
+            for(uint32_t i = 0; i < 32; i++)
+            {
+                pResidency->requestMip(handles[(rng.next() >> 8) % handles.size()], (float)(rng.next() >> 24) / 16.0f - 2.0f);
+            }
+
+            pResidency->update(8, loads, evictions);
+            for(const auto& load : loads)
+            {
+                if(load.mipLevel >= pResidency->getResidentMip(load.handle) || load.mipLevel < pResidency->getRequiredMip(load.handle))
+                {
+                    Logger::log(Logger::Level::Error, "testTextureResidency() - random test issued a load outside of the required range");
+                    passed = false;
+                }
+            }
+            passed = checkAccounting(pResidency.get(), textures, "random test update " + std::to_string(frame)) && passed;
+
+            // Complete some of the loads, a few of them unsuccessfully
+            for(uint32_t handle : handles)
+            {
+                if(pResidency->isLoadPending(handle) && (rng.next() >> 30) != 0)
+                {
+                    pResidency->completeLoad(handle, (rng.next() >> 28) != 0);
+                }
+            }
+
+            // Replace a texture, possibly one with a pending load
+            if(frame % 7 == 0)
+            {
+                uint32_t index = (rng.next() >> 8) % handles.size();
+                removeTexture(pResidency.get(), textures, handles[index]);
+                std::swap(handles[index], handles.back());
+                handles.pop_back();
+                addRandomTexture();
+            }
+            passed = checkAccounting(pResidency.get(), textures, "random test frame " + std::to_string(frame)) && passed;
+            if(passed == false)
+            {
+                break;
+            }
+        }
+    }
+    return passed;
+}
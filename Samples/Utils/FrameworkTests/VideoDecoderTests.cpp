@@ -0,0 +1,218 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "FrameworkTests.h"
+#include "glm/gtc/type_precision.hpp"
+
+static glm::u8vec4 getSyntheticFrameColor(int64_t frameIndex)
+{
+    return glm::u8vec4((uint8_t)(frameIndex * 9), (uint8_t)(255 - frameIndex * 5), (uint8_t)(frameIndex * 31), 255);
+}
+
+static bool writeSyntheticClip(const VideoEncoder::Desc& desc, uint32_t frameCount, bool solidColors)
+{
+    VideoEncoder::UniquePtr pEncoder = VideoEncoder::create(desc);
+    if(pEncoder == nullptr)
+    {
+        return false;
+    }
+
+    // Solid colors identify the frames. Otherwise, a moving gradient gives the codec some real motion.
+    std::vector<glm::u8vec4> frame(desc.width * desc.height);
+    for(uint32_t f = 0; f < frameCount; f++)
+    {
+        for(uint32_t y = 0; y < desc.height; y++)
+        {
+            for(uint32_t x = 0; x < desc.width; x++)
+            {
+                frame[y * desc.width + x] = solidColors ? getSyntheticFrameColor(f) : glm::u8vec4((uint8_t)(x + f * 4), (uint8_t)(y + f * 2), (uint8_t)(x ^ y), 255);
+            }
+        }
+        pEncoder->appendFrame(frame.data());
+    }
+    pEncoder->endCapture();
+    return true;
+}
+
+/** Checks streaming playback of a synthetic clip: frame order, holding the last frame, looping, seeking and skipping frames.
+    The frame contents are only checked under OpenGL, since DX11 textures can't be read back.
+*/
+bool testVideoDecoder(RenderContext* pRenderContext)
+{
+    // Raw video, so that the colors survive the round trip
+    const uint32_t kFrameCount = 30;
+    VideoEncoder::Desc clipDesc;
+    clipDesc.fps = 30;
+    clipDesc.width = 64;
+    clipDesc.height = 64;
+    clipDesc.codec = VideoEncoder::CodecID::RawVideo;
+    clipDesc.filename = getExecutableDirectory() + "/FrameworkTests.avi";
+    if(writeSyntheticClip(clipDesc, kFrameCount, true) == false)
+    {
+        Logger::log(Logger::Level::Error, "testVideoDecoder() - can't write the synthetic clip " + clipDesc.filename);
+        return false;
+    }
+
+    const float frameTime = 1.0f / clipDesc.fps;
+    bool passed = true;
+    float curTime = 0;
+
+    // Shows the frame at curTime, after waiting for the worker to decode it, so that the result doesn't depend on the decoding speed
+    auto showFrame = [&](VideoDecoder* pDecoder, int64_t expectedFrame, const std::string& name)
+    {
+        pDecoder->waitForFrame(expectedFrame);
+        Texture::SharedPtr pTexture = pDecoder->getTextureForNextFrame(curTime);
+        if(pDecoder->getCurrentFrame() != expectedFrame)
+        {
+            Logger::log(Logger::Level::Error, "testVideoDecoder() - " + name + " showed frame " + std::to_string(pDecoder->getCurrentFrame()) + ", expected " + std::to_string(expectedFrame));
+            passed = false;
+            return;
+        }
+#ifdef FALCOR_GL
+        std::vector<glm::u8vec4> texels(clipDesc.width * clipDesc.height);
+        pTexture->readSubresourceData(texels.data(), (uint32_t)(texels.size() * sizeof(glm::u8vec4)), 0, 0);
+        glm::u8vec4 color = getSyntheticFrameColor(expectedFrame % kFrameCount);
+        if(texels.front() != color || texels.back() != color)
+        {
+            Logger::log(Logger::Level::Error, "testVideoDecoder() - " + name + " frame " + std::to_string(expectedFrame) + " has the wrong content");
+            passed = false;
+        }
+#endif
+    };
+
+    // Sequential playback without looping holds the last frame. Times are in the middle of the frames, so rounding doesn't change the frame.
+    VideoDecoder::StreamingDesc desc;
+    desc.ringSize = 4;
+    desc.textureCount = 2;
+    desc.loop = false;
+    VideoDecoder::UniquePtr pDecoder = VideoDecoder::createStreaming(clipDesc.filename, desc);
+    if(pDecoder == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "testVideoDecoder() - can't open the synthetic clip " + clipDesc.filename);
+        return false;
+    }
+    pDecoder->seek(0.5f * frameTime);
+    for(uint32_t i = 0; i < kFrameCount + 3; i++)
+    {
+        curTime = (i + 0.5f) * frameTime;
+        showFrame(pDecoder.get(), std::min(i, kFrameCount - 1), "sequential playback");
+    }
+    VideoDecoder::StreamingStats stats = pDecoder->getStreamingStats();
+    if(stats.decodedFrames != kFrameCount || stats.skippedFrames != 0)
+    {
+        Logger::log(Logger::Level::Error, "testVideoDecoder() - sequential playback decoded " + std::to_string(stats.decodedFrames) + " frames and skipped " + std::to_string(stats.skippedFrames) +
+            ", expected " + std::to_string(kFrameCount) + " and 0");
+        passed = false;
+    }
+
+    // Seeking. The media time continues from the seek position, so call again with the same time.
+    pDecoder->seek(10.5f * frameTime);
+    showFrame(pDecoder.get(), 10, "seek");
+    pDecoder->seek(3.5f * frameTime);
+    showFrame(pDecoder.get(), 3, "backward seek");
+    pDecoder = nullptr;
+
+    // Looping continues the frame indices past the end of the clip
+    desc.loop = true;
+    pDecoder = VideoDecoder::createStreaming(clipDesc.filename, desc);
+    pDecoder->seek(0.5f * frameTime);
+    uint32_t frame = 0;
+    for(; frame < kFrameCount * 2 + 5; frame++)
+    {
+        curTime = (frame + 0.5f) * frameTime;
+        showFrame(pDecoder.get(), frame, "looping playback");
+    }
+
+    // At double speed, every other frame is decoded but never shown
+    pDecoder->setPlaybackRate(2);
+    uint64_t skippedBefore = pDecoder->getStreamingStats().skippedFrames;
+    const uint32_t kFastFrames = 20;
+    for(uint32_t i = 1; i <= kFastFrames; i++)
+    {
+        curTime += frameTime;
+        showFrame(pDecoder.get(), frame - 1 + i * 2, "double speed playback");
+    }
+    uint64_t skipped = pDecoder->getStreamingStats().skippedFrames - skippedBefore;
+    if(skipped != kFastFrames)
+    {
+        Logger::log(Logger::Level::Error, "testVideoDecoder() - double speed playback skipped " + std::to_string(skipped) + " frames, expected " + std::to_string(kFastFrames));
+        passed = false;
+    }
+    return passed;
+}
+
+/** Measures streaming playback of a synthetic H.264 clip, advancing one frame per call as fast as possible, and compares it with decoding the whole clip up-front
+*/
+bool benchmarkVideoDecoder(RenderContext* pRenderContext)
+{
+    const uint32_t frameCount = 300;
+    VideoEncoder::Desc desc;
+    desc.fps = 60;
+    desc.width = 1280;
+    desc.height = 720;
+    desc.codec = VideoEncoder::CodecID::H264;
+    desc.filename = getExecutableDirectory() + "/FrameworkTests.mp4";
+    if(writeSyntheticClip(desc, frameCount, false) == false)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkVideoDecoder() - can't write the synthetic clip " + desc.filename);
+        return false;
+    }
+
+    // Streaming, one frame of media time per call
+    VideoDecoder::StreamingDesc streamingDesc;
+    streamingDesc.loop = false;
+    VideoDecoder::UniquePtr pDecoder = VideoDecoder::createStreaming(desc.filename, streamingDesc);
+    if(pDecoder == nullptr)
+    {
+        Logger::log(Logger::Level::Error, "benchmarkVideoDecoder() - can't open the synthetic clip " + desc.filename);
+        return false;
+    }
+    const float frameTime = 1.0f / desc.fps;
+    pDecoder->seek(0.5f * frameTime);
+    auto start = CpuTimer::getCurrentTimePoint();
+    for(uint32_t i = 0; i < frameCount; i++)
+    {
+        pDecoder->getTextureForNextFrame((i + 0.5f) * frameTime);
+    }
+    double playbackTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    VideoDecoder::StreamingStats stats = pDecoder->getStreamingStats();
+    pDecoder = nullptr;
+
+    // The old path - decode everything, then show the first frame
+    start = CpuTimer::getCurrentTimePoint();
+    pDecoder = VideoDecoder::create(desc.filename, frameCount);
+    if(pDecoder)
+    {
+        pDecoder->getTextureForNextFrame(0);
+    }
+    double preloadTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+    Logger::log(Logger::Level::Info, "benchmarkVideoDecoder() - " + std::to_string(frameCount) + " frames at " + std::to_string(desc.width) + "x" + std::to_string(desc.height) +
+        ": streaming decodes at " + std::to_string(stats.decodeFps) + " fps, " + std::to_string(playbackTime / frameCount) + " ms per playback frame, " + std::to_string(stats.underruns) +
+        " underruns. Decoding the whole clip up-front takes " + std::to_string(preloadTime) + " ms.");
+    return true;
+}
@@ -43,6 +43,7 @@ void SceneEditorSample::initUI()
 {
     mpGui->addButton("Create New Scene", &SceneEditorSample::createSceneCallback, this);
     mpGui->addButton("Load Scene", &SceneEditorSample::loadSceneCallback, this);
+    mpGui->addCheckBox("Load Progressively", &mLoadProgressively);
 }
 
 void SceneEditorSample::onLoad()
@@ -62,7 +63,15 @@ void SceneEditorSample::initNewScene()
     {
         mpRenderer = SceneRenderer::create(mpScene);
         mpEditor = nullptr;    // Need to do that for the UI to work correctly
-        mpEditor = SceneEditor::create(mpScene);
+        if(mpScene->getLoadProgress().isComplete())
+        {
+            mpEditor = SceneEditor::create(mpScene);
+        }
+        else
+        {
+            // Models can't be added or deleted while they are loading, so the editor is created once they all arrived
+            mpScene->setLoadCompleteCallback([this]() { mpEditor = SceneEditor::create(mpScene); });
+        }
 
         mpProgram = Program::createFromFile("", "SceneEditorSample.fs");
         std::string lights;
@@ -78,7 +87,14 @@ void SceneEditorSample::loadScene()
     if(openFileDialog("Scene files\0*.fscene\0\0", Filename))
     {
         reset();
-        mpScene = Scene::loadFromFile(Filename, Model::GenerateTangentSpace);
+        if(mLoadProgressively)
+        {
+            mpScene = Scene::loadFromFileAsync(Filename, Model::GenerateTangentSpace);
+        }
+        else
+        {
+            mpScene = Scene::loadFromFile(Filename, Model::GenerateTangentSpace);
+        }
         initNewScene();
     }
 }
@@ -102,17 +118,28 @@ void SceneEditorSample::onFrameRender()
     const glm::vec4 clearColor(0.38f, 0.52f, 0.10f, 1);
     mpDefaultFBO->clear(clearColor, 1.0f, 0, FboAttachmentType::All);
 
+    std::string msg = getGlobalSampleMessage(true);
     if(mpScene)
     {
+        if(mpScene->updateLoading() == false)
+        {
+            const Scene::LoadProgress& progress = mpScene->getLoadProgress();
+            msg += "\nLoading models: " + std::to_string(progress.loadedModelCount + progress.failedModelCount) + "/" + std::to_string(progress.modelCount);
+        }
+
         mpRenderContext->setBlendState(nullptr);
         mpRenderContext->setDepthStencilState(nullptr, 0);
         setSceneLightsIntoUniformBuffer(mpScene.get(), mpLightBuffer.get());
         mpRenderContext->setUniformBuffer(0, mpLightBuffer);
+        if(isBenchmarkRunning())
+        {
+            Benchmark::animateModels(mpScene.get(), mCurrentTime);
+        }
         mpRenderer->update(mCurrentTime);
         mpRenderer->renderScene(mpRenderContext.get(), mpProgram.get());
     }
 
-    renderText(getGlobalSampleMessage(true), glm::vec2(10, 10));
+    renderText(msg, glm::vec2(10, 10));
 }
 
 void SceneEditorSample::onShutdown()
@@ -135,6 +162,18 @@ void SceneEditorSample::onDataReload()
 
 }
 
+bool SceneEditorSample::onBenchmarkRun(const Benchmark::Run& run)
+{
+    reset();
+    mpScene = Scene::loadFromFile(run.sceneFilename, Model::GenerateTangentSpace);
+    if(mpScene == nullptr)
+    {
+        return false;
+    }
+    initNewScene();
+    return Benchmark::setActivePath(mpScene.get(), run.pathName);
+}
+
 void SceneEditorSample::onResizeSwapChain()
 {
     RenderContext::Viewport vp;
@@ -149,5 +188,13 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
     SampleConfig config;
     config.windowDesc.title = "Scene Editor";
     config.freezeTimeOnStartup = true;
-    sceneEditor.run(config);
+
+    // The command line can name a benchmark file. See Benchmark::readDesc().
+    std::string benchmarkFile = removeLeadingTrailingWhitespaces(lpCmdLine);
+    benchmarkFile = replaceSubstring(benchmarkFile, "\"", "");
+    if(benchmarkFile.size() && (Benchmark::readDesc(benchmarkFile, config.benchmark) == false))
+    {
+        return 1;
+    }
+    return sceneEditor.run(config);
 }
@@ -40,6 +40,7 @@ public:
     bool onKeyEvent(const KeyboardEvent& keyEvent) override;
     bool onMouseEvent(const MouseEvent& mouseEvent) override;
     void onDataReload() override;
+    bool onBenchmarkRun(const Benchmark::Run& run) override;
 
 private:
     void initUI();
@@ -56,4 +57,5 @@ private:
     SceneRenderer::UniquePtr mpRenderer = nullptr;
     SceneEditor::UniquePtr mpEditor = nullptr;
     UniformBuffer::SharedPtr mpLightBuffer = nullptr;
+    bool mLoadProgressively = false;    ///< Load scenes with Scene::loadFromFileAsync(), showing placeholders until the models arrive
 };